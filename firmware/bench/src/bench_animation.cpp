@@ -0,0 +1,119 @@
+/**
+ * コロ助ロボット - キーフレームアニメーション ベンチマーク
+ * Corosuke Robot - Keyframe Animation Benchmark
+ *
+ * 従来の CMD_WAVE（delay(300) x 6 でループを止める）と、AnimationEngine で
+ * サーボ更新 tick ごとに進める版を比べる。tick あたりの処理時間、
+ * 1 tick での最大角度変化（なめらかさ）、終了後にベース姿勢へ戻るかを確認する。
+ *
+ *   pio run -e animation -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../common/config.h"
+#include "../../common/animation.h"
+
+static const uint32_t TICK_MS = SERVO_UPDATE_INTERVAL_MS;
+
+static const AnimKey_t waveShoulderKeys[] = {
+    {  0,  45, EASE_IN_OUT},
+    {300, 135, EASE_IN_OUT},
+    {600,  45, EASE_IN_OUT},
+};
+static const AnimKey_t waveElbowKeys[] = {
+    {  0,  60, EASE_LINEAR},
+};
+static const AnimTrack_t waveTracks[] = {
+    {SERVO_ARM_RIGHT_SHOULDER, 3, waveShoulderKeys},
+    {SERVO_ARM_RIGHT_ELBOW,    1, waveElbowKeys},
+};
+static const AnimClip_t waveClip = {600, 2, waveTracks};
+
+typedef struct {
+    uint32_t ticks;             // 再生に掛かった tick 数
+    uint32_t maxStepDeg;        // 1 tick での最大角度変化
+    uint32_t endMismatches;     // 終了後にベース姿勢と違うチャンネル
+    BenchStats updateNs;
+} Result_t;
+
+// base を表示しながら clip を終わるまで進める。output は実際に出力される角度
+static void runUntilIdle(AnimationEngine& engine, uint8_t layer, const uint8_t base[ANIM_CHANNELS],
+                         uint8_t output[ANIM_CHANNELS], uint32_t* nowMs, Result_t* result) {
+    while (engine.isPlaying(layer) && result->ticks < 100000) {
+        uint8_t angles[ANIM_CHANNELS];
+        uint16_t released;
+
+        uint64_t t0 = benchNowNs();
+        uint16_t driven = engine.update(*nowMs, base, angles, &released);
+        result->updateNs.add(benchNowNs() - t0);
+
+        for (uint8_t ch = 0; ch < ANIM_CHANNELS; ch++) {
+            uint8_t next = output[ch];
+            if (driven & (1u << ch)) next = angles[ch];
+            else if (released & (1u << ch)) next = base[ch];
+            uint32_t step = (uint32_t)abs((int)next - (int)output[ch]);
+            if (step > result->maxStepDeg) result->maxStepDeg = step;
+            output[ch] = next;
+        }
+        result->ticks++;
+        *nowMs += TICK_MS;
+    }
+    for (uint8_t ch = 0; ch < ANIM_CHANNELS; ch++) {
+        if (output[ch] != base[ch]) result->endMismatches++;
+    }
+}
+
+int main() {
+    printf("=== コロ助 animation benchmark ===\n");
+
+    uint8_t base[ANIM_CHANNELS];
+    uint8_t output[ANIM_CHANNELS];
+    memset(base, SERVO_CENTER_ANGLE, sizeof(base));
+    memcpy(output, base, sizeof(output));
+
+    // 従来版: 6 回の delay(300) の間はループ全体が止まる
+    printf("CMD_WAVE x3\n");
+    printf("  %-28s loop blocked %u ms, %u servo ticks missed, step %u deg\n",
+           "delay() version", 6 * 300, 6 * 300 / TICK_MS, 90);
+
+    AnimationEngine engine;
+    uint32_t nowMs = 1000;
+    Result_t wave = {0, 0, 0, BenchStats()};
+    engine.play(1, &waveClip, nowMs, 3, 250, 250);
+    runUntilIdle(engine, 1, base, output, &nowMs, &wave);
+    printf("  %-28s loop blocked 0 ms, %u ticks to finish, max step %u deg/tick, back to base %s\n",
+           "animation engine", wave.ticks, wave.maxStepDeg, wave.endMismatches ? "NO" : "yes");
+    wave.updateNs.printNs("update() per tick");
+
+    // 腕の位置を移動中に手を振るクリップで置き換え → 今の出力から動き出すか
+    AnimClipBuffer arm;
+    AnimKey_t keys[] = {
+        {0, ANIM_FROM_CURRENT, EASE_LINEAR},
+        {500, 160, EASE_IN_OUT},
+    };
+    arm.addTrack(SERVO_ARM_RIGHT_SHOULDER, keys, 2);
+    Result_t replace = {0, 0, 0, BenchStats()};
+    engine.play(1, arm.clip(), nowMs);
+    for (int i = 0; i < 10; i++) {
+        uint8_t angles[ANIM_CHANNELS];
+        uint16_t released;
+        uint16_t driven = engine.update(nowMs, base, angles, &released);
+        if (driven & (1u << SERVO_ARM_RIGHT_SHOULDER)) output[SERVO_ARM_RIGHT_SHOULDER] = angles[SERVO_ARM_RIGHT_SHOULDER];
+        nowMs += TICK_MS;
+    }
+    uint8_t before = output[SERVO_ARM_RIGHT_SHOULDER];
+    engine.play(1, &waveClip, nowMs, 1, 250, 250);
+    runUntilIdle(engine, 1, base, output, &nowMs, &replace);
+    printf("replace mid-motion (arm at %u deg -> wave)\n", before);
+    printf("  %-28s max step %u deg/tick, back to base %s\n", "crossfade", replace.maxStepDeg,
+           replace.endMismatches ? "NO" : "yes");
+
+    bool ok = wave.endMismatches == 0 && replace.endMismatches == 0 &&
+              wave.maxStepDeg < 30 && replace.maxStepDeg < 30;
+    return ok ? 0 : 1;
+}
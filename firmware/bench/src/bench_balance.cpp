@@ -0,0 +1,275 @@
+/**
+ * コロ助ロボット - バランス制御 ベンチマーク（ホストシミュレーター）
+ * Corosuke Robot - Balance Controller Step-Disturbance Simulation
+ *
+ * 足首で支える倒立振子に押す力を加え、ピッチがどれだけ倒れてどれだけで戻るかを
+ * 従来の updateBalance() と BalanceController で比べる。
+ *
+ * - 機体: 質量 1.5kg、重心高さ 18cm、足首サーボ 2 個の剛性と粘性（コンプライアンスあり）
+ * - サーボ: SERVO_UPDATE_INTERVAL_MS ごとに目標を受け取り、400度/秒で追従
+ * - IMU: 333Hz のジャイロ・加速度（雑音とバイアス入り）を ImuFusion に通す
+ * - 制御: 従来版は IMU tick ごとに足首目標へ += し、updateServos() が 20% ずつ寄せる。
+ *   新版は dt 付きの PID 出力を歩容（ここでは直立 90 度）に上乗せする
+ * - 制御周期 10ms、ジッタ付き 10ms ± 3ms、20ms の3通り
+ *
+ *   pio run -e balance -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../common/config.h"
+#include "../../common/protocol.h"
+#include "../../common/imu_fusion.h"
+#include "../../common/balance_controller.h"
+
+static const double SIM_DT = 0.0005;            // 機体の積分刻み
+static const double SIM_SECONDS = 6.0;
+static const double DISTURB_AT = 1.0;
+
+// 機体
+static const double MASS = 1.5;
+static const double COM_HEIGHT = 0.18;
+static const double GRAVITY = 9.80665;
+static const double INERTIA = MASS * COM_HEIGHT * COM_HEIGHT;
+static const double ANKLE_STIFFNESS = 40.0;     // N·m/rad（両足首）
+static const double ANKLE_DAMPING = 0.6;        // N·m·s/rad
+static const double SERVO_RATE_DPS = 400.0;
+static const double FALL_DEG = 30.0;            // これを超えたら転倒
+
+// IMU
+static const uint32_t IMU_PERIOD_US = 3000;
+static const double GYRO_NOISE_DPS = 0.1;
+static const double GYRO_BIAS_DPS = 0.5;
+static const double ACCEL_NOISE_MG = 8.0;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x13579BDF;
+
+static double uniform() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState + 0.5) / 4294967296.0;
+}
+
+static double gaussian() {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+// =============================================================================
+// 従来の制御（corosuke_lower の updateBalance() + updateServos() のピッチ分）
+// =============================================================================
+static const float LEGACY_KP = 2.0f;        // 当時の BALANCE_KP/KI/KD（tick 単位）
+static const float LEGACY_KI = 0.1f;
+static const float LEGACY_KD = 0.5f;
+
+class LegacyBalance {
+public:
+    void reset() { _sum = 0; _prev = 0; _target = 90; _current = 90; }
+
+    void controlTick(float pitch) {
+        float error = 0.0f - pitch;
+        _sum += error;
+        _sum = fmaxf(-100.0f, fminf(100.0f, _sum));
+        float d = error - _prev;
+        _prev = error;
+        float correction = LEGACY_KP * error + LEGACY_KI * _sum + LEGACY_KD * d;
+        _target += correction * 0.5f;
+        _target = fmaxf(60.0f, fminf(120.0f, _target));
+    }
+
+    float servoTick() {
+        if (fabsf(_current - _target) > 0.5f) _current += (_target - _current) * 0.2f;
+        return _current;
+    }
+
+private:
+    float _sum, _prev, _target, _current;
+};
+
+// 新しい制御（直立の目標 90 度 + 補正）
+class NewBalance {
+public:
+    void reset() { _controller = BalanceController(); }
+    void controlTick(float pitch, uint32_t dtUs) { _controller.update(pitch, 0.0f, dtUs); }
+
+    float servoTick() {
+        float offsets[16] = {0};
+        _controller.offsets(offsets);
+        return fmaxf(LEG_ANKLE_MIN, fminf(LEG_ANKLE_MAX, 90.0f + offsets[SERVO_LEG_RIGHT_ANKLE]));
+    }
+
+    uint32_t saturated() const { return _controller.axis(BALANCE_AXIS_PITCH).state().saturated; }
+
+private:
+    BalanceController _controller;
+};
+
+// =============================================================================
+// シナリオ
+// =============================================================================
+typedef struct {
+    const char* name;
+    double torque;          // N·m
+    double duration;        // 秒（0 = 押し続ける）
+} Disturbance_t;
+
+typedef struct {
+    const char* name;
+    uint32_t periodUs;
+    uint32_t jitterUs;
+} Timing_t;
+
+typedef struct {
+    double peakDeg;
+    double settleMs;        // 最後に 0.5 度を超えてから（押し始めから）
+    double finalDeg;        // 最後の 1 秒の平均 |ピッチ|
+    double ankleTravelDeg;  // 足首の総移動量（雑音で震えていないか）
+    bool fell;
+    double fellAtS;
+} Result_t;
+
+template <typename ControllerT>
+static Result_t simulate(ControllerT& controller, bool legacy, const Disturbance_t& disturbance,
+                         const Timing_t& timing) {
+    Result_t r;
+    memset(&r, 0, sizeof(r));
+    rngState = 0x13579BDF;
+
+    double theta = 0.0, omega = 0.0;
+    double ankleDeg = 90.0, ankleCmdDeg = 90.0;
+    ImuFusion fusion;
+    controller.reset();
+
+    uint64_t nowUs = 0;
+    uint64_t nextImuUs = 0, nextControlUs = 0, nextServoUs = 0, lastControlUs = 0;
+    double lastExceedS = DISTURB_AT;
+    double finalSum = 0.0;
+    uint32_t finalCount = 0;
+    const uint64_t endUs = (uint64_t)(SIM_SECONDS * 1e6);
+    const uint64_t stepUs = (uint64_t)(SIM_DT * 1e6);
+
+    for (; nowUs < endUs; nowUs += stepUs) {
+        double t = nowUs / 1e6;
+
+        // IMU サンプル
+        if (nowUs >= nextImuUs) {
+            ImuSample_t sample;
+            sample.gyro[0] = sample.gyro[2] = 0;
+            sample.gyro[1] = (int32_t)lround((omega + (GYRO_BIAS_DPS + GYRO_NOISE_DPS * gaussian()) * M_PI / 180.0) * 65536.0);
+            sample.accel[0] = (int32_t)lround(-sin(theta) * 1000.0 + ACCEL_NOISE_MG * gaussian());
+            sample.accel[1] = (int32_t)lround(ACCEL_NOISE_MG * gaussian());
+            sample.accel[2] = (int32_t)lround(cos(theta) * 1000.0 + ACCEL_NOISE_MG * gaussian());
+            sample.dtUs = nowUs == 0 ? 0 : IMU_PERIOD_US;
+            fusion.update(sample);
+            nextImuUs += IMU_PERIOD_US;
+        }
+
+        // 制御（IMU tick）
+        if (nowUs >= nextControlUs) {
+            float pitch = fusion.pitchDeg();
+            if (legacy) {
+                ((LegacyBalance&)controller).controlTick(pitch);
+            } else {
+                ((NewBalance&)controller).controlTick(pitch, (uint32_t)(nowUs - lastControlUs));
+            }
+            lastControlUs = nowUs;
+            int32_t jitter = timing.jitterUs ? (int32_t)(uniform() * 2 * timing.jitterUs) - (int32_t)timing.jitterUs : 0;
+            nextControlUs += timing.periodUs + jitter;
+        }
+
+        // サーボ更新（50Hz）
+        if (nowUs >= nextServoUs) {
+            double previous = ankleCmdDeg;
+            ankleCmdDeg = controller.servoTick();
+            if (nowUs > 0) r.ankleTravelDeg += fabs(ankleCmdDeg - previous);
+            nextServoUs += SERVO_UPDATE_INTERVAL_MS * 1000;
+        }
+
+        // サーボの追従（速度制限）
+        double maxStep = SERVO_RATE_DPS * SIM_DT;
+        double diff = ankleCmdDeg - ankleDeg;
+        ankleDeg += diff > maxStep ? maxStep : (diff < -maxStep ? -maxStep : diff);
+
+        // 機体（足首まわりの倒立振子）
+        double push = 0.0;
+        if (t >= DISTURB_AT && (disturbance.duration == 0.0 || t < DISTURB_AT + disturbance.duration)) {
+            push = disturbance.torque;
+        }
+        double ankleRad = (ankleDeg - 90.0) * M_PI / 180.0;
+        double torque = MASS * GRAVITY * COM_HEIGHT * sin(theta) + ANKLE_STIFFNESS * (ankleRad - theta) -
+                        ANKLE_DAMPING * omega + push;
+        omega += torque / INERTIA * SIM_DT;
+        theta += omega * SIM_DT;
+
+        double deg = fabs(theta * 180.0 / M_PI);
+        if (deg > FALL_DEG) {
+            r.fell = true;
+            r.fellAtS = t;
+            r.peakDeg = deg;
+            return r;
+        }
+        if (t >= DISTURB_AT) {
+            if (deg > r.peakDeg) r.peakDeg = deg;
+            if (deg > 0.5) lastExceedS = t;
+        }
+        if (t >= SIM_SECONDS - 1.0) {
+            finalSum += deg;
+            finalCount++;
+        }
+    }
+    r.settleMs = (lastExceedS - DISTURB_AT) * 1000.0;
+    r.finalDeg = finalCount ? finalSum / finalCount : 0.0;
+    return r;
+}
+
+static void printResult(const char* label, const Result_t& r) {
+    if (r.fell) {
+        printf("  %-8s FELL (pitch passed %.0f deg at %.2f s)\n", label, FALL_DEG, r.fellAtS);
+        return;
+    }
+    printf("  %-8s peak %5.2f deg  settle(<0.5deg) %6.0f ms  final %5.2f deg  ankle travel %7.1f deg\n",
+           label, r.peakDeg, r.settleMs, r.finalDeg, r.ankleTravelDeg);
+}
+
+int main() {
+    printf("=== コロ助 balance controller simulation ===\n");
+    printf("plant: %.1f kg, COM %.0f cm, ankle %.0f N·m/rad; servo %.0f deg/s at %d ms; IMU %u us\n",
+           MASS, COM_HEIGHT * 100, ANKLE_STIFFNESS, SERVO_RATE_DPS, SERVO_UPDATE_INTERVAL_MS, IMU_PERIOD_US);
+    printf("gains: Kp %.2f Ki %.2f /s Kd %.3f s, D cutoff %.0f Hz, limit %.0f deg\n",
+           BALANCE_KP, BALANCE_KI, BALANCE_KD, BALANCE_D_CUTOFF_HZ, BALANCE_LIMIT_DEG);
+
+    static const Disturbance_t DISTURBANCES[] = {
+        {"no push (sensor noise only)", 0.0, 0.0},
+        {"step push 2.0 N·m (held)", 2.0, 0.0},
+        {"impulse 6.0 N·m for 50 ms", 6.0, 0.05},
+    };
+    static const Timing_t TIMINGS[] = {
+        {"10 ms", 10000, 0},
+        {"10 ms ± 3 ms", 10000, 3000},
+        {"20 ms", 20000, 0},
+    };
+
+    bool ok = true;
+    LegacyBalance legacy;
+    NewBalance balance;
+    for (const Disturbance_t& disturbance : DISTURBANCES) {
+        for (const Timing_t& timing : TIMINGS) {
+            printf("\n--- %s, control period %s ---\n", disturbance.name, timing.name);
+            Result_t a = simulate(legacy, true, disturbance, timing);
+            Result_t b = simulate(balance, false, disturbance, timing);
+            printResult("legacy", a);
+            printResult("new", b);
+            if (b.fell || b.finalDeg > 0.5) ok = false;
+        }
+    }
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: new controller fell or did not settle");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/**
+ * コロ助ロボット - 表情ミキサー ベンチマーク
+ * Corosuke Robot - Expression Mixer Benchmark
+ *
+ * - 一時的な表情が duration_ms の後に基本の表情へ戻るか（戻った後は基本の表情と同じ出力か）
+ * - intensity 50 の顔が、基本の表情・無表情と表の表情のちょうど中間になるか
+ * - 表情・発話・まばたきのコマンドをでたらめに送り続けても、1ms ごとの出力が飛ばないか
+ *   （口はリップシンクの値をそのまま出すので除く。なめらかにするのは軌道の側）
+ * - evaluate() の処理時間
+ *
+ *   pio run -e expression -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../../common/config.h"
+#include "../../common/expression_mixer.h"
+
+static const uint32_t TIMING_CALLS = 2000000;
+static const uint32_t BATCH = 1000;
+static const float TOLERANCE = 1.0f / EXPR_ONE + 1e-4f;
+
+static volatile float sink;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x13572468;
+
+static uint32_t next() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// =============================================================================
+// 出力の比較
+// =============================================================================
+static float difference(const ExpressionOutput_t& a, const ExpressionOutput_t& b) {
+    float d = fabsf(a.eyeH - b.eyeH);
+    d = fmaxf(d, fabsf(a.eyeV - b.eyeV));
+    d = fmaxf(d, fabsf(a.eyelid - b.eyelid));
+    d = fmaxf(d, fabsf(a.mouthLower - b.mouthLower));
+    d = fmaxf(d, fabsf(a.neckPitch - b.neckPitch));
+    d = fmaxf(d, (float)abs(a.red - b.red));
+    d = fmaxf(d, (float)abs(a.green - b.green));
+    return fmaxf(d, (float)abs(a.blue - b.blue));
+}
+
+// 混ぜずにその表情だけ出したときの顔
+static ExpressionOutput_t plainFace(Expression_t expr, uint8_t intensity) {
+    ExpressionMixer mixer;
+    mixer.begin(0);
+    mixer.setMood(expr, intensity, 0);
+    ExpressionOutput_t out;
+    mixer.evaluate(10000, &out);
+    return out;
+}
+
+// =============================================================================
+// 基本の表情へ戻る
+// =============================================================================
+static bool checkTimeout() {
+    printf("reaction over a mood (mood SAD, react HAPPY for 1000 ms; fade in %d ms, out %d ms)\n",
+           EXPRESSION_MOVE_MS, EXPRESSION_FADE_OUT_MS);
+    const ExpressionOutput_t sad = plainFace(EXPR_SAD, 100);
+    const ExpressionOutput_t happy = plainFace(EXPR_HAPPY, 100);
+
+    ExpressionMixer mixer;
+    mixer.begin(0);
+    mixer.setMood(EXPR_SAD, 100, 0);
+    mixer.react(EXPR_HAPPY, 100, 1000, 1000);
+
+    bool ok = true;
+    uint32_t backMs = 0;
+    ExpressionOutput_t out;
+    for (uint32_t now = 1000; now <= 4000; now += 10) {
+        mixer.evaluate(now, &out);
+        uint32_t t = now - 1000;
+        if (t >= EXPRESSION_MOVE_MS && t < 1000 && difference(out, happy) > TOLERANCE) ok = false;
+        if (backMs == 0 && t > 1000 && difference(out, sad) <= TOLERANCE && mixer.expression() == EXPR_SAD) backMs = t;
+    }
+    if (difference(out, sad) > TOLERANCE || mixer.expression() != EXPR_SAD) ok = false;
+    printf("  holds HAPPY from %d to 1000 ms: %s, back to SAD (and expression() == SAD) at %u ms\n",
+           EXPRESSION_MOVE_MS, ok ? "yes" : "NO", backMs);
+    return ok && backMs != 0 && backMs <= 1000 + EXPRESSION_FADE_OUT_MS + 10;
+}
+
+// =============================================================================
+// intensity
+// =============================================================================
+static bool checkIntensity() {
+    printf("\nintensity 50 (worst difference from the midpoint, servo deg / color levels)\n");
+    float worstMood = 0.0f, worstReaction = 0.0f;
+    const ExpressionOutput_t neutral = plainFace(EXPR_NEUTRAL, 100);
+    for (uint8_t e = 1; e < EXPR_COUNT; e++) {
+        const ExpressionOutput_t full = plainFace((Expression_t)e, 100);
+
+        // 基本の表情: 無表情との中間
+        ExpressionOutput_t half = plainFace((Expression_t)e, 50);
+        ExpressionOutput_t mid = neutral;
+        mid.eyeH = (neutral.eyeH + full.eyeH) * 0.5f;
+        mid.eyeV = (neutral.eyeV + full.eyeV) * 0.5f;
+        mid.eyelid = (neutral.eyelid + full.eyelid) * 0.5f;
+        mid.mouthLower = (neutral.mouthLower + full.mouthLower) * 0.5f;
+        mid.neckPitch = (neutral.neckPitch + full.neckPitch) * 0.5f;
+        mid.red = (uint8_t)((neutral.red + full.red + 1) / 2);
+        mid.green = (uint8_t)((neutral.green + full.green + 1) / 2);
+        mid.blue = (uint8_t)((neutral.blue + full.blue + 1) / 2);
+        worstMood = fmaxf(worstMood, difference(half, mid));
+
+        // 一時的な表情: 基本の表情（無表情）との中間
+        ExpressionMixer mixer;
+        mixer.begin(0);
+        mixer.react((Expression_t)e, 50, 5000, 0);
+        ExpressionOutput_t out;
+        mixer.evaluate(1000, &out);
+        worstReaction = fmaxf(worstReaction, difference(out, mid));
+    }
+    printf("  mood:     %.3f\n  reaction: %.3f\n", worstMood, worstReaction);
+    return worstMood <= 1.0f && worstReaction <= 1.0f;
+}
+
+// =============================================================================
+// でたらめなコマンド列での連続性
+// =============================================================================
+static bool checkContinuity() {
+    const uint32_t durationMs = 600000;
+    ExpressionMixer mixer;
+    mixer.begin(0);
+    ExpressionOutput_t prev, out;
+    mixer.evaluate(0, &prev);
+
+    float eyeStep = 0.0f, lidStep = 0.0f, neckStep = 0.0f, colorStep = 0.0f;
+    uint32_t commands = 0, nextCommand = 0;
+    for (uint32_t now = 1; now <= durationMs; now++) {
+        if (now >= nextCommand) {
+            Expression_t expr = (Expression_t)(next() % EXPR_COUNT);
+            uint8_t intensity = (uint8_t)(next() % 101);
+            switch (next() % 7) {
+                case 0: mixer.setMood(expr, intensity, now); break;
+                case 1:
+                case 2: mixer.react(expr, intensity, (uint16_t)(next() % 3000), now); break;
+                case 3: mixer.setSpeech((uint8_t)(next() % 101), now); break;
+                case 4: mixer.stopSpeech(now); break;
+                case 5: mixer.setBlink(next() & 1, now); break;
+                default: mixer.setGaze(0.0f, 0.0f, 0.0f); break;
+            }
+            commands++;
+            nextCommand = now + next() % 200;
+        }
+        mixer.evaluate(now, &out);
+        eyeStep = fmaxf(eyeStep, fmaxf(fabsf(out.eyeH - prev.eyeH), fabsf(out.eyeV - prev.eyeV)));
+        lidStep = fmaxf(lidStep, fabsf(out.eyelid - prev.eyelid));
+        neckStep = fmaxf(neckStep, fabsf(out.neckPitch - prev.neckPitch));
+        colorStep = fmaxf(colorStep, (float)abs(out.red - prev.red));
+        colorStep = fmaxf(colorStep, (float)abs(out.green - prev.green));
+        colorStep = fmaxf(colorStep, (float)abs(out.blue - prev.blue));
+        prev = out;
+    }
+    printf("\n%u random commands over %u s, evaluated every 1 ms: worst step per ms\n", commands, durationMs / 1000);
+    printf("  eyes %.3f deg  eyelid %.3f deg  neck %.3f deg  color %.0f levels\n",
+           eyeStep, lidStep, neckStep, colorStep);
+    // smoothstep の最大の傾きは 1.5 / 時間。まばたき 60ms で 100 度なら 2.5 度/ms、
+    // 下のレイヤーの切り替えと重なるとその分だけ上乗せされる
+    return eyeStep < 0.5f && lidStep < 4.0f && neckStep < 0.3f && colorStep <= 4.0f;
+}
+
+// =============================================================================
+// 処理時間
+// =============================================================================
+static void measureTiming() {
+    printf("\nevaluate() per servo tick (host CPU, mean of %u-call batches)\n", BATCH);
+    for (uint8_t layers : {1, 4}) {
+        BenchStats stats;
+        ExpressionMixer mixer;
+        mixer.begin(0);
+        uint32_t now = 0;
+        ExpressionOutput_t out;
+        for (uint32_t n = 0; n < TIMING_CALLS; n += BATCH) {
+            mixer.setMood((Expression_t)((n / BATCH) % EXPR_COUNT), 100, now);
+            if (layers > 1) {
+                mixer.react(EXPR_SURPRISED, 80, 60000, now);
+                mixer.setSpeech(40, now);
+                mixer.setBlink(true, now);
+            }
+            uint64_t a = benchNowNs();
+            for (uint32_t i = 0; i < BATCH; i++) {
+                mixer.evaluate(++now, &out);
+                sink = out.eyelid;
+            }
+            uint64_t b = benchNowNs();
+            stats.add((b - a) / BATCH);
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%u active layer%s", layers, layers > 1 ? "s" : "");
+        stats.printNs(label);
+    }
+}
+
+int main() {
+    printf("=== コロ助 expression mixer benchmark ===\n");
+    printf("%d expressions x %u-byte poses, %d layers, Q%d fields, Q8 weights\n\n",
+           EXPR_COUNT, (unsigned)sizeof(ExpressionPose_t), EXPR_LAYERS, EXPR_FRAC_BITS);
+
+    bool ok = checkTimeout();
+    ok = checkIntensity() && ok;
+    ok = checkContinuity() && ok;
+    measureTiming();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: no timeout to the mood, wrong intensity or a jump in the output");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/**
+ * コロ助ロボット - 視線制御 ベンチマーク
+ * Corosuke Robot - Eye-Neck Gaze Controller Benchmark
+ *
+ * - 目の範囲の外（ヨー 60 度）への視線移動: 目のサッカードと首の動き、最後に目が中央へ戻るか
+ * - 10Hz・ノイズ付きで届く動く目標（正弦波）を追う: 従来の「サンプルごとに目だけへ書く」との
+ *   視線の誤差と tick ごとの段差（カクつき）の比較
+ * - 首の速度・加速度が GAZE_NECK_MAX_* に収まるか、目が可動範囲を出ないか
+ * - update() の処理時間
+ *
+ *   pio run -e gaze -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../../common/config.h"
+#include "../../common/gaze_controller.h"
+
+static const uint32_t TICK_MS = SERVO_UPDATE_INTERVAL_MS;
+static const uint32_t TIMING_CALLS = 2000000;
+static const uint32_t BATCH = 1000;
+
+static const float EYE_YAW_MAX = (EYE_H_MAX - EYE_H_MIN) * 0.5f;
+
+static volatile float sink;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x0BADF00D;
+
+static float uniform() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState + 0.5f) / 4294967296.0f;
+}
+
+// =============================================================================
+// 目の範囲の外への視線移動
+// =============================================================================
+static bool checkLargeShift() {
+    printf("look 60 deg right (eyes reach +-%.0f deg, neck +-%d deg)\n", EYE_YAW_MAX, (NECK_YAW_MAX - NECK_YAW_MIN) / 2);
+    GazeController gaze;
+    GazeOutput_t out;
+    gaze.update(0, &out);
+    gaze.setTarget(60.0f, 0.0f, 0);
+
+    uint32_t eyeArriveMs = 0, gazeArriveMs = 0;
+    float worstNeckVel = 0.0f, worstNeckAcc = 0.0f, prevNeck = 0.0f, prevVel = 0.0f;
+    for (uint32_t now = TICK_MS; now <= 3000; now += TICK_MS) {
+        gaze.update(now, &out);
+        float vel = (out.neckYaw - prevNeck) * 1000.0f / TICK_MS;
+        worstNeckVel = fmaxf(worstNeckVel, fabsf(vel));
+        worstNeckAcc = fmaxf(worstNeckAcc, fabsf(vel - prevVel) * 1000.0f / TICK_MS);
+        prevNeck = out.neckYaw;
+        prevVel = vel;
+        if (eyeArriveMs == 0 && out.eyeYaw >= EYE_YAW_MAX - 0.01f) eyeArriveMs = now;
+        if (gazeArriveMs == 0 && fabsf(out.eyeYaw + out.neckYaw - 60.0f) < 0.5f) gazeArriveMs = now;
+    }
+    printf("  legacy: eyes clamped at %.0f deg (gaze error %.0f deg)\n", EYE_YAW_MAX, 60.0f - EYE_YAW_MAX);
+    printf("  eyes at their limit after %u ms, gaze within 0.5 deg after %u ms\n", eyeArriveMs, gazeArriveMs);
+    printf("  final eyes %.2f deg + neck %.2f deg; neck peak %.0f deg/s %.0f deg/s2\n",
+           out.eyeYaw, out.neckYaw, worstNeckVel, worstNeckAcc);
+    return eyeArriveMs == TICK_MS && gazeArriveMs != 0 && gazeArriveMs < 1500 &&
+           fabsf(out.eyeYaw - (60.0f - (NECK_YAW_MAX - SERVO_CENTER_ANGLE))) < 0.5f &&
+           worstNeckVel <= GAZE_NECK_MAX_VEL * 1.01f && worstNeckAcc <= GAZE_NECK_MAX_ACC * 1.05f;
+}
+
+// =============================================================================
+// 動く目標の追従
+// =============================================================================
+typedef struct {
+    float rmsError;         // 視線とサーボの遅れの後の本当の目標の差（度）
+    float meanStep;         // tick ごとの目の指令の変化の平均（度）
+    float maxStep;
+    float maxEye;           // 目の指令の最大（可動範囲の確認）
+} Pursuit_t;
+
+static float targetAt(uint32_t ms, float amplitude, float hz) {
+    return amplitude * sinf(2.0f * (float)M_PI * hz * ms * 0.001f);
+}
+
+static Pursuit_t pursue(bool legacy, float amplitude, float hz, float noise, uint32_t sampleMs) {
+    Pursuit_t r = {0.0f, 0.0f, 0.0f, 0.0f};
+    GazeController gaze;
+    GazeOutput_t out;
+    gaze.update(0, &out);
+    float legacyEye = 0.0f, prevEye = 0.0f, sumSq = 0.0f, sumStep = 0.0f;
+    uint32_t ticks = 0, nextSample = 0;
+    for (uint32_t now = 0; now <= 20000; now += TICK_MS) {
+        if (now >= nextSample) {
+            float sample = targetAt(now, amplitude, hz) + (uniform() * 2.0f - 1.0f) * noise;
+            if (legacy) {
+                legacyEye = fmaxf(-EYE_YAW_MAX, fminf(EYE_YAW_MAX, sample));
+            } else {
+                gaze.setTarget(sample, 0.0f, now);
+            }
+            nextSample = now + sampleMs;
+        }
+        float eye, total;
+        if (legacy) {
+            eye = total = legacyEye;
+        } else {
+            gaze.update(now, &out);
+            eye = out.eyeYaw;
+            total = out.eyeYaw + out.neckYaw;
+        }
+        if (now >= 2000) {      // 追い付くまでは除く
+            // 指令が角度になるのはサーボの遅れ（GAZE_LEAD_MS と見込む）の後なので、その時刻の目標と比べる
+            float error = total - targetAt(now + GAZE_LEAD_MS, amplitude, hz);
+            sumSq += error * error;
+            float step = fabsf(eye - prevEye);
+            sumStep += step;
+            r.maxStep = fmaxf(r.maxStep, step);
+            r.maxEye = fmaxf(r.maxEye, fabsf(eye));
+            ticks++;
+        }
+        prevEye = eye;
+    }
+    r.rmsError = sqrtf(sumSq / ticks);
+    r.meanStep = sumStep / ticks;
+    return r;
+}
+
+static bool checkPursuit() {
+    printf("\npursuit of a sine target sampled at 10 Hz with +-1 deg noise (after 2 s, %d ms servo lag)\n", GAZE_LEAD_MS);
+    bool ok = true;
+    struct {
+        float amplitude, hz;
+    } cases[] = {{20.0f, 0.2f}, {40.0f, 0.2f}, {25.0f, 0.4f}};
+    for (auto& c : cases) {
+        Pursuit_t a = pursue(true, c.amplitude, c.hz, 1.0f, 100);
+        Pursuit_t b = pursue(false, c.amplitude, c.hz, 1.0f, 100);
+        printf("  +-%2.0f deg %.1f Hz  legacy: rms %5.2f deg, eye step mean %.2f max %5.2f | "
+               "gaze: rms %5.2f deg, eye step mean %.2f max %5.2f, |eye| max %.1f\n",
+               c.amplitude, c.hz, a.rmsError, a.meanStep, a.maxStep, b.rmsError, b.meanStep, b.maxStep, b.maxEye);
+        if (b.rmsError >= a.rmsError || b.maxStep >= a.maxStep || b.maxEye > EYE_YAW_MAX + 1e-3f) ok = false;
+    }
+    return ok;
+}
+
+// =============================================================================
+// 処理時間
+// =============================================================================
+static void measureTiming() {
+    printf("\nupdate() per servo tick with a 10 Hz target stream (host CPU, mean of %u-call batches)\n", BATCH);
+    BenchStats updateNs, sampleNs;
+    GazeController gaze;
+    GazeOutput_t out;
+    uint32_t now = 0;
+    for (uint32_t n = 0; n < TIMING_CALLS; n += BATCH) {
+        uint64_t a = benchNowNs();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            now += TICK_MS;
+            gaze.update(now, &out);
+            sink = out.eyeYaw;
+        }
+        uint64_t b = benchNowNs();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            gaze.setTarget(targetAt(now + i, 30.0f, 0.2f), 5.0f, now + i);
+        }
+        uint64_t c = benchNowNs();
+        updateNs.add((b - a) / BATCH);
+        sampleNs.add((c - b) / BATCH);
+    }
+    updateNs.printNs("update()");
+    sampleNs.printNs("setTarget()");
+}
+
+int main() {
+    printf("=== コロ助 gaze controller benchmark ===\n");
+    printf("tick %u ms, saccade above %.0f deg, pursuit up to %.0f deg/s, %d-sample prediction\n\n",
+           TICK_MS, GAZE_SACCADE_DEG, GAZE_PURSUIT_MAX_VEL, GAZE_SAMPLES);
+
+    bool ok = checkLargeShift();
+    ok = checkPursuit() && ok;
+    measureTiming();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: gaze did not reach the target, neck over its limits or pursuit worse than legacy");
+    return ok ? 0 : 1;
+}
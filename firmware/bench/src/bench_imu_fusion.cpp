@@ -0,0 +1,479 @@
+/**
+ * コロ助ロボット - IMU 姿勢推定 ベンチマーク
+ * Corosuke Robot - IMU Fusion Replay Benchmark
+ *
+ * IMU ログ（ジャイロ・加速度）を再生して、姿勢推定フィルタの精度・遅れ・処理時間を比べる。
+ *
+ * - fixed Mahony: ImuFusion（下半身で使うもの、Q30 固定小数点）
+ * - float Mahony: 同じゲインの float 版（固定小数点化の誤差を見る）
+ * - float Madgwick: β = 0.1 の float 版
+ * - accel tilt: 加速度だけから求めた傾き（ジャイロなし、参考）
+ *
+ * 1kHz のログを間引いて 333Hz（MPU6050 の FIFO）、200Hz、100Hz（BNO055 を制御周期で読む場合）で流す。
+ * 遅れは推定値と真値を時間方向にずらして RMS 誤差が最小になるずれ量。
+ *
+ * ログ形式（CSV、# から始まる行は無視。真値の列はなくてもよい）:
+ *   t_us, gx_dps, gy_dps, gz_dps, ax_mg, ay_mg, az_mg[, pitch_deg, roll_deg]
+ * ログを渡さなければ歩行中を模したログ（揺れ・着地衝撃・ジャイロのバイアスと雑音・
+ * 10度の段差）を作って使う。--write で書き出せる。
+ *
+ *   pio run -e imu_fusion -t exec
+ *   .pio/build/imu_fusion/program --log walk.csv
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../../common/config.h"
+#include "../../common/imu_fusion.h"
+
+static const double LOG_RATE_HZ = 1000.0;
+static const double SYNTH_SECONDS = 60.0;
+static const int MAX_LAG_MS = 60;
+static const int REPEATS = 20;
+
+// =============================================================================
+// ログ
+// =============================================================================
+typedef struct {
+    uint32_t tUs;
+    float gyroDps[3];
+    float accelMg[3];
+    float pitch;            // 真値（ない場合は NAN）
+    float roll;
+} LogRow_t;
+
+static uint32_t rngState = 0x2468ACE1;
+
+static double uniform() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState + 0.5) / 4294967296.0;
+}
+
+static double gaussian() {
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+// 歩行中を模したログ（1kHz）
+static std::vector<LogRow_t> synthesize() {
+    std::vector<LogRow_t> rows;
+    const double dt = 1.0 / LOG_RATE_HZ;
+    const double bias[3] = {0.5, -0.3, 0.2};        // dps
+    const double deg = M_PI / 180.0;
+
+    auto pitchAt = [](double t) {
+        // 1Hz の前後揺れ + 20s〜40s の間だけ 10度前傾（50ms で移る）
+        double step = 0.0;
+        if (t >= 20.0 && t < 40.0) {
+            double u = fmin(1.0, (t - 20.0) / 0.05);
+            step = 10.0 * u * u * (3.0 - 2.0 * u);
+        } else if (t >= 40.0) {
+            double u = fmin(1.0, (t - 40.0) / 0.05);
+            step = 10.0 * (1.0 - u * u * (3.0 - 2.0 * u));
+        }
+        return 5.0 * sin(2.0 * M_PI * 1.0 * t) + step;
+    };
+    auto rollAt = [](double t) { return 8.0 * sin(2.0 * M_PI * 0.5 * t); };
+
+    for (uint32_t i = 0; i < (uint32_t)(SYNTH_SECONDS * LOG_RATE_HZ); i++) {
+        double t = i * dt;
+        double pitch = pitchAt(t), roll = rollAt(t);
+        double pitchRate = (pitchAt(t + dt / 2) - pitchAt(t - dt / 2)) / dt;
+        double rollRate = (rollAt(t + dt / 2) - rollAt(t - dt / 2)) / dt;
+
+        // ヨー一定のときの機体角速度
+        double p = pitch * deg, r = roll * deg;
+        double body[3] = {rollRate, pitchRate * cos(r), -pitchRate * sin(r)};
+
+        double accel[3] = {-sin(p) * 1000.0, sin(r) * cos(p) * 1000.0, cos(r) * cos(p) * 1000.0};
+        // 着地の衝撃: 0.5 秒ごとに 20ms、上向き 0.6G と前向き 0.2G
+        double sincePhase = fmod(t, 0.5);
+        if (sincePhase < 0.02) {
+            accel[0] += 200.0;
+            accel[2] += 600.0;
+        }
+
+        LogRow_t row;
+        row.tUs = (uint32_t)lround(t * 1e6);
+        for (int k = 0; k < 3; k++) {
+            row.gyroDps[k] = (float)(body[k] + bias[k] + 0.1 * gaussian());
+            row.accelMg[k] = (float)(accel[k] + 8.0 * gaussian());
+        }
+        row.pitch = (float)pitch;
+        row.roll = (float)roll;
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+static bool loadLog(const char* path, std::vector<LogRow_t>* rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        LogRow_t row;
+        double v[9];
+        int n = sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf",
+                       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]);
+        if (n < 7) continue;
+        row.tUs = (uint32_t)v[0];
+        for (int k = 0; k < 3; k++) {
+            row.gyroDps[k] = (float)v[1 + k];
+            row.accelMg[k] = (float)v[4 + k];
+        }
+        row.pitch = n >= 9 ? (float)v[7] : NAN;
+        row.roll = n >= 9 ? (float)v[8] : NAN;
+        rows->push_back(row);
+    }
+    fclose(f);
+    return !rows->empty();
+}
+
+static bool writeLog(const char* path, const std::vector<LogRow_t>& rows) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# t_us,gx_dps,gy_dps,gz_dps,ax_mg,ay_mg,az_mg,pitch_deg,roll_deg\n");
+    for (const LogRow_t& r : rows) {
+        fprintf(f, "%u,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%.4f,%.4f\n", r.tUs,
+                r.gyroDps[0], r.gyroDps[1], r.gyroDps[2], r.accelMg[0], r.accelMg[1], r.accelMg[2],
+                r.pitch, r.roll);
+    }
+    fclose(f);
+    return true;
+}
+
+// =============================================================================
+// 比較用フィルタ（float）
+// =============================================================================
+class FloatMahony {
+public:
+    void reset() { _q[0] = 1; _q[1] = _q[2] = _q[3] = 0; _i[0] = _i[1] = _i[2] = 0; _aligned = false; }
+
+    void update(const float* gyroRad, const float* accelMg, float dt) {
+        float a[3];
+        float norm = sqrtf(accelMg[0] * accelMg[0] + accelMg[1] * accelMg[1] + accelMg[2] * accelMg[2]);
+        const float gate = IMU_ONE_G_MG * IMU_ACCEL_GATE_PERCENT / 100.0f;
+        bool useAccel = fabsf(norm - IMU_ONE_G_MG) <= gate;
+        if (useAccel) for (int k = 0; k < 3; k++) a[k] = accelMg[k] / norm;
+
+        if (useAccel && !_aligned) {
+            float pitch = asinf(fmaxf(-1.0f, fminf(1.0f, -a[0]))), roll = atan2f(a[1], a[2]);
+            float cp = cosf(pitch / 2), sp = sinf(pitch / 2), cr = cosf(roll / 2), sr = sinf(roll / 2);
+            _q[0] = cr * cp; _q[1] = sr * cp; _q[2] = cr * sp; _q[3] = -sr * sp;
+            _aligned = true;
+            return;
+        }
+
+        float g[3] = {gyroRad[0], gyroRad[1], gyroRad[2]};
+        if (useAccel) {
+            float v[3];
+            gravity(v);
+            float e[3] = {a[1] * v[2] - a[2] * v[1], a[2] * v[0] - a[0] * v[2], a[0] * v[1] - a[1] * v[0]};
+            for (int k = 0; k < 3; k++) {
+                _i[k] += IMU_FUSION_KI * e[k] * dt;
+                g[k] += IMU_FUSION_KP * e[k] + _i[k];
+            }
+        }
+        float h[3] = {g[0] * dt / 2, g[1] * dt / 2, g[2] * dt / 2};
+        float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+        _q[0] = w - x * h[0] - y * h[1] - z * h[2];
+        _q[1] = x + w * h[0] + y * h[2] - z * h[1];
+        _q[2] = y + w * h[1] - x * h[2] + z * h[0];
+        _q[3] = z + w * h[2] + x * h[1] - y * h[0];
+        float n = 1.0f / sqrtf(_q[0] * _q[0] + _q[1] * _q[1] + _q[2] * _q[2] + _q[3] * _q[3]);
+        for (int k = 0; k < 4; k++) _q[k] *= n;
+    }
+
+    void gravity(float* v) const {
+        float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+        v[0] = 2 * (x * z - w * y);
+        v[1] = 2 * (w * x + y * z);
+        v[2] = w * w - x * x - y * y + z * z;
+    }
+
+    float pitchDeg() const { float v[3]; gravity(v); return asinf(fmaxf(-1.0f, fminf(1.0f, -v[0]))) * 57.29578f; }
+    float rollDeg() const { float v[3]; gravity(v); return atan2f(v[1], v[2]) * 57.29578f; }
+
+private:
+    float _q[4], _i[3];
+    bool _aligned;
+};
+
+class FloatMadgwick {
+public:
+    void reset() { _q[0] = 1; _q[1] = _q[2] = _q[3] = 0; }
+
+    void update(const float* gyroRad, const float* accelMg, float dt) {
+        const float beta = 0.1f;
+        float q0 = _q[0], q1 = _q[1], q2 = _q[2], q3 = _q[3];
+        float gx = gyroRad[0], gy = gyroRad[1], gz = gyroRad[2];
+        float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+        float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+        float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+        float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+        float ax = accelMg[0], ay = accelMg[1], az = accelMg[2];
+        float norm = sqrtf(ax * ax + ay * ay + az * az);
+        if (norm > 0.0f) {
+            ax /= norm; ay /= norm; az /= norm;
+            float _2q0 = 2 * q0, _2q1 = 2 * q1, _2q2 = 2 * q2, _2q3 = 2 * q3;
+            float _4q0 = 4 * q0, _4q1 = 4 * q1, _4q2 = 4 * q2, _8q1 = 8 * q1, _8q2 = 8 * q2;
+            float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+            float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+            float s1 = _4q1 * q3q3 - _2q3 * ax + 4 * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+            float s2 = 4 * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+            float s3 = 4 * q1q1 * q3 - _2q1 * ax + 4 * q2q2 * q3 - _2q2 * ay;
+            float sn = sqrtf(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+            if (sn > 0.0f) {
+                qDot1 -= beta * s0 / sn; qDot2 -= beta * s1 / sn;
+                qDot3 -= beta * s2 / sn; qDot4 -= beta * s3 / sn;
+            }
+        }
+        q0 += qDot1 * dt; q1 += qDot2 * dt; q2 += qDot3 * dt; q3 += qDot4 * dt;
+        float n = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+        _q[0] = q0 * n; _q[1] = q1 * n; _q[2] = q2 * n; _q[3] = q3 * n;
+    }
+
+    float pitchDeg() const { return asinf(fmaxf(-1.0f, fminf(1.0f, 2 * (_q[0] * _q[2] - _q[1] * _q[3])))) * 57.29578f; }
+    float rollDeg() const {
+        return atan2f(2 * (_q[0] * _q[1] + _q[2] * _q[3]), 1 - 2 * (_q[1] * _q[1] + _q[2] * _q[2])) * 57.29578f;
+    }
+
+private:
+    float _q[4];
+};
+
+// 加速度だけの傾き
+class AccelTilt {
+public:
+    void reset() {}
+    void update(const float*, const float* accelMg, float) {
+        _pitch = atan2f(-accelMg[0], sqrtf(accelMg[1] * accelMg[1] + accelMg[2] * accelMg[2])) * 57.29578f;
+        _roll = atan2f(accelMg[1], accelMg[2]) * 57.29578f;
+    }
+    float pitchDeg() const { return _pitch; }
+    float rollDeg() const { return _roll; }
+
+private:
+    float _pitch = 0, _roll = 0;
+};
+
+// ImuFusion を同じ形で呼ぶための包み
+class FixedMahony {
+public:
+    void reset() { _f.begin(IMU_FUSION_KP, IMU_FUSION_KI); }
+    void update(const ImuSample_t& s) { _f.update(s); }
+    float pitchDeg() const { return _f.pitchDeg(); }
+    float rollDeg() const { return _f.rollDeg(); }
+
+private:
+    ImuFusion _f;
+};
+
+// =============================================================================
+// 再生と評価
+// =============================================================================
+typedef struct {
+    std::vector<uint32_t> index;        // ログの何行目の出力か
+    std::vector<float> pitch;
+    std::vector<float> roll;
+    double nsPerUpdate;
+} Run_t;
+
+// 間引いたサンプル列（センサーが返す形）
+typedef struct {
+    std::vector<uint32_t> index;
+    std::vector<ImuSample_t> fixed;
+    std::vector<float> gyroRad;         // 3 個ずつ
+    std::vector<float> accelMg;
+    std::vector<float> dt;
+} Stream_t;
+
+static Stream_t decimate(const std::vector<LogRow_t>& rows, uint32_t step) {
+    Stream_t s;
+    uint32_t lastUs = rows.empty() ? 0 : rows[0].tUs;
+    for (uint32_t i = 0; i < rows.size(); i += step) {
+        const LogRow_t& r = rows[i];
+        ImuSample_t sample;
+        uint32_t dtUs = i == 0 ? 0 : r.tUs - lastUs;
+        lastUs = r.tUs;
+        for (int k = 0; k < 3; k++) {
+            // センサー側と同じ量子化（rad/s Q16、mg）
+            sample.gyro[k] = (int32_t)lround(r.gyroDps[k] * M_PI / 180.0 * 65536.0);
+            sample.accel[k] = (int32_t)lround(r.accelMg[k]);
+            s.gyroRad.push_back((float)(sample.gyro[k] / 65536.0));
+            s.accelMg.push_back((float)sample.accel[k]);
+        }
+        sample.dtUs = dtUs;
+        s.fixed.push_back(sample);
+        s.dt.push_back(dtUs / 1e6f);
+        s.index.push_back(i);
+    }
+    return s;
+}
+
+static volatile float sink;
+
+template <typename FilterT>
+static Run_t replayFloat(const Stream_t& s) {
+    Run_t run;
+    FilterT filter;
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep < REPEATS; rep++) {
+        filter.reset();
+        uint64_t t0 = benchNowNs();
+        for (size_t i = 0; i < s.index.size(); i++) {
+            filter.update(&s.gyroRad[3 * i], &s.accelMg[3 * i], s.dt[i]);
+            sink = filter.pitchDeg();
+        }
+        uint64_t ns = benchNowNs() - t0;
+        if (ns < best) best = ns;
+    }
+    filter.reset();
+    for (size_t i = 0; i < s.index.size(); i++) {
+        filter.update(&s.gyroRad[3 * i], &s.accelMg[3 * i], s.dt[i]);
+        run.index.push_back(s.index[i]);
+        run.pitch.push_back(filter.pitchDeg());
+        run.roll.push_back(filter.rollDeg());
+    }
+    run.nsPerUpdate = (double)best / s.index.size();
+    return run;
+}
+
+static Run_t replayFixed(const Stream_t& s) {
+    Run_t run;
+    FixedMahony filter;
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep < REPEATS; rep++) {
+        filter.reset();
+        uint64_t t0 = benchNowNs();
+        for (size_t i = 0; i < s.index.size(); i++) {
+            filter.update(s.fixed[i]);
+            sink = (float)filter.pitchDeg();
+        }
+        uint64_t ns = benchNowNs() - t0;
+        if (ns < best) best = ns;
+    }
+    filter.reset();
+    for (size_t i = 0; i < s.index.size(); i++) {
+        filter.update(s.fixed[i]);
+        run.index.push_back(s.index[i]);
+        run.pitch.push_back(filter.pitchDeg());
+        run.roll.push_back(filter.rollDeg());
+    }
+    run.nsPerUpdate = (double)best / s.index.size();
+    return run;
+}
+
+// 推定値を lag ms 遅らせた真値と比べたときのピッチ・ロールの RMS 誤差（最初の 2 秒は収束待ちで除く）
+static double rmsError(const std::vector<LogRow_t>& rows, const Run_t& run, int lagSamples, double* maxError) {
+    double sum = 0.0;
+    size_t n = 0;
+    if (maxError) *maxError = 0.0;
+    for (size_t i = 0; i < run.index.size(); i++) {
+        uint32_t row = run.index[i];
+        if (row < (uint32_t)(2 * LOG_RATE_HZ) || (int)row < lagSamples) continue;
+        const LogRow_t& truth = rows[row - lagSamples];
+        double ep = run.pitch[i] - truth.pitch, er = run.roll[i] - truth.roll;
+        sum += ep * ep + er * er;
+        n += 2;
+        if (maxError) *maxError = fmax(*maxError, fmax(fabs(ep), fabs(er)));
+    }
+    return n ? sqrt(sum / n) : 0.0;
+}
+
+static void report(const char* label, const std::vector<LogRow_t>& rows, const Run_t& run, bool hasTruth) {
+    if (!hasTruth) {
+        printf("  %-16s %7.1f ns/update\n", label, run.nsPerUpdate);
+        return;
+    }
+    double maxError = 0.0;
+    double rms = rmsError(rows, run, 0, &maxError);
+    int bestLag = 0;
+    double bestRms = rms;
+    for (int lag = 1; lag <= MAX_LAG_MS; lag++) {
+        double e = rmsError(rows, run, (int)(lag * LOG_RATE_HZ / 1000), nullptr);
+        if (e < bestRms) {
+            bestRms = e;
+            bestLag = lag;
+        }
+    }
+    printf("  %-16s %7.1f ns/update   RMS %5.2f deg  max %5.2f deg   lag %2d ms (RMS %5.2f at best lag)\n",
+           label, run.nsPerUpdate, rms, maxError, bestLag, bestRms);
+}
+
+static double maxDifference(const Run_t& a, const Run_t& b) {
+    double m = 0.0;
+    for (size_t i = 0; i < a.pitch.size() && i < b.pitch.size(); i++) {
+        m = fmax(m, fmax(fabs(a.pitch[i] - b.pitch[i]), fabs(a.roll[i] - b.roll[i])));
+    }
+    return m;
+}
+
+int main(int argc, char** argv) {
+    const char* logPath = nullptr;
+    const char* writePath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            logPath = argv[++i];
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            writePath = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--log FILE.csv] [--write FILE.csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<LogRow_t> rows;
+    if (logPath) {
+        if (!loadLog(logPath, &rows)) {
+            fprintf(stderr, "cannot read %s\n", logPath);
+            return 2;
+        }
+    } else {
+        rows = synthesize();
+    }
+    if (writePath && !writeLog(writePath, rows)) {
+        fprintf(stderr, "cannot write %s\n", writePath);
+        return 2;
+    }
+    bool hasTruth = !isnan(rows[0].pitch);
+
+    printf("=== コロ助 IMU fusion benchmark ===\n");
+    printf("log: %s, %zu samples, %.1f s%s\n", logPath ? logPath : "synthetic walk", rows.size(),
+           (rows.back().tUs - rows.front().tUs) / 1e6, hasTruth ? ", with ground truth" : "");
+    printf("gains: Kp %.2f Ki %.3f, accel gate %d%%\n", IMU_FUSION_KP, IMU_FUSION_KI, IMU_ACCEL_GATE_PERCENT);
+
+    bool ok = true;
+    static const uint32_t RATES[] = {333, 200, 100};
+    for (uint32_t rate : RATES) {
+        uint32_t step = (uint32_t)lround(LOG_RATE_HZ / rate);
+        Stream_t s = decimate(rows, step);
+        printf("\n--- %u Hz (every %u log samples) ---\n", rate, step);
+
+        Run_t fixed = replayFixed(s);
+        Run_t mahony = replayFloat<FloatMahony>(s);
+        Run_t madgwick = replayFloat<FloatMadgwick>(s);
+        Run_t tilt = replayFloat<AccelTilt>(s);
+        report("fixed Mahony", rows, fixed, hasTruth);
+        report("float Mahony", rows, mahony, hasTruth);
+        report("float Madgwick", rows, madgwick, hasTruth);
+        report("accel tilt", rows, tilt, hasTruth);
+
+        double diff = maxDifference(fixed, mahony);
+        printf("  max |fixed - float Mahony| %.4f deg\n", diff);
+        if (diff > 0.1) ok = false;
+        if (hasTruth && rmsError(rows, fixed, 0, nullptr) > 1.0) ok = false;
+    }
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: fixed-point filter diverges from float reference or truth");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/**
+ * コロ助ロボット - 関節テーブル ベンチマーク
+ * Corosuke Robot - Joint Table Benchmark
+ *
+ * - 整数度の角度で着くところは従来の map() と 1 カウント以内で同じか（全関節・可動範囲全体）
+ * - 90 → 100 度をゆっくり動かしたときのカウントの段数と、指令角度に対するパルス幅の誤差
+ * - 発振器がずれているときに従来の計算（20ms / 4096 固定）で出るパルス幅の誤差
+ * - 1 回の変換の処理時間（従来: constrain + map + 除算、新: min/max + 積和）
+ *
+ *   pio run -e joint_table -t exec
+ */
+
+#include <Arduino.h>
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../../common/config.h"
+#include "../../common/joint_table.h"
+
+static const uint32_t TIMING_CALLS = 2000000;
+static const uint32_t BATCH = 1000;
+
+static volatile uint16_t sink;
+
+// 従来の writeServo()（下半身: float を int に切り捨て、足首だけ 60〜120 度）
+static uint16_t legacyTicks(uint8_t channel, float angle) {
+    angle = constrain(angle, 0, 180);
+    if (channel == SERVO_LEG_RIGHT_ANKLE || channel == SERVO_LEG_LEFT_ANKLE) {
+        angle = constrain(angle, 60, 120);
+    }
+    uint16_t pulse = map((int)angle, 0, 180, SERVO_MIN_PULSE, SERVO_MAX_PULSE);
+    return (uint16_t)((pulse * 4096L) / 20000L);
+}
+
+// カウント → サーボ角（実際の発振器 oscHz、プリスケーラ prescale のとき）
+static double ticksToDegrees(uint16_t ticks, double oscHz, int prescale) {
+    double pulseUs = ticks * (prescale + 1) * 1e6 / oscHz;
+    return (pulseUs - SERVO_MIN_PULSE) * 180.0 / (SERVO_MAX_PULSE - SERVO_MIN_PULSE);
+}
+
+static int libraryPrescale(double oscHz) {
+    return (int)(oscHz / (SERVO_PWM_HZ * 4096.0) + 0.5 - 1.0);
+}
+
+// =============================================================================
+// 整数度での一致
+// =============================================================================
+static bool checkIntegerAngles() {
+    int worst = 0;
+    uint32_t checked = 0;
+    for (const JointSpec_t* table : {UPPER_JOINTS, LOWER_JOINTS}) {
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            for (int angle = table[ch].minQ / JOINT_ANGLE_ONE; angle <= table[ch].maxQ / JOINT_ANGLE_ONE; angle++) {
+                uint16_t legacy = (uint16_t)((map(angle, 0, 180, SERVO_MIN_PULSE, SERVO_MAX_PULSE) * 4096L) / 20000L);
+                int diff = abs((int)jointTicks(table[ch], angle * JOINT_ANGLE_ONE) - (int)legacy);
+                if (diff > worst) worst = diff;
+                checked++;
+            }
+        }
+    }
+    printf("integer angles vs legacy map(): %u angles over both tables, worst difference %d tick\n", checked, worst);
+    return worst <= 1;
+}
+
+// =============================================================================
+// ゆっくり動かしたときの段差
+// =============================================================================
+static bool checkResolution() {
+    const double osc = PCA9685_OSC_HZ;
+    const int prescale = JOINT_PRESCALE;
+    const uint8_t ch = SERVO_LEG_RIGHT_KNEE;
+    uint32_t legacySteps = 0, tableSteps = 0;
+    uint16_t legacyPrev = 0, tablePrev = 0;
+    double legacyErr = 0.0, tableErr = 0.0;
+    for (int i = 0; i <= 1000; i++) {
+        float angle = 90.0f + i * 0.01f;
+        uint16_t a = legacyTicks(ch, angle);
+        uint16_t b = jointTicks(LOWER_JOINTS[ch], jointAngleQ(angle));
+        if (i > 0 && a != legacyPrev) legacySteps++;
+        if (i > 0 && b != tablePrev) tableSteps++;
+        legacyPrev = a;
+        tablePrev = b;
+        legacyErr = fmax(legacyErr, fabs(ticksToDegrees(a, osc, prescale) - angle));
+        tableErr = fmax(tableErr, fabs(ticksToDegrees(b, osc, prescale) - angle));
+    }
+    printf("\nknee 90 -> 100 deg in 0.01 deg steps (%.0f Hz oscillator, prescale %d)\n", osc, prescale);
+    printf("  legacy map():  %3u distinct steps, worst pulse error %.3f deg\n", legacySteps, legacyErr);
+    printf("  joint table:   %3u distinct steps, worst pulse error %.3f deg\n", tableSteps, tableErr);
+    return tableSteps > legacySteps && tableErr < legacyErr && tableErr < 0.3;
+}
+
+// =============================================================================
+// 発振器のずれ
+// =============================================================================
+static void showOscillatorError() {
+    printf("\nlegacy pulse error at 90 deg when the real oscillator differs from 25 MHz\n");
+    printf("(the library picks the prescale from 25 MHz; the joint table uses PCA9685_OSC_HZ for both)\n");
+    uint16_t center = legacyTicks(SERVO_WAIST, 90.0f);
+    int prescale = libraryPrescale(25000000.0);
+    for (double osc : {24.0e6, 25.0e6, 26.0e6, 27.0e6}) {
+        double deg = ticksToDegrees(center, osc, prescale);
+        double periodMs = 4096.0 * (prescale + 1) * 1000.0 / osc;
+        printf("  %4.1f MHz: period %5.2f ms, 90 deg comes out at %6.2f deg (%+.2f)\n",
+               osc / 1e6, periodMs, deg, deg - 90.0);
+    }
+    uint16_t calibrated = jointTicks(LOWER_JOINTS[SERVO_WAIST], 90 * JOINT_ANGLE_ONE);
+    printf("  joint table at PCA9685_OSC_HZ %.1f MHz: 90 deg comes out at %6.2f deg\n",
+           PCA9685_OSC_HZ / 1e6, ticksToDegrees(calibrated, PCA9685_OSC_HZ, JOINT_PRESCALE));
+}
+
+// =============================================================================
+// 処理時間
+// =============================================================================
+static void measureTiming() {
+    BenchStats legacyNs, tableNs;
+    float angle = 0.0f;
+    for (uint32_t n = 0; n < TIMING_CALLS; n += BATCH) {
+        uint64_t a = benchNowNs();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            angle += 0.37f;
+            if (angle > 200.0f) angle -= 220.0f;
+            sink = legacyTicks((uint8_t)(i & 15), angle);
+        }
+        uint64_t b = benchNowNs();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            angle += 0.37f;
+            if (angle > 200.0f) angle -= 220.0f;
+            sink = jointTicks(LOWER_JOINTS[i & 15], jointAngleQ(angle));
+        }
+        uint64_t c = benchNowNs();
+        legacyNs.add((b - a) / BATCH);
+        tableNs.add((c - b) / BATCH);
+    }
+    printf("\nper conversion (host CPU, mean of %u-call batches)\n", BATCH);
+    legacyNs.printNs("legacy constrain + map");
+    tableNs.printNs("joint table");
+}
+
+int main() {
+    printf("=== コロ助 joint table benchmark ===\n");
+    printf("pulse %d-%d us, %d Hz, 1/%d deg angles, Q%d ticks\n\n",
+           SERVO_MIN_PULSE, SERVO_MAX_PULSE, SERVO_PWM_HZ, JOINT_ANGLE_ONE, JOINT_TICK_FRAC_BITS);
+
+    bool ok = checkIntegerAngles();
+    ok = checkResolution() && ok;
+    showOscillatorError();
+    measureTiming();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: table disagrees with map() or is not finer");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+/**
+ * コロ助ロボット - 脚の逆運動学・足先軌道 ベンチマーク
+ * Corosuke Robot - Leg IK / Foot Planner Benchmark
+ *
+ * - LegIk::solve → forward の往復誤差（可動範囲を格子で全部）
+ * - 1 回の IK と 1 tick 分の FootPlanner、テーブル補間（GaitEngine）の処理時間
+ * - 1 歩行周期の足裏の軌跡を順運動学で求め、従来の関節ごとの正弦波テーブルと比べる
+ *   （着いている足の傾き、股関節の高さの上下、着いている足の速さのむら、足上げの高さ）
+ * - 制御周期 100Hz で位相を進め、50Hz のサーボ tick で TrajectoryPlanner を通した後の
+ *   足裏の傾き（関節ごとに毎 tick 軌道を引き直す従来の出し方と、follow() でまとめて出す今の出し方）
+ *
+ *   pio run -e leg_ik -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../common/config.h"
+#include "../../common/protocol.h"
+#include "../../common/leg_ik.h"
+#include "../../common/gait_engine.h"
+#include "../../common/foot_planner.h"
+#include "../../common/trajectory.h"
+
+// corosuke_lower と同じ歩容パラメータ
+#define WALK_STEP_HEIGHT     20.0f
+#define WALK_STEP_LENGTH     15.0f
+#define WALK_SWAY_AMOUNT     10.0f
+#define WALK_TURN_YAW        10.0f
+#define WALK_HIP_HEIGHT_MM   140.0f
+#define WALK_STRIDE_MM       30.0f
+#define WALK_LIFT_MM         10.0f
+#define WALK_DUTY            0.6f
+#define WALK_WAIST_SWAY      (WALK_SWAY_AMOUNT * 0.3f)
+#define WALK_CYCLE_SPEED     0.005f
+#define WALK_PHASE_STEP      ((uint32_t)(WALK_CYCLE_SPEED * 4294967296.0))
+#define CONTROL_PERIOD_MS    IMU_UPDATE_INTERVAL_MS
+#define CONTROL_SERVO_DIVIDER (SERVO_UPDATE_INTERVAL_MS / CONTROL_PERIOD_MS)
+
+static const uint32_t PATH_SAMPLES = 1024;
+static const uint32_t TIMING_TICKS = 200000;
+static const uint32_t BATCH = 1000;
+static const uint32_t SERVO_WALK_CYCLES = 4;        // 歩き出しから何周歩くか（最初の 1 周は測らない）
+static const float SERVO_TILT_LIMIT_DEG = 0.05f;    // サーボに出す角度での着いている足の傾きの上限
+
+static volatile float sink;
+
+// =============================================================================
+// 往復誤差
+// =============================================================================
+static bool checkRoundTrip() {
+    float maxPos = 0.0f, maxPitch = 0.0f;
+    uint32_t solved = 0, unreachable = 0;
+    for (float x = -80.0f; x <= 80.0f; x += 2.5f) {
+        for (float z = -145.0f; z <= -50.0f; z += 2.5f) {
+            for (float pitch = -30.0f; pitch <= 30.0f; pitch += 7.5f) {
+                FootTarget_t target = {x, z, 5.0f, pitch};
+                LegAngles_t angles;
+                if (!LegIk::solve(target, &angles)) {
+                    unreachable++;
+                    continue;
+                }
+                FootTarget_t back;
+                LegIk::forward(angles, &back);
+                maxPos = fmaxf(maxPos, hypotf(back.x - x, back.z - z));
+                maxPitch = fmaxf(maxPitch, fabsf(back.pitchDeg - pitch));
+                solved++;
+            }
+        }
+    }
+    printf("round trip (solve -> forward): %u targets, %u out of reach\n", solved, unreachable);
+    printf("  max position error %.5f mm, max sole pitch error %.5f deg\n", maxPos, maxPitch);
+    return maxPos < 0.01f && maxPitch < 0.01f;
+}
+
+// =============================================================================
+// 処理時間
+// =============================================================================
+static void measureTiming(FootPlanner& planner, const GaitEngine& engine) {
+    BenchStats solveNs, plannerNs, tableNs;
+    float targets[16];
+    uint32_t phase = 0;
+
+    for (uint32_t n = 0; n < TIMING_TICKS; n += BATCH) {
+        uint64_t a = benchNowNs();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            FootTarget_t target = {(float)(int)(i % 40) - 20.0f, -130.0f + (float)(i % 7), 0.0f, 0.0f};
+            LegAngles_t angles;
+            LegIk::solve(target, &angles);
+            sink = angles.knee;
+        }
+        uint64_t b = benchNowNs();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            phase += 21474836;
+            planner.evaluate(WALK_FORWARD, 50, phase, targets);
+            sink = targets[SERVO_LEG_RIGHT_KNEE];
+        }
+        uint64_t c = benchNowNs();
+        static GaitEngine timed;
+        timed = engine;
+        for (uint32_t i = 0; i < BATCH; i++) {
+            timed.advance(50, 21474836);
+            timed.evaluate(WALK_FORWARD, 50, targets);
+            sink = targets[SERVO_LEG_RIGHT_KNEE];
+        }
+        uint64_t d = benchNowNs();
+        solveNs.add((b - a) / BATCH);
+        plannerNs.add((c - b) / BATCH);
+        tableNs.add((d - c) / BATCH);
+    }
+    printf("\nper call (host CPU, mean of %u-call batches)\n", BATCH);
+    solveNs.printNs("LegIk::solve (1 leg)");
+    plannerNs.printNs("FootPlanner (2 legs, 1 tick)");
+    tableNs.printNs("gait table (1 tick)");
+}
+
+// =============================================================================
+// 足裏の軌跡
+// =============================================================================
+typedef struct {
+    float maxStancePitch;       // 着いている足の傾き（度）
+    float hipHeightRange;       // 股関節の高さの上下（mm）
+    float stanceSpeedSpread;    // 着いている足の前後速度 (最大 - 最小) / 平均
+    float maxClearance;         // 遊脚の足裏が支持脚より上がる高さ（mm）
+    float ankleMin, ankleMax;   // 足首サーボ角
+    float kneeMax;
+} PathResult_t;
+
+template <typename EvaluateT>
+static PathResult_t tracePath(EvaluateT evaluate) {
+    PathResult_t r;
+    memset(&r, 0, sizeof(r));
+    r.ankleMin = 180.0f;
+    float minHeight = 1e9f, maxHeight = -1e9f;
+    float minSpeed = 1e9f, maxSpeed = -1e9f, sumSpeed = 0.0f;
+    uint32_t speedCount = 0;
+    float prevX = 0.0f;
+    int prevStance = -1;
+
+    for (uint32_t i = 0; i <= PATH_SAMPLES; i++) {
+        uint32_t phase = (uint32_t)((uint64_t)i * 4294967296ull / PATH_SAMPLES);
+        float targets[16];
+        for (int j = 0; j < 16; j++) targets[j] = SERVO_CENTER_ANGLE;
+        evaluate(phase, targets);
+
+        FootTarget_t feet[2];
+        LegAngles_t angles;
+        LegIk::fromServo(targets, LEG_RIGHT_CHANNELS, &angles);
+        LegIk::forward(angles, &feet[0]);
+        LegIk::fromServo(targets, LEG_LEFT_CHANNELS, &angles);
+        LegIk::forward(angles, &feet[1]);
+
+        // 低いほうの足が着いている
+        int stance = feet[0].z <= feet[1].z ? 0 : 1;
+        const FootTarget_t& ground = feet[stance];
+        const FootTarget_t& swing = feet[1 - stance];
+
+        r.maxStancePitch = fmaxf(r.maxStancePitch, fabsf(ground.pitchDeg));
+        minHeight = fminf(minHeight, -ground.z);
+        maxHeight = fmaxf(maxHeight, -ground.z);
+        r.maxClearance = fmaxf(r.maxClearance, swing.z - ground.z);
+
+        // 片脚支持のときだけ（両脚支持や足上げの出だしはどちらの足か決まらない）
+        bool single = swing.z - ground.z > 1.0f;
+        if (single && stance == prevStance) {
+            float speed = (prevX - ground.x) * PATH_SAMPLES;     // mm / 周期
+            minSpeed = fminf(minSpeed, speed);
+            maxSpeed = fmaxf(maxSpeed, speed);
+            sumSpeed += speed;
+            speedCount++;
+        }
+        prevStance = single ? stance : -1;
+        prevX = ground.x;
+
+        for (uint8_t ch : {SERVO_LEG_RIGHT_ANKLE, SERVO_LEG_LEFT_ANKLE}) {
+            r.ankleMin = fminf(r.ankleMin, targets[ch]);
+            r.ankleMax = fmaxf(r.ankleMax, targets[ch]);
+        }
+        r.kneeMax = fmaxf(r.kneeMax, fmaxf(targets[SERVO_LEG_RIGHT_KNEE], targets[SERVO_LEG_LEFT_KNEE]));
+    }
+    r.hipHeightRange = maxHeight - minHeight;
+    float mean = speedCount ? sumSpeed / speedCount : 0.0f;
+    r.stanceSpeedSpread = fabsf(mean) > 1e-3f ? (maxSpeed - minSpeed) / fabsf(mean) : 0.0f;
+    return r;
+}
+
+static void printPath(const char* label, const PathResult_t& r) {
+    printf("  %-22s stance tilt %5.2f deg  hip bob %5.2f mm  stance speed spread %5.2f  "
+           "lift %5.1f mm  ankle %5.1f-%5.1f  knee max %5.1f\n",
+           label, r.maxStancePitch, r.hipHeightRange, r.stanceSpeedSpread, r.maxClearance,
+           r.ankleMin, r.ankleMax, r.kneeMax);
+}
+
+// =============================================================================
+// サーボに出す角度での足裏（歩容 → TrajectoryPlanner → 順運動学）
+// =============================================================================
+typedef struct {
+    float maxStancePitch;       // 着いている足の傾き（度、2 周目から）
+    float maxLag;               // 歩容の目標と出している角度の差（度、2 周目から）
+    uint32_t engageMs;          // 歩き出しから歩容をそのまま出し始めるまで（follow のみ）
+} ServoPathResult_t;
+
+// corosuke_lower の controlStep と同じ順（歩行更新 → 2 周期に 1 回サーボ更新）で直立から歩く
+static ServoPathResult_t traceServoPath(FootPlanner planner, uint8_t speed, bool follow) {
+    ServoPathResult_t r = {0.0f, 0.0f, 0};
+    TrajectoryPlanner trajectory;
+    float targets[16], positions[16];
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        trajectory.setLimits(ch, TRAJ_LEG_MAX_VEL, TRAJ_LEG_MAX_ACC);
+        trajectory.snap(ch, SERVO_CENTER_ANGLE);
+        targets[ch] = positions[ch] = SERVO_CENTER_ANGLE;
+    }
+
+    GaitEngine gait;
+    gait.resetPhase();
+    bool following = false;
+    uint32_t cycles = 0;
+    for (uint32_t cycle = 0; cycles < SERVO_WALK_CYCLES; cycle++) {
+        uint32_t now = cycle * CONTROL_PERIOD_MS;
+
+        // 従来は位相を止めない
+        if (following || !follow) {
+            uint32_t before = gait.phase();
+            gait.advance(speed, WALK_PHASE_STEP);
+            if (gait.phase() < before) cycles++;
+        }
+        planner.evaluate(WALK_FORWARD, speed, gait.phase(), targets);
+
+        if (cycle % CONTROL_SERVO_DIVIDER != 0) continue;
+        if (follow) {
+            following = trajectory.follow(GAIT_JOINT_MASK, targets, now, SERVO_UPDATE_INTERVAL_MS, GAIT_ENGAGE_MS);
+            if (following && r.engageMs == 0) r.engageMs = now;
+        } else {
+            for (uint8_t ch = 0; ch < GAIT_JOINTS; ch++) {
+                if (targets[ch] != trajectory.target(ch)) trajectory.moveTo(ch, targets[ch], now);
+            }
+        }
+        trajectory.update(now, positions);
+        if (cycles == 0) continue;
+
+        FootTarget_t feet[2];
+        LegAngles_t angles;
+        LegIk::fromServo(positions, LEG_RIGHT_CHANNELS, &angles);
+        LegIk::forward(angles, &feet[0]);
+        LegIk::fromServo(positions, LEG_LEFT_CHANNELS, &angles);
+        LegIk::forward(angles, &feet[1]);
+        const FootTarget_t& ground = feet[0].z <= feet[1].z ? feet[0] : feet[1];
+        r.maxStancePitch = fmaxf(r.maxStancePitch, fabsf(ground.pitchDeg));
+        for (uint8_t ch = 0; ch < GAIT_JOINTS; ch++) {
+            r.maxLag = fmaxf(r.maxLag, fabsf(positions[ch] - targets[ch]));
+        }
+    }
+    return r;
+}
+
+int main() {
+    printf("=== コロ助 leg IK / foot planner benchmark ===\n");
+    printf("leg: thigh %.0f mm, shin %.0f mm, ankle height %.1f mm (leg.scad)\n\n",
+           LEG_THIGH_MM, LEG_SHIN_MM, LEG_ANKLE_HEIGHT_MM);
+
+    bool ok = checkRoundTrip();
+
+    GaitParams_t gaitParams = {WALK_STEP_HEIGHT, WALK_STEP_LENGTH, WALK_SWAY_AMOUNT, WALK_TURN_YAW};
+    static GaitEngine engine;
+    engine.begin(gaitParams);
+
+    FootPlanner planner;
+    FootPlanParams_t footParams = {WALK_HIP_HEIGHT_MM, WALK_STRIDE_MM, WALK_LIFT_MM, WALK_DUTY,
+                                   WALK_TURN_YAW, WALK_WAIST_SWAY};
+    planner.begin(footParams);
+
+    measureTiming(planner, engine);
+
+    printf("\nfoot path over one cycle (forward, speed 50, %u samples, forward kinematics)\n", PATH_SAMPLES);
+    static GaitEngine traced;
+    traced = engine;
+    PathResult_t legacy = tracePath([](uint32_t phase, float* targets) {
+        traced.resetPhase();
+        traced.advance(100, phase);         // 速度 100 で phase だけ進める
+        traced.evaluate(WALK_FORWARD, 50, targets);
+    });
+    FootPlanner tracedPlanner = planner;
+    PathResult_t planned = tracePath([&](uint32_t phase, float* targets) {
+        tracedPlanner.evaluate(WALK_FORWARD, 50, phase, targets);
+    });
+    printPath("joint sine table", legacy);
+    printPath("foot planner + IK", planned);
+
+    for (WalkMode_t mode : {WALK_BACKWARD, WALK_TURN_LEFT, WALK_TURN_RIGHT}) {
+        for (uint8_t speed : {10, 90}) {
+            FootPlanner check = planner;
+            PathResult_t r = tracePath([&](uint32_t phase, float* targets) {
+                check.evaluate(mode, speed, phase, targets);
+            });
+            char label[32];
+            snprintf(label, sizeof(label), "  mode %d, speed %u", mode, speed);
+            printPath(label, r);
+            ok = ok && check.unreachable() == 0 && r.maxStancePitch < 0.01f && r.hipHeightRange < 0.1f;
+        }
+    }
+
+    printf("\nafter the servo filter (forward, %u Hz control, %u Hz servo tick, from standing, cycles 2-%u)\n",
+           1000 / CONTROL_PERIOD_MS, 1000 / SERVO_UPDATE_INTERVAL_MS, SERVO_WALK_CYCLES);
+    for (uint8_t speed : {30, 60, 100}) {
+        ServoPathResult_t perJoint = traceServoPath(planner, speed, false);
+        ServoPathResult_t followed = traceServoPath(planner, speed, true);
+        printf("  speed %3u  per-joint moveTo: stance tilt %5.2f deg  lag %5.2f deg\n",
+               speed, perJoint.maxStancePitch, perJoint.maxLag);
+        printf("             follow():         stance tilt %5.2f deg  lag %5.2f deg  (engaged after %u ms)\n",
+               followed.maxStancePitch, followed.maxLag, followed.engageMs);
+        ok = ok && followed.maxStancePitch < SERVO_TILT_LIMIT_DEG && followed.engageMs <= GAIT_ENGAGE_MS * 2;
+    }
+
+    ok = ok && tracedPlanner.unreachable() == 0 && planned.maxStancePitch < 0.01f &&
+         planned.hipHeightRange < 0.1f && planned.ankleMin >= 60.0f && planned.ankleMax <= 120.0f;
+    printf("\n%s\n", ok ? "OK" : "FAILED: IK error, unreachable target, tilted stance foot (before or after the servo filter) or ankle out of range");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+/**
+ * コロ助ロボット - UART ボーレート交渉 ベンチマーク
+ * Corosuke Robot - UART Link-Speed Negotiation Benchmark
+ *
+ * 2枚のボードの UART をホスト上で模擬し、LinkSpeed がどのボーレートに落ち着くか、
+ * 交渉にかかる時間、途中で回線が悪くなったとき・相手がリセットしたときの戻り方を見る。
+ *
+ * - 回線: 配線ごとに「このボーレートまでは BER が低い」上限を決め、それを超えると
+ *   BER が跳ね上がるモデル。送信側と受信側のボーレートが違うバイトはでたらめな値になる
+ * - 両ボードの loop は 1ms ごと。どちらも 100Hz で 24 バイトのフレームを送り続ける
+ *   （エラー率の集計に使うのと、交渉中に流れるほかのフレームの代わり）
+ *
+ *   pio run -e link_speed -t exec
+ *   pio run -e link_speed -t exec -a "--verbose"
+ */
+
+#include <Arduino.h>
+#include <native_hal.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+
+#include "../../common/config.h"
+#include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+#include "../../common/link_speed.h"
+
+static const uint32_t TRAFFIC_INTERVAL_MS = 10;
+static const uint8_t TRAFFIC_LENGTH = 24;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x12345678;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static double nextUniform() {
+    return (nextRandom() >> 8) / (double)(1u << 24);
+}
+
+// =============================================================================
+// 回線（片方向）
+// =============================================================================
+typedef struct {
+    uint32_t cleanBaud;         // ここまでは floorBer
+    double floorBer;
+    double overBer;             // cleanBaud を超えたときの BER
+} Cable_t;
+
+static uint64_t simNowUs = 0;
+
+class Wire {
+public:
+    explicit Wire(const Cable_t& cable) : _cable(cable), _busyUntilUs(0) {}
+
+    void setCable(const Cable_t& cable) { _cable = cable; }
+
+    void write(const uint8_t* data, size_t length, uint32_t baud) {
+        double byteUs = 10e6 / baud;
+        double ber = baud <= _cable.cleanBaud ? _cable.floorBer : _cable.overBer;
+        for (size_t i = 0; i < length; i++) {
+            if (_busyUntilUs < simNowUs) _busyUntilUs = (double)simNowUs;
+            _busyUntilUs += byteUs;
+            uint8_t byte = data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                if (nextUniform() < ber) byte ^= (uint8_t)(1 << bit);
+            }
+            _queue.push_back(Byte_t{(uint64_t)_busyUntilUs, baud, byte});
+        }
+    }
+
+    // 送信が終わっている時刻（flush() の待ち時間）
+    uint64_t idleAtUs() const { return (uint64_t)_busyUntilUs; }
+
+    // 届いたバイトをパーサーへ。ボーレートが合わないバイトは化ける
+    template <typename OnPacket>
+    void deliver(PacketParser& parser, uint32_t rxBaud, OnPacket onPacket) {
+        uint8_t chunk[128];
+        for (;;) {
+            size_t n = 0;
+            while (!_queue.empty() && _queue.front().arrivalUs <= simNowUs && n < sizeof(chunk) &&
+                   n < parser.space()) {
+                const Byte_t& b = _queue.front();
+                chunk[n++] = b.baud == rxBaud ? b.value : (uint8_t)nextRandom();
+                _queue.pop_front();
+            }
+            if (n == 0) break;
+            parser.write(chunk, n);
+            PacketView_t packet;
+            while (parser.next(&packet)) onPacket(packet);
+        }
+    }
+
+private:
+    typedef struct {
+        uint64_t arrivalUs;
+        uint32_t baud;
+        uint8_t value;
+    } Byte_t;
+
+    Cable_t _cable;
+    std::deque<Byte_t> _queue;
+    double _busyUntilUs;
+};
+
+// LinkSpeed から見た HardwareSerial
+class SimSerial {
+public:
+    explicit SimSerial(Wire& tx) : _tx(tx), _baud(UART_BAUD_RATE), _txBytes(0) {}
+
+    size_t write(const uint8_t* data, size_t length) {
+        _tx.write(data, length, _baud);
+        _txBytes += length;
+        return length;
+    }
+    void flush() {}     // 送信済みのバイトは送ったときのボーレートのまま届く
+    void updateBaudRate(unsigned long baud) { _baud = (uint32_t)baud; }
+    uint32_t baud() const { return _baud; }
+    uint32_t txBytes() const { return _txBytes; }
+
+private:
+    Wire& _tx;
+    uint32_t _baud;
+    uint32_t _txBytes;
+};
+
+// =============================================================================
+// 1ボード
+// =============================================================================
+struct Board {
+    Board(Wire& tx, Wire& rx) : serial(tx), rxWire(rx), trafficTx(0), trafficRx(0), txBytes(0) {}
+
+    SimSerial serial;
+    Wire& rxWire;
+    PacketParser parser;
+    LinkSpeed speed;
+    bool answers = true;        // false = CMD_LINK_SPEED を知らない古いファームウェア
+    uint32_t trafficTx;
+    uint32_t trafficRx;
+    uint32_t txBytes;
+
+    void reset(bool initiator, uint32_t now) {
+        parser.reset();
+        serial.updateBaudRate(UART_BAUD_RATE);
+        speed.begin(initiator, UART_BAUD_RATE, 4000000, now);
+    }
+
+    void step(uint32_t now) {
+        rxWire.deliver(parser, serial.baud(), [&](const PacketView_t& packet) {
+            if (packet.cmd == CMD_LINK_SPEED) {
+                if (answers) speed.receive(serial, packet, now);
+            } else if (packet.cmd == CMD_SERVO_FRAME_DELTA && packet.length == TRAFFIC_LENGTH) {
+                trafficRx++;
+            }
+        });
+        if (now % TRAFFIC_INTERVAL_MS == 0) {
+            uint8_t data[TRAFFIC_LENGTH];
+            memset(data, (uint8_t)trafficTx, sizeof(data));
+            uint8_t frame[PACKET_MAX_SIZE];
+            uint8_t length = buildPacketV2(frame, 0, 0, 0, CMD_SERVO_FRAME_DELTA, data, sizeof(data));
+            serial.write(frame, length);
+            txBytes += length;
+            trafficTx++;
+        }
+        if (answers) speed.poll(serial, now, parser.stats(), txBytes);
+    }
+};
+
+// =============================================================================
+// シナリオ
+// =============================================================================
+typedef enum {
+    EVENT_NONE,
+    EVENT_DEGRADE,              // 途中で配線が悪くなる（cleanBaud が下がる）
+    EVENT_RESPONDER_RESET,      // 途中で応答側がリセット
+} Event_t;
+
+typedef struct {
+    const char* name;
+    Cable_t cable;
+    bool responderAnswers;
+    Event_t event;
+    uint32_t eventMs;
+    Cable_t afterCable;
+    uint32_t expectBaud;        // 最後に落ち着くべきボーレート
+} Scenario_t;
+
+static bool runScenario(const Scenario_t& s, uint32_t seconds, bool verbose) {
+    Wire down(s.cable);
+    Wire up(s.cable);
+    Board initiator(down, up);
+    Board responder(up, down);
+    initiator.reset(true, 0);
+    responder.reset(false, 0);
+    responder.answers = s.responderAnswers;
+
+    int32_t firstSettledMs = -1;
+    uint32_t lastUnsettledMs = 0;   // 最後に「期待したボーレートで確定」していなかった時刻
+    uint32_t mismatchMs = 0;
+
+    for (uint32_t now = 0; now < seconds * 1000; now++) {
+        simNowUs = (uint64_t)now * 1000;
+
+        if (s.event != EVENT_NONE && now == s.eventMs) {
+            if (s.event == EVENT_DEGRADE) {
+                down.setCable(s.afterCable);
+                up.setCable(s.afterCable);
+            } else {
+                responder.reset(false, now);
+            }
+        }
+
+        uint32_t before = initiator.serial.baud();
+        initiator.step(now);
+        responder.step(now);
+        if (verbose && initiator.serial.baud() != before) {
+            printf("    %6u ms: %u -> %u\n", (unsigned)now, (unsigned)before, (unsigned)initiator.serial.baud());
+        }
+
+        bool settled = initiator.speed.state() == LINK_SPEED_RUNNING &&
+                       responder.speed.state() == LINK_SPEED_RUNNING &&
+                       initiator.serial.baud() == responder.serial.baud();
+        if (initiator.serial.baud() != responder.serial.baud()) mismatchMs++;
+        if (settled && firstSettledMs < 0) firstSettledMs = (int32_t)now;
+        if (!settled || initiator.serial.baud() != s.expectBaud) lastUnsettledMs = now;
+    }
+
+    LinkStatusData_t a, b;
+    initiator.speed.fillStatus(&a, LINK_MAIN_UPPER);
+    responder.speed.fillStatus(&b, LINK_MAIN_UPPER);
+    const LinkSpeedStats_t& st = initiator.speed.stats();
+
+    printf("  %-30s final %7u baud  first %5d ms", s.name, (unsigned)a.baud, (int)firstSettledMs);
+    if (s.event != EVENT_NONE) printf("  recover %5d ms", (int)(lastUnsettledMs + 1 - s.eventMs));
+    printf("  trial-fail %u reject %u fallback %u/%u  mismatch %u ms  traffic %5.1f%%  rx %6u B/s err %u/1000\n",
+           (unsigned)st.trialFailures, (unsigned)st.rejects, (unsigned)st.errorFallbacks,
+           (unsigned)st.silenceFallbacks, (unsigned)mismatchMs,
+           responder.trafficRx * 100.0 / (initiator.trafficTx ? initiator.trafficTx : 1),
+           (unsigned)b.rx_bytes_per_s, (unsigned)b.rx_error_permille);
+
+    bool ok = a.baud == s.expectBaud && initiator.serial.baud() == responder.serial.baud();
+    if (!ok) printf("    ** FAIL ** (expected %u, responder at %u)\n", (unsigned)s.expectBaud,
+                    (unsigned)responder.serial.baud());
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 30;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;     // ボーレートが変わるたびに表示
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+    nativeHalInit();
+
+    const uint32_t eventMs = seconds * 1000 / 3;
+    static const Cable_t SHORT = {4000000, 0, 1e-2};
+    static const Cable_t MEDIUM = {2000000, 1e-7, 1e-3};
+    static const Cable_t LONG = {921600, 1e-6, 3e-4};
+    static const Cable_t NOISY = {460800, 1e-6, 5e-3};
+
+    const Scenario_t SCENARIOS[] = {
+        {"short cable (4M clean)", SHORT, true, EVENT_NONE, 0, SHORT, 4000000},
+        {"medium cable (2M clean)", MEDIUM, true, EVENT_NONE, 0, MEDIUM, 2000000},
+        {"long cable (921600 clean)", LONG, true, EVENT_NONE, 0, LONG, 921600},
+        {"old responder (no answer)", SHORT, false, EVENT_NONE, 0, SHORT, UART_BAUD_RATE},
+        {"degrades to 460800 mid-run", SHORT, true, EVENT_DEGRADE, eventMs, NOISY, 460800},
+        {"responder resets mid-run", SHORT, true, EVENT_RESPONDER_RESET, eventMs, SHORT, 4000000},
+    };
+
+    printf("=== コロ助 link speed benchmark ===\n");
+    printf("base %u baud, %u s per run, %u probes x %u bytes, error threshold %u/1000 x %u windows of %u ms\n",
+           UART_BAUD_RATE, seconds, LINK_SPEED_PROBES, PACKET_MAX_SIZE, LINK_SPEED_MAX_ERROR_PERMILLE,
+           LINK_SPEED_BAD_WINDOWS, LINK_SPEED_WINDOW_MS);
+
+    bool ok = true;
+    for (const Scenario_t& s : SCENARIOS) {
+        rngState = 0x12345678;
+        ok = runScenario(s, seconds, verbose) && ok;
+    }
+
+    printf("\n%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
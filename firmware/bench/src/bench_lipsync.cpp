@@ -0,0 +1,111 @@
+/**
+ * コロ助ロボット - リップシンク振幅抽出 ベンチマーク
+ * Corosuke Robot - Lip-Sync Envelope Benchmark
+ *
+ * 合成音声（音節ごとに振幅が変わる 24kHz ステレオ）をデコーダと同じ
+ * バッファ単位で LipSync に流し、1バッファあたりの処理時間と、
+ * バッファの再生時間（I2S が空になるまでの猶予）に対する割合を出す。
+ * 窓の数がサーボ周期どおりか、無音区間で口が閉じるかも確認する。
+ *
+ *   pio run -e lipsync -t exec
+ */
+
+#include <Arduino.h>
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../../common/config.h"
+#include "../../common/lipsync.h"
+
+static const uint32_t SAMPLE_RATE = 24000;
+static const uint32_t CHANNELS = 2;
+static const uint32_t BUFFER_FRAMES = 1024;     // audio_process_i2s 1回分
+static const uint32_t SECONDS = 20;
+static const uint32_t REPEAT = 20;              // 時計の分解能より長く測るため
+
+static int16_t pcm[SAMPLE_RATE * SECONDS * CHANNELS];
+
+// 180Hz の声 + 4Hz の音節、音節の合間は無音
+static void synthesize() {
+    for (uint32_t i = 0; i < SAMPLE_RATE * SECONDS; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        double syllable = sin(2 * M_PI * 4 * t);
+        double envelope = syllable > 0.2 ? syllable : 0.0;
+        double voice = sin(2 * M_PI * 180 * t) + 0.5 * sin(2 * M_PI * 360 * t);
+        int16_t sample = (int16_t)(envelope * voice * 12000);
+        pcm[2 * i] = sample;
+        pcm[2 * i + 1] = sample;
+    }
+}
+
+// 比較用: サンプルごとに float で二乗和
+static float naiveRms(const int16_t* x, uint32_t n) {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float v = x[i] / 32768.0f;
+        sum += v * v;
+    }
+    return sqrtf(sum / n) * 32768.0f;
+}
+
+static volatile float sink;
+
+int main() {
+    printf("=== コロ助 lip-sync benchmark ===\n");
+    synthesize();
+
+    const uint32_t buffers = SAMPLE_RATE * SECONDS / BUFFER_FRAMES;
+    const double bufferUs = BUFFER_FRAMES * 1e6 / SAMPLE_RATE;
+    printf("%u Hz x %u ch, %u-frame buffers (%.1f ms of audio each), %u s\n",
+           SAMPLE_RATE, CHANNELS, BUFFER_FRAMES, bufferUs / 1000.0, SECONDS);
+
+    BenchStats lipsyncNs, naiveNs;
+    LipSync lipSync;
+    LipSync timing;
+    lipSync.begin(SAMPLE_RATE, SERVO_UPDATE_INTERVAL_MS);
+    timing.begin(SAMPLE_RATE, SERVO_UPDATE_INTERVAL_MS);
+    uint32_t closedWindows = 0;
+    uint32_t openWindows = 0;
+
+    for (uint32_t b = 0; b < buffers; b++) {
+        const int16_t* buffer = pcm + b * BUFFER_FRAMES * CHANNELS;
+
+        uint64_t t0 = benchNowNs();
+        for (uint32_t r = 0; r < REPEAT; r++) {
+            sink = naiveRms(buffer, BUFFER_FRAMES * CHANNELS);
+        }
+        uint64_t t1 = benchNowNs();
+        naiveNs.add((t1 - t0) / REPEAT);
+
+        // 計測は別インスタンスで繰り返し、結果の確認は lipSync で1回だけ
+        t0 = benchNowNs();
+        for (uint32_t r = 0; r < REPEAT; r++) {
+            timing.process(buffer, BUFFER_FRAMES, CHANNELS);
+        }
+        t1 = benchNowNs();
+        lipsyncNs.add((t1 - t0) / REPEAT);
+        lipSync.process(buffer, BUFFER_FRAMES, CHANNELS);
+
+        uint8_t level;
+        while (timing.pop(&level)) {
+        }
+        while (lipSync.pop(&level)) {
+            if (level == 0) closedWindows++;
+            else openWindows++;
+        }
+    }
+
+    printf("per buffer (host CPU)\n");
+    naiveNs.printNs("float per-sample RMS");
+    lipsyncNs.printNs("LipSync::process");
+    printf("  %-28s %.4f%% of the buffer's playback time (p99)\n", "I2S underrun margin used",
+           100.0 * lipsyncNs.percentile(0.99) / (bufferUs * 1000.0));
+
+    const LipSyncStats_t& stats = lipSync.stats();
+    uint32_t expected = buffers * BUFFER_FRAMES / (SAMPLE_RATE * SERVO_UPDATE_INTERVAL_MS / 1000);
+    printf("windows: %u (expected %u), dropped %u, mouth closed in %u / open in %u windows\n",
+           stats.windows, expected, stats.dropped, closedWindows, openWindows);
+    return (stats.windows == expected && closedWindows > 0 && openWindows > 0) ? 0 : 1;
+}
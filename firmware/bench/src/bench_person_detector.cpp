@@ -0,0 +1,235 @@
+/**
+ * コロ助ロボット - 人物検知 ベンチマーク
+ * Corosuke Robot - Person Detector Benchmark
+ *
+ * QQVGA グレースケールのフレーム列を PersonDetector に流し、1フレームあたりの
+ * 処理時間と検知の正しさを確かめる。
+ *
+ * - 引数なし: 合成シーン（無人 → 人物が横切る → 立ち止まる → 去る）を生成し、
+ *   正解と比べて検知の遅れ・誤検知・顔位置の誤差を出す
+ * - 引数あり: P5 (バイナリ) PGM を順に読み込む。160x120 でなければ
+ *   最近傍で縮小する。正解がないので検知結果の一覧だけ出す
+ *
+ *   pio run -e person_detector -t exec
+ *   .pio/build/person_detector/program frame000.pgm frame001.pgm ...
+ */
+
+#include <bench_stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../../common/person_detector.h"
+
+static const uint32_t FPS = 20;
+static const uint32_t REPEAT = 5;               // 時計の分解能より長く測るため
+
+typedef struct {
+    std::vector<uint8_t> pixels;                // VISION_WIDTH x VISION_HEIGHT
+    bool person;                                // 合成シーンの正解
+    int faceX, faceY;                           // VISION_REPORT_* 基準
+} Frame_t;
+
+// =============================================================================
+// PGM 読み込み（P5、maxval 255 まで）
+// =============================================================================
+static bool readToken(FILE* f, int* value) {
+    int c = fgetc(f);
+    while (c == '#' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) c = fgetc(f);
+        }
+        c = fgetc(f);
+    }
+    if (c < '0' || c > '9') return false;
+    *value = 0;
+    while (c >= '0' && c <= '9') {
+        *value = *value * 10 + (c - '0');
+        c = fgetc(f);
+    }
+    return true;
+}
+
+static bool loadPgm(const char* path, Frame_t* frame) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    int width, height, maxval;
+    bool ok = fgetc(f) == 'P' && fgetc(f) == '5' && readToken(f, &width) && readToken(f, &height) &&
+              readToken(f, &maxval) && width > 0 && height > 0 && maxval > 0 && maxval < 256;
+    std::vector<uint8_t> raw;
+    if (ok) {
+        raw.resize((size_t)width * height);
+        ok = fread(raw.data(), 1, raw.size(), f) == raw.size();
+    }
+    fclose(f);
+    if (!ok) return false;
+
+    frame->pixels.resize(VISION_WIDTH * VISION_HEIGHT);
+    for (int y = 0; y < VISION_HEIGHT; y++) {
+        for (int x = 0; x < VISION_WIDTH; x++) {
+            int v = raw[(size_t)(y * height / VISION_HEIGHT) * width + x * width / VISION_WIDTH];
+            frame->pixels[y * VISION_WIDTH + x] = (uint8_t)(v * 255 / maxval);
+        }
+    }
+    frame->person = false;
+    return true;
+}
+
+// =============================================================================
+// 合成シーン
+// =============================================================================
+static uint32_t noiseState = 1;
+
+static void fillRect(uint8_t* pixels, int x0, int y0, int x1, int y1, uint8_t value) {
+    for (int y = y0 < 0 ? 0 : y0; y < y1 && y < VISION_HEIGHT; y++) {
+        for (int x = x0 < 0 ? 0 : x0; x < x1 && x < VISION_WIDTH; x++) {
+            pixels[y * VISION_WIDTH + x] = value;
+        }
+    }
+}
+
+// 人物の左端 x（-1 なら無人）で1フレーム描く。照明がゆっくり変わる
+static Frame_t makeFrame(int personX, uint32_t index) {
+    Frame_t frame;
+    frame.pixels.resize(VISION_WIDTH * VISION_HEIGHT);
+    int light = (int)(index / 8 % 10);
+    for (int y = 0; y < VISION_HEIGHT; y++) {
+        for (int x = 0; x < VISION_WIDTH; x++) {
+            noiseState = noiseState * 1103515245 + 12345;
+            int v = 50 + light + x / 4 + (y / 20) * 6 + (int)((noiseState >> 16) % 9);
+            frame.pixels[y * VISION_WIDTH + x] = (uint8_t)v;
+        }
+    }
+
+    frame.person = personX >= 0;
+    frame.faceX = frame.faceY = 0;
+    if (frame.person) {
+        const int w = 32, head = 20, top = 18;
+        fillRect(frame.pixels.data(), personX + (w - head) / 2, top, personX + (w + head) / 2, top + head, 205);
+        fillRect(frame.pixels.data(), personX, top + head, personX + w, VISION_HEIGHT, 165);
+        frame.faceX = (personX + w / 2) * VISION_REPORT_WIDTH / VISION_WIDTH;
+        frame.faceY = (top + head / 2) * VISION_REPORT_HEIGHT / VISION_HEIGHT;
+    }
+    return frame;
+}
+
+static std::vector<Frame_t> syntheticScene() {
+    std::vector<Frame_t> frames;
+    uint32_t i = 0;
+    for (uint32_t n = 0; n < 3 * FPS; n++) frames.push_back(makeFrame(-1, i++));           // 無人 3 s
+    for (int x = 0; x <= 64; x += 2) frames.push_back(makeFrame(x, i++));                  // 入ってくる
+    for (uint32_t n = 0; n < 2 * FPS; n++) {                                               // 立ち止まって揺れる 2 s
+        frames.push_back(makeFrame(64 + (int)(n / 2 % 3), i++));
+    }
+    for (int x = 66; x <= 128; x += 3) frames.push_back(makeFrame(x, i++));                // 去っていく
+    for (uint32_t n = 0; n < 3 * FPS; n++) frames.push_back(makeFrame(-1, i++));           // 無人 3 s
+    return frames;
+}
+
+int main(int argc, char** argv) {
+    printf("=== コロ助 person detector benchmark ===\n");
+
+    std::vector<Frame_t> frames;
+    bool synthetic = argc < 2;
+    if (synthetic) {
+        frames = syntheticScene();
+        printf("synthetic scene: %zu frames at %u fps (%dx%d)\n", frames.size(), FPS, VISION_WIDTH, VISION_HEIGHT);
+    } else {
+        for (int i = 1; i < argc; i++) {
+            Frame_t frame;
+            if (!loadPgm(argv[i], &frame)) {
+                printf("cannot read %s (P5 PGM only)\n", argv[i]);
+                return 1;
+            }
+            frames.push_back(frame);
+        }
+        printf("%zu PGM frames\n", frames.size());
+    }
+
+    // motionKernel は別の背景モデルで繰り返し測り、process() は1回ずつ測る
+    BenchStats kernelNs, processNs;
+    static PersonDetector detector;
+    static uint16_t background[VISION_WIDTH * VISION_HEIGHT];
+    static const uint8_t noPerson[VISION_CELLS] = {0};
+    uint8_t counts[VISION_CELLS];
+
+    uint32_t truePositives = 0, falsePositives = 0, falseNegatives = 0, trueNegatives = 0, holdFrames = 0;
+    uint32_t firstPerson = UINT32_MAX, firstDetected = UINT32_MAX;
+    uint32_t lastPerson = 0, lostAt = UINT32_MAX;
+    uint64_t faceErrorSum = 0;
+    uint32_t faceErrorCount = 0, faceErrorMax = 0;
+
+    for (uint32_t i = 0; i < frames.size(); i++) {
+        const uint8_t* pixels = frames[i].pixels.data();
+
+        uint64_t t0 = benchNowNs();
+        for (uint32_t r = 0; r < REPEAT; r++) {
+            PersonDetector::motionKernel(pixels, background, noPerson, counts);
+        }
+        kernelNs.add((benchNowNs() - t0) / REPEAT);
+
+        VisionResult_t result;
+        t0 = benchNowNs();
+        detector.process(pixels, VISION_WIDTH, VISION_HEIGHT, &result);
+        processNs.add(benchNowNs() - t0);
+
+        if (!synthetic) {
+            if (result.changed || result.detected) {
+                printf("  frame %3u: %s face (%d, %d) size %u\n", i, result.detected ? "person" : "lost  ",
+                       result.faceX, result.faceY, result.size);
+            }
+            continue;
+        }
+
+        const Frame_t& truth = frames[i];
+        if (truth.person) {
+            if (firstPerson == UINT32_MAX) firstPerson = i;
+            lastPerson = i;
+        }
+        if (result.detected && firstDetected == UINT32_MAX) firstDetected = i;
+        if (!result.detected && result.changed) lostAt = i;
+
+        if (truth.person && result.detected) {
+            truePositives++;
+            uint32_t error = (uint32_t)(abs(result.faceX - truth.faceX) + abs(result.faceY - truth.faceY));
+            faceErrorSum += error;
+            faceErrorCount++;
+            if (error > faceErrorMax) faceErrorMax = error;
+        } else if (truth.person) {
+            falseNegatives++;
+        } else if (firstPerson != UINT32_MAX && i - lastPerson < VISION_LOST_FRAMES) {
+            holdFrames++;           // 去った直後は喪失判定待ち（正解・誤りに数えない）
+        } else if (result.detected) {
+            falsePositives++;
+        } else {
+            trueNegatives++;
+        }
+    }
+
+    printf("per frame (host CPU, %dx%d)\n", VISION_WIDTH, VISION_HEIGHT);
+    kernelNs.printNs("motionKernel");
+    processNs.printNs("PersonDetector::process");
+    printf("  %-28s %.3f%% of the %u ms frame period (p99)\n", "CPU share",
+           100.0 * processNs.percentile(0.99) / (1e6 * 1000 / FPS), 1000 / FPS);
+    if (!synthetic) return 0;
+
+    const uint32_t frameMs = 1000 / FPS;
+    uint32_t detectMs = firstDetected != UINT32_MAX ? (firstDetected - firstPerson) * frameMs : UINT32_MAX;
+    uint32_t loseMs = lostAt != UINT32_MAX && lostAt > lastPerson ? (lostAt - lastPerson) * frameMs : UINT32_MAX;
+    uint32_t meanError = faceErrorCount ? (uint32_t)(faceErrorSum / faceErrorCount) : 0;
+    printf("accuracy (frames)\n");
+    printf("  %-28s %u / %u person frames, %u false positives in %u empty frames (+%u hold-off)\n", "detected",
+           truePositives, truePositives + falseNegatives, falsePositives, falsePositives + trueNegatives,
+           holdFrames);
+    printf("  %-28s detect after %u ms, lost %u ms after leaving\n", "latency", detectMs, loseMs);
+    printf("  %-28s mean %u px, max %u px (L1, 320x240 coordinates)\n", "face position error",
+           meanError, faceErrorMax);
+
+    bool ok = falsePositives == 0 && detectMs <= 200 && loseMs <= 1000 &&
+              truePositives * 10 >= (truePositives + falseNegatives) * 9 && meanError < 40;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,404 @@
+/**
+ * コロ助ロボット - プロトコル v2 再送リンク ベンチマーク
+ * Corosuke Robot - Protocol v2 Reliable Link Benchmark
+ *
+ * メイン → 上半身の UART をホスト上で模擬し、雑音（ビット反転とバイトの欠落）を
+ * 入れたときに v1（XOR チェックサム、再送なし）と v2（CRC-16 + SEQ/ACK/NACK 再送）で
+ * コマンドがどれだけ届くかを比べる。
+ *
+ * - 回線: 115200bps 8N1（1バイト 86.8us）、両方向とも同じ雑音
+ * - 両ボードの loop は 1ms ごと（受信 → リンク処理 → 送信）
+ * - 送るもの: リップシンク 30Hz と サーボ差分 50Hz（送りっぱなし）、
+ *   表情コマンド（確実に届けるもの）。データに通し番号と検査用パターンを入れ、
+ *   受信側で「届いた・壊れて届いた・順番違い・重複」を数える
+ * - 互換: 新しいメインと古い上半身（v2 フレームを捨てる）、その逆
+ *
+ *   pio run -e reliable_link -t exec
+ *   pio run -e reliable_link -t exec -a "--seconds 120"
+ */
+
+#include <Arduino.h>
+#include <bench_stats.h>
+#include <native_hal.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+#include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+#include "../../common/reliable_link.h"
+
+static const uint32_t BAUD = 115200;
+static const double BYTE_US = 10e6 / BAUD;
+
+static const uint32_t LIPSYNC_INTERVAL_MS = 33;
+static const uint32_t SERVO_INTERVAL_MS = 20;
+static const uint8_t LIPSYNC_LENGTH = 4;     // 実際は 1〜2 バイト（検査用の通し番号を入れる分）
+static const uint8_t SERVO_LENGTH = 10;
+static const uint8_t COMMAND_LENGTH = 12;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x12345678;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// 0.0〜1.0
+static double nextUniform() {
+    return (nextRandom() >> 8) / (double)(1u << 24);
+}
+
+// =============================================================================
+// 回線（片方向）
+// =============================================================================
+typedef struct {
+    double bitErrorRate;        // ビットごとの反転確率
+    double dropRate;            // バイトごとの欠落開始確率
+    uint32_t dropBurst;         // 欠落が続く最大バイト数
+} Noise_t;
+
+static uint64_t simNowUs = 0;
+
+class Wire {
+public:
+    explicit Wire(const Noise_t& noise) : _noise(noise), _busyUntilUs(0), _dropLeft(0), _bytes(0) {}
+
+    // ReliableLink の出力先
+    size_t write(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (_busyUntilUs < simNowUs) _busyUntilUs = simNowUs;
+            _busyUntilUs += (uint64_t)BYTE_US;
+            _bytes++;
+
+            if (_dropLeft == 0 && nextUniform() < _noise.dropRate) {
+                _dropLeft = 1 + nextRandom() % _noise.dropBurst;
+            }
+            if (_dropLeft > 0) {
+                _dropLeft--;
+                continue;
+            }
+            uint8_t byte = data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                if (nextUniform() < _noise.bitErrorRate) byte ^= (uint8_t)(1 << bit);
+            }
+            _queue.push_back(Byte_t{_busyUntilUs, byte});
+        }
+        return length;
+    }
+
+    // 届いたバイトをパーサーへ
+    size_t deliver(PacketParser& parser) {
+        uint8_t chunk[256];
+        size_t n = 0;
+        while (!_queue.empty() && _queue.front().arrivalUs <= simNowUs && n < sizeof(chunk)) {
+            chunk[n++] = _queue.front().value;
+            _queue.pop_front();
+        }
+        parser.write(chunk, n);
+        return n;
+    }
+
+    uint64_t bytes() const { return _bytes; }
+
+private:
+    typedef struct {
+        uint64_t arrivalUs;
+        uint8_t value;
+    } Byte_t;
+
+    Noise_t _noise;
+    std::deque<Byte_t> _queue;
+    uint64_t _busyUntilUs;
+    uint32_t _dropLeft;
+    uint64_t _bytes;
+};
+
+// =============================================================================
+// 送受信する中身
+// =============================================================================
+static void fillPayload(uint8_t* data, uint8_t length, uint32_t id) {
+    memcpy(data, &id, sizeof(id));
+    for (uint8_t i = sizeof(id); i < length; i++) {
+        data[i] = (uint8_t)(id * 31 + i * 7);
+    }
+}
+
+static bool checkPayload(const uint8_t* data, uint8_t length, uint8_t expectedLength, uint32_t* id) {
+    if (length != expectedLength) return false;
+    memcpy(id, data, sizeof(*id));
+    for (uint8_t i = sizeof(*id); i < length; i++) {
+        if (data[i] != (uint8_t)(*id * 31 + i * 7)) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    uint32_t sent;
+    uint32_t delivered;         // 正しい内容で1回だけ届いた
+    uint32_t corrupted;         // 壊れた内容のまま受け取ってしまった
+    uint32_t duplicates;
+    uint32_t outOfOrder;
+    uint32_t lastId;
+    bool any;
+    std::vector<uint64_t> sentUs;
+    std::vector<bool> seen;
+} Flow_t;
+
+static void flowSend(Flow_t& flow) {
+    flow.sent++;
+    flow.sentUs.push_back(simNowUs);
+    flow.seen.push_back(false);
+}
+
+static void flowReceive(Flow_t& flow, const uint8_t* data, uint8_t length, uint8_t expectedLength,
+                        BenchStats* latency) {
+    uint32_t id;
+    if (!checkPayload(data, length, expectedLength, &id) || id >= flow.sent) {
+        flow.corrupted++;
+        return;
+    }
+    if (flow.seen[id]) {
+        flow.duplicates++;
+        return;
+    }
+    if (flow.any && id < flow.lastId) flow.outOfOrder++;
+    flow.seen[id] = true;
+    flow.lastId = id;
+    flow.any = true;
+    flow.delivered++;
+    if (latency) latency->add((simNowUs - flow.sentUs[id]) * 1000);
+}
+
+// =============================================================================
+// 1シナリオ
+// =============================================================================
+typedef enum {
+    MODE_V1,            // 従来どおり v1 フレームを送りっぱなし
+    MODE_V2,            // 両方とも v2（HELLO で切り替わる）
+    MODE_NEW_TO_OLD,    // 新しいメイン → 古い上半身（v2 フレームを捨てる）
+    MODE_OLD_TO_NEW,    // 古いメイン → 新しい上半身
+} Mode_t;
+
+typedef struct {
+    uint32_t seconds;
+    uint32_t commandIntervalMs; // 表情コマンドの間隔
+} Workload_t;
+
+typedef struct {
+    Flow_t commands;
+    Flow_t streams;             // リップシンク + サーボ（まとめて数える）
+    BenchStats latency;
+    uint64_t wireBytes;
+    uint64_t payloadBytes;
+    LinkStats_t mainLink;
+    LinkStats_t upperLink;
+    ParserStats_t upperParser;
+} Result_t;
+
+static void receiveCommand(const PacketView_t& packet, Result_t* r) {
+    if (packet.cmd == CMD_EXPRESSION) {
+        flowReceive(r->commands, packet.data, packet.length, COMMAND_LENGTH, &r->latency);
+    } else if (packet.cmd == CMD_SERVO_FRAME_DELTA) {
+        flowReceive(r->streams, packet.data, packet.length, SERVO_LENGTH, NULL);
+    } else if (packet.cmd == CMD_LIPSYNC_DATA) {
+        flowReceive(r->streams, packet.data, packet.length, LIPSYNC_LENGTH, NULL);
+    } else {
+        r->commands.corrupted++;        // 送っていないコマンド
+    }
+}
+
+static void sendFrame(Wire& wire, uint8_t cmd, const uint8_t* data, uint8_t length) {
+    uint8_t frame[PACKET_MAX_SIZE];
+    wire.write(frame, buildPacket(frame, cmd, data, length));
+}
+
+static void runScenario(Mode_t mode, const Noise_t& noise, const Workload_t& work, Result_t* r) {
+    Wire down(noise);
+    Wire up(noise);
+
+    static PacketParser mainParser;
+    static PacketParser upperParser;
+    static ReliableLink mainLink;
+    static ReliableLink upperLink;
+    mainParser.reset();
+    upperParser.reset();
+    mainLink.reset((uint8_t)nextRandom());
+    upperLink.reset((uint8_t)nextRandom());
+
+    bool mainV2 = mode == MODE_V2 || mode == MODE_NEW_TO_OLD;
+    bool upperV2 = mode == MODE_V2 || mode == MODE_OLD_TO_NEW;
+
+    uint32_t streamId = 0;
+    uint32_t lastUpperRxMs = 0;
+    uint32_t lastMainRxMs = 0;
+    r->latency.clear();
+
+    uint64_t endUs = (uint64_t)work.seconds * 1000000;
+    // 最後に送ったコマンドの再送が終わるまで少し回す
+    uint64_t drainUs = endUs + 500000;
+
+    for (simNowUs = 0; simNowUs < drainUs; simNowUs += 1000) {
+        uint32_t now = (uint32_t)(simNowUs / 1000);
+        bool sending = simNowUs < endUs;
+
+        // ---- メインボード ----
+        if (sending) {
+            uint8_t data[PACKET_MAX_SIZE];
+            if (now % work.commandIntervalMs == 0) {
+                fillPayload(data, COMMAND_LENGTH, r->commands.sent);
+                flowSend(r->commands);
+                r->payloadBytes += COMMAND_LENGTH;
+                if (mainV2) mainLink.send(down, CMD_EXPRESSION, data, COMMAND_LENGTH, now);
+                else sendFrame(down, CMD_EXPRESSION, data, COMMAND_LENGTH);
+            }
+            bool lipsync = now % LIPSYNC_INTERVAL_MS == 0;
+            bool servo = now % SERVO_INTERVAL_MS == 0;
+            if (lipsync || servo) {
+                uint8_t cmd = servo ? CMD_SERVO_FRAME_DELTA : CMD_LIPSYNC_DATA;
+                uint8_t length = servo ? SERVO_LENGTH : LIPSYNC_LENGTH;
+                fillPayload(data, length, streamId++);
+                flowSend(r->streams);
+                r->payloadBytes += length;
+                if (mainV2) mainLink.send(down, cmd, data, length, now);
+                else sendFrame(down, cmd, data, length);
+            }
+        }
+        if (mainV2) {
+            if (up.deliver(mainParser) > 0) lastMainRxMs = now;
+            else if (mainParser.buffered() > 0 && now - lastMainRxMs >= UART_IDLE_RESYNC_MS) mainParser.resyncIfStalled();
+            PacketView_t packet;
+            while (mainParser.next(&packet)) {
+                mainLink.receive(down, packet, now);
+            }
+            mainLink.poll(down, now);
+        }
+
+        // ---- 上半身ボード ----
+        if (down.deliver(upperParser) > 0) lastUpperRxMs = now;
+        else if (upperParser.buffered() > 0 && now - lastUpperRxMs >= UART_IDLE_RESYNC_MS) upperParser.resyncIfStalled();
+
+        PacketView_t packet;
+        while (upperParser.next(&packet)) {
+            if (!upperV2) {
+                if (packet.version == 2) continue;      // 古いパーサーは 0xAB を読み飛ばす
+                receiveCommand(packet, r);
+                continue;
+            }
+            if (upperLink.receive(up, packet, now)) receiveCommand(packet, r);
+            while (upperLink.nextBuffered(&packet)) receiveCommand(packet, r);
+        }
+        if (upperV2) upperLink.poll(up, now);
+    }
+
+    r->wireBytes = down.bytes() + up.bytes();
+    r->mainLink = mainLink.stats();
+    r->upperLink = upperLink.stats();
+    r->upperParser = upperParser.stats();
+}
+
+// =============================================================================
+// 表示
+// =============================================================================
+static const char* modeName(Mode_t mode) {
+    switch (mode) {
+        case MODE_V1: return "v1";
+        case MODE_V2: return "v2";
+        case MODE_NEW_TO_OLD: return "v2 main/v1 upper";
+        case MODE_OLD_TO_NEW: return "v1 main/v2 upper";
+    }
+    return "?";
+}
+
+static double percent(uint32_t part, uint32_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+static bool printRow(Mode_t mode, const Noise_t& noise, const Workload_t& work, bool expectLossless) {
+    Result_t r = Result_t();
+    runScenario(mode, noise, work, &r);
+
+    double seconds = work.seconds;
+    double goodput = r.commands.delivered * (double)COMMAND_LENGTH / seconds;
+    printf("  %-17s cmd %6.2f%% (%5u/%5u) bad %4u dup %3u ooo %3u | stream %6.2f%% bad %4u | "
+           "goodput %5.0f B/s  wire %5.1f%%  retx %5u  nack %4u  giveup %u  qfull %u\n",
+           modeName(mode),
+           percent(r.commands.delivered, r.commands.sent), r.commands.delivered, r.commands.sent,
+           r.commands.corrupted, r.commands.duplicates, r.commands.outOfOrder,
+           percent(r.streams.delivered, r.streams.sent), r.streams.corrupted,
+           goodput, 100.0 * r.wireBytes * BYTE_US / (seconds * 1e6) / 2,
+           r.mainLink.retransmits, r.upperLink.nacksSent, r.mainLink.giveUps, r.mainLink.queueFull);
+    if (r.latency.count() > 0 && (mode == MODE_V2 || noise.bitErrorRate > 0)) {
+        r.latency.printUs("    command latency");
+    }
+
+    bool ok = true;
+    if (mode == MODE_V2) {
+        // v2: 壊れたコマンドを受け取らず、順番も守る
+        ok = r.commands.corrupted == 0 && r.commands.duplicates == 0 && r.commands.outOfOrder == 0 &&
+             r.streams.corrupted == 0;
+    }
+    if (expectLossless) ok = ok && r.commands.delivered == r.commands.sent;
+    if (!ok) printf("    ** FAIL **\n");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 60;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N]\n", argv[0]);
+            return 2;
+        }
+    }
+    nativeHalInit();
+
+    static const Noise_t NOISE[] = {
+        {0, 0, 1},
+        {1e-5, 0, 1},
+        {1e-4, 1e-4, 8},
+        {1e-3, 5e-4, 16},
+        {3e-3, 1e-3, 32},
+    };
+    static const Workload_t WORK[] = {
+        {seconds, 100},     // 普段（表情・動作コマンドが 10 回/秒）
+        {seconds, 4},       // 詰め込み（回線の 7 割程度を使う）
+    };
+
+    printf("=== コロ助 reliable link benchmark ===\n");
+    printf("%u baud, %u s per run, lipsync %u ms + servo delta %u ms (fire-and-forget), "
+           "window %u, initial RTO %u ms, retries %u\n",
+           BAUD, seconds, LIPSYNC_INTERVAL_MS, SERVO_INTERVAL_MS,
+           RELIABLE_LINK_WINDOW, RELIABLE_LINK_RTO_MS, RELIABLE_LINK_MAX_RETRIES);
+
+    bool ok = true;
+    for (const Workload_t& work : WORK) {
+        printf("\n--- commands every %u ms ---\n", work.commandIntervalMs);
+        for (const Noise_t& noise : NOISE) {
+            printf("BER %.0e, drop %.0e (burst <= %u bytes)\n",
+                   noise.bitErrorRate, noise.dropRate, noise.dropBurst);
+            rngState = 0x12345678;
+            printRow(MODE_V1, noise, work, noise.bitErrorRate == 0);
+            rngState = 0x12345678;
+            ok = printRow(MODE_V2, noise, work, noise.bitErrorRate <= 1e-4) && ok;
+        }
+    }
+
+    printf("\n--- rollout (no noise, commands every 100 ms) ---\n");
+    Noise_t clean = {0, 0, 1};
+    Workload_t work = {seconds, 100};
+    ok = printRow(MODE_NEW_TO_OLD, clean, work, true) && ok;
+    ok = printRow(MODE_OLD_TO_NEW, clean, work, true) && ok;
+
+    printf("\n%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
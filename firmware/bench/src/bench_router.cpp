@@ -0,0 +1,425 @@
+/**
+ * コロ助ロボット - 上半身の中継（優先度付き送信）ベンチマーク
+ * Corosuke Robot - Upper Board Packet Router Benchmark
+ *
+ * メインから届いたフレームを上半身が下半身へ中継するときに、歩行停止のような動作コマンドが
+ * サーボフレームや歩容テーブルの転送の後ろでどれだけ待たされるかを測る。
+ *
+ * - 従来: 受け取った順に Serial2.write()（送信バッファが一杯なら loop() が止まる）
+ * - ルーター: PacketRouter（送信バッファに積むのは ROUTER_TX_BACKLOG まで、残りは優先度順）
+ *
+ * 流すもの（上半身 → 下半身）
+ * - 下半身のサーボ差分 50Hz、キーフレーム 1Hz（ROUTE_STREAM）
+ * - 歩容テーブルの書き換え: 3 秒ごとに 24 チャンク、メイン側の UART が速いので 1ms に 1 つ届く（ROUTE_TRANSFER、1つでも欠けたら失敗）
+ * - 動作コマンド: 平均 150ms ごと（ROUTE_MOTION）
+ * - ステータス要求: 1 秒ごと（ROUTE_BULK）
+ *
+ * 確実に届けるコマンドがメインから下半身まで届くかも試す: 下半身への送信バッファが詰まっている
+ * 間にメインが動作コマンドを続けて送り、上半身 → 下半身でも1フレームを壊す。
+ * - 従来: 上半身は受け取った時点で ACK し、そのまま中継する（断られた・壊れたものは消える）
+ * - 再送つき: 上半身は lowerLink の送信待ちに空きがあるときだけ受け取り、SEQ を付け直して
+ *   RoutedOutput 経由で送る。下半身が ACK するまで lowerLink が再送する
+ *
+ *   pio run -e router -t exec
+ */
+
+#include <Arduino.h>
+#include <bench_stats.h>
+#include <native_hal.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+#include "../../common/config.h"
+#include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+#include "../../common/packet_router.h"
+#include "../../common/reliable_link.h"
+
+static const uint32_t SERVO_DELTA_INTERVAL_MS = 20;
+static const uint32_t SERVO_KEY_INTERVAL_MS = 1000;
+static const uint32_t GAIT_UPLOAD_INTERVAL_MS = 3000;
+static const uint32_t GAIT_UPLOAD_CHUNKS = 24;
+static const uint32_t MOTION_MEAN_INTERVAL_MS = 150;
+static const uint32_t STATUS_INTERVAL_MS = 1000;
+static const uint32_t BURST_COMMANDS = RELIABLE_LINK_QUEUE;     // 続けて送る動作コマンド
+static const uint32_t BURST_BACKLOG_BYTES = 600;                // そのとき下半身への送信バッファに残っている量
+static const uint32_t BURST_CORRUPT_FRAME = 2;                  // 上半身 → 下半身で壊すフレーム（先頭から）
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x12345678;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// =============================================================================
+// 送信側 UART（送信バッファ + FIFO をボーレートで排出）
+// =============================================================================
+static uint64_t simNowUs = 0;
+
+typedef struct {
+    uint64_t submitUs;
+    RoutePriority_t priority;
+} FrameInfo_t;
+
+static std::vector<FrameInfo_t> frames;     // データ先頭の通し番号 → 中継を頼んだ時刻
+
+class SimUart {
+public:
+    SimUart(uint32_t baud, size_t capacity)
+        : _byteUs(10e6 / baud), _capacity(capacity), _busyUntilUs(0), _stallUs(0), _maxStallUs(0) {}
+
+    int availableForWrite() const {
+        double level = _busyUntilUs > simNowUs ? (_busyUntilUs - simNowUs) / _byteUs : 0.0;
+        double room = (double)_capacity - level;
+        return room > 0 ? (int)room : 0;
+    }
+
+    size_t write(const uint8_t* frame, size_t length) {
+        if (_busyUntilUs < simNowUs) _busyUntilUs = (double)simNowUs;
+
+        // 入りきらない分は送信し終わるまで write() が返らない（loop() が止まる）
+        int room = availableForWrite();
+        if ((size_t)room < length) {
+            double stall = (length - room) * _byteUs;
+            _stallUs += stall;
+            if (stall > _maxStallUs) _maxStallUs = stall;
+        }
+        _busyUntilUs += length * _byteUs;
+
+        // v2（CTRL = 0）: [START][LEN][CTRL][CMD][通し番号 4 バイト]...
+        uint32_t id;
+        memcpy(&id, &frame[4], sizeof(id));
+        const FrameInfo_t& info = frames[id];
+        latency[info.priority].add((uint64_t)((_busyUntilUs - info.submitUs) * 1000));
+        return length;
+    }
+
+    BenchStats latency[ROUTE_PRIORITIES];
+    double stallUs() const { return _stallUs; }
+    double maxStallUs() const { return _maxStallUs; }
+
+private:
+    double _byteUs;
+    size_t _capacity;
+    double _busyUntilUs;
+    double _stallUs;
+    double _maxStallUs;
+};
+
+// =============================================================================
+// 1シナリオ
+// =============================================================================
+typedef struct {
+    uint32_t frames;
+    uint32_t dropped[ROUTE_PRIORITIES];
+    double stallMs;
+    double maxStallMs;
+} Result_t;
+
+static void submit(bool useRouter, PacketRouter& router, SimUart& uart, uint8_t cmd, uint8_t length,
+                   uint32_t now, Result_t* r) {
+    uint8_t data[PACKET_V2_MAX_DATA];
+    uint32_t id = (uint32_t)frames.size();
+    RoutePriority_t priority = routePriority(cmd);
+    frames.push_back(FrameInfo_t{simNowUs, priority});
+    memset(data, 0, sizeof(data));
+    memcpy(data, &id, sizeof(id));
+
+    uint8_t frame[PACKET_MAX_SIZE];
+    uint8_t size = buildPacketV2(frame, 0, 0, 0, cmd, data, length);
+    r->frames++;
+    if (useRouter) {
+        router.forward(uart, frame, size, priority, now);
+    } else {
+        uart.write(frame, size);
+    }
+}
+
+static void runScenario(bool useRouter, uint32_t baud, uint32_t seconds, SimUart& uart, Result_t* r) {
+    static PacketRouter router;
+    router.begin(UART_TX_BUFFER_SIZE + UART_HW_FIFO_SIZE);
+    frames.clear();
+    memset(r, 0, sizeof(*r));
+
+    uint32_t gaitChunksLeft = 0;
+    uint32_t nextMotionMs = MOTION_MEAN_INTERVAL_MS;
+
+    for (uint32_t now = 0; now < seconds * 1000; now++) {
+        simNowUs = (uint64_t)now * 1000;
+
+        if (now % SERVO_KEY_INTERVAL_MS == 0) {
+            submit(useRouter, router, uart, CMD_SERVO_FRAME, sizeof(ServoFrameData_t), now, r);
+        } else if (now % SERVO_DELTA_INTERVAL_MS == 0) {
+            submit(useRouter, router, uart, CMD_SERVO_FRAME_DELTA, sizeof(ServoFrameDeltaHeader_t) + 4, now, r);
+        }
+        if (now % GAIT_UPLOAD_INTERVAL_MS == 500) gaitChunksLeft = GAIT_UPLOAD_CHUNKS;
+        if (gaitChunksLeft > 0) {
+            submit(useRouter, router, uart, CMD_GAIT_TABLE, PACKET_V2_MAX_DATA, now, r);
+            gaitChunksLeft--;
+        }
+        if (now >= nextMotionMs) {
+            static const uint8_t MOTION[] = {CMD_WALK_STOP, CMD_WALK_DIRECTION, CMD_TURN, CMD_STAND};
+            uint8_t cmd = MOTION[nextRandom() % 4];
+            submit(useRouter, router, uart, cmd, cmd == CMD_WALK_DIRECTION ? 4 : 4, now, r);
+            nextMotionMs = now + 1 + nextRandom() % (2 * MOTION_MEAN_INTERVAL_MS);
+        }
+        if (now % STATUS_INTERVAL_MS == 250) {
+            submit(useRouter, router, uart, CMD_STATUS, 4, now, r);
+        }
+
+        if (useRouter) router.pump(uart, now);
+    }
+
+    if (useRouter) memcpy(r->dropped, router.stats().dropped, sizeof(r->dropped));
+    r->stallMs = uart.stallUs() / 1000.0;
+    r->maxStallMs = uart.maxStallUs() / 1000.0;
+    (void)baud;
+}
+
+static bool printScenario(bool useRouter, uint32_t baud, uint32_t seconds) {
+    SimUart uart(baud, UART_TX_BUFFER_SIZE + UART_HW_FIFO_SIZE);
+    Result_t r;
+    rngState = 0x12345678;
+    runScenario(useRouter, baud, seconds, uart, &r);
+
+    printf("%s: %u frames, loop() blocked %.1f ms total (max %.2f ms), "
+           "dropped motion %u / servo %u / gait %u / status %u\n",
+           useRouter ? "router" : "direct", r.frames, r.stallMs, r.maxStallMs,
+           r.dropped[ROUTE_MOTION], r.dropped[ROUTE_STREAM], r.dropped[ROUTE_TRANSFER], r.dropped[ROUTE_BULK]);
+    uart.latency[ROUTE_MOTION].printUs("motion command latency");
+    uart.latency[ROUTE_STREAM].printUs("servo frame latency");
+    uart.latency[ROUTE_TRANSFER].printUs("gait chunk latency");
+    uart.latency[ROUTE_BULK].printUs("status latency");
+
+    // 動作コマンドと歩容テーブルは捨ててはいけない
+    return r.dropped[ROUTE_MOTION] == 0 && r.dropped[ROUTE_TRANSFER] == 0;
+}
+
+// =============================================================================
+// 確実に届けるコマンドをメインから下半身まで
+// =============================================================================
+// メイン ↔ 上半身、下半身 → 上半身（1ms で届く、雑音なし）
+class Pipe {
+public:
+    size_t write(const uint8_t* data, size_t length) {
+        _bytes.insert(_bytes.end(), data, data + length);
+        return length;
+    }
+
+    void deliver(PacketParser& parser) {
+        if (!_bytes.empty()) parser.write(_bytes.data(), _bytes.size());
+        _bytes.clear();
+    }
+
+private:
+    std::vector<uint8_t> _bytes;
+};
+
+// 上半身 → 下半身（送信バッファが詰まった状態から、ボーレートで空いていく。corruptFrame 番目のフレームを壊す）
+class BackloggedUart {
+public:
+    BackloggedUart(uint32_t baud, size_t capacity, size_t backlog, uint32_t corruptFrame)
+        : _byteUs(10e6 / baud), _capacity(capacity), _busyUntilUs(backlog * _byteUs),
+          _corruptFrame(corruptFrame), _frames(0) {}
+
+    int availableForWrite() const {
+        double level = _busyUntilUs > simNowUs ? (_busyUntilUs - simNowUs) / _byteUs : 0.0;
+        double room = (double)_capacity - level;
+        return room > 0 ? (int)room : 0;
+    }
+
+    size_t write(const uint8_t* frame, size_t length) {
+        if (_busyUntilUs < simNowUs) _busyUntilUs = (double)simNowUs;
+        bool corrupt = _frames++ == _corruptFrame;
+        for (size_t i = 0; i < length; i++) {
+            _busyUntilUs += _byteUs;
+            uint8_t value = corrupt && i == length / 2 ? frame[i] ^ 0x10 : frame[i];
+            _queue.push_back(Byte_t{(uint64_t)_busyUntilUs, value});
+        }
+        return length;
+    }
+
+    // 送り終わったバイトを下半身のパーサーへ
+    void deliver(PacketParser& parser) {
+        while (!_queue.empty() && _queue.front().arrivalUs <= simNowUs) {
+            parser.write(&_queue.front().value, 1);
+            _queue.pop_front();
+        }
+    }
+
+private:
+    typedef struct {
+        uint64_t arrivalUs;
+        uint8_t value;
+    } Byte_t;
+
+    double _byteUs;
+    size_t _capacity;
+    double _busyUntilUs;
+    uint32_t _corruptFrame;
+    uint32_t _frames;
+    std::deque<Byte_t> _queue;
+};
+
+typedef struct {
+    uint32_t delivered;         // 下半身が処理した動作コマンド
+    uint32_t inOrder;           // そのうち順番どおり・重複なし
+    uint32_t refused;           // 中継の待ち行列に断られた（従来は消える、再送つきは送り直す）
+    uint32_t deferred;          // lowerLink の送信待ちが一杯で受け取らなかった（メインが再送）
+    uint32_t retransmits;       // 上半身 → 下半身の再送
+    uint32_t gaveUp;            // メイン・上半身が再送を諦めた
+    uint32_t doneMs;            // 最後の動作コマンドを下半身が処理した時刻
+} BurstResult_t;
+
+// relay: 上半身が lowerLink で再送する（上半身の handleUART() / routeToLower() と同じ）
+static void runBurst(bool relay, BurstResult_t* r) {
+    Pipe down;
+    Pipe up;
+    Pipe lowerUp;
+    BackloggedUart lowerWire(UART_BAUD_RATE, UART_TX_BUFFER_SIZE + UART_HW_FIFO_SIZE, BURST_BACKLOG_BYTES,
+                             BURST_CORRUPT_FRAME);
+    static PacketParser upperParser, mainParser, lowerParser, upperLowerParser;
+    static ReliableLink mainLink, upperMainLink, upperLowerLink, lowerLink;
+    static PacketRouter router;
+    upperParser.reset();
+    mainParser.reset();
+    lowerParser.reset();
+    upperLowerParser.reset();
+    mainLink.reset(0x80);
+    upperMainLink.reset(0x10);
+    upperLowerLink.reset(0xC0);
+    lowerLink.reset(0x20);
+    mainLink.assumePeerV2();
+    upperMainLink.assumePeerV2();
+    upperLowerLink.assumePeerV2();
+    lowerLink.assumePeerV2();
+    router.begin(UART_TX_BUFFER_SIZE + UART_HW_FIFO_SIZE);
+    RoutedOutput<BackloggedUart> lowerOut(router, lowerWire);
+    std::vector<uint32_t> received;
+    memset(r, 0, sizeof(*r));
+
+    auto hasRoom = [&]() { return !relay || upperLowerLink.queued() < RELIABLE_LINK_QUEUE; };
+    auto routeToLower = [&](const PacketView_t& packet, uint32_t now) {
+        if (relay) {
+            upperLowerLink.send(lowerOut.at(now), packet.cmd, packet.data, packet.length, true, now);
+            return;
+        }
+        uint8_t frame[PACKET_MAX_SIZE];
+        uint8_t length = buildPacketV2(frame, 0, 0, 0, packet.cmd, packet.data, packet.length);
+        if (!router.forward(lowerWire, frame, length, routePriority(packet.cmd), now)) r->refused++;
+    };
+    auto lowerReceive = [&](const PacketView_t& packet) {
+        if (packet.cmd < CMD_WALK_START || packet.cmd > 0x3F || packet.length < 4) return;
+        uint32_t id;
+        memcpy(&id, packet.data, sizeof(id));
+        received.push_back(id);
+    };
+
+    for (uint32_t now = 0; now < 2000; now++) {
+        simNowUs = (uint64_t)now * 1000;
+
+        // ---- メインボード: 最初に歩行方向・旋回・停止を続けて送る ----
+        if (now == 0) {
+            static const uint8_t MOTION[] = {CMD_WALK_DIRECTION, CMD_TURN, CMD_WALK_STOP, CMD_STAND};
+            for (uint32_t id = 0; id < BURST_COMMANDS; id++) {
+                uint8_t data[4];
+                memcpy(data, &id, sizeof(id));
+                mainLink.send(down, MOTION[id % 4], data, sizeof(data), true, now);
+            }
+        }
+        up.deliver(mainParser);
+        PacketView_t packet;
+        while (mainParser.next(&packet)) mainLink.receive(down, packet, now);
+        mainLink.poll(down, now);
+
+        // ---- 上半身ボード ----
+        down.deliver(upperParser);
+        router.pump(lowerWire, now);
+        while (upperParser.next(&packet)) {
+            if ((packet.ctrl & PACKET_V2_RELIABLE) && !hasRoom()) {
+                r->deferred++;
+                continue;
+            }
+            if (upperMainLink.receive(up, packet, now)) routeToLower(packet, now);
+            while (hasRoom() && upperMainLink.nextBuffered(&packet)) routeToLower(packet, now);
+        }
+        while (hasRoom() && upperMainLink.nextBuffered(&packet)) routeToLower(packet, now);
+        upperMainLink.poll(up, now);
+        lowerUp.deliver(upperLowerParser);
+        while (upperLowerParser.next(&packet)) upperLowerLink.receive(lowerOut.at(now), packet, now);
+        if (relay) upperLowerLink.poll(lowerOut.at(now), now);
+        router.pump(lowerWire, now);
+
+        // ---- 下半身ボード ----
+        lowerWire.deliver(lowerParser);
+        while (lowerParser.next(&packet)) {
+            if (lowerLink.receive(lowerUp, packet, now)) lowerReceive(packet);
+            while (lowerLink.nextBuffered(&packet)) lowerReceive(packet);
+        }
+        lowerLink.poll(lowerUp, now);
+
+        if (r->doneMs == 0 && received.size() >= BURST_COMMANDS) r->doneMs = now;
+    }
+
+    r->delivered = (uint32_t)received.size();
+    for (uint32_t i = 0; i < received.size(); i++) {
+        if (received[i] == i) r->inOrder++;
+    }
+    if (relay) r->refused = lowerOut.refused();
+    r->retransmits = upperLowerLink.stats().retransmits;
+    r->gaveUp = mainLink.stats().giveUps + upperLowerLink.stats().giveUps;
+}
+
+static bool printBurst(bool relay) {
+    BurstResult_t r;
+    runBurst(relay, &r);
+    printf("%s: %u/%u motion commands processed by lower (%u in order), router refused %u, "
+           "deferred %u, upper->lower retransmits %u, gave up %u, done at %u ms\n",
+           relay ? "relay with lowerLink " : "ACK then forward     ", r.delivered, BURST_COMMANDS, r.inOrder,
+           r.refused, r.deferred, r.retransmits, r.gaveUp, r.doneMs);
+    return r.delivered == BURST_COMMANDS && r.inOrder == BURST_COMMANDS && r.gaveUp == 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 60;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N]\n", argv[0]);
+            return 2;
+        }
+    }
+    nativeHalInit();
+
+    printf("=== コロ助 packet router benchmark ===\n");
+    printf("%u s per run, TX buffer %u + FIFO %u bytes, router backlog %u bytes, queue %u per priority (gait %u)\n",
+           seconds, UART_TX_BUFFER_SIZE, UART_HW_FIFO_SIZE, ROUTER_TX_BACKLOG, ROUTER_QUEUE_DEPTH,
+           ROUTER_TRANSFER_DEPTH);
+
+    bool ok = true;
+    static const uint32_t BAUDS[] = {UART_BAUD_RATE, 460800, UART_LOWER_BAUD_MAX};
+    for (uint32_t baud : BAUDS) {
+        printf("\n--- upper -> lower at %u baud ---\n", baud);
+        printScenario(false, baud, seconds);
+        if (!printScenario(true, baud, seconds)) ok = false;
+    }
+
+    printf("\n--- %u reliable motion commands while %u bytes wait for the lower UART at %u baud, "
+           "frame %u to lower corrupted ---\n",
+           BURST_COMMANDS, BURST_BACKLOG_BYTES, UART_BAUD_RATE, BURST_CORRUPT_FRAME);
+    printBurst(false);
+    if (!printBurst(true)) ok = false;
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: router dropped motion commands or gait chunks");
+    return ok ? 0 : 1;
+}
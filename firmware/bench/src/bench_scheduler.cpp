@@ -0,0 +1,281 @@
+/**
+ * コロ助ロボット - 周期ジョブのスケジューラー ベンチマーク
+ * Corosuke Robot - Deadline-Aware Cooperative Scheduler Benchmark
+ *
+ * scheduler.h を、今までの loop()（millis() を見て「lastX = now」で回す）と比べる。
+ *
+ * - 負荷（UART 処理のばらつき、ときどき重い報告）がある中で 50Hz のサーボ更新と 100Hz の IMU が
+ *   1 分にきっちり 3000 回・6000 回になるか（従来は遅れた分だけ次の予定も遅れていく）
+ * - サーボ更新の間隔のばらつきと、loop() が起きていた割合（従来は空回りで 100%）
+ * - 75ms 止まったときに飛ばした回と締め切り超過を数え、同じ格子（位相）に戻るか
+ * - 同時に予定時刻が来たら優先度の高いジョブから回るか
+ * - 予定時刻がないときの runDue() 1回の時間（ホストの CPU）
+ *
+ * 処理の時間は仮想時計をチャージして作る。micros() が 32bit で一周する時刻をまたいで回す。
+ *
+ *   pio run -e scheduler -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <Arduino.h>
+#include <stdio.h>
+
+#include "../../common/config.h"
+#include "../../common/scheduler.h"
+
+static const uint32_t RUN_MS = 60000;
+static const uint32_t SPIN_US = 5;              // 従来の loop() が何もせず一周する時間
+static const uint32_t SERVO_EXEC_US = 400;      // I2C へのフレーム書き込み込み
+static const uint32_t IMU_EXEC_US = 150;
+static const uint32_t REPORT_MS = 5000;
+static const uint32_t REPORT_EXEC_US = 15000;   // 115200bps の Serial 出力
+static const uint32_t TIMING_PASSES = 2000000;
+
+// =============================================================================
+// 負荷
+// =============================================================================
+static uint32_t rngState = 0x5EED1234;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint64_t workUs = 0;
+
+static void work(uint32_t us) {
+    if (us) nativeHalCharge(NATIVE_CHARGE_OTHER, us);
+    workUs += us;
+}
+
+// UART 処理: ふだんは 0〜300us、1割はまとめて届いたフレームで 2ms
+static void uartWork() {
+    uint32_t r = nextRandom();
+    work(r % 10 == 0 ? 2000 : r % 300);
+}
+
+// サーボ更新の開始時刻の記録
+typedef struct {
+    uint32_t runs;
+    uint32_t lastUs;
+    uint32_t minIntervalUs;
+    uint32_t maxIntervalUs;
+} Ticks_t;
+
+static void tick(Ticks_t& t) {
+    uint32_t now = micros();
+    if (t.runs > 0) {
+        uint32_t interval = now - t.lastUs;
+        if (interval < t.minIntervalUs) t.minIntervalUs = interval;
+        if (interval > t.maxIntervalUs) t.maxIntervalUs = interval;
+    }
+    t.lastUs = now;
+    t.runs++;
+}
+
+static Ticks_t servoTicks, imuTicks;
+
+static void resetTicks() {
+    servoTicks = {0, 0, UINT32_MAX, 0};
+    imuTicks = {0, 0, UINT32_MAX, 0};
+}
+
+static void jobServo() { tick(servoTicks); work(SERVO_EXEC_US); }
+static void jobImu() { tick(imuTicks); work(IMU_EXEC_US); }
+static void jobUart() { uartWork(); }
+static void jobReport() { work(REPORT_EXEC_US); }
+
+typedef struct {
+    const char* name;
+    uint32_t passes;
+    uint64_t awakeUs;
+} RunResult_t;
+
+static void printRun(const RunResult_t& r) {
+    printf("  %-10s servo %u runs (%.3f Hz), interval %.2f..%.2f ms | imu %u runs (%.3f Hz) | "
+           "loop %u passes, awake %.1f%%\n",
+           r.name, servoTicks.runs, servoTicks.runs * 1000.0 / RUN_MS,
+           servoTicks.minIntervalUs / 1000.0, servoTicks.maxIntervalUs / 1000.0,
+           imuTicks.runs, imuTicks.runs * 1000.0 / RUN_MS, r.passes, r.awakeUs * 100.0 / (RUN_MS * 1000.0));
+}
+
+// =============================================================================
+// 従来の loop()
+// =============================================================================
+static RunResult_t runPolling() {
+    resetTicks();
+    rngState = 0x5EED1234;
+    const uint64_t startUs = nativeHalNowUs();
+    const uint64_t endUs = startUs + RUN_MS * 1000ULL;
+    unsigned long lastServo = millis(), lastImu = millis(), lastUart = millis(), lastReport = millis();
+    RunResult_t r = {"millis()", 0, 0};
+
+    while (nativeHalNowUs() < endUs) {
+        unsigned long now = millis();
+        if (now - lastUart >= UART_POLL_MS) { lastUart = now; jobUart(); }
+        if (now - lastServo >= SERVO_UPDATE_INTERVAL_MS) { lastServo = now; jobServo(); }
+        if (now - lastImu >= IMU_UPDATE_INTERVAL_MS) { lastImu = now; jobImu(); }
+        if (now - lastReport >= REPORT_MS) { lastReport = now; jobReport(); }
+        work(SPIN_US);
+        r.passes++;
+    }
+    r.awakeUs = nativeHalNowUs() - startUs;
+    return r;
+}
+
+// =============================================================================
+// スケジューラー
+// =============================================================================
+static Scheduler scheduler;
+
+static RunResult_t runScheduler() {
+    resetTicks();
+    rngState = 0x5EED1234;
+    workUs = 0;
+    scheduler.begin();
+    scheduler.add("servo", jobServo, SERVO_UPDATE_INTERVAL_MS * 1000UL, 3, SERVO_TICK_DEADLINE_MS * 1000UL);
+    scheduler.add("imu", jobImu, IMU_UPDATE_INTERVAL_MS * 1000UL, 2);
+    scheduler.add("uart", jobUart, UART_POLL_MS * 1000UL, 1, UART_POLL_DEADLINE_MS * 1000UL);
+    scheduler.add("report", jobReport, REPORT_MS * 1000UL, 0, 0, REPORT_MS * 1000UL);
+
+    const uint64_t startUs = nativeHalNowUs();
+    const uint64_t endUs = startUs + RUN_MS * 1000ULL;
+    RunResult_t r = {"scheduler", 0, 0};
+    while (nativeHalNowUs() < endUs) {
+        scheduler.runDue();
+        scheduler.sleepUntilDue();
+        r.passes++;
+    }
+    r.awakeUs = nativeHalNowUs() - startUs - scheduler.stats().sleptUs;
+    return r;
+}
+
+static bool checkRates() {
+    printf("%u s under load (uart 0-300 us, 10%% 2 ms; %u ms report every %u s), micros() wraps mid-run\n",
+           RUN_MS / 1000, REPORT_EXEC_US / 1000, REPORT_MS / 1000);
+    RunResult_t polling = runPolling();
+    printRun(polling);
+    uint32_t pollingServo = servoTicks.runs;
+
+    RunResult_t scheduled = runScheduler();
+    printRun(scheduled);
+    for (uint8_t i = 0; i < scheduler.jobs(); i++) {
+        const SchedulerJobStats_t& job = scheduler.job(i);
+        printf("    job %-7s runs %6u, exec max %5u us, late max %5u us, overruns %u, skipped %u\n",
+               job.name, job.runs, job.maxExecUs, job.maxLateUs, job.overruns, job.skipped);
+    }
+
+    const uint32_t servoExpected = RUN_MS / SERVO_UPDATE_INTERVAL_MS;
+    const uint32_t imuExpected = RUN_MS / IMU_UPDATE_INTERVAL_MS;
+    bool ok = servoTicks.runs >= servoExpected && servoTicks.runs <= servoExpected + 1 &&
+              imuTicks.runs >= imuExpected && imuTicks.runs <= imuExpected + 1;
+    ok &= scheduler.job(0).skipped == 0 && scheduler.job(1).skipped == 0;
+    // 起きているのはジョブの処理の間だけ（空回りしない）
+    ok &= scheduled.awakeUs <= workUs + workUs / 100 && scheduled.passes * 100 < polling.passes;
+    printf("  polling lost %d servo ticks in %u s; scheduler awake %.1f%% for %.1f%% of work\n",
+           (int)servoExpected - (int)pollingServo, RUN_MS / 1000,
+           scheduled.awakeUs * 100.0 / (RUN_MS * 1000.0), workUs * 100.0 / (RUN_MS * 1000.0));
+    printf("rates: %s\n\n", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+// =============================================================================
+// 75ms 止まったとき
+// =============================================================================
+static uint32_t stallUs = 0;
+
+static void jobStall() {
+    work(stallUs);
+    stallUs = 0;
+}
+
+static bool checkStall() {
+    resetTicks();
+    scheduler.begin();
+    scheduler.add("servo", jobServo, SERVO_UPDATE_INTERVAL_MS * 1000UL, 3, SERVO_TICK_DEADLINE_MS * 1000UL);
+    scheduler.add("stall", jobStall, 1000UL, 0);
+    const uint32_t addUs = micros();
+
+    const uint64_t endUs = nativeHalNowUs() + 1000000;
+    uint32_t offGrid = 0;
+    while (nativeHalNowUs() < endUs) {
+        if (servoTicks.runs == 10 && stallUs == 0 && scheduler.job(0).skipped == 0) stallUs = 75000;
+        uint32_t before = servoTicks.runs;
+        scheduler.runDue();
+        // 始まりは格子の上から最大 1 tick（sleepUntilDue の切り上げ）遅れるだけ。止まった直後の1回を除く
+        if (servoTicks.runs != before) {
+            uint32_t offset = (servoTicks.lastUs - addUs) % (SERVO_UPDATE_INTERVAL_MS * 1000UL);
+            if (offset > portTICK_PERIOD_MS * 1000) offGrid++;
+        }
+        scheduler.sleepUntilDue();
+    }
+    const SchedulerJobStats_t& servo = scheduler.job(0);
+    printf("75 ms stall in a low-priority job: servo runs %u, skipped %u, overruns %u, late max %u us\n",
+           servo.runs, servo.skipped, servo.overruns, servo.maxLateUs);
+    // サーボ更新の直後から 1〜76ms: +20・+40 は飛ばし、+60 は 16ms ほど遅れて回り締め切り (+70) を超える
+    bool ok = servo.skipped == 2 && servo.overruns == 1 && servo.runs + servo.skipped >= 50 &&
+              servo.runs + servo.skipped <= 51 && offGrid == 1;
+    printf("stall: %s (starts off the %u ms grid: %u)\n\n", ok ? "ok" : "WRONG",
+           SERVO_UPDATE_INTERVAL_MS, offGrid);
+    return ok;
+}
+
+// =============================================================================
+// 優先度
+// =============================================================================
+static char order[8];
+static uint8_t orderCount = 0;
+
+static void jobA() { if (orderCount < sizeof(order) - 1) order[orderCount++] = 'a'; }
+static void jobB() { if (orderCount < sizeof(order) - 1) order[orderCount++] = 'b'; }
+static void jobC() { if (orderCount < sizeof(order) - 1) order[orderCount++] = 'c'; }
+
+static bool checkPriority() {
+    scheduler.begin();
+    scheduler.add("a", jobA, 1000, 0);
+    scheduler.add("b", jobB, 1000, 2);
+    scheduler.add("c", jobC, 1000, 1);
+    orderCount = 0;
+    scheduler.runDue();
+    order[orderCount] = 0;
+    bool ok = strcmp(order, "bca") == 0;
+    printf("three jobs due together (priority a=0 b=2 c=1): ran %s\n", order);
+    printf("priority: %s\n\n", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+// =============================================================================
+// runDue() 1回の時間
+// =============================================================================
+static void jobNothing() {}
+
+static void measureCost() {
+    scheduler.begin();
+    for (uint8_t i = 0; i < 8; i++) {
+        scheduler.add("idle", jobNothing, 1000000UL, i, 0, 1000000UL);
+    }
+    uint64_t start = benchNowNs();
+    for (uint32_t i = 0; i < TIMING_PASSES; i++) scheduler.runDue();
+    uint64_t ns = benchNowNs() - start;
+    printf("runDue() with 8 jobs, none due (host CPU): %.1f ns\n", (double)ns / TIMING_PASSES);
+}
+
+int main() {
+    printf("=== コロ助 scheduler benchmark ===\n");
+    printf("servo %d ms, imu %d ms, uart poll %d ms, tick %u ms\n\n", SERVO_UPDATE_INTERVAL_MS,
+           IMU_UPDATE_INTERVAL_MS, UART_POLL_MS, (unsigned)portTICK_PERIOD_MS);
+
+    // micros() が 32bit で一周する時刻の 30 秒前から
+    nativeHalAdvanceUs(0x100000000ULL - 30000000ULL);
+
+    bool ok = checkRates();
+    ok &= checkStall();
+    ok &= checkPriority();
+    measureCost();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: a periodic job drifted, did not skip back onto its grid or ran out of order");
+    return ok ? 0 : 1;
+}
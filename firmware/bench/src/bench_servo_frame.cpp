@@ -0,0 +1,245 @@
+/**
+ * コロ助ロボット - サーボフレーム ベンチマーク
+ * Corosuke Robot - Servo Frame Benchmark
+ *
+ * 50Hz の振り付け（目・口・首・腕が同時に動く）を送るときの UART バイト数と
+ * 受信側のコマンド処理時間を、機能別コマンド / キーフレームのみ / 差分付き で比較する。
+ * 取りこぼし（疑似乱数で 5%、キーフレームも落ちる）を入れた場合に、受信側の姿勢が送信側と
+ * 食い違ったままの tick 数を、キーフレームを送りっぱなしにした場合と確実に送った場合
+ * （ReliableLink: RTO ごとに再送、順番どおりに渡す）で比べる。
+ *
+ *   pio run -e servo_frame -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+
+#include "../../common/config.h"
+#include "../../common/protocol.h"
+#include "../../common/reliable_link.h"
+#include "../../common/servo_frame.h"
+
+static const uint32_t TICKS = 50 * 60;                  // 60 秒分
+static const double LINK_BYTES_PER_SEC = UART_BAUD_RATE / 10.0;
+static const uint8_t FRAME_OVERHEAD = 5;                // START + LEN + CMD + CHECKSUM + END
+static const uint32_t LOSS_PERCENT = 5;
+// 確実に送るキーフレームの再送が届くまで（RTO を tick に切り上げ）
+static const uint32_t RETRANSMIT_TICKS = (RELIABLE_LINK_RTO_MS + SERVO_UPDATE_INTERVAL_MS - 1) / SERVO_UPDATE_INTERVAL_MS;
+// 取りこぼしから戻るまでの上限: キーフレームの再送が1回落ちても 2 回目で届く
+static const uint32_t RECOVERY_TICKS_MAX = 2 * RETRANSMIT_TICKS + 1;
+
+// =============================================================================
+// 乱数（取りこぼし）
+// =============================================================================
+static uint32_t rngState = 0x12345678;
+
+static bool nextDropped() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % 100 < LOSS_PERCENT;
+}
+
+// 振り付け: 目は 1.5Hz、口は発話、首と腕はゆっくり、まぶたはたまにまばたき
+static void choreography(uint32_t tick, uint8_t angles[SERVO_FRAME_CHANNELS]) {
+    double t = tick * SERVO_UPDATE_INTERVAL_MS / 1000.0;
+    memset(angles, SERVO_FRAME_HOLD, SERVO_FRAME_CHANNELS);
+
+    uint8_t eyeH = (uint8_t)lround(90 + 25 * sin(2 * M_PI * 1.5 * t));
+    uint8_t eyeV = (uint8_t)lround(90 + 10 * sin(2 * M_PI * 0.7 * t));
+    angles[SERVO_EYE_RIGHT_H] = eyeH;
+    angles[SERVO_EYE_LEFT_H] = eyeH;
+    angles[SERVO_EYE_RIGHT_V] = eyeV;
+    angles[SERVO_EYE_LEFT_V] = eyeV;
+
+    bool blink = (tick % 200) < 6;
+    angles[SERVO_EYELID_RIGHT] = blink ? EYELID_CLOSE : EYELID_OPEN;
+    angles[SERVO_EYELID_LEFT] = blink ? EYELID_CLOSE : EYELID_OPEN;
+
+    uint8_t mouth = (uint8_t)lround(MOUTH_CLOSED + 15 * (1 + sin(2 * M_PI * 4 * t)));
+    angles[SERVO_MOUTH_LOWER] = mouth;
+    angles[SERVO_MOUTH_UPPER] = (uint8_t)(MOUTH_CLOSED - (mouth - MOUTH_CLOSED) / 3);
+
+    angles[SERVO_NECK_YAW] = (uint8_t)lround(90 + 30 * sin(2 * M_PI * 0.2 * t));
+    angles[SERVO_NECK_PITCH] = (uint8_t)lround(90 + 8 * sin(2 * M_PI * 0.3 * t));
+
+    // 腕は 2 秒動いて 2 秒止まる
+    double arm = fmod(t, 4.0) < 2.0 ? sin(2 * M_PI * 0.5 * t) : 0.0;
+    angles[SERVO_ARM_RIGHT_SHOULDER] = (uint8_t)lround(90 + 40 * arm);
+    angles[SERVO_ARM_RIGHT_ELBOW] = (uint8_t)lround(90 + 20 * arm);
+    angles[SERVO_ARM_LEFT_SHOULDER] = (uint8_t)lround(90 - 40 * arm);
+    angles[SERVO_ARM_LEFT_ELBOW] = (uint8_t)lround(90 - 20 * arm);
+}
+
+// 機能別コマンドで同じ振り付けを送った場合（腕は表現できないので除外）
+static uint32_t featureCommandBytes(const uint8_t* prev, const uint8_t* angles, uint32_t* commands) {
+    uint32_t bytes = 0;
+    if (!prev || angles[SERVO_EYE_RIGHT_H] != prev[SERVO_EYE_RIGHT_H] ||
+        angles[SERVO_EYE_RIGHT_V] != prev[SERVO_EYE_RIGHT_V]) {
+        bytes += FRAME_OVERHEAD + sizeof(EyePositionData_t);
+        (*commands)++;
+    }
+    if (!prev || angles[SERVO_EYELID_RIGHT] != prev[SERVO_EYELID_RIGHT]) {
+        bytes += FRAME_OVERHEAD + 1;    // CMD_BLINK
+        (*commands)++;
+    }
+    if (!prev || angles[SERVO_MOUTH_LOWER] != prev[SERVO_MOUTH_LOWER]) {
+        bytes += FRAME_OVERHEAD + sizeof(MouthData_t);
+        (*commands)++;
+    }
+    if (!prev || angles[SERVO_NECK_YAW] != prev[SERVO_NECK_YAW] ||
+        angles[SERVO_NECK_PITCH] != prev[SERVO_NECK_PITCH]) {
+        bytes += FRAME_OVERHEAD + 2;    // CMD_LOOK_AT
+        (*commands)++;
+    }
+    return bytes;
+}
+
+typedef struct {
+    uint32_t bytes;
+    uint32_t keyframes;
+    uint32_t deltas;
+    uint32_t dropped;       // 取りこぼしたフレーム（再送を含む）
+    uint32_t mismatches;    // 受信側の姿勢が送信側と食い違った tick
+    uint32_t longestRun;    // 食い違いが続いた最長の tick 数
+    uint32_t rejected;      // 基準キーフレーム不一致で捨てた差分
+    BenchStats receiveNs;
+} RunResult_t;
+
+typedef struct {
+    uint32_t dueTick;       // 受信側に届く tick（取りこぼすたびに再送の分だけ遅れる）
+    uint8_t cmd;
+    uint8_t length;
+    uint8_t data[sizeof(ServoFrameData_t)];
+} Pending_t;
+
+static void deliver(ServoFrameReceiver& receiver, uint8_t cmd, const uint8_t* data, uint8_t length,
+                    RunResult_t* result) {
+    uint64_t t0 = benchNowNs();
+    receiver.receive(cmd, data, length);
+    result->receiveNs.add(benchNowNs() - t0);
+}
+
+// lossy: 疑似乱数で取りこぼす。reliableKeyframes: キーフレームは再送して順番どおりに渡す
+static void run(bool keyframesOnly, bool lossy, bool reliableKeyframes, RunResult_t* result) {
+    ServoFrameEncoder encoder(BODY_UPPER);
+    ServoFrameReceiver receiver(BODY_UPPER);
+    std::deque<Pending_t> reliable;
+    uint8_t applied[SERVO_FRAME_CHANNELS];
+    memset(applied, SERVO_FRAME_HOLD, sizeof(applied));
+    rngState = 0x12345678;
+
+    result->bytes = result->keyframes = result->deltas = result->dropped = 0;
+    result->mismatches = result->longestRun = result->rejected = 0;
+    result->receiveNs.clear();
+    result->receiveNs.reserve(TICKS);
+
+    uint32_t run = 0;
+    for (uint32_t tick = 0; tick < TICKS; tick++) {
+        uint8_t angles[SERVO_FRAME_CHANNELS];
+        choreography(tick, angles);
+
+        if (keyframesOnly) encoder.reset();
+        Pending_t frame;
+        frame.length = encoder.encode(angles, 0, &frame.cmd, frame.data);
+        result->bytes += FRAME_OVERHEAD + frame.length;
+        if (frame.cmd == CMD_SERVO_FRAME) result->keyframes++;
+        else result->deltas++;
+
+        if (reliableKeyframes && frame.cmd == CMD_SERVO_FRAME) {
+            // 落ちるたびに RTO 後の再送（再送も同じ確率で落ちる）
+            frame.dueTick = tick;
+            while (lossy && nextDropped()) {
+                result->dropped++;
+                frame.dueTick += RETRANSMIT_TICKS;
+            }
+            reliable.push_back(frame);
+        }
+        // 確実に送るものは順番どおり（前のものが再送待ちなら後ろも待つ）
+        while (!reliable.empty() && reliable.front().dueTick <= tick) {
+            const Pending_t& next = reliable.front();
+            deliver(receiver, next.cmd, next.data, next.length, result);
+            reliable.pop_front();
+        }
+        if (!(reliableKeyframes && frame.cmd == CMD_SERVO_FRAME)) {
+            if (lossy && nextDropped()) result->dropped++;
+            else deliver(receiver, frame.cmd, frame.data, frame.length, result);
+        }
+
+        ServoPose_t pose;
+        if (receiver.take(&pose)) {
+            for (uint8_t ch = 0; ch < SERVO_FRAME_CHANNELS; ch++) {
+                applied[ch] = (pose.mask & (1u << ch)) ? pose.angles[ch] : SERVO_FRAME_HOLD;
+            }
+        }
+        if (memcmp(applied, angles, sizeof(applied)) != 0) {
+            result->mismatches++;
+            if (++run > result->longestRun) result->longestRun = run;
+        } else {
+            run = 0;
+        }
+    }
+    result->rejected = receiver.stats().rejected;
+}
+
+static void printRun(const char* label, RunResult_t& result) {
+    double seconds = TICKS * SERVO_UPDATE_INTERVAL_MS / 1000.0;
+    double bytesPerSec = result.bytes / seconds;
+    printf("  %-22s %7.0f byte/s (%5.1f%% of %d baud)  key %4u  delta %4u\n",
+           label, bytesPerSec, 100.0 * bytesPerSec / LINK_BYTES_PER_SEC, UART_BAUD_RATE,
+           result.keyframes, result.deltas);
+}
+
+static void printLoss(const char* label, RunResult_t& result) {
+    printf("  %-22s dropped %3u  rejected deltas %3u  mismatch %3u ticks  longest %2u ticks (%u ms)\n",
+           label, result.dropped, result.rejected, result.mismatches, result.longestRun,
+           result.longestRun * SERVO_UPDATE_INTERVAL_MS);
+}
+
+int main() {
+    printf("=== コロ助 servo frame benchmark ===\n");
+    printf("choreography: %u ticks @ %d ms, 14 channels\n", TICKS, SERVO_UPDATE_INTERVAL_MS);
+
+    uint32_t featureBytes = 0;
+    uint32_t featureCommands = 0;
+    uint8_t prev[SERVO_FRAME_CHANNELS];
+    for (uint32_t tick = 0; tick < TICKS; tick++) {
+        uint8_t angles[SERVO_FRAME_CHANNELS];
+        choreography(tick, angles);
+        featureBytes += featureCommandBytes(tick ? prev : nullptr, angles, &featureCommands);
+        memcpy(prev, angles, sizeof(prev));
+    }
+    double seconds = TICKS * SERVO_UPDATE_INTERVAL_MS / 1000.0;
+    printf("UART load\n");
+    printf("  %-22s %7.0f byte/s (%5.1f%% of %d baud)  ~%.1f commands/tick (no arms)\n",
+           "feature commands", featureBytes / seconds,
+           100.0 * featureBytes / seconds / LINK_BYTES_PER_SEC, UART_BAUD_RATE,
+           (double)featureCommands / TICKS);
+
+    static RunResult_t keyOnly, delta, lossyOneShot, lossyReliable;
+    run(true, false, false, &keyOnly);
+    run(false, false, false, &delta);
+    run(false, true, false, &lossyOneShot);
+    run(false, true, true, &lossyReliable);
+    printRun("keyframe only", keyOnly);
+    printRun("keyframe + delta", delta);
+
+    printf("%u%% packet loss (keyframes dropped too)\n", LOSS_PERCENT);
+    printLoss("keyframes one-shot", lossyOneShot);
+    printLoss("keyframes reliable", lossyReliable);
+
+    printf("receiver (receive + take per frame, host CPU)\n");
+    keyOnly.receiveNs.printNs("keyframe only");
+    delta.receiveNs.printNs("keyframe + delta");
+
+    // 取りこぼしがなければ一致し続け、あっても確実に送るキーフレームで RECOVERY_TICKS_MAX 以内に戻る
+    bool ok = delta.mismatches == 0 && keyOnly.mismatches == 0 &&
+              lossyReliable.longestRun <= RECOVERY_TICKS_MAX;
+    printf("\n%s (recovery bound %u ticks)\n", ok ? "OK" : "FAILED: pose stayed wrong too long after a loss",
+           RECOVERY_TICKS_MAX);
+    return ok ? 0 : 1;
+}
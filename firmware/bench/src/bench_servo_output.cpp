@@ -0,0 +1,177 @@
+/**
+ * コロ助ロボット - サーボ出力ステージ ベンチマーク
+ * Corosuke Robot - Servo Output Stage Benchmark
+ *
+ * 1チャンネルずつの setPWM() と ServoOutput（差分 + オートインクリメント）で、
+ * 20ms の servo tick あたりの I2C バス時間をバスクロックごとに比べる。
+ * 毎 tick、PCA9685 モデルのレジスタが目標値と一致しているかも確認し、
+ * バスエラーを注入して復旧できることを確かめる。
+ *
+ *   pio run -e servo_output -t exec
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_PWMServoDriver.h>
+#include <native_devices.h>
+#include <native_hal.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../../common/config.h"
+#include "../../common/servo_output.h"
+
+static const uint32_t TICKS = 500;
+static const uint32_t CLOCKS[] = {100000, 400000, 1000000};
+
+typedef void (*Scenario)(uint32_t tick, uint16_t values[16], uint16_t* mask);
+
+static uint16_t angleToTicks(double angle) {
+    uint16_t pulse = map((int)angle, 0, 180, SERVO_MIN_PULSE, SERVO_MAX_PULSE);
+    return (uint16_t)((pulse * 4096L) / 20000L);
+}
+
+// 下半身の歩行: 腰 + 両脚 8軸 (ch0-8) が毎 tick 動く
+static void gaitScenario(uint32_t tick, uint16_t values[16], uint16_t* mask) {
+    double phase = 2 * M_PI * tick / 50.0;
+    *mask = 0x01FF;
+    for (int ch = 0; ch < 9; ch++) {
+        values[ch] = angleToTicks(90 + 20 * sin(phase + ch * 0.7));
+    }
+}
+
+// 上半身の表情切り替え: 目・まぶた・口 (ch0-7) が 1秒ごとに一斉に変わる
+static void expressionScenario(uint32_t tick, uint16_t values[16], uint16_t* mask) {
+    *mask = 0x00FF;
+    int expr = (tick / 50) % 4;
+    for (int ch = 0; ch < 8; ch++) {
+        values[ch] = angleToTicks(70 + expr * 10 + ch);
+    }
+}
+
+// 視線だけ動かす: 両目の水平・垂直 (ch0-3) とまぶた (ch4-5) は固定、首 (ch8) も
+static void gazeScenario(uint32_t tick, uint16_t values[16], uint16_t* mask) {
+    *mask = 0x013F;
+    double t = tick / 50.0;
+    values[0] = values[2] = angleToTicks(90 + 25 * sin(2 * M_PI * 0.5 * t));
+    values[1] = values[3] = angleToTicks(90 + 10 * sin(2 * M_PI * 0.3 * t));
+    values[4] = values[5] = angleToTicks(EYELID_OPEN);
+    values[8] = angleToTicks(90 + 30 * sin(2 * M_PI * 0.1 * t));
+}
+
+typedef struct {
+    double busUsPerTick;
+    double transactionsPerTick;
+    uint32_t mismatches;
+} Result_t;
+
+static NativePca9685* pcaModel() {
+    return static_cast<NativePca9685*>(nativeHalI2CDevice(I2C_ADDR_PCA9685_LOWER));
+}
+
+static uint32_t checkRegisters(const uint16_t values[16], uint16_t mask) {
+    uint32_t mismatches = 0;
+    for (int ch = 0; ch < 16; ch++) {
+        if ((mask & (1u << ch)) && pcaModel()->channelOff(ch) != values[ch]) mismatches++;
+    }
+    return mismatches;
+}
+
+// 従来: 変化の有無に関係なく対象チャンネルを1つずつ setPWM()
+static Result_t runLegacy(Scenario scenario, uint32_t clockHz) {
+    Adafruit_PWMServoDriver pwm(I2C_ADDR_PCA9685_LOWER);
+    pwm.begin();
+    pwm.setPWMFreq(50);
+    Wire.setClock(clockHz);
+
+    Result_t result = {0, 0, 0};
+    nativeHalTakeChargedUs();
+    uint32_t txStart = nativeHalStats().i2cTransactions;
+    for (uint32_t tick = 0; tick < TICKS; tick++) {
+        uint16_t values[16];
+        uint16_t mask;
+        scenario(tick, values, &mask);
+        for (int ch = 0; ch < 16; ch++) {
+            if (mask & (1u << ch)) pwm.setPWM(ch, 0, values[ch]);
+        }
+        result.mismatches += checkRegisters(values, mask);
+    }
+    result.busUsPerTick = (double)nativeHalTakeChargedUs() / TICKS;
+    result.transactionsPerTick = (double)(nativeHalStats().i2cTransactions - txStart) / TICKS;
+    return result;
+}
+
+static Result_t runBatched(Scenario scenario, uint32_t clockHz, ServoOutputStats_t* stats,
+                           uint32_t injectAtTick = 0, uint32_t injectErrors = 0) {
+    Adafruit_PWMServoDriver pwm(I2C_ADDR_PCA9685_LOWER);
+    pwm.begin();
+    pwm.setPWMFreq(50);
+    ServoOutput out(I2C_ADDR_PCA9685_LOWER);
+    out.begin(I2C_SDA_PIN, I2C_SCL_PIN, clockHz);
+
+    Result_t result = {0, 0, 0};
+    nativeHalTakeChargedUs();
+    uint32_t txStart = nativeHalStats().i2cTransactions;
+    for (uint32_t tick = 0; tick < TICKS; tick++) {
+        uint16_t values[16];
+        uint16_t mask;
+        scenario(tick, values, &mask);
+        for (int ch = 0; ch < 16; ch++) {
+            if (mask & (1u << ch)) out.set(ch, values[ch]);
+        }
+        if (injectErrors && tick == injectAtTick) nativeHalInjectI2CErrors(injectErrors);
+        out.flush();
+        // エラー注入中の tick は書けていなくてよい
+        if (!(injectErrors && tick >= injectAtTick && tick < injectAtTick + injectErrors)) {
+            result.mismatches += checkRegisters(values, mask);
+        }
+    }
+    result.busUsPerTick = (double)nativeHalTakeChargedUs() / TICKS;
+    result.transactionsPerTick = (double)(nativeHalStats().i2cTransactions - txStart) / TICKS;
+    *stats = out.stats();
+    return result;
+}
+
+int main() {
+    nativeHalInit();
+    Wire.begin();
+
+    printf("=== コロ助 servo output benchmark ===\n");
+    printf("I2C bus time per %d ms servo tick (modeled, incl. driver overhead)\n",
+           SERVO_UPDATE_INTERVAL_MS);
+
+    struct {
+        const char* name;
+        Scenario fn;
+    } scenarios[] = {
+        {"gait (9ch every tick)", gaitScenario},
+        {"expression (8ch @1Hz)", expressionScenario},
+        {"gaze (eyes + neck)", gazeScenario},
+    };
+
+    for (auto& scenario : scenarios) {
+        printf("%s\n", scenario.name);
+        for (uint32_t clockHz : CLOCKS) {
+            ServoOutputStats_t stats;
+            Result_t legacy = runLegacy(scenario.fn, clockHz);
+            Result_t batched = runBatched(scenario.fn, clockHz, &stats);
+            printf("  %4u kHz  setPWM %7.1f us (%4.1f txn)  batched %7.1f us (%4.2f txn)  "
+                   "%5.1f%% of tick -> %5.1f%%  mismatch %u/%u\n",
+                   clockHz / 1000,
+                   legacy.busUsPerTick, legacy.transactionsPerTick,
+                   batched.busUsPerTick, batched.transactionsPerTick,
+                   100.0 * legacy.busUsPerTick / (SERVO_UPDATE_INTERVAL_MS * 1000),
+                   100.0 * batched.busUsPerTick / (SERVO_UPDATE_INTERVAL_MS * 1000),
+                   legacy.mismatches, batched.mismatches);
+        }
+    }
+
+    printf("bus error recovery (gait, 400 kHz, %u errors injected at tick 100)\n",
+           SERVO_OUTPUT_RECOVER_AFTER + 1);
+    ServoOutputStats_t stats;
+    Result_t recovered = runBatched(gaitScenario, 400000, &stats, 100, SERVO_OUTPUT_RECOVER_AFTER + 1);
+    printf("  errors %u, recoveries %u, register mismatches after recovery %u\n",
+           stats.errors, stats.recoveries, recovered.mismatches);
+    return recovered.mismatches == 0 ? 0 : 1;
+}
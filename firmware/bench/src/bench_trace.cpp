@@ -0,0 +1,220 @@
+/**
+ * コロ助ロボット - 処理時間の計測（トレース）ベンチマーク
+ * Corosuke Robot - Trace Ring and Latency Histogram Benchmark
+ *
+ * trace.h を次の点で調べる。
+ *
+ * - ヒストグラムの番号の境目と、STATUS_TRACE の差分（回数・超過・最大・16bit に収める scale）
+ * - 長く動かしたあと: 合計が 32bit を超えても平均が合うか、サイクルカウンタが一周しても
+ *   イベントが何 ms 前かが合うか
+ * - 複数のスレッドが同時に record() し、別のスレッドが recent() で読み続けても、
+ *   読めたイベントが壊れていないか（処理ごとの回数とヒストグラムも合うか）
+ * - 1回の記録にかかる時間（TraceScope、ホストの CPU）
+ *
+ * 仮想時計は止めておき、startCycles をずらして好きな長さのイベントを作る。
+ *
+ *   pio run -e trace -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../../common/trace.h"
+
+static const uint32_t WRITERS = 4;
+static const uint32_t EVENTS_PER_WRITER = 400000;
+static const uint32_t TIMING_RECORDS = 2000000;
+
+// =============================================================================
+// ヒストグラムと差分
+// =============================================================================
+static Tracer tracer;
+
+static void recordUs(Tracer& t, TraceStage_t stage, uint32_t us) {
+    t.record(stage, Tracer::cycles() - us * t.cyclesPerUs());
+}
+
+static bool checkBuckets() {
+    static const struct { uint32_t us; uint8_t bucket; } CASES[] = {
+        {0, 0}, {15, 0}, {16, 1}, {31, 1}, {32, 2}, {1000, 6}, {1024, 7}, {19999, 11},
+        {20000, 11}, {32768, 12}, {262143, 14}, {262144, 15}, {100000000, 15},
+    };
+    bool ok = true;
+    for (const auto& c : CASES) {
+        uint8_t bucket = traceBucket(c.us);
+        if (bucket != c.bucket) {
+            printf("  traceBucket(%u) = %u, expected %u\n", c.us, bucket, c.bucket);
+            ok = false;
+        }
+        if (c.bucket < TRACE_BUCKETS - 1 && c.us >= traceBucketLimitUs(c.bucket)) ok = false;
+    }
+    printf("bucket edges: %s\n", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+static bool checkStatus() {
+    tracer.begin(TRACE_BOARD_LOWER);
+    bool ok = true;
+
+    // 1回目: 1000 回のうち 3 回が 20ms 超え
+    for (uint32_t i = 0; i < 1000; i++) recordUs(tracer, TRACE_CONTROL, i < 3 ? 25000 : 700);
+    TraceStatusData_t status;
+    ok &= tracer.fillStatus(TRACE_CONTROL, &status);
+    ok &= status.kind == STATUS_RESP_TRACE && status.board == TRACE_BOARD_LOWER && status.stage == TRACE_CONTROL;
+    ok &= status.samples == 1000 && status.over_budget == 3 && status.max_us == 25000 && status.scale == 0;
+    ok &= status.total_us == 3 * 25000 + 997 * 700;
+    ok &= status.buckets[traceBucket(700)] == 997 && status.buckets[traceBucket(25000)] == 3;
+    printf("window 1: %u samples, over budget %u, max %u us, total %u us\n",
+           status.samples, status.over_budget, status.max_us, status.total_us);
+
+    // 2回目: 前回からの差分だけ、最大も前回の分を持ち越さない。16bit に収まらない回数は scale で
+    for (uint32_t i = 0; i < 200000; i++) recordUs(tracer, TRACE_CONTROL, 40);
+    ok &= tracer.fillStatus(TRACE_CONTROL, &status);
+    ok &= status.samples == 200000 && status.over_budget == 0 && status.max_us == 40;
+    ok &= status.scale == 2 && status.buckets[traceBucket(40)] == 200000 >> 2;
+    printf("window 2: %u samples, over budget %u, max %u us, scale %u (bucket %u)\n",
+           status.samples, status.over_budget, status.max_us, status.scale,
+           status.buckets[traceBucket(40)]);
+
+    // 記録のない処理は応答しない
+    ok &= !tracer.fillStatus(TRACE_CAMERA, &status);
+
+    // リング: TRACE_RING_MIN_US 以上だけ、新しい順
+    TraceEvent_t events[TRACE_RING_SIZE];
+    size_t count = tracer.recent(events, TRACE_RING_SIZE);
+    ok &= count == 3 && events[0].us == 25000;
+    printf("ring: %u events of >= %u us\n", (unsigned)count, TRACE_RING_MIN_US);
+
+    printf("status windows: %s\n\n", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+// =============================================================================
+// 長く動かしたあと
+// =============================================================================
+static bool checkLongUptime() {
+    static Tracer longRun;
+    longRun.begin(TRACE_BOARD_MAIN);
+    bool ok = true;
+
+    // 10 秒 × 500 回 = 5000 秒（32bit の us だと 4295 秒で一周する）
+    for (uint32_t i = 0; i < 500; i++) recordUs(longRun, TRACE_LOOP, 10000000);
+    const TraceCounters_t& c = longRun.counters(TRACE_LOOP);
+    ok &= c.totalUs == 5000000000ULL && c.totalUs / c.samples == 10000000;
+
+    // 30 秒後（240MHz のサイクルカウンタは 17.9 秒で一周する）
+    uint32_t recordedMs = millis();
+    nativeHalAdvanceUs(30000000);
+    TraceEvent_t event;
+    ok &= longRun.recent(&event, 1) == 1 && event.ms == recordedMs && millis() - event.ms == 30000;
+    printf("long uptime: total %llu us, average %llu us, last event %lu ms ago\n",
+           (unsigned long long)c.totalUs, (unsigned long long)(c.totalUs / c.samples),
+           (unsigned long)(millis() - event.ms));
+
+    printf("long uptime: %s\n\n", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+// =============================================================================
+// 複数スレッドからの書き込み
+// =============================================================================
+// イベントの長さに処理の番号を埋め込み、読んだイベントの処理と長さと開始時刻が合うかを見る
+static uint32_t eventUs(uint32_t writer, uint32_t i) {
+    return TRACE_RING_MIN_US + writer * 100000 + i % 50000;
+}
+
+static Tracer shared;
+
+static bool checkConcurrent() {
+    shared.begin(TRACE_BOARD_MAIN);
+    const uint32_t nowCycles = Tracer::cycles();
+
+    std::atomic<uint32_t> running{WRITERS};
+    std::vector<std::thread> writers;
+    for (uint32_t w = 0; w < WRITERS; w++) {
+        writers.emplace_back([&running, w]() {
+            for (uint32_t i = 0; i < EVENTS_PER_WRITER; i++) {
+                recordUs(shared, (TraceStage_t)(TRACE_IMU + w), eventUs(w, i));
+            }
+            running.fetch_sub(1);
+        });
+    }
+
+    uint64_t reads = 0, events = 0, torn = 0;
+    std::vector<TraceEvent_t> buffer(TRACE_RING_SIZE);
+    while (running.load() > 0) {
+        size_t count = shared.recent(buffer.data(), buffer.size());
+        reads++;
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent_t& e = buffer[i];
+            uint32_t w = (e.us - TRACE_RING_MIN_US) / 100000;
+            bool valid = e.stage == TRACE_IMU + w && w < WRITERS &&
+                         e.startCycles == nowCycles - e.us * shared.cyclesPerUs();
+            events++;
+            if (!valid) torn++;
+        }
+    }
+    for (auto& t : writers) t.join();
+
+    bool ok = torn == 0 && shared.events() == WRITERS * EVENTS_PER_WRITER;
+    for (uint32_t w = 0; w < WRITERS; w++) {
+        const TraceCounters_t& c = shared.counters((TraceStage_t)(TRACE_IMU + w));
+        uint32_t bucketed = 0;
+        for (uint8_t b = 0; b < TRACE_BUCKETS; b++) bucketed += c.buckets[b];
+        if (c.samples != EVENTS_PER_WRITER || bucketed != EVENTS_PER_WRITER) ok = false;
+    }
+    printf("%u writers x %u events, reader took %llu snapshots (%llu events), torn %llu\n",
+           WRITERS, EVENTS_PER_WRITER, (unsigned long long)reads, (unsigned long long)events,
+           (unsigned long long)torn);
+    printf("concurrent ring: %s\n\n", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+// =============================================================================
+// 1回の記録にかかる時間
+// =============================================================================
+static void measureCost() {
+    static Tracer timed;
+    timed.begin(TRACE_BOARD_UPPER);
+
+    uint64_t start = benchNowNs();
+    for (uint32_t i = 0; i < TIMING_RECORDS; i++) {
+        TraceScope trace(timed, TRACE_SERVO_TICK);
+    }
+    uint64_t shortNs = benchNowNs() - start;
+
+    start = benchNowNs();
+    for (uint32_t i = 0; i < TIMING_RECORDS; i++) {
+        recordUs(timed, TRACE_LED_SHOW, TRACE_RING_MIN_US);
+    }
+    uint64_t ringNs = benchNowNs() - start;
+
+    printf("per record (host CPU)\n");
+    printf("  short (counters only)      %6.1f ns\n", (double)shortNs / TIMING_RECORDS);
+    printf("  >= %u us (counters + ring) %6.1f ns\n", TRACE_RING_MIN_US, (double)ringNs / TIMING_RECORDS);
+}
+
+int main() {
+    printf("=== コロ助 trace benchmark ===\n");
+    printf("%d buckets from %d us, ring %d events >= %d us, budget %lu us, report %u bytes\n\n",
+           TRACE_BUCKETS, TRACE_BUCKET0_US, TRACE_RING_SIZE, TRACE_RING_MIN_US,
+           (unsigned long)TRACE_BUDGET_US, (unsigned)sizeof(TraceStatusData_t));
+    nativeHalAdvanceUs(1000000);
+
+    bool ok = sizeof(TraceStatusData_t) <= PACKET_V2_MAX_DATA;
+    ok &= checkBuckets();
+    ok &= checkStatus();
+    ok &= checkLongUptime();
+    ok &= checkConcurrent();
+    measureCost();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: wrong histogram, status window, long-uptime total or a torn ring event");
+    return ok ? 0 : 1;
+}
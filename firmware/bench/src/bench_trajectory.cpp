@@ -0,0 +1,242 @@
+/**
+ * コロ助ロボット - 関節軌道 ベンチマーク
+ * Corosuke Robot - Minimum-Jerk Trajectory Benchmark
+ *
+ * - 従来の「毎 tick 残りの 20% ずつ寄せる」と最小躍度軌道で、サーボ更新周期を変えたときに
+ *   指定時間どおりに着くか、ピーク速度・加速度がどうなるかを比べる
+ * - いろいろな移動（時間指定なし・短すぎる指定・速度 %）で関節ごとの速度・加速度の上限を守るか
+ * - 動いている途中で目標を変えたときに速度が途切れないか
+ * - update() の処理時間と動いている関節数
+ *
+ *   pio run -e trajectory -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../common/config.h"
+#include "../../common/trajectory.h"
+
+static const uint32_t TIMING_TICKS = 200000;
+static const uint32_t BATCH = 1000;
+
+static volatile float sink;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x2468ACE1;
+
+static float uniform() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState + 0.5f) / 4294967296.0f;
+}
+
+// =============================================================================
+// 指定時間どおりに着くか（目 90 → 130 度を 300ms で）
+// =============================================================================
+typedef struct {
+    uint32_t arriveMs;      // 目標から 0.5 度以内に入った時刻
+    float peakVel;          // 度/秒（tick ごとの変化から）
+    float peakAcc;          // 度/秒²
+} Arrival_t;
+
+static Arrival_t legacyArrival(float from, float to, uint32_t tickMs) {
+    Arrival_t r = {0, 0.0f, 0.0f};
+    float current = from, prevVel = 0.0f;
+    for (uint32_t now = tickMs; now < 5000; now += tickMs) {
+        float previous = current;
+        if (fabsf(current - to) > 0.5f) current += (to - current) * 0.2f;
+        float vel = (current - previous) * 1000.0f / tickMs;
+        r.peakVel = fmaxf(r.peakVel, fabsf(vel));
+        r.peakAcc = fmaxf(r.peakAcc, fabsf(vel - prevVel) * 1000.0f / tickMs);
+        prevVel = vel;
+        if (r.arriveMs == 0 && fabsf(current - to) <= 0.5f) r.arriveMs = now;
+    }
+    return r;
+}
+
+static Arrival_t plannedArrival(float from, float to, uint32_t durationMs, uint32_t tickMs) {
+    Arrival_t r = {0, 0.0f, 0.0f};
+    TrajectoryPlanner planner;
+    planner.setLimits(0, TRAJ_EYE_MAX_VEL, TRAJ_EYE_MAX_ACC);
+    planner.snap(0, from);
+    float positions[TRAJ_CHANNELS] = {from};
+    planner.moveTo(0, to, 0, durationMs);
+    float prevVel = 0.0f;
+    for (uint32_t now = tickMs; now < 5000; now += tickMs) {
+        float previous = positions[0];
+        planner.update(now, positions);
+        float vel = (positions[0] - previous) * 1000.0f / tickMs;
+        r.peakVel = fmaxf(r.peakVel, fabsf(vel));
+        r.peakAcc = fmaxf(r.peakAcc, fabsf(vel - prevVel) * 1000.0f / tickMs);
+        prevVel = vel;
+        if (r.arriveMs == 0 && fabsf(positions[0] - to) <= 0.5f) r.arriveMs = now;
+    }
+    return r;
+}
+
+static bool checkArrival() {
+    const uint32_t durationMs = 300;
+    printf("eye 90 -> 130 deg, requested %u ms (arrival = within 0.5 deg; vel/acc from tick differences)\n",
+           durationMs);
+    bool ok = true;
+    for (uint32_t tickMs : {10u, 20u, 33u}) {
+        Arrival_t a = legacyArrival(90.0f, 130.0f, tickMs);
+        Arrival_t b = plannedArrival(90.0f, 130.0f, durationMs, tickMs);
+        printf("  tick %2u ms  legacy 20%%: arrive %4u ms  peak %6.0f deg/s %8.0f deg/s2 | "
+               "min-jerk: arrive %4u ms  peak %6.0f deg/s %8.0f deg/s2\n",
+               tickMs, a.arriveMs, a.peakVel, a.peakAcc, b.arriveMs, b.peakVel, b.peakAcc);
+        // 最小躍度は 1 tick の遅れの範囲で指定時間に着く
+        if (b.arriveMs > durationMs + tickMs || b.arriveMs + tickMs < durationMs - 2 * tickMs) ok = false;
+    }
+    return ok;
+}
+
+// =============================================================================
+// 速度・加速度の上限（止まっている関節からの移動、1ms 刻み）
+// =============================================================================
+typedef struct {
+    const char* name;
+    float maxVel, maxAcc;
+} Group_t;
+
+static bool checkLimits() {
+    static const Group_t GROUPS[] = {
+        {"eye", TRAJ_EYE_MAX_VEL, TRAJ_EYE_MAX_ACC},
+        {"eyelid", TRAJ_EYELID_MAX_VEL, TRAJ_EYELID_MAX_ACC},
+        {"mouth", TRAJ_MOUTH_MAX_VEL, TRAJ_MOUTH_MAX_ACC},
+        {"neck", TRAJ_NECK_MAX_VEL, TRAJ_NECK_MAX_ACC},
+        {"arm", TRAJ_ARM_MAX_VEL, TRAJ_ARM_MAX_ACC},
+        {"leg", TRAJ_LEG_MAX_VEL, TRAJ_LEG_MAX_ACC},
+    };
+    printf("\nlimits over 2000 random moves per joint group (duration 0 / too short / long, speed %%)\n");
+    bool ok = true;
+    for (const Group_t& g : GROUPS) {
+        float worstVel = 0.0f, worstAcc = 0.0f;
+        TrajectoryPlanner planner;
+        planner.setLimits(0, g.maxVel, g.maxAcc);
+        planner.snap(0, 90.0f);
+        float positions[TRAJ_CHANNELS] = {90.0f};
+        uint32_t now = 0;
+        for (uint32_t n = 0; n < 2000; n++) {
+            float target = 10.0f + uniform() * 160.0f;
+            uint32_t kind = n % 4;
+            uint8_t speed = (uint8_t)(1 + uniform() * 99.0f);
+            float scale = 1.0f;
+            if (kind == 0) {
+                planner.moveTo(0, target, now);
+            } else if (kind == 1) {
+                planner.moveTo(0, target, now, (uint32_t)(1 + uniform() * 50.0f));
+            } else if (kind == 2) {
+                planner.moveTo(0, target, now, (uint32_t)(200 + uniform() * 2000.0f));
+            } else {
+                planner.moveAtSpeed(0, target, now, speed);
+                scale = speed / 100.0f;
+            }
+            // 位置の差分は float の分解能で遅い移動の加速度が埋もれるので、速度は velocity() から
+            float prevVel = 0.0f;
+            while (planner.moving(0)) {
+                now++;
+                float vel = planner.velocity(0, now);
+                planner.update(now, positions);
+                worstVel = fmaxf(worstVel, fabsf(vel) / (g.maxVel * scale));
+                worstAcc = fmaxf(worstAcc, fabsf(vel - prevVel) * 1000.0f / (g.maxAcc * scale * scale));
+                prevVel = vel;
+            }
+            planner.update(now, positions);     // 0.01 度未満の移動は軌道を引かずに次の update() で書く
+            if (positions[0] != target) ok = false;
+        }
+        printf("  %-7s %5.0f deg/s %6.0f deg/s2  peak vel %5.1f%%  peak acc %5.1f%% of limit  (%u stretched)\n",
+               g.name, g.maxVel, g.maxAcc, worstVel * 100.0f, worstAcc * 100.0f, planner.stats().stretched);
+        // 1ms 刻みの差分なので少しだけ余裕を見る
+        if (worstVel > 1.01f || worstAcc > 1.03f) ok = false;
+    }
+    return ok;
+}
+
+// =============================================================================
+// 途中で目標を変えたときの速度のつながり
+// =============================================================================
+static bool checkRetarget() {
+    printf("\nretarget mid-move (neck 90 -> 150, then -> 40 / 160 / 150.5 at 30-70%% of the move)\n");
+    float worstJump = 0.0f;
+    uint32_t count = 0;
+    for (float second : {40.0f, 160.0f, 150.5f}) {
+        for (uint32_t at = 30; at <= 70; at += 10) {
+            TrajectoryPlanner planner;
+            planner.setLimits(0, TRAJ_NECK_MAX_VEL, TRAJ_NECK_MAX_ACC);
+            planner.snap(0, 90.0f);
+            float positions[TRAJ_CHANNELS] = {90.0f};
+            planner.moveTo(0, 150.0f, 0, 1000);
+            uint32_t switchMs = at * 10;
+            planner.update(switchMs, positions);
+            float before = planner.velocity(0, switchMs);
+            planner.moveTo(0, second, switchMs);
+            float after = planner.velocity(0, switchMs);
+            float jump = fabsf(after - before);
+            worstJump = fmaxf(worstJump, jump);
+            count++;
+
+            // 位置も飛ばない
+            float held = positions[0];
+            planner.update(switchMs, positions);
+            if (fabsf(positions[0] - held) > 0.01f) worstJump = 1e9f;
+            while (planner.moving(0)) planner.update(switchMs += 5, positions);
+            if (positions[0] != second) worstJump = 1e9f;
+        }
+    }
+    printf("  %u retargets, worst velocity jump %.3f deg/s\n", count, worstJump);
+    return worstJump < 0.5f;
+}
+
+// =============================================================================
+// 処理時間
+// =============================================================================
+static void measureTiming() {
+    printf("\nupdate() per 20 ms tick (host CPU, mean of %u-call batches)\n", BATCH);
+    for (uint8_t active : {0, 1, 4, 9, 16}) {
+        BenchStats stats;
+        TrajectoryPlanner planner;
+        float positions[TRAJ_CHANNELS];
+        for (uint8_t ch = 0; ch < TRAJ_CHANNELS; ch++) {
+            planner.setLimits(ch, 1e6f, 1e9f);
+            planner.snap(ch, 90.0f);
+        }
+        uint32_t now = 0;
+        planner.update(now, positions);
+        for (uint32_t n = 0; n < TIMING_TICKS; n += BATCH) {
+            // 終わらない長い移動を active 本
+            for (uint8_t ch = 0; ch < active; ch++) {
+                planner.moveTo(ch, (n / BATCH) % 2 ? 30.0f : 150.0f, now, 60000);
+            }
+            uint64_t a = benchNowNs();
+            for (uint32_t i = 0; i < BATCH; i++) {
+                now += 20;
+                sink = (float)planner.update(now, positions);
+            }
+            uint64_t b = benchNowNs();
+            stats.add((b - a) / BATCH);
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%2u active joints", active);
+        stats.printNs(label);
+    }
+}
+
+int main() {
+    printf("=== コロ助 joint trajectory benchmark ===\n");
+
+    bool ok = checkArrival();
+    ok = checkLimits() && ok;
+    ok = checkRetarget() && ok;
+    measureTiming();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: late arrival, limit exceeded or velocity jump on retarget");
+    return ok ? 0 : 1;
+}
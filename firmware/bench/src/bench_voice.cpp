@@ -0,0 +1,308 @@
+/**
+ * コロ助ロボット - マイクの声の区間検出と ADPCM ベンチマーク
+ * Corosuke Robot - Voice Activity Detection and IMA-ADPCM Benchmark
+ *
+ * 合成した 2 分の部屋の音（雑音・ノック・サーッという音・大きさの違う発話）をメインボードと
+ * 同じ流れ（MIC_FRAME_MS ごとに VAD、声の区間だけ語頭と一緒に ADPCM）に通して次を調べる。
+ *
+ * - 発話を取りこぼさないか（発話のフレームのうち送られた割合）、発話でない音で区間ができないか
+ * - 上りの帯域: ずっと PCM / ずっと ADPCM で送る場合との比較
+ * - ADPCM の音質（SNR）と、チャンクの頭の状態から単独で復号しても同じ音になるか
+ * - 1 フレームあたりの処理時間（黙っている間 = VAD だけ、声の区間 = VAD + 符号化）
+ *
+ *   pio run -e voice -t exec
+ */
+
+#include <bench_stats.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "../../common/config.h"
+#include "../../common/ima_adpcm.h"
+#include "../../common/voice_activity.h"
+
+static const uint32_t FRAME_SAMPLES = MIC_SAMPLE_RATE * MIC_FRAME_MS / 1000;
+static const uint32_t SCENE_MS = 120000;
+static const uint32_t TIMING_FRAMES = 200000;
+
+static volatile uint32_t sink;
+
+// =============================================================================
+// 乱数
+// =============================================================================
+static uint32_t rngState = 0x2468ACE1;
+
+static float uniform() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState + 0.5f) / 4294967296.0f;
+}
+
+// =============================================================================
+// 合成した部屋の音
+// =============================================================================
+typedef enum { EVENT_SPEECH, EVENT_KNOCK, EVENT_HISS } EventKind_t;
+
+typedef struct {
+    EventKind_t kind;
+    uint32_t startMs;
+    uint32_t lengthMs;
+    float level;            // 振幅（16bit）
+} SceneEvent_t;
+
+// 発話の長さは「はい」程度から長い文まで、大きさは近く・普通・離れて小声
+static const SceneEvent_t SCENE[] = {
+    {EVENT_SPEECH, 3000, 2500, 6000.0f},
+    {EVENT_KNOCK, 9000, 200, 9000.0f},
+    {EVENT_SPEECH, 14000, 600, 3000.0f},
+    {EVENT_HISS, 20000, 1500, 1500.0f},
+    {EVENT_SPEECH, 26000, 4000, 2000.0f},
+    {EVENT_SPEECH, 31500, 1200, 900.0f},
+    {EVENT_KNOCK, 40000, 200, 15000.0f},
+    {EVENT_SPEECH, 47000, 3000, 9000.0f},
+    {EVENT_HISS, 55000, 3000, 3000.0f},
+    {EVENT_SPEECH, 65000, 800, 1200.0f},
+    {EVENT_SPEECH, 72000, 6000, 4000.0f},
+    {EVENT_KNOCK, 86000, 200, 12000.0f},
+    {EVENT_SPEECH, 95000, 2000, 700.0f},
+    {EVENT_SPEECH, 104000, 3500, 5000.0f},
+};
+static const size_t SCENE_EVENTS = sizeof(SCENE) / sizeof(SCENE[0]);
+
+static std::vector<int16_t> scene;
+static std::vector<uint8_t> speechFrame;    // 発話の中のフレーム
+
+static void buildScene() {
+    const uint32_t total = MIC_SAMPLE_RATE / 1000 * SCENE_MS;
+    std::vector<float> x(total);
+    for (uint32_t n = 0; n < total; n++) {
+        x[n] = (uniform() * 2.0f - 1.0f) * 120.0f;         // 部屋の雑音（RMS 約 70）
+    }
+
+    for (const SceneEvent_t& e : SCENE) {
+        uint32_t first = e.startMs * (MIC_SAMPLE_RATE / 1000);
+        uint32_t count = e.lengthMs * (MIC_SAMPLE_RATE / 1000);
+        float phase = 0.0f, lowpass = 0.0f;
+        for (uint32_t i = 0; i < count; i++) {
+            float t = (float)i / MIC_SAMPLE_RATE;
+            float u = uniform() * 2.0f - 1.0f;
+            float sample = 0.0f;
+            switch (e.kind) {
+                case EVENT_SPEECH: {
+                    // 音節（約 5Hz）ごとに頭に子音（高い周波数の雑音）、母音は揺れる f0 と倍音
+                    float syllable = fmodf(t * 5.0f, 1.0f);
+                    float f0 = 150.0f + 30.0f * sinf(2.0f * (float)M_PI * 0.7f * t);
+                    phase += 2.0f * (float)M_PI * f0 / MIC_SAMPLE_RATE;
+                    float vowel = sinf(phase) + 0.7f * sinf(2.0f * phase) + 0.4f * sinf(3.0f * phase) +
+                                  0.25f * sinf(5.0f * phase);
+                    float envelope = syllable < 0.15f ? 0.0f : sinf((syllable - 0.15f) / 0.85f * (float)M_PI);
+                    sample = vowel * envelope * 0.6f + (syllable < 0.12f ? u * 0.3f : 0.0f);
+                    break;
+                }
+                case EVENT_KNOCK:
+                    // 20ms の広帯域の音を 2 回
+                    if (i < count / 10 || (i >= count / 2 && i < count / 2 + count / 10)) {
+                        lowpass += (u - lowpass) * 0.3f;
+                        sample = lowpass * 2.0f;
+                    }
+                    break;
+                case EVENT_HISS:
+                    sample = u;
+                    break;
+            }
+            x[first + i] += sample * e.level;
+        }
+    }
+
+    scene.resize(total);
+    for (uint32_t n = 0; n < total; n++) {
+        scene[n] = (int16_t)fmaxf(-32768.0f, fminf(32767.0f, x[n]));
+    }
+    speechFrame.assign(total / FRAME_SAMPLES, 0);
+    for (const SceneEvent_t& e : SCENE) {
+        if (e.kind != EVENT_SPEECH) continue;
+        for (uint32_t ms = e.startMs; ms < e.startMs + e.lengthMs; ms += MIC_FRAME_MS) {
+            speechFrame[ms / MIC_FRAME_MS] = 1;
+        }
+    }
+}
+
+// =============================================================================
+// メインボードと同じ流れで送るフレームを決める
+// =============================================================================
+typedef struct {
+    std::vector<uint8_t> sent;      // 送ったフレーム（語頭・区間・余韻）
+    uint32_t segments;
+    uint32_t falseSegments;         // 発話と重ならない区間
+    uint32_t speechEvents;
+    uint32_t missedEvents;          // 区間と重ならない発話
+    uint32_t bytes;                 // メッセージのバイト数（種類と seq のヘッダー・チャンクの頭を含む）
+} Upstream_t;
+
+static Upstream_t runPipeline() {
+    Upstream_t r;
+    const uint32_t frames = (uint32_t)speechFrame.size();
+    r.sent.assign(frames, 0);
+    r.segments = r.falseSegments = r.speechEvents = r.missedEvents = 0;
+    r.bytes = 0;
+
+    VoiceActivityDetector vad;
+    uint32_t segmentStart = 0, chunkFrames = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        VadEvent_t event = vad.process(&scene[f * FRAME_SAMPLES], FRAME_SAMPLES);
+        uint32_t first = f, last = f;
+        if (event == VAD_START) {
+            r.segments++;
+            r.bytes += 2 + 9;                                   // AUDIO_START
+            first = f + 1 >= MIC_PREROLL_FRAMES ? f + 1 - MIC_PREROLL_FRAMES : 0;
+            segmentStart = first;
+        } else if (event != VAD_VOICE) {
+            if (event == VAD_END) {
+                bool overlaps = false;
+                for (uint32_t k = segmentStart; k < f; k++) overlaps = overlaps || speechFrame[k];
+                if (!overlaps) r.falseSegments++;
+                if (chunkFrames) r.bytes += 2 + 6;              // 途中のチャンクの頭
+                r.bytes += 2 + 4;                               // AUDIO_END
+                chunkFrames = 0;
+            }
+            continue;
+        }
+        for (uint32_t k = first; k <= last; k++) {
+            r.sent[k] = 1;
+            r.bytes += FRAME_SAMPLES / 2;
+            if (chunkFrames++ == 0) r.bytes += 2 + 6;
+            if (chunkFrames == MIC_CHUNK_FRAMES) chunkFrames = 0;
+        }
+    }
+
+    for (const SceneEvent_t& e : SCENE) {
+        if (e.kind != EVENT_SPEECH) continue;
+        r.speechEvents++;
+        bool heard = false;
+        for (uint32_t ms = e.startMs; ms < e.startMs + e.lengthMs; ms += MIC_FRAME_MS) {
+            heard = heard || r.sent[ms / MIC_FRAME_MS];
+        }
+        if (!heard) r.missedEvents++;
+    }
+    return r;
+}
+
+static bool checkDetection() {
+    Upstream_t r = runPipeline();
+    uint32_t speech = 0, speechSent = 0, other = 0, otherSent = 0;
+    for (size_t f = 0; f < r.sent.size(); f++) {
+        if (speechFrame[f]) {
+            speech++;
+            speechSent += r.sent[f];
+        } else {
+            other++;
+            otherSent += r.sent[f];
+        }
+    }
+    const float seconds = SCENE_MS / 1000.0f;
+    printf("%u s scene: %u utterances (%.1f%% of the time), %u knocks/hiss bursts\n",
+           SCENE_MS / 1000, r.speechEvents, speech * 100.0f / r.sent.size(), (unsigned)(SCENE_EVENTS - r.speechEvents));
+    printf("  segments %u (false %u), missed utterances %u\n", r.segments, r.falseSegments, r.missedEvents);
+    printf("  speech frames sent %.1f%%, other frames sent %.1f%% (pre-roll and hangover)\n",
+           speechSent * 100.0f / speech, otherSent * 100.0f / other);
+    printf("\nupstream bandwidth\n");
+    printf("  always PCM    %8.0f B/s\n", MIC_SAMPLE_RATE * 2.0f);
+    printf("  always ADPCM  %8.0f B/s\n", MIC_SAMPLE_RATE / 2.0f);
+    printf("  VAD + ADPCM   %8.0f B/s (%.1f%% of always-PCM)\n", r.bytes / seconds,
+           r.bytes / seconds * 100.0f / (MIC_SAMPLE_RATE * 2.0f));
+    return r.missedEvents == 0 && r.falseSegments == 0 && speechSent >= speech * 0.98f &&
+           r.bytes / seconds < MIC_SAMPLE_RATE / 2.0f * 0.5f;
+}
+
+// =============================================================================
+// ADPCM の音質とチャンク単位の復号
+// =============================================================================
+static bool checkAdpcm() {
+    const uint32_t chunkSamples = FRAME_SAMPLES * MIC_CHUNK_FRAMES;
+    bool ok = true;
+    printf("\nIMA-ADPCM (4 bit/sample) on the utterances\n");
+    for (const SceneEvent_t& e : SCENE) {
+        if (e.kind != EVENT_SPEECH || (e.level != 9000.0f && e.level != 2000.0f && e.level != 700.0f)) continue;
+        uint32_t first = e.startMs * (MIC_SAMPLE_RATE / 1000);
+        uint32_t count = e.lengthMs * (MIC_SAMPLE_RATE / 1000) / chunkSamples * chunkSamples;
+        const int16_t* pcm = &scene[first];
+
+        std::vector<uint8_t> code(count / 2);
+        std::vector<AdpcmState_t> headers;
+        AdpcmState_t encoder;
+        adpcmReset(&encoder);
+        for (uint32_t i = 0; i < count; i += chunkSamples) {
+            headers.push_back(encoder);
+            adpcmEncode(&encoder, pcm + i, chunkSamples, &code[i / 2]);
+        }
+
+        // 続けて復号したものと、チャンクごとに頭の状態から復号したもの
+        std::vector<int16_t> whole(count), chunked(count);
+        AdpcmState_t decoder;
+        adpcmReset(&decoder);
+        adpcmDecode(&decoder, code.data(), count / 2, whole.data());
+        for (size_t c = 0; c < headers.size(); c++) {
+            AdpcmState_t state = headers[c];
+            adpcmDecode(&state, &code[c * chunkSamples / 2], chunkSamples / 2, &chunked[c * chunkSamples]);
+        }
+
+        double signal = 0.0, noise = 0.0;
+        for (uint32_t i = 0; i < count; i++) {
+            signal += (double)pcm[i] * pcm[i];
+            noise += ((double)whole[i] - pcm[i]) * ((double)whole[i] - pcm[i]);
+        }
+        double snr = 10.0 * log10(signal / fmax(noise, 1.0));
+        bool same = memcmp(whole.data(), chunked.data(), count * sizeof(int16_t)) == 0;
+        printf("  level %5.0f: SNR %.1f dB, per-chunk decode %s\n", e.level, snr, same ? "identical" : "DIFFERS");
+        if (snr < 18.0 || !same) ok = false;
+    }
+    return ok;
+}
+
+// =============================================================================
+// 処理時間
+// =============================================================================
+static void measureTiming() {
+    printf("\nper %d ms frame (%u samples, host CPU)\n", MIC_FRAME_MS, FRAME_SAMPLES);
+    std::vector<int16_t> quiet(FRAME_SAMPLES), voice(FRAME_SAMPLES);
+    for (uint32_t i = 0; i < FRAME_SAMPLES; i++) {
+        quiet[i] = (int16_t)((uniform() * 2.0f - 1.0f) * 120.0f);
+        voice[i] = scene[3000 * (MIC_SAMPLE_RATE / 1000) + 4000 + i];
+    }
+    uint8_t code[FRAME_SAMPLES / 2];
+
+    BenchStats vadNs, encodeNs;
+    VoiceActivityDetector vad;
+    AdpcmState_t state;
+    adpcmReset(&state);
+    for (uint32_t n = 0; n < TIMING_FRAMES; n++) {
+        uint64_t a = benchNowNs();
+        sink = vad.process(quiet.data(), FRAME_SAMPLES);
+        uint64_t b = benchNowNs();
+        sink = (uint32_t)adpcmEncode(&state, voice.data(), FRAME_SAMPLES, code) + code[n % sizeof(code)];
+        uint64_t c = benchNowNs();
+        vadNs.add(b - a);
+        encodeNs.add(c - b);
+    }
+    vadNs.printNs("VAD (silence)");
+    encodeNs.printNs("ADPCM encode (voice)");
+}
+
+int main() {
+    printf("=== コロ助 voice activity / ADPCM benchmark ===\n");
+    printf("%d Hz, %d ms frames, onset %d frames, hangover %d ms, pre-roll %d frames, %d frames per chunk\n\n",
+           MIC_SAMPLE_RATE, MIC_FRAME_MS, VAD_ONSET_FRAMES, VAD_HANGOVER_MS, MIC_PREROLL_FRAMES, MIC_CHUNK_FRAMES);
+
+    buildScene();
+    bool ok = checkDetection();
+    ok = checkAdpcm() && ok;
+    measureTiming();
+
+    printf("\n%s\n", ok ? "OK" : "FAILED: missed speech, a false segment, too much upstream or poor ADPCM");
+    return ok ? 0 : 1;
+}
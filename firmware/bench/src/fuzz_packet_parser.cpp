@@ -0,0 +1,374 @@
+/**
+ * コロ助ロボット - パケットパーサー ファズハーネス
+ * Corosuke Robot - Packet Parser Fuzz Harness
+ *
+ * 任意のバイト列を不規則な大きさに区切って PacketParser に流し込み、
+ * 取り出したパケット列が参照実装（全入力を先頭から貪欲に走査）と
+ * 完全に一致することを確認する。v1 と v2（CRC-16）のフレームが混ざった入力も扱う。
+ *
+ * - COROSUKE_LIBFUZZER 定義時は LLVMFuzzerTestOneInput のみを提供する
+ * - それ以外はコーパスの再生と簡易変異ファズを行う main() を持つ
+ *
+ *   fuzz_packet_parser [corpus_dir] [--iterations N] [--write-corpus]
+ */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+
+typedef struct {
+    uint8_t version;
+    uint8_t ctrl;
+    uint8_t seq;
+    uint8_t ack;
+    uint8_t cmd;
+    std::vector<uint8_t> data;
+} RefPacket_t;
+
+// v2 フレームとして正しければ packet を埋めてフレーム長を返す（違えば 0）
+static size_t referenceParseV2(const uint8_t* frame, size_t available, RefPacket_t* packet) {
+    if (available < 2) return 0;
+    size_t length = frame[1];
+    size_t frameLength = length + 5;
+    if (length < 2 || frameLength > PACKET_MAX_SIZE || frameLength > available) return 0;
+    if (frame[frameLength - 1] != PACKET_END) return 0;
+    if (crc16(&frame[1], length + 1) != (frame[frameLength - 3] | (frame[frameLength - 2] << 8))) return 0;
+
+    size_t header = 1 + ((frame[2] & PACKET_V2_RELIABLE) ? 1 : 0) + ((frame[2] & PACKET_V2_ACK) ? 1 : 0);
+    if (header + 1 > length) return 0;
+    size_t idx = 3;
+    packet->version = 2;
+    packet->ctrl = frame[2];
+    packet->seq = (frame[2] & PACKET_V2_RELIABLE) ? frame[idx++] : 0;
+    packet->ack = (frame[2] & PACKET_V2_ACK) ? frame[idx++] : 0;
+    packet->cmd = frame[idx];
+    packet->data.assign(&frame[idx + 1], &frame[length + 2]);
+    return frameLength;
+}
+
+// 参照実装: START の位置ごとに完全なフレームかを調べ、正しければ丸ごと消費する
+static std::vector<RefPacket_t> referenceParse(const uint8_t* input, size_t size) {
+    std::vector<RefPacket_t> packets;
+    size_t i = 0;
+    while (i < size) {
+        if (input[i] == PACKET_START_V2) {
+            RefPacket_t packet;
+            size_t frameLength = referenceParseV2(&input[i], size - i, &packet);
+            if (frameLength) {
+                packets.push_back(packet);
+                i += frameLength;
+                continue;
+            }
+        }
+        if (input[i] == PACKET_START && i + 1 < size) {
+            size_t length = input[i + 1];
+            size_t frameLength = length + 4;
+            if (length > 0 && frameLength <= PACKET_MAX_SIZE && i + frameLength <= size &&
+                input[i + frameLength - 1] == PACKET_END &&
+                calculateChecksum(&input[i + 1], (uint8_t)(length + 1)) == input[i + frameLength - 2]) {
+                RefPacket_t packet;
+                packet.version = 1;
+                packet.ctrl = 0;
+                packet.seq = 0;
+                packet.ack = 0;
+                packet.cmd = input[i + 2];
+                packet.data.assign(&input[i + 3], &input[i + 3 + length - 1]);
+                packets.push_back(packet);
+                i += frameLength;
+                continue;
+            }
+        }
+        i++;
+    }
+    return packets;
+}
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        fprintf(stderr, "packet parser invariant violated: %s\n", what);
+        abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* input, size_t size) {
+    static PacketParser parser;
+    parser.reset();
+
+    std::vector<RefPacket_t> expected = referenceParse(input, size);
+    size_t got = 0;
+
+    // 区切り位置は入力自身から決める（同じ入力なら常に同じ分割）
+    size_t offset = 0;
+    size_t step = 1;
+    bool draining = false;
+    while (!draining) {
+        if (offset < size) {
+            size_t chunk = 1 + (input[offset] ^ (uint8_t)step) % 97;
+            if (chunk > size - offset) chunk = size - offset;
+            size_t accepted = parser.write(&input[offset], chunk);
+            offset += accepted;
+            step++;
+        } else {
+            // 入力が途切れた → アイドル再同期で残りを吐き出す
+            draining = !parser.resyncIfStalled();
+        }
+
+        PacketView_t view;
+        while (parser.next(&view)) {
+            check(view.frame[0] == (view.version == 2 ? PACKET_START_V2 : PACKET_START), "frame starts with START");
+            check(view.frame[view.frameLength - 1] == PACKET_END, "frame ends with END");
+            check(view.data + view.length + (view.version == 2 ? 3 : 2) == view.frame + view.frameLength,
+                  "data view ends before trailer");
+            check(view.cmd == view.data[-1], "cmd byte precedes data");
+            check(got < expected.size(), "no extra packets");
+            check(view.version == expected[got].version, "version matches reference");
+            check(view.ctrl == expected[got].ctrl, "ctrl matches reference");
+            check(view.seq == expected[got].seq && view.ack == expected[got].ack, "seq/ack match reference");
+            check(view.cmd == expected[got].cmd, "cmd matches reference");
+            check(view.length == expected[got].data.size(), "length matches reference");
+            check(view.length == 0 || memcmp(view.data, expected[got].data.data(), view.length) == 0,
+                  "payload matches reference");
+            got++;
+        }
+        check(parser.buffered() <= PACKET_PARSER_RING_SIZE, "ring bounds");
+    }
+
+    check(got == expected.size(), "no lost packets");
+    check(parser.buffered() == 0, "drained");
+    check(parser.stats().overflows == 0, "write() never overflows when fed by space()");
+    return 0;
+}
+
+#ifndef COROSUKE_LIBFUZZER
+
+// =============================================================================
+// コーパス再生 + 簡易変異ファズ
+// =============================================================================
+static uint32_t rngState = 0xC0C05u;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>* out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    out->clear();
+    uint8_t buffer[1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        out->insert(out->end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    return true;
+}
+
+static void appendPacket(std::vector<uint8_t>& out, uint8_t cmd, const uint8_t* data, uint8_t length) {
+    size_t begin = out.size();
+    out.push_back(PACKET_START);
+    out.push_back(length + 1);
+    out.push_back(cmd);
+    out.insert(out.end(), data, data + length);
+    out.push_back(calculateChecksum(&out[begin + 1], length + 2));
+    out.push_back(PACKET_END);
+}
+
+static void appendPacketV2(std::vector<uint8_t>& out, uint8_t ctrl, uint8_t seq, uint8_t ack,
+                           uint8_t cmd, const uint8_t* data, uint8_t length) {
+    uint8_t frame[PACKET_MAX_SIZE];
+    uint8_t size = buildPacketV2(frame, ctrl, seq, ack, cmd, data, length);
+    out.insert(out.end(), frame, frame + size);
+}
+
+// 境界条件を突くシード
+static std::vector<std::pair<std::string, std::vector<uint8_t>>> seedCorpus() {
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> seeds;
+    uint8_t payload[PACKET_MAX_SIZE];
+    for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 37 + 1);
+
+    std::vector<uint8_t> s;
+
+    appendPacket(s, CMD_PING, nullptr, 0);
+    seeds.push_back({"ping", s});
+
+    s.clear();
+    appendPacket(s, CMD_ARM_POSITION, payload, PACKET_MAX_SIZE - 5);
+    seeds.push_back({"max_length", s});
+
+    s.clear();
+    s.push_back(PACKET_START);
+    s.push_back(PACKET_MAX_SIZE);      // 長すぎる LENGTH
+    appendPacket(s, CMD_LIPSYNC_DATA, payload, 1);
+    seeds.push_back({"bad_length_then_valid", s});
+
+    s.clear();
+    s.push_back(PACKET_START);
+    s.push_back(40);                   // 偽の START が後続の正常パケットを飲み込む形
+    appendPacket(s, CMD_EXPRESSION, payload, 4);
+    appendPacket(s, CMD_EYE_POSITION, payload, 3);
+    seeds.push_back({"false_start_swallows", s});
+
+    s.clear();
+    appendPacket(s, CMD_WALK_START, payload, 3);
+    s[s.size() - 2] ^= 0x01;           // チェックサム不一致
+    appendPacket(s, CMD_WALK_STOP, nullptr, 0);
+    seeds.push_back({"checksum_error", s});
+
+    s.clear();
+    appendPacket(s, CMD_IMU_DATA, payload, 12);
+    s.back() = 0x00;                   // END 不一致
+    appendPacket(s, CMD_BALANCE_STATUS, payload, 1);
+    seeds.push_back({"missing_end", s});
+
+    s.clear();
+    for (int i = 0; i < 3; i++) s.push_back(PACKET_START);
+    payload[0] = PACKET_START;         // データ部に START/END を含む
+    payload[1] = PACKET_END;
+    appendPacket(s, CMD_LOOK_AT, payload, 3);
+    seeds.push_back({"embedded_markers", s});
+
+    s.clear();
+    for (int i = 0; i < 120; i++) {    // リングを何周もする長いストリーム
+        appendPacket(s, CMD_LIPSYNC_DATA, &payload[i % 8], 1 + (i % 20));
+        if (i % 17 == 0) s.push_back((uint8_t)i);
+    }
+    seeds.push_back({"ring_wrap_stream", s});
+
+    s.clear();
+    appendPacket(s, CMD_EXPRESSION, payload, 4);
+    s.resize(s.size() - 3);            // 途中で切れたパケット
+    seeds.push_back({"truncated", s});
+
+    s.clear();                         // v1 と v2 の混在（SEQ/ACK の有無をすべて）
+    appendPacketV2(s, 0, 0, 0, CMD_LIPSYNC_DATA, payload, 1);
+    appendPacket(s, CMD_EXPRESSION, payload, 4);
+    appendPacketV2(s, PACKET_V2_RELIABLE | PACKET_V2_SYN, 200, 0, CMD_EXPRESSION, payload, 4);
+    appendPacketV2(s, PACKET_V2_ACK, 0, 17, CMD_LINK_ACK, nullptr, 0);
+    appendPacketV2(s, PACKET_V2_RELIABLE | PACKET_V2_ACK, 201, 18, CMD_WAVE, payload, 1);
+    seeds.push_back({"v2_mixed", s});
+
+    s.clear();
+    appendPacketV2(s, PACKET_V2_RELIABLE | PACKET_V2_ACK, 5, 6, CMD_ARM_POSITION, payload, PACKET_V2_MAX_DATA);
+    seeds.push_back({"v2_max_length", s});
+
+    s.clear();
+    appendPacketV2(s, PACKET_V2_RELIABLE, 9, 0, CMD_WALK_START, payload, 3);
+    s[s.size() - 3] ^= 0x10;           // CRC 不一致
+    appendPacketV2(s, PACKET_V2_ACK, 0, 10, CMD_LINK_NACK, payload, 2);
+    seeds.push_back({"v2_crc_error", s});
+
+    s.clear();
+    s.push_back(PACKET_START_V2);      // CTRL が SEQ/ACK を要求するのに CMD が入らない長さ
+    s.push_back(2);
+    s.push_back(PACKET_V2_RELIABLE | PACKET_V2_ACK);
+    s.push_back(1);
+    uint16_t crc = crc16(&s[1], 3);
+    s.push_back((uint8_t)crc);
+    s.push_back((uint8_t)(crc >> 8));
+    s.push_back(PACKET_END);
+    appendPacketV2(s, 0, 0, 0, CMD_PING, nullptr, 0);
+    seeds.push_back({"v2_short_header", s});
+
+    return seeds;
+}
+
+static void mutate(std::vector<uint8_t>* data) {
+    int edits = 1 + nextRandom() % 4;
+    for (int i = 0; i < edits; i++) {
+        size_t size = data->size();
+        switch (nextRandom() % 5) {
+            case 0:
+                if (size) (*data)[nextRandom() % size] ^= (uint8_t)(1u << (nextRandom() % 8));
+                break;
+            case 1:
+                if (size) data->erase(data->begin() + nextRandom() % size);
+                break;
+            case 2:
+                data->insert(data->begin() + (size ? nextRandom() % (size + 1) : 0),
+                             (nextRandom() & 1) ? (uint8_t)(PACKET_START | (nextRandom() & 1)) : (uint8_t)nextRandom());
+                break;
+            case 3:
+                if (size) (*data)[nextRandom() % size] = (uint8_t)nextRandom();
+                break;
+            default:
+                if (size > 1 && data->size() < 4096) {
+                    size_t from = nextRandom() % size;
+                    size_t len = 1 + nextRandom() % (size - from);
+                    std::vector<uint8_t> copy(data->begin() + from, data->begin() + from + len);
+                    data->insert(data->begin() + nextRandom() % (size + 1), copy.begin(), copy.end());
+                }
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string corpusDir;
+    uint32_t iterations = 200000;
+    bool writeCorpus = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--write-corpus") == 0) {
+            writeCorpus = true;
+        } else {
+            corpusDir = argv[i];
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> corpus;
+    for (auto& seed : seedCorpus()) {
+        corpus.push_back(seed.second);
+        if (writeCorpus && !corpusDir.empty()) {
+            writeFile(corpusDir + "/" + seed.first + ".bin", seed.second);
+        }
+    }
+
+    if (!corpusDir.empty()) {
+        DIR* dir = opendir(corpusDir.c_str());
+        if (dir) {
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                if (entry->d_name[0] == '.') continue;
+                std::vector<uint8_t> data;
+                if (readFile(corpusDir + "/" + entry->d_name, &data)) {
+                    corpus.push_back(data);
+                }
+            }
+            closedir(dir);
+        }
+    }
+
+    for (auto& input : corpus) {
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("corpus: %zu inputs OK\n", corpus.size());
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        std::vector<uint8_t> input = corpus[nextRandom() % corpus.size()];
+        mutate(&input);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("mutations: %u inputs OK\n", iterations);
+    return 0;
+}
+
+#endif // COROSUKE_LIBFUZZER
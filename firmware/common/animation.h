@@ -0,0 +1,293 @@
+/**
+ * コロ助ロボット - キーフレームアニメーションエンジン
+ * Corosuke Robot - Keyframe Animation Engine
+ *
+ * チャンネルごとのキーフレーム列（トラック）をまとめたクリップを、
+ * サーボ更新 tick の中で少しずつ進める。delay() で待たないので、
+ * 再生中もまばたき・リップシンク・UART受信が止まらない。
+ *
+ * - キー間はイージング付きで補間（0.25度単位の固定小数点）
+ * - クリップは繰り返し回数を指定でき、0 なら止めるまでループ
+ * - レイヤーは番号順に重ね、フェードイン・フェードアウトの重みで
+ *   下のレイヤー（最下層は表情などで決まるベース姿勢）と混ぜる
+ * - 角度 ANIM_FROM_CURRENT のキーは再生開始時の出力角度になるので、
+ *   今の姿勢から滑らかに動き出すクリップを作れる
+ */
+
+#ifndef COROSUKE_ANIMATION_H
+#define COROSUKE_ANIMATION_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define ANIM_CHANNELS       16
+#define ANIM_LAYERS         4
+#define ANIM_FROM_CURRENT   0xFF    // 再生開始時の出力角度
+#define ANIM_WEIGHT_ONE     256     // 重み 1.0 (Q8)
+
+typedef enum {
+    EASE_LINEAR = 0,
+    EASE_IN,                // ゆっくり動き出す
+    EASE_OUT,               // ゆっくり止まる
+    EASE_IN_OUT,            // 両端でゆっくり（smoothstep）
+    EASE_STEP               // 次のキーの時刻で切り替え
+} AnimEase_t;
+
+// キーフレーム（ease は直前のキーからこのキーへの補間方法）
+typedef struct {
+    uint16_t timeMs;
+    uint8_t angle;          // 0-180 / ANIM_FROM_CURRENT
+    uint8_t ease;           // AnimEase_t
+} AnimKey_t;
+
+typedef struct {
+    uint8_t channel;
+    uint8_t keyCount;
+    const AnimKey_t* keys;  // timeMs の昇順
+} AnimTrack_t;
+
+typedef struct {
+    uint16_t durationMs;    // 1回分の長さ（ループ周期）
+    uint8_t trackCount;
+    const AnimTrack_t* tracks;
+} AnimClip_t;
+
+// 実行時に組み立てるクリップ（指差し・腕の位置など引数で形が変わるもの）
+#define ANIM_BUFFER_TRACKS  8
+#define ANIM_BUFFER_KEYS    4
+
+class AnimClipBuffer {
+public:
+    AnimClipBuffer() { clear(); }
+
+    void clear() {
+        _clip.durationMs = 0;
+        _clip.trackCount = 0;
+        _clip.tracks = _tracks;
+    }
+
+    // 1トラック追加（keys はコピーする）。入りきらなければ false
+    bool addTrack(uint8_t channel, const AnimKey_t* keys, uint8_t keyCount) {
+        if (_clip.trackCount >= ANIM_BUFFER_TRACKS || keyCount == 0 || keyCount > ANIM_BUFFER_KEYS) {
+            return false;
+        }
+        uint8_t index = _clip.trackCount++;
+        memcpy(_keys[index], keys, keyCount * sizeof(AnimKey_t));
+        _tracks[index].channel = channel;
+        _tracks[index].keyCount = keyCount;
+        _tracks[index].keys = _keys[index];
+        if (keys[keyCount - 1].timeMs > _clip.durationMs) {
+            _clip.durationMs = keys[keyCount - 1].timeMs;
+        }
+        return true;
+    }
+
+    const AnimClip_t* clip() const { return &_clip; }
+
+private:
+    AnimClip_t _clip;
+    AnimTrack_t _tracks[ANIM_BUFFER_TRACKS];
+    AnimKey_t _keys[ANIM_BUFFER_TRACKS][ANIM_BUFFER_KEYS];
+};
+
+// =============================================================================
+// 再生エンジン
+// =============================================================================
+class AnimationEngine {
+public:
+    AnimationEngine() {
+        memset(_layers, 0, sizeof(_layers));
+        memset(_lastOut, 0, sizeof(_lastOut));
+    }
+
+    // layer にクリップを再生する（同じレイヤーの再生中クリップは置き換え）
+    // repeats: 繰り返し回数（0 = stop() までループ）
+    // fadeInMs / fadeOutMs: 下のレイヤーとの重みを 0↔1 に変える時間
+    void play(uint8_t layer, const AnimClip_t* clip, uint32_t nowMs, uint8_t repeats = 1,
+              uint16_t fadeInMs = 0, uint16_t fadeOutMs = 0) {
+        if (layer >= ANIM_LAYERS || clip == nullptr) return;
+        Layer_t& l = _layers[layer];
+        l.clip = clip;
+        l.startMs = nowMs;
+        l.repeats = repeats;
+        l.fadeInMs = fadeInMs;
+        l.fadeOutMs = fadeOutMs;
+        l.stopping = false;
+        // アニメーション中のチャンネルは今の出力から、それ以外は次の update() の base から
+        memcpy(l.from, _lastOut, sizeof(l.from));
+        l.fromBaseMask = (uint16_t)~_drivenPrev;
+        updateActiveMask();
+    }
+
+    // フェードアウトしてから止める（fadeOutMs = 0 なら次の update() で解放）
+    void stop(uint8_t layer, uint32_t nowMs, uint16_t fadeOutMs = 0) {
+        if (layer >= ANIM_LAYERS || _layers[layer].clip == nullptr) return;
+        Layer_t& l = _layers[layer];
+        l.stopping = true;
+        l.stopMs = nowMs;
+        l.stopWeight = layerWeight(l, nowMs);
+        l.fadeOutMs = fadeOutMs;
+    }
+
+    bool isPlaying(uint8_t layer) const {
+        return layer < ANIM_LAYERS && _layers[layer].clip != nullptr;
+    }
+
+    const AnimClip_t* clip(uint8_t layer) const {
+        return layer < ANIM_LAYERS ? _layers[layer].clip : nullptr;
+    }
+
+    // 再生中のクリップが動かしているチャンネル
+    uint16_t activeMask() const { return _activeMask; }
+
+    // サーボ更新 tick ごとに呼ぶ。base はアニメーションがないときの姿勢。
+    // 戻り値: out に角度を書いたチャンネル。released: この tick で
+    // アニメーションが外れた（base に戻すべき）チャンネル
+    uint16_t update(uint32_t nowMs, const uint8_t base[ANIM_CHANNELS], uint8_t out[ANIM_CHANNELS],
+                    uint16_t* released) {
+        // Q2 (0.25度単位) で重ねてから最後に丸める
+        int16_t blended[ANIM_CHANNELS];
+        uint16_t driven = 0;
+
+        for (uint8_t layer = 0; layer < ANIM_LAYERS; layer++) {
+            Layer_t& l = _layers[layer];
+            if (l.clip == nullptr) continue;
+
+            if (l.fromBaseMask) {
+                for (uint8_t ch = 0; ch < ANIM_CHANNELS; ch++) {
+                    if (l.fromBaseMask & (1u << ch)) l.from[ch] = base[ch];
+                }
+                l.fromBaseMask = 0;
+            }
+            // 置き換えたクリップのフェードインは base ではなく直前の出力から
+            bool fadingIn = !l.stopping && nowMs - l.startMs < l.fadeInMs;
+
+            uint32_t t;
+            int32_t weight;
+            if (!advance(l, nowMs, &t, &weight)) {
+                l.clip = nullptr;
+                continue;
+            }
+
+            for (uint8_t i = 0; i < l.clip->trackCount; i++) {
+                const AnimTrack_t& track = l.clip->tracks[i];
+                uint8_t ch = track.channel;
+                if (ch >= ANIM_CHANNELS) continue;
+                uint16_t bit = (uint16_t)(1u << ch);
+
+                int32_t target = evaluate(track, t, l.from[ch]);
+                int32_t below = (driven & bit) ? blended[ch] : (fadingIn ? l.from[ch] : base[ch]) * 4;
+                blended[ch] = (int16_t)(below + (((target - below) * weight) >> 8));
+                driven |= bit;
+            }
+        }
+
+        for (uint8_t ch = 0; ch < ANIM_CHANNELS; ch++) {
+            if (driven & (1u << ch)) {
+                out[ch] = (uint8_t)((blended[ch] + 2) >> 2);
+                _lastOut[ch] = out[ch];
+            } else {
+                _lastOut[ch] = base[ch];
+            }
+        }
+
+        *released = _drivenPrev & ~driven;
+        _drivenPrev = driven;
+        updateActiveMask();
+        return driven;
+    }
+
+private:
+    typedef struct {
+        const AnimClip_t* clip;     // nullptr = 空き
+        uint32_t startMs;
+        uint32_t stopMs;
+        uint16_t fadeInMs;
+        uint16_t fadeOutMs;
+        int32_t stopWeight;         // stop() した時点の重み
+        uint8_t repeats;
+        bool stopping;
+        uint16_t fromBaseMask;          // from を base で埋めるチャンネル
+        uint8_t from[ANIM_CHANNELS];    // 再生開始時の出力角度
+    } Layer_t;
+
+    // フェードアウト前の重み (Q8)
+    static int32_t layerWeight(const Layer_t& l, uint32_t nowMs) {
+        uint32_t elapsed = nowMs - l.startMs;
+        if (l.fadeInMs == 0 || elapsed >= l.fadeInMs) return ANIM_WEIGHT_ONE;
+        return (int32_t)(elapsed * ANIM_WEIGHT_ONE / l.fadeInMs);
+    }
+
+    static int32_t fadeOut(int32_t weight, uint32_t elapsed, uint16_t fadeOutMs) {
+        if (elapsed >= fadeOutMs) return 0;
+        return weight * (int32_t)(fadeOutMs - elapsed) / fadeOutMs;
+    }
+
+    // クリップ内の時刻と重みを求める。フェードアウトし終わっていれば false
+    static bool advance(const Layer_t& l, uint32_t nowMs, uint32_t* t, int32_t* weight) {
+        uint32_t elapsed = nowMs - l.startMs;
+        uint32_t duration = l.clip->durationMs;
+        uint32_t total = duration * l.repeats;
+        bool finished = l.repeats != 0 && elapsed >= total;
+
+        // 繰り返しが終わったら最後のフレームのまま
+        *t = finished ? duration : (duration ? elapsed % duration : 0);
+
+        if (l.stopping) {
+            *weight = fadeOut(l.stopWeight, nowMs - l.stopMs, l.fadeOutMs);
+            return *weight > 0;
+        }
+        if (finished) {
+            *weight = fadeOut(layerWeight(l, l.startMs + total), elapsed - total, l.fadeOutMs);
+            return *weight > 0;
+        }
+        *weight = layerWeight(l, nowMs);
+        return true;
+    }
+
+    // イージング: 進み具合 x (Q8) → Q8
+    static int32_t ease(uint8_t kind, int32_t x) {
+        switch (kind) {
+            case EASE_IN:     return (x * x) >> 8;
+            case EASE_OUT:    return x * (512 - x) >> 8;
+            case EASE_IN_OUT: return (x * x * (768 - 2 * x)) >> 16;
+            case EASE_STEP:   return x >= ANIM_WEIGHT_ONE ? ANIM_WEIGHT_ONE : 0;
+            default:          return x;
+        }
+    }
+
+    // トラックの時刻 t での角度 (Q2)
+    static int32_t evaluate(const AnimTrack_t& track, uint32_t t, uint8_t from) {
+        const AnimKey_t* keys = track.keys;
+        uint8_t i = 0;
+        while (i + 1 < track.keyCount && keys[i + 1].timeMs <= t) i++;
+
+        int32_t a = (keys[i].angle == ANIM_FROM_CURRENT ? from : keys[i].angle) * 4;
+        if (i + 1 >= track.keyCount || t <= keys[i].timeMs) return a;
+
+        const AnimKey_t& next = keys[i + 1];
+        int32_t b = (next.angle == ANIM_FROM_CURRENT ? from : next.angle) * 4;
+        int32_t span = next.timeMs - keys[i].timeMs;
+        int32_t x = (int32_t)((t - keys[i].timeMs) * ANIM_WEIGHT_ONE / span);
+        return a + (((b - a) * ease(next.ease, x)) >> 8);
+    }
+
+    void updateActiveMask() {
+        uint16_t mask = 0;
+        for (uint8_t layer = 0; layer < ANIM_LAYERS; layer++) {
+            const AnimClip_t* clip = _layers[layer].clip;
+            if (clip == nullptr) continue;
+            for (uint8_t i = 0; i < clip->trackCount; i++) {
+                if (clip->tracks[i].channel < ANIM_CHANNELS) mask |= (uint16_t)(1u << clip->tracks[i].channel);
+            }
+        }
+        _activeMask = mask;
+    }
+
+    Layer_t _layers[ANIM_LAYERS];
+    uint8_t _lastOut[ANIM_CHANNELS];
+    uint16_t _drivenPrev = 0;
+    uint16_t _activeMask = 0;
+};
+
+#endif // COROSUKE_ANIMATION_H
@@ -0,0 +1,206 @@
+/**
+ * コロ助ロボット - バランス制御（ピッチ・ロール）
+ * Corosuke Robot - Balance Controller
+ *
+ * 姿勢（度）から足首・股関節・膝への補正角を求める。補正は歩容や直立姿勢の
+ * 目標角（フィードフォワード）には書き込まず、サーボへ出すときに上乗せする。
+ *
+ * - 実際の経過時間 dt で積分・微分する（制御周期がずれてもゲインの意味が変わらない）
+ * - 微分は測定値の変化から取り（目標を変えたときに跳ねない）、1次ローパスを通す
+ * - 出力が上限に張り付いている間は、さらに張り付く向きには積分しない（ワインドアップ防止）
+ * - ピッチ: 両足首と両股関節を同じ向きに
+ * - ロール: 脚はピッチ軸しかないので、片脚を曲げて（膝 + 足首で足裏は水平のまま）
+ *   左右の脚の長さを変えて傾きを戻す
+ * - ゲインは CMD_BALANCE_GAINS で実行中に変えられる
+ */
+
+#ifndef COROSUKE_BALANCE_CONTROLLER_H
+#define COROSUKE_BALANCE_CONTROLLER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "protocol.h"
+
+#define BALANCE_MAX_DT_US   100000      // これより空いたら（起動直後・停止明け）積分・微分しない
+
+typedef struct {
+    float kp;               // 度 / 度
+    float ki;               // 度 / (度・秒)
+    float kd;               // 度 / (度/秒)
+    float dCutoffHz;        // 微分のローパス
+    float limitDeg;         // 補正の上限
+    bool enabled;
+} BalanceGains_t;
+
+typedef struct {
+    float error;
+    float p;
+    float i;
+    float d;                // 測定値の微分（ローパス後、度/秒。D 項は kd 倍）
+    float output;           // 補正角（度）
+    uint32_t saturated;     // 出力が上限に張り付いた周期数
+} BalanceAxisState_t;
+
+// =============================================================================
+// 1軸分の PID
+// =============================================================================
+class BalanceAxis {
+public:
+    BalanceAxis() : _state{} {
+        memset(&_gains, 0, sizeof(_gains));
+        reset();
+    }
+
+    void setGains(const BalanceGains_t& gains) {
+        _gains = gains;
+        if (!_gains.enabled) reset();
+    }
+
+    const BalanceGains_t& gains() const { return _gains; }
+    const BalanceAxisState_t& state() const { return _state; }
+
+    // 積分と微分を捨てる（saturated は起動からの回数なので残す）
+    void reset() {
+        _state.error = 0.0f;
+        _state.p = 0.0f;
+        _state.i = 0.0f;
+        _state.d = 0.0f;
+        _state.output = 0.0f;
+        _hasPrevious = false;
+    }
+
+    float update(float setpointDeg, float measuredDeg, uint32_t dtUs) {
+        if (!_gains.enabled) return 0.0f;
+
+        float error = setpointDeg - measuredDeg;
+        bool valid = _hasPrevious && dtUs > 0 && dtUs <= BALANCE_MAX_DT_US;
+        float dt = dtUs * 1e-6f;
+
+        if (valid) {
+            // 測定値の微分（目標の変化では跳ねない）をローパスに通す
+            float raw = -(measuredDeg - _previous) / dt;
+            float tau = 1.0f / (2.0f * (float)M_PI * _gains.dCutoffHz);
+            _state.d += (dt / (tau + dt)) * (raw - _state.d);
+        } else {
+            _state.d = 0.0f;
+        }
+        _previous = measuredDeg;
+        _hasPrevious = true;
+
+        float p = _gains.kp * error;
+        float d = _gains.kd * _state.d;
+        float integral = _state.i;
+        if (valid) {
+            float candidate = integral + _gains.ki * error * dt;
+            float unsaturated = p + candidate + d;
+            // 張り付いている向きにはそれ以上積分しない
+            bool windingUp = fabsf(unsaturated) > _gains.limitDeg && (unsaturated > 0.0f) == (error > 0.0f);
+            if (!windingUp) integral = candidate;
+        }
+        integral = clamp(integral, _gains.limitDeg);
+
+        float output = p + integral + d;
+        if (fabsf(output) > _gains.limitDeg) _state.saturated++;
+        output = clamp(output, _gains.limitDeg);
+
+        _state.error = error;
+        _state.p = p;
+        _state.i = integral;
+        _state.output = output;
+        return output;
+    }
+
+private:
+    static float clamp(float v, float limit) {
+        return v > limit ? limit : (v < -limit ? -limit : v);
+    }
+
+    BalanceGains_t _gains;
+    BalanceAxisState_t _state;
+    float _previous = 0.0f;
+    bool _hasPrevious = false;
+};
+
+// =============================================================================
+// ピッチ・ロールの補正を下半身の関節へ振り分ける
+// =============================================================================
+typedef enum {
+    BALANCE_AXIS_PITCH = 0,
+    BALANCE_AXIS_ROLL = 1,
+    BALANCE_AXES
+} BalanceAxisId_t;
+
+class BalanceController {
+public:
+    BalanceController() {
+        BalanceGains_t pitch = {BALANCE_KP, BALANCE_KI, BALANCE_KD, BALANCE_D_CUTOFF_HZ, BALANCE_LIMIT_DEG, true};
+        BalanceGains_t roll = pitch;
+        _axes[BALANCE_AXIS_PITCH].setGains(pitch);
+        _axes[BALANCE_AXIS_ROLL].setGains(roll);
+        _setpoint[0] = _setpoint[1] = 0.0f;
+    }
+
+    void setGains(uint8_t axis, const BalanceGains_t& gains) {
+        if (axis < BALANCE_AXES) _axes[axis].setGains(gains);
+    }
+
+    // CMD_BALANCE_GAINS のデータから（長さが足りなければ false）
+    bool setGains(const uint8_t* data, uint8_t length) {
+        if (length < sizeof(BalanceGainsData_t)) return false;
+        BalanceGainsData_t msg;
+        memcpy(&msg, data, sizeof(msg));
+        if (msg.axis >= BALANCE_AXES) return false;
+        BalanceGains_t gains;
+        gains.kp = msg.kp_milli / 1000.0f;
+        gains.ki = msg.ki_milli / 1000.0f;
+        gains.kd = msg.kd_milli / 1000.0f;
+        gains.dCutoffHz = msg.d_cutoff_dhz > 0 ? msg.d_cutoff_dhz / 10.0f : BALANCE_D_CUTOFF_HZ;
+        gains.limitDeg = msg.limit_ddeg / 10.0f;
+        gains.enabled = msg.enabled != 0;
+        setGains(msg.axis, gains);
+        return true;
+    }
+
+    const BalanceAxis& axis(uint8_t axis) const { return _axes[axis]; }
+
+    // 歩き方によって前傾させたいときなど
+    void setSetpoint(uint8_t axis, float deg) {
+        if (axis < BALANCE_AXES) _setpoint[axis] = deg;
+    }
+
+    void reset() {
+        _axes[BALANCE_AXIS_PITCH].reset();
+        _axes[BALANCE_AXIS_ROLL].reset();
+    }
+
+    void update(float pitchDeg, float rollDeg, uint32_t dtUs) {
+        _axes[BALANCE_AXIS_PITCH].update(_setpoint[BALANCE_AXIS_PITCH], pitchDeg, dtUs);
+        _axes[BALANCE_AXIS_ROLL].update(_setpoint[BALANCE_AXIS_ROLL], rollDeg, dtUs);
+    }
+
+    // 下半身の各チャンネルへの補正角（度）。歩容の目標角に足して使う
+    void offsets(float* offsets) const {
+        float pitch = _axes[BALANCE_AXIS_PITCH].state().output;
+        float roll = _axes[BALANCE_AXIS_ROLL].state().output;
+
+        // ロールが正（右が下がった）なら補正は負 → 右脚を伸ばし左脚を曲げる
+        float rightBend = roll * BALANCE_ROLL_BEND_GAIN;
+        float leftBend = -rightBend;
+
+        offsets[SERVO_LEG_RIGHT_ANKLE] = pitch * BALANCE_PITCH_ANKLE_GAIN - rightBend * 0.5f;
+        offsets[SERVO_LEG_LEFT_ANKLE] = pitch * BALANCE_PITCH_ANKLE_GAIN - leftBend * 0.5f;
+        offsets[SERVO_LEG_RIGHT_HIP_PITCH] = pitch * BALANCE_PITCH_HIP_GAIN;
+        offsets[SERVO_LEG_LEFT_HIP_PITCH] = pitch * BALANCE_PITCH_HIP_GAIN;
+        offsets[SERVO_LEG_RIGHT_KNEE] = rightBend;
+        offsets[SERVO_LEG_LEFT_KNEE] = leftBend;
+    }
+
+private:
+    BalanceAxis _axes[BALANCE_AXES];
+    float _setpoint[BALANCE_AXES];
+};
+
+#endif // COROSUKE_BALANCE_CONTROLLER_H
@@ -31,6 +31,12 @@
 #define I2C_ADDR_BNO055        0x28  // IMU
 #define I2C_ADDR_MPU6050       0x68  // バックアップIMU
 
+// I2Cバス
+#define I2C_SDA_PIN         21
+#define I2C_SCL_PIN         22
+#define I2C_CLOCK_UPPER_HZ  1000000   // Fast-mode Plus（PCA9685のみ、プルアップ 2.2kΩ 以下）
+#define I2C_CLOCK_LOWER_HZ  400000    // Fast-mode（BNO055 が 400kHz まで）
+
 // =============================================================================
 // サーボチャンネル割り当て - 上半身 (PCA9685 #1)
 // =============================================================================
@@ -73,12 +79,36 @@
 #define SERVO_LEG_LEFT_KNEE        7   // 左膝
 #define SERVO_LEG_LEFT_ANKLE       8   // 左足首
 
+// 脚の寸法（hardware/3d_models/legs/leg.scad、mm）
+#define LEG_THIGH_MM          60.0f   // 股関節ピッチ軸 → 膝軸 (thigh_length)
+#define LEG_SHIN_MM           55.0f   // 膝軸 → 足首軸 (shin_length)
+#define LEG_ANKLE_HEIGHT_MM   27.5f   // 足首軸 → 足裏 (foot_height + 7.5)
+#define LEG_FOOT_LENGTH_MM    70.0f   // foot_length
+
+// 関節角（leg_ik.h、0 = 脚をまっすぐ伸ばした直立）→ サーボ角の向き
+#define LEG_HIP_YAW_DIR       1       // 正: つま先が左へ
+#define LEG_HIP_PITCH_DIR     1       // 正: 脚を前へ振る
+#define LEG_KNEE_DIR          1       // 正: 膝を曲げる
+#define LEG_ANKLE_DIR         (-1)    // 正: つま先を上げる（サーボは逆向き。膝を曲げると足首はマイナス、従来の歩容と同じ）
+
 // =============================================================================
 // サーボ角度制限
 // =============================================================================
 #define SERVO_MIN_PULSE     500   // 最小パルス幅 (μs)
 #define SERVO_MAX_PULSE     2500  // 最大パルス幅 (μs)
 #define SERVO_CENTER_ANGLE  90    // 中心角度
+#define SERVO_PWM_HZ        50    // サーボ PWM 周期 (20ms)
+
+// PCA9685 の内部発振器（公称 25MHz、個体差で数 % ずれる）。
+// 出力周期をオシロスコープなどで測り、50Hz からのずれに合わせて較正する（ボードごとに -D で上書き可）
+#ifndef PCA9685_OSC_HZ
+#define PCA9685_OSC_HZ      25000000
+#endif
+
+// 関節ごとのトリム（0.1 度単位、チャンネル 0〜15 の順）。ホーンの取り付けずれを較正する。
+// 可動範囲の端がパルス幅の範囲を出るとコンパイルエラー（joint_table.h）なので、0〜180 度の関節は範囲も狭める
+#define SERVO_TRIM_UPPER    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define SERVO_TRIM_LOWER    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 
 // 目の可動範囲
 #define EYE_H_MIN   60
@@ -87,10 +117,12 @@
 #define EYE_V_MAX   110
 #define EYELID_OPEN   30
 #define EYELID_CLOSE  120
+#define EYELID_WIDE   (EYELID_OPEN - 10)    // 見開き（驚き）
 
 // 口の可動範囲
 #define MOUTH_CLOSED  90
 #define MOUTH_OPEN    120
+#define MOUTH_UPPER_OPEN  (MOUTH_CLOSED - (MOUTH_OPEN - MOUTH_CLOSED) / 3)   // 上あごは下の 1/3 だけ逆へ
 
 // 首の可動範囲
 #define NECK_YAW_MIN    45
@@ -98,6 +130,49 @@
 #define NECK_PITCH_MIN  70
 #define NECK_PITCH_MAX  110
 
+// 足首の可動範囲（足裏が床や脛に当たらない）
+#define LEG_ANKLE_MIN   60
+#define LEG_ANKLE_MAX   120
+
+// 速度・加速度の上限（trajectory.h、度/秒・度/秒²）
+#define TRAJ_EYE_MAX_VEL        600.0f      // 目（サッカードに近い速さ）
+#define TRAJ_EYE_MAX_ACC        30000.0f
+#define TRAJ_EYELID_MAX_VEL     1500.0f     // まぶた（まばたきで約 0.1 秒で閉じる）
+#define TRAJ_EYELID_MAX_ACC     60000.0f
+#define TRAJ_MOUTH_MAX_VEL      600.0f      // 口（リップシンクに遅れない）
+#define TRAJ_MOUTH_MAX_ACC      40000.0f
+#define TRAJ_NECK_MAX_VEL       180.0f
+#define TRAJ_NECK_MAX_ACC       1500.0f
+#define TRAJ_ARM_MAX_VEL        240.0f
+#define TRAJ_ARM_MAX_ACC        2400.0f
+#define TRAJ_LEG_MAX_VEL        300.0f      // 歩容はこの範囲で目標に追従する
+#define TRAJ_LEG_MAX_ACC        6000.0f
+
+// 移動時間
+#define EXPRESSION_MOVE_MS      300         // 表情を切り替える時間
+#define EXPRESSION_FADE_OUT_MS  500         // 一時的な表情から基本の表情へ戻る時間
+#define EXPRESSION_BLINK_MS     60          // まばたきでまぶたを閉じる・開ける時間
+#define EXPRESSION_SPEECH_RELEASE_MS 120    // 話し終えて口を表情の形へ戻す時間
+#define POSE_MOVE_MS            800         // 直立・座るへ移る時間（下半身）
+#define GAIT_ENGAGE_MS          300         // 歩き出し・歩容の切り替えで歩容の姿勢へ移る時間
+
+// 視線（gaze_controller.h、度・度/秒）
+#define GAZE_SACCADE_DEG            4.0f    // これより離れた目標へは目を一気に飛ばす
+#define GAZE_NEW_TARGET_DEG         10.0f   // 予測からこれだけ外れたサンプルは別の目標（速度の推定をやり直す）
+#define GAZE_PURSUIT_GAIN           15.0f   // 追従の位置ゲイン（1/秒）
+#define GAZE_PURSUIT_MAX_VEL        60.0f   // 滑らかに追える目標の速さ
+#define GAZE_LEAD_MS                40      // サーボの遅れの分だけ先を見る
+#define GAZE_PREDICT_MAX_MS         200     // 最後のサンプルから先読みする上限
+#define GAZE_SAMPLE_WINDOW_MS       600     // 速度の推定に使うサンプルの古さ（超えたら止まった目標）
+#define GAZE_EYE_COMFORT_YAW_DEG    10.0f   // 首を動かさずに目だけで見る範囲
+#define GAZE_EYE_COMFORT_PITCH_DEG  6.0f
+#define GAZE_NECK_FOLLOW_VEL        5.0f    // 目標がこれより速く動いていたら首も追う
+#define GAZE_NECK_GAIN              4.0f    // 首を向ける速さ（残りの角度に対して 1/秒）
+#define GAZE_NECK_MAX_VEL           90.0f   // 軌道の上限（TRAJ_NECK_*）より低くして遅れないようにする
+#define GAZE_NECK_MAX_ACC           600.0f
+#define GAZE_CAMERA_FOV_H_DEG       60.0f   // メインボードのカメラの画角（CMD_FACE_POSITION の換算）
+#define GAZE_CAMERA_FOV_V_DEG       45.0f
+
 // =============================================================================
 // LEDリング設定
 // =============================================================================
@@ -105,6 +180,7 @@
 #define LED_EYE_LEFT_PIN    19
 #define LED_EYE_NUM_LEDS    12
 #define LED_BRIGHTNESS      50
+#define LED_FRAME_MS        20    // 目のLEDを描き直す周期（変わったときだけ出力）
 
 // =============================================================================
 // オーディオ設定
@@ -118,10 +194,34 @@
 #define MIC_SCK_PIN     8
 #define MIC_SD_PIN      9
 
+// マイク（INMP441、スピーカーとは別の I2S1 で取り込む）
+#define MIC_SAMPLE_RATE     16000
+#define MIC_SAMPLE_SHIFT    14      // 32bit スロットの 24bit 値 → 16bit
+#define MIC_FRAME_MS        20      // 声の判定単位（DMA から1回に読む長さ）
+#define MIC_CHUNK_FRAMES    3       // 1メッセージに詰めるフレーム数（60ms = ADPCM で 480 バイト）
+#define MIC_PREROLL_FRAMES  8       // 発話と判定する前から送る分（語頭を切らない）
+
+// 声の区間の検出（voice_activity.h）
+#define VAD_ENERGY_RATIO    6       // 雑音の底（平均二乗）の何倍で声らしいとみなすか（約 8dB）
+#define VAD_MIN_RMS         150     // 静かな部屋でもこれより小さい音は声としない
+#define VAD_ZCR_MAX_PERCENT 35      // ゼロ交差率がこれより高い音（サーッという雑音）は声としない
+#define VAD_ONSET_FRAMES    3       // 声らしいフレームがこれだけ続いたら発話開始（ノックなどを除く）
+#define VAD_HANGOVER_MS     400     // 声らしくないフレームがこれだけ続いたら発話終了
+#define VAD_MAX_SEGMENT_MS  10000   // これより長い区間は一度区切る
+
 // =============================================================================
 // UART設定 (ESP32間通信)
 // =============================================================================
-#define UART_BAUD_RATE  115200
+#define UART_BAUD_RATE  115200      // 起動時・交渉できないときのボーレート
+
+// 起動後に link_speed.h で交渉して上げる上限（配線の長さで決める）
+#define UART_MAIN_BAUD_MAX      4000000     // メイン ↔ 上半身（頭の中の短い配線）
+#define UART_LOWER_BAUD_MAX     2000000     // 上半身 ↔ 下半身（胴体を通る配線）
+
+// UART ドライバのリングバッファ（begin() より前に設定する）
+// 4Mbaud では 1ms に 400 バイト届くので、loop() が 10ms 止まっても溢れない大きさにする
+#define UART_RX_BUFFER_SIZE     4096
+#define UART_TX_BUFFER_SIZE     2048        // 0 だと write() が FIFO の空きを待って止まる
 
 // メイン ↔ 上半身
 #define UART_MAIN_TX    1
@@ -138,12 +238,32 @@
 #define IMU_UPDATE_INTERVAL_MS      10   // IMU更新間隔 (100Hz)
 #define EXPRESSION_UPDATE_MS        50   // 表情更新間隔
 #define WALKING_CYCLE_MS           1000  // 歩行1サイクル時間
+#define SERVO_BUS_REPORT_MS       10000  // サーボI2Cバス時間の報告間隔
+#define SENSOR_REPORT_INTERVAL_MS    50  // 下半身 → メインの IMU データ間隔 (20Hz)
+
+// loop() の周期ジョブ（scheduler.h）
+#define UART_POLL_MS                 1   // UART受信を見に行く周期
+#define UART_POLL_DEADLINE_MS        8   // 4Mbaud でこれ以上空くと UART_RX_BUFFER_SIZE が溢れかける
+#define SERVO_TICK_DEADLINE_MS      10   // サーボ更新は予定時刻から半周期までに書き終える
+
+// =============================================================================
+// IMU 姿勢推定（imu_fusion.h / imu_sensor.h）
+// =============================================================================
+#define IMU_FUSION_KP            1.0f   // 加速度による補正の強さ (rad/s)
+#define IMU_FUSION_KI            0.02f  // ジャイロのバイアス推定
+#define IMU_ACCEL_GATE_PERCENT   20     // 1G からこれ以上ずれた加速度は使わない
+#define IMU_MPU6050_RATE_DIV     2      // MPU6050 のサンプル周期 1kHz / (1 + 2) = 333Hz
 
 // =============================================================================
-// バランス制御 PIDゲイン
+// バランス制御 PIDゲイン（balance_controller.h、時間で割った単位）
 // =============================================================================
-#define BALANCE_KP  2.0f
-#define BALANCE_KI  0.1f
-#define BALANCE_KD  0.5f
+#define BALANCE_KP  1.0f                // 度 / 度
+#define BALANCE_KI  3.0f                // 度 / (度・秒)
+#define BALANCE_KD  0.03f               // 度 / (度/秒)
+#define BALANCE_D_CUTOFF_HZ      10.0f  // 微分のローパス
+#define BALANCE_LIMIT_DEG        15.0f  // 補正の上限
+#define BALANCE_PITCH_ANKLE_GAIN 0.5f   // ピッチ補正のうち足首に入れる割合
+#define BALANCE_PITCH_HIP_GAIN   0.2f   // 同じく股関節
+#define BALANCE_ROLL_BEND_GAIN   1.0f   // ロール補正 → 膝を曲げる角度
 
 #endif // COROSUKE_CONFIG_H
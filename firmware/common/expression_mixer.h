@@ -0,0 +1,296 @@
+/**
+ * コロ助ロボット - 表情ミキサー
+ * Corosuke Robot - Layered Expression Blending
+ *
+ * 表情ごとの顔のポーズ（視線・まぶた・口・首ピッチ・LED の色）を表にしておき、
+ * レイヤーを重みで重ねて毎 tick の顔を決める。switch で関節ごとに角度を書く代わりに、
+ * 表の 1 行を足せば表情が増える。
+ *
+ * - レイヤーは下から 基本の表情 / 一時的な表情 / 発話の口 / まばたき。
+ *   上のレイヤーは自分の受け持つ項目だけを、重み (Q8) で下の結果と混ぜる
+ * - ポーズは 1/16 単位の固定小数点、混ぜるのは整数の積和だけ
+ * - 一時的な表情は duration_ms が過ぎたらフェードアウトして基本の表情へ戻る。
+ *   サーバーはコマンドを 1 つ送るだけで、戻すところまでこちらで動かす
+ * - intensity (0-100): 基本の表情は無表情からのずれを、一時的な表情は下へ混ぜる重みを縮める
+ * - レイヤーのポーズ・重みの切り替えは smoothstep でつなぐ（途中で変わっても今の値から）
+ * - 目と首ピッチは視線制御の出力（setGaze）に表情の分を足す
+ */
+
+#ifndef COROSUKE_EXPRESSION_MIXER_H
+#define COROSUKE_EXPRESSION_MIXER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "protocol.h"
+
+#define EXPR_FRAC_BITS      4                       // ポーズは 1/16 単位
+#define EXPR_ONE            (1 << EXPR_FRAC_BITS)
+#define EXPR_WEIGHT_ONE     256                     // 重み 1.0 (Q8)
+
+// ポーズの項目
+#define EXPR_FIELD_EYE_X    0       // 視線のずれ（-50〜50 で目の可動範囲の端から端、視線制御の目に足す）
+#define EXPR_FIELD_EYE_Y    1
+#define EXPR_FIELD_EYELID   2       // まぶたのサーボ角
+#define EXPR_FIELD_MOUTH    3       // 口の開き（0-100）
+#define EXPR_FIELD_NECK     4       // 首ピッチ（度、正 = 上。視線制御の首に足す）
+#define EXPR_FIELD_RED      5       // LED の色
+#define EXPR_FIELD_GREEN    6
+#define EXPR_FIELD_BLUE     7
+#define EXPR_FIELDS         8
+
+#define EXPR_MASK_EYELID    (1u << EXPR_FIELD_EYELID)
+#define EXPR_MASK_MOUTH     (1u << EXPR_FIELD_MOUTH)
+#define EXPR_MASK_ALL       ((1u << EXPR_FIELDS) - 1)
+
+// レイヤー（番号の小さい順に重ねる）
+#define EXPR_LAYER_MOOD     0       // 基本の表情（重みは常に 1）
+#define EXPR_LAYER_REACTION 1       // 一時的な表情
+#define EXPR_LAYER_SPEECH   2       // 発話の口
+#define EXPR_LAYER_BLINK    3       // まばたき
+#define EXPR_LAYERS         4
+
+// 表情のポーズ（1 行 8 バイト）
+typedef struct {
+    int8_t eyeX;
+    int8_t eyeY;
+    uint8_t eyelid;
+    uint8_t mouth;
+    int8_t neck;
+    uint8_t red, green, blue;
+} ExpressionPose_t;
+
+static const ExpressionPose_t EXPRESSION_POSES[EXPR_COUNT] = {
+    //  目 x   y   まぶた              口   首   色
+    {   0,   0, EYELID_OPEN,        0,   0, 200, 200, 200},    // EXPR_NEUTRAL
+    {   0,  10, EYELID_OPEN + 20,  30,   3, 255, 200, 100},    // EXPR_HAPPY     まぶたを少し下げて笑顔に
+    {   0, -20, EYELID_OPEN + 30,  10,  -8, 100, 100, 255},    // EXPR_SAD       うつむく
+    {   0,  20, EYELID_WIDE,       80,   5, 200, 200, 200},    // EXPR_SURPRISED 見開いて顔を上げる
+    {   0, -10, EYELID_OPEN + 40,  20,  -3, 255,  50,  50},    // EXPR_ANGRY     まぶたを下げて怒り顔
+    {   0, -30, EYELID_OPEN + 50,  10, -10, 200, 200, 200},    // EXPR_SLEEPY
+    {  30,  20, EYELID_OPEN,        5,   4, 200, 200, 200},    // EXPR_THINKING  右上を見る
+    {   0,  15, EYELID_OPEN,       50,   5, 255, 200, 100},    // EXPR_EXCITED
+};
+
+// 顔の出力（サーボ角は度、両目は同じ向き）
+typedef struct {
+    float eyeH;
+    float eyeV;
+    float eyelid;
+    float mouthUpper;
+    float mouthLower;
+    float neckPitch;
+    uint8_t red, green, blue;
+} ExpressionOutput_t;
+
+class ExpressionMixer {
+public:
+    void begin(uint32_t nowMs) {
+        memset(_layers, 0, sizeof(_layers));
+        _layers[EXPR_LAYER_MOOD].mask = EXPR_MASK_ALL;
+        _layers[EXPR_LAYER_REACTION].mask = EXPR_MASK_ALL;
+        _layers[EXPR_LAYER_SPEECH].mask = EXPR_MASK_MOUTH;
+        _layers[EXPR_LAYER_BLINK].mask = EXPR_MASK_EYELID;
+
+        int16_t pose[EXPR_FIELDS];
+        loadPose(EXPR_NEUTRAL, 100, pose);
+        memcpy(_layers[EXPR_LAYER_MOOD].from, pose, sizeof(pose));
+        memcpy(_layers[EXPR_LAYER_MOOD].to, pose, sizeof(pose));
+        _layers[EXPR_LAYER_MOOD].poseStartMs = nowMs;
+        _mood = _reaction = EXPR_NEUTRAL;
+        _gazeH = _gazeV = _gazeNeckPitch = 0.0f;
+    }
+
+    // 基本の表情（一時的な表情が出ていたら終わらせる）
+    void setMood(Expression_t expr, uint8_t intensity, uint32_t nowMs) {
+        if (expr >= EXPR_COUNT) return;
+        int16_t pose[EXPR_FIELDS];
+        loadPose(expr, intensity, pose);
+        setPose(_layers[EXPR_LAYER_MOOD], pose, nowMs, EXPRESSION_MOVE_MS);
+        _mood = expr;
+        Layer_t& reaction = _layers[EXPR_LAYER_REACTION];
+        if (reaction.active) fade(reaction, 0, nowMs, EXPRESSION_MOVE_MS, 0, 0);
+    }
+
+    // 一時的な表情（durationMs 後に基本の表情へ戻る）
+    void react(Expression_t expr, uint8_t intensity, uint16_t durationMs, uint32_t nowMs) {
+        if (expr >= EXPR_COUNT) return;
+        Layer_t& reaction = _layers[EXPR_LAYER_REACTION];
+        int16_t pose[EXPR_FIELDS];
+        loadPose(expr, 100, pose);
+        // 出ていなければ重み 0 から始まるので、ポーズは切り替えるだけでいい
+        setPose(reaction, pose, nowMs, reaction.active ? EXPRESSION_MOVE_MS : 0);
+        uint16_t peak = (uint16_t)((intensity > 100 ? 100 : intensity) * EXPR_WEIGHT_ONE / 100);
+        fade(reaction, peak, nowMs, EXPRESSION_MOVE_MS, durationMs, EXPRESSION_FADE_OUT_MS);
+        _reaction = expr;
+    }
+
+    // 発話の口（0-100）。stopSpeech() まで表情の口より優先
+    void setSpeech(uint8_t amount, uint32_t nowMs) {
+        int16_t pose[EXPR_FIELDS] = {0};
+        pose[EXPR_FIELD_MOUTH] = (int16_t)((amount > 100 ? 100 : amount) * EXPR_ONE);
+        Layer_t& speech = _layers[EXPR_LAYER_SPEECH];
+        setPose(speech, pose, nowMs, 0);
+        if (!speech.active || speech.weightPeak != EXPR_WEIGHT_ONE) fade(speech, EXPR_WEIGHT_ONE, nowMs, 0, 0, 0);
+    }
+
+    void stopSpeech(uint32_t nowMs) {
+        Layer_t& speech = _layers[EXPR_LAYER_SPEECH];
+        if (speech.active) fade(speech, 0, nowMs, EXPRESSION_SPEECH_RELEASE_MS, 0, 0);
+    }
+
+    // まばたき（閉じている間は表情のまぶたより優先）
+    void setBlink(bool closed, uint32_t nowMs) {
+        Layer_t& blink = _layers[EXPR_LAYER_BLINK];
+        if (closed) {
+            int16_t pose[EXPR_FIELDS] = {0};
+            pose[EXPR_FIELD_EYELID] = EYELID_CLOSE * EXPR_ONE;
+            setPose(blink, pose, nowMs, 0);
+            fade(blink, EXPR_WEIGHT_ONE, nowMs, EXPRESSION_BLINK_MS, 0, 0);
+        } else if (blink.active) {
+            fade(blink, 0, nowMs, EXPRESSION_BLINK_MS, 0, 0);
+        }
+    }
+
+    // 視線制御の目・首ピッチ（中心からの度）
+    void setGaze(float eyeYaw, float eyePitch, float neckPitch) {
+        _gazeH = eyeYaw;
+        _gazeV = eyePitch;
+        _gazeNeckPitch = neckPitch;
+    }
+
+    // 今出ている表情（一時的な表情がフェードアウトし終わるまではそちら）
+    Expression_t expression() const {
+        return _layers[EXPR_LAYER_REACTION].active ? _reaction : _mood;
+    }
+
+    Expression_t mood() const { return _mood; }
+
+    // レイヤーを重ねて今の顔を出す
+    void evaluate(uint32_t nowMs, ExpressionOutput_t* out) {
+        int32_t acc[EXPR_FIELDS];
+        layerPose(_layers[EXPR_LAYER_MOOD], nowMs, acc);
+
+        for (uint8_t i = EXPR_LAYER_MOOD + 1; i < EXPR_LAYERS; i++) {
+            Layer_t& layer = _layers[i];
+            if (!layer.active) continue;
+            bool finished;
+            int32_t w = weight(layer, nowMs, &finished);
+            if (finished) layer.active = false;
+            if (w == 0) continue;
+            int32_t pose[EXPR_FIELDS];
+            layerPose(layer, nowMs, pose);
+            for (uint8_t f = 0; f < EXPR_FIELDS; f++) {
+                if (layer.mask & (1u << f)) acc[f] += ((pose[f] - acc[f]) * w) >> 8;
+            }
+        }
+
+        float eyeH = SERVO_CENTER_ANGLE + _gazeH + acc[EXPR_FIELD_EYE_X] * ((EYE_H_MAX - EYE_H_MIN) / (100.0f * EXPR_ONE));
+        float eyeV = SERVO_CENTER_ANGLE + _gazeV + acc[EXPR_FIELD_EYE_Y] * ((EYE_V_MAX - EYE_V_MIN) / (100.0f * EXPR_ONE));
+        out->eyeH = eyeH < EYE_H_MIN ? EYE_H_MIN : (eyeH > EYE_H_MAX ? EYE_H_MAX : eyeH);
+        out->eyeV = eyeV < EYE_V_MIN ? EYE_V_MIN : (eyeV > EYE_V_MAX ? EYE_V_MAX : eyeV);
+        out->eyelid = acc[EXPR_FIELD_EYELID] * (1.0f / EXPR_ONE);
+        out->mouthLower = MOUTH_CLOSED + acc[EXPR_FIELD_MOUTH] * ((MOUTH_OPEN - MOUTH_CLOSED) / (100.0f * EXPR_ONE));
+        out->mouthUpper = MOUTH_CLOSED - (out->mouthLower - MOUTH_CLOSED) / 3.0f;      // 上あごは下の 1/3 だけ逆へ
+        float neck = SERVO_CENTER_ANGLE + _gazeNeckPitch + acc[EXPR_FIELD_NECK] * (1.0f / EXPR_ONE);
+        out->neckPitch = neck < NECK_PITCH_MIN ? NECK_PITCH_MIN : (neck > NECK_PITCH_MAX ? NECK_PITCH_MAX : neck);
+        out->red = (uint8_t)((acc[EXPR_FIELD_RED] + EXPR_ONE / 2) >> EXPR_FRAC_BITS);
+        out->green = (uint8_t)((acc[EXPR_FIELD_GREEN] + EXPR_ONE / 2) >> EXPR_FRAC_BITS);
+        out->blue = (uint8_t)((acc[EXPR_FIELD_BLUE] + EXPR_ONE / 2) >> EXPR_FRAC_BITS);
+    }
+
+private:
+    typedef struct {
+        int16_t from[EXPR_FIELDS];  // 切り替え前のポーズ
+        int16_t to[EXPR_FIELDS];
+        uint32_t poseStartMs;
+        uint16_t poseMs;
+        uint16_t weightFrom;        // フェードを始めたときの重み
+        uint16_t weightPeak;
+        uint32_t fadeStartMs;
+        uint16_t fadeInMs;
+        uint16_t fadeOutMs;
+        uint16_t holdMs;            // フェードイン開始からフェードアウト開始まで（0 = ずっと）
+        uint8_t mask;               // 受け持つ項目
+        bool active;
+    } Layer_t;
+
+    // smoothstep (Q8)
+    static int32_t ease(int32_t x) {
+        return (x * x * (3 * EXPR_WEIGHT_ONE - 2 * x)) >> 16;
+    }
+
+    static int32_t progress(uint32_t elapsed, uint16_t spanMs) {
+        return elapsed >= spanMs ? EXPR_WEIGHT_ONE : ease((int32_t)(elapsed * EXPR_WEIGHT_ONE / spanMs));
+    }
+
+    // 表の 1 行を固定小数点に。intensity は無表情からのずれを縮める
+    static void loadPose(Expression_t expr, uint8_t intensity, int16_t* pose) {
+        const ExpressionPose_t& p = EXPRESSION_POSES[expr];
+        const ExpressionPose_t& n = EXPRESSION_POSES[EXPR_NEUTRAL];
+        const int16_t target[EXPR_FIELDS] = {p.eyeX, p.eyeY, p.eyelid, p.mouth, p.neck, p.red, p.green, p.blue};
+        const int16_t neutral[EXPR_FIELDS] = {n.eyeX, n.eyeY, n.eyelid, n.mouth, n.neck, n.red, n.green, n.blue};
+        int32_t scale = (intensity > 100 ? 100 : intensity) * EXPR_ONE;
+        for (uint8_t f = 0; f < EXPR_FIELDS; f++) {
+            pose[f] = (int16_t)(neutral[f] * EXPR_ONE + (target[f] - neutral[f]) * scale / 100);
+        }
+    }
+
+    static void layerPose(const Layer_t& layer, uint32_t nowMs, int32_t* pose) {
+        int32_t s = progress(nowMs - layer.poseStartMs, layer.poseMs);
+        for (uint8_t f = 0; f < EXPR_FIELDS; f++) {
+            pose[f] = layer.from[f] + (((layer.to[f] - layer.from[f]) * s) >> 8);
+        }
+    }
+
+    // 今のポーズから spanMs かけて pose へ
+    static void setPose(Layer_t& layer, const int16_t* pose, uint32_t nowMs, uint16_t spanMs) {
+        int32_t current[EXPR_FIELDS];
+        layerPose(layer, nowMs, current);
+        for (uint8_t f = 0; f < EXPR_FIELDS; f++) layer.from[f] = (int16_t)current[f];
+        memcpy(layer.to, pose, sizeof(layer.to));
+        layer.poseStartMs = nowMs;
+        layer.poseMs = spanMs;
+    }
+
+    static int32_t weight(const Layer_t& layer, uint32_t nowMs, bool* finished) {
+        *finished = false;
+        uint32_t elapsed = nowMs - layer.fadeStartMs;
+        if (elapsed < layer.fadeInMs) {
+            return layer.weightFrom + (((layer.weightPeak - layer.weightFrom) * progress(elapsed, layer.fadeInMs)) >> 8);
+        }
+        uint32_t holdEnd = layer.holdMs > layer.fadeInMs ? layer.holdMs : layer.fadeInMs;
+        if (layer.holdMs == 0 || elapsed < holdEnd) {
+            if (layer.weightPeak == 0) *finished = true;
+            return layer.weightPeak;
+        }
+        uint32_t out = elapsed - holdEnd;
+        if (out >= layer.fadeOutMs) {
+            *finished = true;
+            return 0;
+        }
+        return layer.weightPeak - ((layer.weightPeak * progress(out, layer.fadeOutMs)) >> 8);
+    }
+
+    // 今の重みから inMs かけて peak へ、holdMs で outMs かけて 0 へ
+    static void fade(Layer_t& layer, uint16_t peak, uint32_t nowMs, uint16_t inMs, uint16_t holdMs, uint16_t outMs) {
+        bool finished;
+        layer.weightFrom = (uint16_t)(layer.active ? weight(layer, nowMs, &finished) : 0);
+        layer.weightPeak = peak;
+        layer.fadeStartMs = nowMs;
+        layer.fadeInMs = inMs;
+        layer.holdMs = holdMs;
+        layer.fadeOutMs = outMs;
+        layer.active = true;
+    }
+
+    Layer_t _layers[EXPR_LAYERS];
+    Expression_t _mood = EXPR_NEUTRAL;
+    Expression_t _reaction = EXPR_NEUTRAL;
+    float _gazeH = 0.0f;
+    float _gazeV = 0.0f;
+    float _gazeNeckPitch = 0.0f;
+};
+
+#endif // COROSUKE_EXPRESSION_MIXER_H
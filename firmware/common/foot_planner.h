@@ -0,0 +1,109 @@
+/**
+ * コロ助ロボット - 足先軌道プランナー
+ * Corosuke Robot - Swing/Stance Foot Trajectory Planner
+ *
+ * 歩行の位相から両足の足裏の目標を作り、LegIk で関節角にする。
+ * 関節ごとの正弦波ではなく足裏の位置を決めるので、着いている足は水平のまま
+ * 一定の速さで後ろへ動き、股関節の高さも変わらない。
+ *
+ * - 位相は GaitEngine と同じ 32bit（1周 = 2^32）。左脚は半周ずらす
+ * - 1周のうち duty の割合が支持脚（0.5 を超えた分が両脚支持）、残りが遊脚
+ * - 遊脚は 5 次の最小躍度曲線で前へ、足上げは s³(1-s)³ の山（端で速度・加速度 0）
+ * - 旋回は支持脚のヨーを +turn/2 → -turn/2 と回し、遊脚で戻す
+ * - 1 tick あたり IK 2 回と多項式だけ（三角関数は IK のほかに腰の揺れで 1 回）
+ */
+
+#ifndef COROSUKE_FOOT_PLANNER_H
+#define COROSUKE_FOOT_PLANNER_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "protocol.h"
+#include "leg_ik.h"
+#include "gait_engine.h"
+
+// 歩容パラメータ（mm・度）
+typedef struct {
+    float hipHeight;        // 股関節ピッチ軸の高さ（足裏から。膝を少し曲げておく）
+    float stride;           // 1歩で足が前後に動く距離
+    float lift;             // 足を上げる高さ
+    float duty;             // 支持脚の割合 (0.5 〜 1)
+    float turnYaw;          // 旋回時に1歩で回すヨー
+    float waistSway;        // 腰の左右の揺れ
+} FootPlanParams_t;
+
+class FootPlanner {
+public:
+    void begin(const FootPlanParams_t& params) {
+        _params = params;
+        if (_params.duty < 0.5f) _params.duty = 0.5f;
+        if (_params.duty > 0.95f) _params.duty = 0.95f;
+        _unreachable = 0;
+    }
+
+    const FootPlanParams_t& params() const { return _params; }
+
+    // IK が届かなかった回数（歩幅・足上げが大きすぎる）
+    uint32_t unreachable() const { return _unreachable; }
+
+    // 1 本の脚の足裏の目標（legPhase: その脚の位相、0 = 着地した瞬間）
+    void foot(uint32_t legPhase, float stride, float turn, FootTarget_t* target) const {
+        float u = legPhase * (1.0f / 4294967296.0f);
+        float duty = _params.duty;
+
+        target->z = -_params.hipHeight;
+        target->pitchDeg = 0.0f;
+        if (u < duty) {
+            // 支持脚: 前端から後端へ等速
+            float s = u / duty;
+            target->x = stride * (0.5f - s);
+            target->yawDeg = turn * (0.5f - s);
+        } else {
+            // 遊脚: 後端から前端へ、途中で持ち上げる
+            float s = (u - duty) / (1.0f - duty);
+            float move = minJerk(s);
+            target->x = stride * (move - 0.5f);
+            target->yawDeg = turn * (move - 0.5f);
+            float t = s * (1.0f - s);
+            target->z += _params.lift * 64.0f * t * t * t;
+        }
+    }
+
+    // 現在の位相での下半身の目標角度を targets[0..8] に書く
+    void evaluate(WalkMode_t mode, uint8_t speed, uint32_t phase, float* targets) {
+        float stride = _params.stride * GAIT_BUCKET_STRIDE[GaitEngine::speedBucket(speed)];
+        if (mode == WALK_BACKWARD) stride = -stride;
+        float turn = 0.0f;
+        if (mode == WALK_TURN_LEFT) turn = _params.turnYaw;
+        else if (mode == WALK_TURN_RIGHT) turn = -_params.turnYaw;
+        // 横歩きは股関節ロールがないので前進と同じ（従来の歩容どおり）
+
+        FootTarget_t right, left;
+        foot(phase, stride, turn, &right);
+        foot(phase + 0x80000000u, stride, turn, &left);
+
+        LegAngles_t angles;
+        if (!LegIk::solve(right, &angles)) _unreachable++;
+        LegIk::toServo(angles, LEG_RIGHT_CHANNELS, targets);
+        if (!LegIk::solve(left, &angles)) _unreachable++;
+        LegIk::toServo(angles, LEG_LEFT_CHANNELS, targets);
+
+        // 腰を支持脚の側へ揺らす（右脚の遊脚の真ん中で +、左脚の遊脚の真ん中で -。従来の歩容と同じ向き）
+        uint32_t rightSwingMid = (uint32_t)((1.0f + _params.duty) * 0.5f * 4294967296.0f);
+        float sway = cosf((uint32_t)(phase - rightSwingMid) * (float)(2.0 * M_PI / 4294967296.0));
+        targets[SERVO_WAIST] = SERVO_CENTER_ANGLE + sway * _params.waistSway;
+    }
+
+private:
+    // 0 → 1 を速度・加速度 0 で結ぶ 5 次式
+    static float minJerk(float s) {
+        return s * s * s * (10.0f + s * (-15.0f + 6.0f * s));
+    }
+
+    FootPlanParams_t _params;
+    uint32_t _unreachable = 0;
+};
+
+#endif // COROSUKE_FOOT_PLANNER_H
@@ -0,0 +1,186 @@
+/**
+ * コロ助ロボット - テーブル駆動歩行エンジン
+ * Corosuke Robot - Table-Driven Gait Engine
+ *
+ * 歩行1サイクル分の関節軌道を、歩行モード × 速度バケットごとに
+ * 固定小数点テーブルとして起動時に作っておき、制御 tick では
+ * 位相でテーブルを引いて線形補間するだけにする（sin/cos なし、処理時間一定）。
+ *
+ * - 位相は 32bit 固定小数点（1周 = 2^32）で、桁あふれがそのまま周回になる
+ * - テーブル値は直立（90度）からのオフセット、0.25度単位の int8
+ * - CMD_GAIT_TABLE で別の歩容テーブルを書き換えられる（再書き込み不要）
+ * - 下半身は通常 FootPlanner（足先軌道 + 逆運動学）で歩き、CMD_GAIT_TABLE で
+ *   書き換えたモード・速度バケットだけこのテーブルを使う（customized()）
+ */
+
+#ifndef COROSUKE_GAIT_ENGINE_H
+#define COROSUKE_GAIT_ENGINE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "protocol.h"
+
+#define GAIT_SAMPLES_LOG2   6
+#define GAIT_SAMPLES        (1 << GAIT_SAMPLES_LOG2)    // 1サイクルのサンプル数
+#define GAIT_JOINTS         9                           // 腰 + 両脚 (下半身 ch0-8)
+#define GAIT_JOINT_MASK     ((1u << GAIT_JOINTS) - 1)
+#define GAIT_MODES          6                           // WALK_FORWARD 〜 WALK_TURN_RIGHT
+#define GAIT_SPEED_BUCKETS  3                           // 遅い / 普通 / 速い
+#define GAIT_UNITS_PER_DEG  4                           // テーブル値の分解能 (0.25度)
+
+// 1サイクル分の関節オフセット（サンプルごとに全関節を並べる）
+typedef struct {
+    int8_t offset[GAIT_SAMPLES][GAIT_JOINTS];
+} GaitTable_t;
+
+// テーブル生成用の歩容パラメータ（度）
+typedef struct {
+    float stepHeight;       // 足を上げる高さ
+    float stepLength;       // 歩幅
+    float swayAmount;       // 左右の揺れ
+    float turnYaw;          // 旋回時の股関節ヨー
+} GaitParams_t;
+
+// 速度バケットごとの歩幅倍率（普通 = 従来の歩容そのもの）
+static const float GAIT_BUCKET_STRIDE[GAIT_SPEED_BUCKETS] = {0.8f, 1.0f, 1.2f};
+
+class GaitEngine {
+public:
+    // 速度 (0-100) → バケット
+    static uint8_t speedBucket(uint8_t speed) {
+        return speed < 34 ? 0 : (speed < 67 ? 1 : 2);
+    }
+
+    // 1サイクル分のテーブルを作る（起動時・ホスト側ツール用）
+    static void buildTable(const GaitParams_t& params, WalkMode_t mode, GaitTable_t* table) {
+        float direction = (mode == WALK_BACKWARD) ? -1.0f : 1.0f;
+        float turn = 0.0f;
+        if (mode == WALK_TURN_LEFT) turn = params.turnYaw;
+        else if (mode == WALK_TURN_RIGHT) turn = -params.turnYaw;
+
+        for (int i = 0; i < GAIT_SAMPLES; i++) {
+            float phase = 2.0f * (float)M_PI * i / GAIT_SAMPLES;
+            float rightPhase = phase;
+            float leftPhase = phase + (float)M_PI;
+
+            float rightLift = fmaxf(0.0f, sinf(rightPhase)) * params.stepHeight;
+            float leftLift = fmaxf(0.0f, sinf(leftPhase)) * params.stepHeight;
+            float rightSwing = cosf(rightPhase) * params.stepLength;
+            float leftSwing = cosf(leftPhase) * params.stepLength;
+            float bodySway = sinf(phase) * params.swayAmount;
+
+            int8_t* row = table->offset[i];
+            row[SERVO_WAIST] = quantize(bodySway * 0.3f);
+            row[SERVO_LEG_RIGHT_HIP_YAW] = quantize(bodySway + turn);
+            row[SERVO_LEG_RIGHT_HIP_PITCH] = quantize(rightSwing * direction);
+            row[SERVO_LEG_RIGHT_KNEE] = quantize(rightLift);
+            row[SERVO_LEG_RIGHT_ANKLE] = quantize(-rightLift * 0.5f);
+            row[SERVO_LEG_LEFT_HIP_YAW] = quantize(-bodySway + turn);
+            row[SERVO_LEG_LEFT_HIP_PITCH] = quantize(leftSwing * direction);
+            row[SERVO_LEG_LEFT_KNEE] = quantize(leftLift);
+            row[SERVO_LEG_LEFT_ANKLE] = quantize(-leftLift * 0.5f);
+        }
+    }
+
+    // 全モード・全速度バケットのテーブルを作る
+    void begin(const GaitParams_t& params) {
+        for (int m = 0; m < GAIT_MODES; m++) {
+            for (int b = 0; b < GAIT_SPEED_BUCKETS; b++) {
+                GaitParams_t scaled = params;
+                scaled.stepLength *= GAIT_BUCKET_STRIDE[b];
+                buildTable(scaled, (WalkMode_t)(WALK_FORWARD + m), &_tables[m][b]);
+            }
+        }
+        _phase = 0;
+        _stagingValid = false;
+        _customized = 0;
+    }
+
+    void resetPhase() { _phase = 0; }
+    uint32_t phase() const { return _phase; }
+
+    // 位相を進める（phaseStep は速度 100 のときの1 tick あたりの増分）
+    void advance(uint8_t speed, uint32_t phaseStep) {
+        _phase += (phaseStep / 100) * speed;
+    }
+
+    // 現在の位相での目標角度を targets[0..GAIT_JOINTS-1] に書く
+    void evaluate(WalkMode_t mode, uint8_t speed, float* targets) const {
+        if (mode < WALK_FORWARD || mode > WALK_TURN_RIGHT) return;
+        const GaitTable_t& table = _tables[mode - WALK_FORWARD][speedBucket(speed)];
+
+        uint32_t index = _phase >> (32 - GAIT_SAMPLES_LOG2);
+        int32_t frac = (int32_t)((_phase >> (24 - GAIT_SAMPLES_LOG2)) & 0xFF);
+        const int8_t* a = table.offset[index];
+        const int8_t* b = table.offset[(index + 1) & (GAIT_SAMPLES - 1)];
+
+        for (int j = 0; j < GAIT_JOINTS; j++) {
+            int32_t v = a[j] * 256 + (b[j] - a[j]) * frac;
+            targets[j] = SERVO_CENTER_ANGLE + v * (1.0f / (256 * GAIT_UNITS_PER_DEG));
+        }
+    }
+
+    // CMD_GAIT_TABLE を受け取る。テーブル全体が揃ったら差し替えて true
+    bool loadChunk(const uint8_t* data, uint8_t length) {
+        if (length < sizeof(GaitTableChunk_t)) return false;
+        const GaitTableChunk_t* chunk = (const GaitTableChunk_t*)data;
+        size_t bytes = length - sizeof(GaitTableChunk_t);
+
+        if (chunk->mode < WALK_FORWARD || chunk->mode > WALK_TURN_RIGHT ||
+            chunk->speed_bucket >= GAIT_SPEED_BUCKETS ||
+            chunk->offset + bytes > sizeof(GaitTable_t)) {
+            _stagingValid = false;
+            return false;
+        }
+
+        // 先頭から順番に届いたときだけ受け付ける
+        if (chunk->offset == 0) {
+            _stagingMode = chunk->mode;
+            _stagingBucket = chunk->speed_bucket;
+            _stagingValid = true;
+        } else if (!_stagingValid || chunk->offset != _stagingBytes ||
+                   chunk->mode != _stagingMode || chunk->speed_bucket != _stagingBucket) {
+            _stagingValid = false;
+            return false;
+        }
+        memcpy((uint8_t*)&_staging + chunk->offset, data + sizeof(GaitTableChunk_t), bytes);
+        _stagingBytes = chunk->offset + bytes;
+
+        if (_stagingBytes < sizeof(GaitTable_t)) return false;
+        _tables[_stagingMode - WALK_FORWARD][_stagingBucket] = _staging;
+        _customized |= 1u << ((_stagingMode - WALK_FORWARD) * GAIT_SPEED_BUCKETS + _stagingBucket);
+        _stagingValid = false;
+        return true;
+    }
+
+    // CMD_GAIT_TABLE で書き換えたテーブルか
+    bool customized(WalkMode_t mode, uint8_t speed) const {
+        if (mode < WALK_FORWARD || mode > WALK_TURN_RIGHT) return false;
+        return (_customized >> ((mode - WALK_FORWARD) * GAIT_SPEED_BUCKETS + speedBucket(speed))) & 1u;
+    }
+
+    const GaitTable_t& table(WalkMode_t mode, uint8_t bucket) const {
+        return _tables[mode - WALK_FORWARD][bucket];
+    }
+
+private:
+    static int8_t quantize(float degrees) {
+        float q = roundf(degrees * GAIT_UNITS_PER_DEG);
+        return (int8_t)(q > 127.0f ? 127.0f : (q < -128.0f ? -128.0f : q));
+    }
+
+    GaitTable_t _tables[GAIT_MODES][GAIT_SPEED_BUCKETS];
+    uint32_t _phase = 0;
+    uint32_t _customized = 0;       // モード × バケットごとのビット
+
+    GaitTable_t _staging;
+    size_t _stagingBytes = 0;
+    uint8_t _stagingMode = 0;
+    uint8_t _stagingBucket = 0;
+    bool _stagingValid = false;
+};
+
+#endif // COROSUKE_GAIT_ENGINE_H
@@ -0,0 +1,221 @@
+/**
+ * コロ助ロボット - 視線制御（目と首の協調）
+ * Corosuke Robot - Coordinated Eye-Neck Gaze Controller
+ *
+ * 体から見た注視点の向き（ヨー・ピッチ、度）を受け取り、サーボ更新 tick ごとに
+ * 速い目と遅い首へ振り分ける。目の可動範囲の外も首を回して見られる。
+ *
+ * - 目標の向きは直近 GAZE_SAMPLES 個のサンプルから最小二乗で速度を求め、少し先を予測する
+ *   （カメラの顔位置のような飛び飛びの流れでも、コマンドごとにカクカクしない）
+ * - 予測した向きと今の視線の差が GAZE_SACCADE_DEG を超えたらサッカード（目が一気に飛ぶ）、
+ *   それ以内なら速度のフィードフォワード付きで滑らかに追う（スムーズパーシュート）
+ * - 首は目標が目の楽な範囲を出たとき・目標が動いているときだけ、速度・加速度を抑えて向ける。
+ *   目は「視線 - 首」で首の動きを打ち消す（前庭動眼反射）ので、首が回る間も視線は動かない
+ * - 予測から大きく外れたサンプルは新しい目標とみなし、それまでのサンプルを捨てる
+ * - 角度は中心からの度（ヨー: 正 = 右、ピッチ: 正 = 上）
+ */
+
+#ifndef COROSUKE_GAZE_CONTROLLER_H
+#define COROSUKE_GAZE_CONTROLLER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+
+#define GAZE_YAW            0
+#define GAZE_PITCH          1
+#define GAZE_AXES           2
+#define GAZE_SAMPLES        4       // 速度の推定に使う直近のサンプル数
+
+// 目と首を合わせて向ける範囲（中心から片側、度）
+#define GAZE_YAW_RANGE      ((EYE_H_MAX - EYE_H_MIN) / 2 + (NECK_YAW_MAX - NECK_YAW_MIN) / 2)
+#define GAZE_PITCH_RANGE    ((EYE_V_MAX - EYE_V_MIN) / 2 + (NECK_PITCH_MAX - NECK_PITCH_MIN) / 2)
+
+typedef struct {
+    float eyeYaw;           // 目（中心からの度）
+    float eyePitch;
+    float neckYaw;          // 首（中心からの度）
+    float neckPitch;
+} GazeOutput_t;
+
+typedef struct {
+    uint32_t samples;       // setTarget() の回数
+    uint32_t newTargets;    // 予測から外れて履歴を捨てたサンプル
+    uint32_t saccades;      // 軸ごとのサッカード
+} GazeStats_t;
+
+class GazeController {
+public:
+    GazeController() {
+        memset(_axes, 0, sizeof(_axes));
+        memset(&_stats, 0, sizeof(_stats));
+        _axes[GAZE_YAW].eyeMax = (EYE_H_MAX - EYE_H_MIN) * 0.5f;
+        _axes[GAZE_YAW].neckMin = NECK_YAW_MIN - SERVO_CENTER_ANGLE;
+        _axes[GAZE_YAW].neckMax = NECK_YAW_MAX - SERVO_CENTER_ANGLE;
+        _axes[GAZE_YAW].comfort = GAZE_EYE_COMFORT_YAW_DEG;
+        _axes[GAZE_YAW].range = GAZE_YAW_RANGE;
+        _axes[GAZE_PITCH].eyeMax = (EYE_V_MAX - EYE_V_MIN) * 0.5f;
+        _axes[GAZE_PITCH].neckMin = NECK_PITCH_MIN - SERVO_CENTER_ANGLE;
+        _axes[GAZE_PITCH].neckMax = NECK_PITCH_MAX - SERVO_CENTER_ANGLE;
+        _axes[GAZE_PITCH].comfort = GAZE_EYE_COMFORT_PITCH_DEG;
+        _axes[GAZE_PITCH].range = GAZE_PITCH_RANGE;
+    }
+
+    // 注視点の向きのサンプル（体から見た度）
+    void setTarget(float yaw, float pitch, uint32_t nowMs) {
+        const float target[GAZE_AXES] = {yaw, pitch};
+        _stats.samples++;
+
+        bool fresh = _count == 0;
+        for (uint8_t a = 0; a < GAZE_AXES && !fresh; a++) {
+            if (fabsf(target[a] - predict(_axes[a], nowMs)) > GAZE_NEW_TARGET_DEG) fresh = true;
+        }
+        if (fresh) {
+            if (_count != 0) _stats.newTargets++;
+            _count = 0;
+        }
+
+        _head = (uint8_t)((_head + 1) % GAZE_SAMPLES);
+        _timesMs[_head] = nowMs;
+        if (_count < GAZE_SAMPLES) _count++;
+        for (uint8_t a = 0; a < GAZE_AXES; a++) {
+            Axis_t& axis = _axes[a];
+            axis.samples[_head] = target[a] < -axis.range ? -axis.range : (target[a] > axis.range ? axis.range : target[a]);
+            fitLine(axis);
+        }
+        _lastSampleMs = nowMs;
+    }
+
+    // 頭（カメラ）から見た向きのサンプル。今の首の向きを足して体から見た向きにする
+    void setTargetFromHead(float yaw, float pitch, uint32_t nowMs) {
+        setTarget(_axes[GAZE_YAW].neck + yaw, _axes[GAZE_PITCH].neck + pitch, nowMs);
+    }
+
+    // サーボ更新 tick ごと
+    void update(uint32_t nowMs, GazeOutput_t* out) {
+        float dt = _started ? (nowMs - _lastUpdateMs) * 0.001f : 0.0f;
+        _started = true;
+        _lastUpdateMs = nowMs;
+        bool stale = nowMs - _lastSampleMs > GAZE_SAMPLE_WINDOW_MS;
+
+        float eye[GAZE_AXES], neck[GAZE_AXES];
+        for (uint8_t a = 0; a < GAZE_AXES; a++) {
+            Axis_t& axis = _axes[a];
+            float target = predict(axis, nowMs);
+            float feedForward = stale ? 0.0f : axis.velocity;
+
+            // 視線: 遠ければサッカード、近ければ速度を合わせて追う
+            float error = target - axis.gaze;
+            if (fabsf(error) > GAZE_SACCADE_DEG) {
+                axis.gaze = target;
+                _stats.saccades++;
+            } else {
+                float rate = feedForward + GAZE_PURSUIT_GAIN * error;
+                if (rate > GAZE_PURSUIT_MAX_VEL) rate = GAZE_PURSUIT_MAX_VEL;
+                if (rate < -GAZE_PURSUIT_MAX_VEL) rate = -GAZE_PURSUIT_MAX_VEL;
+                axis.gaze += rate * dt;
+            }
+
+            // 首: 目が楽な範囲を出るか、目標が動いているときだけ目標へ
+            if (fabsf(target - axis.neckGoal) > axis.comfort || fabsf(feedForward) > GAZE_NECK_FOLLOW_VEL) {
+                axis.neckGoal = target < axis.neckMin ? axis.neckMin : (target > axis.neckMax ? axis.neckMax : target);
+            }
+            moveNeck(axis, dt);
+
+            // 目は首の分を打ち消す
+            float e = axis.gaze - axis.neck;
+            eye[a] = e < -axis.eyeMax ? -axis.eyeMax : (e > axis.eyeMax ? axis.eyeMax : e);
+            neck[a] = axis.neck;
+        }
+
+        out->eyeYaw = eye[GAZE_YAW];
+        out->eyePitch = eye[GAZE_PITCH];
+        out->neckYaw = neck[GAZE_YAW];
+        out->neckPitch = neck[GAZE_PITCH];
+    }
+
+    // 予測した注視点の向き
+    float predicted(uint8_t axis, uint32_t nowMs) const { return predict(_axes[axis], nowMs); }
+    const GazeStats_t& stats() const { return _stats; }
+
+private:
+    typedef struct {
+        float samples[GAZE_SAMPLES];
+        float last;             // 最新のサンプルの時刻での目標（当てはめた直線の値）
+        float velocity;         // 推定した目標の速度（度/秒）
+        float gaze;             // 視線（目 + 首）
+        float neck;
+        float neckVel;
+        float neckGoal;
+        float eyeMax;           // 目の可動範囲（中心から片側）
+        float neckMin, neckMax;
+        float comfort;          // 首を動かさずに目だけで見る範囲
+        float range;            // 目と首を合わせて向ける範囲
+    } Axis_t;
+
+    // 最新のサンプルから先読みした向き（先読みは GAZE_PREDICT_MAX_MS まで）
+    float predict(const Axis_t& axis, uint32_t nowMs) const {
+        if (_count == 0) return axis.gaze;
+        uint32_t ahead = nowMs - _lastSampleMs + GAZE_LEAD_MS;
+        if (ahead > GAZE_PREDICT_MAX_MS) ahead = GAZE_PREDICT_MAX_MS;
+        return axis.last + axis.velocity * (ahead * 0.001f);
+    }
+
+    // GAZE_SAMPLE_WINDOW_MS 以内のサンプルに直線を当てはめる（傾きは GAZE_PURSUIT_MAX_VEL まで）
+    void fitLine(Axis_t& axis) const {
+        float st = 0.0f, sx = 0.0f, stt = 0.0f, stx = 0.0f;
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            uint8_t k = (uint8_t)((_head + GAZE_SAMPLES - i) % GAZE_SAMPLES);
+            uint32_t age = _timesMs[_head] - _timesMs[k];
+            if (age > GAZE_SAMPLE_WINDOW_MS) break;
+            float t = -(float)age * 0.001f;
+            st += t;
+            sx += axis.samples[k];
+            stt += t * t;
+            stx += t * axis.samples[k];
+            n++;
+        }
+        float denom = n * stt - st * st;
+        if (n < 2 || denom < 1e-6f) {
+            axis.last = axis.samples[_head];
+            axis.velocity = 0.0f;
+            return;
+        }
+        float v = (n * stx - st * sx) / denom;
+        axis.velocity = v < -GAZE_PURSUIT_MAX_VEL ? -GAZE_PURSUIT_MAX_VEL : (v > GAZE_PURSUIT_MAX_VEL ? GAZE_PURSUIT_MAX_VEL : v);
+        axis.last = (sx - axis.velocity * st) / n;     // t = 0（最新のサンプル）での値
+    }
+
+    // 速度・加速度を抑えて首を neckGoal へ（止まれる速さまでしか出さないので行き過ぎない）
+    static void moveNeck(Axis_t& axis, float dt) {
+        float distance = axis.neckGoal - axis.neck;
+        float want = distance * GAZE_NECK_GAIN;
+        float brake = sqrtf(2.0f * GAZE_NECK_MAX_ACC * fabsf(distance));
+        float limit = brake < GAZE_NECK_MAX_VEL ? brake : GAZE_NECK_MAX_VEL;
+        if (want > limit) want = limit;
+        if (want < -limit) want = -limit;
+        float step = GAZE_NECK_MAX_ACC * dt;
+        if (want > axis.neckVel + step) want = axis.neckVel + step;
+        if (want < axis.neckVel - step) want = axis.neckVel - step;
+        axis.neckVel = want;
+        axis.neck += want * dt;
+        if ((distance > 0.0f && axis.neck > axis.neckGoal) || (distance < 0.0f && axis.neck < axis.neckGoal)) {
+            axis.neck = axis.neckGoal;
+            axis.neckVel = 0.0f;
+        }
+    }
+
+    Axis_t _axes[GAZE_AXES];
+    uint32_t _timesMs[GAZE_SAMPLES] = {0};
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+    uint32_t _lastSampleMs = 0;
+    uint32_t _lastUpdateMs = 0;
+    bool _started = false;
+    GazeStats_t _stats;
+};
+
+#endif // COROSUKE_GAZE_CONTROLLER_H
@@ -0,0 +1,102 @@
+/**
+ * コロ助ロボット - IMA-ADPCM 符号化
+ * Corosuke Robot - IMA-ADPCM Codec
+ *
+ * 16bit PCM を 1 サンプル 4bit にする（1/4）。掛け算も表引きも 1 サンプルに数回なので、
+ * マイクのタスクで声の区間だけ符号化しても CPU はほとんど使わない。
+ *
+ * - 1 バイトに 2 サンプル、下位ニブルが先（WAV の IMA-ADPCM と同じ順）
+ * - 状態（予測値とステップの番号）をチャンクの頭に付けて送れば、チャンクごとに
+ *   単独で復号できる（途中を取りこぼしても後ろのチャンクは崩れない）
+ * - 復号は server/voice_ingest.py にもある（表と手順をそろえること）
+ */
+
+#ifndef COROSUKE_IMA_ADPCM_H
+#define COROSUKE_IMA_ADPCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ADPCM_STEP_COUNT    89
+
+typedef struct {
+    int16_t predictor;      // 直前のサンプルの予測値
+    uint8_t index;          // ステップ表の番号 (0-88)
+} AdpcmState_t;
+
+static const int16_t ADPCM_STEPS[ADPCM_STEP_COUNT] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t ADPCM_INDEX_STEP[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static inline void adpcmReset(AdpcmState_t* state) {
+    state->predictor = 0;
+    state->index = 0;
+}
+
+// 4bit 符号から予測値とステップを進める（符号化・復号で共通）
+static inline int16_t adpcmStep(AdpcmState_t* state, uint8_t code) {
+    int32_t step = ADPCM_STEPS[state->index];
+    int32_t diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+
+    int32_t predictor = state->predictor + ((code & 8) ? -diff : diff);
+    if (predictor > 32767) predictor = 32767;
+    if (predictor < -32768) predictor = -32768;
+    state->predictor = (int16_t)predictor;
+
+    int32_t index = state->index + ADPCM_INDEX_STEP[code & 7];
+    if (index < 0) index = 0;
+    if (index > ADPCM_STEP_COUNT - 1) index = ADPCM_STEP_COUNT - 1;
+    state->index = (uint8_t)index;
+    return state->predictor;
+}
+
+static inline uint8_t adpcmEncodeSample(AdpcmState_t* state, int16_t sample) {
+    int32_t step = ADPCM_STEPS[state->index];
+    int32_t diff = sample - state->predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+    }
+    if (diff >= step >> 1) {
+        code |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= step >> 2) code |= 1;
+    adpcmStep(state, code);
+    return code;
+}
+
+// samples 個（偶数）を符号化して out へ。戻り値: 書いたバイト数
+static inline size_t adpcmEncode(AdpcmState_t* state, const int16_t* pcm, size_t samples, uint8_t* out) {
+    size_t bytes = samples / 2;
+    for (size_t i = 0; i < bytes; i++) {
+        uint8_t low = adpcmEncodeSample(state, pcm[2 * i]);
+        uint8_t high = adpcmEncodeSample(state, pcm[2 * i + 1]);
+        out[i] = (uint8_t)(low | (high << 4));
+    }
+    return bytes;
+}
+
+// bytes バイトを復号して pcm へ（2 * bytes サンプル）
+static inline void adpcmDecode(AdpcmState_t* state, const uint8_t* in, size_t bytes, int16_t* pcm) {
+    for (size_t i = 0; i < bytes; i++) {
+        pcm[2 * i] = adpcmStep(state, in[i] & 0x0F);
+        pcm[2 * i + 1] = adpcmStep(state, in[i] >> 4);
+    }
+}
+
+#endif // COROSUKE_IMA_ADPCM_H
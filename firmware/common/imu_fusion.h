@@ -0,0 +1,219 @@
+/**
+ * コロ助ロボット - 固定小数点 IMU 姿勢推定（Mahony フィルタ）
+ * Corosuke Robot - Fixed-Point Mahony Attitude Filter
+ *
+ * ジャイロを積分してクォータニオンを進め、加速度から見た重力方向とのずれ
+ * （外積）を PI でジャイロにフィードバックする。BNO055 内蔵のオイラー角と違い
+ * ジンバルロックがなく、サンプルごとに更新するので遅れも小さい。
+ *
+ * - クォータニオン・重力ベクトル・誤差は Q30（1.0 = 2^30）の int32
+ * - 角速度は rad/s の Q16、加速度は mg（1000 = 1G）で受け取る
+ * - 加速度の大きさが 1G から IMU_ACCEL_GATE_PERCENT 以上ずれたサンプル
+ *   （着地の衝撃など）はジャイロだけで進める
+ * - 正規化は平方根を使わず、1 に近いことを前提にニュートン法 1 回で戻す
+ * - 最初に使える加速度で傾きを合わせる（起動直後に収束を待たない）
+ *
+ * 軸は機体座標系（X: 前、Y: 左、Z: 上）。ピッチは Y 軸、ロールは X 軸まわり。
+ */
+
+#ifndef COROSUKE_IMU_FUSION_H
+#define COROSUKE_IMU_FUSION_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+
+#define IMU_Q               30
+#define IMU_ONE             ((int32_t)1 << IMU_Q)
+#define IMU_GYRO_Q          16                      // 角速度の小数部ビット数
+#define IMU_ONE_G_MG        1000
+
+// 1サンプル（センサーの生値を単位変換したもの）
+typedef struct {
+    int32_t gyro[3];        // rad/s, Q16
+    int32_t accel[3];       // mg
+    uint32_t dtUs;          // 前のサンプルからの時間
+} ImuSample_t;
+
+typedef struct {
+    uint32_t updates;
+    uint32_t accelRejected;     // 大きさが 1G から外れて使わなかった加速度
+    uint32_t aligned;           // 加速度で傾きを合わせ直した回数
+} ImuFusionStats_t;
+
+class ImuFusion {
+public:
+    ImuFusion() { begin(IMU_FUSION_KP, IMU_FUSION_KI); }
+
+    void begin(float kp, float ki) {
+        _kp = (int32_t)(kp * 65536.0f);
+        _ki = (int32_t)(ki * 65536.0f);
+        reset();
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // 姿勢を捨てて、次の加速度で合わせ直す
+    void reset() {
+        _q[0] = IMU_ONE;
+        _q[1] = _q[2] = _q[3] = 0;
+        _integral[0] = _integral[1] = _integral[2] = 0;
+        _aligned = false;
+        updateGravity();
+    }
+
+    bool aligned() const { return _aligned; }
+    const ImuFusionStats_t& stats() const { return _stats; }
+
+    // w, x, y, z（Q30）
+    const int32_t* quaternion() const { return _q; }
+    // 機体座標系での重力方向（Q30、単位ベクトル、水平に立っていれば (0, 0, 1)）
+    const int32_t* gravity() const { return _gravity; }
+
+    void update(const ImuSample_t& sample) {
+        _stats.updates++;
+
+        // 加速度の向き（Q30）。大きさが 1G から外れていたら使わない
+        int32_t a[3];
+        bool useAccel = normalizeAccel(sample.accel, a);
+        if (!useAccel) _stats.accelRejected++;
+
+        if (useAccel && !_aligned) {
+            alignTo(a);
+            return;
+        }
+
+        // 角速度（Q30 rad/s）。積分は int64 で持つ
+        int64_t rate[3];
+        for (int i = 0; i < 3; i++) rate[i] = (int64_t)sample.gyro[i] << (IMU_Q - IMU_GYRO_Q);
+
+        if (useAccel) {
+            // 推定した重力方向と加速度の外積 = 回すべき向き
+            int32_t e[3];
+            e[0] = mul(a[1], _gravity[2]) - mul(a[2], _gravity[1]);
+            e[1] = mul(a[2], _gravity[0]) - mul(a[0], _gravity[2]);
+            e[2] = mul(a[0], _gravity[1]) - mul(a[1], _gravity[0]);
+
+            for (int i = 0; i < 3; i++) {
+                if (_ki != 0) {
+                    _integral[i] += (((int64_t)_ki * e[i]) >> 16) * sample.dtUs / 1000000;
+                }
+                rate[i] += (((int64_t)_kp * e[i]) >> 16) + _integral[i];
+            }
+        }
+
+        // q += q ⊗ (0, ω·dt/2)
+        int32_t h[3];
+        for (int i = 0; i < 3; i++) h[i] = (int32_t)(rate[i] * sample.dtUs / 2000000);
+
+        int32_t w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+        _q[0] = w - mul(x, h[0]) - mul(y, h[1]) - mul(z, h[2]);
+        _q[1] = x + mul(w, h[0]) + mul(y, h[2]) - mul(z, h[1]);
+        _q[2] = y + mul(w, h[1]) - mul(x, h[2]) + mul(z, h[0]);
+        _q[3] = z + mul(w, h[2]) + mul(x, h[1]) - mul(y, h[0]);
+
+        renormalize();
+        updateGravity();
+    }
+
+    // 表示・バランス制御用の角度（度）。出力側だけ浮動小数点
+    float pitchDeg() const {
+        float s = toFloat(-_gravity[0]);
+        if (s > 1.0f) s = 1.0f;
+        if (s < -1.0f) s = -1.0f;
+        return asinf(s) * (180.0f / (float)M_PI);
+    }
+
+    float rollDeg() const {
+        return atan2f(toFloat(_gravity[1]), toFloat(_gravity[2])) * (180.0f / (float)M_PI);
+    }
+
+    float yawDeg() const {
+        float w = toFloat(_q[0]), x = toFloat(_q[1]), y = toFloat(_q[2]), z = toFloat(_q[3]);
+        return atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z)) * (180.0f / (float)M_PI);
+    }
+
+    static float toFloat(int32_t q30) { return q30 * (1.0f / IMU_ONE); }
+
+private:
+    static int32_t mul(int32_t a, int32_t b) {
+        return (int32_t)(((int64_t)a * b + ((int64_t)1 << (IMU_Q - 1))) >> IMU_Q);
+    }
+
+    static uint32_t isqrt(uint32_t n) {
+        uint32_t root = 0;
+        uint32_t bit = (uint32_t)1 << 30;
+        while (bit > n) bit >>= 2;
+        while (bit != 0) {
+            if (n >= root + bit) {
+                n -= root + bit;
+                root = (root >> 1) + bit;
+            } else {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return root;
+    }
+
+    bool normalizeAccel(const int32_t* accel, int32_t* out) const {
+        // mg なので ±16G でも 2乗和は 32bit に収まる
+        uint32_t n2 = 0;
+        for (int i = 0; i < 3; i++) {
+            int32_t v = accel[i];
+            if (v > 16 * IMU_ONE_G_MG || v < -16 * IMU_ONE_G_MG) return false;
+            n2 += (uint32_t)(v * v);
+        }
+        uint32_t norm = isqrt(n2);
+        const uint32_t gate = IMU_ONE_G_MG * IMU_ACCEL_GATE_PERCENT / 100;
+        if (norm + gate < IMU_ONE_G_MG || norm > IMU_ONE_G_MG + gate) return false;
+
+        int64_t inverse = ((int64_t)1 << (IMU_Q + 16)) / norm;
+        for (int i = 0; i < 3; i++) out[i] = (int32_t)((accel[i] * inverse) >> 16);
+        return true;
+    }
+
+    // 加速度の向きに合わせる（ヨーは 0）
+    void alignTo(const int32_t* a) {
+        float ax = toFloat(a[0]), ay = toFloat(a[1]), az = toFloat(a[2]);
+        float pitch = asinf(fmaxf(-1.0f, fminf(1.0f, -ax)));
+        float roll = atan2f(ay, az);
+        float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+        float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+        _q[0] = (int32_t)(cr * cp * IMU_ONE);
+        _q[1] = (int32_t)(sr * cp * IMU_ONE);
+        _q[2] = (int32_t)(cr * sp * IMU_ONE);
+        _q[3] = (int32_t)(-sr * sp * IMU_ONE);
+        _integral[0] = _integral[1] = _integral[2] = 0;
+        _aligned = true;
+        _stats.aligned++;
+        renormalize();
+        updateGravity();
+    }
+
+    // |q|² ≈ 1 のとき 1/|q| ≈ (3 - |q|²) / 2
+    void renormalize() {
+        int64_t n2 = 0;
+        for (int i = 0; i < 4; i++) n2 += ((int64_t)_q[i] * _q[i]) >> IMU_Q;
+        int32_t factor = (int32_t)((3 * (int64_t)IMU_ONE - n2) / 2);
+        for (int i = 0; i < 4; i++) _q[i] = mul(_q[i], factor);
+    }
+
+    void updateGravity() {
+        int32_t w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+        _gravity[0] = 2 * (mul(x, z) - mul(w, y));
+        _gravity[1] = 2 * (mul(w, x) + mul(y, z));
+        _gravity[2] = mul(w, w) - mul(x, x) - mul(y, y) + mul(z, z);
+    }
+
+    int32_t _q[4];
+    int32_t _gravity[3];
+    int64_t _integral[3];       // ジャイロのバイアス推定（Q30 rad/s）
+    int32_t _kp;                // Q16
+    int32_t _ki;                // Q16
+    bool _aligned;
+    ImuFusionStats_t _stats;
+};
+
+#endif // COROSUKE_IMU_FUSION_H
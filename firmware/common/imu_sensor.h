@@ -0,0 +1,262 @@
+/**
+ * コロ助ロボット - IMU 生データ読み出し（BNO055 / MPU6050）
+ * Corosuke Robot - Raw IMU Reader with BNO055 / MPU6050 Fallback
+ *
+ * 姿勢の計算は ImuFusion（imu_fusion.h）に任せ、ここではジャイロと加速度の
+ * 生値をまとめて読んで単位をそろえる（rad/s Q16 と mg）。
+ *
+ * - 起動時に BNO055 → MPU6050 の順に探す。BNO055 は内蔵フュージョンを使わない
+ *   AMG モードで、加速度・地磁気・ジャイロを 1 トランザクションで読む
+ * - MPU6050 は内部 FIFO に IMU_MPU6050_RATE_DIV で決まる周期（333Hz）で
+ *   貯めさせ、制御周期ごとにまとめて読む（I2C バッファに入るだけ）
+ * - 読み出し失敗が IMU_SENSOR_REPROBE_AFTER 回続いたら両方を探し直す。
+ *   呼び出し側はどちらのセンサーかを気にしなくてよい
+ *
+ * どちらも機体座標系（X: 前、Y: 左、Z: 上）に合わせて取り付けてある前提。
+ */
+
+#ifndef COROSUKE_IMU_SENSOR_H
+#define COROSUKE_IMU_SENSOR_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "config.h"
+#include "imu_fusion.h"
+
+#define IMU_SENSOR_BURST_MAX        10      // 1回の read() で返す最大サンプル数（12バイト x 10 が I2C バッファに入る）
+#define IMU_SENSOR_REPROBE_AFTER    5       // この回数続けて失敗したら探し直す
+#define IMU_SENSOR_MAX_DT_US        50000   // これより空いたら（再接続など）積分しない
+
+// BNO055
+#define BNO055_REG_CHIP_ID          0x00
+#define BNO055_REG_ACC_DATA         0x08    // 加速度・地磁気・ジャイロの順に 18 バイト
+#define BNO055_REG_OPR_MODE         0x3D
+#define BNO055_CHIP_ID_VALUE        0xA0
+#define BNO055_MODE_CONFIG          0x00
+#define BNO055_MODE_AMG             0x07
+#define BNO055_ACCEL_LSB_PER_MS2    100     // 1 m/s² = 100 LSB
+#define BNO055_GYRO_LSB_PER_DPS     16
+#define BNO055_GYRO_Q24             ((int32_t)(16777216.0 * M_PI / 180.0 / BNO055_GYRO_LSB_PER_DPS + 0.5))
+
+// MPU6050
+#define MPU6050_REG_SMPLRT_DIV      0x19
+#define MPU6050_REG_CONFIG          0x1A
+#define MPU6050_REG_GYRO_CONFIG     0x1B
+#define MPU6050_REG_ACCEL_CONFIG    0x1C
+#define MPU6050_REG_FIFO_EN         0x23
+#define MPU6050_REG_INT_STATUS      0x3A
+#define MPU6050_REG_USER_CTRL       0x6A
+#define MPU6050_REG_PWR_MGMT_1      0x6B
+#define MPU6050_REG_FIFO_COUNT_H    0x72
+#define MPU6050_REG_FIFO_R_W        0x74
+#define MPU6050_REG_WHO_AM_I        0x75
+#define MPU6050_WHO_AM_I_VALUE      0x68
+#define MPU6050_DLPF_94HZ           0x02    // 遅れ 3ms（サンプル周期に合わせて浅め）
+#define MPU6050_GYRO_500DPS         0x08    // 65.5 LSB/dps
+#define MPU6050_ACCEL_4G            0x08    // 8192 LSB/G
+#define MPU6050_FIFO_ACCEL_GYRO     0x78    // XG | YG | ZG | ACCEL
+#define MPU6050_USER_FIFO_EN        0x40
+#define MPU6050_USER_FIFO_RESET     0x04
+#define MPU6050_CLOCK_PLL_XGYRO     0x01
+#define MPU6050_INT_FIFO_OFLOW      0x10
+#define MPU6050_FIFO_SAMPLE_BYTES   12      // 加速度 XYZ + ジャイロ XYZ（ビッグエンディアン）
+#define MPU6050_GYRO_LSB_PER_DPS    65.5
+#define MPU6050_GYRO_Q24            ((int32_t)(16777216.0 * M_PI / 180.0 / MPU6050_GYRO_LSB_PER_DPS + 0.5))
+#define MPU6050_ACCEL_LSB_PER_G     8192
+
+typedef enum {
+    IMU_SENSOR_NONE = 0,
+    IMU_SENSOR_BNO055,
+    IMU_SENSOR_MPU6050
+} ImuSensorType_t;
+
+typedef struct {
+    uint32_t reads;             // read() 呼び出し
+    uint32_t samples;           // 返したサンプル
+    uint32_t errors;            // I2C の失敗
+    uint32_t fifoOverflows;     // MPU6050 の FIFO が溢れて捨てた回数
+    uint32_t switches;          // 探し直してセンサーが変わった回数
+} ImuSensorStats_t;
+
+class ImuSensor {
+public:
+    ImuSensor(TwoWire& wire = Wire) : _wire(&wire), _type(IMU_SENSOR_NONE) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    ImuSensorType_t type() const { return _type; }
+    const ImuSensorStats_t& stats() const { return _stats; }
+
+    const char* name() const {
+        switch (_type) {
+            case IMU_SENSOR_BNO055: return "BNO055";
+            case IMU_SENSOR_MPU6050: return "MPU6050";
+            default: return "なし";
+        }
+    }
+
+    // BNO055 → MPU6050 の順に探して設定する
+    bool begin() {
+        ImuSensorType_t previous = _type;
+        _type = IMU_SENSOR_NONE;
+        if (initBno055()) {
+            _type = IMU_SENSOR_BNO055;
+        } else if (initMpu6050()) {
+            _type = IMU_SENSOR_MPU6050;
+        }
+        if (previous != IMU_SENSOR_NONE && _type != previous) _stats.switches++;
+        _failures = 0;
+        _lastReadUs = micros();
+        return _type != IMU_SENSOR_NONE;
+    }
+
+    // 前回から溜まったサンプルを読む（古い順）。読めなければ 0
+    size_t read(ImuSample_t* out, size_t max) {
+        _stats.reads++;
+        if (max > IMU_SENSOR_BURST_MAX) max = IMU_SENSOR_BURST_MAX;
+
+        size_t count = 0;
+        bool ok = false;
+        if (_type == IMU_SENSOR_BNO055) {
+            ok = readBno055(out, &count);
+        } else if (_type == IMU_SENSOR_MPU6050) {
+            ok = readMpu6050(out, max, &count);
+        }
+
+        if (ok) {
+            _failures = 0;
+        } else {
+            if (_type != IMU_SENSOR_NONE) _stats.errors++;
+            if (++_failures >= IMU_SENSOR_REPROBE_AFTER) begin();
+            return 0;
+        }
+        _stats.samples += count;
+        return count;
+    }
+
+private:
+    // -------------------------------------------------------------------------
+    // BNO055（FIFO がないので 1 回に 1 サンプル、時間は読んだ間隔）
+    // -------------------------------------------------------------------------
+    bool initBno055() {
+        uint8_t id = 0;
+        if (!readRegs(I2C_ADDR_BNO055, BNO055_REG_CHIP_ID, &id, 1) || id != BNO055_CHIP_ID_VALUE) return false;
+        if (!write8(I2C_ADDR_BNO055, BNO055_REG_OPR_MODE, BNO055_MODE_CONFIG)) return false;
+        delay(20);
+        if (!write8(I2C_ADDR_BNO055, BNO055_REG_OPR_MODE, BNO055_MODE_AMG)) return false;
+        delay(10);
+        return true;
+    }
+
+    bool readBno055(ImuSample_t* out, size_t* count) {
+        uint8_t raw[18];
+        if (!readRegs(I2C_ADDR_BNO055, BNO055_REG_ACC_DATA, raw, sizeof(raw))) return false;
+
+        uint32_t nowUs = micros();
+        uint32_t dtUs = nowUs - _lastReadUs;
+        _lastReadUs = nowUs;
+
+        for (int i = 0; i < 3; i++) {
+            int16_t accel = (int16_t)(raw[2 * i] | (raw[2 * i + 1] << 8));
+            int16_t gyro = (int16_t)(raw[12 + 2 * i] | (raw[12 + 2 * i + 1] << 8));
+            // 0.01 m/s² → mg、1/16 dps → rad/s Q16
+            out->accel[i] = accel * 10000 / 9807;
+            out->gyro[i] = (gyro * BNO055_GYRO_Q24) >> 8;
+        }
+        out->dtUs = dtUs > IMU_SENSOR_MAX_DT_US ? 0 : dtUs;
+        *count = 1;
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // MPU6050（FIFO にまとめて貯めさせ、サンプル間隔は固定）
+    // -------------------------------------------------------------------------
+    bool initMpu6050() {
+        uint8_t id = 0;
+        if (!readRegs(I2C_ADDR_MPU6050, MPU6050_REG_WHO_AM_I, &id, 1) || id != MPU6050_WHO_AM_I_VALUE) return false;
+        bool ok = write8(I2C_ADDR_MPU6050, MPU6050_REG_PWR_MGMT_1, MPU6050_CLOCK_PLL_XGYRO) &&
+                  write8(I2C_ADDR_MPU6050, MPU6050_REG_CONFIG, MPU6050_DLPF_94HZ) &&
+                  write8(I2C_ADDR_MPU6050, MPU6050_REG_SMPLRT_DIV, IMU_MPU6050_RATE_DIV) &&
+                  write8(I2C_ADDR_MPU6050, MPU6050_REG_GYRO_CONFIG, MPU6050_GYRO_500DPS) &&
+                  write8(I2C_ADDR_MPU6050, MPU6050_REG_ACCEL_CONFIG, MPU6050_ACCEL_4G) &&
+                  resetMpu6050Fifo();
+        return ok;
+    }
+
+    bool resetMpu6050Fifo() {
+        return write8(I2C_ADDR_MPU6050, MPU6050_REG_FIFO_EN, 0) &&
+               write8(I2C_ADDR_MPU6050, MPU6050_REG_USER_CTRL, MPU6050_USER_FIFO_RESET) &&
+               write8(I2C_ADDR_MPU6050, MPU6050_REG_USER_CTRL, MPU6050_USER_FIFO_EN) &&
+               write8(I2C_ADDR_MPU6050, MPU6050_REG_FIFO_EN, MPU6050_FIFO_ACCEL_GYRO);
+    }
+
+    bool readMpu6050(ImuSample_t* out, size_t max, size_t* count) {
+        // INT_STATUS と FIFO_COUNT は離れているので別に読む
+        uint8_t status = 0;
+        uint8_t fifoCount[2];
+        if (!readRegs(I2C_ADDR_MPU6050, MPU6050_REG_INT_STATUS, &status, 1) ||
+            !readRegs(I2C_ADDR_MPU6050, MPU6050_REG_FIFO_COUNT_H, fifoCount, 2)) {
+            return false;
+        }
+        if (status & MPU6050_INT_FIFO_OFLOW) {
+            // 溢れたら途中からサンプルの区切りが分からないので捨てる
+            _stats.fifoOverflows++;
+            *count = 0;
+            return resetMpu6050Fifo();
+        }
+
+        size_t available = (size_t)((fifoCount[0] << 8) | fifoCount[1]) / MPU6050_FIFO_SAMPLE_BYTES;
+        size_t n = available < max ? available : max;
+        *count = n;
+        if (n == 0) return true;
+
+        uint8_t raw[MPU6050_FIFO_SAMPLE_BYTES * IMU_SENSOR_BURST_MAX];
+        if (!readRegs(I2C_ADDR_MPU6050, MPU6050_REG_FIFO_R_W, raw, (uint8_t)(n * MPU6050_FIFO_SAMPLE_BYTES))) {
+            return false;
+        }
+
+        const uint32_t intervalUs = 1000 * (1 + IMU_MPU6050_RATE_DIV);     // 内部 1kHz を分周
+        for (size_t s = 0; s < n; s++) {
+            const uint8_t* p = &raw[s * MPU6050_FIFO_SAMPLE_BYTES];
+            for (int i = 0; i < 3; i++) {
+                int16_t accel = (int16_t)((p[2 * i] << 8) | p[2 * i + 1]);
+                int16_t gyro = (int16_t)((p[6 + 2 * i] << 8) | p[6 + 2 * i + 1]);
+                out[s].accel[i] = accel * IMU_ONE_G_MG / MPU6050_ACCEL_LSB_PER_G;
+                out[s].gyro[i] = (gyro * MPU6050_GYRO_Q24) >> 8;
+            }
+            out[s].dtUs = intervalUs;
+        }
+        _lastReadUs = micros();
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // I2C
+    // -------------------------------------------------------------------------
+    bool write8(uint8_t address, uint8_t reg, uint8_t value) {
+        _wire->beginTransmission(address);
+        _wire->write(reg);
+        _wire->write(value);
+        return _wire->endTransmission() == 0;
+    }
+
+    bool readRegs(uint8_t address, uint8_t reg, uint8_t* buffer, uint8_t length) {
+        _wire->beginTransmission(address);
+        _wire->write(reg);
+        if (_wire->endTransmission(false) != 0) return false;
+        if (_wire->requestFrom(address, length) != length) return false;
+        for (uint8_t i = 0; i < length; i++) {
+            buffer[i] = (uint8_t)_wire->read();
+        }
+        return true;
+    }
+
+    TwoWire* _wire;
+    ImuSensorType_t _type;
+    uint32_t _failures = 0;
+    uint32_t _lastReadUs = 0;
+    ImuSensorStats_t _stats;
+};
+
+#endif // COROSUKE_IMU_SENSOR_H
@@ -0,0 +1,157 @@
+/**
+ * コロ助ロボット - 関節テーブル（角度 → PCA9685 カウント）
+ * Corosuke Robot - Compile-Time Joint Table
+ *
+ * config.h のチャンネル・可動範囲・トリムのマクロから、関節ごとの最小・最大角、向きと
+ * 角度 → 12bit カウントの変換係数をコンパイル時に作る。
+ *
+ * - 角度は 1/16 度の固定小数点。整数度に切り捨ててから map() していた従来は
+ *   1 度 ≈ 2.3 カウントの段差になっていたが、軌道の 1 度未満の動きもそのままカウントになる
+ * - 1 カウントの長さは PCA9685_OSC_HZ とプリスケーラ（setPWMFreq() と同じ丸め）から求める。
+ *   発振器を較正すればパルス幅も周期も合う
+ * - 可動範囲への丸めは min/max だけ（分岐なし）。トリム・向きは係数に入っている
+ * - 範囲の端がパルス幅の範囲に収まることは static_assert で確かめる
+ * - ESP32 の Arduino は gnu++11 なので constexpr 関数は return 1 つで書く
+ */
+
+#ifndef COROSUKE_JOINT_TABLE_H
+#define COROSUKE_JOINT_TABLE_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+#define JOINT_ANGLE_FRAC_BITS   4                               // 角度は 1/16 度
+#define JOINT_ANGLE_ONE         (1 << JOINT_ANGLE_FRAC_BITS)
+#define JOINT_TICK_FRAC_BITS    16                              // 係数は Q16 カウント
+
+// setPWMFreq() が書くプリスケーラと 1μs あたりのカウント
+#define JOINT_PRESCALE          ((int)((double)PCA9685_OSC_HZ / (SERVO_PWM_HZ * 4096.0) + 0.5 - 1.0))
+#define JOINT_TICKS_PER_US      ((double)PCA9685_OSC_HZ / ((JOINT_PRESCALE + 1) * 1000000.0))
+
+typedef struct {
+    int16_t minQ;           // 可動範囲（1/16 度）
+    int16_t maxQ;
+    int32_t offsetQ16;      // 角度 0 のカウント（Q16、向き・トリム込み）
+    int32_t slopeQ16;       // 1/16 度あたりのカウント（Q16、向きの符号つき）
+} JointSpec_t;
+
+static constexpr int32_t jointRound(double x) {
+    return (int32_t)(x < 0.0 ? x - 0.5 : x + 0.5);
+}
+
+// パルス幅 (μs) → Q16 カウント
+static constexpr int32_t jointPulseQ16(double pulseUs) {
+    return jointRound(pulseUs * JOINT_TICKS_PER_US * (1 << JOINT_TICK_FRAC_BITS));
+}
+
+// サーボ角 (度) → パルス幅 (μs)
+static constexpr double jointPulseUs(double servoDeg) {
+    return SERVO_MIN_PULSE + servoDeg * (SERVO_MAX_PULSE - SERVO_MIN_PULSE) / 180.0;
+}
+
+// 角度 a のサーボ角は 90 + dir * (a - 90) + trim
+static constexpr JointSpec_t makeJoint(int minDeg, int maxDeg, int dir, int trimDecideg) {
+    return JointSpec_t{
+        (int16_t)(minDeg * JOINT_ANGLE_ONE),
+        (int16_t)(maxDeg * JOINT_ANGLE_ONE),
+        jointPulseQ16(jointPulseUs(SERVO_CENTER_ANGLE - dir * SERVO_CENTER_ANGLE + trimDecideg / 10.0)),
+        jointRound(dir * (SERVO_MAX_PULSE - SERVO_MIN_PULSE) / 180.0 / JOINT_ANGLE_ONE *
+                   JOINT_TICKS_PER_US * (1 << JOINT_TICK_FRAC_BITS)),
+    };
+}
+
+static constexpr int32_t jointClamp(int32_t angleQ, int32_t minQ, int32_t maxQ) {
+    return angleQ < minQ ? minQ : (angleQ > maxQ ? maxQ : angleQ);
+}
+
+// 角度 (1/16 度) → PCA9685 のカウント（可動範囲に丸める）
+static constexpr uint16_t jointTicks(const JointSpec_t& joint, int32_t angleQ) {
+    return (uint16_t)((joint.offsetQ16 + joint.slopeQ16 * jointClamp(angleQ, joint.minQ, joint.maxQ) +
+                       (1 << (JOINT_TICK_FRAC_BITS - 1))) >> JOINT_TICK_FRAC_BITS);
+}
+
+// 度 → 1/16 度（負の角度はどのみち最小角に丸められるので 0 方向への切り捨てで足りる）
+static inline int32_t jointAngleQ(float deg) {
+    return (int32_t)(deg * JOINT_ANGLE_ONE + 0.5f);
+}
+
+// =============================================================================
+// 上半身 (PCA9685 #1)
+// =============================================================================
+static constexpr int16_t JOINT_TRIM_UPPER[16] = SERVO_TRIM_UPPER;
+
+static constexpr JointSpec_t UPPER_JOINTS[16] = {
+    makeJoint(EYE_H_MIN, EYE_H_MAX, 1, JOINT_TRIM_UPPER[SERVO_EYE_RIGHT_H]),
+    makeJoint(EYE_V_MIN, EYE_V_MAX, 1, JOINT_TRIM_UPPER[SERVO_EYE_RIGHT_V]),
+    makeJoint(EYE_H_MIN, EYE_H_MAX, 1, JOINT_TRIM_UPPER[SERVO_EYE_LEFT_H]),
+    makeJoint(EYE_V_MIN, EYE_V_MAX, 1, JOINT_TRIM_UPPER[SERVO_EYE_LEFT_V]),
+    makeJoint(EYELID_WIDE, EYELID_CLOSE, 1, JOINT_TRIM_UPPER[SERVO_EYELID_RIGHT]),
+    makeJoint(EYELID_WIDE, EYELID_CLOSE, 1, JOINT_TRIM_UPPER[SERVO_EYELID_LEFT]),
+    makeJoint(MOUTH_UPPER_OPEN, MOUTH_CLOSED, 1, JOINT_TRIM_UPPER[SERVO_MOUTH_UPPER]),
+    makeJoint(MOUTH_CLOSED, MOUTH_OPEN, 1, JOINT_TRIM_UPPER[SERVO_MOUTH_LOWER]),
+    makeJoint(NECK_YAW_MIN, NECK_YAW_MAX, 1, JOINT_TRIM_UPPER[SERVO_NECK_YAW]),
+    makeJoint(NECK_PITCH_MIN, NECK_PITCH_MAX, 1, JOINT_TRIM_UPPER[SERVO_NECK_PITCH]),
+    makeJoint(0, 180, 1, JOINT_TRIM_UPPER[SERVO_ARM_RIGHT_SHOULDER]),
+    makeJoint(0, 180, 1, JOINT_TRIM_UPPER[SERVO_ARM_RIGHT_ELBOW]),
+    makeJoint(0, 180, 1, JOINT_TRIM_UPPER[SERVO_ARM_LEFT_SHOULDER]),
+    makeJoint(0, 180, 1, JOINT_TRIM_UPPER[SERVO_ARM_LEFT_ELBOW]),
+    makeJoint(0, 180, 1, JOINT_TRIM_UPPER[14]),     // 予備
+    makeJoint(0, 180, 1, JOINT_TRIM_UPPER[15]),
+};
+
+// =============================================================================
+// 下半身 (PCA9685 #2)
+// =============================================================================
+static constexpr int16_t JOINT_TRIM_LOWER[16] = SERVO_TRIM_LOWER;
+
+static constexpr JointSpec_t LOWER_JOINTS[16] = {
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_WAIST]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_LEG_RIGHT_HIP_YAW]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_LEG_RIGHT_HIP_PITCH]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_LEG_RIGHT_KNEE]),
+    makeJoint(LEG_ANKLE_MIN, LEG_ANKLE_MAX, 1, JOINT_TRIM_LOWER[SERVO_LEG_RIGHT_ANKLE]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_LEG_LEFT_HIP_YAW]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_LEG_LEFT_HIP_PITCH]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[SERVO_LEG_LEFT_KNEE]),
+    makeJoint(LEG_ANKLE_MIN, LEG_ANKLE_MAX, 1, JOINT_TRIM_LOWER[SERVO_LEG_LEFT_ANKLE]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[9]),      // 予備
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[10]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[11]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[12]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[13]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[14]),
+    makeJoint(0, 180, 1, JOINT_TRIM_LOWER[15]),
+};
+
+// =============================================================================
+// コンパイル時の検査
+// =============================================================================
+// 可動範囲の両端（トリム・向き込み）が SERVO_MIN_PULSE〜SERVO_MAX_PULSE に収まる
+static constexpr bool jointInPulseRange(uint16_t ticks) {
+    return ticks + 1 >= (jointPulseQ16(SERVO_MIN_PULSE) >> JOINT_TICK_FRAC_BITS) &&
+           ticks <= (jointPulseQ16(SERVO_MAX_PULSE) >> JOINT_TICK_FRAC_BITS) + 1;
+}
+
+static constexpr bool jointValid(const JointSpec_t& joint) {
+    return joint.minQ >= 0 && joint.minQ < joint.maxQ && joint.maxQ <= 180 * JOINT_ANGLE_ONE &&
+           joint.slopeQ16 != 0 &&
+           jointInPulseRange(jointTicks(joint, joint.minQ)) && jointInPulseRange(jointTicks(joint, joint.maxQ));
+}
+
+static constexpr bool jointTableValid(const JointSpec_t* table, int count) {
+    return count == 0 || (jointValid(table[count - 1]) && jointTableValid(table, count - 1));
+}
+
+static constexpr bool jointTrimValid(const int16_t* trims, int count) {
+    return count == 0 || (trims[count - 1] >= -150 && trims[count - 1] <= 150 && jointTrimValid(trims, count - 1));
+}
+
+static_assert(JOINT_PRESCALE >= 3 && JOINT_PRESCALE <= 255, "PCA9685 prescale out of range (check PCA9685_OSC_HZ)");
+static_assert(jointPulseQ16(SERVO_MAX_PULSE) >> JOINT_TICK_FRAC_BITS < 4096, "SERVO_MAX_PULSE exceeds the PWM period");
+static_assert(jointTrimValid(JOINT_TRIM_UPPER, 16) && jointTrimValid(JOINT_TRIM_LOWER, 16),
+              "servo trim must be within +-15 degrees");
+static_assert(jointTableValid(UPPER_JOINTS, 16), "upper joint range outside the servo pulse range");
+static_assert(jointTableValid(LOWER_JOINTS, 16), "lower joint range outside the servo pulse range");
+
+#endif // COROSUKE_JOINT_TABLE_H
@@ -0,0 +1,148 @@
+/**
+ * コロ助ロボット - LED目の描画
+ * Corosuke Robot - LED Eye Compositor
+ *
+ * 目の LED リング（左右 LED_EYE_NUM_LEDS 個ずつ）のフレームを、目とまぶたのサーボ角と
+ * 表情の色から作る。前回出したフレームと同じなら何もしないので、止まっている間は
+ * FastLED.show() を呼ばずに済む。
+ *
+ * - 瞳のハイライト: 正面ではいちばん上の LED、視線の向きへリング上を動く（隣の LED と按分）
+ * - まばたき: まぶたの角度に合わせて上から順に消していく（縁は LED_LID_EDGE でぼかす）
+ * - 表情の色: setColor() から fadeMs かけて混ぜる
+ * - リングは LED 0 が上、正面から見て時計回り
+ * - 描画だけで出力はしない。frame() を出力側へ渡し、渡せたら commit() する
+ */
+
+#ifndef COROSUKE_LED_EYES_H
+#define COROSUKE_LED_EYES_H
+
+#include <FastLED.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+
+#define LED_EYES            2
+#define LED_EYE_RIGHT       0
+#define LED_EYE_LEFT        1
+#define LED_HIGHLIGHT_GAIN  2.0f    // 視線の向きへハイライトを寄せる強さ（目が端まで向くと反対側まで回る）
+#define LED_LID_EDGE        0.5f    // まぶたの縁のぼかし幅（リングの直径 = 2）
+
+// 片目の姿勢（サーボ角、度）
+typedef struct {
+    float eyeH;
+    float eyeV;
+    float eyelid;
+} LedEyePose_t;
+
+typedef struct {
+    CRGB leds[LED_EYES][LED_EYE_NUM_LEDS];
+} LedEyeFrame_t;
+
+typedef struct {
+    uint32_t renders;       // render() 回数
+    uint32_t changes;       // 前回出したフレームから変わった回数
+    uint32_t commits;       // 出力側へ渡したフレーム
+} LedEyeStats_t;
+
+class LedEyeRenderer {
+public:
+    void begin(CRGB color) {
+        for (uint8_t i = 0; i < LED_EYE_NUM_LEDS; i++) {
+            float angle = i * (float)(2.0 * M_PI) / LED_EYE_NUM_LEDS;
+            _ringY[i] = cosf(angle);
+        }
+        _from = _to = color;
+        _fadeStartMs = 0;
+        _fadeMs = 0;
+        _frame = LedEyeFrame_t();
+        _shown = LedEyeFrame_t();
+        memset(&_stats, 0, sizeof(_stats));
+        _shownValid = false;
+    }
+
+    // 表情の色を fadeMs かけて color へ（途中で呼ばれたら今の色から）
+    void setColor(CRGB color, uint32_t nowMs, uint16_t fadeMs) {
+        _from = currentColor(nowMs);
+        _to = color;
+        _fadeStartMs = nowMs;
+        _fadeMs = fadeMs;
+    }
+
+    // フレームを描く。戻り値: 前回 commit() したフレームから変わった
+    bool render(uint32_t nowMs, const LedEyePose_t poses[LED_EYES]) {
+        _stats.renders++;
+        CRGB base = currentColor(nowMs);
+        for (uint8_t eye = 0; eye < LED_EYES; eye++) {
+            renderEye(poses[eye], base, _frame.leds[eye]);
+        }
+        bool changed = !_shownValid || memcmp(&_frame, &_shown, sizeof(_frame)) != 0;
+        if (changed) _stats.changes++;
+        return changed;
+    }
+
+    const LedEyeFrame_t& frame() const { return _frame; }
+
+    // frame() を出力側へ渡せた
+    void commit() {
+        _shown = _frame;
+        _shownValid = true;
+        _stats.commits++;
+    }
+
+    const LedEyeStats_t& stats() const { return _stats; }
+
+private:
+    CRGB currentColor(uint32_t nowMs) const {
+        uint32_t elapsed = nowMs - _fadeStartMs;
+        if (_fadeMs == 0 || elapsed >= _fadeMs) return _to;
+        return blend(_from, _to, (uint8_t)(elapsed * 255 / _fadeMs));
+    }
+
+    void renderEye(const LedEyePose_t& pose, CRGB base, CRGB* leds) const {
+        // 視線（-1〜1）。正面の「上」に視線の分を足した向きがハイライトの位置
+        float gazeX = (pose.eyeH - SERVO_CENTER_ANGLE) / ((EYE_H_MAX - EYE_H_MIN) * 0.5f);
+        float gazeY = (pose.eyeV - SERVO_CENTER_ANGLE) / ((EYE_V_MAX - EYE_V_MIN) * 0.5f);
+        float hx = gazeX * LED_HIGHLIGHT_GAIN;
+        float hy = 1.0f + gazeY * LED_HIGHLIGHT_GAIN;
+        float position = 0.0f;
+        if (hx * hx + hy * hy > 1e-6f) {
+            position = atan2f(hx, hy) * (LED_EYE_NUM_LEDS / (float)(2.0 * M_PI));
+            if (position < 0.0f) position += LED_EYE_NUM_LEDS;
+        }
+        uint8_t first = (uint8_t)position % LED_EYE_NUM_LEDS;
+        uint8_t second = (uint8_t)((first + 1) % LED_EYE_NUM_LEDS);
+        uint8_t toSecond = (uint8_t)((position - (int)position) * 255.0f + 0.5f);
+
+        // まぶたの縁の高さ（開いていると上端より上、閉じると下端より下）
+        float closed = (pose.eyelid - EYELID_OPEN) / (float)(EYELID_CLOSE - EYELID_OPEN);
+        closed = fmaxf(0.0f, fminf(1.0f, closed));
+        float lidY = 1.0f + LED_LID_EDGE * 0.5f - closed * (2.0f + LED_LID_EDGE);
+
+        for (uint8_t i = 0; i < LED_EYE_NUM_LEDS; i++) {
+            CRGB c = base;
+            if (i == first) c = blend(base, CRGB(CRGB::White), (uint8_t)(255 - toSecond));
+            else if (i == second) c = blend(base, CRGB(CRGB::White), toSecond);
+
+            float lit = (lidY - _ringY[i]) / LED_LID_EDGE + 0.5f;
+            if (lit <= 0.0f) {
+                c = CRGB(0, 0, 0);
+            } else if (lit < 1.0f) {
+                c.nscale8((uint8_t)(lit * 255.0f));
+            }
+            leds[i] = c;
+        }
+    }
+
+    float _ringY[LED_EYE_NUM_LEDS];
+    CRGB _from, _to;
+    uint32_t _fadeStartMs = 0;
+    uint16_t _fadeMs = 0;
+    LedEyeFrame_t _frame;
+    LedEyeFrame_t _shown;
+    bool _shownValid = false;
+    LedEyeStats_t _stats;
+};
+
+#endif // COROSUKE_LED_EYES_H
@@ -0,0 +1,122 @@
+/**
+ * コロ助ロボット - 脚の逆運動学（閉じた式）
+ * Corosuke Robot - Closed-Form Leg Inverse Kinematics
+ *
+ * 股関節ヨー・股関節ピッチ・膝・足首の 4 自由度の脚で、足裏の位置（前後・高さ）と
+ * 向き（ヨー・ピッチ）から関節角を求める。余弦定理と atan2 だけで解くので
+ * 反復はなく、処理時間は毎回同じ。
+ *
+ * - 寸法は config.h の LEG_*_MM（leg.scad の値）
+ * - 座標は股関節ピッチ軸が原点、x: 前、z: 上（足は負）。ヨーで回した脚の面内で考える
+ * - 角度は右から見て反時計回りが正（太もも・すね: 下端が前へ、足: つま先が上へ）
+ * - 膝は前に出る向き（人と同じ）だけを解く
+ * - 股関節ロールがないので左右（y）には足を動かせない
+ */
+
+#ifndef COROSUKE_LEG_IK_H
+#define COROSUKE_LEG_IK_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#define LEG_IK_RAD_TO_DEG   (180.0f / (float)M_PI)
+#define LEG_IK_DEG_TO_RAD   ((float)M_PI / 180.0f)
+#define LEG_IK_MIN_REACH_MM 10.0f       // 股関節と足首がこれより近い目標は届かない扱い
+
+// 足裏の目標（足裏中心、股関節ピッチ軸から）
+typedef struct {
+    float x;            // 前 (mm)
+    float z;            // 上 (mm)、股関節より下なので負
+    float yawDeg;       // つま先の向き（左が正）
+    float pitchDeg;     // 足裏の傾き（つま先が上がる向きが正、0 = 水平）
+} FootTarget_t;
+
+// 関節角（度、0 = 脚をまっすぐ伸ばした直立）
+typedef struct {
+    float hipYaw;
+    float hipPitch;     // 正: 脚を前へ
+    float knee;         // 正: 曲げる
+    float ankle;        // 正: つま先を上げる（すねに対して）
+} LegAngles_t;
+
+class LegIk {
+public:
+    // 届かない目標は届く範囲のいちばん近い位置で解き、false を返す
+    static bool solve(const FootTarget_t& foot, LegAngles_t* angles) {
+        const float l1 = LEG_THIGH_MM, l2 = LEG_SHIN_MM;
+        float pitch = foot.pitchDeg * LEG_IK_DEG_TO_RAD;
+
+        // 足裏中心 → 足首軸
+        float ax = foot.x - LEG_ANKLE_HEIGHT_MM * sinf(pitch);
+        float az = foot.z + LEG_ANKLE_HEIGHT_MM * cosf(pitch);
+
+        float d2 = ax * ax + az * az;
+        bool reachable = true;
+        const float maxReach = l1 + l2;
+        const float minReach = fmaxf(fabsf(l1 - l2), LEG_IK_MIN_REACH_MM);
+        if (d2 > maxReach * maxReach) {
+            d2 = maxReach * maxReach;
+            reachable = false;
+        } else if (d2 < minReach * minReach) {
+            d2 = minReach * minReach;
+            reachable = false;
+        }
+
+        // 余弦定理で膝、膝の曲がりから太ももと「股関節 → 足首」の線がなす角
+        float cosKnee = (d2 - l1 * l1 - l2 * l2) / (2.0f * l1 * l2);
+        cosKnee = fmaxf(-1.0f, fminf(1.0f, cosKnee));
+        float sinKnee = sqrtf(1.0f - cosKnee * cosKnee);
+        float knee = atan2f(sinKnee, cosKnee);
+        float hip = atan2f(ax, -az) + atan2f(l2 * sinKnee, l1 + l2 * cosKnee);
+
+        // すねの向き = 股関節 - 膝。足裏をその分だけ戻す
+        float shin = hip - knee;
+
+        angles->hipYaw = foot.yawDeg;
+        angles->hipPitch = hip * LEG_IK_RAD_TO_DEG;
+        angles->knee = knee * LEG_IK_RAD_TO_DEG;
+        angles->ankle = foot.pitchDeg - shin * LEG_IK_RAD_TO_DEG;
+        return reachable;
+    }
+
+    // 関節角 → 足裏（検証・ホスト側ツール用）
+    static void forward(const LegAngles_t& angles, FootTarget_t* foot) {
+        float hip = angles.hipPitch * LEG_IK_DEG_TO_RAD;
+        float shin = hip - angles.knee * LEG_IK_DEG_TO_RAD;
+        float pitch = shin + angles.ankle * LEG_IK_DEG_TO_RAD;
+
+        float ax = LEG_THIGH_MM * sinf(hip) + LEG_SHIN_MM * sinf(shin);
+        float az = -LEG_THIGH_MM * cosf(hip) - LEG_SHIN_MM * cosf(shin);
+
+        foot->x = ax + LEG_ANKLE_HEIGHT_MM * sinf(pitch);
+        foot->z = az - LEG_ANKLE_HEIGHT_MM * cosf(pitch);
+        foot->yawDeg = angles.hipYaw;
+        foot->pitchDeg = pitch * LEG_IK_RAD_TO_DEG;
+    }
+
+    // 関節角をサーボ角にして書く（channels: ヨー・ピッチ・膝・足首の順）
+    static void toServo(const LegAngles_t& angles, const uint8_t* channels, float* targets) {
+        targets[channels[0]] = SERVO_CENTER_ANGLE + LEG_HIP_YAW_DIR * angles.hipYaw;
+        targets[channels[1]] = SERVO_CENTER_ANGLE + LEG_HIP_PITCH_DIR * angles.hipPitch;
+        targets[channels[2]] = SERVO_CENTER_ANGLE + LEG_KNEE_DIR * angles.knee;
+        targets[channels[3]] = SERVO_CENTER_ANGLE + LEG_ANKLE_DIR * angles.ankle;
+    }
+
+    // サーボ角 → 関節角（toServo の逆）
+    static void fromServo(const float* targets, const uint8_t* channels, LegAngles_t* angles) {
+        angles->hipYaw = (targets[channels[0]] - SERVO_CENTER_ANGLE) * LEG_HIP_YAW_DIR;
+        angles->hipPitch = (targets[channels[1]] - SERVO_CENTER_ANGLE) * LEG_HIP_PITCH_DIR;
+        angles->knee = (targets[channels[2]] - SERVO_CENTER_ANGLE) * LEG_KNEE_DIR;
+        angles->ankle = (targets[channels[3]] - SERVO_CENTER_ANGLE) * LEG_ANKLE_DIR;
+    }
+};
+
+// 左右の脚のチャンネル（ヨー・ピッチ・膝・足首）
+static const uint8_t LEG_RIGHT_CHANNELS[4] = {
+    SERVO_LEG_RIGHT_HIP_YAW, SERVO_LEG_RIGHT_HIP_PITCH, SERVO_LEG_RIGHT_KNEE, SERVO_LEG_RIGHT_ANKLE};
+static const uint8_t LEG_LEFT_CHANNELS[4] = {
+    SERVO_LEG_LEFT_HIP_YAW, SERVO_LEG_LEFT_HIP_PITCH, SERVO_LEG_LEFT_KNEE, SERVO_LEG_LEFT_ANKLE};
+
+#endif // COROSUKE_LEG_IK_H
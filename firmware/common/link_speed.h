@@ -0,0 +1,551 @@
+/**
+ * コロ助ロボット - ESP32間 UART のボーレート交渉
+ * Corosuke Robot - Inter-ESP32 UART Link-Speed Negotiation
+ *
+ * どちらのボードも UART_BAUD_RATE で起動し、上流側（起動側）が
+ * LINK_SPEED_LADDER の高い方から順に試して、通るうちで一番速いボーレートに上げる。
+ *
+ *   起動側                                応答側
+ *   PROPOSE(baud) ──────────────────────▶ 対応していれば ACCEPT を返して切り替え（TRIAL）
+ *   ◀─────────────────────────── ACCEPT    対応していなければ REJECT（次の候補へ）
+ *   切り替え → SETTLE_MS 待つ
+ *   PROBE × LINK_SPEED_PROBES ───────────▶ CRC とパターンが正しいものを数える
+ *   PROBE_END ───────────────────────────▶
+ *   ◀─────────────────────────── REPORT(正しく届いた数)
+ *   全部届いていれば COMMIT（RUNNING）     足りなければすぐ、COMMIT が来なければ TRIAL_MS で
+ *   足りなければ元に戻して次の候補へ        元のボーレートへ
+ *
+ * - 確定後は集計窓ごとに受信エラー率を見て、BAD_WINDOWS 回続けて
+ *   MAX_ERROR_PERMILLE を超えたら 1 段下げて交渉し直す（応答側は DOWNGRADE で頼む）
+ * - 基準より速いときは両方が KEEPALIVE_MS ごとに ALIVE を送り、SILENCE_MS の間
+ *   何も受け取れなければ基準のボーレートへ戻る（相手のリセット・配線不良からの復帰）
+ * - 交渉のフレームは v2 の送りっぱなし（CRC-16 付き）。ボーレートを切り替える前に
+ *   flush() で送信を出し切る。切り替えの前後で化けた確実に届けるコマンドは ReliableLink が再送する
+ * - CMD_LINK_SPEED を知らない古いボードは返事をしないので、基準のままで
+ *   RETRY_MS ごとに PROPOSE を送るだけになる
+ *
+ * 出力先は write(const uint8_t*, size_t)・flush()・updateBaudRate() を持つもの（HardwareSerial など）。
+ * 受信の速さは UART ドライバのリングバッファ（setRxBufferSize()）で吸収する。
+ */
+
+#ifndef COROSUKE_LINK_SPEED_H
+#define COROSUKE_LINK_SPEED_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+#include "packet_parser.h"
+
+#define LINK_SPEED_PROBES               16      // 1回の試験で送る PROBE の数
+#define LINK_SPEED_REPLY_MS             60      // PROPOSE の再送間隔
+#define LINK_SPEED_PROPOSE_TRIES        8       // 返事がないまま諦めるまでの PROPOSE 回数
+#define LINK_SPEED_SETTLE_MS            5       // 切り替え後、PROBE を送り始めるまで
+#define LINK_SPEED_REPORT_MS            100     // PROBE を送り終えてから REPORT を待つ時間
+#define LINK_SPEED_TRIAL_MS             400     // 応答側が COMMIT を待つ時間（起動側の再提案より短く）
+#define LINK_SPEED_COMMIT_REPEAT        2
+#define LINK_SPEED_KEEPALIVE_MS         200
+#define LINK_SPEED_SILENCE_MS           1000
+#define LINK_SPEED_WINDOW_MS            1000    // エラー率・スループットの集計窓
+#define LINK_SPEED_MIN_WINDOW_FRAMES    8       // これより少ない窓ではエラー率を判定しない
+#define LINK_SPEED_MAX_ERROR_PERMILLE   20
+#define LINK_SPEED_BAD_WINDOWS          2
+#define LINK_SPEED_START_MS             200     // 起動から最初の PROPOSE まで（相手の起動待ち）
+#define LINK_SPEED_RETRY_MS             5000    // 相手が答えないときの再挑戦間隔
+
+// 試す順（ESP32 の UART は APB 80MHz の分周なので 5Mbaud まで）
+static const uint32_t LINK_SPEED_LADDER[] = {
+    4000000, 2000000, 1500000, 921600, 460800, 230400, 115200
+};
+#define LINK_SPEED_LADDER_SIZE  (sizeof(LINK_SPEED_LADDER) / sizeof(LINK_SPEED_LADDER[0]))
+
+// LinkSpeedMsg_t.op
+#define LINK_SPEED_OP_PROPOSE   1
+#define LINK_SPEED_OP_ACCEPT    2
+#define LINK_SPEED_OP_REJECT    3
+#define LINK_SPEED_OP_PROBE     4
+#define LINK_SPEED_OP_PROBE_END 5
+#define LINK_SPEED_OP_REPORT    6
+#define LINK_SPEED_OP_COMMIT    7
+#define LINK_SPEED_OP_DOWNGRADE 8
+#define LINK_SPEED_OP_ALIVE     9
+
+typedef enum {
+    LINK_SPEED_IDLE = 0,        // 基準のボーレート（交渉前・相手が答えない）
+    LINK_SPEED_PROPOSING,       // 起動側: PROPOSE の返事待ち
+    LINK_SPEED_SETTLING,        // 起動側: 切り替えた直後
+    LINK_SPEED_PROBING,         // 起動側: PROBE を送って REPORT 待ち
+    LINK_SPEED_TRIAL,           // 応答側: 切り替えて COMMIT 待ち
+    LINK_SPEED_RUNNING          // 確定
+} LinkSpeedState_t;
+
+typedef struct {
+    uint32_t negotiations;      // 確定した交渉
+    uint32_t trialFailures;     // PROBE が揃わなかった・REPORT が来なかった
+    uint32_t rejects;           // 相手が対応していなかった
+    uint32_t errorFallbacks;    // エラー率で下げた
+    uint32_t silenceFallbacks;  // 無通信で基準に戻った
+    uint32_t probesReceived;    // 応答側: 正しく届いた PROBE
+    uint32_t txBytes;           // 交渉・ALIVE で送ったバイト数
+} LinkSpeedStats_t;
+
+// =============================================================================
+// 交渉本体
+// =============================================================================
+class LinkSpeed {
+public:
+    LinkSpeed() { begin(false, 115200, 115200, 0); }
+
+    // initiator: 交渉を始める側（上流のボード）。maxBaud は配線が許す上限
+    void begin(bool initiator, uint32_t baseBaud, uint32_t maxBaud, uint32_t now) {
+        _initiator = initiator;
+        _baseBaud = baseBaud;
+        _baud = baseBaud;
+        _prevBaud = baseBaud;
+        _state = LINK_SPEED_IDLE;
+        _baseIndex = LINK_SPEED_LADDER_SIZE - 1;
+        _topIndex = _baseIndex;
+        for (uint8_t i = 0; i < LINK_SPEED_LADDER_SIZE; i++) {
+            if (LINK_SPEED_LADDER[i] == baseBaud) _baseIndex = i;
+        }
+        for (uint8_t i = LINK_SPEED_LADDER_SIZE; i-- > 0;) {
+            if (LINK_SPEED_LADDER[i] <= maxBaud) _topIndex = i;
+        }
+        if (_topIndex > _baseIndex) _topIndex = _baseIndex;
+        _ceiling = _topIndex;
+        _candidate = _topIndex;
+        _token = (uint8_t)now;
+        _tries = 0;
+        _deadlineMs = now + LINK_SPEED_START_MS;
+        _lastRxMs = now;
+        _lastTxMs = now;
+        _probeGood = 0;
+        _badWindows = 0;
+        _windowStartMs = now;
+        _windowPackets = 0;
+        _windowErrors = 0;
+        _windowRxBytes = 0;
+        _windowTxBytes = 0;
+        _windowPrimed = false;
+        _seenPackets = 0;
+        _rxBytesPerS = 0;
+        _txBytesPerS = 0;
+        _errorPermille = 0;
+        _rxErrors = 0;
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    uint32_t baud() const { return _baud; }
+    LinkSpeedState_t state() const { return _state; }
+    const LinkSpeedStats_t& stats() const { return _stats; }
+    bool initiator() const { return _initiator; }
+
+    // 交渉が終わって基準より速く動いている
+    bool boosted() const { return _state == LINK_SPEED_RUNNING && _baud != _baseBaud; }
+
+    // CMD_LINK_SPEED を受け取ったとき
+    template <typename SerialT>
+    void receive(SerialT& serial, const PacketView_t& packet, uint32_t now) {
+        if (packet.length < sizeof(LinkSpeedMsg_t)) return;
+        LinkSpeedMsg_t msg;
+        memcpy(&msg, packet.data, sizeof(msg));
+        _lastRxMs = now;
+
+        if (_initiator) receiveAsInitiator(serial, msg, now);
+        else receiveAsResponder(serial, msg, packet, now);
+    }
+
+    // 毎ループ呼ぶ。rx は同じ UART のパーサー統計、txBytes はほかの送信の累計
+    template <typename SerialT>
+    void poll(SerialT& serial, uint32_t now, const ParserStats_t& rx, uint32_t txBytes) {
+        observe(now, rx, txBytes);
+        checkErrorRate(serial, now);
+
+        // 速いボーレートで相手を見失ったら基準へ（相手も同じく戻ってくる）
+        if (_baud != _baseBaud && (int32_t)(now - _lastRxMs) >= LINK_SPEED_SILENCE_MS &&
+            _state != LINK_SPEED_SETTLING && _state != LINK_SPEED_PROBING) {
+            _stats.silenceFallbacks++;
+            setBaud(serial, _baseBaud);
+            _state = LINK_SPEED_IDLE;
+            _lastRxMs = now;
+            _deadlineMs = now + LINK_SPEED_START_MS;
+        }
+
+        switch (_state) {
+            case LINK_SPEED_IDLE:
+                if (_initiator && (int32_t)(now - _deadlineMs) >= 0) {
+                    startProposal(serial, _ceiling, now);
+                }
+                break;
+
+            case LINK_SPEED_PROPOSING:
+                if ((int32_t)(now - _deadlineMs) < 0) break;
+                if (_tries < LINK_SPEED_PROPOSE_TRIES) {
+                    sendPropose(serial, now);
+                    break;
+                }
+                // 返事がない: 速いボーレートのままなら基準に戻って出直す
+                // （相手はまだこちらの化けたフレームを受けているので、無通信で戻るのを待つ）
+                if (_baud != _baseBaud) {
+                    _stats.silenceFallbacks++;
+                    setBaud(serial, _baseBaud);
+                    _deadlineMs = now + LINK_SPEED_SILENCE_MS;
+                } else {
+                    _deadlineMs = now + LINK_SPEED_RETRY_MS;
+                }
+                _state = LINK_SPEED_IDLE;
+                break;
+
+            case LINK_SPEED_SETTLING:
+                if ((int32_t)(now - _deadlineMs) >= 0) sendProbes(serial, now);
+                break;
+
+            case LINK_SPEED_PROBING:
+                if ((int32_t)(now - _deadlineMs) >= 0) failTrial(serial, now);
+                break;
+
+            case LINK_SPEED_TRIAL:
+                // COMMIT が来なかった: 元のボーレートで次の PROPOSE を待つ
+                if ((int32_t)(now - _deadlineMs) >= 0) revertTrial(serial, now);
+                break;
+
+            case LINK_SPEED_RUNNING:
+                if (_baud != _baseBaud && now - _lastTxMs >= LINK_SPEED_KEEPALIVE_MS) {
+                    sendMessage(serial, LINK_SPEED_OP_ALIVE, _token, _baud, 0, now);
+                }
+                break;
+        }
+    }
+
+    // CMD_STATUS_RESP に載せる状態
+    void fillStatus(LinkStatusData_t* out, uint8_t link) const {
+        out->link = link;
+        out->state = (uint8_t)_state;
+        out->baud = _baud;
+        out->rx_bytes_per_s = _rxBytesPerS;
+        out->tx_bytes_per_s = _txBytesPerS;
+        out->rx_error_permille = (uint16_t)_errorPermille;
+        out->negotiations = (uint16_t)_stats.negotiations;
+        out->fallbacks = (uint16_t)(_stats.errorFallbacks + _stats.silenceFallbacks);
+        out->trial_failures = (uint16_t)_stats.trialFailures;
+        out->rx_errors = _rxErrors;
+    }
+
+    // fillStatus() の状態を1行で（board: その状態を見ているボード）
+    static void printStatus(Print& out, const char* board, const LinkStatusData_t& status) {
+        out.printf("  [%s] %s: %lu baud (%s), 受信 %lu B/s, 送信 %lu B/s, エラー率 %u/1000 (累計 %lu), "
+                   "交渉 %u, 下げた %u, 試験失敗 %u\n",
+                   board, status.link == LINK_MAIN_UPPER ? "メイン↔上半身" : "上半身↔下半身",
+                   (unsigned long)status.baud, stateName(status.state),
+                   (unsigned long)status.rx_bytes_per_s, (unsigned long)status.tx_bytes_per_s,
+                   status.rx_error_permille, (unsigned long)status.rx_errors,
+                   status.negotiations, status.fallbacks, status.trial_failures);
+    }
+
+    static const char* stateName(uint8_t state) {
+        switch (state) {
+            case LINK_SPEED_IDLE:       return "基準";
+            case LINK_SPEED_PROPOSING:  return "提案中";
+            case LINK_SPEED_SETTLING:   return "切替中";
+            case LINK_SPEED_PROBING:    return "確認中";     // 起動側: 新しい速さで PROBE を送った
+            case LINK_SPEED_TRIAL:      return "試用中";     // 応答側: 新しい速さで COMMIT 待ち
+            case LINK_SPEED_RUNNING:    return "確定";
+        }
+        return "?";
+    }
+
+private:
+    // -------------------------------------------------------------------------
+    // 送信
+    // -------------------------------------------------------------------------
+    template <typename SerialT>
+    void sendMessage(SerialT& serial, uint8_t op, uint8_t token, uint32_t baud, uint16_t value,
+                     uint32_t now, uint8_t patternLength = 0) {
+        uint8_t data[PACKET_V2_MAX_DATA];
+        LinkSpeedMsg_t msg = {op, token, baud, value};
+        memcpy(data, &msg, sizeof(msg));
+        for (uint8_t i = 0; i < patternLength; i++) {
+            data[sizeof(msg) + i] = probePattern(token, value, i);
+        }
+        uint8_t frame[PACKET_MAX_SIZE];
+        uint8_t length = buildPacketV2(frame, 0, 0, 0, CMD_LINK_SPEED, data,
+                                       (uint8_t)(sizeof(msg) + patternLength));
+        serial.write(frame, length);
+        _stats.txBytes += length;
+        _lastTxMs = now;
+    }
+
+    // 0x55/0xAA の交互と START/END に似たバイトを混ぜる（ビット境界のずれが出やすい並び）
+    static uint8_t probePattern(uint8_t token, uint16_t index, uint8_t i) {
+        static const uint8_t BASE[] = {0x55, 0xAA, 0x00, 0xFF, 0xAB, 0x0F, 0xF0, 0x33};
+        return (uint8_t)(BASE[i & 7] ^ (uint8_t)(token + index * 29 + (i >> 3) * 101));
+    }
+
+    template <typename SerialT>
+    void setBaud(SerialT& serial, uint32_t baud) {
+        if (baud == _baud) return;
+        serial.flush();         // 送信中のバイトを古いボーレートで出し切る
+        serial.updateBaudRate(baud);
+        _baud = baud;
+        _windowPrimed = false;  // 切り替えをまたいだ窓は判定しない
+        _badWindows = 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // 起動側
+    // -------------------------------------------------------------------------
+    template <typename SerialT>
+    void startProposal(SerialT& serial, uint8_t index, uint32_t now) {
+        _candidate = index;
+        _token++;
+        _tries = 0;
+        _state = LINK_SPEED_PROPOSING;
+        sendPropose(serial, now);
+    }
+
+    template <typename SerialT>
+    void sendPropose(SerialT& serial, uint32_t now) {
+        _tries++;
+        sendMessage(serial, LINK_SPEED_OP_PROPOSE, _token, LINK_SPEED_LADDER[_candidate], 0, now);
+        _deadlineMs = now + LINK_SPEED_REPLY_MS;
+    }
+
+    template <typename SerialT>
+    void sendProbes(SerialT& serial, uint32_t now) {
+        uint8_t patternLength = PACKET_V2_MAX_DATA - sizeof(LinkSpeedMsg_t);
+        uint32_t baud = LINK_SPEED_LADDER[_candidate];
+        for (uint16_t i = 0; i < LINK_SPEED_PROBES; i++) {
+            sendMessage(serial, LINK_SPEED_OP_PROBE, _token, baud, i, now, patternLength);
+        }
+        sendMessage(serial, LINK_SPEED_OP_PROBE_END, _token, baud, LINK_SPEED_PROBES, now);
+        // 送信バッファに積んだ分が出ていく時間も待つ
+        uint32_t airMs = (uint32_t)((uint64_t)(LINK_SPEED_PROBES + 1) * PACKET_MAX_SIZE * 10 * 1000 / baud) + 1;
+        _state = LINK_SPEED_PROBING;
+        _deadlineMs = now + airMs + LINK_SPEED_REPORT_MS;
+    }
+
+    template <typename SerialT>
+    void failTrial(SerialT& serial, uint32_t now) {
+        _stats.trialFailures++;
+        setBaud(serial, _prevBaud);
+        if (_candidate < _baseIndex) {
+            _ceiling = _candidate + 1;
+            startProposal(serial, _ceiling, now);
+        } else {
+            _state = LINK_SPEED_IDLE;
+            _deadlineMs = now + LINK_SPEED_RETRY_MS;
+        }
+    }
+
+    template <typename SerialT>
+    void stepDown(SerialT& serial, uint32_t now) {
+        uint8_t index = currentIndex();
+        if (index >= _baseIndex) return;
+        _stats.errorFallbacks++;
+        _ceiling = index + 1;
+        startProposal(serial, _ceiling, now);
+    }
+
+    template <typename SerialT>
+    void receiveAsInitiator(SerialT& serial, const LinkSpeedMsg_t& msg, uint32_t now) {
+        if (msg.op == LINK_SPEED_OP_DOWNGRADE) {
+            if (_state == LINK_SPEED_RUNNING && msg.baud == _baud) stepDown(serial, now);
+            return;
+        }
+        if (msg.token != _token || msg.baud != LINK_SPEED_LADDER[_candidate]) return;
+
+        switch (msg.op) {
+            case LINK_SPEED_OP_ACCEPT:
+                if (_state != LINK_SPEED_PROPOSING) return;
+                _prevBaud = _baud;
+                setBaud(serial, msg.baud);
+                _state = LINK_SPEED_SETTLING;
+                _deadlineMs = now + LINK_SPEED_SETTLE_MS;
+                break;
+
+            case LINK_SPEED_OP_REJECT:
+                if (_state != LINK_SPEED_PROPOSING) return;
+                _stats.rejects++;
+                if (_candidate < _baseIndex) {
+                    _ceiling = _candidate + 1;
+                    startProposal(serial, _ceiling, now);
+                } else {
+                    _state = LINK_SPEED_IDLE;
+                    _deadlineMs = now + LINK_SPEED_RETRY_MS;
+                }
+                break;
+
+            case LINK_SPEED_OP_REPORT:
+                if (_state != LINK_SPEED_PROBING) return;
+                if (msg.value < LINK_SPEED_PROBES) {
+                    failTrial(serial, now);
+                    return;
+                }
+                for (uint8_t i = 0; i < LINK_SPEED_COMMIT_REPEAT; i++) {
+                    sendMessage(serial, LINK_SPEED_OP_COMMIT, _token, _baud, 0, now);
+                }
+                _stats.negotiations++;
+                _state = LINK_SPEED_RUNNING;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // 応答側
+    // -------------------------------------------------------------------------
+    template <typename SerialT>
+    void receiveAsResponder(SerialT& serial, const LinkSpeedMsg_t& msg, const PacketView_t& packet,
+                            uint32_t now) {
+        switch (msg.op) {
+            case LINK_SPEED_OP_PROPOSE: {
+                if (_state == LINK_SPEED_TRIAL) return;     // 試験中の古いボーレートの再送
+                uint8_t index = ladderIndex(msg.baud);
+                if (index > _baseIndex || index < _topIndex) {
+                    sendMessage(serial, LINK_SPEED_OP_REJECT, msg.token, msg.baud, 0, now);
+                    return;
+                }
+                sendMessage(serial, LINK_SPEED_OP_ACCEPT, msg.token, msg.baud, 0, now);
+                _prevBaud = _baud;
+                setBaud(serial, msg.baud);
+                _token = msg.token;
+                _probeGood = 0;
+                _state = LINK_SPEED_TRIAL;
+                _deadlineMs = now + LINK_SPEED_TRIAL_MS;
+                break;
+            }
+
+            case LINK_SPEED_OP_PROBE:
+                if (_state != LINK_SPEED_TRIAL || msg.token != _token) return;
+                if (probeIntact(msg, packet)) {
+                    _probeGood++;
+                    _stats.probesReceived++;
+                }
+                break;
+
+            case LINK_SPEED_OP_PROBE_END:
+                if (_state != LINK_SPEED_TRIAL || msg.token != _token) return;
+                sendMessage(serial, LINK_SPEED_OP_REPORT, _token, _baud, _probeGood, now);
+                // 足りなければ起動側も元に戻すので、TRIAL_MS を待たずに戻って次の PROPOSE を待つ
+                if (_probeGood < LINK_SPEED_PROBES) revertTrial(serial, now);
+                break;
+
+            case LINK_SPEED_OP_COMMIT:
+                if (_state != LINK_SPEED_TRIAL || msg.token != _token || msg.baud != _baud) return;
+                _stats.negotiations++;
+                _state = LINK_SPEED_RUNNING;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    template <typename SerialT>
+    void revertTrial(SerialT& serial, uint32_t now) {
+        setBaud(serial, _prevBaud);
+        _state = _prevBaud == _baseBaud ? LINK_SPEED_IDLE : LINK_SPEED_RUNNING;
+        _lastRxMs = now;
+    }
+
+    bool probeIntact(const LinkSpeedMsg_t& msg, const PacketView_t& packet) const {
+        uint8_t patternLength = PACKET_V2_MAX_DATA - sizeof(LinkSpeedMsg_t);
+        if (packet.length != sizeof(LinkSpeedMsg_t) + patternLength || msg.baud != _baud) return false;
+        const uint8_t* pattern = packet.data + sizeof(LinkSpeedMsg_t);
+        for (uint8_t i = 0; i < patternLength; i++) {
+            if (pattern[i] != probePattern(msg.token, msg.value, i)) return false;
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // エラー率・スループットの集計
+    // -------------------------------------------------------------------------
+    void observe(uint32_t now, const ParserStats_t& rx, uint32_t txBytes) {
+        uint32_t errors = rx.checksumErrors + rx.framingErrors;
+        uint32_t tx = txBytes + _stats.txBytes;
+        if (rx.packets != _seenPackets) {
+            _seenPackets = rx.packets;
+            _lastRxMs = now;
+        }
+
+        uint32_t elapsed = now - _windowStartMs;
+        if (_windowPrimed && elapsed < LINK_SPEED_WINDOW_MS) return;
+
+        if (_windowPrimed && elapsed > 0) {
+            uint32_t packets = rx.packets - _windowPackets;
+            uint32_t badFrames = errors - _windowErrors;
+            _rxBytesPerS = (uint32_t)((uint64_t)(rx.bytes - _windowRxBytes) * 1000 / elapsed);
+            _txBytesPerS = (uint32_t)((uint64_t)(tx - _windowTxBytes) * 1000 / elapsed);
+            _errorPermille = packets + badFrames ? badFrames * 1000 / (packets + badFrames) : 0;
+            _rxErrors += badFrames;
+
+            bool judged = _state == LINK_SPEED_RUNNING && packets + badFrames >= LINK_SPEED_MIN_WINDOW_FRAMES;
+            if (judged && _errorPermille > LINK_SPEED_MAX_ERROR_PERMILLE) _badWindows++;
+            else if (judged) _badWindows = 0;
+        }
+        _windowStartMs = now;
+        _windowPackets = rx.packets;
+        _windowErrors = errors;
+        _windowRxBytes = rx.bytes;
+        _windowTxBytes = tx;
+        _windowPrimed = true;
+    }
+
+    template <typename SerialT>
+    void checkErrorRate(SerialT& serial, uint32_t now) {
+        if (_badWindows < LINK_SPEED_BAD_WINDOWS || _state != LINK_SPEED_RUNNING) return;
+        _badWindows = 0;
+        if (_initiator) stepDown(serial, now);
+        else if (_baud != _baseBaud) sendMessage(serial, LINK_SPEED_OP_DOWNGRADE, _token, _baud, 0, now);
+    }
+
+    static uint8_t ladderIndex(uint32_t baud) {
+        for (uint8_t i = 0; i < LINK_SPEED_LADDER_SIZE; i++) {
+            if (LINK_SPEED_LADDER[i] == baud) return i;
+        }
+        return 0xFF;
+    }
+
+    uint8_t currentIndex() const {
+        uint8_t index = ladderIndex(_baud);
+        return index == 0xFF ? _baseIndex : index;
+    }
+
+    bool _initiator;
+    uint32_t _baseBaud;
+    uint32_t _baud;
+    uint32_t _prevBaud;         // 試験に落ちたら戻るボーレート
+    LinkSpeedState_t _state;
+    uint8_t _baseIndex;         // LINK_SPEED_LADDER 上の位置
+    uint8_t _topIndex;          // 配線の上限
+    uint8_t _ceiling;           // 次に試す上限（試験に落ちる・エラー率で下げるたびに下がる）
+    uint8_t _candidate;
+    uint8_t _token;
+    uint8_t _tries;
+    uint32_t _deadlineMs;
+    uint32_t _lastRxMs;
+    uint32_t _lastTxMs;
+    uint16_t _probeGood;
+    uint8_t _badWindows;
+
+    uint32_t _windowStartMs;
+    uint32_t _windowPackets;
+    uint32_t _windowErrors;
+    uint32_t _windowRxBytes;
+    uint32_t _windowTxBytes;
+    bool _windowPrimed;
+    uint32_t _seenPackets;      // 無通信の判定用（どのパケットでも届けば更新）
+    uint32_t _rxBytesPerS;
+    uint32_t _txBytesPerS;
+    uint32_t _errorPermille;
+    uint32_t _rxErrors;
+
+    LinkSpeedStats_t _stats;
+};
+
+#endif // COROSUKE_LINK_SPEED_H
@@ -0,0 +1,183 @@
+/**
+ * コロ助ロボット - リップシンク振幅抽出
+ * Corosuke Robot - Lip-Sync Envelope Extraction
+ *
+ * デコード済みの PCM（ESP32-audioI2S の audio_process_i2s コールバック）から
+ * サーボ更新周期ごとの RMS を求め、口の開き具合 (0-255) に変換する。
+ *
+ * - 二乗和は窓の途中でもバッファごとに足し込むだけ（コピーなし）
+ * - ESP32-S3 では esp-dsp の内積（MAC 命令）で二乗和を求める
+ * - dBFS で口の開きに割り当て、閉じる側だけ緩やかにする（パクパクしすぎない）
+ * - 結果は SPSC キューで渡すので、コールバックがオーディオタスクで動いても
+ *   loop() 側はロックなしで取り出せる
+ */
+
+#ifndef COROSUKE_LIPSYNC_H
+#define COROSUKE_LIPSYNC_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "spsc_queue.h"
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && __has_include(<dsps_dotprod.h>)
+#include <dsps_dotprod.h>
+#define LIPSYNC_USE_ESP_DSP     1
+#else
+#define LIPSYNC_USE_ESP_DSP     0
+#endif
+
+#define LIPSYNC_FLOOR_DB        -45.0f  // これより小さい音は口を閉じる
+#define LIPSYNC_CEIL_DB         -9.0f   // これ以上で全開
+#define LIPSYNC_RELEASE_Q8      128     // 閉じるときの1窓あたりの減衰 (0.5)
+#define LIPSYNC_CLOSE_LEVEL     12      // 減衰がこれを下回ったら閉じる
+#define LIPSYNC_QUEUE_DEPTH     8
+
+// esp-dsp の内積は結果が int16 なので、128 サンプルずつ 2^23 で割って受け取る
+// （量子化の下限は -45dBFS 付近で、LIPSYNC_FLOOR_DB と同じ）
+#define LIPSYNC_DSP_BLOCK       128
+#define LIPSYNC_DSP_SHIFT       (-8)    // 結果 = 二乗和 >> (15 - shift)
+
+typedef struct {
+    uint32_t buffers;           // process() 呼び出し回数
+    uint32_t frames;            // 処理したフレーム数
+    uint32_t windows;           // 出力した振幅の数
+    uint32_t dropped;           // キュー満杯で捨てた振幅
+    uint32_t busyUs;            // process() の累積処理時間
+    uint32_t maxBusyUs;
+} LipSyncStats_t;
+
+class LipSync {
+public:
+    LipSync() { memset(&_stats, 0, sizeof(_stats)); }
+
+    void begin(uint32_t sampleRate, uint32_t windowMs) {
+        _windowMs = windowMs;
+        setSampleRate(sampleRate);
+        memset(&_stats, 0, sizeof(_stats));
+        reset();
+    }
+
+    void setSampleRate(uint32_t sampleRate) {
+        if (sampleRate == 0 || sampleRate == _sampleRate) return;
+        _sampleRate = sampleRate;
+        _windowFrames = sampleRate * _windowMs / 1000;
+        if (_windowFrames == 0) _windowFrames = 1;
+    }
+
+    uint32_t sampleRate() const { return _sampleRate; }
+
+    // 発話の区切りで呼ぶ（窓の途中の値と包絡線を捨てる）
+    void reset() {
+        _sum = 0;
+        _frames = 0;
+        _samples = 0;
+        _envelope = 0;
+    }
+
+    // オーディオコールバックから呼ぶ。samples はインターリーブされた 16bit PCM
+    void process(const int16_t* samples, uint32_t frames, uint8_t channels) {
+        uint32_t start = micros();
+        _stats.buffers++;
+        _stats.frames += frames;
+
+        while (frames > 0) {
+            uint32_t take = _windowFrames - _frames;
+            if (take > frames) take = frames;
+            _sum += sumSquares(samples, take * channels);
+            _samples += take * channels;
+            _frames += take;
+            samples += take * channels;
+            frames -= take;
+
+            if (_frames >= _windowFrames) finishWindow();
+        }
+
+        uint32_t busy = micros() - start;
+        _stats.busyUs += busy;
+        if (busy > _stats.maxBusyUs) _stats.maxBusyUs = busy;
+    }
+
+    // loop() から呼ぶ: 窓ごとの口の開き具合 (0-255)
+    bool pop(uint8_t* level) {
+        return _queue.pop(level);
+    }
+
+    const LipSyncStats_t& stats() const { return _stats; }
+
+    // 再生時間に対する process() の CPU 使用率 (%)
+    float cpuPercent() const {
+        if (_stats.frames == 0 || _sampleRate == 0) return 0.0f;
+        float audioUs = _stats.frames * 1e6f / _sampleRate;
+        return 100.0f * _stats.busyUs / audioUs;
+    }
+
+    // 二乗和（ESP32-S3 は esp-dsp、それ以外は 4 系統に分けてベクトル化しやすく）
+    static uint64_t sumSquares(const int16_t* x, uint32_t n) {
+        uint64_t sum = 0;
+#if LIPSYNC_USE_ESP_DSP
+        while (n >= LIPSYNC_DSP_BLOCK) {
+            int16_t part = 0;
+            dsps_dotprod_s16(x, x, &part, LIPSYNC_DSP_BLOCK, LIPSYNC_DSP_SHIFT);
+            sum += (uint64_t)(uint16_t)part << (15 - LIPSYNC_DSP_SHIFT);
+            x += LIPSYNC_DSP_BLOCK;
+            n -= LIPSYNC_DSP_BLOCK;
+        }
+#endif
+        uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+        uint32_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            a0 += (uint32_t)(x[i] * x[i]);
+            a1 += (uint32_t)(x[i + 1] * x[i + 1]);
+            a2 += (uint32_t)(x[i + 2] * x[i + 2]);
+            a3 += (uint32_t)(x[i + 3] * x[i + 3]);
+        }
+        for (; i < n; i++) {
+            a0 += (uint32_t)(x[i] * x[i]);
+        }
+        return sum + a0 + a1 + a2 + a3;
+    }
+
+    // RMS (dBFS) → 0-255
+    static uint8_t levelFromRms(float rms) {
+        if (rms < 1.0f) return 0;
+        float db = 20.0f * log10f(rms / 32768.0f);
+        float x = (db - LIPSYNC_FLOOR_DB) / (LIPSYNC_CEIL_DB - LIPSYNC_FLOOR_DB);
+        if (x <= 0.0f) return 0;
+        if (x >= 1.0f) return 255;
+        return (uint8_t)(x * 255.0f + 0.5f);
+    }
+
+private:
+    void finishWindow() {
+        float rms = _samples ? sqrtf((float)_sum / _samples) : 0.0f;
+        uint8_t level = levelFromRms(rms);
+
+        // 開くときはすぐ、閉じるときは緩やかに
+        uint16_t decayed = (uint16_t)((_envelope * LIPSYNC_RELEASE_Q8) >> 8);
+        if (decayed < LIPSYNC_CLOSE_LEVEL) decayed = 0;
+        _envelope = level > decayed ? level : (uint8_t)decayed;
+
+        _stats.windows++;
+        if (!_queue.push(_envelope)) _stats.dropped++;
+
+        _sum = 0;
+        _samples = 0;
+        _frames = 0;
+    }
+
+    uint32_t _sampleRate = 0;
+    uint32_t _windowMs = 20;
+    uint32_t _windowFrames = 1;
+
+    uint64_t _sum = 0;
+    uint32_t _samples = 0;
+    uint32_t _frames = 0;
+    uint8_t _envelope = 0;
+
+    SpscQueue<uint8_t, LIPSYNC_QUEUE_DEPTH> _queue;
+    LipSyncStats_t _stats;
+};
+
+#endif // COROSUKE_LIPSYNC_H
@@ -0,0 +1,272 @@
+/**
+ * コロ助ロボット - ストリーミングパケットパーサー
+ * Corosuke Robot - Streaming Packet Parser
+ *
+ * UARTから受信可能なバイトをまとめてリングバッファへ読み込み、
+ * 完成したパケットをコピーなしのビューとして返す。
+ *
+ * - リング先頭 PACKET_MAX_SIZE バイトを末尾にミラーしているため、
+ *   どの位置から始まるパケットも連続したメモリとして参照できる
+ * - フレーム異常時は START 1バイトだけ読み飛ばして再同期するので、
+ *   壊れたパケットの直後にある正常なパケットを失わない
+ * - v1（XOR チェックサム）と v2（CTRL/SEQ/ACK + CRC-16）のどちらも受け付ける
+ */
+
+#ifndef COROSUKE_PACKET_PARSER_H
+#define COROSUKE_PACKET_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+
+// リングバッファサイズ（2のべき乗）
+#ifndef PACKET_PARSER_RING_SIZE
+#define PACKET_PARSER_RING_SIZE 512
+#endif
+
+#if (PACKET_PARSER_RING_SIZE & (PACKET_PARSER_RING_SIZE - 1)) != 0
+#error "PACKET_PARSER_RING_SIZE must be a power of two"
+#endif
+
+// 受信が途切れてから未完成パケットを諦めるまでの時間
+#define UART_IDLE_RESYNC_MS 5
+
+// =============================================================================
+// パケットビュー（次の readFrom()/write() 呼び出しまで有効）
+// =============================================================================
+typedef struct {
+    uint8_t cmd;
+    uint8_t length;             // データ長
+    const uint8_t* data;        // データ部
+    const uint8_t* frame;       // START〜END までのフレーム全体
+    uint8_t frameLength;
+    uint8_t version;            // 1 または 2
+    uint8_t ctrl;               // PACKET_V2_*（v1 は 0）
+    uint8_t seq;                // ctrl & PACKET_V2_RELIABLE のとき有効
+    uint8_t ack;                // ctrl & PACKET_V2_ACK のとき有効
+} PacketView_t;
+
+typedef struct {
+    uint32_t packets;           // 正常に取り出したパケット数
+    uint32_t v2Packets;         // そのうち v2 フレーム
+    uint32_t checksumErrors;    // チェックサム・CRC 不一致
+    uint32_t framingErrors;     // 長さ異常・END不一致
+    uint32_t resyncBytes;       // 再同期で読み飛ばしたバイト数
+    uint32_t overflows;         // リング満杯で捨てたバイト数（write()のみ）
+    uint32_t bytes;             // リングに取り込んだバイト数
+} ParserStats_t;
+
+// =============================================================================
+// パーサー本体
+// =============================================================================
+class PacketParser {
+public:
+    PacketParser() { reset(); }
+
+    void reset() {
+        _head = 0;
+        _tail = 0;
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    size_t buffered() const { return _head - _tail; }
+    size_t space() const { return PACKET_PARSER_RING_SIZE - buffered(); }
+    const ParserStats_t& stats() const { return _stats; }
+
+    // シリアルから受信可能なバイトをまとめて読み込む
+    // （入りきらない分はUARTドライバ側に残るので失われない）
+    template <typename SerialT>
+    size_t readFrom(SerialT& serial) {
+        size_t total = 0;
+        while (space() > 0) {
+            int available = serial.available();
+            if (available <= 0) break;
+
+            size_t pos = _head & RING_MASK;
+            size_t chunk = PACKET_PARSER_RING_SIZE - pos;
+            if (chunk > space()) chunk = space();
+            if (chunk > (size_t)available) chunk = (size_t)available;
+
+            size_t n = serial.read(&_ring[pos], chunk);
+            if (n == 0) break;
+            mirror(pos, n);
+            _head += n;
+            total += n;
+        }
+        _stats.bytes += (uint32_t)total;
+        return total;
+    }
+
+    // バイト列を投入する（テスト・ベンチマーク用）
+    size_t write(const uint8_t* data, size_t length) {
+        size_t accepted = length < space() ? length : space();
+        _stats.overflows += (uint32_t)(length - accepted);
+
+        size_t done = 0;
+        while (done < accepted) {
+            size_t pos = _head & RING_MASK;
+            size_t chunk = PACKET_PARSER_RING_SIZE - pos;
+            if (chunk > accepted - done) chunk = accepted - done;
+            memcpy(&_ring[pos], &data[done], chunk);
+            mirror(pos, chunk);
+            _head += chunk;
+            done += chunk;
+        }
+        _stats.bytes += (uint32_t)accepted;
+        return accepted;
+    }
+
+    // 完成したパケットを1つ取り出す
+    bool next(PacketView_t* view) {
+        for (;;) {
+            if (!seekStart()) return false;
+
+            size_t avail = buffered();
+            if (avail < 2) return false;
+
+            const uint8_t* frame = &_ring[_tail & RING_MASK];
+            if (frame[0] == PACKET_START_V2) {
+                int result = parseV2(frame, avail, view);
+                if (result > 0) return true;
+                if (result == 0) return false;
+                continue;
+            }
+
+            uint8_t length = frame[1];
+            uint8_t frameLength = length + 4;   // START + LENGTH + (CMD + DATA) + CHECKSUM + END
+
+            if (length == 0 || length + 4 > PACKET_MAX_SIZE) {
+                _stats.framingErrors++;
+                skip(1);
+                continue;
+            }
+            if (avail < frameLength) return false;
+
+            if (frame[frameLength - 1] != PACKET_END) {
+                _stats.framingErrors++;
+                skip(1);
+                continue;
+            }
+            if (calculateChecksum(&frame[1], length + 1) != frame[frameLength - 2]) {
+                _stats.checksumErrors++;
+                skip(1);
+                continue;
+            }
+
+            view->cmd = frame[2];
+            view->length = length - 1;
+            view->data = &frame[3];
+            view->frame = frame;
+            view->frameLength = frameLength;
+            view->version = 1;
+            view->ctrl = 0;
+            view->seq = 0;
+            view->ack = 0;
+            _tail += frameLength;
+            _stats.packets++;
+            return true;
+        }
+    }
+
+    // 受信が途切れたのに未完成パケットが残っている場合、その START を捨てて
+    // 後続バイトから再同期する（偽の START が正常パケットを塞ぐのを防ぐ）
+    bool resyncIfStalled() {
+        if (buffered() == 0) return false;
+        _stats.framingErrors++;
+        skip(1);
+        return true;
+    }
+
+private:
+    static const size_t RING_MASK = PACKET_PARSER_RING_SIZE - 1;
+
+    // 先頭 PACKET_MAX_SIZE バイトを末尾にミラーする
+    void mirror(size_t pos, size_t n) {
+        if (pos < PACKET_MAX_SIZE) {
+            size_t m = PACKET_MAX_SIZE - pos;
+            if (m > n) m = n;
+            memcpy(&_ring[PACKET_PARSER_RING_SIZE + pos], &_ring[pos], m);
+        }
+    }
+
+    // v2 フレームを1つ検査する。1=取り出した 0=データ待ち -1=読み飛ばした
+    int parseV2(const uint8_t* frame, size_t avail, PacketView_t* view) {
+        uint8_t length = frame[1];
+        uint8_t frameLength = length + 5;       // START + LENGTH + (CTRL〜DATA) + CRC16 + END
+        if (length < 2 || length + 5 > PACKET_MAX_SIZE) {
+            _stats.framingErrors++;
+            skip(1);
+            return -1;
+        }
+        if (avail < frameLength) return 0;
+
+        if (frame[frameLength - 1] != PACKET_END) {
+            _stats.framingErrors++;
+            skip(1);
+            return -1;
+        }
+        uint16_t crc = (uint16_t)(frame[frameLength - 3] | (frame[frameLength - 2] << 8));
+        if (crc16(&frame[1], length + 1) != crc) {
+            _stats.checksumErrors++;
+            skip(1);
+            return -1;
+        }
+
+        uint8_t ctrl = frame[2];
+        uint8_t idx = 3;
+        view->seq = (ctrl & PACKET_V2_RELIABLE) ? frame[idx++] : 0;
+        view->ack = (ctrl & PACKET_V2_ACK) ? frame[idx++] : 0;
+        if (idx > length + 1) {                 // CMD が入っていない
+            _stats.framingErrors++;
+            skip(1);
+            return -1;
+        }
+        view->cmd = frame[idx];
+        view->length = (uint8_t)(length + 1 - idx);
+        view->data = &frame[idx + 1];
+        view->frame = frame;
+        view->frameLength = frameLength;
+        view->version = 2;
+        view->ctrl = ctrl;
+        _tail += frameLength;
+        _stats.packets++;
+        _stats.v2Packets++;
+        return 1;
+    }
+
+    void skip(size_t n) {
+        _tail += n;
+        _stats.resyncBytes += (uint32_t)n;
+    }
+
+    // START バイト（v1/v2）まで読み飛ばす
+    bool seekStart() {
+        while (buffered() > 0) {
+            size_t pos = _tail & RING_MASK;
+            size_t span = PACKET_PARSER_RING_SIZE - pos;
+            if (span > buffered()) span = buffered();
+
+            const uint8_t* found = (const uint8_t*)memchr(&_ring[pos], PACKET_START, span);
+            size_t before = found ? (size_t)(found - &_ring[pos]) : span;
+            const uint8_t* foundV2 = (const uint8_t*)memchr(&_ring[pos], PACKET_START_V2, before);
+            if (foundV2) found = foundV2;
+            if (found) {
+                _stats.resyncBytes += (uint32_t)(found - &_ring[pos]);
+                _tail += (size_t)(found - &_ring[pos]);
+                return true;
+            }
+            _stats.resyncBytes += (uint32_t)span;
+            _tail += span;
+        }
+        return false;
+    }
+
+    uint8_t _ring[PACKET_PARSER_RING_SIZE + PACKET_MAX_SIZE];
+    size_t _head;
+    size_t _tail;
+    ParserStats_t _stats;
+};
+
+#endif // COROSUKE_PACKET_PARSER_H
@@ -0,0 +1,217 @@
+/**
+ * コロ助ロボット - 優先度付きパケット転送
+ * Corosuke Robot - Priority Packet Router
+ *
+ * 上半身ボードがメイン ↔ 下半身の間でフレームを中継するときの送信側。
+ * 受信したフレームは作り直さず、PacketParser のリング上のバイト列をそのまま送る。
+ *
+ * - UART の送信バッファに積むのは ROUTER_TX_BACKLOG バイトまで。
+ *   それより先は優先度ごとの待ち行列に置き、空いたら優先度の高い方から送る
+ *   （送信バッファに積んでしまったフレームは後から来たフレームに追い越されないので、
+ *   積む量を絞るほど歩行停止のようなコマンドが待たずに済む）
+ * - 待ち行列が空で送信バッファにも余裕があれば、受信リングから直接 write() する（コピーなし）
+ * - 待ち行列が一杯のとき: 動作コマンドと歩容テーブルは新しい方を断る（呼び出し側で数える）。
+ *   サーボフレームやセンサーデータは古い方を捨てる（新しい値で置き換わるので）。
+ *   断られたものは消えるので、確実に届けるコマンドは RoutedOutput 経由で ReliableLink から送る
+ * - 歩容テーブルは揃うまで差し替わらないので、1回分の転送が入る深さを別に取る
+ * - RoutedOutput を ReliableLink の出力先にすると、SEQ 付きのフレームも再送も同じ待ち行列に並ぶ
+ *
+ * 出力先は write(const uint8_t*, size_t) と availableForWrite() を持つもの（HardwareSerial など）。
+ */
+
+#ifndef COROSUKE_PACKET_ROUTER_H
+#define COROSUKE_PACKET_ROUTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+
+#define ROUTER_QUEUE_DEPTH      8       // 優先度ごとに待たせるフレーム数（2のべき乗）
+#define ROUTER_TRANSFER_DEPTH   32      // 歩容テーブル用（2のべき乗）
+#if (ROUTER_QUEUE_DEPTH & (ROUTER_QUEUE_DEPTH - 1)) != 0 || (ROUTER_TRANSFER_DEPTH & (ROUTER_TRANSFER_DEPTH - 1)) != 0
+#error "ROUTER_QUEUE_DEPTH / ROUTER_TRANSFER_DEPTH must be powers of two"
+#endif
+#define ROUTER_TX_BACKLOG       128     // UART の送信バッファに先に積んでおくバイト数の上限
+#define UART_HW_FIFO_SIZE       128     // ESP32 の UART 送信 FIFO
+
+typedef enum {
+    ROUTE_MOTION = 0,           // 歩行・姿勢コマンド（1回きり、最優先）
+    ROUTE_STREAM,               // サーボフレーム（古いものは捨ててよい）
+    ROUTE_TRANSFER,             // 歩容テーブルの分割転送（捨てられない）
+    ROUTE_BULK,                 // センサーデータ・ステータス
+    ROUTE_PRIORITIES
+} RoutePriority_t;
+
+// コマンドから優先度を決める
+static inline RoutePriority_t routePriority(uint8_t cmd) {
+    if (cmd == CMD_GAIT_TABLE) return ROUTE_TRANSFER;
+    if (cmd >= CMD_WALK_START && cmd <= 0x3F) return ROUTE_MOTION;
+    if (cmd >= CMD_SERVO_FRAME && cmd <= 0x7F) return ROUTE_STREAM;
+    return ROUTE_BULK;
+}
+
+// 組み立て済みのフレーム（v1 / v2）のコマンド
+static inline uint8_t routeFrameCommand(const uint8_t* frame) {
+    if (frame[0] != PACKET_START_V2) return frame[2];
+    uint8_t idx = 3;
+    if (frame[2] & PACKET_V2_RELIABLE) idx++;
+    if (frame[2] & PACKET_V2_ACK) idx++;
+    return frame[idx];
+}
+
+typedef struct {
+    uint32_t frames;                        // 送ったフレーム
+    uint32_t bytes;
+    uint32_t direct;                        // 待たずに受信リングから直接送ったフレーム
+    uint32_t queued;                        // 待ち行列を通ったフレーム
+    uint32_t dropped[ROUTE_PRIORITIES];     // 待ち行列が一杯で捨てた・断ったフレーム
+    uint32_t maxWaitMs[ROUTE_PRIORITIES];   // 待ち行列での最長待ち時間
+} RouterStats_t;
+
+// =============================================================================
+// ルーター本体（転送先の UART ごとに1つ）
+// =============================================================================
+class PacketRouter {
+public:
+    PacketRouter() { begin(UART_HW_FIFO_SIZE); }
+
+    // txCapacity: availableForWrite() が空のときに返す値（送信バッファ + FIFO）
+    void begin(size_t txCapacity) {
+        _txCapacity = txCapacity;
+        memset(_queues, 0, sizeof(_queues));
+        memset(&_stats, 0, sizeof(_stats));
+        Slot_t* slots = _slots;
+        for (uint8_t p = 0; p < ROUTE_PRIORITIES; p++) {
+            uint8_t depth = p == ROUTE_TRANSFER ? ROUTER_TRANSFER_DEPTH : ROUTER_QUEUE_DEPTH;
+            _queues[p].slots = slots;
+            _queues[p].depth = depth;
+            slots += depth;
+        }
+    }
+
+    const RouterStats_t& stats() const { return _stats; }
+
+    size_t pending(uint8_t priority) const {
+        return (uint8_t)(_queues[priority].tail - _queues[priority].head);
+    }
+
+    size_t pending() const {
+        size_t total = 0;
+        for (uint8_t p = 0; p < ROUTE_PRIORITIES; p++) total += pending(p);
+        return total;
+    }
+
+    // フレームを転送する。frame は送るまで有効でなくてよい（待たせるときはコピーする）
+    // 動作コマンド・歩容テーブルの待ち行列が一杯なら false
+    template <typename OutT>
+    bool forward(OutT& out, const uint8_t* frame, uint8_t length, RoutePriority_t priority, uint32_t now) {
+        if (length == 0 || length > PACKET_MAX_SIZE) return false;
+        pump(out, now);
+
+        // 先に待っているフレームがなければ受信リングから直接
+        if (pending() == 0 && backlogRoom(out) >= length) {
+            emit(out, frame, length);
+            _stats.direct++;
+            return true;
+        }
+
+        Queue_t& queue = _queues[priority];
+        if (pending(priority) >= queue.depth) {
+            _stats.dropped[priority]++;
+            if (priority == ROUTE_MOTION || priority == ROUTE_TRANSFER) return false;
+            queue.head++;       // 古い値は捨てる
+        }
+        Slot_t& slot = queue.slots[queue.tail & (queue.depth - 1)];
+        memcpy(slot.frame, frame, length);
+        slot.length = length;
+        slot.queuedMs = now;
+        queue.tail++;
+        return true;
+    }
+
+    // 送信バッファが空いた分だけ、優先度の高い方から送る（毎ループ呼ぶ）
+    template <typename OutT>
+    void pump(OutT& out, uint32_t now) {
+        for (uint8_t p = 0; p < ROUTE_PRIORITIES; p++) {
+            Queue_t& queue = _queues[p];
+            while (queue.head != queue.tail) {
+                Slot_t& slot = queue.slots[queue.head & (queue.depth - 1)];
+                if (backlogRoom(out) < slot.length) return;     // 低い優先度にも譲らない
+                emit(out, slot.frame, slot.length);
+                uint32_t waited = now - slot.queuedMs;
+                if (waited > _stats.maxWaitMs[p]) _stats.maxWaitMs[p] = waited;
+                _stats.queued++;
+                queue.head++;
+            }
+        }
+    }
+
+private:
+    typedef struct {
+        uint8_t frame[PACKET_MAX_SIZE];
+        uint8_t length;
+        uint32_t queuedMs;
+    } Slot_t;
+
+    typedef struct {
+        Slot_t* slots;          // _slots の中の自分の分
+        uint8_t depth;
+        uint8_t head;
+        uint8_t tail;
+    } Queue_t;
+
+    // 送信バッファにあと何バイト積んでよいか
+    template <typename OutT>
+    size_t backlogRoom(OutT& out) const {
+        int available = out.availableForWrite();
+        size_t queuedBytes = available >= 0 && (size_t)available < _txCapacity ? _txCapacity - available : 0;
+        return queuedBytes >= ROUTER_TX_BACKLOG ? 0 : ROUTER_TX_BACKLOG - queuedBytes;
+    }
+
+    template <typename OutT>
+    void emit(OutT& out, const uint8_t* frame, uint8_t length) {
+        out.write(frame, length);
+        _stats.frames++;
+        _stats.bytes += length;
+    }
+
+    size_t _txCapacity;
+    Queue_t _queues[ROUTE_PRIORITIES];
+    Slot_t _slots[ROUTER_QUEUE_DEPTH * (ROUTE_PRIORITIES - 1) + ROUTER_TRANSFER_DEPTH];
+    RouterStats_t _stats;
+};
+
+// =============================================================================
+// ReliableLink の出力先（書かれたフレームをコマンドの優先度で forward() する）
+// =============================================================================
+// 待ち行列が一杯で断られたフレームは捨てる。ACK が来ないので ReliableLink が送り直す
+template <typename OutT>
+class RoutedOutput {
+public:
+    RoutedOutput(PacketRouter& router, OutT& out) : _router(router), _out(out), _now(0), _refused(0) {}
+
+    // ReliableLink に渡す前に今の時刻を入れる（待ち時間の統計用）
+    RoutedOutput& at(uint32_t now) {
+        _now = now;
+        return *this;
+    }
+
+    size_t write(const uint8_t* frame, size_t length) {
+        if (length < 5 || length > PACKET_MAX_SIZE) return 0;
+        RoutePriority_t priority = routePriority(routeFrameCommand(frame));
+        if (!_router.forward(_out, frame, (uint8_t)length, priority, _now)) _refused++;
+        return length;
+    }
+
+    uint32_t refused() const { return _refused; }
+
+private:
+    PacketRouter& _router;
+    OutT& _out;
+    uint32_t _now;
+    uint32_t _refused;
+};
+
+#endif // COROSUKE_PACKET_ROUTER_H
@@ -0,0 +1,237 @@
+/**
+ * コロ助ロボット - カメラ人物検知
+ * Corosuke Robot - Camera Person Detector
+ *
+ * QQVGA (160x120) グレースケールのフレームから、背景差分で動いた領域を
+ * 8x8 画素のセルに集計し、つながったセルの最大の塊を人物とみなす。
+ * 塊の上端付近を顔の位置とする。
+ *
+ * - 差分・背景更新・セル集計はフレームを1回なめるだけの分岐なしループ
+ *   （ホストでは自動ベクトル化される）
+ * - 人物がいるセルでは背景をほとんど更新しないので、立ち止まっても
+ *   すぐには背景に溶け込まない
+ * - 連続フレームで確定・喪失を判定してちらつきを抑える
+ * - ボード非依存なので、ホストでも PGM 画像に対して動かせる
+ */
+
+#ifndef COROSUKE_PERSON_DETECTOR_H
+#define COROSUKE_PERSON_DETECTOR_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define VISION_WIDTH            160
+#define VISION_HEIGHT           120
+#define VISION_CELL             8
+#define VISION_CELLS_X          (VISION_WIDTH / VISION_CELL)
+#define VISION_CELLS_Y          (VISION_HEIGHT / VISION_CELL)
+#define VISION_CELLS            (VISION_CELLS_X * VISION_CELLS_Y)
+
+#define VISION_MOTION_THRESHOLD 20      // 背景との輝度差
+#define VISION_CELL_ACTIVE      10      // セル (64画素) 内の動いた画素数
+#define VISION_MIN_CELLS        4       // 人物とみなす最小セル数
+#define VISION_BG_SHIFT         4       // 背景更新 1/16 /フレーム
+#define VISION_BG_SHIFT_PERSON  9       // 人物のいるセルは 1/512
+#define VISION_WARMUP_FRAMES    8       // 背景ができるまで検知しない
+#define VISION_CONFIRM_FRAMES   2       // 連続で見えたら検知
+#define VISION_LOST_FRAMES      8       // 連続で見えなかったら喪失
+
+// PersonData_t の座標はこの解像度基準（従来の QVGA と同じ）
+#define VISION_REPORT_WIDTH     320
+#define VISION_REPORT_HEIGHT    240
+
+typedef struct {
+    bool detected;
+    bool changed;               // detected が今回のフレームで変わった
+    int16_t x, y;               // 人物の重心 (VISION_REPORT_* 基準)
+    int16_t faceX, faceY;       // 顔の推定位置
+    uint16_t size;              // 動いた領域の面積 (VISION_REPORT_* 基準の画素数 / 64)
+    uint8_t cells;              // 塊のセル数
+} VisionResult_t;
+
+class PersonDetector {
+public:
+    PersonDetector() { reset(); }
+
+    void reset() {
+        _frames = 0;
+        _seen = 0;
+        _missed = 0;
+        _detected = false;
+        memset(_personCell, 0, sizeof(_personCell));
+        memset(&_last, 0, sizeof(_last));
+    }
+
+    bool detected() const { return _detected; }
+
+    // 1フレーム処理する。フレームサイズが違えば false
+    bool process(const uint8_t* gray, uint16_t width, uint16_t height, VisionResult_t* result) {
+        if (width != VISION_WIDTH || height != VISION_HEIGHT) return false;
+
+        if (_frames == 0) {
+            for (int i = 0; i < VISION_WIDTH * VISION_HEIGHT; i++) {
+                _background[i] = (uint16_t)(gray[i] << 8);
+            }
+        }
+        _frames++;
+
+        uint8_t counts[VISION_CELLS];
+        motionKernel(gray, _background, _personCell, counts);
+
+        Blob_t blob;
+        bool found = _frames > VISION_WARMUP_FRAMES && largestBlob(counts, &blob);
+
+        // 次のフレームの背景更新で人物のセルを守る
+        memset(_personCell, 0, sizeof(_personCell));
+        if (found) {
+            for (int c = 0; c < VISION_CELLS; c++) {
+                _personCell[c] = _labels[c] == blob.label;
+            }
+        }
+
+        bool was = _detected;
+        if (found) {
+            _missed = 0;
+            if (_seen < 255) _seen++;
+            if (_seen >= VISION_CONFIRM_FRAMES) _detected = true;
+        } else {
+            _seen = 0;
+            if (_missed < 255) _missed++;
+            if (_missed >= VISION_LOST_FRAMES) _detected = false;
+        }
+
+        if (found) {
+            const int sx = VISION_REPORT_WIDTH / VISION_CELLS_X;
+            const int sy = VISION_REPORT_HEIGHT / VISION_CELLS_Y;
+            _last.x = (int16_t)(blob.sumX * sx / blob.weight + sx / 2);
+            _last.y = (int16_t)(blob.sumY * sy / blob.weight + sy / 2);
+            _last.faceX = (int16_t)(blob.faceX * sx / 16 + sx / 2);
+            _last.faceY = (int16_t)(blob.top * sy + sy / 2);
+            _last.size = (uint16_t)(blob.cells * sx * sy / 64);
+            _last.cells = blob.cells;
+        }
+        *result = _last;
+        result->detected = _detected;
+        result->changed = _detected != was;
+        return true;
+    }
+
+    // 差分 + 背景更新 + セル集計（1パス）
+    // 行単位の固定長ループにして、更新率の切り替えもマスクで行う（分岐なし）
+    static void motionKernel(const uint8_t* frame, uint16_t* background, const uint8_t* personCell,
+                             uint8_t counts[VISION_CELLS]) {
+        memset(counts, 0, VISION_CELLS);
+        int32_t personMask[VISION_WIDTH];
+        uint8_t moved[VISION_WIDTH];
+
+        for (int y = 0; y < VISION_HEIGHT; y++) {
+            if (y % VISION_CELL == 0) {
+                const uint8_t* rowPerson = personCell + (y / VISION_CELL) * VISION_CELLS_X;
+                for (int x = 0; x < VISION_WIDTH; x++) {
+                    personMask[x] = -(int32_t)(rowPerson[x / VISION_CELL] != 0);
+                }
+            }
+
+            const uint8_t* row = frame + y * VISION_WIDTH;
+            uint16_t* bg = background + y * VISION_WIDTH;
+            for (int x = 0; x < VISION_WIDTH; x++) {
+                int32_t pixel = row[x];
+                int32_t model = bg[x];
+                int32_t diff = pixel - (model >> 8);
+                moved[x] = (uint8_t)((diff > VISION_MOTION_THRESHOLD) | (diff < -VISION_MOTION_THRESHOLD));
+
+                int32_t delta = (pixel << 8) - model;
+                int32_t fast = delta >> VISION_BG_SHIFT;
+                int32_t slow = delta >> VISION_BG_SHIFT_PERSON;
+                bg[x] = (uint16_t)(model + fast + ((slow - fast) & personMask[x]));
+            }
+
+            uint8_t* rowCounts = counts + (y / VISION_CELL) * VISION_CELLS_X;
+            for (int cx = 0; cx < VISION_CELLS_X; cx++) {
+                const uint8_t* m = moved + cx * VISION_CELL;
+                rowCounts[cx] += (uint8_t)(m[0] + m[1] + m[2] + m[3] + m[4] + m[5] + m[6] + m[7]);
+            }
+        }
+    }
+
+private:
+    typedef struct {
+        uint8_t label;
+        uint8_t cells;
+        uint32_t weight;        // 動いた画素数の合計
+        uint32_t sumX, sumY;    // セル座標 x 重み
+        uint8_t top;            // 最上段のセル行
+        uint32_t faceX;         // 上端 2 行の x 重心 (1/16 セル単位)
+    } Blob_t;
+
+    // 動いたセルの 4 近傍連結成分のうち、動いた画素の合計が最大のもの
+    bool largestBlob(const uint8_t counts[VISION_CELLS], Blob_t* best) {
+        memset(_labels, 0, sizeof(_labels));
+        uint16_t stack[VISION_CELLS];
+        uint8_t next = 1;
+        best->label = 0;
+        best->weight = 0;
+
+        for (int start = 0; start < VISION_CELLS; start++) {
+            if (_labels[start] || counts[start] < VISION_CELL_ACTIVE || next == 255) continue;
+
+            Blob_t blob = {next, 0, 0, 0, 0, 255, 0};
+            int depth = 0;
+            stack[depth++] = (uint16_t)start;
+            _labels[start] = next;
+            while (depth > 0) {
+                int c = stack[--depth];
+                int cx = c % VISION_CELLS_X;
+                int cy = c / VISION_CELLS_X;
+                blob.cells++;
+                blob.weight += counts[c];
+                blob.sumX += (uint32_t)cx * counts[c];
+                blob.sumY += (uint32_t)cy * counts[c];
+                if (cy < blob.top) blob.top = (uint8_t)cy;
+
+                const int neighbors[4] = {
+                    cx > 0 ? c - 1 : -1,
+                    cx < VISION_CELLS_X - 1 ? c + 1 : -1,
+                    cy > 0 ? c - VISION_CELLS_X : -1,
+                    cy < VISION_CELLS_Y - 1 ? c + VISION_CELLS_X : -1,
+                };
+                for (int n : neighbors) {
+                    if (n >= 0 && !_labels[n] && counts[n] >= VISION_CELL_ACTIVE) {
+                        _labels[n] = next;
+                        stack[depth++] = (uint16_t)n;
+                    }
+                }
+            }
+            if (blob.cells >= VISION_MIN_CELLS && blob.weight > best->weight) {
+                *best = blob;
+            }
+            next++;
+        }
+        if (best->weight == 0) return false;
+
+        // 顔: 塊の上端 2 行の重心
+        uint32_t w = 0, sx = 0;
+        for (int cy = best->top; cy < best->top + 2 && cy < VISION_CELLS_Y; cy++) {
+            for (int cx = 0; cx < VISION_CELLS_X; cx++) {
+                int c = cy * VISION_CELLS_X + cx;
+                if (_labels[c] == best->label) {
+                    w += counts[c];
+                    sx += (uint32_t)cx * counts[c];
+                }
+            }
+        }
+        best->faceX = w ? sx * 16 / w : best->sumX * 16 / best->weight;
+        return true;
+    }
+
+    uint16_t _background[VISION_WIDTH * VISION_HEIGHT];     // Q8
+    uint8_t _personCell[VISION_CELLS];
+    uint8_t _labels[VISION_CELLS];
+    uint32_t _frames;
+    uint8_t _seen;
+    uint8_t _missed;
+    bool _detected;
+    VisionResult_t _last;
+};
+
+#endif // COROSUKE_PERSON_DETECTOR_H
@@ -7,6 +7,9 @@
 #define COROSUKE_PROTOCOL_H
 
 #include <stdint.h>
+#include <string.h>
+
+#include "crc16.h"
 
 // =============================================================================
 // パケット構造
@@ -18,6 +21,20 @@
 #define PACKET_END      0x55
 #define PACKET_MAX_SIZE 64
 
+// -----------------------------------------------------------------------------
+// v2: [START_V2][LENGTH][CTRL][SEQ?][ACK?][CMD][DATA...][CRC16 L][CRC16 H][END]
+//   0xAB       1byte   1byte  CTRL で有無が決まる  N bytes  CRC-16/CCITT-FALSE  0x55
+//
+// LENGTH は CTRL〜DATA のバイト数、CRC は LENGTH〜DATA が対象。
+// START が違うので v1 の受信側は v2 フレームを読み飛ばし、v2 の受信側は両方を受け付ける。
+// -----------------------------------------------------------------------------
+#define PACKET_START_V2         0xAB
+#define PACKET_V2_RELIABLE      0x01    // SEQ あり。受信側は ACK を返し、抜けは再送される
+#define PACKET_V2_ACK           0x02    // ACK あり（この番号まで順番どおりに受け取った）
+#define PACKET_V2_SYN           0x04    // 送信側で未確認の一番古いフレーム（これより前はもう来ない）
+#define PACKET_V2_OVERHEAD      8       // START LENGTH CTRL SEQ ACK CRC CRC END（CMD は含まない）
+#define PACKET_V2_MAX_DATA      (PACKET_MAX_SIZE - PACKET_V2_OVERHEAD - 1)
+
 // =============================================================================
 // コマンド定義
 // =============================================================================
@@ -25,8 +42,12 @@
 // システムコマンド (0x00-0x0F)
 #define CMD_PING            0x00    // 疎通確認
 #define CMD_PONG            0x01    // 疎通応答
-#define CMD_STATUS          0x02    // ステータス要求
-#define CMD_STATUS_RESP     0x03    // ステータス応答
+#define CMD_STATUS          0x02    // ステータス要求（データ: STATUS_*、なければ STATUS_LINKS）
+#define CMD_STATUS_RESP     0x03    // ステータス応答（データ: リンク数 + LinkStatusData_t の列、または TraceStatusData_t）
+#define CMD_LINK_ACK        0x04    // ACK だけを運ぶ v2 フレーム（データなし）
+#define CMD_LINK_NACK       0x05    // 抜けている SEQ の再送要求（データ: SEQ の列）
+#define CMD_LINK_HELLO      0x06    // v2 対応の通知（データ: バージョン）
+#define CMD_LINK_SPEED      0x07    // ボーレートの交渉（データ: LinkSpeedMsg_t + 検査パターン）
 #define CMD_ERROR           0x0F    // エラー通知
 
 // 表情コマンド (0x10-0x1F) - メイン→上半身
@@ -48,6 +69,8 @@
 #define CMD_TURN            0x33    // 旋回
 #define CMD_STAND           0x34    // 直立
 #define CMD_SIT             0x35    // 座る
+#define CMD_GAIT_TABLE      0x36    // 歩容テーブルの書き換え（分割転送）
+#define CMD_BALANCE_GAINS   0x37    // バランス制御のゲイン（データ: BalanceGainsData_t）
 
 // 腕コマンド (0x40-0x4F) - メイン→上半身
 #define CMD_ARM_POSITION    0x40    // 腕の位置
@@ -63,6 +86,10 @@
 #define CMD_FACE_POSITION   0x61    // 顔の位置
 #define CMD_LOOK_AT         0x62    // 注視点設定
 
+// サーボフレーム (0x70-0x7F) - メイン→上半身（→下半身）
+#define CMD_SERVO_FRAME       0x70  // 全16チャンネルの目標角度（キーフレーム）
+#define CMD_SERVO_FRAME_DELTA 0x71  // キーフレームから変化したチャンネルのみ
+
 // =============================================================================
 // 表情ID
 // =============================================================================
@@ -91,6 +118,45 @@ typedef enum {
     WALK_TURN_RIGHT
 } WalkMode_t;
 
+// =============================================================================
+// ステータスの種類（CMD_STATUS のデータ）
+// =============================================================================
+#define STATUS_LINKS        0x00    // リンクの状態 → リンク数 + LinkStatusData_t の列
+#define STATUS_TRACE        0x01    // 処理時間の分布 → 計測した処理ごとに TraceStatusData_t を1つずつ
+                                    // （上半身は下半身へも回し、下半身の応答をメインへ中継する）
+
+// CMD_STATUS_RESP の先頭バイト: これ未満ならリンク数
+#define STATUS_RESP_TRACE   0x80
+
+// =============================================================================
+// 処理時間の計測（trace.h）
+// =============================================================================
+typedef enum {
+    TRACE_BOARD_MAIN = 0,
+    TRACE_BOARD_UPPER,
+    TRACE_BOARD_LOWER
+} TraceBoard_t;
+
+typedef enum {
+    TRACE_LOOP = 0,         // loop() 1回（scheduler.h の runDue()、眠っている間は入らない）
+    TRACE_UART,             // UART の受信・解析・振り分け
+    TRACE_IMU,              // IMU の読み出しと姿勢推定
+    TRACE_BALANCE,          // バランス補正
+    TRACE_GAIT,             // 歩容
+    TRACE_CONTROL,          // 制御周期 1回（下半身 100Hz）
+    TRACE_SERVO_TICK,       // サーボ更新 tick 1回（50Hz）
+    TRACE_SERVO_WRITE,      // サーボへの I2C 書き込み
+    TRACE_LED_SHOW,         // LED目の転送
+    TRACE_AUDIO,            // 音声のデコードとリップシンク
+    TRACE_CAMERA,           // 人物検知 1フレーム
+    TRACE_MIC,              // マイク 1フレーム
+    TRACE_SERVER,           // サーバーとの WebSocket
+    TRACE_STAGES
+} TraceStage_t;
+
+#define TRACE_BUCKETS       16      // 0: 16us 未満、n: 16·2^(n-1) 〜 16·2^n us、15: 262ms 以上
+#define TRACE_BUCKET0_US    16
+
 // =============================================================================
 // パケット構造体
 // =============================================================================
@@ -108,12 +174,12 @@ typedef struct {
 typedef struct {
     uint8_t expression_id;
     uint8_t intensity;      // 0-100
-    uint16_t duration_ms;
+    uint16_t duration_ms;   // 0 = 基本の表情にする、それ以外 = この時間だけ出して基本の表情へ戻る
 } ExpressionData_t;
 
 // 目の位置パケットデータ
 typedef struct {
-    int8_t x;       // -50 to 50 (左右)
+    int8_t x;       // -50 to 50 (左右、目と首を合わせた範囲)
     int8_t y;       // -50 to 50 (上下)
     uint8_t speed;  // 0-100
 } EyePositionData_t;
@@ -130,6 +196,45 @@ typedef struct {
     int8_t direction;       // -90 to 90 度
 } WalkData_t;
 
+// 歩容テーブル転送（後ろにテーブルの offset バイト目からのデータが続く）
+typedef struct {
+    uint8_t mode;           // WalkMode_t (WALK_FORWARD 〜 WALK_TURN_RIGHT)
+    uint8_t speed_bucket;   // 速度バケット (0:遅い 1:普通 2:速い)
+    uint16_t offset;        // テーブル内のバイト位置
+} GaitTableChunk_t;
+
+// バランス制御のゲイン（軸ごと）
+typedef struct {
+    uint8_t axis;           // 0: ピッチ 1: ロール
+    uint8_t enabled;        // 0 なら補正を止める
+    uint16_t kp_milli;      // 度/度 x1000
+    uint16_t ki_milli;      // 度/(度・秒) x1000
+    uint16_t kd_milli;      // 度/(度/秒) x1000
+    uint16_t d_cutoff_dhz;  // 微分ローパスのカットオフ 0.1Hz 単位（0 = 既定値）
+    uint16_t limit_ddeg;    // 補正の上限 0.1度単位
+} BalanceGainsData_t;
+
+// 腕の位置データ（SERVO_FRAME_HOLD の関節は動かさない）
+typedef struct {
+    uint8_t right_shoulder; // 0-180 度
+    uint8_t right_elbow;
+    uint8_t left_shoulder;
+    uint8_t left_elbow;
+    uint16_t duration_ms;   // 目標までの時間（0 = 既定値）
+} ArmPositionData_t;
+
+// 手を振るデータ
+typedef struct {
+    uint8_t count;          // 振る回数（0 = 既定値）
+} WaveData_t;
+
+// 指差しデータ（x が正なら右手、負なら左手で指す）
+typedef struct {
+    int8_t x;               // -50 to 50 (左右)
+    int8_t y;               // -50 to 50 (上下)
+    uint16_t hold_ms;       // 指したままにする時間（0 = 既定値）
+} PointData_t;
+
 // IMUデータ
 typedef struct {
     int16_t pitch;          // ピッチ角 x100
@@ -148,6 +253,77 @@ typedef struct {
     uint16_t size;          // 検出サイズ
 } PersonData_t;
 
+// サーボフレームの宛先
+typedef enum {
+    BODY_UPPER = 0,         // 上半身 PCA9685
+    BODY_LOWER = 1          // 下半身 PCA9685
+} ServoBody_t;
+
+#define SERVO_FRAME_CHANNELS    16
+#define SERVO_FRAME_HOLD        0xFF    // このチャンネルは駆動しない
+#define SERVO_FRAME_FLAG_SNAP   0x01    // 補間せず目標角度へ直接移動
+
+// サーボフレーム（キーフレーム）
+typedef struct {
+    uint8_t body;           // ServoBody_t
+    uint8_t seq;            // フレーム番号
+    uint8_t flags;          // SERVO_FRAME_FLAG_*
+    uint8_t angles[SERVO_FRAME_CHANNELS];   // 0-180 度 / SERVO_FRAME_HOLD
+} ServoFrameData_t;
+
+// サーボフレーム（差分）
+// ヘッダーの後に mask の立っているチャンネルの角度がチャンネル順に続く
+typedef struct {
+    uint8_t body;           // ServoBody_t
+    uint8_t seq;            // フレーム番号
+    uint8_t flags;          // SERVO_FRAME_FLAG_*
+    uint8_t base_seq;       // 基準キーフレームの番号
+    uint16_t mask;          // bit n = チャンネル n が変化
+} ServoFrameDeltaHeader_t;
+
+// ボーレートの交渉（link_speed.h）
+typedef struct {
+    uint8_t op;             // LINK_SPEED_OP_*
+    uint8_t token;          // 交渉ごとの番号（古い返事と取り違えない）
+    uint32_t baud;
+    uint16_t value;         // PROBE: 通し番号 / REPORT: 正しく届いた PROBE 数
+} LinkSpeedMsg_t;
+
+// ESP32間リンクの識別子
+typedef enum {
+    LINK_MAIN_UPPER = 0,    // メイン ↔ 上半身
+    LINK_UPPER_LOWER = 1    // 上半身 ↔ 下半身
+} LinkId_t;
+
+// リンクの状態（CMD_STATUS_RESP に、見ているボードのリンクの数だけ並べる）
+typedef struct {
+    uint8_t link;           // LinkId_t
+    uint8_t state;          // LinkSpeedState_t
+    uint32_t baud;
+    uint32_t rx_bytes_per_s;    // 直近の集計窓
+    uint32_t tx_bytes_per_s;
+    uint16_t rx_error_permille; // 直近の集計窓の受信エラー率
+    uint16_t negotiations;      // 確定した交渉の回数
+    uint16_t fallbacks;         // エラー率・無通信で下げた回数
+    uint16_t trial_failures;    // 試験に落ちたボーレートの数
+    uint32_t rx_errors;         // CRC/チェックサム・フレーム異常の累計
+} LinkStatusData_t;
+
+#define LINK_STATUS_MAX_LINKS   2
+
+// 処理ごとの時間の分布（前回の STATUS_TRACE からの差分）
+typedef struct {
+    uint8_t kind;           // STATUS_RESP_TRACE
+    uint8_t board;          // TraceBoard_t
+    uint8_t stage;          // TraceStage_t
+    uint8_t scale;          // buckets[] は回数を scale ビット右へずらしたもの（16bit に収めるため）
+    uint32_t samples;
+    uint32_t over_budget;   // TRACE_BUDGET_US を超えた回数
+    uint32_t total_us;
+    uint32_t max_us;
+    uint16_t buckets[TRACE_BUCKETS];
+} TraceStatusData_t;
+
 #pragma pack(pop)
 
 // =============================================================================
@@ -171,4 +347,37 @@ static inline bool validatePacket(const uint8_t* buffer, uint8_t size) {
     return checksum == buffer[size - 2];
 }
 
+// v1 フレームを組み立てる（out は PACKET_MAX_SIZE 以上）。収まらなければ 0
+static inline uint8_t buildPacket(uint8_t* out, uint8_t cmd, const uint8_t* data, uint8_t length) {
+    if (length + 5 > PACKET_MAX_SIZE) return 0;
+    out[0] = PACKET_START;
+    out[1] = length + 1;
+    out[2] = cmd;
+    if (length) memcpy(&out[3], data, length);
+    out[3 + length] = calculateChecksum(&out[1], length + 2);
+    out[4 + length] = PACKET_END;
+    return length + 5;
+}
+
+// v2 フレームを組み立てる。SEQ/ACK は ctrl にフラグがあるときだけ入る
+static inline uint8_t buildPacketV2(uint8_t* out, uint8_t ctrl, uint8_t seq, uint8_t ack,
+                                    uint8_t cmd, const uint8_t* data, uint8_t length) {
+    if (length > PACKET_V2_MAX_DATA) return 0;
+    uint8_t idx = 2;
+    out[0] = PACKET_START_V2;
+    out[idx++] = ctrl;
+    if (ctrl & PACKET_V2_RELIABLE) out[idx++] = seq;
+    if (ctrl & PACKET_V2_ACK) out[idx++] = ack;
+    out[idx++] = cmd;
+    if (length) memcpy(&out[idx], data, length);
+    idx += length;
+    out[1] = idx - 2;
+
+    uint16_t crc = crc16(&out[1], idx - 1);
+    out[idx++] = (uint8_t)crc;
+    out[idx++] = (uint8_t)(crc >> 8);
+    out[idx++] = PACKET_END;
+    return idx;
+}
+
 #endif // COROSUKE_PROTOCOL_H
@@ -0,0 +1,507 @@
+/**
+ * コロ助ロボット - UART 再送付きリンク（プロトコル v2）
+ * Corosuke Robot - Reliable UART Link (protocol v2)
+ *
+ * PacketParser が取り出したパケットと送信の間に入り、
+ * 確実に届けたいコマンドだけに SEQ を付けて再送する。
+ *
+ * - 送信側: SEQ 付きフレームを最大 RELIABLE_LINK_WINDOW 個まで ACK 待ちで保持し、
+ *   先頭フレームの RTO 経過か NACK で送り直す（先頭で MAX_RETRIES 回 RTO を迎えたら諦める）。
+ *   RTO は往復時間の平滑値とばらつきから決める（再送したフレームは測らない）。
+ *   混み合うネットワークではないので、RTO を迎えても間隔は伸ばさない。
+ *   窓が埋まっている間のコマンドは RELIABLE_LINK_QUEUE 個まで順番どおりに待たせる
+ * - 受信側: 順番どおりに渡し、先に届いたフレームは並べ替えバッファで待たせる。
+ *   抜けに気づいたら NACK で抜けている SEQ だけを要求する
+ * - ACK は累積（「この SEQ の手前まで受け取った」）。送るフレームがあれば相乗りし、
+ *   なければ ACK_DELAY_MS 後に CMD_LINK_ACK を単独で送る
+ * - リップシンクやサーボの差分フレームのような送りっぱなしのコマンドは SEQ なし
+ *   （v1 より CTRL と CRC の 2 バイト増えるだけ）
+ * - 相手から v2 フレームが届くまでは v1 で送り、CMD_LINK_HELLO で v2 対応を知らせる
+ *   （v1 のパーサーは 0xAB を読み飛ばすので、古いボードとも混在できる）
+ *
+ * 出力先は write(const uint8_t*, size_t) を持つもの（HardwareSerial など）。
+ */
+
+#ifndef COROSUKE_RELIABLE_LINK_H
+#define COROSUKE_RELIABLE_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+#include "packet_parser.h"
+
+#define RELIABLE_LINK_VERSION       2
+#define RELIABLE_LINK_WINDOW        8       // ACK 待ちにできるフレーム数（2のべき乗）
+#define RELIABLE_LINK_QUEUE         16      // 窓の分を含めて保持できるフレーム数（2のべき乗）
+#define RELIABLE_LINK_RTO_MS        30      // 往復時間を測るまでの RTO
+#define RELIABLE_LINK_RTO_MIN_MS    10
+#define RELIABLE_LINK_RTO_MAX_MS    250
+#define RELIABLE_LINK_MAX_RETRIES   5
+#define RELIABLE_LINK_ACK_DELAY_MS  5       // 相乗りできる送信を待つ時間
+#define RELIABLE_LINK_NACK_HOLDOFF_MS 15    // 同じ抜けへの NACK を繰り返さない時間
+#define RELIABLE_LINK_HELLO_MS      1000
+
+#if (RELIABLE_LINK_WINDOW & (RELIABLE_LINK_WINDOW - 1)) != 0
+#error "RELIABLE_LINK_WINDOW must be a power of two"
+#endif
+#if (RELIABLE_LINK_QUEUE & (RELIABLE_LINK_QUEUE - 1)) != 0 || RELIABLE_LINK_QUEUE < RELIABLE_LINK_WINDOW
+#error "RELIABLE_LINK_QUEUE must be a power of two and at least RELIABLE_LINK_WINDOW"
+#endif
+
+typedef struct {
+    uint32_t txFrames;          // 送信フレーム（再送・ACK を含む）
+    uint32_t txBytes;
+    uint32_t rxFrames;          // 受け取ったフレーム（v1 を含む）
+    uint32_t retransmits;       // 再送（RTO と NACK の合計）
+    uint32_t nacksSent;
+    uint32_t nacksReceived;
+    uint32_t acksSent;          // 単独で送った ACK
+    uint32_t duplicates;        // 受信済みの SEQ
+    uint32_t reordered;         // 並べ替えバッファで待たせたフレーム
+    uint32_t lost;              // 相手が諦めて届かなかった SEQ
+    uint32_t giveUps;           // こちらが諦めた SEQ
+    uint32_t queueFull;         // 待ち行列が埋まっていて捨てたフレーム
+    uint32_t v1Frames;          // v1 で送受信したフレーム
+} LinkStats_t;
+
+// 確実に届けるコマンド（状態が1回きりで変わるもの）。連続して送るものは対象外。
+// サーボのキーフレームは、失うと次のキーフレームまで差分フレームがすべて捨てられるので確実に送る
+static inline bool linkCommandIsReliable(uint8_t cmd) {
+    switch (cmd) {
+        case CMD_EXPRESSION:
+        case CMD_BLINK:
+        case CMD_SPEAK_START:
+        case CMD_SPEAK_STOP:
+        case CMD_PLAY_AUDIO:
+        case CMD_WALK_START:
+        case CMD_WALK_STOP:
+        case CMD_WALK_DIRECTION:
+        case CMD_TURN:
+        case CMD_STAND:
+        case CMD_SIT:
+        case CMD_GAIT_TABLE:
+        case CMD_ARM_POSITION:
+        case CMD_WAVE:
+        case CMD_POINT:
+        case CMD_PERSON_DETECTED:
+        case CMD_SERVO_FRAME:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// =============================================================================
+// リンク本体
+// =============================================================================
+class ReliableLink {
+public:
+    ReliableLink() { reset(0); }
+
+    // initialSeq は起動ごとに変える（相手が古い SEQ と取り違えないように）
+    void reset(uint8_t initialSeq) {
+        _peerV2 = false;
+        _lastHelloMs = 0;
+        _helloSent = false;
+        _txBase = initialSeq;
+        _txSent = initialSeq;
+        _txNext = initialSeq;
+        memset(_tx, 0, sizeof(_tx));
+        _srtt8 = 0;
+        _rttvar4 = 0;
+        _rtoMs = RELIABLE_LINK_RTO_MS;
+        _rxSynced = false;
+        _rxNext = 0;
+        _rxFloor = 0;
+        memset(_rx, 0, sizeof(_rx));
+        _ackPending = false;
+        _ackDueMs = 0;
+        _lastNackMs = 0;
+        _nackSent = false;
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    const LinkStats_t& stats() const { return _stats; }
+    bool peerV2() const { return _peerV2; }
+    uint8_t inFlight() const { return (uint8_t)(_txSent - _txBase); }
+    uint8_t queued() const { return (uint8_t)(_txNext - _txBase); }
+    uint32_t rtoMs() const { return _rtoMs; }
+
+    // 相手が v2 に対応していることが分かっている場合（ベンチマーク用）
+    void assumePeerV2() { _peerV2 = true; }
+
+    // コマンドを送る。reliable なら ACK まで保持して再送する。
+    // 待ち行列が埋まっていて送れなければ false
+    template <typename OutT>
+    bool send(OutT& out, uint8_t cmd, const uint8_t* data, uint8_t length, bool reliable, uint32_t now) {
+        if (!_peerV2 || length > PACKET_V2_MAX_DATA) {
+            uint8_t frame[PACKET_MAX_SIZE];
+            uint8_t size = buildPacket(frame, cmd, data, length);
+            if (size == 0) return false;
+            _stats.v1Frames++;
+            emit(out, frame, size);
+            return true;
+        }
+
+        if (reliable) {
+            if (queued() >= RELIABLE_LINK_QUEUE) {
+                _stats.queueFull++;
+                return false;
+            }
+            TxSlot_t& slot = _tx[_txNext & QUEUE_MASK];
+            slot.cmd = cmd;
+            slot.length = length;
+            if (length) memcpy(slot.data, data, length);
+            slot.retransmits = 0;
+            slot.timeouts = 0;
+            _txNext++;
+            pump(out, now);
+            return true;
+        }
+
+        uint8_t frame[PACKET_MAX_SIZE];
+        uint8_t ctrl = _ackPending ? PACKET_V2_ACK : 0;
+        uint8_t size = buildPacketV2(frame, ctrl, 0, _rxNext, cmd, data, length);
+        if (ctrl) _ackPending = false;
+        emit(out, frame, size);
+        return true;
+    }
+
+    template <typename OutT>
+    bool send(OutT& out, uint8_t cmd, const uint8_t* data, uint8_t length, uint32_t now) {
+        return send(out, cmd, data, length, linkCommandIsReliable(cmd), now);
+    }
+
+    // 受け取ったパケットを渡す。true ならこのパケットをすぐ処理してよい。
+    // そのあと nextBuffered() で並べ替えバッファから続きを取り出すこと
+    template <typename OutT>
+    bool receive(OutT& out, const PacketView_t& packet, uint32_t now) {
+        _stats.rxFrames++;
+        if (packet.version != 2) {
+            _stats.v1Frames++;
+            return true;
+        }
+        _peerV2 = true;
+
+        if (packet.ctrl & PACKET_V2_ACK) {
+            handleAck(packet.ack, now);
+            pump(out, now);
+        }
+
+        switch (packet.cmd) {
+            case CMD_LINK_ACK:
+            case CMD_LINK_HELLO:
+                return false;
+            case CMD_LINK_NACK:
+                _stats.nacksReceived++;
+                for (uint8_t i = 0; i < packet.length; i++) {
+                    uint8_t seq = packet.data[i];
+                    if ((uint8_t)(seq - _txBase) < inFlight()) retransmit(out, seq, now);
+                }
+                return false;
+            default:
+                break;
+        }
+
+        if (!(packet.ctrl & PACKET_V2_RELIABLE)) return true;
+        return receiveReliable(out, packet, now);
+    }
+
+    // 並べ替えバッファで順番が来たパケットを1つ取り出す（次の receive() まで有効）
+    bool nextBuffered(PacketView_t* packet) {
+        while (_rxSynced) {
+            RxSlot_t& slot = _rx[_rxNext & WINDOW_MASK];
+            if (slot.valid && slot.seq == _rxNext) {
+                slot.valid = false;
+                packet->cmd = slot.cmd;
+                packet->length = slot.length;
+                packet->data = slot.data;
+                packet->frame = NULL;
+                packet->frameLength = 0;
+                packet->version = 2;
+                packet->ctrl = PACKET_V2_RELIABLE;
+                packet->seq = _rxNext;
+                packet->ack = 0;
+                advanceRx();
+                return true;
+            }
+            // 相手が諦めた SEQ は飛ばす
+            uint8_t gap = (uint8_t)(_rxFloor - _rxNext);
+            if (gap == 0 || gap >= RELIABLE_LINK_WINDOW) return false;
+            _stats.lost++;
+            advanceRx();
+        }
+        return false;
+    }
+
+    // 再送・遅延 ACK・HELLO を送る（loop ごとに呼ぶ）
+    template <typename OutT>
+    void poll(OutT& out, uint32_t now) {
+        if (!_peerV2 && (!_helloSent || now - _lastHelloMs >= RELIABLE_LINK_HELLO_MS)) {
+            uint8_t version = RELIABLE_LINK_VERSION;
+            uint8_t frame[PACKET_MAX_SIZE];
+            emit(out, frame, buildPacketV2(frame, 0, 0, 0, CMD_LINK_HELLO, &version, 1));
+            _helloSent = true;
+            _lastHelloMs = now;
+        }
+
+        // RTO は先頭のフレームだけ見る（後ろの抜けは受信側の NACK で送り直す）
+        if (inFlight() > 0) {
+            TxSlot_t& slot = _tx[_txBase & QUEUE_MASK];
+            if (now - slot.sentMs >= _rtoMs) {
+                if (slot.timeouts >= RELIABLE_LINK_MAX_RETRIES) {
+                    // 諦めて窓を進め、新しい先頭をすぐ SYN 付きで送る
+                    _txBase++;
+                    _stats.giveUps++;
+                    if (inFlight() > 0) retransmit(out, _txBase, now);
+                } else {
+                    slot.timeouts++;
+                    retransmit(out, _txBase, now);
+                }
+            }
+        }
+        pump(out, now);
+
+        if (_ackPending && (int32_t)(now - _ackDueMs) >= 0) {
+            // 抜けの後ろに待たせているフレームがあれば、ACK の代わりに NACK で抜けを知らせる
+            uint8_t last;
+            if (lastBuffered(&last) && sendNack(out, last, now, true)) return;
+
+            uint8_t frame[PACKET_MAX_SIZE];
+            emit(out, frame, buildPacketV2(frame, PACKET_V2_ACK, 0, _rxNext, CMD_LINK_ACK, NULL, 0));
+            _ackPending = false;
+            _stats.acksSent++;
+        }
+    }
+
+private:
+    static const uint8_t WINDOW_MASK = RELIABLE_LINK_WINDOW - 1;
+    static const uint8_t QUEUE_MASK = RELIABLE_LINK_QUEUE - 1;
+
+    typedef struct {
+        uint8_t cmd;
+        uint8_t length;
+        uint8_t data[PACKET_V2_MAX_DATA];
+        uint8_t retransmits;    // 送り直した回数（往復時間の測定から外す）
+        uint8_t timeouts;       // 先頭で RTO を迎えた回数（MAX_RETRIES で諦める）
+        uint32_t sentMs;
+    } TxSlot_t;
+
+    typedef struct {
+        uint8_t cmd;
+        uint8_t length;
+        uint8_t data[PACKET_V2_MAX_DATA];
+        uint8_t seq;
+        bool valid;
+    } RxSlot_t;
+
+    template <typename OutT>
+    void emit(OutT& out, const uint8_t* frame, uint8_t size) {
+        if (size == 0) return;
+        out.write(frame, size);
+        _stats.txFrames++;
+        _stats.txBytes += size;
+    }
+
+    // 窓が空いた分だけ待ち行列から初回送信する
+    template <typename OutT>
+    void pump(OutT& out, uint32_t now) {
+        while (_txSent != _txNext && inFlight() < RELIABLE_LINK_WINDOW) {
+            transmit(out, _txSent++, now);
+        }
+    }
+
+    template <typename OutT>
+    void retransmit(OutT& out, uint8_t seq, uint32_t now) {
+        TxSlot_t& slot = _tx[seq & QUEUE_MASK];
+        if (slot.retransmits < 255) slot.retransmits++;
+        _stats.retransmits++;
+        transmit(out, seq, now);
+    }
+
+    // 保持しているフレームを今の ACK を載せて送る
+    template <typename OutT>
+    void transmit(OutT& out, uint8_t seq, uint32_t now) {
+        TxSlot_t& slot = _tx[seq & QUEUE_MASK];
+        uint8_t ctrl = PACKET_V2_RELIABLE;
+        if (seq == _txBase) ctrl |= PACKET_V2_SYN;
+        if (_rxSynced) ctrl |= PACKET_V2_ACK;
+
+        uint8_t frame[PACKET_MAX_SIZE];
+        emit(out, frame, buildPacketV2(frame, ctrl, seq, _rxNext, slot.cmd, slot.data, slot.length));
+        if (ctrl & PACKET_V2_ACK) _ackPending = false;
+        slot.sentMs = now;
+    }
+
+    // 累積 ACK: ack の手前までを窓から外す
+    void handleAck(uint8_t ack, uint32_t now) {
+        uint8_t acked = (uint8_t)(ack - _txBase);
+        if (acked == 0 || acked > inFlight()) return;
+
+        // 最後に確認されたフレームで往復時間を測る。確認された中に再送したものがあれば
+        // 抜けが埋まるのを待っていた時間が混ざるので測らない
+        bool clean = true;
+        for (uint8_t seq = _txBase; seq != ack; seq++) {
+            if (_tx[seq & QUEUE_MASK].retransmits) clean = false;
+        }
+        if (clean) sampleRtt(now - _tx[(uint8_t)(ack - 1) & QUEUE_MASK].sentMs);
+
+        _txBase = ack;
+    }
+
+    // RFC 6298 と同じ平滑化（SRTT は 1/8ms、RTTVAR は 1/4ms 単位）
+    void sampleRtt(uint32_t rttMs) {
+        int32_t rtt = (int32_t)rttMs;
+        if (_srtt8 == 0) {
+            _srtt8 = rtt << 3;
+            _rttvar4 = rtt << 1;
+        } else {
+            int32_t err = rtt - (_srtt8 >> 3);
+            _srtt8 += err;
+            if (err < 0) err = -err;
+            _rttvar4 += err - (_rttvar4 >> 2);
+        }
+        uint32_t rto = (uint32_t)((_srtt8 >> 3) + _rttvar4);
+        if (rto < RELIABLE_LINK_RTO_MIN_MS) rto = RELIABLE_LINK_RTO_MIN_MS;
+        if (rto > RELIABLE_LINK_RTO_MAX_MS) rto = RELIABLE_LINK_RTO_MAX_MS;
+        _rtoMs = rto;
+    }
+
+    void advanceRx() {
+        _rxNext++;
+        if ((uint8_t)(_rxFloor - _rxNext) >= RELIABLE_LINK_WINDOW) _rxFloor = _rxNext;
+        _nackSent = false;
+    }
+
+    void scheduleAck(uint32_t now, uint32_t delayMs) {
+        uint32_t due = now + delayMs;
+        if (!_ackPending || (int32_t)(due - _ackDueMs) < 0) _ackDueMs = due;
+        _ackPending = true;
+    }
+
+    template <typename OutT>
+    bool receiveReliable(OutT& out, const PacketView_t& packet, uint32_t now) {
+        bool syn = (packet.ctrl & PACKET_V2_SYN) != 0;
+        if (!_rxSynced) {
+            if (!syn) return false;             // 先頭（SYN）が再送されるのを待つ
+            startRx(packet.seq);
+        }
+
+        uint8_t offset = (uint8_t)(packet.seq - _rxNext);
+        if (offset == 0) {
+            advanceRx();
+            scheduleAck(now, RELIABLE_LINK_ACK_DELAY_MS);
+            return true;
+        }
+
+        if (offset < RELIABLE_LINK_WINDOW) {
+            if (packet.length > PACKET_V2_MAX_DATA) return false;
+            RxSlot_t& slot = _rx[packet.seq & WINDOW_MASK];
+            if (slot.valid && slot.seq == packet.seq) {
+                _stats.duplicates++;
+            } else {
+                slot.cmd = packet.cmd;
+                slot.length = packet.length;
+                memcpy(slot.data, packet.data, packet.length);
+                slot.seq = packet.seq;
+                slot.valid = true;
+                _stats.reordered++;
+            }
+            scheduleAck(now, 0);
+            if (syn) {
+                // 手前の SEQ は相手が諦めたので、もう来ない
+                _rxFloor = packet.seq;
+            } else {
+                sendNack(out, packet.seq, now, false);
+            }
+            return false;
+        }
+
+        if (offset >= (uint8_t)(256 - 2 * RELIABLE_LINK_WINDOW)) {
+            // 受け取り済み（ACK が相手に届かなかった）→ すぐ ACK し直す
+            _stats.duplicates++;
+            scheduleAck(now, 0);
+            return false;
+        }
+
+        // 窓から大きく外れた SYN は相手の再起動
+        if (syn) {
+            startRx(packet.seq);
+            advanceRx();
+            scheduleAck(now, RELIABLE_LINK_ACK_DELAY_MS);
+            return true;
+        }
+        return false;
+    }
+
+    void startRx(uint8_t seq) {
+        memset(_rx, 0, sizeof(_rx));
+        _rxSynced = true;
+        _rxNext = seq;
+        _rxFloor = seq;
+        _nackSent = false;
+    }
+
+    // _rxNext から upTo の手前までで抜けている SEQ を要求する
+    template <typename OutT>
+    bool sendNack(OutT& out, uint8_t upTo, uint32_t now, bool force) {
+        if (!force && _nackSent && now - _lastNackMs < RELIABLE_LINK_NACK_HOLDOFF_MS) return false;
+
+        uint8_t missing[RELIABLE_LINK_WINDOW];
+        uint8_t count = 0;
+        for (uint8_t seq = _rxNext; seq != upTo; seq++) {
+            const RxSlot_t& slot = _rx[seq & WINDOW_MASK];
+            if (!(slot.valid && slot.seq == seq)) missing[count++] = seq;
+        }
+        if (count == 0) return false;
+
+        uint8_t frame[PACKET_MAX_SIZE];
+        emit(out, frame, buildPacketV2(frame, PACKET_V2_ACK, 0, _rxNext, CMD_LINK_NACK, missing, count));
+        _ackPending = false;
+        _nackSent = true;
+        _lastNackMs = now;
+        _stats.nacksSent++;
+        return true;
+    }
+
+    // 並べ替えバッファで待たせている最も新しい SEQ
+    bool lastBuffered(uint8_t* seq) const {
+        for (uint8_t offset = RELIABLE_LINK_WINDOW - 1; offset > 0; offset--) {
+            uint8_t candidate = (uint8_t)(_rxNext + offset);
+            const RxSlot_t& slot = _rx[candidate & WINDOW_MASK];
+            if (slot.valid && slot.seq == candidate) {
+                *seq = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool _peerV2;
+    bool _helloSent;
+    uint32_t _lastHelloMs;
+
+    TxSlot_t _tx[RELIABLE_LINK_QUEUE];
+    uint8_t _txBase;            // ACK 待ちの最も古い SEQ
+    uint8_t _txSent;            // まだ一度も送っていない最も古い SEQ
+    uint8_t _txNext;            // 次に割り当てる SEQ
+    int32_t _srtt8;             // 平滑化した往復時間 x8（0 = まだ測っていない）
+    int32_t _rttvar4;           // 往復時間のばらつき x4
+    uint32_t _rtoMs;
+
+    RxSlot_t _rx[RELIABLE_LINK_WINDOW];
+    bool _rxSynced;
+    uint8_t _rxNext;            // 次に渡す SEQ（= 送り返す ACK）
+    uint8_t _rxFloor;           // 相手の窓の先頭（これより前は来ない）
+
+    bool _ackPending;
+    uint32_t _ackDueMs;
+    bool _nackSent;
+    uint32_t _lastNackMs;
+
+    LinkStats_t _stats;
+};
+
+#endif // COROSUKE_RELIABLE_LINK_H
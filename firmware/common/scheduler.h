@@ -0,0 +1,194 @@
+/**
+ * コロ助ロボット - 周期ジョブのスケジューラー
+ * Corosuke Robot - Deadline-Aware Cooperative Scheduler
+ *
+ * loop() の「if (now - lastX >= INTERVAL) { lastX = now; ... }」の並びを置き換える。
+ * ジョブを周期・優先度・締め切りで登録し、loop() は runDue() と sleepUntilDue() を呼ぶだけ。
+ *
+ * - 予定時刻は「前の予定時刻 + 周期」で進める（実際に動いた時刻からではない）。遅れて始まっても
+ *   次の予定は変わらないので、負荷があっても 50Hz のサーボ更新は 1 秒にきっちり 50 回になる
+ * - 1周期以上遅れたら、取り返そうとして続けて回さずに飛ばした回として数え、同じ格子に戻る
+ * - 予定時刻を過ぎたジョブが複数あれば優先度の高い順（同じなら予定時刻の早い順）。
+ *   協調型なので動いているジョブは止めない。1回の runDue() で同じジョブは1回だけ
+ * - 予定時刻から締め切りまでに終わらなかった回を超過として数える（締め切りの既定は周期）
+ * - 次の予定時刻まで vTaskDelay で眠る（空回りしない。同じコアの他のタスクと IDLE が動ける）。
+ *   tick 単位で切り上げて眠るので、始まるのは最大 1 tick 遅れる（遅れは次へ持ち越さない）
+ *
+ * 時刻は micros()（32bit、差分で比べるので一周しても平気。周期は 35 分まで）。
+ * schedulerReport() はジョブごとの回数・実行時間・遅れと眠っていた割合をシリアルに出す。
+ */
+
+#ifndef COROSUKE_SCHEDULER_H
+#define COROSUKE_SCHEDULER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SCHEDULER_MAX_JOBS      16
+
+typedef void (*SchedulerJobFn_t)();
+
+typedef struct {
+    const char* name;
+    uint32_t periodUs;
+    uint32_t deadlineUs;        // 予定時刻からこれまでに終わらなければ超過
+    uint8_t priority;           // 大きいほど先
+    uint32_t runs;
+    uint32_t overruns;          // 締め切りまでに終わらなかった回
+    uint32_t skipped;           // 1周期以上遅れて飛ばした回
+    uint32_t maxLateUs;         // 予定時刻から始まるまでの最大
+    uint32_t maxExecUs;
+    uint64_t totalExecUs;
+} SchedulerJobStats_t;
+
+typedef struct {
+    uint32_t passes;            // runDue() の回数
+    uint32_t sleeps;            // 眠った回数
+    uint64_t sleptUs;           // 眠っていた時間の合計
+    uint64_t elapsedUs;         // begin() から最後の runDue() まで（眠っていた割合の分母）
+} SchedulerStats_t;
+
+class Scheduler {
+public:
+    Scheduler() { begin(); }
+
+    void begin() {
+        _count = 0;
+        memset(_jobs, 0, sizeof(_jobs));
+        memset(&_stats, 0, sizeof(_stats));
+        _lastPassUs = nowUs();
+    }
+
+    // 戻り値: ジョブの番号（一杯・周期 0 なら -1）。
+    // deadlineUs: 0 なら周期。offsetUs: 最初の予定時刻を今からずらす（同じ周期のジョブを重ねない）
+    int8_t add(const char* name, SchedulerJobFn_t fn, uint32_t periodUs, uint8_t priority,
+               uint32_t deadlineUs = 0, uint32_t offsetUs = 0) {
+        if (_count >= SCHEDULER_MAX_JOBS || periodUs == 0 || !fn) return -1;
+        Job_t& job = _jobs[_count];
+        job.fn = fn;
+        job.dueUs = nowUs() + offsetUs;
+        job.stats.name = name;
+        job.stats.periodUs = periodUs;
+        job.stats.deadlineUs = deadlineUs ? deadlineUs : periodUs;
+        job.stats.priority = priority;
+        return (int8_t)_count++;
+    }
+
+    // 予定時刻を過ぎたジョブを優先度順に1回ずつ回す
+    void runDue() {
+        uint32_t start = nowUs();
+        _stats.elapsedUs += start - _lastPassUs;
+        _lastPassUs = start;
+
+        uint32_t ran = 0;
+        for (;;) {
+            uint32_t now = nowUs();
+            int8_t pick = -1;
+            for (uint8_t i = 0; i < _count; i++) {
+                const Job_t& job = _jobs[i];
+                if ((ran & (1u << i)) || (int32_t)(now - job.dueUs) < 0) continue;
+                if (pick < 0 || job.stats.priority > _jobs[pick].stats.priority ||
+                    (job.stats.priority == _jobs[pick].stats.priority &&
+                     (int32_t)(job.dueUs - _jobs[pick].dueUs) < 0)) {
+                    pick = (int8_t)i;
+                }
+            }
+            if (pick < 0) break;
+            ran |= 1u << pick;
+            runJob(_jobs[pick], now);
+        }
+        _stats.passes++;
+    }
+
+    // 次の予定時刻まで（どれかがもう来ていればすぐ戻る）
+    uint32_t untilDueUs() const {
+        uint32_t now = nowUs();
+        int32_t wait = INT32_MAX;
+        for (uint8_t i = 0; i < _count; i++) {
+            int32_t w = (int32_t)(_jobs[i].dueUs - now);
+            if (w < wait) wait = w;
+        }
+        return wait > 0 ? (uint32_t)wait : 0;
+    }
+
+    // 次の予定時刻まで眠る（tick 単位で切り上げ）
+    void sleepUntilDue() {
+        uint32_t waitUs = untilDueUs();
+        if (waitUs == 0) return;
+        const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+        uint32_t start = nowUs();
+        vTaskDelay((TickType_t)((waitUs + tickUs - 1) / tickUs));
+        _stats.sleeps++;
+        _stats.sleptUs += nowUs() - start;
+    }
+
+    uint8_t jobs() const { return _count; }
+    const SchedulerJobStats_t& job(uint8_t id) const { return _jobs[id].stats; }
+    const SchedulerStats_t& stats() const { return _stats; }
+
+    // begin() からの眠っていた割合（1/1000）
+    uint32_t idlePermille() const {
+        return _stats.elapsedUs ? (uint32_t)(_stats.sleptUs * 1000 / _stats.elapsedUs) : 0;
+    }
+
+private:
+    static uint32_t nowUs() { return (uint32_t)micros(); }
+
+    typedef struct {
+        SchedulerJobFn_t fn;
+        uint32_t dueUs;             // 次の予定時刻
+        SchedulerJobStats_t stats;
+    } Job_t;
+
+    void runJob(Job_t& job, uint32_t now) {
+        SchedulerJobStats_t& s = job.stats;
+        uint32_t late = now - job.dueUs;
+        if (late >= s.periodUs) {
+            // 1周期以上遅れた: 飛ばした分を数え、同じ格子の直近の予定時刻から
+            uint32_t missed = late / s.periodUs;
+            s.skipped += missed;
+            job.dueUs += missed * s.periodUs;
+            late -= missed * s.periodUs;
+        }
+        uint32_t releaseUs = job.dueUs;
+        job.dueUs += s.periodUs;
+
+        job.fn();
+
+        uint32_t end = nowUs();
+        uint32_t execUs = end - now;
+        s.runs++;
+        s.totalExecUs += execUs;
+        if (late > s.maxLateUs) s.maxLateUs = late;
+        if (execUs > s.maxExecUs) s.maxExecUs = execUs;
+        if (end - releaseUs > s.deadlineUs) s.overruns++;
+    }
+
+    Job_t _jobs[SCHEDULER_MAX_JOBS];
+    uint8_t _count;
+    SchedulerStats_t _stats;
+    uint32_t _lastPassUs;
+};
+
+// =============================================================================
+// シリアルへの報告
+// =============================================================================
+static inline void schedulerReport(const Scheduler& scheduler) {
+    for (uint8_t i = 0; i < scheduler.jobs(); i++) {
+        const SchedulerJobStats_t& job = scheduler.job(i);
+        Serial.printf("ジョブ %s: %lu 回, 実行 平均 %lu us 最大 %lu us, 遅れ最大 %lu us, 締め切り超過 %lu, 飛ばし %lu\n",
+                      job.name, (unsigned long)job.runs,
+                      (unsigned long)(job.runs ? job.totalExecUs / job.runs : 0), (unsigned long)job.maxExecUs,
+                      (unsigned long)job.maxLateUs, (unsigned long)job.overruns, (unsigned long)job.skipped);
+    }
+    const SchedulerStats_t& stats = scheduler.stats();
+    uint32_t idle = scheduler.idlePermille();
+    Serial.printf("loop() 眠っていた割合 %lu.%lu%% (%lu 回)\n",
+                  (unsigned long)(idle / 10), (unsigned long)(idle % 10), (unsigned long)stats.sleeps);
+}
+
+#endif // COROSUKE_SCHEDULER_H
@@ -0,0 +1,110 @@
+/**
+ * コロ助ロボット - ホームサーバー接続（WebSocket バイナリメッセージ）
+ * Corosuke Robot - Home Server Link (binary WebSocket messages)
+ *
+ * メインボードはサーバーの /ws に WebSocket を1本張ったままにし、
+ * 会話・読み上げ・テレメトリー・サーバーからの指令をすべてこの上でやり取りする。
+ * リクエストごとの TCP 接続・HTTP ヘッダー・JSON が不要になる。
+ *
+ * 1メッセージ = 1 WebSocket バイナリフレーム:
+ *   [type][seq][payload...]
+ *   seq は要求ごとに増やし、応答は要求の seq をそのまま返す（通知は 0）
+ *
+ * サーバー側の定義は server/robot_link.py（値をそろえること）
+ */
+
+#ifndef COROSUKE_SERVER_LINK_H
+#define COROSUKE_SERVER_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LINK_PATH               "/ws"
+#define LINK_VERSION            1
+#define LINK_RECONNECT_MS       2000    // 切れたら再接続を試す間隔
+#define LINK_PING_INTERVAL_MS   15000   // WebSocket ping の間隔
+#define LINK_PONG_TIMEOUT_MS    3000
+#define LINK_PONG_MISSES        2       // pong が続けて来なければ切断して再接続
+#define LINK_TELEMETRY_MS       5000
+#define LINK_TRACE_MS           10000   // 3枚分の処理時間の分布を送る間隔
+
+#define LINK_HEADER_SIZE        2
+#define LINK_MAX_MESSAGE        512
+
+// ボード → サーバー
+#define LINK_MSG_HELLO          0x01    // 接続直後: [version][board name]
+#define LINK_MSG_CHAT           0x02    // UTF-8 テキスト → REPLY + PLAY
+#define LINK_MSG_SPEAK          0x03    // UTF-8 テキストを読み上げ → PLAY
+#define LINK_MSG_TELEMETRY      0x04    // LinkTelemetry_t
+#define LINK_MSG_AUDIO_START    0x05    // LinkAudioStart_t（声の区間の始まり）
+#define LINK_MSG_AUDIO          0x06    // LinkAudioChunk_t + IMA-ADPCM（ima_adpcm.h）
+#define LINK_MSG_AUDIO_END      0x07    // LinkAudioEnd_t → HEARD + REPLY + PLAY
+#define LINK_MSG_TRACE          0x08    // TraceStatusData_t の列（protocol.h。前回からの処理時間の分布）
+
+// サーバー → ボード
+#define LINK_MSG_REPLY          0x81    // [expression_id][UTF-8 テキスト]
+#define LINK_MSG_PLAY           0x82    // [sample_rate u32][UTF-8 パス] を再生
+#define LINK_MSG_ROBOT_CMD      0x83    // [cmd][data...] を上半身へそのまま送る
+#define LINK_MSG_HEARD          0x84    // 声の区間を聞き取った UTF-8 テキスト（空なら聞き取れなかった）
+#define LINK_MSG_ERROR          0x8F    // UTF-8 エラーメッセージ
+
+#define LINK_FLAG_PERSON        0x01
+#define LINK_FLAG_SPEAKING      0x02
+#define LINK_FLAG_LISTENING     0x04
+
+#define LINK_AUDIO_IMA_ADPCM    1       // LinkAudioStart_t.codec
+
+// LinkAudioEnd_t.reason
+#define LINK_AUDIO_END_SILENCE  0       // 声が途切れた
+#define LINK_AUDIO_END_LENGTH   1       // VAD_MAX_SEGMENT_MS で区切った（続きは次の区間）
+#define LINK_AUDIO_END_CANCEL   2       // 打ち切り（ロボットが話し始めた）。サーバーは捨てる
+
+// テレメトリー（リトルエンディアン、詰めて送る）
+typedef struct __attribute__((packed)) {
+    uint32_t uptime_ms;
+    uint32_t free_heap;
+    int8_t rssi;            // dBm
+    uint8_t flags;          // LINK_FLAG_*
+    int16_t person_x;       // 顔の位置 (320x240 基準)
+    int16_t person_y;
+    uint16_t vision_fps_x10;
+    uint16_t reconnects;    // 起動してからの再接続回数
+} LinkTelemetry_t;
+
+// 声の区間（リトルエンディアン、詰めて送る）。segment は区間ごとに増やす
+typedef struct __attribute__((packed)) {
+    uint8_t segment;
+    uint8_t codec;          // LINK_AUDIO_*
+    uint32_t sample_rate;
+    uint16_t preroll_ms;    // 検出より前から含めた長さ
+} LinkAudioStart_t;
+
+// この後に IMA-ADPCM（1 バイト 2 サンプル、下位ニブルが先）が続く。
+// 符号化の状態を頭に付けるので、チャンクごとに単独で復号できる
+typedef struct __attribute__((packed)) {
+    uint8_t segment;
+    uint16_t chunk;         // 区間の中の通し番号（抜けたら無音で埋める）
+    int16_t predictor;      // このチャンクの前の AdpcmState_t
+    uint8_t step_index;
+} LinkAudioChunk_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t segment;
+    uint8_t reason;         // LINK_AUDIO_END_*
+    uint16_t chunks;        // 送ったチャンク数
+} LinkAudioEnd_t;
+
+#define LINK_AUDIO_MAX_DATA     (LINK_MAX_MESSAGE - LINK_HEADER_SIZE - sizeof(LinkAudioChunk_t))
+
+// [type][seq][payload] を組み立てる。収まらなければ 0
+static inline size_t linkEncode(uint8_t* out, size_t capacity, uint8_t type, uint8_t seq,
+                                const void* payload, size_t length) {
+    if (LINK_HEADER_SIZE + length > capacity) return 0;
+    out[0] = type;
+    out[1] = seq;
+    if (length) memcpy(out + LINK_HEADER_SIZE, payload, length);
+    return LINK_HEADER_SIZE + length;
+}
+
+#endif // COROSUKE_SERVER_LINK_H
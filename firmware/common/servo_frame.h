@@ -0,0 +1,226 @@
+/**
+ * コロ助ロボット - サーボフレーム
+ * Corosuke Robot - Servo Frame Encoder / Receiver
+ *
+ * CMD_SERVO_FRAME / CMD_SERVO_FRAME_DELTA の組み立てと受信側の保持。
+ *
+ * - 差分フレームは「直前のキーフレームからの変化」を送るので、
+ *   差分フレームを1つ取りこぼしても次の差分で正しい姿勢に戻る
+ * - キーフレームを取りこぼすと、それを基準にした差分は基準不一致ですべて捨てられる。
+ *   キーフレームは ReliableLink で確実に送る（linkCommandIsReliable）ので、再送が届けば
+ *   その次の tick から戻る。送れなかったときは encoder.reset() で次をキーフレームにする
+ * - 受信したフレームは保留しておき、サーボ更新の tick でまとめて取り出す
+ *   （同じ tick 内で全チャンネルが一度に切り替わる）
+ */
+
+#ifndef COROSUKE_SERVO_FRAME_H
+#define COROSUKE_SERVO_FRAME_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "protocol.h"
+
+// この間隔ごとに差分ではなくキーフレームを送る（キーフレームの再送も諦めたときの復帰用）
+#define SERVO_FRAME_KEYFRAME_INTERVAL 25
+
+// 1 tick で適用する姿勢
+typedef struct {
+    uint8_t angles[SERVO_FRAME_CHANNELS];
+    uint16_t mask;          // 駆動するチャンネル
+    uint8_t flags;
+    uint8_t seq;
+} ServoPose_t;
+
+typedef struct {
+    uint32_t keyframes;     // 受信したキーフレーム
+    uint32_t deltas;        // 受信した差分フレーム
+    uint32_t rejected;      // 基準キーフレーム不一致・長さ異常
+    uint32_t superseded;    // tick を待つ間に上書きされたフレーム
+} ServoFrameStats_t;
+
+// =============================================================================
+// 受信側
+// =============================================================================
+class ServoFrameReceiver {
+public:
+    ServoFrameReceiver() : _body(BODY_UPPER) { reset(); }
+    explicit ServoFrameReceiver(ServoBody_t body) : _body(body) { reset(); }
+
+    void reset() {
+        memset(_keyframe, SERVO_FRAME_HOLD, sizeof(_keyframe));
+        _keyValid = false;
+        _keySeq = 0;
+        _pending = false;
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    const ServoFrameStats_t& stats() const { return _stats; }
+
+    // コマンドを受け取る（対象外のコマンド・宛先なら false）
+    bool receive(uint8_t cmd, const uint8_t* data, uint8_t length) {
+        if (cmd == CMD_SERVO_FRAME) {
+            if (length < sizeof(ServoFrameData_t)) {
+                _stats.rejected++;
+                return false;
+            }
+            const ServoFrameData_t* frame = (const ServoFrameData_t*)data;
+            if (frame->body != _body) return false;
+
+            memcpy(_keyframe, frame->angles, SERVO_FRAME_CHANNELS);
+            _keySeq = frame->seq;
+            _keyValid = true;
+            _stats.keyframes++;
+            stage(_keyframe, frame->seq, frame->flags);
+            return true;
+        }
+
+        if (cmd == CMD_SERVO_FRAME_DELTA) {
+            if (length < sizeof(ServoFrameDeltaHeader_t)) {
+                _stats.rejected++;
+                return false;
+            }
+            const ServoFrameDeltaHeader_t* header = (const ServoFrameDeltaHeader_t*)data;
+            if (header->body != _body) return false;
+
+            uint16_t mask = header->mask;
+            if (!_keyValid || header->base_seq != _keySeq ||
+                length < sizeof(ServoFrameDeltaHeader_t) + popcount16(mask)) {
+                _stats.rejected++;
+                return false;
+            }
+
+            uint8_t angles[SERVO_FRAME_CHANNELS];
+            memcpy(angles, _keyframe, SERVO_FRAME_CHANNELS);
+            const uint8_t* values = data + sizeof(ServoFrameDeltaHeader_t);
+            for (uint8_t ch = 0; mask != 0; ch++, mask >>= 1) {
+                if (mask & 1) {
+                    angles[ch] = *values++;
+                }
+            }
+            _stats.deltas++;
+            stage(angles, header->seq, header->flags);
+            return true;
+        }
+
+        return false;
+    }
+
+    // サーボ更新 tick で呼ぶ。保留中のフレームがあれば取り出す
+    bool take(ServoPose_t* pose) {
+        if (!_pending) return false;
+        *pose = _pose;
+        _pending = false;
+        return true;
+    }
+
+private:
+    static uint8_t popcount16(uint16_t v) {
+        uint8_t n = 0;
+        for (; v != 0; v &= v - 1) n++;
+        return n;
+    }
+
+    void stage(const uint8_t* angles, uint8_t seq, uint8_t flags) {
+        if (_pending) _stats.superseded++;
+
+        _pose.mask = 0;
+        for (uint8_t ch = 0; ch < SERVO_FRAME_CHANNELS; ch++) {
+            uint8_t angle = angles[ch];
+            if (angle != SERVO_FRAME_HOLD) {
+                _pose.angles[ch] = angle > 180 ? 180 : angle;
+                _pose.mask |= (uint16_t)(1u << ch);
+            }
+        }
+        _pose.flags = flags;
+        _pose.seq = seq;
+        _pending = true;
+    }
+
+    ServoBody_t _body;
+    uint8_t _keyframe[SERVO_FRAME_CHANNELS];
+    uint8_t _keySeq;
+    bool _keyValid;
+    bool _pending;
+    ServoPose_t _pose;
+    ServoFrameStats_t _stats;
+};
+
+// =============================================================================
+// 送信側
+// =============================================================================
+class ServoFrameEncoder {
+public:
+    explicit ServoFrameEncoder(ServoBody_t body) : _body(body) { reset(); }
+
+    // 次のフレームを必ずキーフレームにする
+    void reset() {
+        memset(_keyframe, SERVO_FRAME_HOLD, sizeof(_keyframe));
+        _keyValid = false;
+        _seq = 0;
+        _sinceKeyframe = 0;
+    }
+
+    // 姿勢をエンコードする。*cmd にコマンド、戻り値にデータ長を返す
+    // （data は sizeof(ServoFrameData_t) バイト以上）
+    uint8_t encode(const uint8_t angles[SERVO_FRAME_CHANNELS], uint8_t flags,
+                   uint8_t* cmd, uint8_t* data) {
+        uint16_t mask = 0;
+        uint8_t changed = 0;
+        if (_keyValid) {
+            for (uint8_t ch = 0; ch < SERVO_FRAME_CHANNELS; ch++) {
+                if (angles[ch] != _keyframe[ch]) {
+                    mask |= (uint16_t)(1u << ch);
+                    changed++;
+                }
+            }
+        }
+
+        _seq++;
+
+        // 差分のほうが大きくなる・キーフレーム間隔を超えた → キーフレーム
+        bool keyframe = !_keyValid || _sinceKeyframe >= SERVO_FRAME_KEYFRAME_INTERVAL ||
+                        sizeof(ServoFrameDeltaHeader_t) + changed >= sizeof(ServoFrameData_t);
+        if (keyframe) {
+            ServoFrameData_t* frame = (ServoFrameData_t*)data;
+            frame->body = _body;
+            frame->seq = _seq;
+            frame->flags = flags;
+            memcpy(frame->angles, angles, SERVO_FRAME_CHANNELS);
+
+            memcpy(_keyframe, angles, SERVO_FRAME_CHANNELS);
+            _keySeq = _seq;
+            _keyValid = true;
+            _sinceKeyframe = 0;
+            *cmd = CMD_SERVO_FRAME;
+            return sizeof(ServoFrameData_t);
+        }
+
+        ServoFrameDeltaHeader_t* header = (ServoFrameDeltaHeader_t*)data;
+        header->body = _body;
+        header->seq = _seq;
+        header->flags = flags;
+        header->base_seq = _keySeq;
+        header->mask = mask;
+
+        uint8_t* values = data + sizeof(ServoFrameDeltaHeader_t);
+        for (uint8_t ch = 0; ch < SERVO_FRAME_CHANNELS; ch++) {
+            if (mask & (1u << ch)) {
+                *values++ = angles[ch];
+            }
+        }
+        _sinceKeyframe++;
+        *cmd = CMD_SERVO_FRAME_DELTA;
+        return (uint8_t)(sizeof(ServoFrameDeltaHeader_t) + changed);
+    }
+
+private:
+    ServoBody_t _body;
+    uint8_t _keyframe[SERVO_FRAME_CHANNELS];
+    uint8_t _keySeq;
+    uint8_t _seq;
+    bool _keyValid;
+    uint8_t _sinceKeyframe;
+};
+
+#endif // COROSUKE_SERVO_FRAME_H
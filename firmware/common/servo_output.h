@@ -0,0 +1,220 @@
+/**
+ * コロ助ロボット - PCA9685 サーボ出力ステージ
+ * Corosuke Robot - Batched PCA9685 Servo Output
+ *
+ * set() で値を溜めておき、サーボ更新 tick ごとに flush() で書き込む。
+ *
+ * - 前回書き込んだ値から変わったチャンネルだけを書く
+ * - 連続したチャンネルはオートインクリメント（MODE1.AI）で
+ *   1トランザクションにまとめる。1チャンネルだけ離れた隙間は
+ *   トランザクションを分けるより埋めたほうが短いので一緒に書く
+ * - PCA9685 は STOP で出力を更新するので、1トランザクションで書いた
+ *   チャンネルは同じ PWM 周期から一斉に切り替わる
+ * - 書き込み失敗が続いたら SCL を手動でクロックしてバスを解放し、
+ *   MODE1/PRESCALE を復元して全チャンネルを書き直す
+ */
+
+#ifndef COROSUKE_SERVO_OUTPUT_H
+#define COROSUKE_SERVO_OUTPUT_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_PWMServoDriver.h>   // レジスタ定義
+
+#define SERVO_OUTPUT_CHANNELS       16
+#define SERVO_OUTPUT_MERGE_GAP      1   // この数以下の隙間は埋めて1トランザクションに
+#define SERVO_OUTPUT_RECOVER_AFTER  3   // 連続エラーでバス復旧
+
+typedef struct {
+    uint32_t ticks;             // flush() 回数
+    uint32_t transactions;      // I2Cトランザクション数
+    uint32_t channelWrites;     // 書き込んだチャンネル数（隙間埋めを含む）
+    uint32_t errors;            // 書き込み失敗
+    uint32_t recoveries;        // バス復旧
+    uint32_t lastBusUs;         // 直近の flush() のバス時間
+    uint32_t maxBusUs;
+    uint64_t totalBusUs;
+} ServoOutputStats_t;
+
+class ServoOutput {
+public:
+    ServoOutput(uint8_t address, TwoWire& wire = Wire)
+        : _address(address), _wire(&wire) {
+        memset(_value, 0, sizeof(_value));
+        memset(_written, 0, sizeof(_written));
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // PCA9685 の初期化（周波数設定）後に呼ぶ。復旧時に戻す MODE1/PRESCALE を覚え、
+    // オートインクリメントを有効にする
+    bool begin(int sdaPin, int sclPin, uint32_t clockHz) {
+        _sdaPin = sdaPin;
+        _sclPin = sclPin;
+        _clockHz = clockHz;
+        _wire->setClock(clockHz);
+
+        uint8_t mode1 = 0;
+        if (!read8(PCA9685_MODE1, &mode1) || !read8(PCA9685_PRESCALE, &_prescale)) {
+            return false;
+        }
+        _mode1 = (mode1 & ~(MODE1_RESTART | MODE1_SLEEP)) | MODE1_AI;
+        return write8(PCA9685_MODE1, _mode1);
+    }
+
+    // OFF カウント (0-4095) を設定する。実際の書き込みは flush()
+    void set(uint8_t channel, uint16_t off) {
+        if (channel >= SERVO_OUTPUT_CHANNELS) return;
+        _value[channel] = off;
+        if (off != _written[channel]) {
+            _dirty |= (uint16_t)(1u << channel);
+        } else {
+            _dirty &= (uint16_t)~(1u << channel);
+        }
+    }
+
+    uint16_t dirtyMask() const { return _dirty; }
+    const ServoOutputStats_t& stats() const { return _stats; }
+
+    // 変化したチャンネルを書き込む（サーボ更新 tick ごとに1回）
+    bool flush() {
+        _stats.ticks++;
+        if (_dirty == 0) {
+            _stats.lastBusUs = 0;
+            return true;
+        }
+
+        uint32_t start = micros();
+        bool ok = true;
+        uint8_t ch = 0;
+        while (ch < SERVO_OUTPUT_CHANNELS && (_dirty >> ch) != 0) {
+            if (!(_dirty & (1u << ch))) {
+                ch++;
+                continue;
+            }
+            uint8_t first = ch;
+            uint8_t last = ch;
+            for (uint8_t n = ch + 1; n < SERVO_OUTPUT_CHANNELS; n++) {
+                if (_dirty & (1u << n)) {
+                    if (n - last - 1 > SERVO_OUTPUT_MERGE_GAP) break;
+                    last = n;
+                }
+            }
+            if (!writeRun(first, last)) {
+                ok = false;
+                break;
+            }
+            ch = last + 1;
+        }
+
+        uint32_t busUs = micros() - start;
+        _stats.lastBusUs = busUs;
+        _stats.totalBusUs += busUs;
+        if (busUs > _stats.maxBusUs) _stats.maxBusUs = busUs;
+
+        if (ok) {
+            _errorStreak = 0;
+        } else if (++_errorStreak >= SERVO_OUTPUT_RECOVER_AFTER) {
+            recoverBus();
+        }
+        return ok;
+    }
+
+    // 平均バス時間 (μs / tick)
+    uint32_t averageBusUs() const {
+        return _stats.ticks ? (uint32_t)(_stats.totalBusUs / _stats.ticks) : 0;
+    }
+
+private:
+    bool writeRun(uint8_t first, uint8_t last) {
+        uint8_t buffer[1 + 4 * SERVO_OUTPUT_CHANNELS];
+        uint8_t length = 0;
+        buffer[length++] = PCA9685_LED0_ON_L + 4 * first;
+        for (uint8_t ch = first; ch <= last; ch++) {
+            buffer[length++] = 0;                   // ON_L
+            buffer[length++] = 0;                   // ON_H
+            buffer[length++] = _value[ch] & 0xFF;   // OFF_L
+            buffer[length++] = _value[ch] >> 8;     // OFF_H
+        }
+
+        _wire->beginTransmission(_address);
+        _wire->write(buffer, length);
+        _stats.transactions++;
+        if (_wire->endTransmission() != 0) {
+            _stats.errors++;
+            return false;
+        }
+        for (uint8_t ch = first; ch <= last; ch++) {
+            _written[ch] = _value[ch];
+        }
+        _dirty &= (uint16_t)~(((1u << (last - first + 1)) - 1) << first);
+        _stats.channelWrites += last - first + 1;
+        return true;
+    }
+
+    // SDA を握ったままのスレーブを解放する（SCL 最大9クロック + STOP）
+    void recoverBus() {
+        _stats.recoveries++;
+        _errorStreak = 0;
+
+        if (_sdaPin >= 0 && _sclPin >= 0) {
+            _wire->end();
+            pinMode(_sdaPin, INPUT_PULLUP);
+            pinMode(_sclPin, OUTPUT_OPEN_DRAIN);
+            for (int i = 0; i < 9 && digitalRead(_sdaPin) == LOW; i++) {
+                digitalWrite(_sclPin, LOW);
+                delayMicroseconds(5);
+                digitalWrite(_sclPin, HIGH);
+                delayMicroseconds(5);
+            }
+            pinMode(_sdaPin, OUTPUT_OPEN_DRAIN);
+            digitalWrite(_sdaPin, LOW);
+            delayMicroseconds(5);
+            digitalWrite(_sclPin, HIGH);
+            delayMicroseconds(5);
+            digitalWrite(_sdaPin, HIGH);
+            _wire->begin(_sdaPin, _sclPin, _clockHz);
+        }
+
+        // PCA9685 がリセットされていれば周波数設定からやり直す
+        uint8_t mode1 = 0;
+        if (read8(PCA9685_MODE1, &mode1) && (mode1 & ~MODE1_RESTART) != _mode1) {
+            write8(PCA9685_MODE1, (_mode1 & ~MODE1_RESTART) | MODE1_SLEEP);
+            write8(PCA9685_PRESCALE, _prescale);
+            write8(PCA9685_MODE1, _mode1);
+            delayMicroseconds(500);
+        }
+        _dirty = 0xFFFF;
+    }
+
+    bool write8(uint8_t reg, uint8_t value) {
+        _wire->beginTransmission(_address);
+        _wire->write(reg);
+        _wire->write(value);
+        return _wire->endTransmission() == 0;
+    }
+
+    bool read8(uint8_t reg, uint8_t* value) {
+        _wire->beginTransmission(_address);
+        _wire->write(reg);
+        if (_wire->endTransmission() != 0) return false;
+        if (_wire->requestFrom((uint8_t)_address, (uint8_t)1) != 1) return false;
+        *value = (uint8_t)_wire->read();
+        return true;
+    }
+
+    uint8_t _address;
+    TwoWire* _wire;
+    int _sdaPin = -1;
+    int _sclPin = -1;
+    uint32_t _clockHz = 400000;
+    uint8_t _mode1 = MODE1_AI;
+    uint8_t _prescale = 0;
+
+    uint16_t _value[SERVO_OUTPUT_CHANNELS];
+    uint16_t _written[SERVO_OUTPUT_CHANNELS];
+    uint16_t _dirty = 0;
+    uint8_t _errorStreak = 0;
+    ServoOutputStats_t _stats;
+};
+
+#endif // COROSUKE_SERVO_OUTPUT_H
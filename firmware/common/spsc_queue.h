@@ -0,0 +1,58 @@
+/**
+ * コロ助ロボット - ロックフリー SPSC キュー
+ * Corosuke Robot - Lock-Free Single-Producer Single-Consumer Queue
+ *
+ * 書き込み側1タスク・読み出し側1タスク専用のリングバッファ。
+ * コア間（loop() の core 1 と制御タスクの core 0）で要素を渡しても
+ * ミューテックスや割り込み禁止を使わないので、制御周期を乱さない。
+ *
+ * - head は読み出し側だけ、tail は書き込み側だけが更新する
+ * - 要素を書いてから tail を release で公開し、相手は acquire で読む
+ * - 満杯時の push() は失敗を返すだけ（呼び出し側で数える）
+ */
+
+#ifndef COROSUKE_SPSC_QUEUE_H
+#define COROSUKE_SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    // 書き込み側: 満杯なら false
+    bool push(const T& item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= N) return false;
+        _items[tail & (N - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 読み出し側: 空なら false
+    bool pop(T* item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) return false;
+        *item = _items[head & (N - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // どちらの側から呼んでも目安の値（相手側が同時に動いている）
+    size_t size() const {
+        return (size_t)(_tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire));
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+};
+
+#endif // COROSUKE_SPSC_QUEUE_H
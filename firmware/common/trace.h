@@ -0,0 +1,233 @@
+/**
+ * コロ助ロボット - 処理時間の計測（トレース）
+ * Corosuke Robot - Lock-Free Trace Ring and Per-Stage Latency Histograms
+ *
+ * loop() やタスクの中の処理（TraceStage_t）ごとに、かかった時間を CPU のサイクル
+ * カウンタで測って次の2か所に残す。どちらもロックも割り込み禁止も使わない。
+ *
+ * - 処理ごとの累計: 回数・合計・最大・TRACE_BUDGET_US（サーボ 1 tick）超えの回数と、
+ *   2 のべき乗の幅のヒストグラム（TRACE_BUCKETS）。1つの処理を書くのは1つのタスク
+ *   だけなので、書き込みはただの加算。読む側は 32bit を1つずつ読むだけで、
+ *   フィールドの間で数回分ずれることがある（表示と集計用なので許す）
+ * - TRACE_RING_MIN_US 以上かかったイベントのリング（TRACE_RING_SIZE 件。短いものまで残すと
+ *   回り続ける loop() ですぐ一周する）: 書き込み位置を fetch_add で取るので
+ *   どのタスクからでも書ける。スロットの通し番号を書き込みの前後で入れ替え、読む側は
+ *   前後で番号が変わっていないスロットだけを使う（書き込み中・上書きされたものは捨てる）
+ *
+ * fillStatus() は前回からの差分を TraceStatusData_t にして CMD_STATUS_RESP で返す
+ * （読む側は1つだけにする）。ホームサーバーが3枚分を集めて、どこが 20ms を食っているかを見る。
+ * traceReport() は同じ累計とリングをシリアルに出す（各ボードの定期報告用）。
+ * 1回の記録はサイクルカウンタの読み出し2回と割り算1回、加算とリングへの書き込みで 1us 未満。
+ */
+
+#ifndef COROSUKE_TRACE_H
+#define COROSUKE_TRACE_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "config.h"
+#include "protocol.h"
+
+#define TRACE_RING_SIZE     256     // 直近のイベント（2のべき乗）
+#define TRACE_RING_MIN_US   1000    // これより短い処理はリングに残さない（累計には入る）
+#define TRACE_BUDGET_US     (SERVO_UPDATE_INTERVAL_MS * 1000UL)
+
+// 処理ごとの累計（起動から。回数は 32bit で一周するので差分で使う）
+typedef struct {
+    uint32_t samples;
+    uint32_t overBudget;
+    uint64_t totalUs;           // 32bit だと loop() の分は 71 分で一周して起動からの平均が狂う
+    uint32_t maxUs;             // 起動からの最大
+    uint32_t windowMaxUs;       // 前回の fillStatus() からの最大（fillStatus() が 0 に戻す）
+    uint32_t buckets[TRACE_BUCKETS];
+} TraceCounters_t;
+
+typedef struct {
+    uint32_t startCycles;       // 始まりのサイクルカウンタ（240MHz だと 17.9 秒で一周する）
+    uint32_t ms;                // 記録した時刻（millis()。何秒前のことかはこちらで見る）
+    uint32_t us;
+    uint8_t stage;              // TraceStage_t
+} TraceEvent_t;
+
+// かかった時間 → ヒストグラムの番号
+static inline uint8_t traceBucket(uint32_t us) {
+    if (us < TRACE_BUCKET0_US) return 0;
+    uint32_t bucket = (32 - __builtin_clz(us)) - (32 - __builtin_clz(TRACE_BUCKET0_US)) + 1;
+    return (uint8_t)(bucket < TRACE_BUCKETS ? bucket : TRACE_BUCKETS - 1);
+}
+
+// ヒストグラムの番号 → その幅の上端（us、最後の番号は上端なし）
+static inline uint32_t traceBucketLimitUs(uint8_t bucket) {
+    return bucket < TRACE_BUCKETS - 1 ? (uint32_t)TRACE_BUCKET0_US << bucket : UINT32_MAX;
+}
+
+static const char* const TRACE_STAGE_NAMES[TRACE_STAGES] = {
+    "loop", "uart", "imu", "balance", "gait", "control", "servo_tick",
+    "servo_write", "led_show", "audio", "camera", "mic", "server"
+};
+
+class Tracer {
+public:
+    Tracer() {
+        _board = TRACE_BOARD_MAIN;
+        _cyclesPerUs = 240;
+        memset(_counters, 0, sizeof(_counters));
+        memset(_reported, 0, sizeof(_reported));
+    }
+
+    void begin(TraceBoard_t board) {
+        _board = board;
+        _cyclesPerUs = ESP.getCpuFreqMHz();
+        if (_cyclesPerUs == 0) _cyclesPerUs = 1;
+    }
+
+    static uint32_t cycles() { return ESP.getCycleCount(); }
+
+    // startCycles から今までを stage の1回として記録する（stage ごとに書くタスクは1つ）
+    void record(TraceStage_t stage, uint32_t startCycles) {
+        uint32_t us = (cycles() - startCycles) / _cyclesPerUs;
+
+        TraceCounters_t& c = _counters[stage];
+        c.samples++;
+        c.totalUs += us;
+        c.buckets[traceBucket(us)]++;
+        if (us > c.maxUs) c.maxUs = us;
+        if (us > c.windowMaxUs) c.windowMaxUs = us;
+        if (us > TRACE_BUDGET_US) c.overBudget++;
+        if (us < TRACE_RING_MIN_US) return;
+
+        uint32_t index = _head.fetch_add(1, std::memory_order_relaxed);
+        Slot_t& slot = _ring[index & (TRACE_RING_SIZE - 1)];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event.startCycles = startCycles;
+        slot.event.ms = millis();
+        slot.event.us = us;
+        slot.event.stage = (uint8_t)stage;
+        slot.seq.store(index + 1, std::memory_order_release);
+    }
+
+    // 前回からの差分（一度も記録していない処理は false）
+    bool fillStatus(TraceStage_t stage, TraceStatusData_t* out) {
+        TraceCounters_t now = _counters[stage];
+        if (now.samples == 0) return false;
+        _counters[stage].windowMaxUs = 0;      // 書き込みと重なったらその1回分を取りこぼすだけ
+        TraceCounters_t& last = _reported[stage];
+
+        out->kind = STATUS_RESP_TRACE;
+        out->board = _board;
+        out->stage = (uint8_t)stage;
+        out->samples = now.samples - last.samples;
+        out->over_budget = now.overBudget - last.overBudget;
+        out->total_us = (uint32_t)(now.totalUs - last.totalUs);
+        out->max_us = now.windowMaxUs;
+
+        uint32_t delta[TRACE_BUCKETS];
+        uint32_t largest = 0;
+        for (uint8_t i = 0; i < TRACE_BUCKETS; i++) {
+            delta[i] = now.buckets[i] - last.buckets[i];
+            if (delta[i] > largest) largest = delta[i];
+        }
+        uint8_t scale = 0;
+        while ((largest >> scale) > 0xFFFF) scale++;
+        out->scale = scale;
+        for (uint8_t i = 0; i < TRACE_BUCKETS; i++) {
+            out->buckets[i] = (uint16_t)(delta[i] >> scale);
+        }
+
+        last = now;
+        return true;
+    }
+
+    // 新しい順に最大 max 件（書き込み中・上書きされたスロットは飛ばす）。どのタスクからでも読める
+    size_t recent(TraceEvent_t* out, size_t max) const {
+        uint32_t head = _head.load(std::memory_order_acquire);
+        size_t n = 0;
+        for (uint32_t i = 0; i < TRACE_RING_SIZE && i < head && n < max; i++) {
+            uint32_t index = head - 1 - i;
+            const Slot_t& slot = _ring[index & (TRACE_RING_SIZE - 1)];
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != index + 1) continue;
+            TraceEvent_t event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+            out[n++] = event;
+        }
+        return n;
+    }
+
+    // 起動からの分布で permille/1000 の回数が収まる幅の上端（us、記録がなければ 0）
+    uint32_t percentileUs(TraceStage_t stage, uint16_t permille) const {
+        const TraceCounters_t& c = _counters[stage];
+        uint64_t goal = ((uint64_t)c.samples * permille + 999) / 1000;
+        uint64_t seen = 0;
+        for (uint8_t i = 0; i < TRACE_BUCKETS && c.samples; i++) {
+            seen += c.buckets[i];
+            if (seen >= goal) return i < TRACE_BUCKETS - 1 ? traceBucketLimitUs(i) : c.maxUs;
+        }
+        return 0;
+    }
+
+    const TraceCounters_t& counters(TraceStage_t stage) const { return _counters[stage]; }
+    uint32_t events() const { return _head.load(std::memory_order_relaxed); }
+    uint32_t cyclesPerUs() const { return _cyclesPerUs; }
+    TraceBoard_t board() const { return _board; }
+
+private:
+    typedef struct {
+        std::atomic<uint32_t> seq{0};   // 書き込んだイベントの通し番号 + 1（書き込み中は 0）
+        TraceEvent_t event;
+    } Slot_t;
+
+    TraceBoard_t _board;
+    uint32_t _cyclesPerUs;
+    TraceCounters_t _counters[TRACE_STAGES];
+    TraceCounters_t _reported[TRACE_STAGES];   // fillStatus() が前回返したときの累計
+    Slot_t _ring[TRACE_RING_SIZE];
+    std::atomic<uint32_t> _head{0};
+};
+
+// =============================================================================
+// シリアルへの報告（起動からの分布と、リングに残っている TRACE_BUDGET_US 超え）
+// =============================================================================
+static inline void traceReport(const Tracer& tracer) {
+    static TraceEvent_t events[TRACE_RING_SIZE];
+    for (uint8_t i = 0; i < TRACE_STAGES; i++) {
+        const TraceCounters_t& c = tracer.counters((TraceStage_t)i);
+        if (c.samples == 0) continue;
+        Serial.printf("処理時間 %s: %lu 回, 平均 %lu us, 99%% %lu us 以下, 最大 %lu us, %lu ms 超え %lu\n",
+                      TRACE_STAGE_NAMES[i], (unsigned long)c.samples, (unsigned long)(c.totalUs / c.samples),
+                      (unsigned long)tracer.percentileUs((TraceStage_t)i, 990), (unsigned long)c.maxUs,
+                      (unsigned long)(TRACE_BUDGET_US / 1000), (unsigned long)c.overBudget);
+    }
+    uint32_t now = millis();
+    size_t count = tracer.recent(events, TRACE_RING_SIZE);
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].us <= TRACE_BUDGET_US) continue;
+        Serial.printf("  超えた処理: %s %lu us (%lu ms 前)\n", TRACE_STAGE_NAMES[events[i].stage],
+                      (unsigned long)events[i].us, (unsigned long)(now - events[i].ms));
+    }
+}
+
+// スコープを抜けるまでを1回として記録する
+class TraceScope {
+public:
+    TraceScope(Tracer& tracer, TraceStage_t stage)
+        : _tracer(tracer), _stage(stage), _start(Tracer::cycles()) {}
+    ~TraceScope() { _tracer.record(_stage, _start); }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+
+    Tracer& _tracer;
+    TraceStage_t _stage;
+    uint32_t _start;
+};
+
+#endif // COROSUKE_TRACE_H
@@ -0,0 +1,227 @@
+/**
+ * コロ助ロボット - 関節軌道（最小躍度）
+ * Corosuke Robot - Minimum-Jerk Joint Trajectories
+ *
+ * 目標角度と移動時間を受け取り、関節ごとに 5 次の最小躍度曲線で動かす。
+ * 「残りの 20% ずつ寄せる」ような tick 数に依存する動きではなく時刻で決まるので、
+ * サーボ更新周期が変わっても、ExpressionData_t.duration_ms などで指定した時間どおりに動く。
+ *
+ * - 関節ごとに速度・加速度の上限を持ち、指定時間では超えてしまう移動は時間を延ばす
+ *   （時間 0 = 上限の範囲でいちばん速く）
+ * - 動いている途中で目標が変わったら、今の位置と速度からつなぐ（止まってから動き直さない）
+ * - 歩容のように毎 tick 動く目標は follow() で関節のまとまりごとにそのまま出す
+ * - update() は動いている関節だけを回る（O(動いている関節数)）
+ * - 角度は度の float、時刻は millis()
+ */
+
+#ifndef COROSUKE_TRAJECTORY_H
+#define COROSUKE_TRAJECTORY_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TRAJ_CHANNELS       16
+
+// 最小躍度曲線のピーク速度・ピーク加速度（平均速度 D/T、D/T² に対する倍率）
+#define TRAJ_PEAK_VEL       1.875f
+#define TRAJ_PEAK_ACC       5.7735f
+
+typedef struct {
+    float maxVel;           // 度/秒
+    float maxAcc;           // 度/秒²
+} TrajLimits_t;
+
+typedef struct {
+    uint32_t moves;         // moveTo() で始めた移動
+    uint32_t stretched;     // 上限を守るために時間を延ばした移動
+    uint32_t retargets;     // 動いている途中で目標を変えた移動
+} TrajStats_t;
+
+class TrajectoryPlanner {
+public:
+    TrajectoryPlanner() {
+        memset(_joints, 0, sizeof(_joints));
+        memset(&_stats, 0, sizeof(_stats));
+        for (uint8_t ch = 0; ch < TRAJ_CHANNELS; ch++) {
+            _joints[ch].limits.maxVel = 360.0f;
+            _joints[ch].limits.maxAcc = 3600.0f;
+        }
+    }
+
+    void setLimits(uint8_t ch, float maxVel, float maxAcc) {
+        if (ch >= TRAJ_CHANNELS || maxVel <= 0.0f || maxAcc <= 0.0f) return;
+        _joints[ch].limits.maxVel = maxVel;
+        _joints[ch].limits.maxAcc = maxAcc;
+    }
+
+    const TrajLimits_t& limits(uint8_t ch) const { return _joints[ch].limits; }
+
+    // 補間せずにその角度にする（起動時・サーボフレームの SNAP）
+    void snap(uint8_t ch, float angle) {
+        if (ch >= TRAJ_CHANNELS) return;
+        Joint_t& j = _joints[ch];
+        j.position = j.target = j.from = angle;
+        j.delta = j.v0 = 0.0f;
+        _active &= (uint16_t)~(1u << ch);
+        _pending |= (uint16_t)(1u << ch);
+    }
+
+    // durationMs かけて target へ（0 = 上限の範囲でいちばん速く）
+    void moveTo(uint8_t ch, float target, uint32_t nowMs, uint32_t durationMs = 0) {
+        moveWithin(ch, target, nowMs, durationMs, 1.0f);
+    }
+
+    // 速度の上限を speedPercent (1-100) % にして target へ（EyePositionData_t.speed など）
+    void moveAtSpeed(uint8_t ch, float target, uint32_t nowMs, uint8_t speedPercent) {
+        float scale = speedPercent == 0 || speedPercent >= 100 ? 1.0f : speedPercent / 100.0f;
+        moveWithin(ch, target, nowMs, 0, scale);
+    }
+
+    // 毎 tick 動く目標（歩容など）を mask の関節まとめて追う。戻り値: 目標をそのまま出している。
+    // 関節ごとに軌道を引き直すと関節ごとに遅れ方が違い、逆運動学で揃えた姿勢が崩れるので、
+    // 目標が速度の上限の範囲（intervalMs あたり）で動いている間は補間せずにそのまま出す。
+    // 上限を超えて飛んだ目標へは、全関節 durationMs の同じ時間で移る（false の間は目標を止めておく）
+    bool follow(uint16_t mask, const float* targets, uint32_t nowMs, uint32_t intervalMs, uint32_t durationMs) {
+        mask &= (uint16_t)((1u << TRAJ_CHANNELS) - 1);
+        bool jumped = false;
+        for (uint16_t m = mask; m != 0; m &= (uint16_t)(m - 1)) {
+            uint8_t ch = (uint8_t)__builtin_ctz(m);
+            float step = _joints[ch].limits.maxVel * intervalMs * 0.001f;
+            if (fabsf(targets[ch] - _joints[ch].target) > step) jumped = true;
+        }
+
+        if (!jumped && (_active & mask) == 0) {
+            for (uint16_t m = mask; m != 0; m &= (uint16_t)(m - 1)) {
+                uint8_t ch = (uint8_t)__builtin_ctz(m);
+                if (targets[ch] != _joints[ch].target) snap(ch, targets[ch]);
+            }
+            return true;
+        }
+
+        for (uint16_t m = mask; m != 0; m &= (uint16_t)(m - 1)) {
+            uint8_t ch = (uint8_t)__builtin_ctz(m);
+            if (targets[ch] != _joints[ch].target) moveTo(ch, targets[ch], nowMs, durationMs);
+        }
+        return false;
+    }
+
+    // 動いている関節を進めて positions に書く。戻り値: この tick で角度が変わった関節
+    uint16_t update(uint32_t nowMs, float* positions) {
+        uint16_t changed = _pending;
+        _pending = 0;
+        for (uint16_t mask = _active; mask != 0; mask &= (uint16_t)(mask - 1)) {
+            uint8_t ch = (uint8_t)__builtin_ctz(mask);
+            Joint_t& j = _joints[ch];
+            uint32_t elapsed = nowMs - j.startMs;
+            if (elapsed >= j.durationMs) {
+                j.position = j.target;
+                _active &= (uint16_t)~(1u << ch);
+            } else {
+                j.position = evaluate(j, elapsed * j.invDuration, nullptr);
+            }
+            changed |= (uint16_t)(1u << ch);
+        }
+        for (uint16_t mask = changed; mask != 0; mask &= (uint16_t)(mask - 1)) {
+            uint8_t ch = (uint8_t)__builtin_ctz(mask);
+            positions[ch] = _joints[ch].position;
+        }
+        return changed;
+    }
+
+    float position(uint8_t ch) const { return _joints[ch].position; }
+    float target(uint8_t ch) const { return _joints[ch].target; }
+    bool moving(uint8_t ch) const { return (_active >> ch) & 1u; }
+    uint16_t activeMask() const { return _active; }
+    const TrajStats_t& stats() const { return _stats; }
+
+    // 今の速度（度/秒）
+    float velocity(uint8_t ch, uint32_t nowMs) const {
+        const Joint_t& j = _joints[ch];
+        if (!((_active >> ch) & 1u)) return 0.0f;
+        uint32_t elapsed = nowMs - j.startMs;
+        if (elapsed >= j.durationMs) return 0.0f;
+        float rate;
+        evaluate(j, elapsed * j.invDuration, &rate);
+        return rate * j.invDuration * 1000.0f;
+    }
+
+private:
+    typedef struct {
+        TrajLimits_t limits;
+        float from;             // 移動を始めた位置
+        float delta;            // 目標 - from
+        float v0;               // 始めたときの速度 × 移動時間（度）
+        float target;
+        float position;
+        float invDuration;      // 1 / durationMs
+        uint32_t startMs;
+        uint32_t durationMs;
+    } Joint_t;
+
+    void moveWithin(uint8_t ch, float target, uint32_t nowMs, uint32_t durationMs, float speedScale) {
+        if (ch >= TRAJ_CHANNELS) return;
+        Joint_t& j = _joints[ch];
+        if (target == j.target && ((_active >> ch) & 1u)) return;   // 同じ目標へ移動中
+
+        // 途中なら今の位置・速度から
+        float start = j.position;
+        float velocity = 0.0f;
+        if ((_active >> ch) & 1u) {
+            uint32_t elapsed = nowMs - j.startMs;
+            if (elapsed < j.durationMs) {
+                float rate;
+                start = evaluate(j, elapsed * j.invDuration, &rate);
+                velocity = rate * j.invDuration;        // 度/ms
+                _stats.retargets++;
+            }
+        }
+
+        float distance = fabsf(target - start);
+        if (distance < 0.01f) {
+            j.position = j.target = target;
+            _active &= (uint16_t)~(1u << ch);
+            _pending |= (uint16_t)(1u << ch);
+            return;
+        }
+
+        // 上限を守れる最短時間（初速がある場合は目安）
+        float maxVel = j.limits.maxVel * speedScale * 0.001f;                   // 度/ms
+        float maxAcc = j.limits.maxAcc * speedScale * speedScale * 0.000001f;   // 度/ms²
+        float minMs = fmaxf(TRAJ_PEAK_VEL * distance / maxVel, sqrtf(TRAJ_PEAK_ACC * distance / maxAcc));
+        uint32_t minDuration = (uint32_t)ceilf(minMs);
+        if (minDuration < 1) minDuration = 1;
+        if (durationMs < minDuration) {
+            if (durationMs != 0) _stats.stretched++;
+            durationMs = minDuration;
+        }
+
+        j.from = start;
+        j.delta = target - start;
+        j.v0 = velocity * durationMs;
+        j.target = target;
+        j.startMs = nowMs;
+        j.durationMs = durationMs;
+        j.invDuration = 1.0f / durationMs;
+        _active |= (uint16_t)(1u << ch);
+        _stats.moves++;
+    }
+
+    // 初速つきの 5 次式（終点で速度・加速度 0）。s = 0..1、rate: ds あたりの変化
+    static float evaluate(const Joint_t& j, float s, float* rate) {
+        float d = j.delta, v = j.v0;
+        float c3 = 10.0f * d - 6.0f * v;
+        float c4 = -15.0f * d + 8.0f * v;
+        float c5 = 6.0f * d - 3.0f * v;
+        float s2 = s * s;
+        if (rate) *rate = v + s2 * (3.0f * c3 + s * (4.0f * c4 + s * 5.0f * c5));
+        return j.from + s * (v + s2 * (c3 + s * (c4 + s * c5)));
+    }
+
+    Joint_t _joints[TRAJ_CHANNELS];
+    uint16_t _active = 0;       // 動いている関節
+    uint16_t _pending = 0;      // snap() などで次の update() に書く関節
+    TrajStats_t _stats;
+};
+
+#endif // COROSUKE_TRAJECTORY_H
@@ -0,0 +1,170 @@
+/**
+ * コロ助ロボット - 声の区間の検出（VAD）
+ * Corosuke Robot - Energy / Zero-Crossing Voice Activity Detector
+ *
+ * マイクの PCM を MIC_FRAME_MS ごとに受け取り、平均二乗（エネルギー）とゼロ交差率だけで
+ * 声らしいフレームを見分けて、発話の始まり・終わりを返す。1 サンプルに足し算と掛け算が
+ * 1 回ずつなので、黙っている間はほぼこれだけで済む（符号化や送信は声の区間だけ）。
+ *
+ * - 声らしい: 平均二乗が雑音の底の VAD_ENERGY_RATIO 倍（と VAD_MIN_RMS）以上で、
+ *   ゼロ交差率が VAD_ZCR_MAX_PERCENT 以下（サーッという雑音を除く）
+ * - 雑音の底は声でないフレームから追う（下がるのは速く、上がるのはゆっくり）
+ * - 声らしいフレームが VAD_ONSET_FRAMES 続いたら開始（ノックのような短い音を除く）。
+ *   開始までのフレームは呼び出し側が取っておいて、語頭として一緒に送る
+ * - VAD_HANGOVER_MS 声が途切れたら終了（文の途中の息継ぎでは切らない）
+ * - VAD_MAX_SEGMENT_MS 続いたら区切り、その音の大きさを雑音の底に取り込む
+ *   （換気扇のような続く音で区間が終わらなくならないように）
+ */
+
+#ifndef COROSUKE_VOICE_ACTIVITY_H
+#define COROSUKE_VOICE_ACTIVITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+
+#define VAD_HANGOVER_FRAMES     (VAD_HANGOVER_MS / MIC_FRAME_MS)
+#define VAD_MAX_SEGMENT_FRAMES  (VAD_MAX_SEGMENT_MS / MIC_FRAME_MS)
+#define VAD_FLOOR_FALL_SHIFT    3       // 雑音の底が下がる速さ（1/8 ずつ）
+#define VAD_FLOOR_RISE_SHIFT    6       // 上がる速さ（1/64 ずつ、20ms フレームで約 1.3 秒）
+
+typedef enum {
+    VAD_SILENCE = 0,        // 区間の外
+    VAD_START,              // このフレームで発話開始（前の VAD_ONSET_FRAMES - 1 フレームも声）
+    VAD_VOICE,              // 区間の中（途切れて終了を待っている間も含む）
+    VAD_END                 // このフレームで終了（このフレームは区間に含めない）
+} VadEvent_t;
+
+typedef struct {
+    uint32_t frames;            // process() の回数
+    uint32_t segmentFrames;     // 区間に入ったフレーム
+    uint32_t segments;          // 発話の区間
+    uint32_t rejected;          // 声らしかったが VAD_ONSET_FRAMES に届かなかった音
+    uint32_t longSegments;      // VAD_MAX_SEGMENT_MS で区切った区間
+} VadStats_t;
+
+class VoiceActivityDetector {
+public:
+    VoiceActivityDetector() { begin(); }
+
+    void begin() {
+        _floor = 0;
+        _floorValid = false;
+        _meanSquare = 0;
+        _zcrPercent = 0;
+        _last = 0;
+        _onset = 0;
+        _quiet = 0;
+        _segmentFrames = 0;
+        _active = false;
+        _endedByLength = false;
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    // 1 フレーム分の PCM
+    VadEvent_t process(const int16_t* pcm, size_t samples) {
+        _stats.frames++;
+        measure(pcm, samples);
+        bool voiced = _meanSquare >= threshold() && _zcrPercent <= VAD_ZCR_MAX_PERCENT;
+
+        if (!_active) {
+            if (voiced) {
+                if (++_onset < VAD_ONSET_FRAMES) return VAD_SILENCE;
+                _active = true;
+                _onset = 0;
+                _quiet = 0;
+                _segmentFrames = VAD_ONSET_FRAMES;
+                _stats.segments++;
+                _stats.segmentFrames += VAD_ONSET_FRAMES;
+                return VAD_START;
+            }
+            if (_onset != 0) {
+                _stats.rejected++;
+                _onset = 0;
+            }
+            adaptFloor();
+            return VAD_SILENCE;
+        }
+
+        _quiet = voiced ? 0 : _quiet + 1;
+        _endedByLength = _segmentFrames >= VAD_MAX_SEGMENT_FRAMES;
+        if (_quiet >= VAD_HANGOVER_FRAMES || _endedByLength) {
+            _active = false;
+            if (_endedByLength) {
+                _stats.longSegments++;
+                _floor = _meanSquare;
+            }
+            return VAD_END;
+        }
+        _segmentFrames++;
+        _stats.segmentFrames++;
+        return VAD_VOICE;
+    }
+
+    // 区間を打ち切る（スピーカーで話し始めたときなど）。戻り値: 区間の中だった
+    bool cancel() {
+        bool wasActive = _active;
+        _active = false;
+        _onset = 0;
+        _quiet = 0;
+        return wasActive;
+    }
+
+    bool active() const { return _active; }
+    // 直前の VAD_END が VAD_MAX_SEGMENT_MS で区切ったものか
+    bool endedByLength() const { return _endedByLength; }
+    uint32_t segmentFrames() const { return _segmentFrames; }
+    uint32_t meanSquare() const { return _meanSquare; }
+    uint32_t noiseFloor() const { return _floor; }
+    uint32_t zcrPercent() const { return _zcrPercent; }
+    const VadStats_t& stats() const { return _stats; }
+
+private:
+    void measure(const int16_t* pcm, size_t samples) {
+        uint64_t sum = 0;
+        uint32_t crossings = 0;
+        int32_t prev = _last;
+        for (size_t i = 0; i < samples; i++) {
+            int32_t s = pcm[i];
+            sum += (uint32_t)(s * s);
+            crossings += (s ^ prev) < 0;
+            prev = s;
+        }
+        _last = (int16_t)prev;
+        _meanSquare = samples ? (uint32_t)(sum / samples) : 0;
+        _zcrPercent = samples ? crossings * 100 / (uint32_t)samples : 0;
+    }
+
+    uint64_t threshold() const {
+        uint64_t t = (uint64_t)_floor * VAD_ENERGY_RATIO;
+        const uint64_t minimum = (uint64_t)VAD_MIN_RMS * VAD_MIN_RMS;
+        return t > minimum ? t : minimum;
+    }
+
+    void adaptFloor() {
+        if (!_floorValid) {
+            _floor = _meanSquare;
+            _floorValid = true;
+        } else if (_meanSquare < _floor) {
+            _floor -= (_floor - _meanSquare) >> VAD_FLOOR_FALL_SHIFT;
+        } else {
+            _floor += (_meanSquare - _floor) >> VAD_FLOOR_RISE_SHIFT;
+        }
+    }
+
+    uint32_t _floor;            // 雑音の底（平均二乗）
+    bool _floorValid;
+    uint32_t _meanSquare;       // 直前のフレーム
+    uint32_t _zcrPercent;
+    int16_t _last;              // ゼロ交差をフレームの境目でも数える
+    uint8_t _onset;             // 続いた声らしいフレーム（開始前）
+    uint16_t _quiet;            // 続いた声らしくないフレーム（区間の中）
+    uint32_t _segmentFrames;
+    bool _active;
+    bool _endedByLength;
+    VadStats_t _stats;
+};
+
+#endif // COROSUKE_VOICE_ACTIVITY_H
@@ -5,19 +5,36 @@
  * 機能:
  * - 腰の制御（1軸）
  * - 脚の制御（8軸: 股関節・膝・足首 x2）
- * - IMUによるバランス制御
+ * - IMUによるバランス制御（BNO055 / MPU6050 の生値を Mahony フィルタで姿勢に）
  * - 二足歩行パターン生成
+ *
+ * IMU・バランス・歩行・サーボ出力は core 0 にピン留めした制御タスクが
+ * 一定周期で回し、loop()（core 1）は UART 受信とログだけを受け持つ。
+ * 受信したコマンドはロックフリーの SPSC キューで制御タスクへ渡す。
  */
 
 #include <Arduino.h>
 #include <Wire.h>
 #include <Adafruit_PWMServoDriver.h>
-#include <Adafruit_BNO055.h>
-#include <Adafruit_Sensor.h>
 
 // 共通ヘッダー
 #include "../../common/config.h"
 #include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+#include "../../common/reliable_link.h"
+#include "../../common/link_speed.h"
+#include "../../common/servo_frame.h"
+#include "../../common/servo_output.h"
+#include "../../common/joint_table.h"
+#include "../../common/gait_engine.h"
+#include "../../common/foot_planner.h"
+#include "../../common/trajectory.h"
+#include "../../common/spsc_queue.h"
+#include "../../common/imu_sensor.h"
+#include "../../common/imu_fusion.h"
+#include "../../common/balance_controller.h"
+#include "../../common/trace.h"
+#include "../../common/scheduler.h"
 
 // =============================================================================
 // グローバル変数
@@ -26,36 +43,108 @@
 // サーボドライバ
 Adafruit_PWMServoDriver pwm = Adafruit_PWMServoDriver(I2C_ADDR_PCA9685_LOWER);
 
-// IMU
-Adafruit_BNO055 bno = Adafruit_BNO055(55, I2C_ADDR_BNO055);
+// サーボ出力（変化したチャンネルを tick ごとにまとめて書く）
+ServoOutput servoOut(I2C_ADDR_PCA9685_LOWER);
+
+// IMU（生値の読み出しと姿勢推定。どちらも制御タスクだけが触る）
+ImuSensor imuSensor;
+ImuFusion imuFusion;
+int32_t imuAccelMg[3] = {0, 0, IMU_ONE_G_MG};   // 直近の加速度
 
-// サーボ現在位置・目標位置
+// サーボ現在位置・目標位置（目標が変わったら servoTrajectory が時間をかけて現在位置を動かす）
 float servoCurrentPos[16];
 float servoTargetPos[16];
+TrajectoryPlanner servoTrajectory;
 
 // 歩行状態
 WalkMode_t walkMode = WALK_STOP;
 uint8_t walkSpeed = 50;
-float walkPhase = 0.0f;
 bool isWalking = false;
+bool gaitFollowing = false;  // 脚が歩容の目標をそのまま出している（サーボ tick で更新）
+
+// 歩行エンジン（位相と、CMD_GAIT_TABLE で書き換えた歩容テーブル）
+GaitEngine gait;
+
+// 足先軌道 + 逆運動学（通常の歩容）
+FootPlanner footPlanner;
 
 // バランス制御
 float pitchAngle = 0.0f;
 float rollAngle = 0.0f;
 float yawAngle = 0.0f;
 
-// PID制御用
-float pitchError = 0.0f, pitchErrorSum = 0.0f, pitchErrorPrev = 0.0f;
-float rollError = 0.0f, rollErrorSum = 0.0f, rollErrorPrev = 0.0f;
-
-// タイミング
-unsigned long lastServoUpdate = 0;
-unsigned long lastIMUUpdate = 0;
-unsigned long lastWalkUpdate = 0;
-
-// UART受信バッファ
-uint8_t uartBuffer[PACKET_MAX_SIZE];
-uint8_t uartIndex = 0;
+// PID制御用（補正は servoTargetPos に書き込まず、出力するときに足す）
+BalanceController balance;
+float balanceOffset[16];
+uint32_t lastBalanceUs = 0;
+
+// loop() の周期ジョブ（優先度は大きいほど先。IMU・サーボは制御タスクが vTaskDelayUntil で回す）
+#define JOB_PRIORITY_UART       3
+#define JOB_PRIORITY_SENSOR     2
+#define JOB_PRIORITY_REPORT     0
+#define GAIT_NOTICE_MS          100
+Scheduler scheduler;
+
+// UART受信パーサー
+PacketParser uartParser;
+unsigned long lastUartRx = 0;
+
+// 上半身からの確実に届けるコマンドを順番どおりに受け取り、ACK/NACK を返す
+// （こちらから送るのはセンサーデータと応答だけで、どれも送りっぱなし）
+ReliableLink upperLink;
+
+// 上半身とのボーレート交渉（上半身が始め、こちらは答える）
+LinkSpeed upperSpeed;
+uint32_t upperTxBytes = 0;      // 交渉以外で上半身へ送ったバイト数
+
+// サーボフレーム（次のサーボ更新でまとめて適用）
+ServoFrameReceiver servoFrame(BODY_LOWER);
+
+// =============================================================================
+// 制御タスク
+// =============================================================================
+#define CONTROL_PERIOD_MS        IMU_UPDATE_INTERVAL_MS     // 制御周期 (100Hz)
+#define CONTROL_SERVO_DIVIDER    (SERVO_UPDATE_INTERVAL_MS / CONTROL_PERIOD_MS)
+#define CONTROL_SENSOR_DIVIDER   (SENSOR_REPORT_INTERVAL_MS / CONTROL_PERIOD_MS)
+#define CONTROL_TASK_CORE        0                          // loop() は core 1
+#define CONTROL_TASK_PRIORITY    (configMAX_PRIORITIES - 2)
+#define CONTROL_TASK_STACK       4096
+#define CONTROL_QUEUE_DEPTH      16
+#define SENSOR_QUEUE_DEPTH       4
+
+// 制御タスクへ渡すコマンド（UARTパケットのデータ部をコピーしたもの）
+typedef struct {
+    uint8_t cmd;
+    uint8_t length;
+    uint8_t data[PACKET_MAX_SIZE - 5];
+} ControlCommand_t;
+
+// 制御周期の計測値（制御タスクが書き、loop() が読んで報告する）
+typedef struct {
+    uint32_t cycles;            // 実行した周期数
+    uint32_t deadlineMisses;    // 次の周期の開始予定までに終わらなかった回数
+    uint32_t lastJitterUs;      // 開始予定時刻からのずれ
+    uint32_t maxJitterUs;
+    uint64_t totalJitterUs;
+    uint32_t lastExecUs;        // 1周期の処理時間
+    uint32_t maxExecUs;
+    uint32_t commands;          // 適用したコマンド数
+    uint32_t unknownCommands;
+    uint32_t gaitTableUpdates;  // 差し替えた歩容テーブル数
+} ControlStats_t;
+
+SpscQueue<ControlCommand_t, CONTROL_QUEUE_DEPTH> controlQueue;
+ControlStats_t controlStats;
+uint32_t controlQueueOverflows = 0;     // loop() 側だけが更新
+
+// 上半身経由でメインへ送る IMU データ（制御タスクが書き、loop() が送る）
+SpscQueue<ImuData_t, SENSOR_QUEUE_DEPTH> sensorQueue;
+uint32_t sensorQueueOverflows = 0;      // 制御タスク側だけが更新
+uint32_t reportedGaitTableUpdates = 0;
+TaskHandle_t controlTaskHandle = nullptr;
+
+// 処理時間の計測（loop() と UART は loop()、それ以外は制御タスクが書く）
+Tracer tracer;
 
 // =============================================================================
 // 歩行パラメータ
@@ -64,22 +153,51 @@ uint8_t uartIndex = 0;
 #define WALK_STEP_LENGTH     15.0f   // 歩幅（度）
 #define WALK_SWAY_AMOUNT     10.0f   // 左右の揺れ（度）
 #define WALK_CYCLE_SPEED     0.005f  // 歩行サイクル速度
+#define WALK_TURN_YAW        10.0f   // 旋回時の股関節ヨー（度）
+
+// 足先軌道（FootPlanner、mm）
+#define WALK_HIP_HEIGHT_MM   140.0f  // 歩行中の股関節の高さ（伸ばしきると 142.5、足首が 60〜120 度に収まる浅さ）
+#define WALK_STRIDE_MM       30.0f   // 1歩で足が前後に動く距離
+#define WALK_LIFT_MM         10.0f   // 足を上げる高さ
+#define WALK_DUTY            0.6f    // 支持脚の割合（0.5 を超えた分が両脚支持）
+#define WALK_WAIST_SWAY      (WALK_SWAY_AMOUNT * 0.3f)
+
+// 速度100のときの1 tick (10ms) あたりの位相増分（1周 = 2^32）
+#define WALK_PHASE_STEP      ((uint32_t)(WALK_CYCLE_SPEED * 4294967296.0))
 
 // =============================================================================
 // 関数プロトタイプ
 // =============================================================================
 void initServos();
 void initIMU();
-void setServoAngle(uint8_t channel, float angle);
+void writeServo(uint8_t channel, float angle);
 void updateServos();
 void updateIMU();
+void publishIMU();
+void sendSensorData();
 void updateBalance();
 void updateWalking();
 void generateGait();
-void processCommand(uint8_t cmd, uint8_t* data, uint8_t length);
+void processCommand(uint8_t cmd, const uint8_t* data, uint8_t length);
+void applyCommand(const ControlCommand_t& command);
+void controlTask(void* parameter);
+void controlStep(uint32_t cycle);
 void handleUART();
+void dispatchPacket(const PacketView_t& packet, unsigned long now);
+void sendStatus();
+void sendTraceStatus();
+void reportUpperLink();
+void reportServoBus();
+void reportControlTiming();
+void reportIMU();
+void reportBalance();
+void jobUART();
+void jobSensorData();
+void jobGaitNotice();
+void jobReport();
 void standUp();
 void sitDown();
+void moveToPose();
 
 // =============================================================================
 // セットアップ
@@ -91,9 +209,14 @@ void setup() {
     Serial.println("  コロ助 下半身コントローラー");
     Serial.println("  Corosuke Lower Body v1.0");
     Serial.println("=================================");
+    tracer.begin(TRACE_BOARD_LOWER);
 
-    // 上半身ボードとのUART
+    // 上半身ボードとのUART（ボーレートは上半身からの交渉で上がる）
+    Serial2.setRxBufferSize(UART_RX_BUFFER_SIZE);
+    Serial2.setTxBufferSize(UART_TX_BUFFER_SIZE);
     Serial2.begin(UART_BAUD_RATE, SERIAL_8N1, UART_UPPER_TO_LOWER_RX, UART_UPPER_TO_LOWER_TX);
+    upperLink.reset((uint8_t)esp_random());
+    upperSpeed.begin(false, UART_BAUD_RATE, UART_LOWER_BAUD_MAX, millis());
 
     // I2C初期化
     Wire.begin();
@@ -101,43 +224,145 @@ void setup() {
     // サーボ初期化
     initServos();
 
+    // 歩容テーブル生成
+    GaitParams_t gaitParams = {WALK_STEP_HEIGHT, WALK_STEP_LENGTH, WALK_SWAY_AMOUNT, WALK_TURN_YAW};
+    gait.begin(gaitParams);
+    FootPlanParams_t footParams = {WALK_HIP_HEIGHT_MM, WALK_STRIDE_MM, WALK_LIFT_MM, WALK_DUTY,
+                                   WALK_TURN_YAW, WALK_WAIST_SWAY};
+    footPlanner.begin(footParams);
+
     // IMU初期化
     initIMU();
 
     // 初期姿勢（直立）
     standUp();
+    Serial.println("直立ナリ！");
+
+    // 制御タスク開始（ここから先の制御状態は制御タスクだけが触る）
+    memset(&controlStats, 0, sizeof(controlStats));
+    if (xTaskCreatePinnedToCore(controlTask, "control", CONTROL_TASK_STACK, nullptr,
+                                CONTROL_TASK_PRIORITY, &controlTaskHandle, CONTROL_TASK_CORE) != pdPASS) {
+        Serial.println("制御タスクを起動できないナリ！");
+    }
 
     Serial.println("初期化完了ナリ！");
+
+    // 周期ジョブ（IMU データは制御タスクが SENSOR_REPORT_INTERVAL_MS ごとにキューへ入れる）
+    scheduler.begin();
+    scheduler.add("uart", jobUART, UART_POLL_MS * 1000UL, JOB_PRIORITY_UART, UART_POLL_DEADLINE_MS * 1000UL);
+    scheduler.add("sensor", jobSensorData, CONTROL_PERIOD_MS * 1000UL, JOB_PRIORITY_SENSOR);
+    scheduler.add("gait_notice", jobGaitNotice, GAIT_NOTICE_MS * 1000UL, JOB_PRIORITY_REPORT);
+    scheduler.add("report", jobReport, SERVO_BUS_REPORT_MS * 1000UL, JOB_PRIORITY_REPORT, 0,
+                  SERVO_BUS_REPORT_MS * 1000UL);
 }
 
 // =============================================================================
 // メインループ
 // =============================================================================
 void loop() {
-    unsigned long now = millis();
+    {
+        TraceScope trace(tracer, TRACE_LOOP);
+        scheduler.runDue();
+    }
+    scheduler.sleepUntilDue();
+}
 
-    // UART受信処理
+// UART受信処理（コマンドは制御タスクへ）
+void jobUART() {
+    TraceScope trace(tracer, TRACE_UART);
     handleUART();
+}
 
-    // IMU更新 (100Hz)
-    if (now - lastIMUUpdate >= IMU_UPDATE_INTERVAL_MS) {
-        lastIMUUpdate = now;
-        updateIMU();
+// IMU データを上半身へ（上半身がメインへ中継する）
+void jobSensorData() {
+    sendSensorData();
+}
 
-        if (isWalking) {
-            updateBalance();
+void jobGaitNotice() {
+    if (controlStats.gaitTableUpdates != reportedGaitTableUpdates) {
+        reportedGaitTableUpdates = controlStats.gaitTableUpdates;
+        Serial.println("歩容テーブル更新ナリ！");
+    }
+}
+
+// サーボI2Cバス時間・制御周期の報告
+void jobReport() {
+    reportServoBus();
+    reportControlTiming();
+    reportIMU();
+    reportBalance();
+    traceReport(tracer);
+    reportUpperLink();
+    schedulerReport(scheduler);
+}
+
+// =============================================================================
+// 制御タスク（core 0、CONTROL_PERIOD_MS 周期）
+// =============================================================================
+void controlTask(void* parameter) {
+    (void)parameter;
+    const uint32_t periodUs = CONTROL_PERIOD_MS * 1000;
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t expectedUs = 0;
+
+    for (uint32_t cycle = 0;; cycle++) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+
+        uint32_t startUs = micros();
+        if (cycle == 0) expectedUs = startUs;
+        uint32_t jitterUs = (uint32_t)abs((int32_t)(startUs - expectedUs));
+
+        controlStep(cycle);
+
+        uint32_t execUs = micros() - startUs;
+        controlStats.cycles++;
+        controlStats.lastJitterUs = jitterUs;
+        controlStats.totalJitterUs += jitterUs;
+        if (jitterUs > controlStats.maxJitterUs) controlStats.maxJitterUs = jitterUs;
+        controlStats.lastExecUs = execUs;
+        if (execUs > controlStats.maxExecUs) controlStats.maxExecUs = execUs;
+
+        // 次の周期の開始予定を過ぎたら取りこぼし。遅れは持ち越さず今の周期に合わせ直す
+        if (jitterUs + execUs > periodUs) {
+            controlStats.deadlineMisses++;
+            expectedUs = startUs + periodUs;
+        } else {
+            expectedUs += periodUs;
         }
     }
+}
+
+void controlStep(uint32_t cycle) {
+    TraceScope controlTrace(tracer, TRACE_CONTROL);
+
+    // 前の周期以降に届いたコマンドを適用
+    ControlCommand_t command;
+    while (controlQueue.pop(&command)) {
+        applyCommand(command);
+    }
+
+    // IMU更新 (100Hz)
+    {
+        TraceScope trace(tracer, TRACE_IMU);
+        updateIMU();
+    }
+    {
+        TraceScope trace(tracer, TRACE_BALANCE);
+        updateBalance();
+    }
+    if (cycle % CONTROL_SENSOR_DIVIDER == 0) {
+        publishIMU();
+    }
 
     // 歩行更新
-    if (isWalking && now - lastWalkUpdate >= 10) {
-        lastWalkUpdate = now;
+    if (isWalking) {
+        TraceScope trace(tracer, TRACE_GAIT);
         updateWalking();
     }
 
     // サーボ更新 (50Hz)
-    if (now - lastServoUpdate >= SERVO_UPDATE_INTERVAL_MS) {
-        lastServoUpdate = now;
+    if (cycle % CONTROL_SERVO_DIVIDER == 0) {
+        TraceScope trace(tracer, TRACE_SERVO_TICK);
         updateServos();
     }
 }
@@ -147,7 +372,11 @@ void loop() {
 // =============================================================================
 void initServos() {
     pwm.begin();
-    pwm.setPWMFreq(50);
+    pwm.setOscillatorFrequency(PCA9685_OSC_HZ);
+    pwm.setPWMFreq(SERVO_PWM_HZ);
+    if (!servoOut.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_CLOCK_LOWER_HZ)) {
+        Serial.println("PCA9685が応答しないナリ！");
+    }
 
     delay(10);
 
@@ -155,6 +384,8 @@ void initServos() {
     for (int i = 0; i < 16; i++) {
         servoCurrentPos[i] = SERVO_CENTER_ANGLE;
         servoTargetPos[i] = SERVO_CENTER_ANGLE;
+        servoTrajectory.setLimits(i, TRAJ_LEG_MAX_VEL, TRAJ_LEG_MAX_ACC);
+        servoTrajectory.snap(i, SERVO_CENTER_ANGLE);
     }
 
     Serial.println("サーボ初期化完了");
@@ -164,92 +395,125 @@ void initServos() {
 // IMU初期化
 // =============================================================================
 void initIMU() {
-    if (!bno.begin()) {
+    if (!imuSensor.begin()) {
+        Serial.println("IMUが見つからないナリ！（BNO055 も MPU6050 も応答なし）");
+        return;
+    }
+    if (imuSensor.type() == IMU_SENSOR_MPU6050) {
         Serial.println("BNO055が見つからないナリ！MPU6050にフォールバック...");
-        // TODO: MPU6050フォールバック実装
-    } else {
-        Serial.println("BNO055初期化完了");
-        bno.setExtCrystalUse(true);
     }
+    Serial.printf("%s初期化完了\n", imuSensor.name());
 }
 
 // =============================================================================
-// サーボ角度設定（即座に適用）
+// サーボ出力（次の flush() で書き込む）
 // =============================================================================
-void setServoAngle(uint8_t channel, float angle) {
+void writeServo(uint8_t channel, float angle) {
     if (channel >= 16) return;
 
-    angle = constrain(angle, 0, 180);
-
-    uint16_t pulse = map((int)angle, 0, 180, SERVO_MIN_PULSE, SERVO_MAX_PULSE);
-    uint16_t pwmValue = (uint16_t)((pulse * 4096L) / 20000L);
-
-    pwm.setPWM(channel, 0, pwmValue);
-    servoCurrentPos[channel] = angle;
+    // 可動範囲（足首は 60〜120 度）への丸めとカウントへの変換は関節テーブルで
+    servoOut.set(channel, jointTicks(LOWER_JOINTS[channel], jointAngleQ(angle)));
 }
 
 // =============================================================================
-// サーボ位置更新（スムーズ補間）
+// サーボ位置更新（目標が変わった関節を最小躍度で動かす、歩行中の脚は歩容のまま）
 // =============================================================================
 void updateServos() {
-    for (int i = 0; i < 16; i++) {
-        if (abs(servoCurrentPos[i] - servoTargetPos[i]) > 0.5f) {
-            // 線形補間
-            float diff = servoTargetPos[i] - servoCurrentPos[i];
-            float step = diff * 0.2f;  // 20%ずつ近づく
+    uint32_t now = millis();
+
+    // 受信済みのサーボフレームを全チャンネル同時に目標へ反映
+    ServoPose_t pose;
+    if (servoFrame.take(&pose)) {
+        for (uint8_t ch = 0; ch < SERVO_FRAME_CHANNELS; ch++) {
+            if (pose.mask & (1u << ch)) {
+                servoTargetPos[ch] = pose.angles[ch];
+                if (pose.flags & SERVO_FRAME_FLAG_SNAP) {
+                    servoTrajectory.snap(ch, pose.angles[ch]);
+                }
+            }
+        }
+    }
 
-            servoCurrentPos[i] += step;
-            setServoAngle(i, servoCurrentPos[i]);
+    // 歩行中の脚は歩容の目標を全関節まとめてそのまま出す（関節ごとに軌道を引くと
+    // 遅れ方が関節ごとに違い、着いている足が傾く）。飛んだときだけ同じ時間で移る
+    uint8_t first = 0;
+    if (isWalking) {
+        gaitFollowing = servoTrajectory.follow(GAIT_JOINT_MASK, servoTargetPos, now,
+                                               SERVO_UPDATE_INTERVAL_MS, GAIT_ENGAGE_MS);
+        first = GAIT_JOINTS;
+    } else {
+        gaitFollowing = false;
+    }
+
+    // 残りは目標が変わった関節だけ軌道を引き直す
+    for (uint8_t ch = first; ch < 16; ch++) {
+        if (servoTargetPos[ch] != servoTrajectory.target(ch)) {
+            servoTrajectory.moveTo(ch, servoTargetPos[ch], now);
         }
     }
+    servoTrajectory.update(now, servoCurrentPos);
+
+    // バランス補正を足して出す（同じ値なら I2C には書かない）
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        writeServo(ch, servoCurrentPos[ch] + balanceOffset[ch]);
+    }
+
+    // 変化したチャンネルをまとめて書き込む
+    TraceScope trace(tracer, TRACE_SERVO_WRITE);
+    servoOut.flush();
 }
 
 // =============================================================================
 // IMU更新
 // =============================================================================
 void updateIMU() {
-    sensors_event_t event;
-    bno.getEvent(&event);
+    // 前の周期から溜まったサンプルを全部フィルタに通す（MPU6050 は 333Hz で 3〜4 個）
+    ImuSample_t samples[IMU_SENSOR_BURST_MAX];
+    size_t count = imuSensor.read(samples, IMU_SENSOR_BURST_MAX);
+    if (count == 0) return;
+    for (size_t i = 0; i < count; i++) {
+        imuFusion.update(samples[i]);
+    }
+    memcpy(imuAccelMg, samples[count - 1].accel, sizeof(imuAccelMg));
 
-    // オイラー角取得
-    pitchAngle = event.orientation.y;
-    rollAngle = event.orientation.z;
-    yawAngle = event.orientation.x;
+    pitchAngle = imuFusion.pitchDeg();
+    rollAngle = imuFusion.rollDeg();
+    yawAngle = imuFusion.yawDeg();
+}
+
+// 姿勢と加速度を loop() へ渡す（送信は loop() 側で、制御周期を UART で待たせない）
+void publishIMU() {
+    ImuData_t data;
+    data.pitch = (int16_t)(pitchAngle * 100.0f);
+    data.roll = (int16_t)(rollAngle * 100.0f);
+    data.yaw = (int16_t)(yawAngle * 100.0f);
+    // mg → 0.01 m/s²
+    data.accel_x = (int16_t)(imuAccelMg[0] * 9807 / 10000);
+    data.accel_y = (int16_t)(imuAccelMg[1] * 9807 / 10000);
+    data.accel_z = (int16_t)(imuAccelMg[2] * 9807 / 10000);
+    if (!sensorQueue.push(data)) {
+        sensorQueueOverflows++;
+    }
 }
 
 // =============================================================================
 // バランス制御（PID）
 // =============================================================================
 void updateBalance() {
-    // ピッチ制御（前後）
-    pitchError = 0.0f - pitchAngle;
-    pitchErrorSum += pitchError;
-    pitchErrorSum = constrain(pitchErrorSum, -100.0f, 100.0f);
-    float pitchD = pitchError - pitchErrorPrev;
-    pitchErrorPrev = pitchError;
-
-    float pitchCorrection = BALANCE_KP * pitchError +
-                            BALANCE_KI * pitchErrorSum +
-                            BALANCE_KD * pitchD;
-
-    // ロール制御（左右）
-    rollError = 0.0f - rollAngle;
-    rollErrorSum += rollError;
-    rollErrorSum = constrain(rollErrorSum, -100.0f, 100.0f);
-    float rollD = rollError - rollErrorPrev;
-    rollErrorPrev = rollError;
-
-    float rollCorrection = BALANCE_KP * rollError +
-                           BALANCE_KI * rollErrorSum +
-                           BALANCE_KD * rollD;
-
-    // 足首に補正を適用
-    servoTargetPos[SERVO_LEG_RIGHT_ANKLE] += pitchCorrection * 0.5f;
-    servoTargetPos[SERVO_LEG_LEFT_ANKLE] += pitchCorrection * 0.5f;
+    uint32_t now = micros();
+    uint32_t dtUs = now - lastBalanceUs;
+    lastBalanceUs = now;
+
+    if (!isWalking) {
+        // 止まっている間は積分を持ち越さず、補正も外す
+        balance.reset();
+        memset(balanceOffset, 0, sizeof(balanceOffset));
+        return;
+    }
 
-    // 制限をかける
-    servoTargetPos[SERVO_LEG_RIGHT_ANKLE] = constrain(servoTargetPos[SERVO_LEG_RIGHT_ANKLE], 60, 120);
-    servoTargetPos[SERVO_LEG_LEFT_ANKLE] = constrain(servoTargetPos[SERVO_LEG_LEFT_ANKLE], 60, 120);
+    // 実際の経過時間で積分・微分する（制御周期がずれてもゲインは同じ意味）
+    balance.update(pitchAngle, rollAngle, dtUs);
+    balance.offsets(balanceOffset);
 }
 
 // =============================================================================
@@ -262,65 +526,24 @@ void updateWalking() {
         return;
     }
 
-    // 歩行フェーズを進める
-    float speedFactor = walkSpeed / 100.0f;
-    walkPhase += WALK_CYCLE_SPEED * speedFactor;
-    if (walkPhase >= 1.0f) {
-        walkPhase -= 1.0f;
+    // 歩行フェーズを進める（1周で自然に桁あふれする）。脚が歩容の姿勢へ移っている間は
+    // 止めておく（歩き出しは位相 0 の姿勢に着いてから）
+    if (gaitFollowing) {
+        gait.advance(walkSpeed, WALK_PHASE_STEP);
     }
 
     generateGait();
 }
 
 // =============================================================================
-// 歩行パターン生成（簡易ペンギン歩き）
+// 歩行パターン生成（足先軌道 + 逆運動学、書き換えた歩容テーブルはそちらを優先）
 // =============================================================================
 void generateGait() {
-    float phase = walkPhase * 2.0f * PI;
-
-    // 左右の足の位相差は180度
-    float rightPhase = phase;
-    float leftPhase = phase + PI;
-
-    // 足を上げる動作（サイン波）
-    float rightLift = max(0.0f, sin(rightPhase)) * WALK_STEP_HEIGHT;
-    float leftLift = max(0.0f, sin(leftPhase)) * WALK_STEP_HEIGHT;
-
-    // 前後の動作（コサイン波）
-    float rightSwing = cos(rightPhase) * WALK_STEP_LENGTH;
-    float leftSwing = cos(leftPhase) * WALK_STEP_LENGTH;
-
-    // 体の左右の揺れ（重心移動）
-    float bodySway = sin(phase) * WALK_SWAY_AMOUNT;
-
-    // 方向に応じて調整
-    float directionFactor = 1.0f;
-    if (walkMode == WALK_BACKWARD) {
-        directionFactor = -1.0f;
-    }
-
-    // 右脚
-    servoTargetPos[SERVO_LEG_RIGHT_HIP_PITCH] = 90 + rightSwing * directionFactor;
-    servoTargetPos[SERVO_LEG_RIGHT_KNEE] = 90 + rightLift;
-    servoTargetPos[SERVO_LEG_RIGHT_ANKLE] = 90 - rightLift * 0.5f;
-    servoTargetPos[SERVO_LEG_RIGHT_HIP_YAW] = 90 + bodySway;
-
-    // 左脚
-    servoTargetPos[SERVO_LEG_LEFT_HIP_PITCH] = 90 + leftSwing * directionFactor;
-    servoTargetPos[SERVO_LEG_LEFT_KNEE] = 90 + leftLift;
-    servoTargetPos[SERVO_LEG_LEFT_ANKLE] = 90 - leftLift * 0.5f;
-    servoTargetPos[SERVO_LEG_LEFT_HIP_YAW] = 90 - bodySway;
-
-    // 腰は揺れに合わせて少し回転
-    servoTargetPos[SERVO_WAIST] = 90 + bodySway * 0.3f;
-
-    // 旋回の場合
-    if (walkMode == WALK_TURN_LEFT) {
-        servoTargetPos[SERVO_LEG_RIGHT_HIP_YAW] += 10;
-        servoTargetPos[SERVO_LEG_LEFT_HIP_YAW] += 10;
-    } else if (walkMode == WALK_TURN_RIGHT) {
-        servoTargetPos[SERVO_LEG_RIGHT_HIP_YAW] -= 10;
-        servoTargetPos[SERVO_LEG_LEFT_HIP_YAW] -= 10;
+    // サーバーから書き換えた歩容テーブルがあればそれを、なければ足先軌道から逆運動学で
+    if (gait.customized(walkMode, walkSpeed)) {
+        gait.evaluate(walkMode, walkSpeed, servoTargetPos);
+    } else {
+        footPlanner.evaluate(walkMode, walkSpeed, gait.phase(), servoTargetPos);
     }
 }
 
@@ -328,8 +551,6 @@ void generateGait() {
 // 直立姿勢
 // =============================================================================
 void standUp() {
-    Serial.println("直立ナリ！");
-
     servoTargetPos[SERVO_WAIST] = 90;
 
     // 右脚
@@ -343,89 +564,199 @@ void standUp() {
     servoTargetPos[SERVO_LEG_LEFT_HIP_PITCH] = 90;
     servoTargetPos[SERVO_LEG_LEFT_KNEE] = 90;
     servoTargetPos[SERVO_LEG_LEFT_ANKLE] = 90;
+
+    moveToPose();
 }
 
 // =============================================================================
 // 座る姿勢
 // =============================================================================
 void sitDown() {
-    Serial.println("座るナリ！");
-
     // 膝を曲げて座る
     servoTargetPos[SERVO_LEG_RIGHT_HIP_PITCH] = 45;
     servoTargetPos[SERVO_LEG_RIGHT_KNEE] = 45;
     servoTargetPos[SERVO_LEG_LEFT_HIP_PITCH] = 45;
     servoTargetPos[SERVO_LEG_LEFT_KNEE] = 45;
+
+    moveToPose();
+}
+
+// 直立・座るは歩容より時間をかけて移る
+void moveToPose() {
+    uint32_t now = millis();
+    for (uint8_t ch = 0; ch < GAIT_JOINTS; ch++) {
+        servoTrajectory.moveTo(ch, servoTargetPos[ch], now, POSE_MOVE_MS);
+    }
 }
 
 // =============================================================================
 // UART受信処理
 // =============================================================================
 void handleUART() {
-    while (Serial2.available()) {
-        uint8_t b = Serial2.read();
+    unsigned long now = millis();
+    if (uartParser.readFrom(Serial2) > 0) {
+        lastUartRx = now;
+    } else if (uartParser.buffered() > 0 && now - lastUartRx >= UART_IDLE_RESYNC_MS) {
+        // 受信が途切れたまま未完成のパケットが残っている → 再同期
+        uartParser.resyncIfStalled();
+    }
 
-        if (uartIndex == 0 && b != PACKET_START) {
-            continue;
-        }
+    // 確実に届けるコマンドは順番どおりに（抜けがあれば再送を待ってから）渡される
+    PacketView_t packet;
+    while (uartParser.next(&packet)) {
+        if (upperLink.receive(Serial2, packet, now)) dispatchPacket(packet, now);
+        while (upperLink.nextBuffered(&packet)) dispatchPacket(packet, now);
+    }
+    upperLink.poll(Serial2, now);
+    upperSpeed.poll(Serial2, now, uartParser.stats(), upperTxBytes + upperLink.stats().txBytes);
+}
 
-        uartBuffer[uartIndex++] = b;
+void dispatchPacket(const PacketView_t& packet, unsigned long now) {
+    // リンクのフレームは制御タスクへ渡さない
+    if (packet.cmd == CMD_LINK_SPEED) {
+        upperSpeed.receive(Serial2, packet, now);
+    } else if (packet.cmd == CMD_STATUS && packet.length >= 1 && packet.data[0] == STATUS_TRACE) {
+        sendTraceStatus();
+    } else if (packet.cmd == CMD_STATUS) {
+        sendStatus();
+    } else {
+        processCommand(packet.cmd, packet.data, packet.length);
+    }
+}
 
-        if (uartIndex >= 4) {
-            uint8_t expectedLen = uartBuffer[1] + 4;
-            if (uartIndex >= expectedLen) {
-                if (uartBuffer[uartIndex - 1] == PACKET_END) {
-                    if (validatePacket(uartBuffer, uartIndex)) {
-                        processCommand(uartBuffer[2], &uartBuffer[3], uartBuffer[1] - 1);
-                    }
-                }
-                uartIndex = 0;
-            }
-        }
+// センサーデータの送信（v2 の送りっぱなし。古い値は新しい値で置き換わるので再送しない）
+void sendSensorData() {
+    ImuData_t data;
+    while (sensorQueue.pop(&data)) {
+        uint8_t frame[PACKET_MAX_SIZE];
+        uint8_t length = buildPacketV2(frame, 0, 0, 0, CMD_IMU_DATA, (const uint8_t*)&data, sizeof(data));
+        Serial2.write(frame, length);
+        upperTxBytes += length;
+    }
+}
 
-        if (uartIndex >= PACKET_MAX_SIZE) {
-            uartIndex = 0;
-        }
+// CMD_STATUS への応答（このボードから見た上半身とのリンク）
+void sendStatus() {
+    uint8_t data[1 + sizeof(LinkStatusData_t)];
+    LinkStatusData_t status;
+    upperSpeed.fillStatus(&status, LINK_UPPER_LOWER);
+    data[0] = 1;
+    memcpy(&data[1], &status, sizeof(status));
+
+    uint8_t frame[PACKET_MAX_SIZE];
+    uint8_t length = buildPacketV2(frame, 0, 0, 0, CMD_STATUS_RESP, data, sizeof(data));
+    Serial2.write(frame, length);
+    upperTxBytes += length;
+}
+
+// STATUS_TRACE への応答（上半身がそのままメインへ中継する）
+void sendTraceStatus() {
+    for (uint8_t stage = 0; stage < TRACE_STAGES; stage++) {
+        TraceStatusData_t status;
+        if (!tracer.fillStatus((TraceStage_t)stage, &status)) continue;
+        uint8_t frame[PACKET_MAX_SIZE];
+        uint8_t length = buildPacketV2(frame, 0, 0, 0, CMD_STATUS_RESP, (const uint8_t*)&status, sizeof(status));
+        Serial2.write(frame, length);
+        upperTxBytes += length;
     }
 }
 
 // =============================================================================
-// コマンド処理
+// コマンド受信（loop() 側: ログを出して制御タスクへ渡す）
 // =============================================================================
-void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
+void processCommand(uint8_t cmd, const uint8_t* data, uint8_t length) {
     Serial.print("コマンド受信: 0x");
     Serial.println(cmd, HEX);
 
     switch (cmd) {
         case CMD_PING:
             Serial.println("PING受信");
-            break;
+            return;     // 制御状態は変えない
 
-        case CMD_WALK_START: {
+        case CMD_WALK_START:
             Serial.println("歩行開始ナリ！");
+            break;
+
+        case CMD_WALK_STOP:
+            Serial.println("歩行停止ナリ！");
+            Serial.println("直立ナリ！");
+            break;
+
+        case CMD_WALK_DIRECTION:
+            if (length >= sizeof(WalkData_t)) {
+                Serial.print("歩行モード: ");
+                Serial.println(((const WalkData_t*)data)->mode);
+            }
+            break;
+
+        case CMD_STAND:
+            Serial.println("直立ナリ！");
+            break;
+
+        case CMD_SIT:
+            Serial.println("座るナリ！");
+            break;
+
+        case CMD_GAIT_TABLE:
+        case CMD_SERVO_FRAME:
+        case CMD_SERVO_FRAME_DELTA:
+        case CMD_TURN:
+            break;
+
+        case CMD_BALANCE_GAINS:
+            if (length >= sizeof(BalanceGainsData_t)) {
+                const BalanceGainsData_t* gains = (const BalanceGainsData_t*)data;
+                Serial.printf("バランスゲイン: %s Kp %u Ki %u Kd %u (/1000) %s\n",
+                              gains->axis == BALANCE_AXIS_PITCH ? "ピッチ" : "ロール",
+                              gains->kp_milli, gains->ki_milli, gains->kd_milli,
+                              gains->enabled ? "有効" : "無効");
+            }
+            break;
+
+        default:
+            Serial.print("未知のコマンド: 0x");
+            Serial.println(cmd, HEX);
+            return;
+    }
+
+    ControlCommand_t command;
+    command.cmd = cmd;
+    command.length = length < sizeof(command.data) ? length : sizeof(command.data);
+    memcpy(command.data, data, command.length);
+    if (!controlQueue.push(command)) {
+        controlQueueOverflows++;
+        Serial.println("コマンドキュー満杯ナリ！");
+    }
+}
+
+// =============================================================================
+// コマンド適用（制御タスク側: 制御状態を変えるのはここだけ）
+// =============================================================================
+void applyCommand(const ControlCommand_t& command) {
+    const uint8_t* data = command.data;
+    uint8_t length = command.length;
+    controlStats.commands++;
+
+    switch (command.cmd) {
+        case CMD_WALK_START:
             isWalking = true;
             walkMode = WALK_FORWARD;
-            walkPhase = 0.0f;
+            gait.resetPhase();
             break;
-        }
 
         case CMD_WALK_STOP:
-            Serial.println("歩行停止ナリ！");
             walkMode = WALK_STOP;
             isWalking = false;
             standUp();
             break;
 
-        case CMD_WALK_DIRECTION: {
+        case CMD_WALK_DIRECTION:
             if (length >= sizeof(WalkData_t)) {
-                WalkData_t* walkData = (WalkData_t*)data;
+                const WalkData_t* walkData = (const WalkData_t*)data;
                 walkMode = (WalkMode_t)walkData->mode;
                 walkSpeed = walkData->speed;
-                Serial.print("歩行モード: ");
-                Serial.println(walkMode);
             }
             break;
-        }
 
         case CMD_STAND:
             isWalking = false;
@@ -437,7 +768,22 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
             sitDown();
             break;
 
-        case CMD_TURN: {
+        case CMD_GAIT_TABLE:
+            if (gait.loadChunk(data, length)) {
+                controlStats.gaitTableUpdates++;
+            }
+            break;
+
+        case CMD_SERVO_FRAME:
+        case CMD_SERVO_FRAME_DELTA:
+            servoFrame.receive(command.cmd, data, length);
+            break;
+
+        case CMD_BALANCE_GAINS:
+            balance.setGains(data, length);
+            break;
+
+        case CMD_TURN:
             if (length >= 1) {
                 int8_t direction = (int8_t)data[0];
                 if (direction < 0) {
@@ -448,11 +794,77 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
                 isWalking = true;
             }
             break;
-        }
 
         default:
-            Serial.print("未知のコマンド: 0x");
-            Serial.println(cmd, HEX);
+            controlStats.unknownCommands++;
             break;
     }
 }
+
+// =============================================================================
+// サーボ出力のI2Cバス時間を報告
+// =============================================================================
+void reportServoBus() {
+    const ServoOutputStats_t& stats = servoOut.stats();
+    Serial.printf("サーボI2C: 平均 %lu us/tick, 最大 %lu us, %lu トランザクション, エラー %lu, 復旧 %lu\n",
+                  (unsigned long)servoOut.averageBusUs(), (unsigned long)stats.maxBusUs,
+                  (unsigned long)stats.transactions, (unsigned long)stats.errors,
+                  (unsigned long)stats.recoveries);
+}
+
+// =============================================================================
+// 上半身とのリンク（ボーレート・エラー率）を報告
+// =============================================================================
+void reportUpperLink() {
+    LinkStatusData_t status;
+    upperSpeed.fillStatus(&status, LINK_UPPER_LOWER);
+    const ParserStats_t& parser = uartParser.stats();
+    const LinkStats_t& link = upperLink.stats();
+    Serial.printf("上半身UART: %lu baud (%s), 受信 %lu B/s, エラー率 %u/1000, CRC/チェックサム %lu, フレーム異常 %lu, "
+                  "交渉 %u, 下げた %u, IMU送信待ち溢れ %lu\n",
+                  (unsigned long)status.baud, upperSpeed.boosted() ? "交渉済み" : "基準",
+                  (unsigned long)status.rx_bytes_per_s, status.rx_error_permille,
+                  (unsigned long)parser.checksumErrors, (unsigned long)parser.framingErrors,
+                  status.negotiations, status.fallbacks, (unsigned long)sensorQueueOverflows);
+    Serial.printf("上半身リンク: %s, 重複 %lu, 並べ替え %lu, 欠落 %lu, NACK送信 %lu\n",
+                  upperLink.peerV2() ? "v2" : "v1",
+                  (unsigned long)link.duplicates, (unsigned long)link.reordered,
+                  (unsigned long)link.lost, (unsigned long)link.nacksSent);
+}
+
+// =============================================================================
+// 制御周期のジッタ・デッドライン超過を報告
+// =============================================================================
+void reportControlTiming() {
+    ControlStats_t stats = controlStats;
+    Serial.printf("制御周期: %lu 回, ジッタ 平均 %lu us / 最大 %lu us, 処理 最大 %lu us, "
+                  "デッドライン超過 %lu, キュー満杯 %lu\n",
+                  (unsigned long)stats.cycles,
+                  (unsigned long)(stats.cycles ? stats.totalJitterUs / stats.cycles : 0),
+                  (unsigned long)stats.maxJitterUs, (unsigned long)stats.maxExecUs,
+                  (unsigned long)stats.deadlineMisses, (unsigned long)controlQueueOverflows);
+}
+
+// IMU の読み出しと姿勢推定（制御タスクが更新する値をそのまま読む。表示用なので多少ずれてよい）
+void reportIMU() {
+    ImuSensorStats_t sensor = imuSensor.stats();
+    ImuFusionStats_t fusion = imuFusion.stats();
+    Serial.printf("IMU: %s, サンプル %lu (読み出し %lu), エラー %lu, FIFO溢れ %lu, 切り替え %lu, "
+                  "加速度不使用 %lu | ピッチ %.1f ロール %.1f ヨー %.1f\n",
+                  imuSensor.name(), (unsigned long)sensor.samples, (unsigned long)sensor.reads,
+                  (unsigned long)sensor.errors, (unsigned long)sensor.fifoOverflows,
+                  (unsigned long)sensor.switches, (unsigned long)fusion.accelRejected,
+                  pitchAngle, rollAngle, yawAngle);
+}
+
+// バランス補正（歩行中だけ動く。張り付き回数が増えていたら上限かゲインを見直す）
+void reportBalance() {
+    BalanceAxisState_t pitch = balance.axis(BALANCE_AXIS_PITCH).state();
+    BalanceAxisState_t roll = balance.axis(BALANCE_AXIS_ROLL).state();
+    Serial.printf("バランス: ピッチ 補正 %.1f (P %.1f I %.1f D %.1f) 張り付き %lu | "
+                  "ロール 補正 %.1f (P %.1f I %.1f D %.1f) 張り付き %lu\n",
+                  pitch.output, pitch.p, pitch.i, pitch.d * balance.axis(BALANCE_AXIS_PITCH).gains().kd,
+                  (unsigned long)pitch.saturated,
+                  roll.output, roll.p, roll.i, roll.d * balance.axis(BALANCE_AXIS_ROLL).gains().kd,
+                  (unsigned long)roll.saturated);
+}
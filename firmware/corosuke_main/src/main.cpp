@@ -15,12 +15,26 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <WebSocketsClient.h>
+#include <driver/i2s.h>
 #include "esp_camera.h"
 #include "Audio.h"
 
 // 共通ヘッダー
 #include "../../common/config.h"
 #include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+#include "../../common/reliable_link.h"
+#include "../../common/link_speed.h"
+#include "../../common/servo_frame.h"
+#include "../../common/lipsync.h"
+#include "../../common/person_detector.h"
+#include "../../common/spsc_queue.h"
+#include "../../common/server_link.h"
+#include "../../common/voice_activity.h"
+#include "../../common/ima_adpcm.h"
+#include "../../common/trace.h"
+#include "../../common/scheduler.h"
 
 // =============================================================================
 // カメラピン定義 (ESP32-S3-CAM)
@@ -49,23 +63,148 @@
 // WiFi状態
 bool wifiConnected = false;
 
+// ホームサーバーとの常時接続（WebSocket、切れたらライブラリが自動で再接続）
+typedef struct {
+    uint32_t connects;          // 接続に成功した回数
+    uint32_t disconnects;
+    uint32_t txMessages;
+    uint32_t txFailures;        // 未接続・大きすぎて送れなかった
+    uint32_t rxMessages;
+    uint32_t robotCommands;     // サーバーから上半身へ転送した指令
+} ServerLinkStats_t;
+
+WebSocketsClient serverLink;
+bool serverLinkConnected = false;
+uint8_t serverLinkSeq = 0;
+ServerLinkStats_t serverLinkStats;
+
 // オーディオ
 Audio audio;
 
-// 人物検知
+// リップシンク（再生中の PCM からサーボ周期ごとの振幅を求める）
+#define LIPSYNC_DEFAULT_SAMPLE_RATE 24000   // VOICEVOX の出力
+LipSync lipSync;
+
+// 人物検知（検知タスクが結果をキューへ、loop() が上半身へ送る）
+#define VISION_PERIOD_MS        50      // 20fps（CMD_FACE_POSITION の送信周期）
+#define VISION_TASK_CORE        0       // loop() とオーディオは core 1
+#define VISION_TASK_PRIORITY    2
+#define VISION_TASK_STACK       4096
+#define VISION_QUEUE_DEPTH      4
+
+// 検知タスクの計測値（検知タスクが書き、status で表示する）
+typedef struct {
+    uint32_t frames;            // 処理したフレーム数
+    uint32_t captureFailures;   // fb_get 失敗・サイズ違い
+    uint32_t dropped;           // キュー満杯で捨てた結果
+    uint64_t totalProcessUs;    // 検知処理時間の合計
+    uint32_t maxProcessUs;
+    uint32_t startMs;           // 最初のフレームの時刻
+    uint32_t lastMs;            // 最後のフレームの時刻
+} VisionStats_t;
+
+PersonDetector personDetector;
+SpscQueue<VisionResult_t, VISION_QUEUE_DEPTH> visionQueue;
+VisionStats_t visionStats;
+TaskHandle_t visionTaskHandle = nullptr;
+
 bool personDetected = false;
 int personX = 0;
 int personY = 0;
 
+// マイク（取り込みタスクが声の区間だけ ADPCM にしてキューへ、loop() がサーバーへ送る）
+#define MIC_I2S_PORT            I2S_NUM_1   // スピーカー（Audio）は I2S_NUM_0
+#define MIC_TASK_CORE           0
+#define MIC_TASK_PRIORITY       3       // 人物検知より上（DMA を溢れさせない）
+#define MIC_TASK_STACK          4096
+#define MIC_DMA_BUFFERS         4       // タスクが MIC_FRAME_MS × 3 遅れても溢れない
+#define MIC_QUEUE_DEPTH         16      // 約 1 秒分のチャンク（loop() が HTTP で止まる間）
+#define MIC_FRAME_SAMPLES       (MIC_SAMPLE_RATE * MIC_FRAME_MS / 1000)
+#define MIC_CHUNK_BYTES         (MIC_FRAME_SAMPLES * MIC_CHUNK_FRAMES / 2)
+
+static_assert(MIC_CHUNK_BYTES <= LINK_AUDIO_MAX_DATA, "MIC_CHUNK_FRAMES does not fit in one link message");
+static_assert(MIC_PREROLL_FRAMES >= VAD_ONSET_FRAMES, "the pre-roll must hold the onset frames");
+
+// サーバーへ送るメッセージ（LINK_MSG_AUDIO_START / AUDIO / AUDIO_END の payload）
+typedef struct {
+    uint8_t type;
+    uint16_t length;
+    uint8_t payload[sizeof(LinkAudioChunk_t) + MIC_CHUNK_BYTES];
+} MicMessage_t;
+
+// マイクタスクの計測値（マイクタスクが書き、status で表示する）
+typedef struct {
+    uint32_t frames;            // 読み出したフレーム数
+    uint32_t encodedFrames;     // ADPCM にしたフレーム（声の区間と語頭）
+    uint32_t segments;
+    uint32_t cancelled;         // 話し始めて打ち切った区間
+    uint32_t queuedBytes;       // キューへ入れた payload のバイト数
+    uint32_t dropped;           // キュー満杯で捨てたメッセージ
+    uint32_t readFailures;
+    uint64_t totalProcessUs;    // 変換・判定・符号化の合計
+    uint32_t maxProcessUs;
+} MicStats_t;
+
+VoiceActivityDetector vad;
+SpscQueue<MicMessage_t, MIC_QUEUE_DEPTH> micQueue;
+MicStats_t micStats;
+TaskHandle_t micTaskHandle = nullptr;
+volatile bool micMuted = false;     // ロボットが話している間は聞かない（自分の声を拾わない）
+
+// ここから下はマイクタスクだけが使う
+int32_t micRaw[MIC_FRAME_SAMPLES];
+int16_t micPreroll[MIC_PREROLL_FRAMES][MIC_FRAME_SAMPLES];     // 直近のフレーム（語頭）
+uint8_t micPrerollHead = 0;
+int32_t micDcQ8 = 0;                // DC オフセット（Q8）
+MicMessage_t micChunk;              // 組み立て中のチャンク
+uint8_t micChunkFrames = 0;
+uint16_t micChunkIndex = 0;
+uint8_t micSegment = 0;
+AdpcmState_t micAdpcm;
+
 // 会話状態
 bool isListening = false;
 bool isSpeaking = false;
 String lastUserMessage = "";
 String lastResponse = "";
 
-// タイミング
-unsigned long lastPersonCheck = 0;
-unsigned long lastIdleAction = 0;
+// 最初の音が出るまでの時間（発話の要求から最初の PCM が I2S に渡るまで）
+uint32_t speechRequestMs = 0;
+uint32_t speechFirstAudioMs = 0;
+bool speechFirstAudioPending = false;
+const char* speechMode = "";
+
+// 上半身との UART（確実に届けるコマンドは ACK まで保持して再送、ACK は Serial1 で受け取る）
+PacketParser upperParser;
+ReliableLink upperLink;
+LinkSpeed upperSpeed;       // 起動後にボーレートを上げる（こちらが交渉を始める側）
+unsigned long lastUpperRx = 0;
+
+// 下半身の IMU（上半身が中継してくる）
+ImuData_t lowerImu;
+unsigned long lowerImuMs = 0;
+uint32_t lowerImuCount = 0;
+
+// サーボフレーム送信（体ごとにキーフレームを保持）
+ServoFrameEncoder upperFrameEncoder(BODY_UPPER);
+ServoFrameEncoder lowerFrameEncoder(BODY_LOWER);
+
+// 処理時間の計測（人物検知・マイクはそれぞれのタスク、それ以外は loop() が書く）
+#define TRACE_ECHO_MS           2000    // trace コマンドの後、上半身・下半身の分布を表示する時間
+Tracer tracer;
+unsigned long traceEchoMs = 0;
+
+// loop() の周期ジョブ（優先度は大きいほど先）
+#define JOB_PRIORITY_AUDIO      4       // I2S の DMA を切らさない
+#define JOB_PRIORITY_UART       3
+#define JOB_PRIORITY_SERVER     2
+#define JOB_PRIORITY_QUEUE      1       // 人物検知・マイクのタスクからのキュー
+#define JOB_PRIORITY_BACKGROUND 0       // テレメトリ・アイドル動作・デバッグコマンド
+#define JOB_SERVER_POLL_MS      2
+#define JOB_QUEUE_POLL_MS       10      // 人物検知は 50ms、マイクは 60ms ごとに1件
+#define JOB_DEBUG_POLL_MS       50
+#define IDLE_ACTION_MS          10000
+Scheduler scheduler;
 
 // =============================================================================
 // 関数プロトタイプ
@@ -73,13 +212,51 @@ unsigned long lastIdleAction = 0;
 void initWiFi();
 void initCamera();
 void initAudio();
-void checkForPerson();
-void sendCommandToUpper(uint8_t cmd, uint8_t* data, uint8_t length);
+void initMic();
+void initServerLink();
+void serverLinkEvent(WStype_t type, uint8_t* payload, size_t length);
+bool sendToServer(uint8_t type, const void* payload, size_t length);
+void handleServerMessage(const uint8_t* message, size_t length);
+void sendTelemetry();
+void reportServerLink();
+void sendTraceStatus();
+void handleTraceStatus(const uint8_t* data);
+void printTraceStatus(const TraceStatusData_t& status);
+void playFromServer(const String& path, uint32_t sampleRate);
+void visionTask(void* parameter);
+void handleVisionResults();
+void reportVision();
+void micTask(void* parameter);
+void micStartSegment();
+void micAppendFrame(const int16_t* frame);
+void micEndSegment(uint8_t reason);
+bool micPush(uint8_t type, const void* payload, size_t length);
+void handleMicMessages();
+void reportMic();
+bool sendCommandToUpper(uint8_t cmd, uint8_t* data, uint8_t length);
+void handleUpperUART(unsigned long now);
+void reportUpperLink();
+void sendServoFrame(ServoBody_t body, const uint8_t* angles, uint8_t flags);
 void handleWebCommand();
 String sendToLLM(String message);
 void speakWithVoicevox(String text);
+void talkStreaming(String message);
+void startSpeechTiming(const char* mode);
+void finishSpeaking();
 void updateLipsync(uint8_t amplitude);
+void sendLipsyncFromAudio();
+void reportLipsync();
 void performIdleAction();
+void handleDebugCommand(String cmd);
+void jobAudio();
+void jobUART();
+void jobServer();
+void jobTelemetry();
+void jobTraceStatus();
+void jobVision();
+void jobMic();
+void jobIdleAction();
+void jobDebugCommand();
 
 // =============================================================================
 // セットアップ
@@ -90,9 +267,14 @@ void setup() {
     Serial.println("  コロ助 メインコントローラー");
     Serial.println("  Corosuke Main v1.0");
     Serial.println("=================================");
+    tracer.begin(TRACE_BOARD_MAIN);
 
-    // 上半身ボードとのUART
+    // 上半身ボードとのUART（ボーレートは起動後に交渉して上げる）
+    Serial1.setRxBufferSize(UART_RX_BUFFER_SIZE);
+    Serial1.setTxBufferSize(UART_TX_BUFFER_SIZE);
     Serial1.begin(UART_BAUD_RATE, SERIAL_8N1, UART_MAIN_RX, UART_MAIN_TX);
+    upperLink.reset((uint8_t)esp_random());
+    upperSpeed.begin(true, UART_BAUD_RATE, UART_MAIN_BAUD_MAX, millis());
 
     // WiFi初期化
     initWiFi();
@@ -103,8 +285,29 @@ void setup() {
     // オーディオ初期化
     initAudio();
 
+    // マイク（声の区間の検出と送信）
+    initMic();
+
+    // サーバーとの常時接続
+    initServerLink();
+
     Serial.println("ワガハイはコロ助ナリ！初期化完了ナリ！");
 
+    // 周期ジョブ（1回目のテレメトリ・トレース・アイドル動作は1周期後）
+    scheduler.begin();
+    scheduler.add("audio", jobAudio, 1000UL, JOB_PRIORITY_AUDIO);
+    scheduler.add("uart", jobUART, UART_POLL_MS * 1000UL, JOB_PRIORITY_UART, UART_POLL_DEADLINE_MS * 1000UL);
+    scheduler.add("server", jobServer, JOB_SERVER_POLL_MS * 1000UL, JOB_PRIORITY_SERVER);
+    scheduler.add("vision", jobVision, JOB_QUEUE_POLL_MS * 1000UL, JOB_PRIORITY_QUEUE);
+    scheduler.add("mic", jobMic, JOB_QUEUE_POLL_MS * 1000UL, JOB_PRIORITY_QUEUE);
+    scheduler.add("telemetry", jobTelemetry, LINK_TELEMETRY_MS * 1000UL, JOB_PRIORITY_BACKGROUND, 0,
+                  LINK_TELEMETRY_MS * 1000UL);
+    scheduler.add("trace", jobTraceStatus, LINK_TRACE_MS * 1000UL, JOB_PRIORITY_BACKGROUND, 0,
+                  LINK_TRACE_MS * 1000UL);
+    scheduler.add("idle_action", jobIdleAction, IDLE_ACTION_MS * 1000UL, JOB_PRIORITY_BACKGROUND, 0,
+                  IDLE_ACTION_MS * 1000UL);
+    scheduler.add("debug", jobDebugCommand, JOB_DEBUG_POLL_MS * 1000UL, JOB_PRIORITY_BACKGROUND);
+
     // 起動メッセージを話す
     // speakWithVoicevox("ワガハイはコロ助ナリ！よろしくナリ！");
 }
@@ -113,24 +316,57 @@ void setup() {
 // メインループ
 // =============================================================================
 void loop() {
-    unsigned long now = millis();
+    {
+        TraceScope trace(tracer, TRACE_LOOP);
+        scheduler.runDue();
+    }
+    scheduler.sleepUntilDue();
+}
 
-    // オーディオ処理
+// オーディオ処理（デコードした PCM は audio_process_i2s() でリップシンクへ）
+void jobAudio() {
+    TraceScope trace(tracer, TRACE_AUDIO);
     audio.loop();
+    sendLipsyncFromAudio();
+}
 
-    // 人物検知 (1秒ごと)
-    if (now - lastPersonCheck >= 1000) {
-        lastPersonCheck = now;
-        checkForPerson();
-    }
+// 上半身からの ACK/NACK と再送
+void jobUART() {
+    TraceScope trace(tracer, TRACE_UART);
+    handleUpperUART(millis());
+}
 
-    // アイドル動作 (10秒ごと)
-    if (!isSpeaking && !isListening && now - lastIdleAction >= 10000) {
-        lastIdleAction = now;
-        performIdleAction();
-    }
+// サーバーとの WebSocket（受信したメッセージは serverLinkEvent へ）
+void jobServer() {
+    TraceScope trace(tracer, TRACE_SERVER);
+    serverLink.loop();
+}
+
+void jobTelemetry() {
+    if (serverLinkConnected) sendTelemetry();
+}
 
-    // シリアルからのデバッグコマンド
+void jobTraceStatus() {
+    if (serverLinkConnected) sendTraceStatus();
+}
+
+// 人物検知の結果を上半身へ
+void jobVision() {
+    handleVisionResults();
+}
+
+// 声の区間をサーバーへ
+void jobMic() {
+    handleMicMessages();
+}
+
+// アイドル動作 (10秒ごと、話している・聞いている間の回は見送る)
+void jobIdleAction() {
+    if (!isSpeaking && !isListening) performIdleAction();
+}
+
+// シリアルからのデバッグコマンド
+void jobDebugCommand() {
     if (Serial.available()) {
         String cmd = Serial.readStringUntil('\n');
         cmd.trim();
@@ -187,17 +423,26 @@ void initCamera() {
     config.pin_pwdn = PWDN_GPIO_NUM;
     config.pin_reset = RESET_GPIO_NUM;
     config.xclk_freq_hz = 20000000;
-    config.pixel_format = PIXFORMAT_JPEG;
-    config.frame_size = FRAMESIZE_QVGA;  // 320x240
+    // 人物検知はグレースケールをそのまま使う（JPEG デコード不要）
+    config.pixel_format = PIXFORMAT_GRAYSCALE;
+    config.frame_size = FRAMESIZE_QQVGA;  // 160x120
     config.jpeg_quality = 12;
-    config.fb_count = 1;
-    config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+    // 2面バッファ: 検知中に次のフレームを DMA で取り込み、常に最新を受け取る
+    config.fb_count = 2;
+    config.fb_location = CAMERA_FB_IN_DRAM;
+    config.grab_mode = CAMERA_GRAB_LATEST;
 
     esp_err_t err = esp_camera_init(&config);
     if (err != ESP_OK) {
         Serial.printf("カメラ初期化失敗: 0x%x\n", err);
-    } else {
-        Serial.println("カメラ初期化完了");
+        return;
+    }
+    Serial.println("カメラ初期化完了");
+
+    memset(&visionStats, 0, sizeof(visionStats));
+    if (xTaskCreatePinnedToCore(visionTask, "vision", VISION_TASK_STACK, nullptr,
+                                VISION_TASK_PRIORITY, &visionTaskHandle, VISION_TASK_CORE) != pdPASS) {
+        Serial.println("人物検知タスクを起動できないナリ！");
     }
 }
 
@@ -207,71 +452,576 @@ void initCamera() {
 void initAudio() {
     audio.setPinout(I2S_BCLK_PIN, I2S_LRCLK_PIN, I2S_DOUT_PIN);
     audio.setVolume(15);  // 0-21
+    lipSync.begin(LIPSYNC_DEFAULT_SAMPLE_RATE, SERVO_UPDATE_INTERVAL_MS);
 
     Serial.println("オーディオ初期化完了");
 }
 
 // =============================================================================
-// 人物検知（簡易版 - 実際はEdge Impulseなどを使用）
+// マイク初期化（I2S1 で INMP441 から取り込み、core 0 のタスクで判定する）
 // =============================================================================
-void checkForPerson() {
-    camera_fb_t* fb = esp_camera_fb_get();
-    if (!fb) {
+void initMic() {
+    memset(&micStats, 0, sizeof(micStats));
+    vad.begin();
+
+    i2s_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
+    config.sample_rate = MIC_SAMPLE_RATE;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;     // 24bit のデータが上詰めで届く
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;      // L/R ピンは GND
+    config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+    config.dma_buf_count = MIC_DMA_BUFFERS;
+    config.dma_buf_len = MIC_FRAME_SAMPLES;
+
+    i2s_pin_config_t pins;
+    pins.mck_io_num = I2S_PIN_NO_CHANGE;
+    pins.bck_io_num = MIC_SCK_PIN;
+    pins.ws_io_num = MIC_WS_PIN;
+    pins.data_out_num = I2S_PIN_NO_CHANGE;
+    pins.data_in_num = MIC_SD_PIN;
+
+    if (i2s_driver_install(MIC_I2S_PORT, &config, 0, nullptr) != ESP_OK ||
+        i2s_set_pin(MIC_I2S_PORT, &pins) != ESP_OK) {
+        Serial.println("マイク初期化失敗");
         return;
     }
 
-    // TODO: 実際の人物検知ロジック
-    // ここでは簡易的に画像の中心部の輝度変化で検知する例
-    // 実際の実装ではEdge Impulseモデルを使用
+    if (xTaskCreatePinnedToCore(micTask, "mic", MIC_TASK_STACK, nullptr,
+                                MIC_TASK_PRIORITY, &micTaskHandle, MIC_TASK_CORE) != pdPASS) {
+        Serial.println("マイクタスク起動失敗");
+        return;
+    }
+    Serial.println("マイク初期化完了");
+}
 
-    // 仮の検知ロジック
-    bool detected = false;
-    int centerX = 160;
-    int centerY = 120;
+// =============================================================================
+// サーバー接続（WebSocket）
+// =============================================================================
+void initServerLink() {
+    memset(&serverLinkStats, 0, sizeof(serverLinkStats));
+    if (!wifiConnected) return;
+
+    serverLink.begin(HOME_SERVER_IP, HOME_SERVER_PORT, LINK_PATH);
+    serverLink.onEvent(serverLinkEvent);
+    serverLink.setReconnectInterval(LINK_RECONNECT_MS);
+    serverLink.enableHeartbeat(LINK_PING_INTERVAL_MS, LINK_PONG_TIMEOUT_MS, LINK_PONG_MISSES);
+}
+
+void serverLinkEvent(WStype_t type, uint8_t* payload, size_t length) {
+    switch (type) {
+        case WStype_CONNECTED: {
+            serverLinkConnected = true;
+            serverLinkStats.connects++;
+            Serial.println("サーバーに接続したナリ！");
 
-    if (detected && !personDetected) {
-        // 新しく人を検知
-        personDetected = true;
-        Serial.println("人を検知したナリ！");
+            const uint8_t hello[] = {LINK_VERSION, 'm', 'a', 'i', 'n'};
+            sendToServer(LINK_MSG_HELLO, hello, sizeof(hello));
+            sendTelemetry();
+            break;
+        }
+
+        case WStype_DISCONNECTED:
+            if (serverLinkConnected) {
+                serverLinkStats.disconnects++;
+                Serial.println("サーバーとの接続が切れたナリ...");
+            }
+            serverLinkConnected = false;
+            break;
 
-        // 上半身に通知
+        case WStype_BIN:
+            serverLinkStats.rxMessages++;
+            handleServerMessage(payload, length);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// [type][seq][payload] を1フレームで送る
+bool sendToServer(uint8_t type, const void* payload, size_t length) {
+    uint8_t message[LINK_MAX_MESSAGE];
+    size_t size = linkEncode(message, sizeof(message), type, ++serverLinkSeq, payload, length);
+    if (!serverLinkConnected || size == 0 || !serverLink.sendBIN(message, size)) {
+        serverLinkStats.txFailures++;
+        return false;
+    }
+    serverLinkStats.txMessages++;
+    return true;
+}
+
+void handleServerMessage(const uint8_t* message, size_t length) {
+    if (length < LINK_HEADER_SIZE) return;
+    uint8_t type = message[0];
+    const uint8_t* payload = message + LINK_HEADER_SIZE;
+    size_t payloadLength = length - LINK_HEADER_SIZE;
+
+    switch (type) {
+        case LINK_MSG_REPLY: {
+            // 応答テキストと表情（音声は LINK_MSG_PLAY で別に届く）
+            if (payloadLength < 1) break;
+            lastResponse = String((const char*)payload + 1, payloadLength - 1);
+            Serial.println("コロ助: " + lastResponse);
+
+            ExpressionData_t expr;
+            expr.expression_id = payload[0] < EXPR_COUNT ? payload[0] : EXPR_NEUTRAL;
+            expr.intensity = 100;
+            expr.duration_ms = 3000;
+            sendCommandToUpper(CMD_EXPRESSION, (uint8_t*)&expr, sizeof(expr));
+            break;
+        }
+
+        case LINK_MSG_PLAY: {
+            if (payloadLength < 5) break;
+            uint32_t sampleRate;
+            memcpy(&sampleRate, payload, sizeof(sampleRate));
+            playFromServer(String((const char*)payload + 4, payloadLength - 4), sampleRate);
+            break;
+        }
+
+        case LINK_MSG_ROBOT_CMD:
+            // サーバーからの表情・動作の指令はそのまま上半身へ
+            if (payloadLength >= 1 && payloadLength - 1 <= PACKET_MAX_SIZE - 5) {
+                serverLinkStats.robotCommands++;
+                sendCommandToUpper(payload[0], (uint8_t*)payload + 1, payloadLength - 1);
+            }
+            break;
+
+        case LINK_MSG_HEARD:
+            // 声の区間を聞き取った結果（応答は続けて REPLY / PLAY で届く）
+            if (payloadLength == 0) {
+                Serial.println("聞き取れなかったナリ...");
+                break;
+            }
+            lastUserMessage = String((const char*)payload, payloadLength);
+            Serial.println("聞こえた: " + lastUserMessage);
+            break;
+
+        case LINK_MSG_ERROR:
+            Serial.print("サーバーエラー: ");
+            Serial.println(String((const char*)payload, payloadLength));
+            break;
+
+        default:
+            Serial.printf("未知のサーバーメッセージ: 0x%02X\n", type);
+            break;
+    }
+}
+
+void sendTelemetry() {
+    uint32_t elapsedMs = visionStats.lastMs - visionStats.startMs;
+
+    LinkTelemetry_t telemetry;
+    telemetry.uptime_ms = millis();
+    telemetry.free_heap = ESP.getFreeHeap();
+    telemetry.rssi = WiFi.RSSI();
+    telemetry.flags = (personDetected ? LINK_FLAG_PERSON : 0) | (isSpeaking ? LINK_FLAG_SPEAKING : 0) |
+                      (isListening ? LINK_FLAG_LISTENING : 0);
+    telemetry.person_x = personX;
+    telemetry.person_y = personY;
+    telemetry.vision_fps_x10 = elapsedMs ? (uint16_t)((visionStats.frames - 1) * 10000ull / elapsedMs) : 0;
+    telemetry.reconnects = serverLinkStats.connects > 0 ? serverLinkStats.connects - 1 : 0;
+    sendToServer(LINK_MSG_TELEMETRY, &telemetry, sizeof(telemetry));
+}
+
+void reportServerLink() {
+    Serial.printf("サーバー接続: %s, 接続 %lu 回 / 切断 %lu 回, 送信 %lu (失敗 %lu), 受信 %lu, 転送した指令 %lu\n",
+                  serverLinkConnected ? "接続中" : "未接続",
+                  (unsigned long)serverLinkStats.connects, (unsigned long)serverLinkStats.disconnects,
+                  (unsigned long)serverLinkStats.txMessages, (unsigned long)serverLinkStats.txFailures,
+                  (unsigned long)serverLinkStats.rxMessages, (unsigned long)serverLinkStats.robotCommands);
+}
+
+// =============================================================================
+// 処理時間の分布をサーバーへ（このボードの分はまとめて送り、上半身・下半身には
+// STATUS_TRACE を頼む。応答は handleTraceStatus() が届いたものから送る）
+// =============================================================================
+void sendTraceStatus() {
+    uint8_t payload[(LINK_MAX_MESSAGE - LINK_HEADER_SIZE) / sizeof(TraceStatusData_t) * sizeof(TraceStatusData_t)];
+    size_t length = 0;
+    for (uint8_t stage = 0; stage < TRACE_STAGES; stage++) {
+        TraceStatusData_t status;
+        if (!tracer.fillStatus((TraceStage_t)stage, &status)) continue;
+        if (length + sizeof(status) > sizeof(payload)) {
+            sendToServer(LINK_MSG_TRACE, payload, length);
+            length = 0;
+        }
+        memcpy(&payload[length], &status, sizeof(status));
+        length += sizeof(status);
+    }
+    if (length > 0) sendToServer(LINK_MSG_TRACE, payload, length);
+
+    uint8_t kind = STATUS_TRACE;
+    sendCommandToUpper(CMD_STATUS, &kind, 1);
+}
+
+void handleTraceStatus(const uint8_t* data) {
+    TraceStatusData_t status;
+    memcpy(&status, data, sizeof(status));
+    if (serverLinkConnected) sendToServer(LINK_MSG_TRACE, &status, sizeof(status));
+    if (traceEchoMs != 0 && millis() - traceEchoMs < TRACE_ECHO_MS) printTraceStatus(status);
+}
+
+void printTraceStatus(const TraceStatusData_t& status) {
+    static const char* const BOARDS[] = {"メイン", "上半身", "下半身"};
+    Serial.printf("  [%s] %s: %lu 回, 平均 %lu us, 最大 %lu us, %lu ms 超え %lu |",
+                  status.board <= TRACE_BOARD_LOWER ? BOARDS[status.board] : "?",
+                  status.stage < TRACE_STAGES ? TRACE_STAGE_NAMES[status.stage] : "?",
+                  (unsigned long)status.samples,
+                  (unsigned long)(status.samples ? status.total_us / status.samples : 0),
+                  (unsigned long)status.max_us, (unsigned long)(TRACE_BUDGET_US / 1000),
+                  (unsigned long)status.over_budget);
+    for (uint8_t i = 0; i < TRACE_BUCKETS; i++) {
+        if (status.buckets[i] == 0) continue;
+        if (i < TRACE_BUCKETS - 1) {
+            Serial.printf(" <%lu:%lu", (unsigned long)traceBucketLimitUs(i),
+                          (unsigned long)status.buckets[i] << status.scale);
+        } else {
+            Serial.printf(" それ以上:%lu", (unsigned long)status.buckets[i] << status.scale);
+        }
+    }
+    Serial.println();
+}
+
+// =============================================================================
+// 人物検知タスク（core 0、VISION_PERIOD_MS 周期）
+// =============================================================================
+void visionTask(void* parameter) {
+    (void)parameter;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(VISION_PERIOD_MS));
+
+        camera_fb_t* fb = esp_camera_fb_get();
+        if (!fb) {
+            visionStats.captureFailures++;
+            continue;
+        }
+
+        uint32_t startUs = micros();
+        uint32_t traceStart = Tracer::cycles();
+        VisionResult_t result;
+        bool ok = fb->format == PIXFORMAT_GRAYSCALE &&
+                  personDetector.process(fb->buf, fb->width, fb->height, &result);
+        uint32_t processUs = micros() - startUs;
+        tracer.record(TRACE_CAMERA, traceStart);
+
+        // 処理が終わったらすぐ返して、次の取り込み先にする
+        esp_camera_fb_return(fb);
+
+        if (!ok) {
+            visionStats.captureFailures++;
+            continue;
+        }
+        if (visionStats.frames == 0) visionStats.startMs = millis();
+        visionStats.lastMs = millis();
+        visionStats.frames++;
+        visionStats.totalProcessUs += processUs;
+        if (processUs > visionStats.maxProcessUs) visionStats.maxProcessUs = processUs;
+
+        if (!visionQueue.push(result)) visionStats.dropped++;
+    }
+}
+
+// =============================================================================
+// 人物検知の結果を上半身へ（検知・喪失は CMD_PERSON_DETECTED、追跡中は毎フレーム顔の位置）
+// =============================================================================
+void handleVisionResults() {
+    VisionResult_t result;
+    while (visionQueue.pop(&result)) {
         PersonData_t personData;
-        personData.detected = 1;
-        personData.x = centerX;
-        personData.y = centerY;
-        personData.size = 100;
-        sendCommandToUpper(CMD_PERSON_DETECTED, (uint8_t*)&personData, sizeof(personData));
+        personData.detected = result.detected ? 1 : 0;
+        personData.x = result.faceX;
+        personData.y = result.faceY;
+        personData.size = result.size;
+
+        if (result.changed) {
+            personDetected = result.detected;
+            Serial.println(personDetected ? "人を検知したナリ！" : "人がいなくなったナリ...");
+            sendCommandToUpper(CMD_PERSON_DETECTED, (uint8_t*)&personData, sizeof(personData));
+        }
+        if (result.detected) {
+            personX = result.faceX;
+            personY = result.faceY;
+            sendCommandToUpper(CMD_FACE_POSITION, (uint8_t*)&personData, sizeof(personData));
+        }
+    }
+}
+
+// =============================================================================
+// マイクタスク（core 0、DMA に MIC_FRAME_MS 溜まるごと）
+// 黙っている間は変換と VAD だけ。声の区間だけ語頭と一緒に ADPCM にしてキューへ
+// =============================================================================
+void micTask(void* parameter) {
+    (void)parameter;
+    for (;;) {
+        size_t bytesRead = 0;
+        if (i2s_read(MIC_I2S_PORT, micRaw, sizeof(micRaw), &bytesRead, portMAX_DELAY) != ESP_OK ||
+            bytesRead != sizeof(micRaw)) {
+            micStats.readFailures++;
+            vTaskDelay(1);
+            continue;
+        }
+
+        TraceScope trace(tracer, TRACE_MIC);
+        uint32_t startUs = micros();
+        int16_t* frame = micPreroll[micPrerollHead];
+        micPrerollHead = (uint8_t)((micPrerollHead + 1) % MIC_PREROLL_FRAMES);
+
+        // 24bit → 16bit、DC オフセットは 1 次のハイパス（約 5Hz）で除く
+        for (uint16_t i = 0; i < MIC_FRAME_SAMPLES; i++) {
+            int32_t sample = micRaw[i] >> MIC_SAMPLE_SHIFT;
+            micDcQ8 += ((sample << 8) - micDcQ8) >> 9;
+            sample -= micDcQ8 >> 8;
+            frame[i] = (int16_t)(sample < -32768 ? -32768 : (sample > 32767 ? 32767 : sample));
+        }
+        micStats.frames++;
+
+        if (micMuted) {
+            if (vad.cancel()) micEndSegment(LINK_AUDIO_END_CANCEL);
+        } else {
+            switch (vad.process(frame, MIC_FRAME_SAMPLES)) {
+                case VAD_START:
+                    micStartSegment();
+                    break;
+                case VAD_VOICE:
+                    micAppendFrame(frame);
+                    break;
+                case VAD_END:
+                    micEndSegment(vad.endedByLength() ? LINK_AUDIO_END_LENGTH : LINK_AUDIO_END_SILENCE);
+                    break;
+                default:
+                    break;
+            }
+        }
 
-        // 視線を向ける
-        int8_t lookX = map(centerX, 0, 320, -50, 50);
-        int8_t lookY = map(centerY, 0, 240, 50, -50);
-        uint8_t lookData[2] = {(uint8_t)lookX, (uint8_t)lookY};
-        sendCommandToUpper(CMD_LOOK_AT, lookData, 2);
+        uint32_t processUs = micros() - startUs;
+        micStats.totalProcessUs += processUs;
+        if (processUs > micStats.maxProcessUs) micStats.maxProcessUs = processUs;
     }
+}
 
-    esp_camera_fb_return(fb);
+// 区間の始まり: AUDIO_START と、取っておいた語頭（今のフレームまで）
+void micStartSegment() {
+    micSegment++;
+    micChunkIndex = 0;
+    micChunkFrames = 0;
+    adpcmReset(&micAdpcm);
+    micStats.segments++;
+
+    LinkAudioStart_t start;
+    start.segment = micSegment;
+    start.codec = LINK_AUDIO_IMA_ADPCM;
+    start.sample_rate = MIC_SAMPLE_RATE;
+    start.preroll_ms = (MIC_PREROLL_FRAMES - VAD_ONSET_FRAMES) * MIC_FRAME_MS;
+    micPush(LINK_MSG_AUDIO_START, &start, sizeof(start));
+
+    for (uint8_t i = 0; i < MIC_PREROLL_FRAMES; i++) {
+        micAppendFrame(micPreroll[(micPrerollHead + i) % MIC_PREROLL_FRAMES]);
+    }
+}
+
+// 1 フレームを符号化してチャンクへ。MIC_CHUNK_FRAMES たまったらキューへ
+void micAppendFrame(const int16_t* frame) {
+    if (micChunkFrames == 0) {
+        LinkAudioChunk_t header;
+        header.segment = micSegment;
+        header.chunk = micChunkIndex;
+        header.predictor = micAdpcm.predictor;
+        header.step_index = micAdpcm.index;
+        memcpy(micChunk.payload, &header, sizeof(header));
+    }
+    uint8_t* out = micChunk.payload + sizeof(LinkAudioChunk_t) + micChunkFrames * (MIC_FRAME_SAMPLES / 2);
+    adpcmEncode(&micAdpcm, frame, MIC_FRAME_SAMPLES, out);
+    micStats.encodedFrames++;
+
+    if (++micChunkFrames < MIC_CHUNK_FRAMES) return;
+    micPush(LINK_MSG_AUDIO, micChunk.payload, sizeof(LinkAudioChunk_t) + MIC_CHUNK_BYTES);
+    micChunkIndex++;
+    micChunkFrames = 0;
+}
+
+// 区間の終わり: 途中のチャンクと AUDIO_END
+void micEndSegment(uint8_t reason) {
+    if (micChunkFrames != 0) {
+        micPush(LINK_MSG_AUDIO, micChunk.payload,
+                sizeof(LinkAudioChunk_t) + micChunkFrames * (MIC_FRAME_SAMPLES / 2));
+        micChunkIndex++;
+        micChunkFrames = 0;
+    }
+    if (reason == LINK_AUDIO_END_CANCEL) micStats.cancelled++;
+
+    LinkAudioEnd_t end;
+    end.segment = micSegment;
+    end.reason = reason;
+    end.chunks = micChunkIndex;
+    micPush(LINK_MSG_AUDIO_END, &end, sizeof(end));
+}
+
+// キューが満杯なら捨てて数える（チャンクの番号は進むので、サーバーは抜けを無音で埋める）
+bool micPush(uint8_t type, const void* payload, size_t length) {
+    // micChunk を組み立てながら送るので、payload が micChunk のときはコピーしない
+    MicMessage_t* message = &micChunk;
+    MicMessage_t control;
+    if (payload != micChunk.payload) {
+        message = &control;
+        memcpy(control.payload, payload, length);
+    }
+    message->type = type;
+    message->length = (uint16_t)length;
+    if (!micQueue.push(*message)) {
+        micStats.dropped++;
+        return false;
+    }
+    micStats.queuedBytes += length;
+    return true;
+}
+
+// =============================================================================
+// 声の区間をサーバーへ（話している間はマイクタスクに聞かないよう伝える）
+// =============================================================================
+void handleMicMessages() {
+    micMuted = isSpeaking;
+
+    MicMessage_t message;
+    while (micQueue.pop(&message)) {
+        if (message.type == LINK_MSG_AUDIO_START) {
+            isListening = true;
+            Serial.println("聞いているナリ...");
+        } else if (message.type == LINK_MSG_AUDIO_END) {
+            LinkAudioEnd_t end;
+            memcpy(&end, message.payload, sizeof(end));
+            isListening = false;
+            Serial.printf("聞き終わったナリ（%u チャンク%s）\n", end.chunks,
+                          end.reason == LINK_AUDIO_END_CANCEL ? "、打ち切り" : "");
+            // 応答の最初の音までは、声の区間が終わったところから測る
+            if (end.reason != LINK_AUDIO_END_CANCEL && serverLinkConnected) startSpeechTiming("音声");
+        }
+        sendToServer(message.type, message.payload, message.length);
+    }
+}
+
+// =============================================================================
+// マイクの帯域と処理コストを報告
+// =============================================================================
+void reportMic() {
+    const VadStats_t& stats = vad.stats();
+    float seconds = micStats.frames * (MIC_FRAME_MS / 1000.0f);
+    float voiced = micStats.frames ? micStats.encodedFrames * 100.0f / micStats.frames : 0.0f;
+    uint32_t avgUs = micStats.frames ? (uint32_t)(micStats.totalProcessUs / micStats.frames) : 0;
+    Serial.printf("マイク: %.0f 秒, 声の区間 %lu (符号化 %.1f%%, 打ち切り %lu, 短い音を除外 %lu), "
+                  "上り %.0f B/s (PCM なら %u B/s), 処理 平均 %lu us / 最大 %lu us, 取りこぼし %lu, 読み出し失敗 %lu\n",
+                  seconds, (unsigned long)micStats.segments, voiced, (unsigned long)micStats.cancelled,
+                  (unsigned long)stats.rejected, seconds > 0.0f ? micStats.queuedBytes / seconds : 0.0f,
+                  MIC_SAMPLE_RATE * 2, (unsigned long)avgUs, (unsigned long)micStats.maxProcessUs,
+                  (unsigned long)micStats.dropped, (unsigned long)micStats.readFailures);
+}
+
+// =============================================================================
+// 人物検知の処理レートを報告
+// =============================================================================
+void reportVision() {
+    uint32_t elapsedMs = visionStats.lastMs - visionStats.startMs;
+    float fps = elapsedMs ? (visionStats.frames - 1) * 1000.0f / elapsedMs : 0.0f;
+    uint32_t avgUs = visionStats.frames ? (uint32_t)(visionStats.totalProcessUs / visionStats.frames) : 0;
+    Serial.printf("人物検知: %lu フレーム, %.1f fps, 処理 平均 %lu us / 最大 %lu us, 取得失敗 %lu, 取りこぼし %lu\n",
+                  (unsigned long)visionStats.frames, fps, (unsigned long)avgUs,
+                  (unsigned long)visionStats.maxProcessUs, (unsigned long)visionStats.captureFailures,
+                  (unsigned long)visionStats.dropped);
 }
 
 // =============================================================================
 // 上半身ボードへコマンド送信
 // =============================================================================
-void sendCommandToUpper(uint8_t cmd, uint8_t* data, uint8_t length) {
-    uint8_t packet[PACKET_MAX_SIZE];
-    uint8_t idx = 0;
+bool sendCommandToUpper(uint8_t cmd, uint8_t* data, uint8_t length) {
+    // 上半身が v2 に対応していなければ v1 のまま送る
+    if (!upperLink.send(Serial1, cmd, data, length, millis())) {
+        Serial.printf("上半身への送信待ちが一杯: 0x%02X を破棄\n", cmd);
+        return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// 上半身からの受信（ACK/NACK/HELLO、ボーレート交渉、ステータス応答）と再送
+// =============================================================================
+void handleUpperUART(unsigned long now) {
+    if (upperParser.readFrom(Serial1) > 0) {
+        lastUpperRx = now;
+    } else if (upperParser.buffered() > 0 && now - lastUpperRx >= UART_IDLE_RESYNC_MS) {
+        upperParser.resyncIfStalled();
+    }
 
-    packet[idx++] = PACKET_START;
-    packet[idx++] = length + 1;  // cmd + data
-    packet[idx++] = cmd;
+    PacketView_t packet;
+    while (upperParser.next(&packet)) {
+        // 上半身から届くのはリンクの制御フレーム、ステータス応答、下半身のセンサーデータ
+        if (upperLink.receive(Serial1, packet, now)) {
+            if (packet.cmd == CMD_IMU_DATA && packet.length >= sizeof(ImuData_t)) {
+                memcpy(&lowerImu, packet.data, sizeof(lowerImu));
+                lowerImuMs = now;
+                lowerImuCount++;
+            } else if (packet.cmd == CMD_LINK_SPEED) {
+                upperSpeed.receive(Serial1, packet, now);
+            } else if (packet.cmd == CMD_STATUS_RESP && packet.length >= sizeof(TraceStatusData_t) &&
+                       packet.data[0] == STATUS_RESP_TRACE) {
+                // 上半身の分と、上半身が中継した下半身の分
+                handleTraceStatus(packet.data);
+            } else if (packet.cmd == CMD_STATUS_RESP && packet.length >= 1 && packet.data[0] < STATUS_RESP_TRACE) {
+                uint8_t count = packet.data[0];
+                for (uint8_t i = 0; i < count && 1 + (i + 1) * sizeof(LinkStatusData_t) <= packet.length; i++) {
+                    LinkStatusData_t status;
+                    memcpy(&status, &packet.data[1 + i * sizeof(LinkStatusData_t)], sizeof(status));
+                    LinkSpeed::printStatus(Serial, "上半身", status);
+                }
+            }
+        }
+        while (upperLink.nextBuffered(&packet)) {}
+    }
+    upperLink.poll(Serial1, now);
+    upperSpeed.poll(Serial1, now, upperParser.stats(), upperLink.stats().txBytes);
+}
 
-    for (int i = 0; i < length; i++) {
-        packet[idx++] = data[i];
+void reportUpperLink() {
+    const LinkStats_t& link = upperLink.stats();
+    const ParserStats_t& parser = upperParser.stats();
+    Serial.printf("上半身UART: %s, 送信 %lu (%lu bytes, v1 %lu), 再送 %lu, NACK受信 %lu, 諦め %lu, 待ち溢れ %lu, RTO %lu ms, 受信エラー %lu\n",
+                  upperLink.peerV2() ? "v2" : "v1",
+                  (unsigned long)link.txFrames, (unsigned long)link.txBytes, (unsigned long)link.v1Frames,
+                  (unsigned long)link.retransmits, (unsigned long)link.nacksReceived,
+                  (unsigned long)link.giveUps, (unsigned long)link.queueFull,
+                  (unsigned long)upperLink.rtoMs(),
+                  (unsigned long)(parser.checksumErrors + parser.framingErrors));
+
+    LinkStatusData_t status;
+    upperSpeed.fillStatus(&status, LINK_MAIN_UPPER);
+    LinkSpeed::printStatus(Serial, "メイン", status);
+
+    if (lowerImuCount > 0) {
+        Serial.printf("下半身IMU: pitch %.2f roll %.2f yaw %.2f (%lu 回受信, %lu ms 前)\n",
+                      lowerImu.pitch / 100.0f, lowerImu.roll / 100.0f, lowerImu.yaw / 100.0f,
+                      (unsigned long)lowerImuCount, (unsigned long)(millis() - lowerImuMs));
+    } else {
+        Serial.println("下半身IMU: 未受信");
     }
 
-    uint8_t checksum = calculateChecksum(&packet[1], idx - 1);
-    packet[idx++] = checksum;
-    packet[idx++] = PACKET_END;
+    // 上半身から見たリンク（上半身 ↔ 下半身を含む）は CMD_STATUS_RESP で届いたときに表示
+    sendCommandToUpper(CMD_STATUS, nullptr, 0);
+}
 
-    Serial1.write(packet, idx);
+// =============================================================================
+// サーボフレーム送信（全16チャンネル、変化が少なければ差分で）
+// =============================================================================
+void sendServoFrame(ServoBody_t body, const uint8_t* angles, uint8_t flags) {
+    ServoFrameEncoder& encoder = (body == BODY_LOWER) ? lowerFrameEncoder : upperFrameEncoder;
+
+    uint8_t data[sizeof(ServoFrameData_t)];
+    uint8_t cmd;
+    uint8_t length = encoder.encode(angles, flags, &cmd, data);
+    // 下半身宛ては上半身が転送。キーフレームを送れなければ、後の差分は基準がないので次もキーフレームに
+    if (!sendCommandToUpper(cmd, data, length) && cmd == CMD_SERVO_FRAME) encoder.reset();
 }
 
 // =============================================================================
@@ -319,6 +1069,11 @@ void speakWithVoicevox(String text) {
         return;
     }
 
+    // 常時接続があればそちらで（音声は LINK_MSG_PLAY で届く）
+    if (sendToServer(LINK_MSG_SPEAK, text.c_str(), text.length())) {
+        return;
+    }
+
     isSpeaking = true;
 
     // サーバーにテキストを送信し、音声URLを取得
@@ -339,21 +1094,94 @@ void speakWithVoicevox(String text) {
         String payload = http.getString();
         StaticJsonDocument<256> resDoc;
         deserializeJson(resDoc, payload);
-        String audioUrl = resDoc["audio_url"].as<String>();
+        playFromServer(resDoc["audio_url"].as<String>(), 0);
+    } else {
+        Serial.printf("VOICEVOX Error: %d\n", httpCode);
+    }
 
-        // 音声を再生
-        audio.connecttohost(audioUrl.c_str());
+    http.end();
+}
 
-        // 発話開始を上半身に通知
-        uint8_t dummy = 0;
-        sendCommandToUpper(CMD_SPEAK_START, &dummy, 1);
+// =============================================================================
+// ストリーミング発話（LLM の応答を文ごとに合成した WAV ストリームを再生）
+// =============================================================================
+void talkStreaming(String message) {
+    if (!wifiConnected) {
+        Serial.println("WiFiに接続されていないナリ...");
+        return;
+    }
+
+    startSpeechTiming("ストリーミング");
+
+    // サーバーはすぐにストリームの URL を返し、最初の文ができ次第流し始める
+    HTTPClient http;
+    String url = String("http://") + HOME_SERVER_IP + ":" + HOME_SERVER_PORT + "/chat_stream";
+
+    http.begin(url);
+    http.addHeader("Content-Type", "application/json");
+
+    StaticJsonDocument<512> doc;
+    doc["message"] = message;
+    String requestBody;
+    serializeJson(doc, requestBody);
+
+    int httpCode = http.POST(requestBody);
+
+    if (httpCode == HTTP_CODE_OK) {
+        String payload = http.getString();
+        StaticJsonDocument<256> resDoc;
+        deserializeJson(resDoc, payload);
+        playFromServer(resDoc["stream_url"].as<String>(), resDoc["sample_rate"] | 0);
     } else {
-        Serial.printf("VOICEVOX Error: %d\n", httpCode);
+        speechFirstAudioPending = false;
+        Serial.printf("ストリーミング Error: %d\n", httpCode);
     }
 
     http.end();
 }
 
+// =============================================================================
+// サーバー上の音声を再生（path はサーバーのパス、sampleRate が 0 なら再生側に任せる）
+// =============================================================================
+void playFromServer(const String& path, uint32_t sampleRate) {
+    String url = String("http://") + HOME_SERVER_IP + ":" + HOME_SERVER_PORT + path;
+
+    isSpeaking = true;
+    lipSync.reset();
+    if (sampleRate) lipSync.setSampleRate(sampleRate);
+    audio.connecttohost(url.c_str());
+
+    // 発話開始を上半身に通知
+    uint8_t dummy = 0;
+    sendCommandToUpper(CMD_SPEAK_START, &dummy, 1);
+}
+
+// =============================================================================
+// 最初の音までの計測
+// =============================================================================
+void startSpeechTiming(const char* mode) {
+    speechMode = mode;
+    speechRequestMs = millis();
+    speechFirstAudioPending = true;
+}
+
+// 再生が終わったら（ファイルでもストリームでも）
+void finishSpeaking() {
+    Serial.println("再生完了");
+    isSpeaking = false;
+    lipSync.reset();
+    reportLipsync();
+    if (!speechFirstAudioPending && speechRequestMs != 0) {
+        Serial.printf("最初の音まで: %lu ms (%s)\n",
+                      (unsigned long)(speechFirstAudioMs - speechRequestMs), speechMode);
+        speechRequestMs = 0;
+    }
+
+    // 発話終了を上半身に通知
+    uint8_t dummy = 0;
+    sendCommandToUpper(CMD_SPEAK_STOP, &dummy, 1);
+}
+
 // =============================================================================
 // リップシンク更新
 // =============================================================================
@@ -362,6 +1190,28 @@ void updateLipsync(uint8_t amplitude) {
     sendCommandToUpper(CMD_LIPSYNC_DATA, &mouthOpen, 1);
 }
 
+// 窓ごとの振幅を送る。loop() が遅れて溜まっていたら最新の1つだけ
+void sendLipsyncFromAudio() {
+    uint8_t level;
+    bool available = false;
+    while (lipSync.pop(&level)) {
+        available = true;
+    }
+    if (available && isSpeaking) {
+        updateLipsync(level);
+    }
+}
+
+// =============================================================================
+// リップシンクの処理コストを報告
+// =============================================================================
+void reportLipsync() {
+    const LipSyncStats_t& stats = lipSync.stats();
+    Serial.printf("リップシンク: %lu 窓, CPU %.3f%% (最大 %lu us/バッファ), 取りこぼし %lu\n",
+                  (unsigned long)stats.windows, lipSync.cpuPercent(),
+                  (unsigned long)stats.maxBusyUs, (unsigned long)stats.dropped);
+}
+
 // =============================================================================
 // アイドル動作
 // =============================================================================
@@ -419,18 +1269,32 @@ void handleDebugCommand(String cmd) {
     Serial.println(cmd);
 
     if (cmd == "hello") {
+        startSpeechTiming("一括");
         speakWithVoicevox("こんにちはナリ！ワガハイはコロ助ナリ！");
     }
     else if (cmd == "walk") {
-        // 歩行開始
+        // 歩行開始（下半身への送信は上半身が中継する）
         WalkData_t walkData;
         walkData.mode = WALK_FORWARD;
         walkData.speed = 50;
         walkData.direction = 0;
-        // 下半身への送信は上半身経由で
+        sendCommandToUpper(CMD_WALK_START, nullptr, 0);
+        sendCommandToUpper(CMD_WALK_DIRECTION, (uint8_t*)&walkData, sizeof(walkData));
     }
     else if (cmd == "stop") {
         // 歩行停止
+        sendCommandToUpper(CMD_WALK_STOP, nullptr, 0);
+    }
+    else if (cmd == "center") {
+        // 全サーボを中心位置へ（サーボフレーム）
+        uint8_t angles[SERVO_FRAME_CHANNELS];
+        memset(angles, SERVO_CENTER_ANGLE, sizeof(angles));
+        angles[SERVO_EYELID_RIGHT] = EYELID_OPEN;
+        angles[SERVO_EYELID_LEFT] = EYELID_OPEN;
+        sendServoFrame(BODY_UPPER, angles, 0);
+
+        memset(angles, SERVO_CENTER_ANGLE, sizeof(angles));
+        sendServoFrame(BODY_LOWER, angles, 0);
     }
     else if (cmd == "wave") {
         uint8_t dummy = 0;
@@ -459,11 +1323,45 @@ void handleDebugCommand(String cmd) {
     }
     else if (cmd.startsWith("say ")) {
         String text = cmd.substring(4);
-        // LLMに送信して応答を得る
+
+        // 常時接続があればそちらで（応答は LINK_MSG_REPLY / LINK_MSG_PLAY で届く）
+        if (serverLinkConnected) {
+            startSpeechTiming("WebSocket");
+            if (sendToServer(LINK_MSG_CHAT, text.c_str(), text.length())) return;
+        }
+
+        // LLMに送信して応答を得る（応答全体 → 全文を合成 → 再生）
+        startSpeechTiming("一括");
         String response = sendToLLM(text);
         Serial.println("コロ助: " + response);
         speakWithVoicevox(response);
     }
+    else if (cmd.startsWith("talk ")) {
+        // 文ごとに合成しながら再生（最初の文ができた時点で話し始める）
+        talkStreaming(cmd.substring(5));
+    }
+    else if (cmd.startsWith("balance ")) {
+        // balance <pitch|roll> <Kp> <Ki> <Kd> [上限(度)] / balance <pitch|roll> off
+        char axisName[8] = {0};
+        float kp = 0.0f, ki = 0.0f, kd = 0.0f, limit = BALANCE_LIMIT_DEG;
+        int fields = sscanf(cmd.c_str() + 8, "%7s %f %f %f %f", axisName, &kp, &ki, &kd, &limit);
+        bool off = cmd.endsWith(" off");
+        BalanceGainsData_t gains;
+        memset(&gains, 0, sizeof(gains));
+        gains.axis = strcmp(axisName, "roll") == 0 ? 1 : 0;     // 0: ピッチ 1: ロール
+        if (fields < 1 || (strcmp(axisName, "pitch") != 0 && strcmp(axisName, "roll") != 0) ||
+            (!off && fields < 4)) {
+            Serial.println("使い方: balance <pitch|roll> <Kp> <Ki> <Kd> [上限] または balance <pitch|roll> off");
+            return;
+        }
+        gains.enabled = off ? 0 : 1;
+        gains.kp_milli = (uint16_t)constrain(kp * 1000.0f, 0.0f, 65535.0f);
+        gains.ki_milli = (uint16_t)constrain(ki * 1000.0f, 0.0f, 65535.0f);
+        gains.kd_milli = (uint16_t)constrain(kd * 1000.0f, 0.0f, 65535.0f);
+        gains.d_cutoff_dhz = (uint16_t)(BALANCE_D_CUTOFF_HZ * 10.0f);
+        gains.limit_ddeg = (uint16_t)constrain(limit * 10.0f, 0.0f, 900.0f);
+        sendCommandToUpper(CMD_BALANCE_GAINS, (uint8_t*)&gains, sizeof(gains));
+    }
     else if (cmd == "status") {
         Serial.println("=== コロ助ステータス ===");
         Serial.print("WiFi: ");
@@ -472,17 +1370,37 @@ void handleDebugCommand(String cmd) {
         Serial.println(WiFi.localIP());
         Serial.print("人物検知: ");
         Serial.println(personDetected ? "あり" : "なし");
+        reportServerLink();
+        reportUpperLink();
+        reportVision();
+        reportMic();
+        reportLipsync();
+        traceReport(tracer);
+        schedulerReport(scheduler);
         Serial.println("========================");
     }
+    else if (cmd == "trace") {
+        // このボードは起動からの分布、上半身・下半身は前回からの分布を届いたら表示
+        traceReport(tracer);
+        traceEchoMs = millis();
+        uint8_t kind = STATUS_TRACE;
+        sendCommandToUpper(CMD_STATUS, &kind, 1);
+    }
     else {
         Serial.println("使用可能なコマンド:");
         Serial.println("  hello    - 挨拶");
         Serial.println("  wave     - 手を振る");
+        Serial.println("  center   - 全サーボを中心に");
+        Serial.println("  walk     - 前へ歩く");
+        Serial.println("  stop     - 歩行停止");
         Serial.println("  happy    - 嬉しい表情");
         Serial.println("  sad      - 悲しい表情");
         Serial.println("  surprised - 驚き");
         Serial.println("  say <text> - LLMと会話");
+        Serial.println("  talk <text> - LLMと会話（ストリーミング）");
+        Serial.println("  balance <pitch|roll> <Kp> <Ki> <Kd> - バランスゲイン変更（off で無効）");
         Serial.println("  status   - ステータス表示");
+        Serial.println("  trace    - 処理時間の分布（上半身・下半身の分も）");
     }
 }
 
@@ -494,11 +1412,26 @@ void audio_info(const char* info) {
     Serial.println(info);
 }
 
+// デコード済み PCM（I2S へ書く直前）。validSamples はチャンネルあたりのフレーム数
+void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample,
+                       uint8_t channels, bool* continueI2S) {
+    *continueI2S = true;    // 音声はそのまま I2S へ
+    if (!isSpeaking || bitsPerSample != 16 || channels == 0) return;
+
+    if (speechFirstAudioPending) {
+        speechFirstAudioPending = false;
+        speechFirstAudioMs = millis();
+    }
+
+    lipSync.setSampleRate(audio.getSampleRate());
+    lipSync.process(outBuff, validSamples, channels);
+}
+
 void audio_eof_mp3(const char* info) {
-    Serial.println("再生完了");
-    isSpeaking = false;
+    finishSpeaking();
+}
 
-    // 発話終了を上半身に通知
-    uint8_t dummy = 0;
-    sendCommandToUpper(CMD_SPEAK_STOP, &dummy, 1);
+// HTTP の音声（/speak の WAV、/chat_stream のストリーム）はこちら
+void audio_eof_stream(const char* info) {
+    finishSpeaking();
 }
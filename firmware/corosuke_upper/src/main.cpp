@@ -4,11 +4,14 @@
  *
  * 機能:
  * - 目の制御（8軸: 左右上下 + まばたき）
+ * - 視線の制御（目と首へ振り分け、目標の動きを予測して追う）
  * - 口の制御（2軸: 上下）
  * - 首の制御（2軸: ヨー・ピッチ）
  * - 腕の制御（4軸: 肩・肘 x2）
- * - LED目の制御（WS2812B）
+ * - LED目の制御（WS2812B。変わったフレームだけを core 0 の出力タスクが送る）
+ * - 表情（基本の表情・一時的な表情・発話・まばたきのレイヤーを毎 tick 混ぜる）
  * - リップシンク
+ * - 腕のジェスチャー（キーフレームアニメーション）
  */
 
 #include <Arduino.h>
@@ -19,6 +22,21 @@
 // 共通ヘッダー
 #include "../../common/config.h"
 #include "../../common/protocol.h"
+#include "../../common/packet_parser.h"
+#include "../../common/reliable_link.h"
+#include "../../common/link_speed.h"
+#include "../../common/packet_router.h"
+#include "../../common/servo_frame.h"
+#include "../../common/servo_output.h"
+#include "../../common/joint_table.h"
+#include "../../common/animation.h"
+#include "../../common/trajectory.h"
+#include "../../common/led_eyes.h"
+#include "../../common/expression_mixer.h"
+#include "../../common/gaze_controller.h"
+#include "../../common/spsc_queue.h"
+#include "../../common/trace.h"
+#include "../../common/scheduler.h"
 
 // =============================================================================
 // グローバル変数
@@ -27,45 +45,155 @@
 // サーボドライバ
 Adafruit_PWMServoDriver pwm = Adafruit_PWMServoDriver(I2C_ADDR_PCA9685_UPPER);
 
-// LED目
+// サーボ出力（変化したチャンネルを tick ごとにまとめて書く）
+ServoOutput servoOut(I2C_ADDR_PCA9685_UPPER);
+
+// LED目（FastLED のバッファは出力タスクだけが触る）
 CRGB ledsRight[LED_EYE_NUM_LEDS];
 CRGB ledsLeft[LED_EYE_NUM_LEDS];
 
-// サーボ現在位置
-uint8_t servoPositions[16];
-
-// 表情状態
-Expression_t currentExpression = EXPR_NEUTRAL;
+// LED目の出力タスク（show() の転送中も loop() を止めない）
+#define LED_TASK_CORE           0           // loop() は core 1
+#define LED_TASK_PRIORITY       1
+#define LED_TASK_STACK          2048
+#define LED_TASK_POLL_MS        5           // 新しいフレームを見に行く周期
+
+LedEyeRenderer ledEyes;
+SpscQueue<LedEyeFrame_t, 2> ledQueue;       // loop() が描いたフレーム → 出力タスク
+
+// 処理時間の計測（LED目の転送は出力タスク、それ以外は loop() が書く）
+Tracer tracer;
+uint32_t ledShows = 0;                      // 出力タスク側だけが更新
+TaskHandle_t ledTaskHandle = nullptr;
+
+// 最後に書いたサーボ角（LED目の瞳・まぶたが追う）
+float servoAngles[16];
+
+// ベース姿勢の目標（アニメーションを重ねる前）。servoTrajectory が時間をかけて servoBase を動かす
+float servoBase[16];
+TrajectoryPlanner servoTrajectory;
+
+// キーフレームアニメーション（サーボ更新 tick で進める）
+AnimationEngine animation;
+AnimClipBuffer pointClip;
+AnimClipBuffer armClip;
+
+// 表情（サーボ更新 tick で混ぜ、変わった顔のチャンネルだけ軌道を引き直す）
+ExpressionMixer expressions;
+ExpressionOutput_t faceOut;
+bool faceOutValid = false;
+uint8_t gazeSpeed = 0;          // 最後の視線コマンドの速度（0 = 速度上限いっぱい）
+
+// 視線（注視点のサンプルを受け取り、サーボ更新 tick で目と首へ振り分ける）
+GazeController gaze;
+GazeOutput_t gazeOut;
+bool gazeOutValid = false;
 uint8_t blinkCounter = 0;
 bool isBlinking = false;
 
 // 口の状態
-uint8_t mouthOpenAmount = 0;
 bool isSpeaking = false;
 
-// タイミング
-unsigned long lastServoUpdate = 0;
-unsigned long lastBlinkCheck = 0;
-unsigned long lastExpressionUpdate = 0;
+// loop() の周期ジョブ（優先度は大きいほど先）
+#define JOB_PRIORITY_SERVO      4
+#define JOB_PRIORITY_UART       3
+#define JOB_PRIORITY_LED        2
+#define JOB_PRIORITY_FACE       1       // まばたき・アイドルアニメーション
+#define JOB_PRIORITY_REPORT     0
+#define BLINK_CHECK_MS          100
+Scheduler scheduler;
+
+// UART受信パーサー（メインボードからの v1/v2 フレーム）
+PacketParser uartParser;
+ReliableLink mainLink;
+LinkSpeed mainSpeed;        // メインが交渉を始め、こちらは答える
+unsigned long lastUartRx = 0;
+
+// 下半身との UART（こちらが交渉を始める側。受信はセンサーデータ・ボーレート交渉・ステータス応答）
+PacketParser lowerParser;
+LinkSpeed lowerSpeed;
+unsigned long lastLowerRx = 0;
+
+// 中継（メイン → 下半身の動作コマンド・サーボフレーム、下半身 → メインのセンサーデータ）
+PacketRouter lowerRouter;
+PacketRouter mainRouter;
+
+// 下半身への確実に届けるコマンド（SEQ を付け直して再送する。下半身が並べ替えて ACK/NACK を返す）。
+// フレームは lowerRouter の待ち行列を通るので、再送も優先度どおりに並ぶ
+ReliableLink lowerLink;
+RoutedOutput<HardwareSerial> lowerOut(lowerRouter, Serial2);
+uint32_t lowerRouteDeferred = 0;    // lowerLink の送信待ちが一杯で受け取りを見送った確実なコマンド
+
+// サーボフレーム（次のサーボ更新でまとめて適用）
+ServoFrameReceiver servoFrame(BODY_UPPER);
 
-// UART受信バッファ
-uint8_t uartBuffer[PACKET_MAX_SIZE];
-uint8_t uartIndex = 0;
+// =============================================================================
+// ジェスチャー
+// =============================================================================
+#define ANIM_LAYER_GESTURE        1       // 手を振る・指差し・腕の位置
+#define GESTURE_FADE_MS           250     // ベース姿勢との切り替え時間
+#define WAVE_DEFAULT_COUNT        3
+#define POINT_MOVE_MS             400     // 腕を上げるまでの時間
+#define POINT_DEFAULT_HOLD_MS     1500
+#define ARM_DEFAULT_DURATION_MS   500
+
+// 手を振る: 右肩 45↔135 度を 600ms 周期で、肘は少し曲げる
+static const AnimKey_t waveShoulderKeys[] = {
+    {  0,  45, EASE_IN_OUT},
+    {300, 135, EASE_IN_OUT},
+    {600,  45, EASE_IN_OUT},
+};
+static const AnimKey_t waveElbowKeys[] = {
+    {  0,  60, EASE_LINEAR},
+};
+static const AnimTrack_t waveTracks[] = {
+    {SERVO_ARM_RIGHT_SHOULDER, 3, waveShoulderKeys},
+    {SERVO_ARM_RIGHT_ELBOW,    1, waveElbowKeys},
+};
+static const AnimClip_t waveClip = {600, 2, waveTracks};
 
 // =============================================================================
 // 関数プロトタイプ
 // =============================================================================
 void initServos();
 void initLEDs();
-void setServoAngle(uint8_t channel, uint8_t angle);
-void setEyePosition(int8_t x, int8_t y);
+void setServoAngle(uint8_t channel, uint8_t angle, uint16_t durationMs = 0, uint8_t speed = 0);
+void setEyePosition(int8_t x, int8_t y, uint8_t speed = 0);
 void setBlink(bool closed);
 void setMouthOpen(uint8_t amount);
-void setExpression(Expression_t expr);
+void setExpression(Expression_t expr, uint8_t intensity = 100, uint16_t durationMs = 0);
+void updateExpression(unsigned long now);
+void updateGaze(unsigned long now);
+void reportGaze();
 void updateIdleAnimation();
-void processCommand(uint8_t cmd, uint8_t* data, uint8_t length);
+void processCommand(uint8_t cmd, const uint8_t* data, uint8_t length);
 void handleUART();
-void updateLEDEyes();
+void dispatchPacket(const PacketView_t& packet);
+bool routedToLower(const PacketView_t& packet);
+bool lowerRouteHasRoom(const PacketView_t& packet);
+bool lowerRouteHasRoom();
+void handleLowerUART();
+void routeToLower(const PacketView_t& packet);
+void sendStatus();
+void sendTraceStatus();
+void reportServoBus();
+void reportMainLink();
+void requestLowerStatus();
+void jobServo();
+void jobUART();
+void jobLEDEyes();
+void jobBlink();
+void jobIdleAnimation();
+void jobReport();
+void renderLEDEyes(unsigned long now);
+void ledTask(void* parameter);
+void reportLEDEyes();
+void applyServoFrame();
+void writeServo(uint8_t channel, float angle);
+void updateAnimation(unsigned long now);
+void playWave(uint8_t count);
+void playPoint(int8_t x, int8_t y, uint16_t holdMs);
+void playArmPosition(const ArmPositionData_t* arm);
 
 // =============================================================================
 // セットアップ
@@ -77,12 +205,23 @@ void setup() {
     Serial.println("  コロ助 上半身コントローラー");
     Serial.println("  Corosuke Upper Body v1.0");
     Serial.println("=================================");
+    tracer.begin(TRACE_BOARD_UPPER);
 
-    // メインボードとのUART
+    // メインボードとのUART（ボーレートはメインからの交渉で上がる）
+    Serial1.setRxBufferSize(UART_RX_BUFFER_SIZE);
+    Serial1.setTxBufferSize(UART_TX_BUFFER_SIZE);
     Serial1.begin(UART_BAUD_RATE, SERIAL_8N1, 4, 5);  // RX=4, TX=5
+    mainLink.reset((uint8_t)esp_random());
+    mainSpeed.begin(false, UART_BAUD_RATE, UART_MAIN_BAUD_MAX, millis());
+    mainRouter.begin(UART_TX_BUFFER_SIZE + UART_HW_FIFO_SIZE);
 
     // 下半身ボードとのUART
+    Serial2.setRxBufferSize(UART_RX_BUFFER_SIZE);
+    Serial2.setTxBufferSize(UART_TX_BUFFER_SIZE);
     Serial2.begin(UART_BAUD_RATE, SERIAL_8N1, UART_UPPER_TO_LOWER_RX, UART_UPPER_TO_LOWER_TX);
+    lowerSpeed.begin(true, UART_BAUD_RATE, UART_LOWER_BAUD_MAX, millis());
+    lowerRouter.begin(UART_TX_BUFFER_SIZE + UART_HW_FIFO_SIZE);
+    lowerLink.reset((uint8_t)esp_random());
 
     // I2C初期化
     Wire.begin();
@@ -94,69 +233,125 @@ void setup() {
     initLEDs();
 
     // 初期姿勢
-    setExpression(EXPR_NEUTRAL);
+    expressions.begin(millis());
 
     Serial.println("初期化完了ナリ！");
+
+    // 周期ジョブ（LED目はサーボ更新と同じ周期なので半周期ずらす）
+    scheduler.begin();
+    scheduler.add("servo", jobServo, SERVO_UPDATE_INTERVAL_MS * 1000UL, JOB_PRIORITY_SERVO,
+                  SERVO_TICK_DEADLINE_MS * 1000UL);
+    scheduler.add("uart", jobUART, UART_POLL_MS * 1000UL, JOB_PRIORITY_UART, UART_POLL_DEADLINE_MS * 1000UL);
+    scheduler.add("led", jobLEDEyes, LED_FRAME_MS * 1000UL, JOB_PRIORITY_LED, 0, LED_FRAME_MS * 500UL);
+    scheduler.add("blink", jobBlink, BLINK_CHECK_MS * 1000UL, JOB_PRIORITY_FACE);
+    scheduler.add("idle_anim", jobIdleAnimation, EXPRESSION_UPDATE_MS * 1000UL, JOB_PRIORITY_FACE);
+    scheduler.add("report", jobReport, SERVO_BUS_REPORT_MS * 1000UL, JOB_PRIORITY_REPORT, 0,
+                  SERVO_BUS_REPORT_MS * 1000UL);
 }
 
 // =============================================================================
 // メインループ
 // =============================================================================
 void loop() {
-    unsigned long now = millis();
+    {
+        TraceScope trace(tracer, TRACE_LOOP);
+        scheduler.runDue();
+    }
+    scheduler.sleepUntilDue();
+}
 
-    // UART受信処理
+// UART受信処理
+void jobUART() {
+    TraceScope trace(tracer, TRACE_UART);
     handleUART();
+    handleLowerUART();
+}
 
-    // サーボ更新 (50Hz)
-    if (now - lastServoUpdate >= SERVO_UPDATE_INTERVAL_MS) {
-        lastServoUpdate = now;
-        // スムーズな動きのための補間処理があればここに
-    }
+// サーボ更新 (50Hz)
+void jobServo() {
+    TraceScope trace(tracer, TRACE_SERVO_TICK);
+    unsigned long now = millis();
+    applyServoFrame();
+    updateGaze(now);
+    updateExpression(now);
+    updateAnimation(now);
+    TraceScope writeTrace(tracer, TRACE_SERVO_WRITE);
+    servoOut.flush();
+}
 
-    // まばたき処理 (ランダム間隔)
-    if (now - lastBlinkCheck >= 100) {
-        lastBlinkCheck = now;
-        blinkCounter++;
-
-        // 約3-5秒ごとにまばたき
-        if (!isBlinking && blinkCounter > random(30, 50)) {
-            isBlinking = true;
-            setBlink(true);
-            blinkCounter = 0;
-        } else if (isBlinking && blinkCounter > 2) {
-            isBlinking = false;
-            setBlink(false);
-            blinkCounter = 0;
-        }
-    }
+// LED目（変わったときだけ出力タスクへ）
+void jobLEDEyes() {
+    renderLEDEyes(millis());
+}
 
-    // アイドルアニメーション
-    if (now - lastExpressionUpdate >= EXPRESSION_UPDATE_MS) {
-        lastExpressionUpdate = now;
-        updateIdleAnimation();
-        updateLEDEyes();
+// まばたき処理 (ランダム間隔)
+void jobBlink() {
+    blinkCounter++;
+
+    // 約3-5秒ごとにまばたき
+    if (!isBlinking && blinkCounter > random(30, 50)) {
+        isBlinking = true;
+        setBlink(true);
+        blinkCounter = 0;
+    } else if (isBlinking && blinkCounter > 2) {
+        isBlinking = false;
+        setBlink(false);
+        blinkCounter = 0;
     }
 }
 
+// アイドルアニメーション
+void jobIdleAnimation() {
+    updateIdleAnimation();
+}
+
+// サーボI2Cバス時間などの報告
+void jobReport() {
+    reportServoBus();
+    reportLEDEyes();
+    reportGaze();
+    traceReport(tracer);
+    reportMainLink();
+    schedulerReport(scheduler);
+    requestLowerStatus();
+}
+
 // =============================================================================
 // サーボ初期化
 // =============================================================================
 void initServos() {
     pwm.begin();
-    pwm.setPWMFreq(50);  // 50Hz for servos
+    pwm.setOscillatorFrequency(PCA9685_OSC_HZ);
+    pwm.setPWMFreq(SERVO_PWM_HZ);  // 50Hz for servos
+    if (!servoOut.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_CLOCK_UPPER_HZ)) {
+        Serial.println("PCA9685が応答しないナリ！");
+    }
 
     delay(10);
 
-    // 全サーボを中心位置に
-    for (int i = 0; i < 16; i++) {
-        servoPositions[i] = SERVO_CENTER_ANGLE;
-        setServoAngle(i, SERVO_CENTER_ANGLE);
+    // 関節ごとの速度・加速度の上限
+    for (uint8_t ch = SERVO_EYE_RIGHT_H; ch <= SERVO_EYE_LEFT_V; ch++) {
+        servoTrajectory.setLimits(ch, TRAJ_EYE_MAX_VEL, TRAJ_EYE_MAX_ACC);
+    }
+    servoTrajectory.setLimits(SERVO_EYELID_RIGHT, TRAJ_EYELID_MAX_VEL, TRAJ_EYELID_MAX_ACC);
+    servoTrajectory.setLimits(SERVO_EYELID_LEFT, TRAJ_EYELID_MAX_VEL, TRAJ_EYELID_MAX_ACC);
+    servoTrajectory.setLimits(SERVO_MOUTH_UPPER, TRAJ_MOUTH_MAX_VEL, TRAJ_MOUTH_MAX_ACC);
+    servoTrajectory.setLimits(SERVO_MOUTH_LOWER, TRAJ_MOUTH_MAX_VEL, TRAJ_MOUTH_MAX_ACC);
+    servoTrajectory.setLimits(SERVO_NECK_YAW, TRAJ_NECK_MAX_VEL, TRAJ_NECK_MAX_ACC);
+    servoTrajectory.setLimits(SERVO_NECK_PITCH, TRAJ_NECK_MAX_VEL, TRAJ_NECK_MAX_ACC);
+    for (uint8_t ch = SERVO_ARM_RIGHT_SHOULDER; ch <= SERVO_ARM_LEFT_ELBOW; ch++) {
+        servoTrajectory.setLimits(ch, TRAJ_ARM_MAX_VEL, TRAJ_ARM_MAX_ACC);
     }
 
-    // まぶたを開く
-    setServoAngle(SERVO_EYELID_RIGHT, EYELID_OPEN);
-    setServoAngle(SERVO_EYELID_LEFT, EYELID_OPEN);
+    // 全サーボを中心位置に（まぶたは開く）
+    for (int i = 0; i < 16; i++) {
+        uint8_t angle = SERVO_CENTER_ANGLE;
+        if (i == SERVO_EYELID_RIGHT || i == SERVO_EYELID_LEFT) angle = EYELID_OPEN;
+        servoBase[i] = angle;
+        servoTrajectory.snap(i, angle);
+        writeServo(i, angle);
+    }
+    servoOut.flush();
 
     Serial.println("サーボ初期化完了");
 }
@@ -179,134 +374,128 @@ void initLEDs() {
 
     FastLED.show();
 
+    // 色は表情ミキサーがサーボ更新 tick ごとに決める
+    ledEyes.begin(CRGB::Black);
+    if (xTaskCreatePinnedToCore(ledTask, "led", LED_TASK_STACK, nullptr,
+                                LED_TASK_PRIORITY, &ledTaskHandle, LED_TASK_CORE) != pdPASS) {
+        Serial.println("LED出力タスクを起動できないナリ！");
+    }
+
     Serial.println("LED初期化完了");
 }
 
 // =============================================================================
-// サーボ角度設定
+// サーボ角度設定（ベース姿勢の目標。サーボ更新 tick で durationMs かけて動く）
+// durationMs 0 = 関節の速度上限でいちばん速く、speed (1-100) は速度上限に対する割合
 // =============================================================================
-void setServoAngle(uint8_t channel, uint8_t angle) {
+void setServoAngle(uint8_t channel, uint8_t angle, uint16_t durationMs, uint8_t speed) {
     if (channel >= 16 || angle > 180) return;
 
-    // 角度をパルス幅に変換
-    uint16_t pulse = map(angle, 0, 180, SERVO_MIN_PULSE, SERVO_MAX_PULSE);
-    // パルス幅を12ビット値に変換 (4096段階、20ms周期)
-    uint16_t pwmValue = (uint16_t)((pulse * 4096L) / 20000L);
+    if (speed != 0) {
+        servoTrajectory.moveAtSpeed(channel, angle, millis(), speed);
+    } else {
+        servoTrajectory.moveTo(channel, angle, millis(), durationMs);
+    }
+}
+
+// =============================================================================
+// サーボ出力（次の flush() で書き込む）
+// =============================================================================
+void writeServo(uint8_t channel, float angle) {
+    if (channel >= 16) return;
 
-    pwm.setPWM(channel, 0, pwmValue);
-    servoPositions[channel] = angle;
+    // 可動範囲への丸めと 1/16 度単位でのカウントへの変換は関節テーブルで
+    servoAngles[channel] = angle;
+    servoOut.set(channel, jointTicks(UPPER_JOINTS[channel], jointAngleQ(angle)));
 }
 
 // =============================================================================
-// 目の位置設定
+// 目の位置設定（注視点。目の範囲を超える分は首も向ける）
 // =============================================================================
-void setEyePosition(int8_t x, int8_t y) {
-    // x: -50〜50 (左〜右)
+void setEyePosition(int8_t x, int8_t y, uint8_t speed) {
+    // x: -50〜50 (左〜右、目と首を合わせた範囲)
     // y: -50〜50 (下〜上)
+    x = constrain(x, -50, 50);
+    y = constrain(y, -50, 50);
+    gaze.setTarget(x * (GAZE_YAW_RANGE / 50.0f), y * (GAZE_PITCH_RANGE / 50.0f), millis());
+    gazeSpeed = speed;
+}
 
-    uint8_t hAngle = map(constrain(x, -50, 50), -50, 50, EYE_H_MIN, EYE_H_MAX);
-    uint8_t vAngle = map(constrain(y, -50, 50), -50, 50, EYE_V_MIN, EYE_V_MAX);
-
-    // 両目を同じ方向に
-    setServoAngle(SERVO_EYE_RIGHT_H, hAngle);
-    setServoAngle(SERVO_EYE_LEFT_H, hAngle);
-    setServoAngle(SERVO_EYE_RIGHT_V, vAngle);
-    setServoAngle(SERVO_EYE_LEFT_V, vAngle);
+// =============================================================================
+// 視線の更新（サーボ更新 tick 内、表情より前。目と首ピッチは表情ミキサーで表情の分と足す）
+// =============================================================================
+void updateGaze(unsigned long now) {
+    GazeOutput_t out;
+    gaze.update(now, &out);
+    expressions.setGaze(out.eyeYaw, out.eyePitch, out.neckPitch);
+    if (!gazeOutValid || out.neckYaw != gazeOut.neckYaw) {
+        servoTrajectory.moveTo(SERVO_NECK_YAW, SERVO_CENTER_ANGLE + out.neckYaw, now);
+    }
+    gazeOut = out;
+    gazeOutValid = true;
 }
 
 // =============================================================================
 // まばたき
 // =============================================================================
 void setBlink(bool closed) {
-    uint8_t angle = closed ? EYELID_CLOSE : EYELID_OPEN;
-    setServoAngle(SERVO_EYELID_RIGHT, angle);
-    setServoAngle(SERVO_EYELID_LEFT, angle);
+    expressions.setBlink(closed, millis());
 }
 
 // =============================================================================
-// 口の開閉
+// 口の開閉（発話レイヤー。CMD_SPEAK_STOP で表情の口へ戻る）
 // =============================================================================
 void setMouthOpen(uint8_t amount) {
     // amount: 0-100
-    mouthOpenAmount = constrain(amount, 0, 100);
-
-    uint8_t angle = map(mouthOpenAmount, 0, 100, MOUTH_CLOSED, MOUTH_OPEN);
-    setServoAngle(SERVO_MOUTH_LOWER, angle);
-    // 上唇は固定か、少し動かす
-    setServoAngle(SERVO_MOUTH_UPPER, MOUTH_CLOSED - (angle - MOUTH_CLOSED) / 3);
+    expressions.setSpeech(amount, millis());
 }
 
 // =============================================================================
-// 表情設定
+// 表情設定（durationMs 0 = 基本の表情、それ以外 = その時間だけ出して基本の表情へ戻る）
 // =============================================================================
-void setExpression(Expression_t expr) {
-    currentExpression = expr;
-
-    switch (expr) {
-        case EXPR_NEUTRAL:
-            setEyePosition(0, 0);
-            setBlink(false);
-            setMouthOpen(0);
-            break;
-
-        case EXPR_HAPPY:
-            setEyePosition(0, 10);
-            // まぶたを少し下げて笑顔に
-            setServoAngle(SERVO_EYELID_RIGHT, EYELID_OPEN + 20);
-            setServoAngle(SERVO_EYELID_LEFT, EYELID_OPEN + 20);
-            setMouthOpen(30);
-            break;
+void setExpression(Expression_t expr, uint8_t intensity, uint16_t durationMs) {
+    if (expr >= EXPR_COUNT) return;
 
-        case EXPR_SAD:
-            setEyePosition(0, -20);
-            setServoAngle(SERVO_EYELID_RIGHT, EYELID_OPEN + 30);
-            setServoAngle(SERVO_EYELID_LEFT, EYELID_OPEN + 30);
-            setMouthOpen(10);
-            break;
-
-        case EXPR_SURPRISED:
-            setEyePosition(0, 20);
-            // まぶた全開
-            setServoAngle(SERVO_EYELID_RIGHT, EYELID_OPEN - 10);
-            setServoAngle(SERVO_EYELID_LEFT, EYELID_OPEN - 10);
-            setMouthOpen(80);
-            break;
-
-        case EXPR_ANGRY:
-            setEyePosition(0, -10);
-            // まぶたを下げて怒り顔
-            setServoAngle(SERVO_EYELID_RIGHT, EYELID_OPEN + 40);
-            setServoAngle(SERVO_EYELID_LEFT, EYELID_OPEN + 40);
-            setMouthOpen(20);
-            break;
-
-        case EXPR_SLEEPY:
-            setEyePosition(0, -30);
-            setServoAngle(SERVO_EYELID_RIGHT, EYELID_OPEN + 50);
-            setServoAngle(SERVO_EYELID_LEFT, EYELID_OPEN + 50);
-            setMouthOpen(10);
-            break;
-
-        case EXPR_THINKING:
-            setEyePosition(30, 20);  // 右上を見る
-            setBlink(false);
-            setMouthOpen(5);
-            break;
-
-        case EXPR_EXCITED:
-            setEyePosition(0, 15);
-            setBlink(false);
-            setMouthOpen(50);
-            break;
-
-        default:
-            break;
+    if (durationMs == 0) {
+        expressions.setMood(expr, intensity, millis());
+    } else {
+        expressions.react(expr, intensity, durationMs, millis());
     }
 
     Serial.print("表情変更: ");
     Serial.println(expr);
 }
 
+// =============================================================================
+// 表情の反映（サーボ更新 tick 内、軌道の update() の前）
+// 変わったチャンネルだけ引き直すので、サーボフレームで動かした顔のチャンネルは次に表情が変わるまでそのまま
+// =============================================================================
+static void moveFace(uint8_t channel, float angle, float previous, unsigned long now, uint8_t speed = 0) {
+    if (faceOutValid && angle == previous) return;
+    servoTrajectory.moveAtSpeed(channel, angle, now, speed);
+}
+
+void updateExpression(unsigned long now) {
+    ExpressionOutput_t face;
+    expressions.evaluate(now, &face);
+
+    moveFace(SERVO_EYE_RIGHT_H, face.eyeH, faceOut.eyeH, now, gazeSpeed);
+    moveFace(SERVO_EYE_LEFT_H, face.eyeH, faceOut.eyeH, now, gazeSpeed);
+    moveFace(SERVO_EYE_RIGHT_V, face.eyeV, faceOut.eyeV, now, gazeSpeed);
+    moveFace(SERVO_EYE_LEFT_V, face.eyeV, faceOut.eyeV, now, gazeSpeed);
+    moveFace(SERVO_EYELID_RIGHT, face.eyelid, faceOut.eyelid, now);
+    moveFace(SERVO_EYELID_LEFT, face.eyelid, faceOut.eyelid, now);
+    moveFace(SERVO_MOUTH_UPPER, face.mouthUpper, faceOut.mouthUpper, now);
+    moveFace(SERVO_MOUTH_LOWER, face.mouthLower, faceOut.mouthLower, now);
+    moveFace(SERVO_NECK_PITCH, face.neckPitch, faceOut.neckPitch, now);
+
+    if (!faceOutValid || face.red != faceOut.red || face.green != faceOut.green || face.blue != faceOut.blue) {
+        ledEyes.setColor(CRGB(face.red, face.green, face.blue), now, 0);
+    }
+    faceOut = face;
+    faceOutValid = true;
+}
+
 // =============================================================================
 // アイドルアニメーション
 // =============================================================================
@@ -315,7 +504,7 @@ void updateIdleAnimation() {
     static int8_t idleEyeY = 0;
     static uint8_t idleCounter = 0;
 
-    if (!isSpeaking && currentExpression == EXPR_NEUTRAL) {
+    if (!isSpeaking && expressions.expression() == EXPR_NEUTRAL) {
         idleCounter++;
 
         // たまに視線を動かす
@@ -329,39 +518,38 @@ void updateIdleAnimation() {
 }
 
 // =============================================================================
-// LED目の更新
+// LED目の描画（LED_FRAME_MS ごと。前回と同じフレームなら出力しない）
 // =============================================================================
-void updateLEDEyes() {
-    // 表情に応じてLEDの色を変更
-    CRGB eyeColor = CRGB::Black;
-
-    switch (currentExpression) {
-        case EXPR_HAPPY:
-        case EXPR_EXCITED:
-            eyeColor = CRGB(255, 200, 100);  // 暖かい色
-            break;
-        case EXPR_SAD:
-            eyeColor = CRGB(100, 100, 255);  // 青っぽい
-            break;
-        case EXPR_ANGRY:
-            eyeColor = CRGB(255, 50, 50);    // 赤
-            break;
-        default:
-            eyeColor = CRGB(200, 200, 200);  // 白
-            break;
+void renderLEDEyes(unsigned long now) {
+    const LedEyePose_t poses[LED_EYES] = {
+        {servoAngles[SERVO_EYE_RIGHT_H], servoAngles[SERVO_EYE_RIGHT_V], servoAngles[SERVO_EYELID_RIGHT]},
+        {servoAngles[SERVO_EYE_LEFT_H], servoAngles[SERVO_EYE_LEFT_V], servoAngles[SERVO_EYELID_LEFT]},
+    };
+    // 出力タスクが前のフレームをまだ受け取っていなければ、次の周期に描き直して渡す
+    if (ledEyes.render(now, poses) && ledQueue.push(ledEyes.frame())) {
+        ledEyes.commit();
     }
+}
 
-    // 瞳のハイライト以外を設定
-    for (int i = 1; i < LED_EYE_NUM_LEDS; i++) {
-        ledsRight[i] = eyeColor;
-        ledsLeft[i] = eyeColor;
+// =============================================================================
+// LED目の出力タスク（core 0）。溜まっていたら最新のフレームだけを送る
+// =============================================================================
+void ledTask(void* parameter) {
+    (void)parameter;
+    LedEyeFrame_t frame;
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(LED_TASK_POLL_MS));
+
+        bool fresh = false;
+        while (ledQueue.pop(&frame)) fresh = true;
+        if (!fresh) continue;
+
+        memcpy(ledsRight, frame.leds[LED_EYE_RIGHT], sizeof(ledsRight));
+        memcpy(ledsLeft, frame.leds[LED_EYE_LEFT], sizeof(ledsLeft));
+        TraceScope trace(tracer, TRACE_LED_SHOW);
+        FastLED.show();
+        ledShows++;
     }
-
-    // ハイライトは常に白
-    ledsRight[0] = CRGB::White;
-    ledsLeft[0] = CRGB::White;
-
-    FastLED.show();
 }
 
 // =============================================================================
@@ -369,39 +557,271 @@ void updateLEDEyes() {
 // =============================================================================
 void handleUART() {
     // メインボードからの受信
-    while (Serial1.available()) {
-        uint8_t b = Serial1.read();
+    if (uartParser.readFrom(Serial1) > 0) {
+        lastUartRx = millis();
+    } else if (uartParser.buffered() > 0 && millis() - lastUartRx >= UART_IDLE_RESYNC_MS) {
+        // 受信が途切れたまま未完成のパケットが残っている → 再同期
+        uartParser.resyncIfStalled();
+    }
 
-        if (uartIndex == 0 && b != PACKET_START) {
-            continue;  // スタートバイトを待つ
+    // v2 の確実に届けるコマンドは順番どおりに（抜けがあれば再送を待ってから）渡される
+    unsigned long now = millis();
+    lowerRouter.pump(Serial2, now);
+    PacketView_t packet;
+    while (uartParser.next(&packet)) {
+        if (!lowerRouteHasRoom(packet)) {
+            // mainLink に渡すと ACK してしまうので渡さない（メインが再送してくる）
+            lowerRouteDeferred++;
+            continue;
         }
+        if (mainLink.receive(Serial1, packet, now)) dispatchPacket(packet);
+        while (lowerRouteHasRoom() && mainLink.nextBuffered(&packet)) dispatchPacket(packet);
+    }
+    // 空き待ちで並べ替えバッファに残したもの
+    while (lowerRouteHasRoom() && mainLink.nextBuffered(&packet)) dispatchPacket(packet);
+    mainLink.poll(Serial1, now);
+    mainRouter.pump(Serial1, now);
+    mainSpeed.poll(Serial1, now, uartParser.stats(), mainLink.stats().txBytes + mainRouter.stats().bytes);
+}
 
-        uartBuffer[uartIndex++] = b;
-
-        // パケット完成チェック
-        if (uartIndex >= 4) {
-            uint8_t expectedLen = uartBuffer[1] + 4;  // length + header(2) + checksum + end
-            if (uartIndex >= expectedLen) {
-                if (uartBuffer[uartIndex - 1] == PACKET_END) {
-                    // パケット受信完了
-                    if (validatePacket(uartBuffer, uartIndex)) {
-                        processCommand(uartBuffer[2], &uartBuffer[3], uartBuffer[1] - 1);
-                    }
-                }
-                uartIndex = 0;
+void dispatchPacket(const PacketView_t& packet) {
+    // 下半身宛て（確実に届けるコマンドの ACK はここで受け取った時点で mainLink が返している。
+    //   その先は lowerLink が下半身の ACK まで再送する。lowerRouteHasRoom() で空きを確かめてから
+    //   渡しているので、lowerLink の送信待ちには必ず入る）
+    if (routedToLower(packet)) {
+        routeToLower(packet);
+        return;
+    }
+    switch (packet.cmd) {
+        case CMD_LINK_SPEED:
+            mainSpeed.receive(Serial1, packet, millis());
+            return;
+        case CMD_STATUS:
+            if (packet.length >= 1 && packet.data[0] == STATUS_TRACE) {
+                // 下半身の分は handleLowerUART() がメインへ中継する
+                sendTraceStatus();
+                routeToLower(packet);
+            } else {
+                sendStatus();
             }
+            return;
+        default:
+            processCommand(packet.cmd, packet.data, packet.length);
+            return;
+    }
+}
+
+// 下半身宛て: 動作コマンド (0x30-0x3F) と下半身のサーボフレーム
+bool routedToLower(const PacketView_t& packet) {
+    bool motion = packet.cmd >= CMD_WALK_START && packet.cmd <= 0x3F;
+    bool lowerFrame = (packet.cmd == CMD_SERVO_FRAME || packet.cmd == CMD_SERVO_FRAME_DELTA) &&
+                      packet.length >= 1 && packet.data[0] == BODY_LOWER;
+    return motion || lowerFrame;
+}
+
+// 下半身へ回す確実なコマンドは、lowerLink の送信待ちに空きがあるときだけ受け取る。
+// 受け取ってから入らないと ACK 済みのまま消える（歩行停止が届かない）ので、ACK せずにメインの再送を待つ
+bool lowerRouteHasRoom(const PacketView_t& packet) {
+    if (packet.version != 2 || !(packet.ctrl & PACKET_V2_RELIABLE)) return true;
+    if (!routedToLower(packet)) return true;
+    return lowerRouteHasRoom();
+}
+
+// 並べ替えバッファの中身は取り出すまで宛先が分からないので、空きがあるときだけ取り出す
+bool lowerRouteHasRoom() {
+    return lowerLink.queued() < RELIABLE_LINK_QUEUE;
+}
+
+void routeToLower(const PacketView_t& packet) {
+    unsigned long now = millis();
+    if (packet.version == 2 && (packet.ctrl & PACKET_V2_RELIABLE)) {
+        // メインの SEQ は下半身には通じないので、lowerLink の SEQ を付け直して送る
+        if (!lowerLink.send(lowerOut.at(now), packet.cmd, packet.data, packet.length, true, now)) {
+            Serial.printf("下半身への再送待ちが一杯: 0x%02X を破棄\n", packet.cmd);
+        }
+        return;
+    }
+
+    // 送りっぱなしのものは受信リング上のフレームをそのまま（メインの ACK が載っていても、
+    // 下半身からは確実に届けるコマンドを送らないので、下半身のリンクは読み捨てる）
+    if (!lowerRouter.forward(Serial2, packet.frame, packet.frameLength, routePriority(packet.cmd), now)) {
+        Serial.printf("下半身への送信待ちが一杯: 0x%02X を破棄\n", packet.cmd);
+    }
+}
+
+// =============================================================================
+// 下半身からの受信（センサーデータと処理時間はメインへ中継、ボーレート交渉、ステータス応答）
+// =============================================================================
+void handleLowerUART() {
+    unsigned long now = millis();
+    if (lowerParser.readFrom(Serial2) > 0) {
+        lastLowerRx = now;
+    } else if (lowerParser.buffered() > 0 && now - lastLowerRx >= UART_IDLE_RESYNC_MS) {
+        lowerParser.resyncIfStalled();
+    }
+
+    PacketView_t packet;
+    while (lowerParser.next(&packet)) {
+        // ACK/NACK/HELLO は lowerLink が受け取る（メインへは中継しない）
+        if (!lowerLink.receive(lowerOut.at(now), packet, now)) continue;
+        if (packet.cmd >= CMD_IMU_DATA && packet.cmd <= 0x5F) {
+            // センサーデータは受信リングからそのままメインへ（優先度は一番低い）
+            mainRouter.forward(Serial1, packet.frame, packet.frameLength, ROUTE_BULK, now);
+        } else if (packet.cmd == CMD_LINK_SPEED) {
+            lowerSpeed.receive(Serial2, packet, now);
+        } else if (packet.cmd == CMD_STATUS_RESP && packet.length >= 1 && packet.data[0] == STATUS_RESP_TRACE) {
+            mainRouter.forward(Serial1, packet.frame, packet.frameLength, ROUTE_BULK, now);
+        } else if (packet.cmd == CMD_STATUS_RESP && packet.length >= 1 + sizeof(LinkStatusData_t)) {
+            LinkStatusData_t status;
+            memcpy(&status, &packet.data[1], sizeof(status));
+            LinkSpeed::printStatus(Serial, "下半身", status);
+        }
+    }
+    lowerLink.poll(lowerOut.at(now), now);
+    lowerRouter.pump(Serial2, now);
+    lowerSpeed.poll(Serial2, now, lowerParser.stats(), lowerRouter.stats().bytes);
+}
+
+// =============================================================================
+// CMD_STATUS への応答（このボードから見た両方のリンク）
+// =============================================================================
+void sendStatus() {
+    uint8_t data[1 + LINK_STATUS_MAX_LINKS * sizeof(LinkStatusData_t)];
+    LinkStatusData_t status[LINK_STATUS_MAX_LINKS];
+    mainSpeed.fillStatus(&status[0], LINK_MAIN_UPPER);
+    lowerSpeed.fillStatus(&status[1], LINK_UPPER_LOWER);
+    data[0] = LINK_STATUS_MAX_LINKS;
+    memcpy(&data[1], status, sizeof(status));
+    mainLink.send(Serial1, CMD_STATUS_RESP, data, sizeof(data), millis());
+}
+
+// STATUS_TRACE への応答（前回からの処理時間の分布を処理ごとに1フレーム）
+void sendTraceStatus() {
+    for (uint8_t stage = 0; stage < TRACE_STAGES; stage++) {
+        TraceStatusData_t status;
+        if (tracer.fillStatus((TraceStage_t)stage, &status)) {
+            mainLink.send(Serial1, CMD_STATUS_RESP, (const uint8_t*)&status, sizeof(status), millis());
         }
+    }
+}
 
-        if (uartIndex >= PACKET_MAX_SIZE) {
-            uartIndex = 0;  // オーバーフロー防止
+// =============================================================================
+// サーボフレーム適用（サーボ更新 tick 内で全チャンネルを一度に）
+// =============================================================================
+void applyServoFrame() {
+    ServoPose_t pose;
+    if (!servoFrame.take(&pose)) return;
+
+    for (uint8_t ch = 0; ch < SERVO_FRAME_CHANNELS; ch++) {
+        if (!(pose.mask & (1u << ch))) continue;
+        if (pose.flags & SERVO_FRAME_FLAG_SNAP) {
+            servoTrajectory.snap(ch, pose.angles[ch]);
+        } else {
+            setServoAngle(ch, pose.angles[ch]);
         }
     }
 }
 
+// =============================================================================
+// アニメーション更新（サーボ更新 tick 内で、軌道で動かしたベース姿勢の上に重ねる）
+// =============================================================================
+void updateAnimation(unsigned long now) {
+    uint16_t moved = servoTrajectory.update(now, servoBase);
+    uint8_t base[16];
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        base[ch] = (uint8_t)(servoBase[ch] + 0.5f);
+    }
+
+    uint8_t angles[16];
+    uint16_t released;
+    uint16_t driven = animation.update(now, base, angles, &released);
+
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        if (driven & (1u << ch)) {
+            writeServo(ch, angles[ch]);
+        } else if ((released | moved) & (1u << ch)) {
+            writeServo(ch, servoBase[ch]);      // 1 度未満もそのまま
+        }
+    }
+}
+
+// =============================================================================
+// 手を振る
+// =============================================================================
+void playWave(uint8_t count) {
+    animation.play(ANIM_LAYER_GESTURE, &waveClip, millis(), count ? count : WAVE_DEFAULT_COUNT,
+                   GESTURE_FADE_MS, GESTURE_FADE_MS);
+}
+
+// =============================================================================
+// 指差し（腕を上げて指し、目と首もそちらへ向ける）
+// =============================================================================
+void playPoint(int8_t x, int8_t y, uint16_t holdMs) {
+    x = constrain(x, -50, 50);
+    y = constrain(y, -50, 50);
+    uint16_t end = POINT_MOVE_MS + (holdMs ? holdMs : POINT_DEFAULT_HOLD_MS);
+
+    bool right = x >= 0;
+    uint8_t shoulder = map(y, -50, 50, 70, 160);
+    if (!right) shoulder = 180 - shoulder;
+
+    struct {
+        uint8_t channel;
+        uint8_t angle;
+    } targets[] = {
+        {(uint8_t)(right ? SERVO_ARM_RIGHT_SHOULDER : SERVO_ARM_LEFT_SHOULDER), shoulder},
+        {(uint8_t)(right ? SERVO_ARM_RIGHT_ELBOW : SERVO_ARM_LEFT_ELBOW), SERVO_CENTER_ANGLE},
+        {SERVO_EYE_RIGHT_H, (uint8_t)map(x, -50, 50, EYE_H_MIN, EYE_H_MAX)},
+        {SERVO_EYE_LEFT_H, (uint8_t)map(x, -50, 50, EYE_H_MIN, EYE_H_MAX)},
+        {SERVO_EYE_RIGHT_V, (uint8_t)map(y, -50, 50, EYE_V_MIN, EYE_V_MAX)},
+        {SERVO_EYE_LEFT_V, (uint8_t)map(y, -50, 50, EYE_V_MIN, EYE_V_MAX)},
+        {SERVO_NECK_YAW, (uint8_t)map(x, -50, 50, 60, 120)},
+    };
+
+    pointClip.clear();
+    for (auto& target : targets) {
+        AnimKey_t keys[] = {
+            {0, ANIM_FROM_CURRENT, EASE_LINEAR},
+            {POINT_MOVE_MS, target.angle, EASE_OUT},
+            {end, target.angle, EASE_LINEAR},
+        };
+        pointClip.addTrack(target.channel, keys, 3);
+    }
+    animation.play(ANIM_LAYER_GESTURE, pointClip.clip(), millis(), 1, 0, GESTURE_FADE_MS);
+}
+
+// =============================================================================
+// 腕の位置（今の角度から duration_ms かけて移動し、そのままベース姿勢にする）
+// =============================================================================
+void playArmPosition(const ArmPositionData_t* arm) {
+    const uint8_t channels[4] = {
+        SERVO_ARM_RIGHT_SHOULDER, SERVO_ARM_RIGHT_ELBOW, SERVO_ARM_LEFT_SHOULDER, SERVO_ARM_LEFT_ELBOW
+    };
+    const uint8_t angles[4] = {arm->right_shoulder, arm->right_elbow, arm->left_shoulder, arm->left_elbow};
+    uint16_t duration = arm->duration_ms ? arm->duration_ms : ARM_DEFAULT_DURATION_MS;
+
+    armClip.clear();
+    for (int i = 0; i < 4; i++) {
+        if (angles[i] > 180) continue;     // SERVO_FRAME_HOLD
+        AnimKey_t keys[] = {
+            {0, ANIM_FROM_CURRENT, EASE_LINEAR},
+            {duration, angles[i], EASE_IN_OUT},
+        };
+        armClip.addTrack(channels[i], keys, 2);
+    }
+    animation.play(ANIM_LAYER_GESTURE, armClip.clip(), millis());
+
+    // 終わったらベース姿勢がそのまま引き継ぐ（クリップの始点は次の tick のベースなので、
+    // ベースも同じ時間をかけて動かす）
+    for (int i = 0; i < 4; i++) {
+        if (angles[i] <= 180) setServoAngle(channels[i], angles[i], duration);
+    }
+}
+
 // =============================================================================
 // コマンド処理
 // =============================================================================
-void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
+void processCommand(uint8_t cmd, const uint8_t* data, uint8_t length) {
     Serial.print("コマンド受信: 0x");
     Serial.println(cmd, HEX);
 
@@ -413,16 +833,16 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
 
         case CMD_EXPRESSION: {
             if (length >= sizeof(ExpressionData_t)) {
-                ExpressionData_t* exprData = (ExpressionData_t*)data;
-                setExpression((Expression_t)exprData->expression_id);
+                const ExpressionData_t* exprData = (const ExpressionData_t*)data;
+                setExpression((Expression_t)exprData->expression_id, exprData->intensity, exprData->duration_ms);
             }
             break;
         }
 
         case CMD_EYE_POSITION: {
             if (length >= sizeof(EyePositionData_t)) {
-                EyePositionData_t* eyeData = (EyePositionData_t*)data;
-                setEyePosition(eyeData->x, eyeData->y);
+                const EyePositionData_t* eyeData = (const EyePositionData_t*)data;
+                setEyePosition(eyeData->x, eyeData->y, eyeData->speed);
             }
             break;
         }
@@ -433,7 +853,7 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
 
         case CMD_MOUTH_OPEN: {
             if (length >= sizeof(MouthData_t)) {
-                MouthData_t* mouthData = (MouthData_t*)data;
+                const MouthData_t* mouthData = (const MouthData_t*)data;
                 setMouthOpen(mouthData->open_amount);
             }
             break;
@@ -449,7 +869,7 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
 
         case CMD_SPEAK_STOP:
             isSpeaking = false;
-            setMouthOpen(0);
+            expressions.stopSpeech(millis());
             break;
 
         case CMD_LOOK_AT: {
@@ -462,16 +882,49 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
             break;
         }
 
+        case CMD_PERSON_DETECTED:
+            // 人物の検知・喪失（いなくなったら前を向く）
+            if (length >= sizeof(PersonData_t)) {
+                const PersonData_t* person = (const PersonData_t*)data;
+                Serial.println(person->detected ? "人がいるナリ！" : "人がいなくなったナリ");
+                if (!person->detected) setEyePosition(0, 0);
+            }
+            break;
+
+        case CMD_FACE_POSITION:
+            // 顔の位置（カメラ 320x240 基準）を目と首で追う。カメラは頭についているので頭から見た向き
+            if (length >= sizeof(PersonData_t)) {
+                const PersonData_t* person = (const PersonData_t*)data;
+                float yaw = (constrain(person->x, 0, 320) - 160) * (GAZE_CAMERA_FOV_H_DEG / 320.0f);
+                float pitch = (120 - constrain(person->y, 0, 240)) * (GAZE_CAMERA_FOV_V_DEG / 240.0f);
+                gaze.setTargetFromHead(yaw, pitch, millis());
+                gazeSpeed = 0;
+            }
+            break;
+
+        case CMD_SERVO_FRAME:
+        case CMD_SERVO_FRAME_DELTA:
+            servoFrame.receive(cmd, data, length);
+            break;
+
         case CMD_WAVE:
-            // 手を振るモーション（簡易実装）
+            // 手を振るモーション（サーボ更新 tick で進める）
             Serial.println("手を振るナリ！");
-            for (int i = 0; i < 3; i++) {
-                setServoAngle(SERVO_ARM_RIGHT_SHOULDER, 45);
-                delay(300);
-                setServoAngle(SERVO_ARM_RIGHT_SHOULDER, 135);
-                delay(300);
+            playWave(length >= sizeof(WaveData_t) ? ((const WaveData_t*)data)->count : 0);
+            break;
+
+        case CMD_POINT:
+            if (length >= sizeof(PointData_t)) {
+                const PointData_t* point = (const PointData_t*)data;
+                Serial.println("指差しナリ！");
+                playPoint(point->x, point->y, point->hold_ms);
+            }
+            break;
+
+        case CMD_ARM_POSITION:
+            if (length >= sizeof(ArmPositionData_t)) {
+                playArmPosition((const ArmPositionData_t*)data);
             }
-            setServoAngle(SERVO_ARM_RIGHT_SHOULDER, 90);
             break;
 
         default:
@@ -480,3 +933,74 @@ void processCommand(uint8_t cmd, uint8_t* data, uint8_t length) {
             break;
     }
 }
+
+// =============================================================================
+// メイン・下半身とのリンクを報告
+// =============================================================================
+void reportMainLink() {
+    const LinkStats_t& link = mainLink.stats();
+    const ParserStats_t& parser = uartParser.stats();
+    Serial.printf("メインUART: %s, 受信 %lu (v2 %lu), 重複 %lu, 並べ替え %lu, 欠落 %lu, NACK送信 %lu, CRC/チェックサム %lu, フレーム異常 %lu\n",
+                  mainLink.peerV2() ? "v2" : "v1",
+                  (unsigned long)parser.packets, (unsigned long)parser.v2Packets,
+                  (unsigned long)link.duplicates, (unsigned long)link.reordered,
+                  (unsigned long)link.lost, (unsigned long)link.nacksSent,
+                  (unsigned long)parser.checksumErrors, (unsigned long)parser.framingErrors);
+
+    const LinkStats_t& lower = lowerLink.stats();
+    Serial.printf("下半身UART: %s, 送信 %lu, 再送 %lu, NACK受信 %lu, 諦め %lu, 待ち溢れ %lu, RTO %lu ms, "
+                  "中継に断られた %lu\n",
+                  lowerLink.peerV2() ? "v2" : "v1", (unsigned long)lower.txFrames,
+                  (unsigned long)lower.retransmits, (unsigned long)lower.nacksReceived,
+                  (unsigned long)lower.giveUps, (unsigned long)lower.queueFull,
+                  (unsigned long)lowerLink.rtoMs(), (unsigned long)lowerOut.refused());
+
+    LinkStatusData_t status;
+    mainSpeed.fillStatus(&status, LINK_MAIN_UPPER);
+    LinkSpeed::printStatus(Serial, "上半身", status);
+    lowerSpeed.fillStatus(&status, LINK_UPPER_LOWER);
+    LinkSpeed::printStatus(Serial, "上半身", status);
+
+    const RouterStats_t& down = lowerRouter.stats();
+    const RouterStats_t& up = mainRouter.stats();
+    Serial.printf("中継: 下半身へ %lu (直接 %lu), 最長待ち 動作 %lu ms / 連続 %lu ms / 歩容 %lu ms, 破棄 %lu/%lu/%lu, "
+                  "空き待ちで再送させた %lu | メインへ %lu (直接 %lu), 最長待ち %lu ms, 破棄 %lu\n",
+                  (unsigned long)down.frames, (unsigned long)down.direct,
+                  (unsigned long)down.maxWaitMs[ROUTE_MOTION], (unsigned long)down.maxWaitMs[ROUTE_STREAM],
+                  (unsigned long)down.maxWaitMs[ROUTE_TRANSFER],
+                  (unsigned long)down.dropped[ROUTE_MOTION], (unsigned long)down.dropped[ROUTE_STREAM],
+                  (unsigned long)down.dropped[ROUTE_TRANSFER], (unsigned long)lowerRouteDeferred,
+                  (unsigned long)up.frames, (unsigned long)up.direct,
+                  (unsigned long)up.maxWaitMs[ROUTE_BULK], (unsigned long)up.dropped[ROUTE_BULK]);
+}
+
+// 下半身から見たリンクを問い合わせる（CMD_STATUS_RESP が届いたら handleLowerUART() が表示）
+void requestLowerStatus() {
+    uint8_t frame[PACKET_MAX_SIZE];
+    lowerRouter.forward(Serial2, frame, buildPacketV2(frame, 0, 0, 0, CMD_STATUS, nullptr, 0), ROUTE_BULK, millis());
+}
+
+// =============================================================================
+// サーボ出力のI2Cバス時間を報告
+// =============================================================================
+void reportServoBus() {
+    const ServoOutputStats_t& stats = servoOut.stats();
+    Serial.printf("サーボI2C: 平均 %lu us/tick, 最大 %lu us, %lu トランザクション, エラー %lu, 復旧 %lu\n",
+                  (unsigned long)servoOut.averageBusUs(), (unsigned long)stats.maxBusUs,
+                  (unsigned long)stats.transactions, (unsigned long)stats.errors,
+                  (unsigned long)stats.recoveries);
+}
+
+void reportLEDEyes() {
+    const LedEyeStats_t& stats = ledEyes.stats();
+    Serial.printf("LED目: 描画 %lu, 変化 %lu, 出力 %lu (show %lu)\n",
+                  (unsigned long)stats.renders, (unsigned long)stats.changes,
+                  (unsigned long)stats.commits, (unsigned long)ledShows);
+}
+
+void reportGaze() {
+    const GazeStats_t& stats = gaze.stats();
+    Serial.printf("視線: 目標 %lu (新しい目標 %lu), サッカード %lu, 首 %.1f/%.1f 度\n",
+                  (unsigned long)stats.samples, (unsigned long)stats.newTargets,
+                  (unsigned long)stats.saccades, gazeOut.neckYaw, gazeOut.neckPitch);
+}
@@ -0,0 +1,196 @@
+/**
+ * コロ助ロボット - ネイティブHAL BNO055ドライバ代替
+ * Corosuke Robot - Native HAL Adafruit_BNO055 stand-in
+ *
+ * I2C経由でデバイスモデル（native_devices.h）のレジスタを読む。
+ */
+
+#ifndef COROSUKE_NATIVE_ADAFRUIT_BNO055_H
+#define COROSUKE_NATIVE_ADAFRUIT_BNO055_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Adafruit_Sensor.h"
+
+#define BNO055_ID 0xA0
+
+namespace imu {
+
+template <uint8_t N>
+class Vector {
+public:
+    Vector() { for (uint8_t i = 0; i < N; i++) _v[i] = 0; }
+    double& operator[](int i) { return _v[i]; }
+    double operator[](int i) const { return _v[i]; }
+    double& x() { return _v[0]; }
+    double& y() { return _v[1]; }
+    double& z() { return _v[2]; }
+
+private:
+    double _v[N];
+};
+
+class Quaternion {
+public:
+    Quaternion() : _w(1), _x(0), _y(0), _z(0) {}
+    Quaternion(double w, double x, double y, double z) : _w(w), _x(x), _y(y), _z(z) {}
+    double& w() { return _w; }
+    double& x() { return _x; }
+    double& y() { return _y; }
+    double& z() { return _z; }
+
+private:
+    double _w, _x, _y, _z;
+};
+
+} // namespace imu
+
+typedef enum {
+    OPERATION_MODE_CONFIG = 0x00,
+    OPERATION_MODE_ACCONLY = 0x01,
+    OPERATION_MODE_MAGONLY = 0x02,
+    OPERATION_MODE_GYRONLY = 0x03,
+    OPERATION_MODE_ACCMAG = 0x04,
+    OPERATION_MODE_ACCGYRO = 0x05,
+    OPERATION_MODE_MAGGYRO = 0x06,
+    OPERATION_MODE_AMG = 0x07,
+    OPERATION_MODE_IMUPLUS = 0x08,
+    OPERATION_MODE_COMPASS = 0x09,
+    OPERATION_MODE_M4G = 0x0A,
+    OPERATION_MODE_NDOF_FMC_OFF = 0x0B,
+    OPERATION_MODE_NDOF = 0x0C
+} adafruit_bno055_opmode_t;
+
+class Adafruit_BNO055 {
+public:
+    typedef enum {
+        BNO055_PAGE_ID_ADDR = 0x07,
+        BNO055_CHIP_ID_ADDR = 0x00,
+        BNO055_ACCEL_DATA_X_LSB_ADDR = 0x08,
+        BNO055_MAG_DATA_X_LSB_ADDR = 0x0E,
+        BNO055_GYRO_DATA_X_LSB_ADDR = 0x14,
+        BNO055_EULER_H_LSB_ADDR = 0x1A,
+        BNO055_QUATERNION_DATA_W_LSB_ADDR = 0x20,
+        BNO055_LINEAR_ACCEL_DATA_X_LSB_ADDR = 0x28,
+        BNO055_GRAVITY_DATA_X_LSB_ADDR = 0x2E,
+        BNO055_UNIT_SEL_ADDR = 0x3B,
+        BNO055_OPR_MODE_ADDR = 0x3D,
+        BNO055_PWR_MODE_ADDR = 0x3E,
+        BNO055_SYS_TRIGGER_ADDR = 0x3F
+    } adafruit_bno055_reg_t;
+
+    typedef enum {
+        VECTOR_ACCELEROMETER = BNO055_ACCEL_DATA_X_LSB_ADDR,
+        VECTOR_MAGNETOMETER = BNO055_MAG_DATA_X_LSB_ADDR,
+        VECTOR_GYROSCOPE = BNO055_GYRO_DATA_X_LSB_ADDR,
+        VECTOR_EULER = BNO055_EULER_H_LSB_ADDR,
+        VECTOR_LINEARACCEL = BNO055_LINEAR_ACCEL_DATA_X_LSB_ADDR,
+        VECTOR_GRAVITY = BNO055_GRAVITY_DATA_X_LSB_ADDR
+    } adafruit_vector_type_t;
+
+    Adafruit_BNO055(int32_t sensorID = -1, uint8_t address = 0x28, TwoWire* theWire = &Wire)
+        : _sensorID(sensorID), _address(address), _wire(theWire) {}
+
+    bool begin(adafruit_bno055_opmode_t mode = OPERATION_MODE_NDOF) {
+        _wire->begin();
+        if (read8(BNO055_CHIP_ID_ADDR) != BNO055_ID) {
+            return false;
+        }
+        write8(BNO055_OPR_MODE_ADDR, mode);
+        delay(20);
+        return true;
+    }
+
+    void setExtCrystalUse(bool usextal) {
+        write8(BNO055_SYS_TRIGGER_ADDR, usextal ? 0x80 : 0x00);
+        delay(10);
+    }
+
+    void setMode(adafruit_bno055_opmode_t mode) {
+        write8(BNO055_OPR_MODE_ADDR, mode);
+        delay(30);
+    }
+
+    imu::Vector<3> getVector(adafruit_vector_type_t type) {
+        imu::Vector<3> xyz;
+        uint8_t buffer[6] = {0};
+        readLen((uint8_t)type, buffer, 6);
+
+        int16_t x = (int16_t)(buffer[0] | (buffer[1] << 8));
+        int16_t y = (int16_t)(buffer[2] | (buffer[3] << 8));
+        int16_t z = (int16_t)(buffer[4] | (buffer[5] << 8));
+
+        double scale = 1.0;
+        switch (type) {
+            case VECTOR_MAGNETOMETER:
+            case VECTOR_GYROSCOPE:
+            case VECTOR_EULER:
+                scale = 16.0;
+                break;
+            case VECTOR_ACCELEROMETER:
+            case VECTOR_LINEARACCEL:
+            case VECTOR_GRAVITY:
+                scale = 100.0;
+                break;
+        }
+        xyz[0] = x / scale;
+        xyz[1] = y / scale;
+        xyz[2] = z / scale;
+        return xyz;
+    }
+
+    imu::Quaternion getQuat() {
+        uint8_t buffer[8] = {0};
+        readLen(BNO055_QUATERNION_DATA_W_LSB_ADDR, buffer, 8);
+        const double scale = 1.0 / (1 << 14);
+        return imu::Quaternion((int16_t)(buffer[0] | (buffer[1] << 8)) * scale,
+                               (int16_t)(buffer[2] | (buffer[3] << 8)) * scale,
+                               (int16_t)(buffer[4] | (buffer[5] << 8)) * scale,
+                               (int16_t)(buffer[6] | (buffer[7] << 8)) * scale);
+    }
+
+    bool getEvent(sensors_event_t* event) {
+        memset(event, 0, sizeof(sensors_event_t));
+        event->version = sizeof(sensors_event_t);
+        event->sensor_id = _sensorID;
+        event->type = SENSOR_TYPE_ORIENTATION;
+        event->timestamp = millis();
+
+        imu::Vector<3> euler = getVector(VECTOR_EULER);
+        event->orientation.x = euler.x();
+        event->orientation.y = euler.y();
+        event->orientation.z = euler.z();
+        return true;
+    }
+
+private:
+    uint8_t read8(uint8_t reg) {
+        uint8_t value = 0;
+        readLen(reg, &value, 1);
+        return value;
+    }
+
+    bool write8(uint8_t reg, uint8_t value) {
+        _wire->beginTransmission(_address);
+        _wire->write(reg);
+        _wire->write(value);
+        return _wire->endTransmission() == 0;
+    }
+
+    bool readLen(uint8_t reg, uint8_t* buffer, uint8_t len) {
+        _wire->beginTransmission(_address);
+        _wire->write(reg);
+        if (_wire->endTransmission() != 0) return false;
+        if (_wire->requestFrom(_address, len) != len) return false;
+        for (uint8_t i = 0; i < len; i++) {
+            buffer[i] = (uint8_t)_wire->read();
+        }
+        return true;
+    }
+
+    int32_t _sensorID;
+    uint8_t _address;
+    TwoWire* _wire;
+};
+
+#endif // COROSUKE_NATIVE_ADAFRUIT_BNO055_H
@@ -0,0 +1,187 @@
+/**
+ * コロ助ロボット - ネイティブHAL PCA9685ドライバ代替
+ * Corosuke Robot - Native HAL Adafruit_PWMServoDriver stand-in
+ *
+ * Adafruit PWM Servo Driver Library 2.4.x と同じI2Cシーケンスを発行する。
+ */
+
+#ifndef COROSUKE_NATIVE_ADAFRUIT_PWMSERVODRIVER_H
+#define COROSUKE_NATIVE_ADAFRUIT_PWMSERVODRIVER_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// レジスタ
+#define PCA9685_MODE1       0x00
+#define PCA9685_MODE2       0x01
+#define PCA9685_SUBADR1     0x02
+#define PCA9685_SUBADR2     0x03
+#define PCA9685_SUBADR3     0x04
+#define PCA9685_ALLCALLADR  0x05
+#define PCA9685_LED0_ON_L   0x06
+#define PCA9685_LED0_ON_H   0x07
+#define PCA9685_LED0_OFF_L  0x08
+#define PCA9685_LED0_OFF_H  0x09
+#define PCA9685_ALLLED_ON_L  0xFA
+#define PCA9685_ALLLED_ON_H  0xFB
+#define PCA9685_ALLLED_OFF_L 0xFC
+#define PCA9685_ALLLED_OFF_H 0xFD
+#define PCA9685_PRESCALE    0xFE
+#define PCA9685_TESTMODE    0xFF
+
+// MODE1 ビット
+#define MODE1_ALLCAL  0x01
+#define MODE1_SUB3    0x02
+#define MODE1_SUB2    0x04
+#define MODE1_SUB1    0x08
+#define MODE1_SLEEP   0x10
+#define MODE1_AI      0x20
+#define MODE1_EXTCLK  0x40
+#define MODE1_RESTART 0x80
+
+// MODE2 ビット
+#define MODE2_OUTNE_0 0x01
+#define MODE2_OUTNE_1 0x02
+#define MODE2_OUTDRV  0x04
+#define MODE2_OCH     0x08
+#define MODE2_INVRT   0x10
+
+#define PCA9685_I2C_ADDRESS   0x40
+#define FREQUENCY_OSCILLATOR  25000000
+#define PCA9685_PRESCALE_MIN  3
+#define PCA9685_PRESCALE_MAX  255
+
+class Adafruit_PWMServoDriver {
+public:
+    Adafruit_PWMServoDriver() : Adafruit_PWMServoDriver(PCA9685_I2C_ADDRESS, Wire) {}
+    Adafruit_PWMServoDriver(const uint8_t addr) : Adafruit_PWMServoDriver(addr, Wire) {}
+    Adafruit_PWMServoDriver(const uint8_t addr, TwoWire& i2c) : _i2caddr(addr), _i2c(&i2c) {}
+
+    bool begin(uint8_t prescale = 0) {
+        _i2c->begin();
+        reset();
+        if (prescale) {
+            setExtClk(prescale);
+        } else {
+            setPWMFreq(1000);
+        }
+        setOscillatorFrequency(FREQUENCY_OSCILLATOR);
+        return true;
+    }
+
+    void reset() {
+        write8(PCA9685_MODE1, MODE1_RESTART);
+        delay(10);
+    }
+
+    void sleep() {
+        write8(PCA9685_MODE1, read8(PCA9685_MODE1) | MODE1_SLEEP);
+        delay(5);
+    }
+
+    void wakeup() {
+        write8(PCA9685_MODE1, read8(PCA9685_MODE1) & ~MODE1_SLEEP);
+    }
+
+    void setExtClk(uint8_t prescale) {
+        uint8_t oldmode = read8(PCA9685_MODE1);
+        uint8_t newmode = (oldmode & ~MODE1_RESTART) | MODE1_SLEEP;
+        write8(PCA9685_MODE1, newmode);
+        write8(PCA9685_MODE1, (newmode |= MODE1_EXTCLK));
+        write8(PCA9685_PRESCALE, prescale);
+        delay(5);
+        write8(PCA9685_MODE1, (newmode & ~MODE1_SLEEP) | MODE1_RESTART | MODE1_AI);
+    }
+
+    void setPWMFreq(float freq) {
+        if (freq < 1) freq = 1;
+        if (freq > 3500) freq = 3500;
+        float prescaleval = ((_oscillator_freq / (freq * 4096.0f)) + 0.5f) - 1;
+        if (prescaleval < PCA9685_PRESCALE_MIN) prescaleval = PCA9685_PRESCALE_MIN;
+        if (prescaleval > PCA9685_PRESCALE_MAX) prescaleval = PCA9685_PRESCALE_MAX;
+        uint8_t prescale = (uint8_t)prescaleval;
+
+        uint8_t oldmode = read8(PCA9685_MODE1);
+        uint8_t newmode = (oldmode & ~MODE1_RESTART) | MODE1_SLEEP;
+        write8(PCA9685_MODE1, newmode);
+        write8(PCA9685_PRESCALE, prescale);
+        write8(PCA9685_MODE1, oldmode);
+        delay(5);
+        write8(PCA9685_MODE1, oldmode | MODE1_RESTART | MODE1_AI);
+    }
+
+    void setOutputMode(bool totempole) {
+        uint8_t oldmode = read8(PCA9685_MODE2);
+        uint8_t newmode = totempole ? (oldmode | MODE2_OUTDRV) : (oldmode & ~MODE2_OUTDRV);
+        write8(PCA9685_MODE2, newmode);
+    }
+
+    uint8_t readPrescale() { return read8(PCA9685_PRESCALE); }
+
+    uint16_t getPWM(uint8_t num, bool off = false) {
+        _i2c->beginTransmission(_i2caddr);
+        _i2c->write(PCA9685_LED0_ON_L + 4 * num + (off ? 2 : 0));
+        _i2c->endTransmission();
+        _i2c->requestFrom((uint8_t)_i2caddr, (uint8_t)2);
+        uint16_t lo = _i2c->read();
+        uint16_t hi = _i2c->read();
+        return lo | (hi << 8);
+    }
+
+    uint8_t setPWM(uint8_t num, uint16_t on, uint16_t off) {
+        _i2c->beginTransmission(_i2caddr);
+        _i2c->write(PCA9685_LED0_ON_L + 4 * num);
+        _i2c->write(on);
+        _i2c->write(on >> 8);
+        _i2c->write(off);
+        _i2c->write(off >> 8);
+        return _i2c->endTransmission();
+    }
+
+    void setPin(uint8_t num, uint16_t val, bool invert = false) {
+        val = min(val, (uint16_t)4095);
+        if (invert) {
+            if (val == 0) setPWM(num, 4096, 0);
+            else if (val == 4095) setPWM(num, 0, 4096);
+            else setPWM(num, 0, 4095 - val);
+        } else {
+            if (val == 4095) setPWM(num, 4096, 0);
+            else if (val == 0) setPWM(num, 0, 4096);
+            else setPWM(num, 0, val);
+        }
+    }
+
+    void writeMicroseconds(uint8_t num, uint16_t microseconds) {
+        double pulselength = 1000000;
+        uint16_t prescale = readPrescale() + 1;
+        pulselength *= prescale;
+        pulselength /= _oscillator_freq;
+        double pulse = microseconds / pulselength;
+        setPWM(num, 0, (uint16_t)pulse);
+    }
+
+    uint32_t getOscillatorFrequency() { return _oscillator_freq; }
+    void setOscillatorFrequency(uint32_t freq) { _oscillator_freq = freq; }
+
+private:
+    uint8_t read8(uint8_t addr) {
+        _i2c->beginTransmission(_i2caddr);
+        _i2c->write(addr);
+        _i2c->endTransmission();
+        _i2c->requestFrom((uint8_t)_i2caddr, (uint8_t)1);
+        return _i2c->read();
+    }
+
+    void write8(uint8_t addr, uint8_t d) {
+        _i2c->beginTransmission(_i2caddr);
+        _i2c->write(addr);
+        _i2c->write(d);
+        _i2c->endTransmission();
+    }
+
+    uint8_t _i2caddr;
+    TwoWire* _i2c;
+    uint32_t _oscillator_freq = FREQUENCY_OSCILLATOR;
+};
+
+#endif // COROSUKE_NATIVE_ADAFRUIT_PWMSERVODRIVER_H
@@ -0,0 +1,56 @@
+/**
+ * コロ助ロボット - ネイティブHAL Adafruit Unified Sensor代替
+ * Corosuke Robot - Native HAL Adafruit_Sensor stand-in
+ */
+
+#ifndef COROSUKE_NATIVE_ADAFRUIT_SENSOR_H
+#define COROSUKE_NATIVE_ADAFRUIT_SENSOR_H
+
+#include <stdint.h>
+
+#define SENSORS_GRAVITY_EARTH 9.80665f
+
+typedef enum {
+    SENSOR_TYPE_ACCELEROMETER = 1,
+    SENSOR_TYPE_MAGNETIC_FIELD = 2,
+    SENSOR_TYPE_ORIENTATION = 3,
+    SENSOR_TYPE_GYROSCOPE = 4,
+    SENSOR_TYPE_LINEAR_ACCELERATION = 10,
+    SENSOR_TYPE_GRAVITY = 11
+} sensors_type_t;
+
+typedef struct {
+    union {
+        float v[3];
+        struct {
+            float x;
+            float y;
+            float z;
+        };
+        struct {
+            float roll;
+            float pitch;
+            float heading;
+        };
+    };
+    int8_t status;
+    uint8_t reserved[3];
+} sensors_vec_t;
+
+typedef struct {
+    int32_t version;
+    int32_t sensor_id;
+    int32_t type;
+    int32_t reserved0;
+    int32_t timestamp;
+    union {
+        float data[4];
+        sensors_vec_t acceleration;
+        sensors_vec_t magnetic;
+        sensors_vec_t orientation;
+        sensors_vec_t gyro;
+        float temperature;
+    };
+} sensors_event_t;
+
+#endif // COROSUKE_NATIVE_ADAFRUIT_SENSOR_H
@@ -0,0 +1,104 @@
+/**
+ * コロ助ロボット - ネイティブHAL Arduinoコア代替
+ * Corosuke Robot - Native HAL Arduino core stand-in
+ *
+ * Arduino-ESP32 と同じ挙動になるよう、min/max/abs は std の関数を使う。
+ */
+
+#ifndef COROSUKE_NATIVE_ARDUINO_H
+#define COROSUKE_NATIVE_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
+#include "IPAddress.h"
+#include "native_hal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// =============================================================================
+// 定数・マクロ
+// =============================================================================
+#define PI          3.1415926535897932384626433832795
+#define HALF_PI     1.5707963267948966192313216916398
+#define TWO_PI      6.283185307179586476925286766559
+#define DEG_TO_RAD  0.017453292519943295769236907684886
+#define RAD_TO_DEG  57.295779513082320876798154814105
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+
+using std::abs;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// =============================================================================
+// 時間
+// =============================================================================
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// =============================================================================
+// GPIO
+// =============================================================================
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// =============================================================================
+// 数学
+// =============================================================================
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();      // 実機はハードウェア乱数（ここでは random() と同じ列）
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// =============================================================================
+// ESP（ヒープ残量・サイクルカウンタなど）
+// =============================================================================
+#define NATIVE_CPU_FREQ_MHZ 240
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() const { return 256 * 1024; }
+    uint32_t getMinFreeHeap() const { return 192 * 1024; }
+    // CCOUNT の代わりに仮想時計から（実機と同じく 32bit で一周する）
+    uint32_t getCycleCount() const { return (uint32_t)(nativeHalNowUs() * NATIVE_CPU_FREQ_MHZ); }
+    uint32_t getCpuFreqMHz() const { return NATIVE_CPU_FREQ_MHZ; }
+};
+
+extern EspClass ESP;
+
+// =============================================================================
+// スケッチ側で定義
+// =============================================================================
+void setup();
+void loop();
+
+#endif // COROSUKE_NATIVE_ARDUINO_H
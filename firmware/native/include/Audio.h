@@ -0,0 +1,41 @@
+/**
+ * コロ助ロボット - ネイティブHAL ESP32-audioI2S代替
+ * Corosuke Robot - Native HAL Audio stand-in
+ *
+ * connecttohost() すると、音節のように振幅が変わる合成音声（約3秒）を
+ * 仮想時間に合わせて audio_process_i2s() へ流し、最後に audio_eof_mp3() を呼ぶ。
+ */
+
+#ifndef COROSUKE_NATIVE_AUDIO_H
+#define COROSUKE_NATIVE_AUDIO_H
+
+#include <Arduino.h>
+
+// ESP32-audioI2S 3.0.x と同じコールバック（定義されていなければ呼ばない）
+extern __attribute__((weak)) void audio_process_i2s(int16_t* outBuff, uint16_t validSamples,
+                                                    uint8_t bitsPerSample, uint8_t channels,
+                                                    bool* continueI2S);
+extern __attribute__((weak)) void audio_eof_mp3(const char* info);
+
+class Audio {
+public:
+    bool setPinout(uint8_t BCLK, uint8_t LRC, uint8_t DOUT, int8_t MCLK = -1) {
+        (void)BCLK; (void)LRC; (void)DOUT; (void)MCLK;
+        return true;
+    }
+    void setVolume(uint8_t vol) { _volume = vol; }
+    uint8_t getVolume() const { return _volume; }
+    bool connecttohost(const char* host, const char* user = "", const char* pwd = "");
+    void loop();
+    bool isRunning() const { return _running; }
+    uint32_t stopSong() { _running = false; return 0; }
+    uint32_t getSampleRate() const { return 24000; }
+
+private:
+    uint8_t _volume = 0;
+    bool _running = false;
+    uint64_t _startUs = 0;
+    uint32_t _framesPlayed = 0;
+};
+
+#endif // COROSUKE_NATIVE_AUDIO_H
@@ -0,0 +1,108 @@
+/**
+ * コロ助ロボット - ネイティブHAL FastLED代替
+ * Corosuke Robot - Native HAL FastLED stand-in
+ *
+ * show() は WS2812B の転送時間（1 LED = 24bit × 1.25μs + リセット50μs）を
+ * コントローラごとにチャージする。
+ */
+
+#ifndef COROSUKE_NATIVE_FASTLED_H
+#define COROSUKE_NATIVE_FASTLED_H
+
+#include <Arduino.h>
+
+struct CRGB {
+    union {
+        struct {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+        };
+        uint8_t raw[3];
+    };
+
+    typedef enum {
+        Black = 0x000000,
+        Blue = 0x0000FF,
+        Green = 0x008000,
+        Orange = 0xFFA500,
+        Red = 0xFF0000,
+        White = 0xFFFFFF,
+        Yellow = 0xFFFF00
+    } HTMLColorCode;
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+    CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+
+    CRGB& operator=(uint32_t colorcode) { *this = CRGB(colorcode); return *this; }
+    uint8_t& operator[](uint8_t x) { return raw[x]; }
+    const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+    CRGB& nscale8(uint8_t scale) {
+        r = (uint8_t)(((uint16_t)r * (1 + scale)) >> 8);
+        g = (uint8_t)(((uint16_t)g * (1 + scale)) >> 8);
+        b = (uint8_t)(((uint16_t)b * (1 + scale)) >> 8);
+        return *this;
+    }
+
+    bool operator==(const CRGB& rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+    bool operator!=(const CRGB& rhs) const { return !(*this == rhs); }
+};
+
+static inline void fill_solid(CRGB* leds, int numToFill, const CRGB& color) {
+    for (int i = 0; i < numToFill; i++) {
+        leds[i] = color;
+    }
+}
+
+static inline uint8_t scale8(uint8_t i, uint8_t scale) {
+    return (uint8_t)(((uint16_t)i * (1 + (uint16_t)scale)) >> 8);
+}
+
+static inline CRGB blend(const CRGB& p1, const CRGB& p2, uint8_t amountOfP2) {
+    return CRGB((uint8_t)(p1.r + (((int)p2.r - p1.r) * amountOfP2) / 255),
+                (uint8_t)(p1.g + (((int)p2.g - p1.g) * amountOfP2) / 255),
+                (uint8_t)(p1.b + (((int)p2.b - p1.b) * amountOfP2) / 255));
+}
+
+// チップセット・カラーオーダー（型タグのみ）
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB> class WS2812B {};
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB> class WS2812 {};
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB> class NEOPIXEL {};
+
+class CLEDController {
+public:
+    CRGB* leds = nullptr;
+    int numLeds = 0;
+};
+
+#define NATIVE_FASTLED_MAX_CONTROLLERS 8
+
+class CFastLED {
+public:
+    template <template <uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CLEDController& addLeds(CRGB* data, int numLeds) {
+        return registerController(data, numLeds);
+    }
+
+    void setBrightness(uint8_t scale) { _brightness = scale; }
+    uint8_t getBrightness() const { return _brightness; }
+    void show();
+    void clear(bool writeData = false);
+    int count() const { return _count; }
+    CLEDController& operator[](int x) { return _controllers[x]; }
+
+private:
+    CLEDController& registerController(CRGB* data, int numLeds);
+
+    CLEDController _controllers[NATIVE_FASTLED_MAX_CONTROLLERS];
+    int _count = 0;
+    uint8_t _brightness = 255;
+};
+
+extern CFastLED FastLED;
+
+#endif // COROSUKE_NATIVE_FASTLED_H
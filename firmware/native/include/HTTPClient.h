@@ -0,0 +1,33 @@
+/**
+ * コロ助ロボット - ネイティブHAL HTTPClient代替
+ * Corosuke Robot - Native HAL HTTPClient stand-in
+ *
+ * サーバーには接続せず、常に接続拒否を返す。
+ */
+
+#ifndef COROSUKE_NATIVE_HTTPCLIENT_H
+#define COROSUKE_NATIVE_HTTPCLIENT_H
+
+#include <Arduino.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+public:
+    bool begin(const String& url) { _url = url; return true; }
+    void end() {}
+    void setReuse(bool reuse) { (void)reuse; }
+    void setTimeout(uint16_t timeout) { (void)timeout; }
+    void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+    int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int POST(const String& payload) { (void)payload; return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int POST(const uint8_t* payload, size_t size) { (void)payload; (void)size; return HTTPC_ERROR_CONNECTION_REFUSED; }
+    String getString() { return String(); }
+    int getSize() { return -1; }
+
+private:
+    String _url;
+};
+
+#endif // COROSUKE_NATIVE_HTTPCLIENT_H
@@ -0,0 +1,77 @@
+/**
+ * コロ助ロボット - ネイティブHAL HardwareSerial代替
+ * Corosuke Robot - Native HAL HardwareSerial stand-in
+ *
+ * 受信はベンチマークドライバが nativeInjectRx() で流し込む。
+ * 送信はUART FIFOをボーレートで排出するモデルで、FIFOが溢れる分だけ
+ * ブロッキング時間をチャージする（実機のSerial.println()と同じ挙動）。
+ */
+
+#ifndef COROSUKE_NATIVE_HARDWARESERIAL_H
+#define COROSUKE_NATIVE_HARDWARESERIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "Print.h"
+
+#define SERIAL_8N1 0x800001c
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int port) : _port(port) {}
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1,
+               int8_t rxPin = -1, int8_t txPin = -1, bool invert = false,
+               unsigned long timeoutMs = 20000UL);
+    void end() { _baud = 0; }
+    void updateBaudRate(unsigned long baud);
+    unsigned long baudRate() const { return _baud; }
+    size_t setRxBufferSize(size_t size) { _rxCapacity = size; return size; }
+    size_t setTxBufferSize(size_t size) { _txBufferSize = size; return size; }
+
+    int available() override { return (int)_rx.size(); }
+    int read() override;
+    int peek() override { return _rx.empty() ? -1 : _rx.front(); }
+    size_t read(uint8_t* buffer, size_t size);
+    size_t read(char* buffer, size_t size) { return read((uint8_t*)buffer, size); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;
+
+    operator bool() const { return true; }
+
+    // --- ネイティブ専用 ---
+    // 受信データを注入（RXバッファ容量を超えた分は破棄＝オーバーラン）
+    size_t nativeInjectRx(const uint8_t* data, size_t length);
+    // 送信済みデータを取り出す（ループバック/検証用）
+    size_t nativeTakeTx(uint8_t* buffer, size_t size);
+    size_t nativeTxPending() const { return _tx.size(); }
+    // 標準出力にエコーするか（Serialのみデフォルトで環境変数に従う）
+    void nativeSetEcho(bool echo) { _echo = echo; }
+    uint32_t nativeRxOverruns() const { return _rxOverruns; }
+
+private:
+    void drainFifo();
+
+    int _port;
+    unsigned long _baud = 0;
+    std::deque<uint8_t> _rx;
+    std::deque<uint8_t> _tx;
+    size_t _rxCapacity = 256;       // Arduino-ESP32 デフォルト
+    size_t _txBufferSize = 0;       // 0 = ハードウェアFIFOのみ
+    double _fifoLevel = 0.0;        // 送信FIFO内のバイト数
+    uint64_t _fifoStampUs = 0;
+    bool _echo = false;
+    uint32_t _rxOverruns = 0;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif // COROSUKE_NATIVE_HARDWARESERIAL_H
@@ -0,0 +1,25 @@
+/**
+ * コロ助ロボット - ネイティブHAL IPAddress代替
+ * Corosuke Robot - Native HAL IPAddress stand-in
+ */
+
+#ifndef COROSUKE_NATIVE_IPADDRESS_H
+#define COROSUKE_NATIVE_IPADDRESS_H
+
+#include <stdint.h>
+#include "Print.h"
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : IPAddress(0, 0, 0, 0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _octets[0] = a; _octets[1] = b; _octets[2] = c; _octets[3] = d; }
+
+    uint8_t operator[](int index) const { return _octets[index & 3]; }
+    String toString() const;
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t _octets[4];
+};
+
+#endif // COROSUKE_NATIVE_IPADDRESS_H
@@ -0,0 +1,82 @@
+/**
+ * コロ助ロボット - ネイティブHAL Arduino String代替
+ * Corosuke Robot - Native HAL String stand-in
+ */
+
+#ifndef COROSUKE_NATIVE_WSTRING_H
+#define COROSUKE_NATIVE_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* s) { if (s) _str = s; }
+    String(const char* s, unsigned int length) { if (s) _str.assign(s, length); }
+    String(const std::string& s) : _str(s) {}
+    String(char c) : _str(1, c) {}
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    String& operator=(const char* s) { if (s) _str = s; else _str.clear(); return *this; }
+
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return (unsigned int)_str.length(); }
+    bool reserve(unsigned int size) { _str.reserve(size); return true; }
+
+    bool concat(const String& s) { _str += s._str; return true; }
+    bool concat(const char* s) { if (s) _str += s; return true; }
+    bool concat(const char* s, unsigned int length) { if (s) _str.append(s, length); return true; }
+    bool concat(char c) { _str += c; return true; }
+    bool concat(int v) { return concat(String(v)); }
+    bool concat(unsigned int v) { return concat(String(v)); }
+    bool concat(long v) { return concat(String(v)); }
+    bool concat(unsigned long v) { return concat(String(v)); }
+    bool concat(float v) { return concat(String(v)); }
+    bool concat(double v) { return concat(String(v)); }
+
+    template <typename T>
+    String& operator+=(const T& v) { concat(v); return *this; }
+
+    bool operator==(const String& rhs) const { return _str == rhs._str; }
+    bool operator==(const char* rhs) const { return rhs ? _str == rhs : _str.empty(); }
+    bool operator!=(const String& rhs) const { return !(*this == rhs); }
+    bool operator!=(const char* rhs) const { return !(*this == rhs); }
+    bool operator<(const String& rhs) const { return _str < rhs._str; }
+
+    char operator[](unsigned int index) const { return index < _str.length() ? _str[index] : 0; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    bool startsWith(const String& prefix) const { return _str.compare(0, prefix._str.length(), prefix._str) == 0; }
+    bool endsWith(const String& suffix) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& s, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    long toInt() const;
+    float toFloat() const;
+    bool isEmpty() const { return _str.empty(); }
+
+private:
+    std::string _str;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+String operator+(const String& lhs, int rhs);
+String operator+(const String& lhs, unsigned int rhs);
+String operator+(const String& lhs, long rhs);
+String operator+(const String& lhs, unsigned long rhs);
+
+#endif // COROSUKE_NATIVE_WSTRING_H
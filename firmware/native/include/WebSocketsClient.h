@@ -0,0 +1,55 @@
+/**
+ * コロ助ロボット - ネイティブHAL arduinoWebSockets代替
+ * Corosuke Robot - Native HAL WebSocketsClient stand-in
+ *
+ * サーバーには接続しない（HTTPClient と同じく常に未接続）。
+ * イベントは一度も発生せず、送信は失敗する。
+ */
+
+#ifndef COROSUKE_NATIVE_WEBSOCKETSCLIENT_H
+#define COROSUKE_NATIVE_WEBSOCKETSCLIENT_H
+
+#include <Arduino.h>
+
+#include <functional>
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG
+} WStype_t;
+
+class WebSocketsClient {
+public:
+    typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+    void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino") {
+        (void)host; (void)port; (void)url; (void)protocol;
+    }
+    void onEvent(WebSocketClientEvent cbEvent) { _event = cbEvent; }
+    void setReconnectInterval(unsigned long time) { (void)time; }
+    void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {
+        (void)pingInterval; (void)pongTimeout; (void)disconnectTimeoutCount;
+    }
+    void loop() {}
+    bool isConnected() { return false; }
+    bool sendBIN(uint8_t* payload, size_t length, bool headerToPayload = false) {
+        (void)payload; (void)length; (void)headerToPayload;
+        return false;
+    }
+    bool sendTXT(const char* payload) { (void)payload; return false; }
+    void disconnect() {}
+
+private:
+    WebSocketClientEvent _event;
+};
+
+#endif // COROSUKE_NATIVE_WEBSOCKETSCLIENT_H
@@ -0,0 +1,44 @@
+/**
+ * コロ助ロボット - ネイティブHAL WiFi代替
+ * Corosuke Robot - Native HAL WiFi stand-in
+ *
+ * 常に即時接続済みとして振る舞う（ネットワークは使わない）。
+ */
+
+#ifndef COROSUKE_NATIVE_WIFI_H
+#define COROSUKE_NATIVE_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr) {
+        (void)ssid;
+        (void)passphrase;
+        _status = WL_CONNECTED;
+        return _status;
+    }
+    bool disconnect(bool wifiOff = false) { (void)wifiOff; _status = WL_DISCONNECTED; return true; }
+    wl_status_t status() const { return _status; }
+    bool isConnected() const { return _status == WL_CONNECTED; }
+    IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+    int8_t RSSI() const { return -50; }
+    bool setSleep(bool enabled) { (void)enabled; return true; }
+
+private:
+    wl_status_t _status = WL_IDLE_STATUS;
+};
+
+extern WiFiClass WiFi;
+
+#endif // COROSUKE_NATIVE_WIFI_H
@@ -0,0 +1,58 @@
+/**
+ * コロ助ロボット - ネイティブHAL Wire(I2C)代替
+ * Corosuke Robot - Native HAL TwoWire stand-in
+ *
+ * nativeHalAttachI2C() で登録したデバイスモデルへ転送する。
+ * 各トランザクションはバスクロックから求めた転送時間をチャージする
+ * （START + アドレス + データ各9ビット + STOP）。
+ */
+
+#ifndef COROSUKE_NATIVE_WIRE_H
+#define COROSUKE_NATIVE_WIRE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire : public Stream {
+public:
+    bool begin() { return begin(-1, -1, 0); }
+    bool begin(int sda, int scl, uint32_t frequency = 0);
+    bool end() { _started = false; return true; }
+    bool setClock(uint32_t frequency) { _clockHz = frequency; return true; }
+    uint32_t getClock() const { return _clockHz; }
+    void setTimeOut(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+
+    void beginTransmission(uint16_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    size_t requestFrom(uint16_t address, size_t size, bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t size) { return (uint8_t)requestFrom((uint16_t)address, (size_t)size, true); }
+    uint8_t requestFrom(int address, int size) { return (uint8_t)requestFrom((uint16_t)address, (size_t)size, true); }
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t size) override;
+    using Print::write;
+
+    int available() override { return (int)(_rxLength - _rxIndex); }
+    int read() override { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1; }
+    int peek() override { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1; }
+
+private:
+    void chargeBus(size_t bytes);
+
+    bool _started = false;
+    uint32_t _clockHz = 100000;
+    uint16_t _timeoutMs = 50;
+    uint16_t _txAddress = 0;
+    uint8_t _txBuffer[I2C_BUFFER_LENGTH];
+    size_t _txLength = 0;
+    uint8_t _rxBuffer[I2C_BUFFER_LENGTH];
+    size_t _rxLength = 0;
+    size_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // COROSUKE_NATIVE_WIRE_H
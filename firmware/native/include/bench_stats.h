@@ -0,0 +1,77 @@
+/**
+ * コロ助ロボット - ベンチマーク統計
+ * Corosuke Robot - Benchmark Statistics
+ *
+ * サンプル（ナノ秒）を貯めてパーセンタイルを出すだけの簡易集計。
+ * ボードのループベンチと firmware/bench の各ベンチで共用する。
+ */
+
+#ifndef COROSUKE_BENCH_STATS_H
+#define COROSUKE_BENCH_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// ホストの単調増加時計 (ns)
+static inline uint64_t benchNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class BenchStats {
+public:
+    void reserve(size_t n) { _samples.reserve(n); }
+    void add(uint64_t ns) { _samples.push_back(ns); _sum += ns; _sorted = false; }
+    void clear() { _samples.clear(); _sum = 0; _sorted = false; }
+    size_t count() const { return _samples.size(); }
+    uint64_t sum() const { return _sum; }
+    double mean() const { return _samples.empty() ? 0.0 : (double)_sum / _samples.size(); }
+
+    // p: 0.0〜1.0
+    uint64_t percentile(double p) {
+        if (_samples.empty()) return 0;
+        sort();
+        size_t index = (size_t)(p * (_samples.size() - 1) + 0.5);
+        return _samples[std::min(index, _samples.size() - 1)];
+    }
+
+    uint64_t max() {
+        if (_samples.empty()) return 0;
+        sort();
+        return _samples.back();
+    }
+
+    // 1行でパーセンタイルを出力（単位はμs）
+    void printUs(const char* label) {
+        printf("  %-28s p50 %9.2f  p90 %9.2f  p99 %9.2f  p99.9 %9.2f  max %10.2f us\n",
+               label,
+               percentile(0.50) / 1000.0, percentile(0.90) / 1000.0,
+               percentile(0.99) / 1000.0, percentile(0.999) / 1000.0,
+               max() / 1000.0);
+    }
+
+    // 1行でパーセンタイルを出力（単位はns）
+    void printNs(const char* label) {
+        printf("  %-28s p50 %9llu  p90 %9llu  p99 %9llu  max %10llu ns\n",
+               label,
+               (unsigned long long)percentile(0.50), (unsigned long long)percentile(0.90),
+               (unsigned long long)percentile(0.99), (unsigned long long)max());
+    }
+
+private:
+    void sort() {
+        if (!_sorted) {
+            std::sort(_samples.begin(), _samples.end());
+            _sorted = true;
+        }
+    }
+
+    std::vector<uint64_t> _samples;
+    uint64_t _sum = 0;
+    bool _sorted = false;
+};
+
+#endif // COROSUKE_BENCH_STATS_H
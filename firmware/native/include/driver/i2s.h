@@ -0,0 +1,80 @@
+/**
+ * コロ助ロボット - ネイティブHAL I2Sドライバ代替（受信のみ）
+ * Corosuke Robot - Native HAL legacy I2S driver stand-in (RX only)
+ *
+ * i2s_driver_install() した時刻から sample_rate でマイクの合成音が DMA に溜まっていき、
+ * i2s_read() は要求した分が溜まるまで（タスクなら vTaskDelay で）待つ。
+ * 読み出しが遅れて dma_buf_count * dma_buf_len を超えた分は古い方から捨てる（実機と同じ）。
+ * 値は INMP441 と同じく 32bit スロットの上位 24bit。
+ */
+
+#ifndef COROSUKE_NATIVE_DRIVER_I2S_H
+#define COROSUKE_NATIVE_DRIVER_I2S_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+
+#include "esp_err.h"
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 = 1, I2S_NUM_MAX } i2s_port_t;
+
+typedef enum {
+    I2S_MODE_MASTER = 1 << 0,
+    I2S_MODE_SLAVE  = 1 << 1,
+    I2S_MODE_TX     = 1 << 2,
+    I2S_MODE_RX     = 1 << 3
+} i2s_mode_t;
+
+typedef enum {
+    I2S_BITS_PER_SAMPLE_16BIT = 16,
+    I2S_BITS_PER_SAMPLE_24BIT = 24,
+    I2S_BITS_PER_SAMPLE_32BIT = 32
+} i2s_bits_per_sample_t;
+
+typedef enum {
+    I2S_CHANNEL_FMT_RIGHT_LEFT,
+    I2S_CHANNEL_FMT_ALL_RIGHT,
+    I2S_CHANNEL_FMT_ALL_LEFT,
+    I2S_CHANNEL_FMT_ONLY_RIGHT,
+    I2S_CHANNEL_FMT_ONLY_LEFT
+} i2s_channel_fmt_t;
+
+typedef enum {
+    I2S_COMM_FORMAT_STAND_I2S = 0x01,
+    I2S_COMM_FORMAT_STAND_MSB = 0x02
+} i2s_comm_format_t;
+
+#define I2S_PIN_NO_CHANGE       (-1)
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+
+typedef struct {
+    i2s_mode_t mode;
+    uint32_t sample_rate;
+    i2s_bits_per_sample_t bits_per_sample;
+    i2s_channel_fmt_t channel_format;
+    i2s_comm_format_t communication_format;
+    int intr_alloc_flags;
+    int dma_buf_count;
+    int dma_buf_len;                // バッファあたりのフレーム数
+    bool use_apll;
+    bool tx_desc_auto_clear;
+    int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+    int mck_io_num;
+    int bck_io_num;
+    int ws_io_num;
+    int data_out_num;
+    int data_in_num;
+} i2s_pin_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queueSize, void* queue);
+esp_err_t i2s_driver_uninstall(i2s_port_t port);
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pins);
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port);
+esp_err_t i2s_read(i2s_port_t port, void* dest, size_t size, size_t* bytesRead, TickType_t ticksToWait);
+
+#endif // COROSUKE_NATIVE_DRIVER_I2S_H
@@ -0,0 +1,16 @@
+/**
+ * コロ助ロボット - ネイティブHAL esp_err代替
+ * Corosuke Robot - Native HAL esp_err stand-in
+ */
+
+#ifndef COROSUKE_NATIVE_ESP_ERR_H
+#define COROSUKE_NATIVE_ESP_ERR_H
+
+typedef int esp_err_t;
+#define ESP_OK                  0
+#define ESP_FAIL                (-1)
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_TIMEOUT         0x107
+
+#endif // COROSUKE_NATIVE_ESP_ERR_H
@@ -0,0 +1,30 @@
+/**
+ * コロ助ロボット - ネイティブHAL FreeRTOS代替
+ * Corosuke Robot - Native HAL FreeRTOS stand-in
+ *
+ * ESP-IDF と同じ型・定数だけを用意する（tick = 1ms）。
+ */
+
+#ifndef COROSUKE_NATIVE_FREERTOS_H
+#define COROSUKE_NATIVE_FREERTOS_H
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+
+#define configTICK_RATE_HZ      1000
+#define configMAX_PRIORITIES    25
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000))
+
+#define tskNO_AFFINITY          ((BaseType_t)0x7FFFFFFF)
+
+#endif // COROSUKE_NATIVE_FREERTOS_H
@@ -0,0 +1,28 @@
+/**
+ * コロ助ロボット - ネイティブHAL FreeRTOSタスク代替
+ * Corosuke Robot - Native HAL FreeRTOS task stand-in
+ *
+ * タスクはホストのスレッドで動かすが、同時に動くのは常に1つだけで、
+ * 仮想時計に合わせてベンチマークドライバ（nativeHalRunTasks）から
+ * ブロックするまで実行される。ピン留めしたコアは loop() と別コアとみなし、
+ * タスクの実行時間は loop() の時間に加算しない。
+ */
+
+#ifndef COROSUKE_NATIVE_FREERTOS_TASK_H
+#define COROSUKE_NATIVE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct NativeTask* TaskHandle_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t coreId);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+TickType_t xTaskGetTickCount();
+BaseType_t xPortGetCoreID();
+
+#endif // COROSUKE_NATIVE_FREERTOS_TASK_H
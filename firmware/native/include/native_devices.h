@@ -0,0 +1,89 @@
+/**
+ * コロ助ロボット - ネイティブHAL I2Cデバイスモデル
+ * Corosuke Robot - Native HAL I2C Device Models
+ */
+
+#ifndef COROSUKE_NATIVE_DEVICES_H
+#define COROSUKE_NATIVE_DEVICES_H
+
+#include <stdint.h>
+#include "native_hal.h"
+
+// =============================================================================
+// PCA9685 (16ch PWM) - レジスタファイルとオートインクリメント
+// =============================================================================
+class NativePca9685 : public NativeI2CDevice {
+public:
+    NativePca9685();
+    bool onWrite(const uint8_t* data, size_t length) override;
+    size_t onRead(uint8_t* data, size_t length) override;
+
+    uint16_t channelOn(uint8_t channel) const;
+    uint16_t channelOff(uint8_t channel) const;
+    uint8_t reg(uint8_t address) const { return _regs[address]; }
+    uint32_t channelWrites(uint8_t channel) const { return _channelWrites[channel & 15]; }
+
+private:
+    uint8_t nextPointer(uint8_t pointer) const;
+
+    uint8_t _regs[256];
+    uint8_t _pointer = 0;
+    uint32_t _channelWrites[16];
+};
+
+// =============================================================================
+// 姿勢モデル（IMUモデルが参照する真値）
+// =============================================================================
+typedef struct {
+    float pitch;        // 度
+    float roll;         // 度
+    float yaw;          // 度
+    float gyroX;        // dps（ロール軸）
+    float gyroY;        // dps（ピッチ軸）
+    float gyroZ;        // dps（ヨー軸）
+} NativeImuState_t;
+
+// 現在の仮想時刻での姿勢（外部から上書きされていなければ緩やかな揺れ）
+NativeImuState_t nativeImuState();
+// 指定した仮想時刻での姿勢（FIFO にサンプルを貯めるセンサー用）
+NativeImuState_t nativeImuStateAt(uint64_t us);
+// シミュレータなどから姿勢を与える（override=false で内蔵の揺れに戻す）
+void nativeImuSetState(const NativeImuState_t& state, bool override = true);
+
+// =============================================================================
+// BNO055 - 姿勢モデルからレジスタ値を生成
+// =============================================================================
+class NativeBno055 : public NativeI2CDevice {
+public:
+    bool onWrite(const uint8_t* data, size_t length) override;
+    size_t onRead(uint8_t* data, size_t length) override;
+
+private:
+    void refresh();
+
+    uint8_t _regs[128] = {0};
+    uint8_t _pointer = 0;
+};
+
+// =============================================================================
+// MPU6050 - 姿勢モデルからサンプル周期ごとに FIFO へ貯める
+// =============================================================================
+class NativeMpu6050 : public NativeI2CDevice {
+public:
+    NativeMpu6050();
+    bool onWrite(const uint8_t* data, size_t length) override;
+    size_t onRead(uint8_t* data, size_t length) override;
+
+private:
+    void fillFifo();
+    void pushSample(const NativeImuState_t& s);
+
+    uint8_t _regs[128];
+    uint8_t _pointer = 0;
+    uint8_t _fifo[1024];
+    size_t _fifoHead = 0;
+    size_t _fifoLength = 0;
+    uint64_t _nextSampleUs = 0;
+};
+
+#endif // COROSUKE_NATIVE_DEVICES_H
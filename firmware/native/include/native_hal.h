@@ -0,0 +1,105 @@
+/**
+ * コロ助ロボット - ネイティブHAL 制御API
+ * Corosuke Robot - Native HAL Control API
+ *
+ * ホストPC上でファームウェアを動かすための仮想時計と周辺機器モデル。
+ * 時間はすべて仮想時間（μs）で、I2C・UART・LEDなど実機でCPUを
+ * ブロックする転送時間は「チャージ」として仮想時計を進める。
+ */
+
+#ifndef COROSUKE_NATIVE_HAL_H
+#define COROSUKE_NATIVE_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// 仮想時計
+// =============================================================================
+
+// 現在の仮想時刻 (μs)
+uint64_t nativeHalNowUs();
+
+// 仮想時計を進める（ブロックしない待ち）
+void nativeHalAdvanceUs(uint64_t us);
+
+// =============================================================================
+// ブロッキング時間のチャージ
+// =============================================================================
+typedef enum {
+    NATIVE_CHARGE_I2C = 0,      // I2Cバス転送
+    NATIVE_CHARGE_UART,         // UART送信FIFO待ち
+    NATIVE_CHARGE_LED,          // WS2812B転送
+    NATIVE_CHARGE_DELAY,        // delay()
+    NATIVE_CHARGE_OTHER,
+    NATIVE_CHARGE_IDLE,         // loop() が vTaskDelay で眠っている（ブロックではない）
+    NATIVE_CHARGE_COUNT
+} NativeChargeKind_t;
+
+// 実機でCPUがブロックされる時間を計上し、仮想時計を進める
+void nativeHalCharge(NativeChargeKind_t kind, uint32_t us);
+
+// 前回呼び出し以降にチャージされた合計時間を取得してリセット
+uint64_t nativeHalTakeChargedUs();
+
+// 種別ごとの累積チャージ時間 (μs)
+uint64_t nativeHalChargedTotalUs(NativeChargeKind_t kind);
+
+// =============================================================================
+// 周辺機器の統計
+// =============================================================================
+typedef struct {
+    uint32_t i2cTransactions;   // endTransmission/requestFrom 回数
+    uint32_t i2cBytes;          // アドレスを除く転送バイト数
+    uint32_t i2cErrors;         // NACKなど
+    uint32_t ledShows;          // FastLED.show() 回数
+    uint32_t uartTxBytes;       // 全UART送信バイト数
+    uint32_t uartRxBytes;       // 全UART受信バイト数
+} NativeHalStats_t;
+
+const NativeHalStats_t& nativeHalStats();
+void nativeHalResetStats();
+
+// =============================================================================
+// I2Cデバイスモデル
+// =============================================================================
+class NativeI2CDevice {
+public:
+    virtual ~NativeI2CDevice() {}
+    // マスターからの書き込み（レジスタアドレス + データ）
+    virtual bool onWrite(const uint8_t* data, size_t length) = 0;
+    // マスターへの読み出し
+    virtual size_t onRead(uint8_t* data, size_t length) = 0;
+};
+
+void nativeHalAttachI2C(uint8_t address, NativeI2CDevice* device);
+NativeI2CDevice* nativeHalI2CDevice(uint8_t address);
+
+// 次のn回のI2Cトランザクションを失敗させる（バスエラー注入）
+void nativeHalInjectI2CErrors(uint32_t count);
+
+// =============================================================================
+// FreeRTOSタスク（ベンチマークドライバから呼ぶ）
+// =============================================================================
+typedef struct {
+    const char* name;
+    int core;
+    uint32_t runs;              // ブロックするまでの実行回数
+    uint64_t totalExecUs;       // 仮想時間での実行時間
+    uint32_t maxExecUs;
+    uint32_t maxLateUs;         // 起床予定時刻からの遅れ（前回の実行が食い込んだ分）
+} NativeTaskStats_t;
+
+// 起床時刻を過ぎたタスクを順に実行する。タスクは loop() と別のコアで
+// 動くものとして扱い、終わったら仮想時計とチャージ時間を元に戻す
+void nativeHalRunTasks();
+
+size_t nativeHalTaskCount();
+const NativeTaskStats_t& nativeHalTaskStats(size_t index);
+
+// =============================================================================
+// 初期化（ベンチマークドライバから呼ぶ）
+// =============================================================================
+void nativeHalInit();
+
+#endif // COROSUKE_NATIVE_HAL_H
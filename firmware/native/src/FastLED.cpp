@@ -0,0 +1,36 @@
+/**
+ * コロ助ロボット - ネイティブHAL FastLED実装
+ * Corosuke Robot - Native HAL FastLED Implementation
+ */
+
+#include <FastLED.h>
+#include "native_internal.h"
+
+// WS2812B: 1ビット1.25μs × 24ビット、ラッチに50μs
+#define NATIVE_WS2812_US_PER_LED_X100 3000
+#define NATIVE_WS2812_RESET_US        50
+
+CFastLED FastLED;
+
+CLEDController& CFastLED::registerController(CRGB* data, int numLeds) {
+    CLEDController& controller = _controllers[_count < NATIVE_FASTLED_MAX_CONTROLLERS ? _count++ : _count - 1];
+    controller.leds = data;
+    controller.numLeds = numLeds;
+    return controller;
+}
+
+void CFastLED::show() {
+    uint32_t us = 0;
+    for (int i = 0; i < _count; i++) {
+        us += (uint32_t)(_controllers[i].numLeds * NATIVE_WS2812_US_PER_LED_X100 / 100) + NATIVE_WS2812_RESET_US;
+    }
+    nativeHalCharge(NATIVE_CHARGE_LED, us);
+    nativeHalMutableStats().ledShows++;
+}
+
+void CFastLED::clear(bool writeData) {
+    for (int i = 0; i < _count; i++) {
+        fill_solid(_controllers[i].leds, _controllers[i].numLeds, CRGB::Black);
+    }
+    if (writeData) show();
+}
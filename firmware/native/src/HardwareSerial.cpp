@@ -0,0 +1,120 @@
+/**
+ * コロ助ロボット - ネイティブHAL HardwareSerial実装
+ * Corosuke Robot - Native HAL HardwareSerial Implementation
+ */
+
+#include <stdio.h>
+#include <Arduino.h>
+#include "native_internal.h"
+
+// ESP32 UARTのハードウェア送信FIFO
+#define NATIVE_UART_HW_FIFO 128
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin,
+                           bool invert, unsigned long timeoutMs) {
+    (void)config; (void)rxPin; (void)txPin; (void)invert; (void)timeoutMs;
+    _baud = baud;
+    _fifoLevel = 0.0;
+    _fifoStampUs = nativeHalNowUs();
+}
+
+void HardwareSerial::updateBaudRate(unsigned long baud) {
+    drainFifo();
+    _baud = baud;
+}
+
+int HardwareSerial::read() {
+    if (_rx.empty()) return -1;
+    uint8_t b = _rx.front();
+    _rx.pop_front();
+    return b;
+}
+
+size_t HardwareSerial::read(uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && !_rx.empty()) {
+        buffer[n++] = _rx.front();
+        _rx.pop_front();
+    }
+    return n;
+}
+
+void HardwareSerial::drainFifo() {
+    uint64_t now = nativeHalNowUs();
+    if (_baud > 0 && now > _fifoStampUs) {
+        double drained = (double)(now - _fifoStampUs) * _baud / 10.0 / 1e6;
+        _fifoLevel = drained >= _fifoLevel ? 0.0 : _fifoLevel - drained;
+    }
+    _fifoStampUs = now;
+}
+
+int HardwareSerial::availableForWrite() {
+    drainFifo();
+    double room = (double)(NATIVE_UART_HW_FIFO + _txBufferSize) - _fifoLevel;
+    return room > 0 ? (int)room : 0;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (_echo) {
+        fwrite(buffer, 1, size, stdout);
+    }
+    for (size_t i = 0; i < size; i++) {
+        _tx.push_back(buffer[i]);
+    }
+    // 取り出されない送信データは古い方から捨てる
+    while (_tx.size() > 65536) {
+        _tx.pop_front();
+    }
+    nativeHalMutableStats().uartTxBytes += (uint32_t)size;
+
+    // FIFOに入りきらない分は送信完了までブロックする
+    if (_baud > 0) {
+        drainFifo();
+        double capacity = (double)(NATIVE_UART_HW_FIFO + _txBufferSize);
+        _fifoLevel += (double)size;
+        if (_fifoLevel > capacity) {
+            double overflow = _fifoLevel - capacity;
+            uint32_t blockUs = (uint32_t)(overflow * 10.0 * 1e6 / _baud);
+            nativeHalCharge(NATIVE_CHARGE_UART, blockUs);
+            _fifoStampUs = nativeHalNowUs();
+            _fifoLevel = capacity;
+        }
+    }
+    return size;
+}
+
+void HardwareSerial::flush() {
+    drainFifo();
+    if (_baud > 0 && _fifoLevel > 0.0) {
+        nativeHalCharge(NATIVE_CHARGE_UART, (uint32_t)(_fifoLevel * 10.0 * 1e6 / _baud));
+        _fifoLevel = 0.0;
+        _fifoStampUs = nativeHalNowUs();
+    }
+}
+
+size_t HardwareSerial::nativeInjectRx(const uint8_t* data, size_t length) {
+    size_t accepted = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (_rx.size() >= _rxCapacity) {
+            _rxOverruns++;
+            continue;
+        }
+        _rx.push_back(data[i]);
+        accepted++;
+    }
+    nativeHalMutableStats().uartRxBytes += (uint32_t)accepted;
+    return accepted;
+}
+
+size_t HardwareSerial::nativeTakeTx(uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && !_tx.empty()) {
+        buffer[n++] = _tx.front();
+        _tx.pop_front();
+    }
+    return n;
+}
@@ -0,0 +1,74 @@
+/**
+ * コロ助ロボット - ネイティブHAL Print/Stream実装
+ * Corosuke Robot - Native HAL Print/Stream Implementation
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <Arduino.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (write(*buffer++)) n++;
+        else break;
+    }
+    return n;
+}
+
+size_t Print::write(const char* str) {
+    if (!str) return 0;
+    return write((const uint8_t*)str, strlen(str));
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if ((size_t)len >= sizeof(buffer)) len = sizeof(buffer) - 1;
+    return write((const uint8_t*)buffer, (size_t)len);
+}
+
+size_t Print::print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+size_t Print::print(const char* s) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(long n, int base) { return print(String(n, (unsigned char)base)); }
+size_t Print::print(unsigned long n, int base) { return print(String(n, (unsigned char)base)); }
+size_t Print::print(long long n, int base) { return print(String((long)n, (unsigned char)base)); }
+size_t Print::print(unsigned long long n, int base) { return print(String((unsigned long)n, (unsigned char)base)); }
+size_t Print::print(double n, int digits) { return print(String(n, (unsigned char)digits)); }
+size_t Print::println() { return write((const uint8_t*)"\r\n", 2); }
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) break;
+        buffer[count++] = (uint8_t)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String ret;
+    int c;
+    while ((c = read()) >= 0) ret += (char)c;
+    return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String ret;
+    int c;
+    while ((c = read()) >= 0 && (char)c != terminator) ret += (char)c;
+    return ret;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _octets[0], _octets[1], _octets[2], _octets[3]);
+    return String(buffer);
+}
@@ -0,0 +1,109 @@
+/**
+ * コロ助ロボット - ネイティブHAL String実装
+ * Corosuke Robot - Native HAL String Implementation
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "WString.h"
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2) base = 10;
+    char buffer[72];
+    int pos = sizeof(buffer) - 1;
+    buffer[pos] = '\0';
+    do {
+        unsigned digit = (unsigned)(value % base);
+        buffer[--pos] = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value && pos > 1);
+    if (negative) buffer[--pos] = '-';
+    return std::string(&buffer[pos]);
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        _str = formatInteger((unsigned long long)(-(long long)value), true, base);
+    } else {
+        _str = formatInteger((unsigned long)value, false, base);
+    }
+}
+
+String::String(unsigned long value, unsigned char base) {
+    _str = formatInteger(value, false, base);
+}
+
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned char decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    _str = buffer;
+}
+
+bool String::endsWith(const String& suffix) const {
+    if (suffix._str.length() > _str.length()) return false;
+    return _str.compare(_str.length() - suffix._str.length(), suffix._str.length(), suffix._str) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _str.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+    size_t pos = _str.find(s._str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    return substring(from, length());
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        unsigned int tmp = from;
+        from = to;
+        to = tmp;
+    }
+    if (from >= _str.length()) return String();
+    if (to > _str.length()) to = (unsigned int)_str.length();
+    return String(_str.substr(from, to - from));
+}
+
+void String::trim() {
+    size_t begin = 0;
+    while (begin < _str.length() && isspace((unsigned char)_str[begin])) begin++;
+    size_t end = _str.length();
+    while (end > begin && isspace((unsigned char)_str[end - 1])) end--;
+    _str = _str.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+    for (char& c : _str) c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : _str) c = (char)toupper((unsigned char)c);
+}
+
+long String::toInt() const {
+    return atol(_str.c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(_str.c_str());
+}
+
+String operator+(const String& lhs, const String& rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, const char* rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const char* lhs, const String& rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, char rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned long rhs) { String s(lhs); s.concat(rhs); return s; }
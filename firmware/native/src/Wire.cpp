@@ -0,0 +1,84 @@
+/**
+ * コロ助ロボット - ネイティブHAL TwoWire実装
+ * Corosuke Robot - Native HAL TwoWire Implementation
+ */
+
+#include <Wire.h>
+#include "native_internal.h"
+
+// ESP32 I2Cドライバのトランザクションあたりのソフトウェアオーバーヘッド（概算）
+#define NATIVE_I2C_TXN_OVERHEAD_US 30
+
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    (void)sda;
+    (void)scl;
+    if (frequency) _clockHz = frequency;
+    _started = true;
+    return true;
+}
+
+void TwoWire::chargeBus(size_t bytes) {
+    // START + (アドレス + データ) × 9ビット + STOP
+    uint64_t bits = 2 + (bytes + 1) * 9;
+    uint32_t us = (uint32_t)(bits * 1000000ULL / (_clockHz ? _clockHz : 100000)) + NATIVE_I2C_TXN_OVERHEAD_US;
+    nativeHalCharge(NATIVE_CHARGE_I2C, us);
+
+    NativeHalStats_t& stats = nativeHalMutableStats();
+    stats.i2cTransactions++;
+    stats.i2cBytes += (uint32_t)bytes;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+    _txAddress = address;
+    _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLength >= I2C_BUFFER_LENGTH) return 0;
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+    size_t n = 0;
+    while (n < size && write(data[n])) n++;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    chargeBus(_txLength);
+
+    NativeI2CDevice* device = nativeHalI2CDevice((uint8_t)_txAddress);
+    if (!_started || nativeHalConsumeI2CError()) {
+        nativeHalMutableStats().i2cErrors++;
+        return 4;   // その他のエラー
+    }
+    if (!device) {
+        nativeHalMutableStats().i2cErrors++;
+        return 2;   // アドレスNACK
+    }
+    if (!device->onWrite(_txBuffer, _txLength)) {
+        nativeHalMutableStats().i2cErrors++;
+        return 3;   // データNACK
+    }
+    return 0;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t size, bool sendStop) {
+    (void)sendStop;
+    if (size > I2C_BUFFER_LENGTH) size = I2C_BUFFER_LENGTH;
+    chargeBus(size);
+
+    _rxIndex = 0;
+    _rxLength = 0;
+    NativeI2CDevice* device = nativeHalI2CDevice((uint8_t)address);
+    if (!_started || !device || nativeHalConsumeI2CError()) {
+        nativeHalMutableStats().i2cErrors++;
+        return 0;
+    }
+    _rxLength = device->onRead(_rxBuffer, size);
+    return _rxLength;
+}
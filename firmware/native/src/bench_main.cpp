@@ -0,0 +1,204 @@
+/**
+ * コロ助ロボット - ネイティブループベンチマーク
+ * Corosuke Robot - Native Loop Benchmark Driver
+ *
+ * setup() の後、仮想時計を進めながら loop() を繰り返し呼び、
+ * 1回あたりの所要時間（ホストCPU時間 + 周辺機器のブロッキング時間モデル）の
+ * パーセンタイルとスループットを出力する。
+ *
+ * 使い方:
+ *   pio run -e native -t exec
+ *   .pio/build/native/program [--duration-ms N] [--step-us N] [--no-stimulus]
+ * 環境変数 COROSUKE_BENCH_DURATION_MS でも仮想時間を指定できる。
+ *
+ * firmware/bench のように独自の main() を持つプロジェクトでは
+ * COROSUKE_NATIVE_NO_LOOP_DRIVER を定義してこのドライバを外す。
+ */
+
+#ifndef COROSUKE_NATIVE_NO_LOOP_DRIVER
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_stats.h"
+#include "native_devices.h"
+#include "../../common/config.h"
+#include "../../common/protocol.h"
+
+#ifndef COROSUKE_BOARD_NAME
+#define COROSUKE_BOARD_NAME "firmware"
+#endif
+
+// =============================================================================
+// 受信刺激（Serial1/Serial2 へ一定周期でパケットを流し込む）
+// =============================================================================
+typedef struct {
+    uint32_t startMs;       // 最初の送信時刻
+    uint32_t periodMs;      // 0 = 1回だけ
+    uint8_t cmd;
+    uint8_t length;
+    uint8_t data[8];
+} BenchStimulus_t;
+
+static const BenchStimulus_t benchStimuli[] = {
+    {     0,  1000, CMD_PING,           0, {0} },
+    {    20,    20, CMD_LIPSYNC_DATA,   1, {40} },
+    {   100,   100, CMD_LOOK_AT,        2, {10, (uint8_t)-10} },
+    {   500,  4000, CMD_EXPRESSION,     4, {EXPR_HAPPY, 100, 0xB8, 0x0B} },
+    {  2500,  4000, CMD_EXPRESSION,     4, {EXPR_NEUTRAL, 100, 0x00, 0x00} },
+    {  1000,     0, CMD_WALK_START,     1, {0} },
+    {  5000, 10000, CMD_WALK_DIRECTION, 3, {WALK_BACKWARD, 70, 0} },
+    { 10000, 10000, CMD_WALK_DIRECTION, 3, {WALK_FORWARD, 50, 0} },
+    { 15000,     0, CMD_WAVE,           1, {0} },
+};
+
+static void injectPacket(uint8_t cmd, const uint8_t* data, uint8_t length) {
+    uint8_t packet[PACKET_MAX_SIZE];
+    uint8_t idx = 0;
+
+    packet[idx++] = PACKET_START;
+    packet[idx++] = length + 1;
+    packet[idx++] = cmd;
+    for (uint8_t i = 0; i < length; i++) {
+        packet[idx++] = data[i];
+    }
+    packet[idx] = calculateChecksum(&packet[1], idx - 1);
+    idx++;
+    packet[idx++] = PACKET_END;
+
+    Serial1.nativeInjectRx(packet, idx);
+    Serial2.nativeInjectRx(packet, idx);
+}
+
+// [fromMs, toMs] に入った送信時刻の数だけパケットを流し込む
+static void runStimuli(uint32_t fromMs, uint32_t toMs) {
+    for (size_t i = 0; i < sizeof(benchStimuli) / sizeof(benchStimuli[0]); i++) {
+        const BenchStimulus_t& s = benchStimuli[i];
+        if (toMs < s.startMs) continue;
+
+        uint32_t due;
+        if (s.periodMs == 0) {
+            due = fromMs <= s.startMs ? 1 : 0;
+        } else {
+            uint32_t first = fromMs <= s.startMs ? 0 : (fromMs - s.startMs + s.periodMs - 1) / s.periodMs;
+            uint32_t last = (toMs - s.startMs) / s.periodMs;
+            due = last >= first ? last - first + 1 : 0;
+        }
+        for (uint32_t k = 0; k < due; k++) {
+            injectPacket(s.cmd, s.data, s.length);
+        }
+    }
+}
+
+// =============================================================================
+// メイン
+// =============================================================================
+static uint32_t argValue(int argc, char** argv, const char* name, uint32_t fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    }
+    return fallback;
+}
+
+static bool argFlag(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    const char* envDuration = getenv("COROSUKE_BENCH_DURATION_MS");
+    uint32_t durationMs = argValue(argc, argv, "--duration-ms", envDuration ? (uint32_t)atol(envDuration) : 20000);
+    uint32_t stepUs = argValue(argc, argv, "--step-us", 1000);
+    bool stimulus = !argFlag(argc, argv, "--no-stimulus");
+    if (stepUs == 0) stepUs = 1;
+
+    nativeHalInit();
+
+    uint64_t setupStartNs = benchNowNs();
+    setup();
+    uint64_t setupNs = benchNowNs() - setupStartNs;
+    uint64_t setupVirtualUs = nativeHalNowUs();
+
+    nativeHalResetStats();
+
+    BenchStats total;
+    BenchStats cpuOnly;
+    total.reserve((size_t)durationMs * 1000 / stepUs + 16);
+    cpuOnly.reserve((size_t)durationMs * 1000 / stepUs + 16);
+
+    const uint64_t startUs = nativeHalNowUs();
+    const uint64_t endUs = startUs + (uint64_t)durationMs * 1000;
+    uint32_t nextStimulusMs = 0;
+    uint64_t wallStartNs = benchNowNs();
+    uint64_t cpuSumNs = 0;
+
+    while (nativeHalNowUs() < endUs) {
+        const uint64_t tickStartUs = nativeHalNowUs();
+        const uint32_t nowMs = (uint32_t)((tickStartUs - startUs) / 1000);
+        if (stimulus && nowMs >= nextStimulusMs) {
+            runStimuli(nextStimulusMs, nowMs);
+            nextStimulusMs = nowMs + 1;
+        }
+
+        nativeHalTakeChargedUs();
+        uint64_t t0 = benchNowNs();
+        loop();
+        uint64_t cpuNs = benchNowNs() - t0;
+        uint64_t blockedUs = nativeHalTakeChargedUs();
+
+        cpuOnly.add(cpuNs);
+        total.add(cpuNs + blockedUs * 1000);
+        cpuSumNs += cpuNs;
+
+        // 別コアのタスクを今の時刻まで進める（loop() の時間には含めない）
+        nativeHalRunTasks();
+
+        // ブロッキングで時計が進んでいなければ1ステップ進める
+        if (nativeHalNowUs() < tickStartUs + stepUs) {
+            nativeHalAdvanceUs(tickStartUs + stepUs - nativeHalNowUs());
+        }
+    }
+
+    const uint64_t wallNs = benchNowNs() - wallStartNs;
+    const double virtualSec = (nativeHalNowUs() - startUs) / 1e6;
+    const NativeHalStats_t& stats = nativeHalStats();
+
+    printf("\n=== コロ助 native loop benchmark: %s ===\n", COROSUKE_BOARD_NAME);
+    printf("  setup()                      host %.2f ms, virtual %.2f ms\n", setupNs / 1e6, setupVirtualUs / 1e3);
+    printf("  仮想時間                     %.3f s (step %u us, stimulus %s)\n", virtualSec, stepUs, stimulus ? "on" : "off");
+    printf("  loop() 呼び出し              %zu 回\n", total.count());
+    printf("loop() latency\n");
+    total.printUs("host CPU + modeled I/O");
+    cpuOnly.printUs("host CPU only");
+    printf("throughput\n");
+    printf("  %-28s %.0f loops/s (host CPU only)\n", "loop()", cpuSumNs ? total.count() * 1e9 / cpuSumNs : 0.0);
+    printf("  %-28s %.2fx real time (wall %.3f s)\n", "simulation", virtualSec / (wallNs / 1e9), wallNs / 1e9);
+    printf("modeled blocking time (share of virtual time)\n");
+    const char* kindNames[NATIVE_CHARGE_COUNT] = {"I2C", "UART TX", "LED show", "delay()", "other", "idle (vTaskDelay)"};
+    for (int k = 0; k < NATIVE_CHARGE_COUNT; k++) {
+        uint64_t us = nativeHalChargedTotalUs((NativeChargeKind_t)k);
+        printf("  %-28s %10.3f ms  (%5.2f%%)\n", kindNames[k], us / 1e3, virtualSec > 0 ? us / 1e4 / virtualSec : 0.0);
+    }
+    printf("peripherals\n");
+    printf("  %-28s %u (%.1f /s), %u bytes, %u errors\n", "I2C transactions",
+           stats.i2cTransactions, stats.i2cTransactions / virtualSec, stats.i2cBytes, stats.i2cErrors);
+    printf("  %-28s %.1f us per %d ms servo tick\n", "I2C bus time",
+           nativeHalChargedTotalUs(NATIVE_CHARGE_I2C) / (virtualSec * 1000.0 / SERVO_UPDATE_INTERVAL_MS),
+           SERVO_UPDATE_INTERVAL_MS);
+    printf("  %-28s %u\n", "LED shows", stats.ledShows);
+    printf("  %-28s tx %u bytes, rx %u bytes\n", "UART", stats.uartTxBytes, stats.uartRxBytes);
+    if (nativeHalTaskCount() > 0) {
+        printf("FreeRTOS tasks (modeled on their own core)\n");
+    }
+    for (size_t i = 0; i < nativeHalTaskCount(); i++) {
+        const NativeTaskStats_t& task = nativeHalTaskStats(i);
+        printf("  %-28s core %d, %u runs, exec mean %.1f us max %u us, max late %u us\n",
+               task.name, task.core, task.runs, task.runs ? (double)task.totalExecUs / task.runs : 0.0,
+               task.maxExecUs, task.maxLateUs);
+    }
+    return 0;
+}
+
+#endif // COROSUKE_NATIVE_NO_LOOP_DRIVER
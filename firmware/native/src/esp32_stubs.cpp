@@ -0,0 +1,275 @@
+/**
+ * コロ助ロボット - ネイティブHAL メインボード周辺機器スタブ
+ * Corosuke Robot - Native HAL Main Board Peripheral Stubs
+ */
+
+#include <string.h>
+#include <WiFi.h>
+#include <driver/i2s.h>
+#include <freertos/task.h>
+#include "esp_camera.h"
+#include "Audio.h"
+
+WiFiClass WiFi;
+
+// =============================================================================
+// カメラ - 設定された解像度の合成フレームを返す
+// グレースケールでは、NATIVE_PERSON_PERIOD_MS ごとに人物（頭と胴体の明るい塊）が
+// 左右に横切るシーンを描く。fb_count が 2 以上なら 2 面を交互に使う
+// =============================================================================
+#define NATIVE_PERSON_PERIOD_MS 8000    // 前半は無人、後半に人物が横切る
+
+static camera_config_t cameraConfig;
+static bool cameraReady = false;
+static camera_fb_t frameBuffers[2];
+static uint8_t frameData[2][320 * 240];
+static uint8_t nextFrame = 0;
+static uint32_t noiseState = 12345;
+
+static void frameSizeToDimensions(framesize_t size, size_t* width, size_t* height) {
+    switch (size) {
+        case FRAMESIZE_96X96:   *width = 96;  *height = 96;  break;
+        case FRAMESIZE_QQVGA:   *width = 160; *height = 120; break;
+        case FRAMESIZE_QCIF:    *width = 176; *height = 144; break;
+        case FRAMESIZE_HQVGA:   *width = 240; *height = 176; break;
+        case FRAMESIZE_240X240: *width = 240; *height = 240; break;
+        default:                *width = 320; *height = 240; break;
+    }
+}
+
+static void fillRect(uint8_t* frame, size_t width, size_t height, int x0, int y0, int x1, int y1, uint8_t value) {
+    for (int y = std::max(y0, 0); y < std::min(y1, (int)height); y++) {
+        for (int x = std::max(x0, 0); x < std::min(x1, (int)width); x++) {
+            frame[y * width + x] = value;
+        }
+    }
+}
+
+static void drawScene(uint8_t* frame, size_t width, size_t height) {
+    // 背景: 横方向のグラデーション + 少しのノイズ
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            noiseState = noiseState * 1103515245 + 12345;
+            frame[y * width + x] = (uint8_t)(60 + x * 40 / width + ((noiseState >> 16) & 7));
+        }
+    }
+
+    uint32_t t = (uint32_t)(nativeHalNowUs() / 1000) % NATIVE_PERSON_PERIOD_MS;
+    if (t < NATIVE_PERSON_PERIOD_MS / 2) return;
+
+    // 人物: 画面幅の 1/5、左端から右端へ
+    int w = (int)width / 5;
+    int span = (int)width - w;
+    int x = (int)((t - NATIVE_PERSON_PERIOD_MS / 2) * span / (NATIVE_PERSON_PERIOD_MS / 2));
+    int top = (int)height / 6;
+    int head = w * 2 / 3;
+    fillRect(frame, width, height, x + (w - head) / 2, top, x + (w + head) / 2, top + head, 200);
+    fillRect(frame, width, height, x, top + head, x + w, (int)height, 170);
+}
+
+esp_err_t esp_camera_init(const camera_config_t* config) {
+    cameraConfig = *config;
+    cameraReady = true;
+    nextFrame = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+    cameraReady = false;
+    return ESP_OK;
+}
+
+camera_fb_t* esp_camera_fb_get() {
+    if (!cameraReady) return nullptr;
+
+    size_t width, height;
+    frameSizeToDimensions(cameraConfig.frame_size, &width, &height);
+
+    camera_fb_t& frameBuffer = frameBuffers[nextFrame];
+    frameBuffer.buf = frameData[nextFrame];
+    frameBuffer.width = width;
+    frameBuffer.height = height;
+    frameBuffer.format = cameraConfig.pixel_format;
+    if (cameraConfig.fb_count >= 2) nextFrame ^= 1;
+
+    if (cameraConfig.pixel_format == PIXFORMAT_JPEG) {
+        // 中身はダミー（JPEGとしては解釈しない）
+        frameBuffer.len = width * height / 10;
+        memset(frameBuffer.buf, 0x80, frameBuffer.len);
+    } else if (cameraConfig.pixel_format == PIXFORMAT_GRAYSCALE) {
+        frameBuffer.len = width * height;
+        drawScene(frameBuffer.buf, width, height);
+    } else {
+        frameBuffer.len = width * height;
+        memset(frameBuffer.buf, 0x80, frameBuffer.len);
+    }
+    return &frameBuffer;
+}
+
+void esp_camera_fb_return(camera_fb_t* fb) {
+    (void)fb;
+}
+
+// =============================================================================
+// オーディオ - 合成音声を仮想時間に合わせてコールバックへ流す
+// =============================================================================
+#define NATIVE_AUDIO_SECONDS    3
+#define NATIVE_AUDIO_CHUNK      1024    // 1回のコールバックのフレーム数
+
+bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
+    (void)host; (void)user; (void)pwd;
+    _running = true;
+    _startUs = nativeHalNowUs();
+    _framesPlayed = 0;
+    return true;
+}
+
+void Audio::loop() {
+    if (!_running) return;
+
+    const uint32_t rate = getSampleRate();
+    const uint32_t total = rate * NATIVE_AUDIO_SECONDS;
+    uint32_t due = (uint32_t)((nativeHalNowUs() - _startUs) * rate / 1000000);
+    if (due > total) due = total;
+
+    static int16_t buffer[NATIVE_AUDIO_CHUNK * 2];
+    while (due - _framesPlayed >= NATIVE_AUDIO_CHUNK || (due == total && _framesPlayed < total)) {
+        uint32_t frames = std::min<uint32_t>(NATIVE_AUDIO_CHUNK, total - _framesPlayed);
+        for (uint32_t i = 0; i < frames; i++) {
+            // 180Hz の声 + 4Hz の音節、音節の合間は無音
+            double t = (double)(_framesPlayed + i) / rate;
+            double syllable = sin(2 * M_PI * 4 * t);
+            double envelope = syllable > 0.2 ? syllable : 0.0;
+            double voice = sin(2 * M_PI * 180 * t) + 0.5 * sin(2 * M_PI * 360 * t);
+            int16_t sample = (int16_t)(envelope * voice * 12000);
+            buffer[2 * i] = sample;
+            buffer[2 * i + 1] = sample;
+        }
+        if (audio_process_i2s) {
+            bool continueI2S = true;
+            audio_process_i2s(buffer, (uint16_t)frames, 16, 2, &continueI2S);
+        }
+        _framesPlayed += frames;
+    }
+
+    if (_framesPlayed >= total) {
+        _running = false;
+        if (audio_eof_mp3) audio_eof_mp3("native");
+    }
+}
+
+// =============================================================================
+// マイク（I2S 受信）- NATIVE_VOICE_PERIOD_MS ごとに同じ場面を繰り返す
+// 部屋の雑音と DC オフセットに、ノック（短い広帯域の音）と 2.5 秒の発話が乗る
+// =============================================================================
+#define NATIVE_VOICE_PERIOD_MS  12000
+#define NATIVE_KNOCK_MS         2000    // 25ms のノックを 150ms 間隔で2回
+#define NATIVE_SPEECH_START_MS  5000
+#define NATIVE_SPEECH_END_MS    7500
+#define NATIVE_MIC_SHIFT        14      // 16bit の音を INMP441 の 32bit スロットの大きさへ
+
+typedef struct {
+    bool installed;
+    i2s_config_t config;
+    uint64_t startUs;
+    uint64_t readFrames;        // 読み出した（または溢れて捨てた）フレーム数
+    uint32_t overruns;
+} NativeI2SPort_t;
+
+static NativeI2SPort_t i2sPorts[I2S_NUM_MAX];
+
+static uint32_t hashSample(uint64_t n) {
+    uint32_t x = (uint32_t)n * 2654435761u ^ (uint32_t)(n >> 32);
+    x ^= x >> 15;
+    x *= 2246822519u;
+    x ^= x >> 13;
+    return x;
+}
+
+// n 番目のサンプル（16bit 相当）
+static int32_t micSample(uint64_t n, uint32_t rate) {
+    double t = (double)n / rate;
+    uint32_t ms = (uint32_t)(n * 1000 / rate) % NATIVE_VOICE_PERIOD_MS;
+    double sample = 300.0 + ((int32_t)(hashSample(n) & 0x1FF) - 256) * 0.6;
+
+    for (uint32_t knock = NATIVE_KNOCK_MS; knock <= NATIVE_KNOCK_MS + 150; knock += 150) {
+        if (ms >= knock && ms < knock + 25) {
+            double decay = 1.0 - (ms - knock) / 25.0;
+            sample += ((int32_t)(hashSample(n + 7) & 0x3FFF) - 8192) * decay;
+        }
+    }
+
+    if (ms >= NATIVE_SPEECH_START_MS && ms < NATIVE_SPEECH_END_MS) {
+        // 140Hz の声 + 倍音、4Hz の音節（音節の合間は息継ぎ程度に小さく）
+        double syllable = sin(2 * M_PI * 4 * t);
+        double envelope = syllable > 0.1 ? syllable : 0.05;
+        double voice = sin(2 * M_PI * 140 * t) + 0.6 * sin(2 * M_PI * 280 * t) + 0.3 * sin(2 * M_PI * 700 * t);
+        sample += envelope * voice * 5000;
+    }
+    return (int32_t)sample;
+}
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queueSize, void* queue) {
+    (void)queueSize; (void)queue;
+    if (port >= I2S_NUM_MAX || !config || config->sample_rate == 0) return ESP_ERR_INVALID_ARG;
+    NativeI2SPort_t& p = i2sPorts[port];
+    if (p.installed) return ESP_ERR_INVALID_STATE;
+    p.installed = true;
+    p.config = *config;
+    p.startUs = nativeHalNowUs();
+    p.readFrames = 0;
+    p.overruns = 0;
+    return ESP_OK;
+}
+
+esp_err_t i2s_driver_uninstall(i2s_port_t port) {
+    if (port >= I2S_NUM_MAX || !i2sPorts[port].installed) return ESP_ERR_INVALID_STATE;
+    i2sPorts[port].installed = false;
+    return ESP_OK;
+}
+
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pins) {
+    if (port >= I2S_NUM_MAX || !pins) return ESP_ERR_INVALID_ARG;
+    return i2sPorts[port].installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port) {
+    if (port >= I2S_NUM_MAX || !i2sPorts[port].installed) return ESP_ERR_INVALID_STATE;
+    return ESP_OK;
+}
+
+esp_err_t i2s_read(i2s_port_t port, void* dest, size_t size, size_t* bytesRead, TickType_t ticksToWait) {
+    *bytesRead = 0;
+    if (port >= I2S_NUM_MAX || !i2sPorts[port].installed) return ESP_ERR_INVALID_STATE;
+    NativeI2SPort_t& p = i2sPorts[port];
+    const uint32_t rate = p.config.sample_rate;
+    const size_t slotBytes = p.config.bits_per_sample == I2S_BITS_PER_SAMPLE_16BIT ? 2 : 4;
+    const uint64_t wanted = size / slotBytes;
+    const uint64_t capacity = (uint64_t)p.config.dma_buf_count * p.config.dma_buf_len;
+    const uint64_t deadlineUs = nativeHalNowUs() + (uint64_t)ticksToWait * portTICK_PERIOD_MS * 1000;
+
+    for (;;) {
+        uint64_t produced = (nativeHalNowUs() - p.startUs) * rate / 1000000;
+        if (produced - p.readFrames > capacity) {
+            p.overruns++;
+            p.readFrames = produced - capacity;
+        }
+        if (produced - p.readFrames >= wanted) break;
+
+        uint64_t readyUs = p.startUs + ((p.readFrames + wanted) * 1000000 + rate - 1) / rate;
+        if (ticksToWait != portMAX_DELAY && readyUs > deadlineUs) return ESP_ERR_TIMEOUT;
+        vTaskDelay((TickType_t)((readyUs - nativeHalNowUs() + 999) / 1000));
+    }
+
+    for (uint64_t i = 0; i < wanted; i++) {
+        int32_t sample = micSample(p.readFrames + i, rate);
+        if (slotBytes == 2) {
+            ((int16_t*)dest)[i] = (int16_t)std::max(-32768, std::min(32767, sample));
+        } else {
+            ((int32_t*)dest)[i] = std::max(-(1 << 17), std::min((1 << 17) - 1, sample)) * (1 << NATIVE_MIC_SHIFT);
+        }
+    }
+    p.readFrames += wanted;
+    *bytesRead = wanted * slotBytes;
+    return ESP_OK;
+}
@@ -0,0 +1,174 @@
+/**
+ * コロ助ロボット - ネイティブHAL FreeRTOSタスク
+ * Corosuke Robot - Native HAL FreeRTOS Tasks
+ *
+ * 各タスクはホストのスレッドだが、ドライバとタスクの間でバトンを渡すので
+ * 同時に動くのは1つだけ（ファームウェア側のコードにロックは要らない）。
+ * タスクの実行中は仮想時計をそのタスクのコアの時刻に差し替える。
+ */
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "native_internal.h"
+
+#define NATIVE_LOOP_CORE    1   // Arduino の loop() は core 1
+
+struct NativeTask {
+    TaskFunction_t function;
+    void* parameter;
+    std::string name;
+    UBaseType_t priority;
+    int core;
+    uint64_t wakeUs;            // 次に起床する仮想時刻
+    uint64_t busyUntilUs;       // 前回の実行が終わった仮想時刻
+    bool finished;
+    NativeTaskStats_t stats;
+};
+
+// スレッドが残ったままプロセスが終わるので、同期オブジェクトは破棄しない
+static std::mutex& batonMutex = *new std::mutex();
+static std::condition_variable& batonCv = *new std::condition_variable();
+static NativeTask* running = nullptr;
+static std::vector<NativeTask*> tasks;
+static thread_local NativeTask* self = nullptr;
+
+// タスク側: ドライバにバトンを返し、次に呼ばれるまで待つ
+static void yieldToDriver(NativeTask* task) {
+    std::unique_lock<std::mutex> lock(batonMutex);
+    running = nullptr;
+    batonCv.notify_all();
+    batonCv.wait(lock, [task] { return running == task; });
+}
+
+static void taskEntry(NativeTask* task) {
+    self = task;
+    {
+        std::unique_lock<std::mutex> lock(batonMutex);
+        batonCv.wait(lock, [task] { return running == task; });
+    }
+    task->function(task->parameter);
+
+    std::lock_guard<std::mutex> lock(batonMutex);
+    task->finished = true;
+    running = nullptr;
+    batonCv.notify_all();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t coreId) {
+    (void)stackDepth;
+    NativeTask* task = new NativeTask();
+    task->function = function;
+    task->parameter = parameter;
+    task->name = name ? name : "task";
+    task->priority = priority;
+    task->core = coreId == tskNO_AFFINITY ? 0 : (int)coreId;
+    task->wakeUs = nativeHalNowUs();
+    task->busyUntilUs = 0;
+    task->finished = false;
+    task->stats = NativeTaskStats_t();
+    task->stats.name = task->name.c_str();
+    task->stats.core = task->core;
+    tasks.push_back(task);
+
+    std::thread(taskEntry, task).detach();
+    if (handle) *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (!self) {
+        // タスク外（loop()）からは時計を進めるだけ（眠っている間は他のタスクが動ける）
+        nativeHalCharge(NATIVE_CHARGE_IDLE, ticks * portTICK_PERIOD_MS * 1000);
+        return;
+    }
+    // 0 tick でも必ず時計が進むようにする
+    self->wakeUs = nativeHalNowUs() + (ticks ? (uint64_t)ticks * portTICK_PERIOD_MS * 1000 : 1);
+    yieldToDriver(self);
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment) {
+    *previousWakeTime += increment;
+    if (!self) {
+        uint64_t wakeUs = (uint64_t)*previousWakeTime * portTICK_PERIOD_MS * 1000;
+        if (wakeUs > nativeHalNowUs()) nativeHalCharge(NATIVE_CHARGE_DELAY, (uint32_t)(wakeUs - nativeHalNowUs()));
+        return;
+    }
+    // 起床時刻を過ぎていれば FreeRTOS と同じくすぐ戻る（ドライバがそのまま再開する）
+    self->wakeUs = (uint64_t)*previousWakeTime * portTICK_PERIOD_MS * 1000;
+    yieldToDriver(self);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(nativeHalNowUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+BaseType_t xPortGetCoreID() {
+    return self ? self->core : NATIVE_LOOP_CORE;
+}
+
+// =============================================================================
+// ドライバ
+// =============================================================================
+static NativeTask* nextDueTask(uint64_t nowUs, uint64_t* startUs) {
+    NativeTask* best = nullptr;
+    uint64_t bestStart = 0;
+    for (NativeTask* task : tasks) {
+        if (task->finished) continue;
+        uint64_t start = std::max(task->wakeUs, task->busyUntilUs);
+        if (start > nowUs) continue;
+        if (!best || start < bestStart || (start == bestStart && task->priority > best->priority)) {
+            best = task;
+            bestStart = start;
+        }
+    }
+    *startUs = bestStart;
+    return best;
+}
+
+void nativeHalRunTasks() {
+    const uint64_t loopNowUs = nativeHalNowUs();
+    uint64_t startUs;
+    NativeTask* task;
+
+    while ((task = nextDueTask(loopNowUs, &startUs)) != nullptr) {
+        uint64_t lateUs = startUs - task->wakeUs;
+        nativeHalSetNowUs(startUs);
+        {
+            std::unique_lock<std::mutex> lock(batonMutex);
+            running = task;
+            batonCv.notify_all();
+            batonCv.wait(lock, [] { return running == nullptr; });
+        }
+        uint64_t endUs = nativeHalNowUs();
+        uint32_t execUs = (uint32_t)(endUs - startUs);
+        task->busyUntilUs = endUs;
+
+        NativeTaskStats_t& stats = task->stats;
+        stats.runs++;
+        stats.totalExecUs += execUs;
+        if (execUs > stats.maxExecUs) stats.maxExecUs = execUs;
+        if (lateUs > stats.maxLateUs) stats.maxLateUs = (uint32_t)lateUs;
+    }
+
+    // 別コアの時間なので loop() 側の時計・チャージには残さない
+    nativeHalSetNowUs(loopNowUs);
+    nativeHalTakeChargedUs();
+}
+
+size_t nativeHalTaskCount() {
+    return tasks.size();
+}
+
+const NativeTaskStats_t& nativeHalTaskStats(size_t index) {
+    return tasks[index]->stats;
+}
@@ -0,0 +1,278 @@
+/**
+ * コロ助ロボット - ネイティブHAL I2Cデバイスモデル実装
+ * Corosuke Robot - Native HAL I2C Device Models
+ */
+
+#include <math.h>
+#include <string.h>
+#include "native_devices.h"
+
+// =============================================================================
+// PCA9685
+// =============================================================================
+#define PCA_REG_MODE1       0x00
+#define PCA_REG_LED0_ON_L   0x06
+#define PCA_REG_LED15_OFF_H 0x45
+#define PCA_MODE1_AI        0x20
+
+NativePca9685::NativePca9685() {
+    memset(_regs, 0, sizeof(_regs));
+    memset(_channelWrites, 0, sizeof(_channelWrites));
+    _regs[PCA_REG_MODE1] = 0x11;    // パワーオン時: SLEEP | ALLCALL
+    _regs[0xFE] = 0x1E;             // PRESCALE初期値
+}
+
+uint8_t NativePca9685::nextPointer(uint8_t pointer) const {
+    if (!(_regs[PCA_REG_MODE1] & PCA_MODE1_AI)) {
+        return pointer;
+    }
+    // オートインクリメントはLED15_OFF_H (0x45) の次でMODE1に戻る
+    if (pointer == PCA_REG_LED15_OFF_H || pointer == 0xFF) {
+        return 0;
+    }
+    return pointer + 1;
+}
+
+bool NativePca9685::onWrite(const uint8_t* data, size_t length) {
+    if (length == 0) return true;
+    _pointer = data[0];
+    for (size_t i = 1; i < length; i++) {
+        _regs[_pointer] = data[i];
+        if (_pointer >= PCA_REG_LED0_ON_L && _pointer <= PCA_REG_LED15_OFF_H &&
+            ((_pointer - PCA_REG_LED0_ON_L) & 3) == 3) {
+            _channelWrites[(_pointer - PCA_REG_LED0_ON_L) >> 2]++;
+        }
+        _pointer = nextPointer(_pointer);
+    }
+    return true;
+}
+
+size_t NativePca9685::onRead(uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        data[i] = _regs[_pointer];
+        _pointer = nextPointer(_pointer);
+    }
+    return length;
+}
+
+uint16_t NativePca9685::channelOn(uint8_t channel) const {
+    uint8_t base = PCA_REG_LED0_ON_L + 4 * (channel & 15);
+    return (uint16_t)(_regs[base] | (_regs[base + 1] << 8));
+}
+
+uint16_t NativePca9685::channelOff(uint8_t channel) const {
+    uint8_t base = PCA_REG_LED0_ON_L + 4 * (channel & 15) + 2;
+    return (uint16_t)(_regs[base] | (_regs[base + 1] << 8));
+}
+
+// =============================================================================
+// 姿勢モデル
+// =============================================================================
+static NativeImuState_t overrideState;
+static bool hasOverride = false;
+
+NativeImuState_t nativeImuState() {
+    return nativeImuStateAt(nativeHalNowUs());
+}
+
+NativeImuState_t nativeImuStateAt(uint64_t us) {
+    if (hasOverride) return overrideState;
+
+    // 立っているだけでも起きる程度の緩やかな揺れ
+    const double t = us / 1e6;
+    const double w = 2.0 * M_PI * 0.5;
+    NativeImuState_t s;
+    s.pitch = (float)(2.0 * sin(w * t));
+    s.roll = (float)(1.5 * sin(w * t + 1.0));
+    s.yaw = 0.0f;
+    s.gyroY = (float)(2.0 * w * cos(w * t));
+    s.gyroX = (float)(1.5 * w * cos(w * t + 1.0));
+    s.gyroZ = 0.0f;
+    return s;
+}
+
+void nativeImuSetState(const NativeImuState_t& state, bool override) {
+    overrideState = state;
+    hasOverride = override;
+}
+
+// =============================================================================
+// BNO055
+// =============================================================================
+#define BNO_REG_CHIP_ID   0x00
+#define BNO_REG_ACC_DATA  0x08
+#define BNO_REG_GYR_DATA  0x14
+#define BNO_REG_EUL_DATA  0x1A
+#define BNO_REG_QUA_DATA  0x20
+#define BNO_REG_GRV_DATA  0x2E
+
+static long clampInt16(double value) {
+    long v = lround(value);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    return v;
+}
+
+static void putInt16(uint8_t* regs, uint8_t address, double value) {
+    long v = clampInt16(value);
+    regs[address] = (uint8_t)(v & 0xFF);
+    regs[address + 1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+// 機体座標系の重力ベクトル（m/s²）
+static void bodyGravity(const NativeImuState_t& s, double* gx, double* gy, double* gz) {
+    const double g = 9.80665;
+    const double p = s.pitch * M_PI / 180.0;
+    const double r = s.roll * M_PI / 180.0;
+    *gx = -g * sin(p);
+    *gy = g * sin(r) * cos(p);
+    *gz = g * cos(r) * cos(p);
+}
+
+void NativeBno055::refresh() {
+    const NativeImuState_t s = nativeImuState();
+    const double p = s.pitch * M_PI / 180.0;
+    const double r = s.roll * M_PI / 180.0;
+
+    double gx, gy, gz;
+    bodyGravity(s, &gx, &gy, &gz);
+
+    _regs[BNO_REG_CHIP_ID] = 0xA0;
+    putInt16(_regs, BNO_REG_ACC_DATA + 0, gx * 100.0);
+    putInt16(_regs, BNO_REG_ACC_DATA + 2, gy * 100.0);
+    putInt16(_regs, BNO_REG_ACC_DATA + 4, gz * 100.0);
+    putInt16(_regs, BNO_REG_GYR_DATA + 0, s.gyroX * 16.0);
+    putInt16(_regs, BNO_REG_GYR_DATA + 2, s.gyroY * 16.0);
+    putInt16(_regs, BNO_REG_GYR_DATA + 4, s.gyroZ * 16.0);
+    // オイラー角レジスタは Heading, Roll, Pitch の順
+    putInt16(_regs, BNO_REG_EUL_DATA + 0, s.yaw * 16.0);
+    putInt16(_regs, BNO_REG_EUL_DATA + 2, s.roll * 16.0);
+    putInt16(_regs, BNO_REG_EUL_DATA + 4, s.pitch * 16.0);
+
+    const double cy = cos(s.yaw * M_PI / 360.0), sy = sin(s.yaw * M_PI / 360.0);
+    const double cp = cos(p / 2), sp = sin(p / 2);
+    const double cr = cos(r / 2), sr = sin(r / 2);
+    putInt16(_regs, BNO_REG_QUA_DATA + 0, (cr * cp * cy + sr * sp * sy) * 16384.0);
+    putInt16(_regs, BNO_REG_QUA_DATA + 2, (sr * cp * cy - cr * sp * sy) * 16384.0);
+    putInt16(_regs, BNO_REG_QUA_DATA + 4, (cr * sp * cy + sr * cp * sy) * 16384.0);
+    putInt16(_regs, BNO_REG_QUA_DATA + 6, (cr * cp * sy - sr * sp * cy) * 16384.0);
+    putInt16(_regs, BNO_REG_GRV_DATA + 0, gx * 100.0);
+    putInt16(_regs, BNO_REG_GRV_DATA + 2, gy * 100.0);
+    putInt16(_regs, BNO_REG_GRV_DATA + 4, gz * 100.0);
+}
+
+bool NativeBno055::onWrite(const uint8_t* data, size_t length) {
+    if (length == 0) return true;
+    _pointer = data[0] & 0x7F;
+    for (size_t i = 1; i < length; i++) {
+        _regs[_pointer] = data[i];
+        _pointer = (_pointer + 1) & 0x7F;
+    }
+    return true;
+}
+
+size_t NativeBno055::onRead(uint8_t* data, size_t length) {
+    refresh();
+    for (size_t i = 0; i < length; i++) {
+        data[i] = _regs[_pointer];
+        _pointer = (_pointer + 1) & 0x7F;
+    }
+    return length;
+}
+
+// =============================================================================
+// MPU6050
+// =============================================================================
+#define MPU_REG_SMPLRT_DIV    0x19
+#define MPU_REG_FIFO_EN       0x23
+#define MPU_REG_INT_STATUS    0x3A
+#define MPU_REG_USER_CTRL     0x6A
+#define MPU_REG_PWR_MGMT_1    0x6B
+#define MPU_REG_FIFO_COUNT_H  0x72
+#define MPU_REG_FIFO_COUNT_L  0x73
+#define MPU_REG_FIFO_R_W      0x74
+#define MPU_REG_WHO_AM_I      0x75
+#define MPU_USER_FIFO_EN      0x40
+#define MPU_USER_FIFO_RESET   0x04
+#define MPU_INT_FIFO_OFLOW    0x10
+#define MPU_SAMPLE_BYTES      12
+
+NativeMpu6050::NativeMpu6050() {
+    memset(_regs, 0, sizeof(_regs));
+    _regs[MPU_REG_WHO_AM_I] = 0x68;
+    _regs[MPU_REG_PWR_MGMT_1] = 0x40;   // パワーオン時: SLEEP
+}
+
+void NativeMpu6050::pushSample(const NativeImuState_t& s) {
+    if (_fifoLength + MPU_SAMPLE_BYTES > sizeof(_fifo)) {
+        _regs[MPU_REG_INT_STATUS] |= MPU_INT_FIFO_OFLOW;
+        return;
+    }
+    // ±4G (8192 LSB/G)、±500dps (65.5 LSB/dps)、ビッグエンディアン
+    double gx, gy, gz;
+    bodyGravity(s, &gx, &gy, &gz);
+    const double accelScale = 8192.0 / 9.80665;
+    const double values[6] = {gx * accelScale, gy * accelScale, gz * accelScale,
+                              s.gyroX * 65.5, s.gyroY * 65.5, s.gyroZ * 65.5};
+    for (int i = 0; i < 6; i++) {
+        long v = clampInt16(values[i]);
+        size_t tail = (_fifoHead + _fifoLength) % sizeof(_fifo);
+        _fifo[tail] = (uint8_t)((v >> 8) & 0xFF);
+        _fifo[(tail + 1) % sizeof(_fifo)] = (uint8_t)(v & 0xFF);
+        _fifoLength += 2;
+    }
+}
+
+void NativeMpu6050::fillFifo() {
+    const uint64_t now = nativeHalNowUs();
+    const bool running = !(_regs[MPU_REG_PWR_MGMT_1] & 0x40) && (_regs[MPU_REG_USER_CTRL] & MPU_USER_FIFO_EN) &&
+                         _regs[MPU_REG_FIFO_EN] != 0;
+    const uint64_t intervalUs = 1000ULL * (1 + _regs[MPU_REG_SMPLRT_DIV]);
+    if (!running) {
+        _nextSampleUs = now + intervalUs;
+        return;
+    }
+    while (_nextSampleUs <= now) {
+        pushSample(nativeImuStateAt(_nextSampleUs));
+        _nextSampleUs += intervalUs;
+    }
+    _regs[MPU_REG_FIFO_COUNT_H] = (uint8_t)(_fifoLength >> 8);
+    _regs[MPU_REG_FIFO_COUNT_L] = (uint8_t)(_fifoLength & 0xFF);
+}
+
+bool NativeMpu6050::onWrite(const uint8_t* data, size_t length) {
+    if (length == 0) return true;
+    _pointer = data[0] & 0x7F;
+    for (size_t i = 1; i < length; i++) {
+        _regs[_pointer] = data[i];
+        if (_pointer == MPU_REG_USER_CTRL && (data[i] & MPU_USER_FIFO_RESET)) {
+            _fifoHead = 0;
+            _fifoLength = 0;
+            _regs[MPU_REG_USER_CTRL] &= ~MPU_USER_FIFO_RESET;
+        }
+        _pointer = (_pointer + 1) & 0x7F;
+    }
+    fillFifo();
+    return true;
+}
+
+size_t NativeMpu6050::onRead(uint8_t* data, size_t length) {
+    fillFifo();
+    for (size_t i = 0; i < length; i++) {
+        if (_pointer == MPU_REG_FIFO_R_W) {
+            // FIFO_R_W はアドレスが進まず、読むたびに FIFO から出てくる
+            data[i] = _fifoLength > 0 ? _fifo[_fifoHead] : 0;
+            if (_fifoLength > 0) {
+                _fifoHead = (_fifoHead + 1) % sizeof(_fifo);
+                _fifoLength--;
+            }
+            continue;
+        }
+        data[i] = _regs[_pointer];
+        if (_pointer == MPU_REG_INT_STATUS) _regs[MPU_REG_INT_STATUS] = 0;   // 読むとクリア
+        _pointer = (_pointer + 1) & 0x7F;
+    }
+    _regs[MPU_REG_FIFO_COUNT_H] = (uint8_t)(_fifoLength >> 8);
+    _regs[MPU_REG_FIFO_COUNT_L] = (uint8_t)(_fifoLength & 0xFF);
+    return length;
+}
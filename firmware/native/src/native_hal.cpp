@@ -0,0 +1,183 @@
+/**
+ * コロ助ロボット - ネイティブHAL 仮想時計・Arduinoコア関数
+ * Corosuke Robot - Native HAL Virtual Clock & Arduino Core
+ */
+
+#include <Arduino.h>
+#include "native_devices.h"
+#include "native_internal.h"
+#include "../../common/config.h"
+
+// =============================================================================
+// 仮想時計
+// =============================================================================
+static uint64_t virtualNowUs = 0;
+static uint64_t chargedSinceTakeUs = 0;
+static uint64_t chargedTotalUs[NATIVE_CHARGE_COUNT];
+static NativeHalStats_t halStats;
+
+uint64_t nativeHalNowUs() {
+    return virtualNowUs;
+}
+
+void nativeHalAdvanceUs(uint64_t us) {
+    virtualNowUs += us;
+}
+
+void nativeHalSetNowUs(uint64_t us) {
+    virtualNowUs = us;
+}
+
+void nativeHalCharge(NativeChargeKind_t kind, uint32_t us) {
+    chargedTotalUs[kind] += us;
+    if (kind != NATIVE_CHARGE_IDLE) chargedSinceTakeUs += us;   // 眠っている間は loop() の時間に入れない
+    virtualNowUs += us;
+}
+
+uint64_t nativeHalTakeChargedUs() {
+    uint64_t us = chargedSinceTakeUs;
+    chargedSinceTakeUs = 0;
+    return us;
+}
+
+uint64_t nativeHalChargedTotalUs(NativeChargeKind_t kind) {
+    return chargedTotalUs[kind];
+}
+
+const NativeHalStats_t& nativeHalStats() {
+    return halStats;
+}
+
+NativeHalStats_t& nativeHalMutableStats() {
+    return halStats;
+}
+
+void nativeHalResetStats() {
+    halStats = NativeHalStats_t();
+    for (int i = 0; i < NATIVE_CHARGE_COUNT; i++) {
+        chargedTotalUs[i] = 0;
+    }
+    chargedSinceTakeUs = 0;
+}
+
+// =============================================================================
+// I2Cデバイス登録
+// =============================================================================
+static NativeI2CDevice* i2cDevices[128];
+static uint32_t i2cErrorsToInject = 0;
+
+void nativeHalAttachI2C(uint8_t address, NativeI2CDevice* device) {
+    i2cDevices[address & 0x7F] = device;
+}
+
+NativeI2CDevice* nativeHalI2CDevice(uint8_t address) {
+    return i2cDevices[address & 0x7F];
+}
+
+void nativeHalInjectI2CErrors(uint32_t count) {
+    i2cErrorsToInject = count;
+}
+
+bool nativeHalConsumeI2CError() {
+    if (i2cErrorsToInject == 0) return false;
+    i2cErrorsToInject--;
+    return true;
+}
+
+// =============================================================================
+// 初期化
+// =============================================================================
+void nativeHalInit() {
+    static NativePca9685 pcaUpper;
+    static NativePca9685 pcaLower;
+    static NativeBno055 bno055;
+    static NativeMpu6050 mpu6050;
+
+    nativeHalAttachI2C(I2C_ADDR_PCA9685_UPPER, &pcaUpper);
+    nativeHalAttachI2C(I2C_ADDR_PCA9685_LOWER, &pcaLower);
+    nativeHalAttachI2C(I2C_ADDR_MPU6050, &mpu6050);
+
+    // COROSUKE_NATIVE_IMU=mpu6050 で BNO055 を外す（フォールバックの確認用）
+    const char* imu = getenv("COROSUKE_NATIVE_IMU");
+    if (!imu || strcmp(imu, "mpu6050") != 0) {
+        nativeHalAttachI2C(I2C_ADDR_BNO055, &bno055);
+    }
+
+    Serial.nativeSetEcho(getenv("COROSUKE_NATIVE_ECHO") != nullptr);
+    randomSeed(1);
+}
+
+// =============================================================================
+// Arduinoコア関数
+// =============================================================================
+unsigned long millis() {
+    return (unsigned long)(virtualNowUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)virtualNowUs;
+}
+
+void delay(uint32_t ms) {
+    nativeHalCharge(NATIVE_CHARGE_DELAY, ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    nativeHalCharge(NATIVE_CHARGE_DELAY, us);
+}
+
+EspClass ESP;
+
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < 64 && (mode == INPUT_PULLUP || mode == INPUT)) {
+        pinLevels[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < 64) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < 64 ? pinLevels[pin] : LOW;
+}
+
+// 再現性のためにxorshiftで実装（Arduinoの random() と同じ区間仕様）
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom() {
+    uint32_t x = randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+    return x;
+}
+
+long random(long howbig) {
+    if (howbig <= 0) return 0;
+    return (long)(nextRandom() % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+    randomState = seed ? (uint32_t)seed : 1;
+}
+
+uint32_t esp_random() {
+    return nextRandom();
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    const long run = in_max - in_min;
+    if (run == 0) return -1;
+    const long rise = out_max - out_min;
+    const long delta = x - in_min;
+    return (delta * rise) / run + out_min;
+}
@@ -0,0 +1,17 @@
+/**
+ * コロ助ロボット - ネイティブHAL 内部API
+ * Corosuke Robot - Native HAL Internal API
+ */
+
+#ifndef COROSUKE_NATIVE_INTERNAL_H
+#define COROSUKE_NATIVE_INTERNAL_H
+
+#include "native_hal.h"
+
+NativeHalStats_t& nativeHalMutableStats();
+bool nativeHalConsumeI2CError();
+
+// 別コアで動くタスクの実行中だけ仮想時計を差し替える
+void nativeHalSetNowUs(uint64_t us);
+
+#endif // COROSUKE_NATIVE_INTERNAL_H
@@ -0,0 +1,109 @@
+"""
+コロ助ロボット - ストリーミング発話 ベンチマーク
+Corosuke Robot - Speech Streaming Benchmark
+
+LLM（最初のトークンまでの待ち + 一定速度のトークン）と VOICEVOX
+（文字数に比例する合成時間）をまねた遅延で、最初の音が出るまでの時間を比べる。
+
+- 従来: LLM の応答全体を待つ → 全文を合成 → 再生開始
+- ストリーミング: SpeechStream で文ごとに合成し、最初の文ができたら再生開始
+
+ストリーミングでは、再生中に次の文が間に合わずに音が途切れた時間も出す。
+
+    python bench_streaming.py
+"""
+
+import asyncio
+import io
+import time
+import wave
+
+from speech_stream import STREAM_SAMPLE_RATE, SpeechStream
+
+# LLM のまね（claude-3-haiku を自宅回線から使ったときの目安）
+LLM_FIRST_TOKEN_S = 0.45
+LLM_TOKENS_PER_S = 60
+LLM_CHARS_PER_TOKEN = 2
+
+# VOICEVOX のまね（CPU 版、speedScale 1.2）
+SYNTH_BASE_S = 0.08
+SYNTH_PER_CHAR_S = 0.012
+SPEECH_PER_CHAR_S = 0.11        # 合成した音声の長さ
+
+REPLY = ("ワガハイはコロ助ナリ！今日はとってもいい天気ナリね。"
+         "キテレツと一緒に公園へ行きたいナリ！帰りにコロッケを買ってほしいナリよ。"
+         "みよちゃんも誘うナリか？")
+
+RUNS = 3
+
+
+async def fake_llm(text: str):
+    await asyncio.sleep(LLM_FIRST_TOKEN_S)
+    for i in range(0, len(text), LLM_CHARS_PER_TOKEN):
+        yield text[i:i + LLM_CHARS_PER_TOKEN]
+        await asyncio.sleep(1.0 / LLM_TOKENS_PER_S)
+
+
+def silent_wav(seconds: float) -> bytes:
+    out = io.BytesIO()
+    with wave.open(out, "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(STREAM_SAMPLE_RATE)
+        w.writeframes(b"\0\0" * int(seconds * STREAM_SAMPLE_RATE))
+    return out.getvalue()
+
+
+async def fake_synthesize(text: str) -> bytes:
+    await asyncio.sleep(SYNTH_BASE_S + SYNTH_PER_CHAR_S * len(text))
+    return silent_wav(SPEECH_PER_CHAR_S * len(text))
+
+
+async def legacy_ttfa() -> float:
+    start = time.monotonic()
+    text = "".join([token async for token in fake_llm(REPLY)])
+    await fake_synthesize(text)
+    return time.monotonic() - start
+
+
+async def streaming_ttfa() -> tuple[float, float, int]:
+    """最初の音声までの時間、再生が途切れた合計時間、文の数"""
+    start = time.monotonic()
+    stream = SpeechStream(fake_llm(REPLY), fake_synthesize)
+    first = None
+    play_end = 0.0              # 再生済みの音声が終わる時刻（start 基準）
+    stall = 0.0
+    async for pcm in stream.pcm_chunks():
+        now = time.monotonic() - start
+        if first is None:
+            first = now
+            play_end = now
+        elif now > play_end:
+            stall += now - play_end
+            play_end = now
+        play_end += len(pcm) / 2 / STREAM_SAMPLE_RATE
+    return first, stall, stream.sentences
+
+
+async def main():
+    print("=== コロ助 speech streaming benchmark ===")
+    print(f"reply: {len(REPLY)} chars, LLM first token {LLM_FIRST_TOKEN_S * 1000:.0f} ms, "
+          f"{LLM_TOKENS_PER_S} tok/s, synth {SYNTH_BASE_S * 1000:.0f} ms + "
+          f"{SYNTH_PER_CHAR_S * 1000:.0f} ms/char")
+
+    legacy = [await legacy_ttfa() for _ in range(RUNS)]
+    streaming = [await streaming_ttfa() for _ in range(RUNS)]
+
+    legacy_ms = min(legacy) * 1000
+    streaming_ms = min(s[0] for s in streaming) * 1000
+    stall_ms = max(s[1] for s in streaming) * 1000
+    print("time to first audio (best of %d)" % RUNS)
+    print(f"  {'/chat + /speak':28s} {legacy_ms:8.0f} ms")
+    print(f"  {'/chat_stream':28s} {streaming_ms:8.0f} ms  ({streaming[0][2]} sentences, "
+          f"playback stalls {stall_ms:.0f} ms)")
+    print(f"  {'speedup':28s} {legacy_ms / streaming_ms:8.1f}x")
+    return 0 if streaming_ms < legacy_ms and stall_ms < 50 else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(asyncio.run(main()))
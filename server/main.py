@@ -9,8 +9,9 @@ ESP32からのリクエストを処理し、音声合成を行う
 import os
 import io
 import json
+import uuid
 import asyncio
-from typing import Optional
+from typing import AsyncIterator, Optional
 from pathlib import Path
 
 from fastapi import FastAPI, HTTPException, WebSocket, WebSocketDisconnect
@@ -25,6 +26,10 @@ from corosuke_personality import (
     VOICEVOX_SPEAKER_ID,
     detect_expression
 )
+from speech_stream import STREAM_SAMPLE_RATE, SpeechStream
+from voice_ingest import STT_COMMAND, VoiceSegment, transcribe
+import robot_link
+from robot_trace import TraceAggregator
 
 # 環境変数読み込み
 load_dotenv()
@@ -48,6 +53,9 @@ VOICEVOX_HOST = os.getenv("VOICEVOX_HOST", "http://localhost:50021")
 AUDIO_DIR = Path("audio_cache")
 AUDIO_DIR.mkdir(exist_ok=True)
 
+# ストリーミング発話: 取りに来なかったストリームを捨てるまでの秒数
+STREAM_EXPIRE_S = 60
+
 # =============================================================================
 # FastAPIアプリ
 # =============================================================================
@@ -82,6 +90,19 @@ class SpeakResponse(BaseModel):
     audio_url: str
     duration_ms: int
 
+class ChatStreamResponse(BaseModel):
+    stream_url: str
+    sample_rate: int
+
+class RobotCommandRequest(BaseModel):
+    cmd: int
+    data: list[int] = [0]
+
+class RobotExpressionRequest(BaseModel):
+    expression: str
+    intensity: int = 100
+    duration_ms: int = 3000
+
 class CommandRequest(BaseModel):
     command: str
     params: Optional[dict] = None
@@ -183,12 +204,130 @@ async def chat_with_openai(message: str) -> str:
         except Exception as e:
             return f"通信エラーナリ: {str(e)}"
 
+async def stream_claude(message: str) -> AsyncIterator[str]:
+    """Claude APIで会話（トークンが届くたびに返す）"""
+    if not ANTHROPIC_API_KEY:
+        yield "APIキーが設定されていないナリ..."
+        return
+
+    global conversation_history
+
+    conversation_history.append({
+        "role": "user",
+        "content": message
+    })
+    if len(conversation_history) > MAX_HISTORY * 2:
+        conversation_history = conversation_history[-MAX_HISTORY * 2:]
+
+    parts = []
+    async with httpx.AsyncClient() as client:
+        try:
+            async with client.stream(
+                "POST",
+                "https://api.anthropic.com/v1/messages",
+                headers={
+                    "Content-Type": "application/json",
+                    "x-api-key": ANTHROPIC_API_KEY,
+                    "anthropic-version": "2023-06-01"
+                },
+                json={
+                    "model": "claude-3-haiku-20240307",
+                    "max_tokens": 256,
+                    "system": COROSUKE_SYSTEM_PROMPT,
+                    "messages": conversation_history,
+                    "stream": True
+                },
+                timeout=30.0
+            ) as response:
+                if response.status_code != 200:
+                    yield f"エラーが発生したナリ... (ステータス: {response.status_code})"
+                    return
+
+                # Server-Sent Events: "data: {...}" の行だけ見る
+                async for line in response.aiter_lines():
+                    if not line.startswith("data: "):
+                        continue
+                    event = json.loads(line[6:])
+                    if event.get("type") == "content_block_delta":
+                        text = event.get("delta", {}).get("text", "")
+                        if text:
+                            parts.append(text)
+                            yield text
+
+        except Exception as e:
+            yield f"通信エラーナリ: {str(e)}"
+            return
+
+    # 履歴に追加（最後まで受け取れた分）
+    if parts:
+        conversation_history.append({
+            "role": "assistant",
+            "content": "".join(parts)
+        })
+
+
+async def stream_openai(message: str) -> AsyncIterator[str]:
+    """OpenAI APIで会話（トークンが届くたびに返す、フォールバック用）"""
+    if not OPENAI_API_KEY:
+        yield "OpenAI APIキーが設定されていないナリ..."
+        return
+
+    async with httpx.AsyncClient() as client:
+        try:
+            async with client.stream(
+                "POST",
+                "https://api.openai.com/v1/chat/completions",
+                headers={
+                    "Content-Type": "application/json",
+                    "Authorization": f"Bearer {OPENAI_API_KEY}"
+                },
+                json={
+                    "model": "gpt-3.5-turbo",
+                    "max_tokens": 256,
+                    "messages": [
+                        {"role": "system", "content": COROSUKE_SYSTEM_PROMPT},
+                        {"role": "user", "content": message}
+                    ],
+                    "stream": True
+                },
+                timeout=30.0
+            ) as response:
+                if response.status_code != 200:
+                    yield "エラーが発生したナリ..."
+                    return
+
+                async for line in response.aiter_lines():
+                    if not line.startswith("data: ") or line == "data: [DONE]":
+                        continue
+                    event = json.loads(line[6:])
+                    text = event["choices"][0].get("delta", {}).get("content") or ""
+                    if text:
+                        yield text
+
+        except Exception as e:
+            yield f"通信エラーナリ: {str(e)}"
+
+
+async def stream_llm(message: str) -> AsyncIterator[str]:
+    """設定されているLLMで会話（ストリーミング）"""
+    if ANTHROPIC_API_KEY:
+        source = stream_claude(message)
+    elif OPENAI_API_KEY:
+        source = stream_openai(message)
+    else:
+        yield "ワガハイはコロ助ナリ！APIキーを設定してほしいナリ！"
+        return
+
+    async for text in source:
+        yield text
+
 # =============================================================================
 # VOICEVOX連携
 # =============================================================================
 
-async def synthesize_voice(text: str, speaker_id: int = VOICEVOX_SPEAKER_ID) -> tuple[bytes, int]:
-    """VOICEVOXで音声合成"""
+async def synthesize_voice(text: str, speaker_id: int = VOICEVOX_SPEAKER_ID,
+                           sample_rate: Optional[int] = None) -> tuple[bytes, int]:
+    """VOICEVOXで音声合成（sample_rate を指定するとその周波数のモノラルで出力）"""
     async with httpx.AsyncClient() as client:
         # 音声クエリ作成
         query_response = await client.post(
@@ -206,6 +345,11 @@ async def synthesize_voice(text: str, speaker_id: int = VOICEVOX_SPEAKER_ID) ->
         query["speedScale"] = 1.2
         query["pitchScale"] = 0.05  # 少し高め
 
+        # ストリーミングでは文ごとの WAV をつなげるので形式をそろえる
+        if sample_rate:
+            query["outputSamplingRate"] = sample_rate
+            query["outputStereo"] = False
+
         # 音声合成
         synth_response = await client.post(
             f"{VOICEVOX_HOST}/synthesis",
@@ -324,6 +468,60 @@ async def chat_and_speak(request: ChatRequest):
     }
 
 
+# ストリーミング発話（stream_id → SpeechStream）
+speech_streams: dict[str, SpeechStream] = {}
+
+
+async def synthesize_sentence(text: str) -> bytes:
+    """ストリーム用に1文を音声合成"""
+    audio_data, _ = await synthesize_voice(text, sample_rate=STREAM_SAMPLE_RATE)
+    return audio_data
+
+
+def start_speech_stream(tokens) -> tuple[str, SpeechStream]:
+    """SpeechStream を登録して、再生用のパスと一緒に返す"""
+    stream_id = uuid.uuid4().hex[:16]
+    stream = SpeechStream(tokens, synthesize_sentence)
+    speech_streams[stream_id] = stream
+    asyncio.get_running_loop().call_later(STREAM_EXPIRE_S, speech_streams.pop, stream_id, None)
+    return f"/stream/{stream_id}.wav", stream
+
+
+async def single_text(text: str):
+    """読み上げるテキストを1トークンとして渡す"""
+    yield text
+
+
+@app.post("/chat_stream", response_model=ChatStreamResponse)
+async def chat_stream(request: ChatRequest):
+    """LLMの応答を文ごとに音声合成し、1本のWAVストリームとして流す
+
+    すぐに stream_url を返すので、ESP32はそのURLを再生し始める。
+    最初の文の音声ができた時点で音が出て、残りの文は再生中に生成される。
+    """
+    path, _ = start_speech_stream(stream_llm(request.message))
+    return ChatStreamResponse(
+        stream_url=path,
+        sample_rate=STREAM_SAMPLE_RATE
+    )
+
+
+@app.get("/stream/{stream_id}.wav")
+async def get_stream(stream_id: str):
+    """/chat_stream で作ったストリームを再生する"""
+    stream = speech_streams.pop(stream_id, None)
+    if stream is None:
+        raise HTTPException(status_code=404, detail="ストリームが見つからないナリ")
+
+    async def body():
+        async for chunk in stream.wav_chunks():
+            yield chunk
+        print(f"[stream {stream_id}] {stream.summary()}")
+        print(f"[stream {stream_id}] コロ助: {stream.text} ({detect_expression(stream.text)})")
+
+    return StreamingResponse(body(), media_type="audio/wav")
+
+
 @app.post("/command")
 async def command(request: CommandRequest):
     """ロボットへのコマンドを処理"""
@@ -373,18 +571,119 @@ async def get_expressions():
 # WebSocket（リアルタイム通信用）
 # =============================================================================
 
-connected_clients = set()
+connected_clients = set()       # JSON テキストで話すクライアント
+robot_clients = set()           # バイナリで話すロボット（メインボード）
+robot_telemetry: Optional[robot_link.Telemetry] = None
+voice_segments: dict[WebSocket, VoiceSegment] = {}     # ロボットごとの受信中の声の区間
+robot_trace = TraceAggregator()     # 3枚のボードの処理時間の分布
+
+
+async def send_reply_when_ready(websocket: WebSocket, seq: int, stream: SpeechStream):
+    """応答テキストがそろったら表情付きで送る（音声は先に再生が始まっている）"""
+    await stream.text_done.wait()
+    try:
+        await websocket.send_bytes(
+            robot_link.reply(seq, detect_expression(stream.text), stream.text))
+    except Exception:
+        pass
+
+
+async def start_chat_reply(websocket: WebSocket, seq: int, text: str):
+    """文ごとの音声ストリームをすぐ再生させ、応答テキストは後から送る"""
+    path, stream = start_speech_stream(stream_llm(text))
+    await websocket.send_bytes(robot_link.play(seq, path, STREAM_SAMPLE_RATE))
+    asyncio.create_task(send_reply_when_ready(websocket, seq, stream))
+
+
+async def answer_voice(websocket: WebSocket, seq: int, segment: VoiceSegment):
+    """声の区間を聞き取って HEARD を返し、聞き取れたら CHAT と同じく応答する"""
+    text = await transcribe(segment)
+    print(f"[voice {segment.segment}] 聞き取り: {text or '(なし)'}")
+    try:
+        await websocket.send_bytes(robot_link.heard(seq, text))
+        if text:
+            await start_chat_reply(websocket, seq, text)
+    except Exception:
+        pass
+
+
+async def handle_robot_message(websocket: WebSocket, message: bytes):
+    """ロボットからのバイナリメッセージ"""
+    global robot_telemetry
+
+    decoded = robot_link.decode(message)
+    if decoded is None:
+        return
+    msg_type, seq, payload = decoded
+
+    if msg_type == robot_link.LINK_MSG_HELLO:
+        robot_clients.add(websocket)
+        version = payload[0] if payload else 0
+        print(f"ロボット接続: {payload[1:].decode(errors='replace')} (v{version})")
+
+    elif msg_type == robot_link.LINK_MSG_CHAT:
+        await start_chat_reply(websocket, seq, payload.decode(errors="replace"))
+
+    elif msg_type == robot_link.LINK_MSG_SPEAK:
+        path, _ = start_speech_stream(single_text(payload.decode(errors="replace")))
+        await websocket.send_bytes(robot_link.play(seq, path, STREAM_SAMPLE_RATE))
+
+    elif msg_type == robot_link.LINK_MSG_TELEMETRY:
+        robot_telemetry = robot_link.decode_telemetry(payload)
+
+    elif msg_type == robot_link.LINK_MSG_AUDIO_START:
+        # 前の区間が終わらないまま次が始まったら、前のは捨てる
+        start = robot_link.decode_audio_start(payload)
+        if start is None or start.codec != robot_link.LINK_AUDIO_IMA_ADPCM or start.sample_rate == 0:
+            voice_segments.pop(websocket, None)
+            await websocket.send_bytes(robot_link.error(seq, "対応していない音声形式ナリ"))
+            return
+        voice_segments[websocket] = VoiceSegment(start.segment, start.sample_rate, start.preroll_ms)
+
+    elif msg_type == robot_link.LINK_MSG_AUDIO:
+        # 届いたそばから復号しておく（区間の終わりで待つのは聞き取りだけ）
+        chunk = robot_link.decode_audio_chunk(payload)
+        segment = voice_segments.get(websocket)
+        if chunk is not None and segment is not None and chunk.segment == segment.segment:
+            segment.add_chunk(chunk.chunk, chunk.predictor, chunk.step_index, chunk.data)
+
+    elif msg_type == robot_link.LINK_MSG_AUDIO_END:
+        end = robot_link.decode_audio_end(payload)
+        segment = voice_segments.pop(websocket, None)
+        if end is None or segment is None or end.segment != segment.segment:
+            return
+        segment.finish(end.chunks)
+        print(f"[voice {segment.segment}] {segment.summary()}")
+        if end.reason != robot_link.LINK_AUDIO_END_CANCEL:
+            asyncio.create_task(answer_voice(websocket, seq, segment))
+
+    elif msg_type == robot_link.LINK_MSG_TRACE:
+        for window in robot_link.decode_trace(payload):
+            alert = robot_trace.add(window)
+            if alert:
+                print(alert)
+
+    else:
+        await websocket.send_bytes(robot_link.error(seq, f"未知のメッセージ: 0x{msg_type:02X}"))
+
 
 @app.websocket("/ws")
 async def websocket_endpoint(websocket: WebSocket):
-    """WebSocket接続（ESP32との双方向通信用）"""
+    """WebSocket接続（ESP32はバイナリ、その他のクライアントはJSONテキスト）"""
     await websocket.accept()
-    connected_clients.add(websocket)
 
     try:
         while True:
-            data = await websocket.receive_text()
-            message = json.loads(data)
+            received = await websocket.receive()
+            if received["type"] == "websocket.disconnect":
+                break
+
+            if received.get("bytes") is not None:
+                await handle_robot_message(websocket, received["bytes"])
+                continue
+
+            connected_clients.add(websocket)
+            message = json.loads(received.get("text") or "{}")
 
             if message.get("type") == "chat":
                 # 会話処理
@@ -401,7 +700,13 @@ async def websocket_endpoint(websocket: WebSocket):
                 await websocket.send_json({"type": "pong"})
 
     except WebSocketDisconnect:
-        connected_clients.remove(websocket)
+        pass
+    finally:
+        connected_clients.discard(websocket)
+        voice_segments.pop(websocket, None)
+        if websocket in robot_clients:
+            robot_clients.discard(websocket)
+            print("ロボット切断")
 
 
 async def broadcast(message: dict):
@@ -412,6 +717,59 @@ async def broadcast(message: dict):
         except:
             pass
 
+
+async def push_to_robots(message: bytes) -> int:
+    """接続中のロボットへバイナリメッセージを送る（送れた数を返す）"""
+    sent = 0
+    for client in list(robot_clients):
+        try:
+            await client.send_bytes(message)
+            sent += 1
+        except Exception:
+            robot_clients.discard(client)
+    return sent
+
+
+@app.post("/robot/command")
+async def robot_command(request: RobotCommandRequest):
+    """UARTコマンドをそのままロボットへ送る（例: {"cmd": 65} で手を振る）"""
+    try:
+        message = robot_link.robot_command(request.cmd, bytes(request.data))
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return {"sent": await push_to_robots(message)}
+
+
+@app.post("/robot/expression")
+async def robot_expression(request: RobotExpressionRequest):
+    """ロボットの表情を変える"""
+    if request.expression not in robot_link.EXPRESSION_IDS:
+        raise HTTPException(status_code=400, detail=f"'{request.expression}'という表情は知らないナリ...")
+    message = robot_link.expression_command(request.expression, request.intensity, request.duration_ms)
+    return {"sent": await push_to_robots(message)}
+
+
+@app.get("/robot/status")
+async def robot_status():
+    """ロボットの接続状態と最新のテレメトリー"""
+    return {
+        "connected": len(robot_clients),
+        "telemetry": robot_telemetry.__dict__ if robot_telemetry else None
+    }
+
+
+@app.get("/robot/trace")
+async def robot_trace_summary():
+    """ボード・処理ごとの時間の分布と、サーボ 1 tick（20ms）を超えた処理"""
+    return robot_trace.summary()
+
+
+@app.post("/robot/trace/reset")
+async def robot_trace_reset():
+    """集計をやり直す（設定を変えた後など）"""
+    robot_trace.reset()
+    return {"reset": True}
+
 # =============================================================================
 # メイン
 # =============================================================================
@@ -427,6 +785,7 @@ if __name__ == "__main__":
     print(f"  VOICEVOX: {VOICEVOX_HOST}")
     print(f"  Claude API: {'設定済み' if ANTHROPIC_API_KEY else '未設定'}")
     print(f"  OpenAI API: {'設定済み' if OPENAI_API_KEY else '未設定'}")
+    print(f"  音声認識: {STT_COMMAND or '未設定（STT_STANDIN_TEXT を返す）'}")
     print("=" * 50)
 
     uvicorn.run(app, host=HOST, port=PORT)
@@ -0,0 +1,228 @@
+"""
+コロ助ロボット - ロボットとの常時接続（WebSocket バイナリメッセージ）
+Corosuke Robot - Robot Link (binary WebSocket messages)
+
+メインボードは /ws に WebSocket を張ったままにし、次の形式のバイナリフレームで
+会話・読み上げ・テレメトリーを送ってくる。サーバーからは応答や表情・動作の指令を送る。
+
+    [type][seq][payload...]
+
+マイクの音声は声の区間だけ AUDIO_START → AUDIO（IMA-ADPCM のチャンク）… → AUDIO_END で届く。
+AUDIO_END の seq で HEARD（聞き取ったテキスト）を返し、続けて CHAT と同じく応答する。
+
+TRACE は3枚のボードの処理ごとの時間の分布（前回からの差分）で、robot_trace.py が集める。
+
+値は firmware/common/server_link.h と firmware/common/protocol.h にそろえること。
+"""
+
+import struct
+from dataclasses import dataclass
+from typing import Optional
+
+LINK_VERSION = 1
+LINK_HEADER_SIZE = 2
+
+# ボード → サーバー
+LINK_MSG_HELLO = 0x01
+LINK_MSG_CHAT = 0x02
+LINK_MSG_SPEAK = 0x03
+LINK_MSG_TELEMETRY = 0x04
+LINK_MSG_AUDIO_START = 0x05
+LINK_MSG_AUDIO = 0x06
+LINK_MSG_AUDIO_END = 0x07
+LINK_MSG_TRACE = 0x08
+
+# サーバー → ボード
+LINK_MSG_REPLY = 0x81
+LINK_MSG_PLAY = 0x82
+LINK_MSG_ROBOT_CMD = 0x83
+LINK_MSG_HEARD = 0x84
+LINK_MSG_ERROR = 0x8F
+
+LINK_FLAG_PERSON = 0x01
+LINK_FLAG_SPEAKING = 0x02
+LINK_FLAG_LISTENING = 0x04
+
+LINK_AUDIO_IMA_ADPCM = 1
+
+LINK_AUDIO_END_SILENCE = 0
+LINK_AUDIO_END_LENGTH = 1
+LINK_AUDIO_END_CANCEL = 2
+
+# 処理時間の分布（protocol.h の TraceStatusData_t、trace.h）
+STATUS_RESP_TRACE = 0x80
+TRACE_BUCKETS = 16
+TRACE_BUCKET0_US = 16
+TRACE_BUDGET_US = 20000         # サーボ 1 tick（SERVO_UPDATE_INTERVAL_MS）
+TRACE_BOARDS = ("main", "upper", "lower")
+TRACE_STAGES = ("loop", "uart", "imu", "balance", "gait", "control", "servo_tick",
+                "servo_write", "led_show", "audio", "camera", "mic", "server")
+TRACE_STATUS_FORMAT = f"<BBBBIIII{TRACE_BUCKETS}H"
+
+# UART コマンド（protocol.h から、サーバーが送るものだけ）
+CMD_EXPRESSION = 0x10
+CMD_LOOK_AT = 0x62
+CMD_WAVE = 0x41
+CMD_MAX_DATA = 59
+
+# 表情ID（protocol.h の Expression_t の順）
+EXPRESSION_IDS = {
+    "neutral": 0,
+    "happy": 1,
+    "sad": 2,
+    "surprised": 3,
+    "angry": 4,
+    "sleepy": 5,
+    "thinking": 6,
+    "excited": 7,
+}
+
+# LinkTelemetry_t（詰めたリトルエンディアン）
+TELEMETRY_FORMAT = "<IIbBhhHH"
+
+# LinkAudioStart_t / LinkAudioChunk_t（この後に ADPCM）/ LinkAudioEnd_t
+AUDIO_START_FORMAT = "<BBIH"
+AUDIO_CHUNK_FORMAT = "<BHhB"
+AUDIO_END_FORMAT = "<BBH"
+
+
+@dataclass
+class Telemetry:
+    uptime_ms: int
+    free_heap: int
+    rssi: int
+    person: bool
+    speaking: bool
+    listening: bool
+    person_x: int
+    person_y: int
+    vision_fps: float
+    reconnects: int
+
+
+@dataclass
+class AudioStart:
+    segment: int
+    codec: int
+    sample_rate: int
+    preroll_ms: int
+
+
+@dataclass
+class AudioChunk:
+    segment: int
+    chunk: int
+    predictor: int
+    step_index: int
+    data: bytes
+
+
+@dataclass
+class AudioEnd:
+    segment: int
+    reason: int
+    chunks: int
+
+
+@dataclass
+class TraceWindow:
+    board: str
+    stage: str
+    samples: int
+    over_budget: int
+    total_us: int
+    max_us: int
+    buckets: list[int]      # scale を戻した回数
+
+
+def encode(msg_type: int, seq: int, payload: bytes = b"") -> bytes:
+    return bytes((msg_type, seq & 0xFF)) + payload
+
+
+def decode(message: bytes) -> Optional[tuple[int, int, bytes]]:
+    """(type, seq, payload)、短すぎれば None"""
+    if len(message) < LINK_HEADER_SIZE:
+        return None
+    return message[0], message[1], message[LINK_HEADER_SIZE:]
+
+
+def decode_telemetry(payload: bytes) -> Optional[Telemetry]:
+    if len(payload) < struct.calcsize(TELEMETRY_FORMAT):
+        return None
+    (uptime_ms, free_heap, rssi, flags, person_x, person_y, fps_x10,
+     reconnects) = struct.unpack_from(TELEMETRY_FORMAT, payload)
+    return Telemetry(
+        uptime_ms=uptime_ms,
+        free_heap=free_heap,
+        rssi=rssi,
+        person=bool(flags & LINK_FLAG_PERSON),
+        speaking=bool(flags & LINK_FLAG_SPEAKING),
+        listening=bool(flags & LINK_FLAG_LISTENING),
+        person_x=person_x,
+        person_y=person_y,
+        vision_fps=fps_x10 / 10,
+        reconnects=reconnects,
+    )
+
+
+def decode_audio_start(payload: bytes) -> Optional[AudioStart]:
+    if len(payload) < struct.calcsize(AUDIO_START_FORMAT):
+        return None
+    return AudioStart(*struct.unpack_from(AUDIO_START_FORMAT, payload))
+
+
+def decode_audio_chunk(payload: bytes) -> Optional[AudioChunk]:
+    header = struct.calcsize(AUDIO_CHUNK_FORMAT)
+    if len(payload) < header:
+        return None
+    return AudioChunk(*struct.unpack_from(AUDIO_CHUNK_FORMAT, payload), data=payload[header:])
+
+
+def decode_audio_end(payload: bytes) -> Optional[AudioEnd]:
+    if len(payload) < struct.calcsize(AUDIO_END_FORMAT):
+        return None
+    return AudioEnd(*struct.unpack_from(AUDIO_END_FORMAT, payload))
+
+
+def decode_trace(payload: bytes) -> list[TraceWindow]:
+    """TraceStatusData_t の列（知らないボード・処理は飛ばす）"""
+    size = struct.calcsize(TRACE_STATUS_FORMAT)
+    windows = []
+    for offset in range(0, len(payload) - size + 1, size):
+        kind, board, stage, scale, samples, over_budget, total_us, max_us, *buckets = \
+            struct.unpack_from(TRACE_STATUS_FORMAT, payload, offset)
+        if kind != STATUS_RESP_TRACE or board >= len(TRACE_BOARDS) or stage >= len(TRACE_STAGES):
+            continue
+        windows.append(TraceWindow(TRACE_BOARDS[board], TRACE_STAGES[stage], samples, over_budget,
+                                   total_us, max_us, [count << scale for count in buckets]))
+    return windows
+
+
+def reply(seq: int, expression: str, text: str) -> bytes:
+    return encode(LINK_MSG_REPLY, seq, bytes((EXPRESSION_IDS.get(expression, 0),)) + text.encode())
+
+
+def play(seq: int, path: str, sample_rate: int = 0) -> bytes:
+    return encode(LINK_MSG_PLAY, seq, struct.pack("<I", sample_rate) + path.encode())
+
+
+def heard(seq: int, text: str) -> bytes:
+    """声の区間を聞き取ったテキスト（空なら聞き取れなかった）"""
+    return encode(LINK_MSG_HEARD, seq, text.encode())
+
+
+def robot_command(cmd: int, data: bytes = b"\0") -> bytes:
+    """上半身へそのまま転送される UART コマンド"""
+    if len(data) > CMD_MAX_DATA:
+        raise ValueError(f"コマンドのデータが長すぎるナリ: {len(data)} > {CMD_MAX_DATA}")
+    return encode(LINK_MSG_ROBOT_CMD, 0, bytes((cmd,)) + data)
+
+
+def expression_command(expression: str, intensity: int = 100, duration_ms: int = 3000) -> bytes:
+    """ExpressionData_t {expression_id, intensity, duration_ms}"""
+    data = struct.pack("<BBH", EXPRESSION_IDS.get(expression, 0), intensity, duration_ms)
+    return robot_command(CMD_EXPRESSION, data)
+
+
+def error(seq: int, message: str) -> bytes:
+    return encode(LINK_MSG_ERROR, seq, message.encode())
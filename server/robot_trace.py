@@ -0,0 +1,120 @@
+"""
+コロ助ロボット - 処理時間の分布の集計
+Corosuke Robot - Per-Board Stage Latency Aggregation
+
+メインボードは LINK_TRACE_MS ごとに、3枚のボードの処理（loop・UART・IMU・サーボ書き込み・
+LED・音声・カメラ…）ごとの時間の分布を LINK_MSG_TRACE で送ってくる（前回からの差分）。
+ここで足し合わせて、どのボードのどの処理がサーボ 1 tick（20ms）を超えているかを出す。
+
+- 分布は 2 のべき乗の幅（firmware/common/trace.h）なので、パーセンタイルはその幅の上端
+- 窓ごとに 1 回でも 20ms を超えた処理はコンソールに出す
+
+FastAPI に依存しない。
+"""
+
+import time
+from dataclasses import dataclass, field
+from typing import Optional
+
+from robot_link import TRACE_BUCKET0_US, TRACE_BUCKETS, TRACE_BUDGET_US, TraceWindow
+
+
+def bucket_limit_us(bucket: int) -> Optional[int]:
+    """ヒストグラムの番号 → その幅の上端（最後の番号は上端なし）"""
+    return TRACE_BUCKET0_US << bucket if bucket < TRACE_BUCKETS - 1 else None
+
+
+@dataclass
+class StageTrace:
+    board: str
+    stage: str
+    samples: int = 0
+    over_budget: int = 0
+    total_us: int = 0
+    max_us: int = 0
+    buckets: list[int] = field(default_factory=lambda: [0] * TRACE_BUCKETS)
+    windows: int = 0
+    last: Optional[TraceWindow] = None
+    last_over_budget: Optional[float] = None    # time.monotonic()
+
+    def add(self, window: TraceWindow) -> None:
+        self.samples += window.samples
+        self.over_budget += window.over_budget
+        self.total_us += window.total_us
+        self.max_us = max(self.max_us, window.max_us)
+        self.buckets = [a + b for a, b in zip(self.buckets, window.buckets)]
+        self.windows += 1
+        self.last = window
+        if window.over_budget:
+            self.last_over_budget = time.monotonic()
+
+    def percentile_us(self, fraction: float) -> int:
+        total = sum(self.buckets)
+        if total == 0:
+            return 0
+        goal = total * fraction
+        seen = 0
+        for bucket, count in enumerate(self.buckets):
+            seen += count
+            if seen >= goal:
+                limit = bucket_limit_us(bucket)
+                return self.max_us if limit is None else min(limit, self.max_us)
+        return self.max_us
+
+    def summary(self) -> dict:
+        since = time.monotonic() - self.last_over_budget if self.last_over_budget is not None else None
+        return {
+            "board": self.board,
+            "stage": self.stage,
+            "samples": self.samples,
+            "mean_us": round(self.total_us / self.samples, 1) if self.samples else 0,
+            "p50_us": self.percentile_us(0.5),
+            "p99_us": self.percentile_us(0.99),
+            "p999_us": self.percentile_us(0.999),
+            "max_us": self.max_us,
+            "over_budget": self.over_budget,
+            "over_budget_ratio": self.over_budget / self.samples if self.samples else 0,
+            "last_over_budget_s": round(since, 1) if since is not None else None,
+            "last_window": {
+                "samples": self.last.samples,
+                "max_us": self.last.max_us,
+                "over_budget": self.last.over_budget,
+            } if self.last else None,
+        }
+
+
+class TraceAggregator:
+    """ボードと処理ごとに足し合わせる"""
+
+    def __init__(self):
+        self.stages: dict[tuple[str, str], StageTrace] = {}
+        self.started = time.monotonic()
+
+    def add(self, window: TraceWindow) -> Optional[str]:
+        """1つの窓を足す。20ms を超えた回があればコンソール用の1行を返す"""
+        key = (window.board, window.stage)
+        stage = self.stages.get(key)
+        if stage is None:
+            stage = self.stages[key] = StageTrace(window.board, window.stage)
+        stage.add(window)
+        if window.over_budget == 0:
+            return None
+        return (f"[trace] {window.board}/{window.stage}: {TRACE_BUDGET_US // 1000} ms 超え "
+                f"{window.over_budget}/{window.samples} 回（最大 {window.max_us / 1000:.1f} ms）")
+
+    def reset(self) -> None:
+        self.stages.clear()
+        self.started = time.monotonic()
+
+    def summary(self) -> dict:
+        """処理ごとの分布と、20ms を超えた回数の多い順"""
+        stages = sorted((s.summary() for s in self.stages.values()),
+                        key=lambda s: (s["board"], s["stage"]))
+        worst = sorted((s for s in stages if s["over_budget"]),
+                       key=lambda s: (s["over_budget"], s["max_us"]), reverse=True)
+        return {
+            "budget_us": TRACE_BUDGET_US,
+            "collected_s": round(time.monotonic() - self.started, 1),
+            "stages": stages,
+            "over_budget": [f"{s['board']}/{s['stage']}" for s in worst],
+        }
@@ -0,0 +1,190 @@
+"""
+コロ助ロボット - 文単位のストリーミング発話
+Corosuke Robot - Sentence-Pipelined Speech Streaming
+
+LLM のトークンを受け取りながら文に区切り、文ごとに音声合成して
+1本の WAV ストリーム（ヘッダー + PCM を順に）として流す。
+最初の文の音声ができた時点で再生を始められるので、LLM の応答全体と
+音声合成全体を待つ従来の流れより、最初の音が出るまでが短くなる。
+
+LLM と音声合成は引数で渡すので、このモジュールは FastAPI や httpx に依存しない。
+"""
+
+import asyncio
+import io
+import struct
+import time
+import wave
+from typing import AsyncIterator, Awaitable, Callable, Optional
+
+# =============================================================================
+# 設定
+# =============================================================================
+
+# ストリームの音声形式（VOICEVOX にもこの形式で出力させる）
+STREAM_SAMPLE_RATE = 24000
+STREAM_CHANNELS = 1
+STREAM_SAMPLE_WIDTH = 2         # 16bit
+
+# 文の区切り（連続する「！？」などはまとめて1つの区切りにする）
+SENTENCE_DELIMITERS = "。！？!?\n"
+MIN_SENTENCE_CHARS = 4          # 「うん。」のような短すぎる文は次とまとめる
+
+# 先に合成しておく文の数（再生中に次の文を用意する）
+SYNTH_LOOKAHEAD = 2
+
+# 長さ未定の WAV の data サイズ（再生側は EOF まで読む）
+STREAM_DATA_SIZE = 0x7FFFFFF0
+
+
+# =============================================================================
+# 文の区切り
+# =============================================================================
+
+async def split_sentences(chunks: AsyncIterator[str]) -> AsyncIterator[str]:
+    """トークン列を文ごとにまとめて返す"""
+    buffer = ""
+    async for chunk in chunks:
+        buffer += chunk
+        while True:
+            end = _sentence_end(buffer)
+            if end < 0:
+                break
+            sentence = buffer[:end].strip()
+            buffer = buffer[end:]
+            if sentence:
+                yield sentence
+
+    rest = buffer.strip()
+    if rest:
+        yield rest
+
+
+def _sentence_end(text: str) -> int:
+    """MIN_SENTENCE_CHARS 文字以降の最初の区切りの直後の位置（なければ -1）"""
+    for i in range(MIN_SENTENCE_CHARS - 1, len(text)):
+        if text[i] in SENTENCE_DELIMITERS:
+            end = i + 1
+            while end < len(text) and text[end] in SENTENCE_DELIMITERS:
+                end += 1
+            # 区切りで終わっているときは「！？」と続くかもしれないので次のトークンを待つ
+            if end == len(text) and text[end - 1] != "\n":
+                return -1
+            return end
+    return -1
+
+
+# =============================================================================
+# WAV
+# =============================================================================
+
+def wav_stream_header(sample_rate: int = STREAM_SAMPLE_RATE) -> bytes:
+    """長さ未定の PCM WAV ヘッダー"""
+    byte_rate = sample_rate * STREAM_CHANNELS * STREAM_SAMPLE_WIDTH
+    block_align = STREAM_CHANNELS * STREAM_SAMPLE_WIDTH
+    return (
+        b"RIFF" + struct.pack("<I", STREAM_DATA_SIZE + 36) + b"WAVE"
+        + b"fmt " + struct.pack("<IHHIIHH", 16, 1, STREAM_CHANNELS, sample_rate,
+                                byte_rate, block_align, STREAM_SAMPLE_WIDTH * 8)
+        + b"data" + struct.pack("<I", STREAM_DATA_SIZE)
+    )
+
+
+def wav_to_pcm(wav_data: bytes) -> bytes:
+    """合成結果の WAV から PCM を取り出す（ストリームと同じ形式でなければエラー）"""
+    with wave.open(io.BytesIO(wav_data), "rb") as w:
+        if (w.getframerate() != STREAM_SAMPLE_RATE or w.getnchannels() != STREAM_CHANNELS
+                or w.getsampwidth() != STREAM_SAMPLE_WIDTH):
+            raise ValueError(
+                f"WAV形式が違うナリ: {w.getframerate()}Hz {w.getnchannels()}ch {w.getsampwidth() * 8}bit")
+        return w.readframes(w.getnframes())
+
+
+# =============================================================================
+# パイプライン
+# =============================================================================
+
+class SpeechStream:
+    """LLM → 文分割 → 音声合成 を並行に進め、PCM を順番どおりに渡す"""
+
+    def __init__(self, tokens: AsyncIterator[str],
+                 synthesize: Callable[[str], Awaitable[bytes]]):
+        self.text = ""
+        self.sentences = 0
+        self.error: Optional[str] = None
+        self.text_done = asyncio.Event()    # LLM の応答を最後まで受け取った
+
+        # 計測（秒、作成時刻からの経過）
+        self.started = time.monotonic()
+        self.first_token_s: Optional[float] = None
+        self.first_sentence_s: Optional[float] = None
+        self.first_audio_s: Optional[float] = None
+        self.done_s: Optional[float] = None
+
+        self._tokens = tokens
+        self._synthesize = synthesize
+        self._pcm: asyncio.Queue = asyncio.Queue()
+        self._task = asyncio.create_task(self._run())
+
+    def _elapsed(self) -> float:
+        return time.monotonic() - self.started
+
+    async def _timed_tokens(self) -> AsyncIterator[str]:
+        async for token in self._tokens:
+            if self.first_token_s is None:
+                self.first_token_s = self._elapsed()
+            self.text += token
+            yield token
+
+    async def _run(self):
+        # 合成タスクを順番に並べ、先頭から待って PCM を流す
+        pending: asyncio.Queue = asyncio.Queue(maxsize=SYNTH_LOOKAHEAD)
+
+        async def produce():
+            async for sentence in split_sentences(self._timed_tokens()):
+                if self.first_sentence_s is None:
+                    self.first_sentence_s = self._elapsed()
+                self.sentences += 1
+                await pending.put(asyncio.create_task(self._synthesize(sentence)))
+            self.text_done.set()
+            await pending.put(None)
+
+        producer = asyncio.create_task(produce())
+        try:
+            while True:
+                task = await pending.get()
+                if task is None:
+                    break
+                pcm = wav_to_pcm(await task)
+                if self.first_audio_s is None:
+                    self.first_audio_s = self._elapsed()
+                await self._pcm.put(pcm)
+            await producer
+        except Exception as e:
+            self.error = str(e)
+            producer.cancel()
+        finally:
+            self.text_done.set()
+            self.done_s = self._elapsed()
+            await self._pcm.put(None)
+
+    async def pcm_chunks(self) -> AsyncIterator[bytes]:
+        """文ごとの PCM（全部流し終えたら終わる）"""
+        while True:
+            pcm = await self._pcm.get()
+            if pcm is None:
+                return
+            yield pcm
+
+    async def wav_chunks(self) -> AsyncIterator[bytes]:
+        """WAV ヘッダー + 文ごとの PCM"""
+        yield wav_stream_header()
+        async for pcm in self.pcm_chunks():
+            yield pcm
+
+    def summary(self) -> str:
+        def ms(value: Optional[float]) -> str:
+            return "-" if value is None else f"{value * 1000:.0f}ms"
+        return (f"{self.sentences}文, 最初のトークン {ms(self.first_token_s)}, "
+                f"最初の文 {ms(self.first_sentence_s)}, 最初の音声 {ms(self.first_audio_s)}, "
+                f"完了 {ms(self.done_s)}" + (f", エラー: {self.error}" if self.error else ""))
@@ -0,0 +1,158 @@
+"""
+コロ助ロボット - マイク音声の受け取りと聞き取り
+Corosuke Robot - Voice Segment Ingest and Local Speech-to-Text
+
+メインボードは声の区間だけを IMA-ADPCM のチャンクで送ってくる（firmware/common/ima_adpcm.h）。
+チャンクは届いたそばから PCM に復号してためておき、区間が終わったら聞き取る。
+チャンクごとに符号化の状態が付いているので、抜けたチャンクは無音で埋めて続きを復号できる。
+
+聞き取りはこのサーバーの中で済ませる（声をクラウドへ出さない）:
+- STT_COMMAND があれば、区間の WAV のパスを {wav} に入れて実行し、標準出力をテキストとする
+  （例: whisper.cpp の "whisper-cli -m models/ggml-small.bin -l ja -nt -f {wav}"）
+- なければ STT_STANDIN_TEXT を返す（音声認識なしで、声から応答までの流れを試せる）
+
+FastAPI に依存しない。
+"""
+
+import asyncio
+import io
+import os
+import shlex
+import tempfile
+import time
+import wave
+from array import array
+from typing import Optional
+
+# =============================================================================
+# 設定
+# =============================================================================
+
+STT_COMMAND = os.getenv("STT_COMMAND", "")
+STT_STANDIN_TEXT = os.getenv("STT_STANDIN_TEXT", "こんにちは！")
+STT_TIMEOUT_S = 30
+
+# 長すぎる区間は捨てる（ボードは VAD_MAX_SEGMENT_MS で区切るので、届くのは壊れたときだけ）
+MAX_SEGMENT_S = 30
+
+# =============================================================================
+# IMA-ADPCM の復号（ima_adpcm.h と同じ表と手順）
+# =============================================================================
+
+ADPCM_STEPS = (
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+)
+ADPCM_INDEX_STEP = (-1, -1, -1, -1, 2, 4, 6, 8)
+
+
+def adpcm_decode(data: bytes, predictor: int, index: int) -> array:
+    """1 バイト 2 サンプル（下位ニブルが先）を 16bit PCM に"""
+    out = array("h", bytes(4 * len(data)))
+    n = 0
+    for byte in data:
+        for code in (byte & 0x0F, byte >> 4):
+            step = ADPCM_STEPS[index]
+            diff = step >> 3
+            if code & 4:
+                diff += step
+            if code & 2:
+                diff += step >> 1
+            if code & 1:
+                diff += step >> 2
+            predictor = predictor - diff if code & 8 else predictor + diff
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(len(ADPCM_STEPS) - 1, index + ADPCM_INDEX_STEP[code & 7]))
+            out[n] = predictor
+            n += 1
+    return out
+
+
+# =============================================================================
+# 声の区間
+# =============================================================================
+
+class VoiceSegment:
+    """AUDIO_START から AUDIO_END までの1区間"""
+
+    def __init__(self, segment: int, sample_rate: int, preroll_ms: int = 0):
+        self.segment = segment
+        self.sample_rate = sample_rate
+        self.preroll_ms = preroll_ms
+        self.pcm = array("h")
+        self.next_chunk = 0
+        self.missing_chunks = 0
+        self.received_bytes = 0
+        self.decode_s = 0.0
+        self.started = time.monotonic()
+        self.finished: Optional[float] = None
+
+    def add_chunk(self, chunk: int, predictor: int, step_index: int, data: bytes) -> None:
+        """届いたチャンクを復号して足す（抜けた分は同じ長さの無音で埋める）"""
+        if chunk < self.next_chunk or self.duration_s >= MAX_SEGMENT_S:
+            return
+        start = time.perf_counter()
+        gap = chunk - self.next_chunk
+        if gap:
+            self.missing_chunks += gap
+            self.pcm.frombytes(bytes(4 * len(data) * gap))
+        self.pcm.extend(adpcm_decode(data, predictor, min(step_index, len(ADPCM_STEPS) - 1)))
+        self.next_chunk = chunk + 1
+        self.received_bytes += len(data)
+        self.decode_s += time.perf_counter() - start
+
+    def finish(self, chunks: int) -> None:
+        """AUDIO_END（送ったチャンク数で最後の抜けを数える）"""
+        self.missing_chunks += max(0, chunks - self.next_chunk)
+        self.finished = time.monotonic()
+
+    @property
+    def duration_s(self) -> float:
+        return len(self.pcm) / self.sample_rate
+
+    def wav_bytes(self) -> bytes:
+        buffer = io.BytesIO()
+        with wave.open(buffer, "wb") as wav:
+            wav.setnchannels(1)
+            wav.setsampwidth(2)
+            wav.setframerate(self.sample_rate)
+            wav.writeframes(self.pcm.tobytes())
+        return buffer.getvalue()
+
+    def summary(self) -> str:
+        elapsed = (self.finished or time.monotonic()) - self.started
+        rate = self.received_bytes / elapsed if elapsed > 0 else 0
+        return (f"{self.duration_s:.2f} 秒（語頭 {self.preroll_ms} ms）, "
+                f"{self.received_bytes} バイト（{rate:.0f} B/s）, 抜け {self.missing_chunks} チャンク, "
+                f"復号 {self.decode_s * 1000:.1f} ms")
+
+
+# =============================================================================
+# 聞き取り
+# =============================================================================
+
+async def transcribe(segment: VoiceSegment) -> str:
+    """区間の音声をテキストに（聞き取れなければ空）"""
+    if not STT_COMMAND:
+        return STT_STANDIN_TEXT if segment.duration_s > 0 else ""
+
+    fd, path = tempfile.mkstemp(suffix=".wav")
+    try:
+        with os.fdopen(fd, "wb") as f:
+            f.write(segment.wav_bytes())
+        args = [arg.replace("{wav}", path) for arg in shlex.split(STT_COMMAND)]
+        process = await asyncio.create_subprocess_exec(
+            *args, stdout=asyncio.subprocess.PIPE, stderr=asyncio.subprocess.DEVNULL)
+        try:
+            stdout, _ = await asyncio.wait_for(process.communicate(), STT_TIMEOUT_S)
+        except asyncio.TimeoutError:
+            process.kill()
+            await process.wait()
+            print(f"[voice {segment.segment}] 聞き取りが {STT_TIMEOUT_S} 秒で終わらなかったナリ")
+            return ""
+        return stdout.decode(errors="replace").strip()
+    finally:
+        os.unlink(path)